@@ -0,0 +1,30 @@
+#ifndef _BITS_AES_H
+#define _BITS_AES_H
+
+/** @file
+ *
+ * AES algorithm
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <errno.h>
+
+static inline __attribute__ (( always_inline )) int
+aes_accel_encrypt ( struct aes_context *aes __unused, const void *src __unused,
+		    void *dst __unused ) {
+
+	/* Not yet implemented */
+	return -ENOTSUP;
+}
+
+static inline __attribute__ (( always_inline )) int
+aes_accel_decrypt ( struct aes_context *aes __unused, const void *src __unused,
+		    void *dst __unused ) {
+
+	/* Not yet implemented */
+	return -ENOTSUP;
+}
+
+#endif /* _BITS_AES_H */
@@ -0,0 +1,21 @@
+#ifndef _BITS_SHA256_H
+#define _BITS_SHA256_H
+
+/** @file
+ *
+ * SHA-256 algorithm
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <errno.h>
+
+static inline __attribute__ (( always_inline )) int
+sha256_accel_digest ( struct sha256_context *context __unused ) {
+
+	/* Not yet implemented */
+	return -ENOTSUP;
+}
+
+#endif /* _BITS_SHA256_H */
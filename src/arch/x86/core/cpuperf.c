@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/init.h>
+#include <ipxe/cpuid.h>
+
+/** @file
+ *
+ * CPU performance state assertion
+ *
+ * Some platforms hand control to iPXE with the CPU still in a
+ * low-power performance state, leaving everything (cryptography,
+ * memory copies, TCP) running at a fraction of the achievable clock
+ * speed until the booted operating system takes over frequency
+ * management.  Request the maximum performance state at startup, via
+ * hardware-controlled performance states (Intel Speed Shift) where
+ * available, falling back to a legacy Enhanced SpeedStep request.
+ */
+
+/** Colour for debug messages */
+#define colour 0x0bf1
+
+/** CPUID vendor identification: "Genu" */
+#define CPUID_VENDOR_INTEL_EBX 0x756e6547UL
+
+/** CPUID vendor identification: "ineI" */
+#define CPUID_VENDOR_INTEL_EDX 0x49656e69UL
+
+/** CPUID vendor identification: "ntel" */
+#define CPUID_VENDOR_INTEL_ECX 0x6c65746eUL
+
+/** CPUID thermal and power management leaf */
+#define CPUID_POWER 0x00000006UL
+
+/** Hardware-controlled performance states (HWP) are supported */
+#define CPUID_POWER_EAX_HWP 0x00000080UL
+
+/** Enhanced SpeedStep (EIST) is supported */
+#define CPUID_FEATURES_INTEL_ECX_EIST 0x00000080UL
+
+/** Hardware-controlled performance state enable MSR */
+#define MSR_PM_ENABLE 0x00000770UL
+
+/** Enable hardware-controlled performance states */
+#define PM_ENABLE_HWP 0x00000001UL
+
+/** Hardware-controlled performance state capabilities MSR */
+#define MSR_HWP_CAPABILITIES 0x00000771UL
+
+/** Hardware-controlled performance state request MSR */
+#define MSR_HWP_REQUEST 0x00000774UL
+
+/** Platform information MSR */
+#define MSR_PLATFORM_INFO 0x000000ceUL
+
+/** Enhanced SpeedStep performance control MSR */
+#define MSR_PERF_CTL 0x00000199UL
+
+/**
+ * Read model-specific register
+ *
+ * @v msr		Model-specific register
+ * @ret value		Value
+ */
+static inline uint64_t rdmsr ( uint32_t msr ) {
+	uint32_t high;
+	uint32_t low;
+
+	__asm__ __volatile__ ( "rdmsr"
+			       : "=d" ( high ), "=a" ( low ) : "c" ( msr ) );
+	return ( ( ( ( uint64_t ) high ) << 32 ) | low );
+}
+
+/**
+ * Write model-specific register
+ *
+ * @v msr		Model-specific register
+ * @v value		Value
+ */
+static inline void wrmsr ( uint32_t msr, uint64_t value ) {
+
+	__asm__ __volatile__ ( "wrmsr"
+			       : : "c" ( msr ),
+				   "d" ( ( uint32_t ) ( value >> 32 ) ),
+				   "a" ( ( uint32_t ) ( value >> 0 ) ) );
+}
+
+/**
+ * Assert maximum CPU performance state
+ *
+ */
+static void cpuperf_init ( void ) {
+	uint32_t eax;
+	uint32_t ebx;
+	uint32_t ecx;
+	uint32_t edx;
+	uint64_t caps;
+	uint64_t info;
+	unsigned int perf;
+	unsigned int ratio;
+
+	/* Do nothing unless this is a genuine Intel CPU: the
+	 * performance state machinery is vendor-specific, and a
+	 * mistargeted MSR write would fault.
+	 */
+	cpuid ( CPUID_VENDOR_ID, 0, &eax, &ebx, &ecx, &edx );
+	if ( ( ebx != CPUID_VENDOR_INTEL_EBX ) ||
+	     ( edx != CPUID_VENDOR_INTEL_EDX ) ||
+	     ( ecx != CPUID_VENDOR_INTEL_ECX ) ) {
+		DBGC ( colour, "CPUPERF has no support for this CPU vendor\n" );
+		return;
+	}
+
+	/* Use hardware-controlled performance states, if supported */
+	if ( cpuid_supported ( CPUID_POWER ) ) {
+		cpuid ( CPUID_POWER, 0, &eax, &ebx, &ecx, &edx );
+		if ( eax & CPUID_POWER_EAX_HWP ) {
+
+			/* Enable hardware-controlled performance states */
+			wrmsr ( MSR_PM_ENABLE, PM_ENABLE_HWP );
+
+			/* Request the highest performance level for
+			 * both the minimum and maximum, leaving no
+			 * discretion to the power controller.
+			 */
+			caps = rdmsr ( MSR_HWP_CAPABILITIES );
+			perf = ( caps & 0xff );
+			wrmsr ( MSR_HWP_REQUEST,
+				( ( perf << 8 ) | ( perf << 0 ) ) );
+			DBGC ( colour, "CPUPERF requested HWP performance "
+			       "level %d\n", perf );
+			return;
+		}
+	}
+
+	/* Otherwise, fall back to a legacy Enhanced SpeedStep
+	 * request for the maximum non-turbo ratio.
+	 */
+	cpuid ( CPUID_FEATURES, 0, &eax, &ebx, &ecx, &edx );
+	if ( ecx & CPUID_FEATURES_INTEL_ECX_EIST ) {
+		info = rdmsr ( MSR_PLATFORM_INFO );
+		ratio = ( ( info >> 8 ) & 0xff );
+		wrmsr ( MSR_PERF_CTL, ( ratio << 8 ) );
+		DBGC ( colour, "CPUPERF requested EIST ratio %d\n", ratio );
+		return;
+	}
+
+	DBGC ( colour, "CPUPERF has no supported frequency control\n" );
+}
+
+/** CPU performance state initialisation function */
+struct init_fn cpuperf_init_fn __init_fn ( INIT_EARLY ) = {
+	.initialise = cpuperf_init,
+};
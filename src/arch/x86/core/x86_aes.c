@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * AES acceleration using the AES instruction set (AES-NI)
+ *
+ * The expanded encryption and decryption keys constructed by the
+ * generic AES code are in precisely the layout required by the
+ * AESENC/AESENCLAST and AESDEC/AESDECLAST instructions (with the
+ * decryption keys already transformed via InvMixColumns for use by
+ * the equivalent inverse cipher), and so may be used directly.
+ *
+ * We are compiled without SSE support (since the whole of iPXE runs
+ * without saving and restoring SSE state), and so must use only
+ * explicit SSE instructions within inline assembly.  We restrict
+ * ourselves to using %xmm0 and %xmm1, which are volatile registers
+ * under all relevant ABIs.
+ */
+
+#include <errno.h>
+#include <ipxe/aes.h>
+#include <ipxe/cpuid.h>
+
+/** x87 FPU emulation bit in CR0 */
+#define CR0_EM 0x00000004UL
+
+/** Task switched bit in CR0 */
+#define CR0_TS 0x00000008UL
+
+/** FXSAVE/FXRSTOR (and SSE) enable bit in CR4 */
+#define CR4_OSFXSR 0x00000200UL
+
+/**
+ * Check that the AES instruction set is usable
+ *
+ * @ret ok		AES instruction set is usable
+ */
+static int aes_accel_supported ( void ) {
+	static int supported;
+	struct x86_features features;
+	unsigned long cr;
+	unsigned int cs;
+
+	/* Use cached result, if available */
+	if ( supported )
+		return ( supported > 0 );
+
+	/* Check for presence of the AES instruction set */
+	x86_features ( &features );
+	if ( ! ( features.intel.ecx & CPUID_FEATURES_INTEL_ECX_AES ) ) {
+		supported = -1;
+		return 0;
+	}
+
+	/* Enable SSE instructions if we have sufficient privilege to
+	 * do so.  If we are running at CPL 3 (e.g. as a Linux
+	 * userspace binary) then we must rely on the operating system
+	 * having already enabled SSE, which any SSE-capable operating
+	 * system will have done.
+	 */
+	__asm__ ( "mov %%cs, %k0" : "=r" ( cs ) );
+	if ( ( cs & 0x3 ) == 0 ) {
+		__asm__ __volatile__ ( "mov %%cr4, %0" : "=r" ( cr ) );
+		cr |= CR4_OSFXSR;
+		__asm__ __volatile__ ( "mov %0, %%cr4" : : "r" ( cr ) );
+		__asm__ __volatile__ ( "mov %%cr0, %0" : "=r" ( cr ) );
+		cr &= ~( CR0_EM | CR0_TS );
+		__asm__ __volatile__ ( "mov %0, %%cr0" : : "r" ( cr ) );
+	}
+
+	supported = 1;
+	return 1;
+}
+
+/**
+ * Encrypt data block using the AES instruction set
+ *
+ * @v aes		AES context
+ * @v src		Data to encrypt
+ * @v dst		Buffer for encrypted data
+ * @ret rc		Return status code
+ */
+int aes_accel_encrypt ( struct aes_context *aes, const void *src, void *dst ) {
+	const union aes_matrix *key = aes->encrypt.key;
+	unsigned int rounds = aes->rounds;
+
+	/* Fail (and fall back to the generic implementation) if the
+	 * AES instruction set is not usable.
+	 */
+	if ( ! aes_accel_supported() )
+		return -ENOTSUP;
+
+	/* Load input block and perform initial round (AddRoundKey) */
+	__asm__ __volatile__ ( "movdqu %0, %%xmm0\n\t"
+			       "movdqu %1, %%xmm1\n\t"
+			       "pxor %%xmm1, %%xmm0\n\t"
+			       : : "m" ( *( ( const union aes_matrix * ) src )),
+				   "m" ( *(key++) ) );
+
+	/* Perform intermediate rounds */
+	while ( --rounds > 1 ) {
+		__asm__ __volatile__ ( "movdqu %0, %%xmm1\n\t"
+				       "aesenc %%xmm1, %%xmm0\n\t"
+				       : : "m" ( *(key++) ) );
+	}
+
+	/* Perform final round and store output block */
+	__asm__ __volatile__ ( "movdqu %1, %%xmm1\n\t"
+			       "aesenclast %%xmm1, %%xmm0\n\t"
+			       "movdqu %%xmm0, %0\n\t"
+			       : "=m" ( *( ( union aes_matrix * ) dst ) )
+			       : "m" ( *key ) );
+
+	return 0;
+}
+
+/**
+ * Decrypt data block using the AES instruction set
+ *
+ * @v aes		AES context
+ * @v src		Data to decrypt
+ * @v dst		Buffer for decrypted data
+ * @ret rc		Return status code
+ */
+int aes_accel_decrypt ( struct aes_context *aes, const void *src, void *dst ) {
+	const union aes_matrix *key = aes->decrypt.key;
+	unsigned int rounds = aes->rounds;
+
+	/* Fail (and fall back to the generic implementation) if the
+	 * AES instruction set is not usable.
+	 */
+	if ( ! aes_accel_supported() )
+		return -ENOTSUP;
+
+	/* Load input block and perform initial round (AddRoundKey) */
+	__asm__ __volatile__ ( "movdqu %0, %%xmm0\n\t"
+			       "movdqu %1, %%xmm1\n\t"
+			       "pxor %%xmm1, %%xmm0\n\t"
+			       : : "m" ( *( ( const union aes_matrix * ) src )),
+				   "m" ( *(key++) ) );
+
+	/* Perform intermediate rounds */
+	while ( --rounds > 1 ) {
+		__asm__ __volatile__ ( "movdqu %0, %%xmm1\n\t"
+				       "aesdec %%xmm1, %%xmm0\n\t"
+				       : : "m" ( *(key++) ) );
+	}
+
+	/* Perform final round and store output block */
+	__asm__ __volatile__ ( "movdqu %1, %%xmm1\n\t"
+			       "aesdeclast %%xmm1, %%xmm0\n\t"
+			       "movdqu %%xmm0, %0\n\t"
+			       : "=m" ( *( ( union aes_matrix * ) dst ) )
+			       : "m" ( *key ) );
+
+	return 0;
+}
@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * SHA-256 acceleration using the SHA instruction set (SHA-NI)
+ *
+ * We are compiled without SSE support (since the whole of iPXE runs
+ * without saving and restoring SSE state), and so must use only
+ * explicit SSE instructions within inline assembly.  The SHA
+ * instructions implicitly use %xmm0, and the rolling message schedule
+ * requires a further four registers in addition to the two state
+ * registers.  We use %xmm0-%xmm6, preserving and restoring %xmm6
+ * (which is a non-volatile register under some relevant ABIs) around
+ * the block computation.
+ */
+
+#include <errno.h>
+#include <ipxe/sha256.h>
+#include <ipxe/cpuid.h>
+
+/** x87 FPU emulation bit in CR0 */
+#define CR0_EM 0x00000004UL
+
+/** Task switched bit in CR0 */
+#define CR0_TS 0x00000008UL
+
+/** FXSAVE/FXRSTOR (and SSE) enable bit in CR4 */
+#define CR4_OSFXSR 0x00000200UL
+
+/** SHA-256 constants */
+static const uint32_t sha256_accel_k[SHA256_ROUNDS]
+	__attribute__ (( aligned ( 16 ) )) = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+	0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+	0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+	0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+	0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+	0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/** Byte shuffle mask for endianness conversion */
+static const uint8_t sha256_accel_bswap[16]
+	__attribute__ (( aligned ( 16 ) )) = {
+	3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+};
+
+/**
+ * Load and byte-swap one message schedule block
+ *
+ * @v W			Message schedule register (as a string)
+ * @v dword		First dword of block within data buffer
+ */
+#define SHA256_ACCEL_LOAD( W, dword ) do {				\
+	__asm__ __volatile__ ( "movdqu %0, %%" W "\n\t"			\
+			       "pshufb %1, %%" W "\n\t"			\
+			       : : "m" ( dword ),			\
+				   "m" ( sha256_accel_bswap ) );	\
+	} while ( 0 )
+
+/**
+ * Perform four rounds of SHA-256
+ *
+ * @v W			Message schedule register (as a string)
+ * @v round		First round number
+ *
+ * The current state is held in %xmm1 (ABEF) and %xmm2 (CDGH), as
+ * consumed and produced by the SHA256RNDS2 instruction.
+ */
+#define SHA256_ACCEL_ROUND4( W, round ) do {				\
+	__asm__ __volatile__ ( "movdqa %0, %%xmm0\n\t"			\
+			       "paddd %%" W ", %%xmm0\n\t"		\
+			       "sha256rnds2 %%xmm1, %%xmm2\n\t"		\
+			       "pshufd $0x0e, %%xmm0, %%xmm0\n\t"	\
+			       "sha256rnds2 %%xmm2, %%xmm1\n\t"		\
+			       : : "m" ( sha256_accel_k[round] ) );	\
+	} while ( 0 )
+
+/**
+ * Calculate the next message schedule block
+ *
+ * @v W0		Oldest message schedule register (as a string)
+ * @v W1		Second message schedule register (as a string)
+ * @v W2		Third message schedule register (as a string)
+ * @v W3		Newest message schedule register (as a string)
+ *
+ * Calculates the next block of the message schedule in place of the
+ * oldest block.
+ */
+#define SHA256_ACCEL_SCHEDULE( W0, W1, W2, W3 ) do {			\
+	__asm__ __volatile__ ( "sha256msg1 %%" W1 ", %%" W0 "\n\t"	\
+			       "movdqa %%" W3 ", %%xmm0\n\t"		\
+			       "palignr $4, %%" W2 ", %%xmm0\n\t"	\
+			       "paddd %%xmm0, %%" W0 "\n\t"		\
+			       "sha256msg2 %%" W3 ", %%" W0 "\n\t"	\
+			       : : );					\
+	} while ( 0 )
+
+/**
+ * Check that the SHA instruction set is usable
+ *
+ * @ret ok		SHA instruction set is usable
+ */
+static int sha256_accel_supported ( void ) {
+	static int supported;
+	uint32_t eax;
+	uint32_t ebx;
+	uint32_t ecx;
+	uint32_t edx;
+	unsigned long cr;
+	unsigned int cs;
+
+	/* Use cached result, if available */
+	if ( supported )
+		return ( supported > 0 );
+
+	/* Check for presence of the SHA instruction set */
+	if ( cpuid_supported ( CPUID_EXTENDED_FEATURES ) != 0 ) {
+		supported = -1;
+		return 0;
+	}
+	cpuid ( CPUID_EXTENDED_FEATURES, 0, &eax, &ebx, &ecx, &edx );
+	if ( ! ( ebx & CPUID_EXTENDED_FEATURES_EBX_SHA ) ) {
+		supported = -1;
+		return 0;
+	}
+
+	/* Enable SSE instructions if we have sufficient privilege to
+	 * do so.  If we are running at CPL 3 (e.g. as a Linux
+	 * userspace binary) then we must rely on the operating system
+	 * having already enabled SSE, which any SSE-capable operating
+	 * system will have done.
+	 */
+	__asm__ ( "mov %%cs, %k0" : "=r" ( cs ) );
+	if ( ( cs & 0x3 ) == 0 ) {
+		__asm__ __volatile__ ( "mov %%cr4, %0" : "=r" ( cr ) );
+		cr |= CR4_OSFXSR;
+		__asm__ __volatile__ ( "mov %0, %%cr4" : : "r" ( cr ) );
+		__asm__ __volatile__ ( "mov %%cr0, %0" : "=r" ( cr ) );
+		cr &= ~( CR0_EM | CR0_TS );
+		__asm__ __volatile__ ( "mov %0, %%cr0" : : "r" ( cr ) );
+	}
+
+	supported = 1;
+	return 1;
+}
+
+/**
+ * Calculate SHA-256 digest of accumulated data using the SHA
+ * instruction set
+ *
+ * @v context		SHA-256 context
+ * @ret rc		Return status code
+ */
+int sha256_accel_digest ( struct sha256_context *context ) {
+	struct sha256_digest_data *dd = &context->ddd.dd;
+	struct {
+		struct sha256_digest abef_cdgh;
+		uint8_t xmm6[16];
+	} save __attribute__ (( aligned ( 16 ) ));
+
+	/* Fail (and fall back to the generic implementation) if the
+	 * SHA instruction set is not usable.
+	 */
+	if ( ! sha256_accel_supported() )
+		return -ENOTSUP;
+
+	/* Preserve %xmm6, load the big-endian digest, and rearrange
+	 * it into the ABEF/CDGH representation used by the SHA
+	 * instructions, keeping a copy for the final addition.
+	 */
+	__asm__ __volatile__ ( "movdqu %%xmm6, %0\n\t"
+			       "movdqu %3, %%xmm1\n\t"
+			       "movdqu %4, %%xmm2\n\t"
+			       "pshufb %5, %%xmm1\n\t"
+			       "pshufb %5, %%xmm2\n\t"
+			       "pshufd $0xb1, %%xmm1, %%xmm1\n\t"
+			       "pshufd $0x1b, %%xmm2, %%xmm2\n\t"
+			       "movdqa %%xmm1, %%xmm0\n\t"
+			       "palignr $8, %%xmm2, %%xmm1\n\t"
+			       "pblendw $0xf0, %%xmm0, %%xmm2\n\t"
+			       "movdqa %%xmm1, %1\n\t"
+			       "movdqa %%xmm2, %2\n\t"
+			       : "=m" ( save.xmm6 ),
+				 "=m" ( save.abef_cdgh.h[0] ),
+				 "=m" ( save.abef_cdgh.h[4] )
+			       : "m" ( dd->digest.h[0] ),
+				 "m" ( dd->digest.h[4] ),
+				 "m" ( sha256_accel_bswap ) );
+
+	/* Perform rounds 0-15, loading the message schedule */
+	SHA256_ACCEL_LOAD ( "xmm3", dd->data.dword[0] );
+	SHA256_ACCEL_ROUND4 ( "xmm3", 0 );
+	SHA256_ACCEL_LOAD ( "xmm4", dd->data.dword[4] );
+	SHA256_ACCEL_ROUND4 ( "xmm4", 4 );
+	SHA256_ACCEL_LOAD ( "xmm5", dd->data.dword[8] );
+	SHA256_ACCEL_ROUND4 ( "xmm5", 8 );
+	SHA256_ACCEL_LOAD ( "xmm6", dd->data.dword[12] );
+	SHA256_ACCEL_ROUND4 ( "xmm6", 12 );
+
+	/* Perform rounds 16-63, extending the message schedule */
+	SHA256_ACCEL_SCHEDULE ( "xmm3", "xmm4", "xmm5", "xmm6" );
+	SHA256_ACCEL_ROUND4 ( "xmm3", 16 );
+	SHA256_ACCEL_SCHEDULE ( "xmm4", "xmm5", "xmm6", "xmm3" );
+	SHA256_ACCEL_ROUND4 ( "xmm4", 20 );
+	SHA256_ACCEL_SCHEDULE ( "xmm5", "xmm6", "xmm3", "xmm4" );
+	SHA256_ACCEL_ROUND4 ( "xmm5", 24 );
+	SHA256_ACCEL_SCHEDULE ( "xmm6", "xmm3", "xmm4", "xmm5" );
+	SHA256_ACCEL_ROUND4 ( "xmm6", 28 );
+	SHA256_ACCEL_SCHEDULE ( "xmm3", "xmm4", "xmm5", "xmm6" );
+	SHA256_ACCEL_ROUND4 ( "xmm3", 32 );
+	SHA256_ACCEL_SCHEDULE ( "xmm4", "xmm5", "xmm6", "xmm3" );
+	SHA256_ACCEL_ROUND4 ( "xmm4", 36 );
+	SHA256_ACCEL_SCHEDULE ( "xmm5", "xmm6", "xmm3", "xmm4" );
+	SHA256_ACCEL_ROUND4 ( "xmm5", 40 );
+	SHA256_ACCEL_SCHEDULE ( "xmm6", "xmm3", "xmm4", "xmm5" );
+	SHA256_ACCEL_ROUND4 ( "xmm6", 44 );
+	SHA256_ACCEL_SCHEDULE ( "xmm3", "xmm4", "xmm5", "xmm6" );
+	SHA256_ACCEL_ROUND4 ( "xmm3", 48 );
+	SHA256_ACCEL_SCHEDULE ( "xmm4", "xmm5", "xmm6", "xmm3" );
+	SHA256_ACCEL_ROUND4 ( "xmm4", 52 );
+	SHA256_ACCEL_SCHEDULE ( "xmm5", "xmm6", "xmm3", "xmm4" );
+	SHA256_ACCEL_ROUND4 ( "xmm5", 56 );
+	SHA256_ACCEL_SCHEDULE ( "xmm6", "xmm3", "xmm4", "xmm5" );
+	SHA256_ACCEL_ROUND4 ( "xmm6", 60 );
+
+	/* Add this chunk to the saved initial state, rearrange back
+	 * from the ABEF/CDGH representation, store the big-endian
+	 * digest, and restore %xmm6.
+	 */
+	__asm__ __volatile__ ( "paddd %2, %%xmm1\n\t"
+			       "paddd %3, %%xmm2\n\t"
+			       "pshufd $0x1b, %%xmm1, %%xmm1\n\t"
+			       "pshufd $0xb1, %%xmm2, %%xmm2\n\t"
+			       "movdqa %%xmm1, %%xmm0\n\t"
+			       "pblendw $0xf0, %%xmm2, %%xmm1\n\t"
+			       "palignr $8, %%xmm0, %%xmm2\n\t"
+			       "pshufb %4, %%xmm1\n\t"
+			       "pshufb %4, %%xmm2\n\t"
+			       "movdqu %%xmm1, %0\n\t"
+			       "movdqu %%xmm2, %1\n\t"
+			       "movdqu %5, %%xmm6\n\t"
+			       : "=m" ( dd->digest.h[0] ),
+				 "=m" ( dd->digest.h[4] )
+			       : "m" ( save.abef_cdgh.h[0] ),
+				 "m" ( save.abef_cdgh.h[4] ),
+				 "m" ( sha256_accel_bswap ),
+				 "m" ( save.xmm6 ) );
+
+	return 0;
+}
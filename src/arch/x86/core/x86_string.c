@@ -30,6 +30,18 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <string.h>
+#include <ipxe/cpuid.h>
+#include <ipxe/init.h>
+
+/** Use single "rep movsb" for bulk copies
+ *
+ * Set at initialisation if the CPU advertises enhanced REP
+ * MOVSB/STOSB (ERMS), on which a single "rep movsb" matches or beats
+ * a "rep movsl" pair regardless of alignment.  Vector (SSE/AVX)
+ * variants are deliberately not used, since iPXE does not manage
+ * extended register state across its external interfaces.
+ */
+static int memcpy_erms;
 
 /**
  * Copy memory area
@@ -45,6 +57,16 @@ void * __attribute__ (( noinline )) __memcpy ( void *dest, const void *src,
 	const void *esi = src;
 	int discard_ecx;
 
+	/* Use a single byte-granular copy on ERMS-capable CPUs */
+	if ( memcpy_erms ) {
+		__asm__ __volatile__ ( "rep movsb"
+				       : "=&D" ( edi ), "=&S" ( esi ),
+					 "=&c" ( discard_ecx )
+				       : "0" ( edi ), "1" ( esi ), "2" ( len )
+				       : "memory" );
+		return dest;
+	}
+
 	/* We often do large dword-aligned and dword-length block
 	 * moves.  Using movsl rather than movsb speeds these up by
 	 * around 32%.
@@ -108,3 +130,28 @@ void * __memmove ( void *dest, const void *src, size_t len ) {
 		return __memcpy_reverse ( dest, src, len );
 	}
 }
+
+/**
+ * Probe CPU features used for optimised string operations
+ *
+ */
+static void x86_string_init ( void ) {
+	uint32_t eax;
+	uint32_t ebx;
+	uint32_t ecx;
+	uint32_t edx;
+
+	/* Check for enhanced REP MOVSB/STOSB */
+	if ( ! cpuid_supported ( CPUID_EXTENDED_FEATURES ) )
+		return;
+	cpuid ( CPUID_EXTENDED_FEATURES, 0, &eax, &ebx, &ecx, &edx );
+	if ( ebx & CPUID_EXTENDED_FEATURES_EBX_ERMS ) {
+		DBG ( "X86STRING using enhanced REP MOVSB\n" );
+		memcpy_erms = 1;
+	}
+}
+
+/** Optimised string operations initialisation function */
+struct init_fn x86_string_init_fn __init_fn ( INIT_EARLY ) = {
+	.initialise = x86_string_init,
+};
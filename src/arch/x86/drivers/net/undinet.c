@@ -27,7 +27,6 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <pic8259.h>
 #include <biosint.h>
 #include <pnpbios.h>
-#include <basemem_packet.h>
 #include <ipxe/io.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/netdevice.h>
@@ -45,6 +44,9 @@ FILE_LICENCE ( GPL2_OR_LATER );
  */
 
 /** An UNDI NIC */
+/** Number of transmit batch slots */
+#define UNDINET_TX_SLOTS 4
+
 struct undi_nic {
 	/** Device supports IRQs */
 	int irq_supported;
@@ -54,6 +56,10 @@ struct undi_nic {
 	int isr_processing;
 	/** Bug workarounds */
 	int hacks;
+	/** Queued transmit I/O buffers */
+	struct io_buffer *txbuf[UNDINET_TX_SLOTS];
+	/** Number of queued transmit frames */
+	unsigned int tx_count;
 };
 
 /* Disambiguate the various error causes */
@@ -434,13 +440,150 @@ static int undinet_isr_triggered ( void ) {
  *****************************************************************************
  */
 
-/** UNDI transmit buffer descriptor */
-static struct s_PXENV_UNDI_TBD __data16 ( undinet_tbd );
-#define undinet_tbd __use_data16 ( undinet_tbd )
+/** A transmit batch slot
+ *
+ * Each slot holds a complete, self-contained transmission: parameter
+ * block, transmit buffer descriptor, destination address, and frame
+ * data.  The whole array resides in base memory, so queued frames can
+ * be handed to the PXE stack without any further copying of setup
+ * state at flush time.
+ */
+struct undinet_tx_slot {
+	/** Parameter block */
+	struct s_PXENV_UNDI_TRANSMIT transmit;
+	/** Transmit buffer descriptor */
+	struct s_PXENV_UNDI_TBD tbd;
+	/** Destination address */
+	uint8_t destaddr[ETH_ALEN];
+	/** Frame data */
+	uint8_t data[ETH_FRAME_LEN];
+} __attribute__ (( packed ));
+
+/** UNDI transmit batch slots */
+static struct undinet_tx_slot __bss16_array ( undinet_tx_slots,
+					      [UNDINET_TX_SLOTS] );
+#define undinet_tx_slots __use_data16 ( undinet_tx_slots )
 
-/** UNDI transmit destination address */
-static uint8_t __data16_array ( undinet_destaddr, [ETH_ALEN] );
-#define undinet_destaddr __use_data16 ( undinet_destaddr )
+/**
+ * Initialise transmit batch slots
+ *
+ * Fills in the real-mode segment:offset pointers linking each
+ * parameter block to its buffer descriptor, destination address, and
+ * frame data.  These mappings never change, so calculating them once
+ * here (rather than on every transmission) keeps the per-frame work
+ * down to filling in the variable fields and copying the frame data.
+ */
+static void undinet_tx_init ( void ) {
+	struct undinet_tx_slot *slot;
+	unsigned int i;
+
+	for ( i = 0 ; i < UNDINET_TX_SLOTS ; i++ ) {
+		slot = &undinet_tx_slots[i];
+		slot->transmit.DestAddr.segment = rm_ds;
+		slot->transmit.DestAddr.offset =
+			__from_data16 ( &slot->destaddr );
+		slot->transmit.TBD.segment = rm_ds;
+		slot->transmit.TBD.offset = __from_data16 ( &slot->tbd );
+		slot->tbd.Xmit.segment = rm_ds;
+		slot->tbd.Xmit.offset = __from_data16 ( &slot->data );
+	}
+}
+
+/**
+ * Flush queued transmissions
+ *
+ * @v netdev		Network device
+ *
+ * Issues a PXENV_UNDI_TRANSMIT call for each queued frame within a
+ * single protected-to-real mode transition.  The mode switch
+ * dominates the cost of a transmission, so batching frames queued
+ * within one poll cycle substantially reduces the per-frame overhead.
+ */
+static void undinet_tx_flush ( struct net_device *netdev ) {
+	struct undi_nic *undinic = netdev->priv;
+	struct undinet_profiler *profiler = &undinet_tx_profiler;
+	struct undinet_tx_slot *slot;
+	struct io_buffer *iobuf;
+	uint32_t before;
+	uint32_t started;
+	uint32_t stopped;
+	uint32_t after;
+	int discard_b;
+	int discard_c;
+	int discard_D;
+	unsigned int i;
+	int rc;
+
+	/* Do nothing if no transmissions are queued */
+	if ( ! undinic->tx_count )
+		return;
+
+	/* Issue one PXENV_UNDI_TRANSMIT call per queued frame, all
+	 * within a single real-mode excursion.  Register state is
+	 * preserved around each entry point call, since PXE stacks
+	 * may clobber arbitrary registers.
+	 */
+	profile_start ( &profiler->total );
+	__asm__ __volatile__ ( REAL_CODE ( "pushl %%ebp\n\t" /* gcc bug */
+					   "rdtsc\n\t"
+					   "pushl %%eax\n\t"
+					   "\n1:\n\t"
+					   "pushw %%cx\n\t"
+					   "pushw %%es\n\t"
+					   "pushw %%di\n\t"
+					   "pushw %%es\n\t"
+					   "pushw %%di\n\t"
+					   "pushw %%bx\n\t"
+					   "lcall *undinet_entry_point\n\t"
+					   "addw $6, %%sp\n\t"
+					   "popw %%di\n\t"
+					   "popw %%es\n\t"
+					   "popw %%cx\n\t"
+					   "movw %9, %%bx\n\t"
+					   "addw %8, %%di\n\t"
+					   "loop 1b\n\t"
+					   "rdtsc\n\t"
+					   "popl %%edx\n\t"
+					   "popl %%ebp\n\t" /* gcc bug */ )
+			       : "=a" ( stopped ), "=d" ( started ),
+				 "=b" ( discard_b ), "=c" ( discard_c ),
+				 "=D" ( discard_D )
+			       : "b" ( PXENV_UNDI_TRANSMIT ),
+				 "c" ( undinic->tx_count ),
+				 "D" ( __from_data16 ( &undinet_tx_slots[0] ) ),
+				 "i" ( sizeof ( undinet_tx_slots[0] ) ),
+				 "i" ( PXENV_UNDI_TRANSMIT )
+			       : "esi" );
+	profile_stop ( &profiler->total );
+	before = profile_started ( &profiler->total );
+	after = profile_stopped ( &profiler->total );
+	profile_start_at ( &profiler->p2r, before );
+	profile_stop_at ( &profiler->p2r, started );
+	profile_start_at ( &profiler->ext, started );
+	profile_stop_at ( &profiler->ext, stopped );
+	profile_start_at ( &profiler->r2p, stopped );
+	profile_stop_at ( &profiler->r2p, after );
+
+	/* Complete transmissions individually, based on each
+	 * parameter block's status code.  (The PXENV_EXIT codes are
+	 * not recorded per frame; a stack that fails a transmission
+	 * is expected to set a non-zero status code.)
+	 */
+	for ( i = 0 ; i < undinic->tx_count ; i++ ) {
+		slot = &undinet_tx_slots[i];
+		iobuf = undinic->txbuf[i];
+		undinic->txbuf[i] = NULL;
+		if ( slot->transmit.Status != PXENV_STATUS_SUCCESS ) {
+			rc = -EPXECALL ( slot->transmit.Status );
+			DBGC ( undinic, "UNDINIC %p could not transmit: %s\n",
+			       undinic, strerror ( rc ) );
+			netdev_tx_complete_err ( netdev, iobuf, rc );
+		} else {
+			netdev_tx_complete ( netdev, iobuf );
+		}
+	}
+	undinic->tx_count = 0;
+}
 
 /**
  * Transmit packet
@@ -452,7 +595,7 @@ static uint8_t __data16_array ( undinet_destaddr, [ETH_ALEN] );
 static int undinet_transmit ( struct net_device *netdev,
 			      struct io_buffer *iobuf ) {
 	struct undi_nic *undinic = netdev->priv;
-	struct s_PXENV_UNDI_TRANSMIT undi_transmit;
+	struct undinet_tx_slot *slot;
 	const void *ll_dest;
 	const void *ll_source;
 	uint16_t net_proto;
@@ -461,16 +604,20 @@ static int undinet_transmit ( struct net_device *netdev,
 	size_t len;
 	int rc;
 
-	/* Technically, we ought to make sure that the previous
-	 * transmission has completed before we re-use the buffer.
+	/* Technically, we ought to make sure that any previous
+	 * transmission has completed before we re-use a slot.
 	 * However, many PXE stacks (including at least some Intel PXE
 	 * stacks and Etherboot 5.4) fail to generate TX completions.
 	 * In practice this won't be a problem, since our TX datapath
 	 * has a very low packet volume and we can get away with
 	 * assuming that a TX will be complete by the time we want to
-	 * transmit the next packet.
+	 * re-use its slot.
 	 */
 
+	/* Flush any existing batch if all slots are in use */
+	if ( undinic->tx_count == UNDINET_TX_SLOTS )
+		undinet_tx_flush ( netdev );
+
 	/* Some PXE stacks are unable to cope with P_UNKNOWN, and will
 	 * always try to prepend a link-layer header.  Work around
 	 * these stacks by stripping the existing link-layer header
@@ -483,7 +630,8 @@ static int undinet_transmit ( struct net_device *netdev,
 		       "%s\n", undinic, strerror ( rc ) );
 		return rc;
 	}
-	memcpy ( undinet_destaddr, ll_dest, sizeof ( undinet_destaddr ) );
+	slot = &undinet_tx_slots[undinic->tx_count];
+	memcpy ( slot->destaddr, ll_dest, sizeof ( slot->destaddr ) );
 	switch ( net_proto ) {
 	case htons ( ETH_P_IP ) :
 		protocol = P_IP;
@@ -501,36 +649,30 @@ static int undinet_transmit ( struct net_device *netdev,
 		break;
 	}
 
-	/* Copy packet to UNDI I/O buffer */
+	/* Copy packet to slot's frame buffer */
 	len = iob_len ( iobuf );
-	if ( len > sizeof ( basemem_packet ) )
-		len = sizeof ( basemem_packet );
-	memcpy ( &basemem_packet, iobuf->data, len );
-
-	/* Create PXENV_UNDI_TRANSMIT data structure */
-	memset ( &undi_transmit, 0, sizeof ( undi_transmit ) );
-	undi_transmit.Protocol = protocol;
-	undi_transmit.XmitFlag = ( ( flags & LL_BROADCAST ) ?
-				   XMT_BROADCAST : XMT_DESTADDR );
-	undi_transmit.DestAddr.segment = rm_ds;
-	undi_transmit.DestAddr.offset = __from_data16 ( &undinet_destaddr );
-	undi_transmit.TBD.segment = rm_ds;
-	undi_transmit.TBD.offset = __from_data16 ( &undinet_tbd );
-
-	/* Create PXENV_UNDI_TBD data structure */
-	undinet_tbd.ImmedLength = len;
-	undinet_tbd.Xmit.segment = rm_ds;
-	undinet_tbd.Xmit.offset = __from_data16 ( basemem_packet );
-
-	/* Issue PXE API call */
-	if ( ( rc = undinet_call ( undinic, PXENV_UNDI_TRANSMIT, &undi_transmit,
-				   sizeof ( undi_transmit ) ) ) != 0 )
-		goto done;
-
-	/* Free I/O buffer */
-	netdev_tx_complete ( netdev, iobuf );
- done:
-	return rc;
+	if ( len > sizeof ( slot->data ) )
+		len = sizeof ( slot->data );
+	memcpy ( slot->data, iobuf->data, len );
+
+	/* Fill in variable parameter block and buffer descriptor
+	 * fields; the real-mode pointers are pre-computed by
+	 * undinet_tx_init().
+	 */
+	slot->transmit.Status = PXENV_STATUS_SUCCESS;
+	slot->transmit.Protocol = protocol;
+	slot->transmit.XmitFlag = ( ( flags & LL_BROADCAST ) ?
+				    XMT_BROADCAST : XMT_DESTADDR );
+	slot->tbd.ImmedLength = len;
+	slot->tbd.DataBlkCount = 0;
+
+	/* Add to batch; the queue is flushed on the next poll (or
+	 * immediately, once the batch is full).
+	 */
+	undinic->txbuf[undinic->tx_count] = iobuf;
+	undinic->tx_count++;
+
+	return 0;
 }
 
 /** 
@@ -574,6 +716,9 @@ static void undinet_poll ( struct net_device *netdev ) {
 	size_t max_frag_len;
 	int rc;
 
+	/* Flush any transmissions queued since the last poll */
+	undinet_tx_flush ( netdev );
+
 	if ( ! undinic->isr_processing ) {
 		/* Allow interrupt to occur.  Do this even if
 		 * interrupts are not known to be supported, since
@@ -701,6 +846,9 @@ static int undinet_open ( struct net_device *netdev ) {
 	struct s_PXENV_UNDI_OPEN undi_open;
 	int rc;
 
+	/* Initialise transmit batch slots */
+	undinet_tx_init();
+
 	/* Hook interrupt service routine and enable interrupt if applicable */
 	if ( undinic->irq ) {
 		undinet_hook_isr ( undinic->irq );
@@ -748,6 +896,9 @@ static void undinet_close ( struct net_device *netdev ) {
 	struct s_PXENV_UNDI_CLOSE undi_close;
 	int rc;
 
+	/* Flush any queued transmissions */
+	undinet_tx_flush ( netdev );
+
 	/* Ensure ISR has exited cleanly */
 	while ( undinic->isr_processing ) {
 		undi_isr.FuncFlag = PXENV_UNDI_ISR_IN_GET_NEXT;
@@ -363,6 +363,57 @@ static inline size_t bzimage_align ( size_t len ) {
 	return ( ( len + INITRD_ALIGN - 1 ) & ~( INITRD_ALIGN - 1 ) );
 }
 
+/**
+ * Construct cpio header for initrd, if applicable
+ *
+ * @v image		bzImage image
+ * @v initrd		initrd image
+ * @v address		Address at which to write header, or UNULL
+ * @ret offset		Length of header (including filename and padding)
+ *
+ * Images with no filename are assumed to already be cpio archives
+ * and so have no header constructed for them.
+ */
+static size_t bzimage_initrd_header ( struct image *image,
+				      struct image *initrd,
+				      userptr_t address ) {
+	char *filename = initrd->cmdline;
+	char *cmdline;
+	struct cpio_header cpio;
+	size_t offset;
+	size_t name_len;
+
+	/* Do nothing for prebuilt images */
+	if ( ! ( filename && filename[0] ) )
+		return 0;
+
+	/* Create cpio header */
+	cmdline = strchr ( filename, ' ' );
+	name_len = ( ( cmdline ? ( ( size_t ) ( cmdline - filename ) )
+		       : strlen ( filename ) ) + 1 /* NUL */ );
+	memset ( &cpio, '0', sizeof ( cpio ) );
+	memcpy ( cpio.c_magic, CPIO_MAGIC, sizeof ( cpio.c_magic ) );
+	cpio_set_field ( cpio.c_mode, 0100644 );
+	cpio_set_field ( cpio.c_nlink, 1 );
+	cpio_set_field ( cpio.c_filesize, initrd->len );
+	cpio_set_field ( cpio.c_namesize, name_len );
+	if ( cmdline ) {
+		bzimage_parse_cpio_cmdline ( image, &cpio,
+					     ( cmdline + 1 /* ' ' */ ) );
+	}
+	offset = ( ( sizeof ( cpio ) + name_len + 0x03 ) & ~0x03 );
+
+	/* Write cpio header and filename, if applicable */
+	if ( address ) {
+		memset_user ( address, 0, 0, offset );
+		copy_to_user ( address, 0, &cpio, sizeof ( cpio ) );
+		copy_to_user ( address, sizeof ( cpio ), filename,
+			       ( name_len - 1 /* NUL (or space) */ ) );
+	}
+
+	return offset;
+}
+
 /**
  * Load initrd
  *
@@ -374,52 +425,33 @@ static inline size_t bzimage_align ( size_t len ) {
 static size_t bzimage_load_initrd ( struct image *image,
 				    struct image *initrd,
 				    userptr_t address ) {
-	char *filename = initrd->cmdline;
-	char *cmdline;
-	struct cpio_header cpio;
 	size_t offset;
-	size_t name_len;
 	size_t pad_len;
 
 	/* Do not include kernel image itself as an initrd */
 	if ( initrd == image )
 		return 0;
 
-	/* Create cpio header for non-prebuilt images */
-	if ( filename && filename[0] ) {
-		cmdline = strchr ( filename, ' ' );
-		name_len = ( ( cmdline ? ( ( size_t ) ( cmdline - filename ) )
-			       : strlen ( filename ) ) + 1 /* NUL */ );
-		memset ( &cpio, '0', sizeof ( cpio ) );
-		memcpy ( cpio.c_magic, CPIO_MAGIC, sizeof ( cpio.c_magic ) );
-		cpio_set_field ( cpio.c_mode, 0100644 );
-		cpio_set_field ( cpio.c_nlink, 1 );
-		cpio_set_field ( cpio.c_filesize, initrd->len );
-		cpio_set_field ( cpio.c_namesize, name_len );
-		if ( cmdline ) {
-			bzimage_parse_cpio_cmdline ( image, &cpio,
-						     ( cmdline + 1 /* ' ' */ ));
-		}
-		offset = ( ( sizeof ( cpio ) + name_len + 0x03 ) & ~0x03 );
-	} else {
-		offset = 0;
-		name_len = 0;
-	}
+	/* Calculate length of cpio header for non-prebuilt images */
+	offset = bzimage_initrd_header ( image, initrd, UNULL );
 
-	/* Copy in initrd image body (and cpio header if applicable) */
+	/* Copy in initrd image body (and cpio header if applicable).
+	 * After reshuffling, the image body will often already be at
+	 * its final address, in which case the (potentially very
+	 * large) memory move can be elided completely.
+	 */
 	if ( address ) {
-		memmove_user ( address, offset, initrd->data, 0, initrd->len );
-		if ( offset ) {
-			memset_user ( address, 0, 0, offset );
-			copy_to_user ( address, 0, &cpio, sizeof ( cpio ) );
-			copy_to_user ( address, sizeof ( cpio ), filename,
-				       ( name_len - 1 /* NUL (or space) */ ) );
+		if ( userptr_add ( address, offset ) != initrd->data ) {
+			memmove_user ( address, offset, initrd->data, 0,
+				       initrd->len );
 		}
+		bzimage_initrd_header ( image, initrd, address );
 		DBGC ( image, "bzImage %p initrd %p [%#08lx,%#08lx,%#08lx)"
 		       "%s%s\n", image, initrd, user_to_phys ( address, 0 ),
 		       user_to_phys ( address, offset ),
 		       user_to_phys ( address, ( offset + initrd->len ) ),
-		       ( filename ? " " : "" ), ( filename ? filename : "" ) );
+		       ( initrd->cmdline ? " " : "" ),
+		       ( initrd->cmdline ? initrd->cmdline : "" ) );
 		DBGC2_MD5A ( image, user_to_phys ( address, offset ),
 			     user_to_virt ( address, offset ), initrd->len );
 	}
@@ -491,6 +523,87 @@ static int bzimage_check_initrds ( struct image *image,
 	return 0;
 }
 
+/**
+ * Load initrds in place, if possible
+ *
+ * @v image		bzImage image
+ * @v bzimg		bzImage context
+ * @v top		Highest usable address
+ * @ret rc		Return status code
+ *
+ * After reshuffling, the initrd image bodies are already packed in
+ * the correct order.  Provided that each constructed cpio header
+ * fits into the gap below its image body, the combined initrd can
+ * therefore be assembled simply by writing the headers into these
+ * gaps: Linux explicitly permits zero padding between concatenated
+ * cpio archives.  This avoids a second full pass over the
+ * (potentially very large) image bodies.
+ */
+static int bzimage_load_initrds_inplace ( struct image *image,
+					  struct bzimage_context *bzimg,
+					  userptr_t top ) {
+	struct image *initrd;
+	userptr_t floor = UNULL;
+	userptr_t hdr;
+	userptr_t end;
+	size_t offset;
+
+	/* Check that the image bodies lie in order within the usable
+	 * region, with room for each cpio header below its image
+	 * body, and with the 4-byte alignment required between
+	 * concatenated cpio archives.
+	 */
+	for_each_image ( initrd ) {
+		if ( initrd == image )
+			continue;
+		if ( user_to_phys ( initrd->data, 0 ) & 0x03 )
+			return -ENOTTY;
+		offset = bzimage_initrd_header ( image, initrd, UNULL );
+		hdr = userptr_add ( initrd->data, -offset );
+		if ( floor && ( userptr_sub ( hdr, floor ) < 0 ) )
+			return -ENOTTY;
+		end = userptr_add ( initrd->data, initrd->len );
+		if ( userptr_sub ( end, top ) > 0 )
+			return -ENOTTY;
+		floor = end;
+	}
+
+	/* Construct cpio headers in the gaps between image bodies */
+	floor = UNULL;
+	for_each_image ( initrd ) {
+		if ( initrd == image )
+			continue;
+
+		/* Zero gap below header (ignored by Linux as padding) */
+		offset = bzimage_initrd_header ( image, initrd, UNULL );
+		hdr = userptr_add ( initrd->data, -offset );
+		if ( floor )
+			memset_user ( floor, 0, 0, userptr_sub ( hdr, floor ));
+
+		/* Construct cpio header, if applicable */
+		if ( offset )
+			bzimage_initrd_header ( image, initrd, hdr );
+		DBGC ( image, "bzImage %p initrd %p in place [%#08lx,%#08lx,"
+		       "%#08lx)%s%s\n", image, initrd,
+		       user_to_phys ( hdr, 0 ),
+		       user_to_phys ( initrd->data, 0 ),
+		       user_to_phys ( initrd->data, initrd->len ),
+		       ( initrd->cmdline ? " " : "" ),
+		       ( initrd->cmdline ? initrd->cmdline : "" ) );
+		DBGC2_MD5A ( image, user_to_phys ( initrd->data, 0 ),
+			     user_to_virt ( initrd->data, 0 ), initrd->len );
+
+		/* Record initrd location */
+		if ( ! bzimg->ramdisk_image )
+			bzimg->ramdisk_image = user_to_phys ( hdr, 0 );
+		floor = userptr_add ( initrd->data, initrd->len );
+	}
+	bzimg->ramdisk_size = ( user_to_phys ( floor, 0 ) -
+				bzimg->ramdisk_image );
+
+	return 0;
+}
+
 /**
  * Load initrds, if any
  *
@@ -531,6 +644,16 @@ static void bzimage_load_initrds ( struct image *image,
 	DBGC ( image, "bzImage %p loading initrds from %#08lx downwards\n",
 	       image, user_to_phys ( top, -1 ) );
 
+	/* Assemble initrds in place if possible, avoiding a second
+	 * pass over the image bodies.
+	 */
+	if ( bzimage_load_initrds_inplace ( image, bzimg, top ) == 0 ) {
+		DBGC ( image, "bzImage %p initrds at [%#08lx,%#08lx)\n",
+		       image, bzimg->ramdisk_image,
+		       ( bzimg->ramdisk_image + bzimg->ramdisk_size ) );
+		return;
+	}
+
 	/* Load initrds in order */
 	for_each_image ( initrd ) {
 
@@ -668,6 +791,10 @@ int bzimage_probe ( struct image *image ) {
 /** Linux bzImage image type */
 struct image_type bzimage_image_type __image_type ( PROBE_NORMAL ) = {
 	.name = "bzImage",
+	.sigoffset = ( BZI_HDR_OFFSET +
+		       offsetof ( struct bzimage_header, boot_flag ) ),
+	.signature = "\x55\xaa", /* BZI_BOOT_FLAG */
+	.siglen = 2,
 	.probe = bzimage_probe,
 	.exec = bzimage_exec,
 };
@@ -140,6 +140,8 @@ static int elfboot_probe ( struct image *image ) {
 /** ELF image type */
 struct image_type elfboot_image_type __image_type ( PROBE_NORMAL ) = {
 	.name = "ELF",
+	.signature = "\x7f" "ELF",
+	.siglen = 4,
 	.probe = elfboot_probe,
 	.exec = elfboot_exec,
 };
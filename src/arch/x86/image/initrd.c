@@ -70,18 +70,25 @@ static userptr_t initrd_squash_high ( userptr_t top ) {
 		if ( ! highest )
 			break;
 
-		/* Move this image to its final position */
+		/* Move this image to its final position.  Images
+		 * downloaded into the external heap will typically
+		 * already be packed at the top of memory, in which
+		 * case no data needs to be moved at all.
+		 */
 		len = ( ( highest->len + INITRD_ALIGN - 1 ) &
 			~( INITRD_ALIGN - 1 ) );
 		current = userptr_sub ( current, len );
-		DBGC ( &images, "INITRD squashing %s [%#08lx,%#08lx)->"
-		       "[%#08lx,%#08lx)\n", highest->name,
-		       user_to_phys ( highest->data, 0 ),
-		       user_to_phys ( highest->data, highest->len ),
-		       user_to_phys ( current, 0 ),
-		       user_to_phys ( current, highest->len ) );
-		memmove_user ( current, 0, highest->data, 0, highest->len );
-		highest->data = current;
+		if ( current != highest->data ) {
+			DBGC ( &images, "INITRD squashing %s [%#08lx,%#08lx)->"
+			       "[%#08lx,%#08lx)\n", highest->name,
+			       user_to_phys ( highest->data, 0 ),
+			       user_to_phys ( highest->data, highest->len ),
+			       user_to_phys ( current, 0 ),
+			       user_to_phys ( current, highest->len ) );
+			memmove_user ( current, 0, highest->data, 0,
+				       highest->len );
+			highest->data = current;
+		}
 	}
 
 	/* Copy any remaining initrds (e.g. embedded images) to the region */
@@ -422,6 +422,8 @@ static int nbi_probe ( struct image *image ) {
 /** NBI image type */
 struct image_type nbi_image_type __image_type ( PROBE_NORMAL ) = {
 	.name = "NBI",
+	.signature = "\x36\x13\x03\x1b", /* NBI_MAGIC */
+	.siglen = 4,
 	.probe = nbi_probe,
 	.exec = nbi_exec,
 };
@@ -135,6 +135,8 @@ static int sdi_probe ( struct image *image ) {
 /** SDI image type */
 struct image_type sdi_image_type __image_type ( PROBE_NORMAL ) = {
 	.name = "SDI",
+	.signature = "$SDI",
+	.siglen = 4,
 	.probe = sdi_probe,
 	.exec = sdi_exec,
 };
@@ -0,0 +1,17 @@
+#ifndef _BITS_AES_H
+#define _BITS_AES_H
+
+/** @file
+ *
+ * AES algorithm
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+extern int aes_accel_encrypt ( struct aes_context *aes, const void *src,
+			       void *dst );
+extern int aes_accel_decrypt ( struct aes_context *aes, const void *src,
+			       void *dst );
+
+#endif /* _BITS_AES_H */
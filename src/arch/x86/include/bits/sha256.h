@@ -0,0 +1,14 @@
+#ifndef _BITS_SHA256_H
+#define _BITS_SHA256_H
+
+/** @file
+ *
+ * SHA-256 algorithm
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+extern int sha256_accel_digest ( struct sha256_context *context );
+
+#endif /* _BITS_SHA256_H */
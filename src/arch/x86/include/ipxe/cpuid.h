@@ -39,9 +39,24 @@ struct x86_features {
 /** Get standard features */
 #define CPUID_FEATURES 0x00000001UL
 
+/** AES instruction set is present */
+#define CPUID_FEATURES_INTEL_ECX_AES 0x02000000UL
+
+/** RDRAND instruction is present */
+#define CPUID_FEATURES_INTEL_ECX_RDRAND 0x40000000UL
+
 /** Hypervisor is present */
 #define CPUID_FEATURES_INTEL_ECX_HYPERVISOR 0x80000000UL
 
+/** Get structured extended features */
+#define CPUID_EXTENDED_FEATURES 0x00000007UL
+
+/** Enhanced REP MOVSB/STOSB is present */
+#define CPUID_EXTENDED_FEATURES_EBX_ERMS 0x00000200UL
+
+/** SHA instruction set is present */
+#define CPUID_EXTENDED_FEATURES_EBX_SHA 0x20000000UL
+
 /** Get largest extended function */
 #define CPUID_AMD_MAX_FN 0x80000000UL
 
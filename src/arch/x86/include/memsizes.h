@@ -15,5 +15,6 @@ static inline unsigned int basememsize ( void ) {
 }
 
 extern unsigned int extmemsize ( void );
+extern void memmap_invalidate ( void );
 
 #endif /* _MEMSIZES_H */
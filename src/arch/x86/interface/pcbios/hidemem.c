@@ -26,6 +26,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <realmode.h>
 #include <biosint.h>
 #include <basemem.h>
+#include <memsizes.h>
 #include <fakee820.h>
 #include <ipxe/init.h>
 #include <ipxe/io.h>
@@ -97,6 +98,9 @@ static void hide_region ( struct hidden_region *region,
 	region->start = ( start & ~( ALIGN_HIDDEN - 1 ) );
 	region->end = ( ( end + ALIGN_HIDDEN - 1 ) & ~( ALIGN_HIDDEN - 1 ) );
 
+	/* Invalidate any cached memory map */
+	memmap_invalidate();
+
 	DBG ( "Hiding region [%llx,%llx)\n", region->start, region->end );
 }
 
@@ -110,6 +114,9 @@ void hide_basemem ( void ) {
 	 * nearest page boundary.
 	 */
 	hidemem_base.start = ( get_fbms() * 1024 );
+
+	/* Invalidate any cached memory map */
+	memmap_invalidate();
 }
 
 /**
@@ -180,6 +187,7 @@ static void hide_etherboot ( void ) {
 
 	/* Hook INT 15 */
 	hook_bios_interrupt ( 0x15, ( intptr_t ) int15, &int15_vector );
+	memmap_invalidate();
 
 	/* Dump memory map after mangling */
 	DBG ( "Hidden iPXE from system memory map\n" );
@@ -210,7 +218,9 @@ static void unhide_etherboot ( int flags __unused ) {
 
 	/* Try to unhook INT 15 */
 	if ( ( rc = unhook_bios_interrupt ( 0x15, ( intptr_t ) int15,
-					    &int15_vector ) ) != 0 ) {
+					    &int15_vector ) ) == 0 ) {
+		memmap_invalidate();
+	} else {
 		DBG ( "Cannot unhook INT15: %s\n", strerror ( rc ) );
 		/* Leave it hooked; there's nothing else we can do,
 		 * and it should be intrinsically safe (though
@@ -139,6 +139,17 @@ static uint8_t __text16 ( num_fdds );
 static uint8_t __text16 ( num_drives );
 #define num_drives __use_text16 ( num_drives )
 
+/**
+ * Emulated drive number bitmap
+ *
+ * This is a bitmap of all drive numbers (including natural drive
+ * numbers) belonging to emulated drives.  It is held in .text16 to
+ * allow the INT 13 wrapper to chain calls for non-emulated drives
+ * without the cost of a mode transition.
+ */
+static uint8_t __text16_array ( int13_drive_map, [32] );
+#define int13_drive_map __use_text16 ( int13_drive_map )
+
 /**
  * Calculate SAN device capacity (limited to 32 bits)
  *
@@ -447,6 +458,24 @@ static void int13_sync_num_drives ( void ) {
 	put_real ( num_drives, BDA_SEG, BDA_NUM_DRIVES );
 }
 
+/**
+ * Rebuild emulated drive number bitmap
+ */
+static void int13_sync_drive_map ( void ) {
+	struct san_device *sandev;
+	struct int13_data *int13;
+	unsigned int drive;
+
+	memset ( int13_drive_map, 0, sizeof ( int13_drive_map ) );
+	for_each_sandev ( sandev ) {
+		int13 = sandev->priv;
+		drive = sandev->drive;
+		int13_drive_map[ drive / 8 ] |= ( 1 << ( drive % 8 ) );
+		drive = int13->natural_drive;
+		int13_drive_map[ drive / 8 ] |= ( 1 << ( drive % 8 ) );
+	}
+}
+
 /**
  * Check number of drives
  */
@@ -1182,12 +1211,33 @@ static void int13_hook_vector ( void ) {
 			     "movw %%sp, %%bp\n\t"			     
 			     "pushw %%ax\n\t"
 			     "pushw %%dx\n\t"
+			     /* Chain directly (without a mode
+			      * transition) for calls that cannot
+			      * relate to an emulated drive.  INT
+			      * 13,08 and INT 13,15 return drive
+			      * counts, and INT 13,4b is not
+			      * drive-specific; these must always take
+			      * the slow path.
+			      */
+			     "cmpb $0x08, %%ah\n\t"
+			     "je 5f\n\t"
+			     "cmpb $0x15, %%ah\n\t"
+			     "je 5f\n\t"
+			     "cmpb $0x4b, %%ah\n\t"
+			     "je 5f\n\t"
+			     "pushw %%bx\n\t"
+			     "movzbw %%dl, %%bx\n\t"
+			     "btw %%bx, %%cs:int13_drive_map\n\t"
+			     "popw %%bx\n\t"
+			     "jnc 4f\n\t"
+			     "\n5:\n\t"
 			     /* Clear OF, set CF, call int13() */
 			     "orb $0, %%al\n\t" 
 			     "stc\n\t"
 			     VIRT_CALL ( int13 )
 			     /* Chain if OF not set */
 			     "jo 1f\n\t"
+			     "\n4:\n\t"
 			     "pushfw\n\t"
 			     "lcall *%%cs:int13_vector\n\t"
 			     "\n1:\n\t"
@@ -1300,8 +1350,9 @@ static int int13_hook ( unsigned int drive, struct uri **uris,
 		devices_get();
 	}
 
-	/* Update BIOS drive count */
+	/* Update BIOS drive count and emulated drive bitmap */
 	int13_sync_num_drives();
+	int13_sync_drive_map();
 
 	free ( scratch );
 	return drive;
@@ -1339,6 +1390,9 @@ static void int13_unhook ( unsigned int drive ) {
 	/* Unregister SAN device */
 	unregister_sandev ( sandev );
 
+	/* Update emulated drive bitmap */
+	int13_sync_drive_map();
+
 	/* Should adjust BIOS drive count, but it's difficult
 	 * to do so reliably.
 	 */
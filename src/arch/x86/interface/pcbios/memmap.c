@@ -24,6 +24,7 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
+#include <string.h>
 #include <errno.h>
 #include <realmode.h>
 #include <bios.h>
@@ -306,6 +307,22 @@ static int meme820 ( struct memory_map *memmap ) {
 	return 0;
 }
 
+/** Cached memory map */
+static struct memory_map memmap_cache;
+
+/** Cached memory map is valid */
+static int memmap_cache_valid;
+
+/**
+ * Invalidate cached memory map
+ *
+ * This must be called by any code that alters the underlying memory
+ * map (e.g. by hiding additional memory regions).
+ */
+void memmap_invalidate ( void ) {
+	memmap_cache_valid = 0;
+}
+
 /**
  * Get memory map
  *
@@ -315,6 +332,16 @@ void x86_get_memmap ( struct memory_map *memmap ) {
 	unsigned int basemem, extmem;
 	int rc;
 
+	/* Use cached memory map, if still valid.  Constructing the
+	 * map requires a long series of real-mode INT 15 calls, and
+	 * several callers (settings fetches, image segment placement)
+	 * rebuild the map repeatedly.
+	 */
+	if ( memmap_cache_valid ) {
+		memcpy ( memmap, &memmap_cache, sizeof ( *memmap ) );
+		return;
+	}
+
 	DBG ( "Fetching system memory map\n" );
 
 	/* Clear memory map */
@@ -329,15 +356,20 @@ void x86_get_memmap ( struct memory_map *memmap ) {
 	/* Try INT 15,e820 first */
 	if ( ( rc = meme820 ( memmap ) ) == 0 ) {
 		DBG ( "Obtained system memory map via INT 15,e820\n" );
-		return;
+	} else {
+		/* Fall back to constructing a map from basemem and
+		 * extmem sizes
+		 */
+		DBG ( "INT 15,e820 failed; constructing map\n" );
+		memmap->regions[0].end = ( basemem * 1024 );
+		memmap->regions[1].start = 0x100000;
+		memmap->regions[1].end = 0x100000 + ( extmem * 1024 );
+		memmap->count = 2;
 	}
 
-	/* Fall back to constructing a map from basemem and extmem sizes */
-	DBG ( "INT 15,e820 failed; constructing map\n" );
-	memmap->regions[0].end = ( basemem * 1024 );
-	memmap->regions[1].start = 0x100000;
-	memmap->regions[1].end = 0x100000 + ( extmem * 1024 );
-	memmap->count = 2;
+	/* Update cached memory map */
+	memcpy ( &memmap_cache, memmap, sizeof ( memmap_cache ) );
+	memmap_cache_valid = 1;
 }
 
 PROVIDE_IOAPI ( x86, get_memmap, x86_get_memmap );
@@ -232,4 +232,19 @@ static userptr_t memtop_urealloc ( userptr_t ptr, size_t new_size ) {
 	return ( new_size ? new : UNOWHERE );
 }
 
+/**
+ * Estimate available external memory
+ *
+ * @ret avail		Estimated available memory
+ */
+static size_t memtop_umavail ( void ) {
+
+	/* Initialise external memory allocator if necessary */
+	if ( bottom == top )
+		init_eheap();
+
+	return heap_size;
+}
+
 PROVIDE_UMALLOC ( memtop, urealloc, memtop_urealloc );
+PROVIDE_UMALLOC ( memtop, umavail, memtop_umavail );
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Network device wakeup interrupts
+ *
+ * This provides the wakeup mechanism used by the scheduler to halt
+ * the CPU while waiting for network activity.  The interrupt is never
+ * used to drive the receive datapath: the interrupt service routine
+ * simply masks its own IRQ line (to prevent an interrupt storm, since
+ * a level-triggered line will remain asserted until the device is
+ * eventually serviced), sends EOI, and returns, leaving the woken CPU
+ * to resume polling as normal.
+ *
+ * Note that an interrupt arriving in the short window between
+ * enabling wakeups and halting the CPU will mask the IRQ line before
+ * the CPU halts.  The CPU will still be woken by the next timer tick,
+ * so the worst case is a single bounded delay rather than a lost
+ * wakeup.
+ */
+
+#include <stdint.h>
+#include <errno.h>
+#include <assert.h>
+#include <biosint.h>
+#include <pic8259.h>
+#include <realmode.h>
+#include <ipxe/device.h>
+#include <ipxe/netdevice.h>
+
+/** Assembly interrupt service routine */
+extern void netisr ( void );
+
+/** IRQ number */
+uint8_t __data16 ( netisr_irq );
+#define netisr_irq __use_data16 ( netisr_irq )
+
+/** IRQ mask register */
+uint16_t __data16 ( netisr_imr );
+#define netisr_imr __use_data16 ( netisr_imr )
+
+/** IRQ mask bit */
+uint8_t __data16 ( netisr_imr_bit );
+#define netisr_imr_bit __use_data16 ( netisr_imr_bit )
+
+/** Previous interrupt handler */
+static struct segoff netisr_next_handler;
+
+/** Number of devices sharing the hooked IRQ */
+static unsigned int netisr_count;
+
+/**
+ * Hook wakeup interrupt service routine
+ *
+ * @v irq		IRQ number
+ * @ret rc		Return status code
+ */
+static int netisr_hook ( unsigned int irq ) {
+
+	assert ( irq <= IRQ_MAX );
+
+	/* Share the existing hook if the IRQ number matches.  Only a
+	 * single IRQ can be hooked at any one time; devices on other
+	 * IRQ lines cause the scheduler to fall back to polling.
+	 */
+	if ( netisr_count ) {
+		if ( irq != netisr_irq )
+			return -EBUSY;
+		netisr_count++;
+		return 0;
+	}
+
+	/* Precalculate mask register and bit for use by the ISR */
+	netisr_irq = irq;
+	netisr_imr = IMR_REG ( irq );
+	netisr_imr_bit = IMR_BIT ( irq );
+
+	/* Hook ISR */
+	hook_bios_interrupt ( IRQ_INT ( irq ), ( ( intptr_t ) netisr ),
+			      &netisr_next_handler );
+	netisr_count++;
+
+	return 0;
+}
+
+/**
+ * Unhook wakeup interrupt service routine
+ *
+ * @v irq		IRQ number
+ */
+static void netisr_unhook ( unsigned int irq ) {
+
+	assert ( netisr_count > 0 );
+	assert ( irq == netisr_irq );
+
+	/* Unhook ISR when last sharing device is released */
+	if ( --netisr_count )
+		return;
+	unhook_bios_interrupt ( IRQ_INT ( irq ), ( ( intptr_t ) netisr ),
+				&netisr_next_handler );
+}
+
+/**
+ * Arrange for a network device to wake a halted CPU
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+int netdev_wake ( struct net_device *netdev ) {
+	unsigned int irq = netdev->dev->desc.irq;
+	int rc;
+
+	/* Fail if device has no usable IRQ */
+	if ( ( irq == 0 ) || ( irq > IRQ_MAX ) )
+		return -ENOTSUP;
+
+	/* Hook ISR */
+	if ( ( rc = netisr_hook ( irq ) ) != 0 )
+		return rc;
+
+	/* Enable interrupt generation and unmask IRQ line */
+	netdev_irq ( netdev, 1 );
+	enable_irq ( irq );
+
+	return 0;
+}
+
+/**
+ * Stop a network device from waking a halted CPU
+ *
+ * @v netdev		Network device
+ */
+void netdev_unwake ( struct net_device *netdev ) {
+	unsigned int irq = netdev->dev->desc.irq;
+
+	/* Mask IRQ line (which may already have been masked by the
+	 * ISR) and disable interrupt generation.
+	 */
+	disable_irq ( irq );
+	netdev_irq ( netdev, 0 );
+
+	/* Unhook ISR */
+	netisr_unhook ( irq );
+}
@@ -36,11 +36,18 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <biosint.h>
 #include <pic8259.h>
 #include <rtc.h>
+#include <ipxe/cpuid.h>
 #include <ipxe/entropy.h>
 
 /** Maximum time to wait for an RTC interrupt, in milliseconds */
 #define RTC_MAX_WAIT_MS 100
 
+/** Number of times to retry the RDRAND instruction */
+#define RDRAND_MAX_RETRIES 16
+
+/** RDRAND instruction is available and functional */
+static int rdrand_available;
+
 /** RTC interrupt handler */
 extern void rtc_isr ( void );
 
@@ -168,6 +175,48 @@ static int rtc_entropy_check ( void ) {
 	return -ETIMEDOUT;
 }
 
+/**
+ * Attempt to read a single RDRAND value
+ *
+ * @v value		Value to fill in
+ * @ret ok		Value is valid
+ */
+static uint8_t rdrand_try ( uint32_t *value ) {
+	uint8_t ok;
+
+	__asm__ __volatile__ ( "rdrand %0\n\t"
+			       "setc %1\n\t"
+			       : "=r" ( *value ), "=qm" ( ok ) );
+	return ok;
+}
+
+/**
+ * Probe for a functional RDRAND instruction
+ *
+ */
+static void rdrand_probe ( void ) {
+	uint32_t discard_a;
+	uint32_t discard_b;
+	uint32_t ecx;
+	uint32_t discard_d;
+	uint32_t value;
+
+	/* Check for RDRAND instruction support */
+	if ( cpuid_supported ( CPUID_FEATURES ) != 0 )
+		return;
+	cpuid ( CPUID_FEATURES, 0, &discard_a, &discard_b, &ecx,
+		&discard_d );
+	if ( ! ( ecx & CPUID_FEATURES_INTEL_ECX_RDRAND ) )
+		return;
+
+	/* Check that RDRAND actually produces a value */
+	if ( ! rdrand_try ( &value ) )
+		return;
+
+	DBGC ( &rtc_flag, "RTC using RDRAND for noise samples\n" );
+	rdrand_available = 1;
+}
+
 /**
  * Enable entropy gathering
  *
@@ -176,6 +225,13 @@ static int rtc_entropy_check ( void ) {
 static int rtc_entropy_enable ( void ) {
 	int rc;
 
+	/* Probe for RDRAND.  The RTC interrupt remains hooked even
+	 * when RDRAND is used, to provide a fallback noise source in
+	 * the (unlikely) event that the hardware generator becomes
+	 * temporarily exhausted.
+	 */
+	rdrand_probe();
+
 	/* Hook ISR and enable RTC interrupts */
 	rtc_hook_isr();
 	enable_irq ( RTC_IRQ );
@@ -215,6 +271,21 @@ uint8_t rtc_sample ( void ) {
 	uint32_t before;
 	uint32_t after;
 	uint32_t temp;
+	uint32_t value;
+	unsigned int i;
+
+	/* Use RDRAND where available.  Each sample is credited with
+	 * only the min-entropy measured for RTC tick sampling, but is
+	 * gathered in a few cycles rather than having to wait for two
+	 * RTC interrupts (of the order of milliseconds per sample).
+	 */
+	if ( rdrand_available ) {
+		for ( i = 0 ; i < RDRAND_MAX_RETRIES ; i++ ) {
+			if ( rdrand_try ( &value ) )
+				return value;
+		}
+		/* Generator is exhausted: fall back to tick sampling */
+	}
 
 	__asm__ __volatile__ (
 		REAL_CODE ( /* Enable interrupts */
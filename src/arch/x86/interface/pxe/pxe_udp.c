@@ -60,8 +60,68 @@ struct pxe_udp_connection {
 	struct sockaddr_in local;
 	/** List of received packets */
 	struct list_head list;
+	/** Posted UDP read operation (if any) */
+	struct s_PXENV_UDP_READ *read;
 };
 
+/**
+ * Complete UDP read operation
+ *
+ * @v read		UDP read operation
+ * @v pshdr		PXE UDP pseudo-header
+ * @v data		UDP payload
+ * @v len		Length of UDP payload
+ * @ret rc		Return status code
+ *
+ * Copies the payload into the caller's buffer and fills in the
+ * address information, provided that the packet matches the read
+ * operation's destination address and port filter.
+ */
+static int pxe_udp_complete ( struct s_PXENV_UDP_READ *read,
+			      struct pxe_udp_pseudo_header *pshdr,
+			      const void *data, size_t len ) {
+	struct in_addr dest_ip_wanted = { .s_addr = read->dest_ip };
+	struct in_addr dest_ip = { .s_addr = pshdr->dest_ip };
+	uint16_t d_port_wanted = read->d_port;
+	userptr_t buffer;
+
+	/* Filter on destination address and/or port */
+	if ( dest_ip_wanted.s_addr &&
+	     ( dest_ip_wanted.s_addr != dest_ip.s_addr ) ) {
+		DBG ( " wrong IP %s", inet_ntoa ( dest_ip ) );
+		DBG ( " (wanted %s)\n", inet_ntoa ( dest_ip_wanted ) );
+		return -ENOTTY;
+	}
+	if ( d_port_wanted && ( d_port_wanted != pshdr->d_port ) ) {
+		DBG ( " wrong port %d", htons ( pshdr->d_port ) );
+		DBG ( " (wanted %d)\n", htons ( d_port_wanted ) );
+		return -ENOTTY;
+	}
+
+	/* Copy payload to buffer and record length */
+	buffer = real_to_user ( read->buffer.segment, read->buffer.offset );
+	if ( len > read->buffer_size )
+		len = read->buffer_size;
+	copy_to_user ( buffer, 0, data, len );
+	read->buffer_size = len;
+
+	/* Fill in source/dest information */
+	read->src_ip = pshdr->src_ip;
+	read->s_port = pshdr->s_port;
+	read->dest_ip = pshdr->dest_ip;
+	read->d_port = pshdr->d_port;
+
+	DBG ( " %04x:%04x+%x %s:", read->buffer.segment, read->buffer.offset,
+	      read->buffer_size,
+	      inet_ntoa ( *( ( struct in_addr * ) &read->src_ip ) ) );
+	DBG ( "%d<-%s:%d\n", ntohs ( read->s_port ),
+	      inet_ntoa ( *( ( struct in_addr * ) &read->dest_ip ) ),
+	      ntohs ( read->d_port ) );
+
+	read->Status = PXENV_STATUS_SUCCESS;
+	return 0;
+}
+
 /**
  * Receive PXE UDP data
  *
@@ -71,7 +131,9 @@ struct pxe_udp_connection {
  * @ret rc			Return status code
  *
  * Receives a packet as part of the current pxenv_udp_read()
- * operation.
+ * operation.  If a read operation has been posted then its buffer is
+ * used as the copy destination directly; otherwise the packet is
+ * added to the receive queue.
  */
 static int pxe_udp_deliver ( struct pxe_udp_connection *pxe_udp,
 			     struct io_buffer *iobuf,
@@ -102,6 +164,22 @@ static int pxe_udp_deliver ( struct pxe_udp_connection *pxe_udp,
 	pshdr->dest_ip = sin_dest->sin_addr.s_addr;
 	pshdr->d_port = sin_dest->sin_port;
 
+	/* Complete any posted read operation directly, landing the
+	 * single copy in the caller's buffer without staging the
+	 * packet through the receive queue.
+	 */
+	if ( pxe_udp->read ) {
+		DBG ( "PXENV_UDP_READ" );
+		if ( pxe_udp_complete ( pxe_udp->read, pshdr,
+					( pshdr + 1 ),
+					( iob_len ( iobuf ) -
+					  sizeof ( *pshdr ) ) ) == 0 ) {
+			pxe_udp->read = NULL;
+			free_iob ( iobuf );
+			return 0;
+		}
+	}
+
 	/* Add to queue */
 	list_add_tail ( &iobuf->list, &pxe_udp->list );
 
@@ -393,79 +471,42 @@ pxenv_udp_write ( struct s_PXENV_UDP_WRITE *pxenv_udp_write ) {
  *
  */
 static PXENV_EXIT_t pxenv_udp_read ( struct s_PXENV_UDP_READ *pxenv_udp_read ) {
-	struct in_addr dest_ip_wanted = { .s_addr = pxenv_udp_read->dest_ip };
-	struct in_addr dest_ip;
 	struct io_buffer *iobuf;
 	struct pxe_udp_pseudo_header *pshdr;
-	uint16_t d_port_wanted = pxenv_udp_read->d_port;
-	uint16_t d_port;
-	userptr_t buffer;
-	size_t len;
-
-	/* Try receiving a packet, if the queue is empty */
-	if ( list_empty ( &pxe_udp.list ) )
-		step();
+	int rc;
 
-	/* Remove first packet from the queue */
+	/* Deliver any already-queued packet */
 	iobuf = list_first_entry ( &pxe_udp.list, struct io_buffer, list );
-	if ( ! iobuf ) {
-		/* No packet received */
-		DBG2 ( "PXENV_UDP_READ\n" );
-		goto no_packet;
-	}
-	list_del ( &iobuf->list );
+	if ( iobuf ) {
+		list_del ( &iobuf->list );
 
-	/* Strip pseudo-header */
-	assert ( iob_len ( iobuf ) >= sizeof ( *pshdr ) );
-	pshdr = iobuf->data;
-	iob_pull ( iobuf, sizeof ( *pshdr ) );
-	dest_ip.s_addr = pshdr->dest_ip;
-	d_port = pshdr->d_port;
-	DBG ( "PXENV_UDP_READ" );
+		/* Strip pseudo-header */
+		assert ( iob_len ( iobuf ) >= sizeof ( *pshdr ) );
+		pshdr = iobuf->data;
+		iob_pull ( iobuf, sizeof ( *pshdr ) );
+		DBG ( "PXENV_UDP_READ" );
 
-	/* Filter on destination address and/or port */
-	if ( dest_ip_wanted.s_addr &&
-	     ( dest_ip_wanted.s_addr != dest_ip.s_addr ) ) {
-		DBG ( " wrong IP %s", inet_ntoa ( dest_ip ) );
-		DBG ( " (wanted %s)\n", inet_ntoa ( dest_ip_wanted ) );
-		goto drop;
-	}
-	if ( d_port_wanted && ( d_port_wanted != d_port ) ) {
-		DBG ( " wrong port %d", htons ( d_port ) );
-		DBG ( " (wanted %d)\n", htons ( d_port_wanted ) );
-		goto drop;
+		/* Copy packet to buffer */
+		rc = pxe_udp_complete ( pxenv_udp_read, pshdr, iobuf->data,
+					iob_len ( iobuf ) );
+		free_iob ( iobuf );
+		if ( rc != 0 )
+			goto no_packet;
+		return PXENV_EXIT_SUCCESS;
 	}
 
-	/* Copy packet to buffer and record length */
-	buffer = real_to_user ( pxenv_udp_read->buffer.segment,
-				pxenv_udp_read->buffer.offset );
-	len = iob_len ( iobuf );
-	if ( len > pxenv_udp_read->buffer_size )
-		len = pxenv_udp_read->buffer_size;
-	copy_to_user ( buffer, 0, iobuf->data, len );
-	pxenv_udp_read->buffer_size = len;
-
-	/* Fill in source/dest information */
-	pxenv_udp_read->src_ip = pshdr->src_ip;
-	pxenv_udp_read->s_port = pshdr->s_port;
-	pxenv_udp_read->dest_ip = pshdr->dest_ip;
-	pxenv_udp_read->d_port = pshdr->d_port;
-
-	DBG ( " %04x:%04x+%x %s:", pxenv_udp_read->buffer.segment,
-	      pxenv_udp_read->buffer.offset, pxenv_udp_read->buffer_size,
-	      inet_ntoa ( *( ( struct in_addr * ) &pxenv_udp_read->src_ip ) ));
-	DBG ( "%d<-%s:%d\n",  ntohs ( pxenv_udp_read->s_port ),
-	      inet_ntoa ( *( ( struct in_addr * ) &pxenv_udp_read->dest_ip ) ),
-	      ntohs ( pxenv_udp_read->d_port ) );
-
-	/* Free I/O buffer */
-	free_iob ( iobuf );
-
-	pxenv_udp_read->Status = PXENV_STATUS_SUCCESS;
-	return PXENV_EXIT_SUCCESS;
-
- drop:
-	free_iob ( iobuf );
+	/* Post read operation and try receiving a packet, allowing
+	 * the receive path to copy the payload directly into the
+	 * caller's buffer.
+	 */
+	pxe_udp.read = pxenv_udp_read;
+	step();
+	if ( ! pxe_udp.read )
+		return PXENV_EXIT_SUCCESS;
+	pxe_udp.read = NULL;
+
+	/* No packet received */
+	DBG2 ( "PXENV_UDP_READ\n" );
  no_packet:
 	pxenv_udp_read->Status = PXENV_STATUS_FAILURE;
 	return PXENV_EXIT_FAILURE;
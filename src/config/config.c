@@ -123,6 +123,9 @@ REQUIRE_OBJECT ( nfs_open );
 #ifdef DOWNLOAD_PROTO_SLAM
 REQUIRE_OBJECT ( slam );
 #endif
+#ifdef DOWNLOAD_PROTO_IMGSHARE
+REQUIRE_OBJECT ( imgshare );
+#endif
 
 /*
  * Drag in all requested SAN boot protocols
@@ -131,6 +134,9 @@ REQUIRE_OBJECT ( slam );
 #ifdef SANBOOT_PROTO_ISCSI
 REQUIRE_OBJECT ( iscsi );
 #endif
+#ifdef SANBOOT_PROTO_NVMETCP
+REQUIRE_OBJECT ( nvmetcp );
+#endif
 #ifdef SANBOOT_PROTO_HTTP
 REQUIRE_OBJECT ( httpblock );
 #endif
@@ -275,12 +281,33 @@ REQUIRE_OBJECT ( ipstat_cmd );
 #ifdef PROFSTAT_CMD
 REQUIRE_OBJECT ( profstat_cmd );
 #endif
+#ifdef BENCH_CMD
+REQUIRE_OBJECT ( bench_cmd );
+#endif
+#ifdef TRACETIME_CMD
+REQUIRE_OBJECT ( tracetime_cmd );
+#endif
+#ifdef PENDING_CMD
+REQUIRE_OBJECT ( pending_cmd );
+#endif
 #ifdef NTP_CMD
 REQUIRE_OBJECT ( ntp_cmd );
 #endif
 #ifdef CERT_CMD
 REQUIRE_OBJECT ( cert_cmd );
 #endif
+#ifdef IMGSERVE_CMD
+REQUIRE_OBJECT ( imgserve_cmd );
+#endif
+#ifdef PCAP_CMD
+REQUIRE_OBJECT ( pcap_cmd );
+#endif
+#ifdef IMPAIR_CMD
+REQUIRE_OBJECT ( impair_cmd );
+#endif
+#ifdef MEMSTAT_CMD
+REQUIRE_OBJECT ( memstat_cmd );
+#endif
 
 /*
  * Drag in miscellaneous objects
@@ -289,6 +316,9 @@ REQUIRE_OBJECT ( cert_cmd );
 #ifdef NULL_TRAP
 REQUIRE_OBJECT ( nulltrap );
 #endif
+#ifdef CPU_PERF
+REQUIRE_OBJECT ( cpuperf );
+#endif
 #ifdef GDBSERIAL
 REQUIRE_OBJECT ( gdbidt );
 REQUIRE_OBJECT ( gdbserial );
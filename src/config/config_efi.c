@@ -23,6 +23,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <config/general.h>
 #include <config/console.h>
+#include <config/settings.h>
 
 /** @file
  *
@@ -49,3 +50,12 @@ REQUIRE_OBJECT ( efi_fbcon );
 #ifdef DOWNLOAD_PROTO_FILE
 REQUIRE_OBJECT ( efi_local );
 #endif
+
+/*
+ * Drag in all requested settings sources
+ *
+ */
+
+#ifdef EFIVAR_SETTINGS
+REQUIRE_OBJECT ( efi_nvo );
+#endif
@@ -43,6 +43,12 @@ REQUIRE_OBJECT ( httpdigest );
 #ifdef HTTP_AUTH_NTLM
 REQUIRE_OBJECT ( httpntlm );
 #endif
+#ifdef HTTP_ENC_GZIP
+REQUIRE_OBJECT ( httpgzip );
+#endif
+#ifdef HTTP_ENC_ZSTD
+REQUIRE_OBJECT ( httpzstd );
+#endif
 #ifdef HTTP_ENC_PEERDIST
 REQUIRE_OBJECT ( peerdist );
 #endif
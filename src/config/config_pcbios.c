@@ -22,6 +22,7 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <config/console.h>
+#include <config/general.h>
 
 /** @file
  *
@@ -48,3 +49,12 @@ REQUIRE_OBJECT ( vesafb );
 #ifdef CONSOLE_INT13
 REQUIRE_OBJECT ( int13con );
 #endif
+
+/*
+ * Drag in interrupt-driven wakeup support
+ *
+ */
+
+#ifdef NETDEV_WAKE
+REQUIRE_OBJECT ( netwake );
+#endif
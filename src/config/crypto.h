@@ -15,6 +15,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** AES-CBC block cipher */
 #define CRYPTO_CIPHER_AES_CBC
 
+/** AES-GCM block cipher */
+#define CRYPTO_CIPHER_AES_GCM
+
 /** MD5 digest algorithm
  *
  * Note that use of MD5 is implicit when using TLSv1.1 or earlier.
@@ -69,6 +69,13 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define DHCP_REQ_PROXY_TIMEOUT_SEC	2
 //#define DHCP_REQ_PROXY_TIMEOUT_SEC	7	/* as per PXE spec */
 
+/*
+ * An attempt to reclaim a cached lease (via an INIT-REBOOT request)
+ * should fall back to normal discovery quickly if no server answers,
+ * so that a stale cache costs little on top of a full negotiation.
+ */
+#define DHCP_REQ_RECLAIM_TIMEOUT_SEC	2
+
 /*
  * Per the PXE spec, a PXE boot server request is also be retried 4
  * times at timeouts of 1, 2, 3, 4.  iPXE uses the same timeouts as
@@ -57,8 +57,10 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #undef	DOWNLOAD_PROTO_HTTPS	/* Secure Hypertext Transfer Protocol */
 #undef	DOWNLOAD_PROTO_FTP	/* File Transfer Protocol */
 #undef	DOWNLOAD_PROTO_SLAM	/* Scalable Local Area Multicast */
+#undef	DOWNLOAD_PROTO_IMGSHARE	/* Peer-to-peer image sharing */
 #undef	DOWNLOAD_PROTO_NFS	/* Network File System Protocol */
 //#undef DOWNLOAD_PROTO_FILE	/* Local filesystem access */
+#define	DOWNLOAD_GZIP		/* Extract gzip-compressed downloads */
 
 /*
  * SAN boot protocols
@@ -66,6 +68,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 
 //#undef	SANBOOT_PROTO_ISCSI	/* iSCSI protocol */
+//#undef	SANBOOT_PROTO_NVMETCP	/* NVMe/TCP protocol */
 //#undef	SANBOOT_PROTO_AOE	/* AoE protocol */
 //#undef	SANBOOT_PROTO_IB_SRP	/* Infiniband SCSI RDMA protocol */
 //#undef	SANBOOT_PROTO_FCP	/* Fibre Channel protocol */
@@ -78,6 +81,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define HTTP_AUTH_BASIC		/* Basic authentication */
 #define HTTP_AUTH_DIGEST	/* Digest authentication */
 //#define HTTP_AUTH_NTLM	/* NTLM authentication */
+//#define HTTP_ENC_GZIP	/* gzip content encoding */
+//#define HTTP_ENC_ZSTD	/* Zstandard content encoding */
 //#define HTTP_ENC_PEERDIST	/* PeerDist content encoding */
 //#define HTTP_HACK_GCE		/* Google Compute Engine hacks */
 
@@ -136,6 +141,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define LOGIN_CMD		/* Login command */
 #define SYNC_CMD		/* Sync command */
 #define SHELL_CMD		/* Shell command */
+#define TRACETIME_CMD		/* Boot trace command */
+#define PENDING_CMD		/* Pending operations command */
 //#define NSLOOKUP_CMD		/* DNS resolving command */
 //#define TIME_CMD		/* Time commands */
 //#define DIGEST_CMD		/* Image crypto digest commands */
@@ -152,8 +159,19 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 //#define CONSOLE_CMD		/* Console command */
 //#define IPSTAT_CMD		/* IP statistics commands */
 //#define PROFSTAT_CMD		/* Profiling commands */
+//#define BENCH_CMD		/* Benchmark commands */
 //#define NTP_CMD		/* NTP commands */
 //#define CERT_CMD		/* Certificate management commands */
+//#define IMGSERVE_CMD		/* Image serving command */
+//#define PCAP_CMD		/* Packet capture commands */
+//#define IMPAIR_CMD		/* Network impairment commands */
+//#define MEMSTAT_CMD		/* Memory statistics command */
+
+/*
+ * Profiling
+ *
+ */
+//#define PROFILING_SAMPLED	/* Sampled profiling in non-debug builds */
 
 /*
  * ROM-specific options
@@ -196,6 +214,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define	TIVOLI_VMM_WORKAROUND	/* Work around the Tivoli VMM's garbling of SSE
 				 * registers when iPXE traps to it due to
 				 * privileged instructions */
+//#define NETDEV_WAKE		/* Use interrupts to wake CPU while idle */
+//#define CPU_PERF		/* Assert maximum CPU performance state (x86) */
 
 #include <config/named.h>
 #include NAMED_CONFIG(general.h)
@@ -87,15 +87,28 @@ void acpi_fix_checksum ( struct acpi_header *acpi ) {
  * @ret table		Table, or UNULL if not found
  */
 userptr_t acpi_find ( uint32_t signature, unsigned int index ) {
+	static uint32_t cached_signature;
+	static unsigned int cached_index;
+	static userptr_t cached_table;
 	struct acpi_header acpi;
 	struct acpi_rsdt *rsdtab;
 	typeof ( rsdtab->entry[0] ) entry;
+	unsigned int orig_index = index;
 	userptr_t rsdt;
 	userptr_t table;
 	size_t len;
 	unsigned int count;
 	unsigned int i;
 
+	/* Return cached result, if available.  Repeated lookups of
+	 * the same table (e.g. via the ACPI settings mechanism) are
+	 * common, and firmware tables will not move.
+	 */
+	if ( cached_table && ( cached_signature == signature ) &&
+	     ( cached_index == index ) ) {
+		return cached_table;
+	}
+
 	/* Locate RSDT */
 	rsdt = acpi_find_rsdt();
 	if ( ! rsdt ) {
@@ -157,6 +170,12 @@ userptr_t acpi_find ( uint32_t signature, unsigned int index ) {
 		DBGC ( rsdt, "RSDT %#08lx found %s at %08lx\n",
 		       user_to_phys ( rsdt, 0 ), acpi_name ( signature ),
 		       user_to_phys ( table, 0 ) );
+
+		/* Cache result */
+		cached_signature = signature;
+		cached_index = orig_index;
+		cached_table = table;
+
 		return table;
 	}
 
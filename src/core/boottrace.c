@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2015 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <ipxe/timer.h>
+#include <ipxe/settings.h>
+#include <ipxe/boottrace.h>
+
+/** @file
+ *
+ * Boot-time trace markers
+ *
+ * Timestamped markers are recorded for the interesting phases of a
+ * boot (device probing, DHCP, downloads, TLS negotiation, image
+ * execution) into a fixed-size ring.  Recording a marker is cheap
+ * enough to leave enabled in production builds, allowing boot time
+ * regressions to be diagnosed without a debug build.
+ */
+
+/** Runtime trace level
+ *
+ * Level 1 enables connection-level trace points (TCP state
+ * transitions, TLS alerts); level 2 additionally enables driver ring
+ * error trace points.  The default level of zero disables all
+ * runtime-gated trace points.
+ */
+unsigned int trace_level;
+
+/** Trace level setting */
+const struct setting debuglevel_setting __setting ( SETTING_MISC,
+						    debuglevel ) = {
+	.name = "debuglevel",
+	.description = "Trace level",
+	.type = &setting_type_uint8,
+};
+
+/**
+ * Apply trace level setting
+ *
+ * @ret rc		Return status code
+ */
+static int trace_level_apply ( void ) {
+	unsigned long level;
+
+	if ( fetch_uint_setting ( NULL, &debuglevel_setting, &level ) < 0 )
+		level = 0;
+	trace_level = level;
+	return 0;
+}
+
+/** Trace level settings applicator */
+struct settings_applicator trace_level_applicator __settings_applicator = {
+	.apply = trace_level_apply,
+};
+
+/** Boot trace entry ring */
+static struct boottrace_entry boottrace_entries[BOOTTRACE_COUNT];
+
+/** Total number of markers recorded */
+static unsigned int boottrace_total;
+
+/**
+ * Record boot trace marker
+ *
+ * @v fmt		Format string
+ * @v ...		Arguments
+ */
+void boottrace ( const char *fmt, ... ) {
+	struct boottrace_entry *entry;
+	va_list args;
+
+	/* Record marker in next ring entry */
+	entry = &boottrace_entries[ boottrace_total++ % BOOTTRACE_COUNT ];
+	entry->ticks = currticks();
+	va_start ( args, fmt );
+	vsnprintf ( entry->label, sizeof ( entry->label ), fmt, args );
+	va_end ( args );
+
+	DBG2 ( "BOOTTRACE %s\n", entry->label );
+}
+
+/**
+ * Print all recorded boot trace markers
+ *
+ * Output is sent via the standard console mechanism, and so will
+ * reach any enabled syslog console as well as the local display.
+ */
+void boottrace_show ( void ) {
+	struct boottrace_entry *entry;
+	unsigned long previous = 0;
+	unsigned long delta;
+	unsigned long ms;
+	unsigned int first = 0;
+	unsigned int i;
+
+	/* Skip markers overwritten by ring wraparound */
+	if ( boottrace_total > BOOTTRACE_COUNT ) {
+		first = ( boottrace_total - BOOTTRACE_COUNT );
+		printf ( "(%d markers overwritten)\n", first );
+	}
+
+	/* Print each marker with absolute and delta timestamps */
+	for ( i = first ; i < boottrace_total ; i++ ) {
+		entry = &boottrace_entries[ i % BOOTTRACE_COUNT ];
+		ms = ( ( entry->ticks * 1000 ) / TICKS_PER_SEC );
+		delta = ( ( i > first ) ? ( ms - previous ) : 0 );
+		printf ( "%4ld.%03lds +%ld.%03lds %s\n",
+			 ( ms / 1000 ), ( ms % 1000 ),
+			 ( delta / 1000 ), ( delta % 1000 ), entry->label );
+		previous = ms;
+	}
+}
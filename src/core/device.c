@@ -28,6 +28,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/tables.h>
 #include <ipxe/init.h>
 #include <ipxe/interface.h>
+#include <ipxe/boottrace.h>
 #include <ipxe/device.h>
 
 /**
@@ -53,6 +54,7 @@ static int rootdev_probe ( struct root_device *rootdev ) {
 	int rc;
 
 	DBG ( "Adding %s root bus\n", rootdev->dev.name );
+	boottrace ( "probe %s", rootdev->dev.name );
 	if ( ( rc = rootdev->driver->probe ( rootdev ) ) != 0 ) {
 		DBG ( "Failed to add %s root bus: %s\n",
 		      rootdev->dev.name, strerror ( rc ) );
@@ -89,6 +91,7 @@ static void probe_devices ( void ) {
 		if ( ( rc = rootdev_probe ( rootdev ) ) != 0 )
 			list_del ( &rootdev->dev.siblings );
 	}
+	boottrace ( "probe complete" );
 }
 
 /**
@@ -24,17 +24,24 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
+#include <assert.h>
 #include <syslog.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/xfer.h>
 #include <ipxe/open.h>
 #include <ipxe/job.h>
+#include <ipxe/watchdog.h>
 #include <ipxe/uaccess.h>
 #include <ipxe/umalloc.h>
 #include <ipxe/image.h>
+#include <ipxe/crypto.h>
+#include <ipxe/asn1.h>
+#include <ipxe/deflate.h>
 #include <ipxe/xferbuf.h>
 #include <ipxe/downloader.h>
+#include <config/general.h>
 
 /** @file
  *
@@ -42,6 +49,73 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/** Maximum number of digests to calculate while downloading */
+#define DOWNLOADER_DIGESTS 8
+
+/** Gzip extraction is enabled */
+#ifdef DOWNLOAD_GZIP
+#define DOWNLOADER_GZIP 1
+#else
+#define DOWNLOADER_GZIP 0
+#endif
+
+/** Length of the fixed portion of a gzip member header */
+#define GZIP_HEADER_LEN 10
+
+/** Offset of the flags byte within a gzip member header */
+#define GZIP_HEADER_FLG 3
+
+/** Gzip magic bytes and deflate compression method */
+#define GZIP_MAGIC0 0x1f
+#define GZIP_MAGIC1 0x8b
+#define GZIP_CM_DEFLATE 0x08
+
+/** Gzip header flags */
+#define GZIP_FL_HCRC	0x02	/**< Header CRC is present */
+#define GZIP_FL_EXTRA	0x04	/**< Extra field is present */
+#define GZIP_FL_NAME	0x08	/**< Original file name is present */
+#define GZIP_FL_COMMENT	0x10	/**< Comment is present */
+
+/** Gzip extraction state */
+enum downloader_gzip_state {
+	/** Parsing fixed portion of member header */
+	DOWNLOADER_GZIP_HEADER = 0,
+	/** Parsing extra field length */
+	DOWNLOADER_GZIP_EXTRA_LEN,
+	/** Skipping extra field */
+	DOWNLOADER_GZIP_EXTRA,
+	/** Skipping original file name */
+	DOWNLOADER_GZIP_NAME,
+	/** Skipping comment */
+	DOWNLOADER_GZIP_COMMENT,
+	/** Skipping header CRC */
+	DOWNLOADER_GZIP_HCRC,
+	/** Inflating compressed data */
+	DOWNLOADER_GZIP_DATA,
+	/** Skipping trailer */
+	DOWNLOADER_GZIP_TRAILER,
+};
+
+/** A gzip extraction context */
+struct downloader_gzip {
+	/** Current state */
+	enum downloader_gzip_state state;
+	/** Remaining length of current header field */
+	size_t remaining;
+	/** Header flags */
+	uint8_t flags;
+	/** Extra field length */
+	uint16_t extra;
+	/** Length of compressed data consumed so far */
+	size_t in_len;
+	/** Length of decompressed data produced so far */
+	size_t len;
+	/** Decompressor */
+	struct deflate deflate;
+	/** Saved decompressor state (used for output sizing passes) */
+	struct deflate saved;
+};
+
 /** A downloader */
 struct downloader {
 	/** Reference count for this object */
@@ -56,6 +130,18 @@ struct downloader {
 	struct image *image;
 	/** Data transfer buffer */
 	struct xfer_buffer buffer;
+
+	/** Digest algorithms */
+	struct digest_algorithm *digest[DOWNLOADER_DIGESTS];
+	/** Digest contexts (if digests are being calculated) */
+	uint8_t *ctx;
+	/** Length of contiguously digested data */
+	size_t digested;
+
+	/** Gzip extraction context (if stream is gzip-compressed) */
+	struct downloader_gzip *gzip;
+	/** Stream content has been probed for gzip compression */
+	int probed;
 };
 
 /**
@@ -68,9 +154,193 @@ static void downloader_free ( struct refcnt *refcnt ) {
 		container_of ( refcnt, struct downloader, refcnt );
 
 	image_put ( downloader->image );
+	free ( downloader->ctx );
+	free ( downloader->gzip );
 	free ( downloader );
 }
 
+/****************************************************************************
+ *
+ * Progressive digest calculation
+ *
+ */
+
+/**
+ * Restart digest calculation
+ *
+ * @v downloader	Downloader
+ */
+static void downloader_digests_reset ( struct downloader *downloader ) {
+	size_t offset = 0;
+	unsigned int i;
+
+	/* Do nothing if digests are not being calculated */
+	if ( ! downloader->ctx )
+		return;
+
+	/* (Re)initialise digest contexts */
+	for ( i = 0 ; ( i < DOWNLOADER_DIGESTS ) &&
+		      downloader->digest[i] ; i++ ) {
+		digest_init ( downloader->digest[i],
+			      &downloader->ctx[offset] );
+		offset += downloader->digest[i]->ctxsize;
+	}
+	downloader->digested = 0;
+}
+
+/**
+ * Start digest calculation
+ *
+ * @v downloader	Downloader
+ *
+ * Calculate digests of the downloaded data as it arrives, so that
+ * subsequent image verification does not require an additional pass
+ * over the (potentially very large) downloaded file.  We do this only
+ * when a trust requirement is in force, since the calculation would
+ * otherwise usually be wasted effort.  This is a policy decision.
+ */
+static void downloader_digests_init ( struct downloader *downloader ) {
+	struct asn1_algorithm *algorithm;
+	struct digest_algorithm *digest;
+	size_t ctxsize = 0;
+	unsigned int count = 0;
+	unsigned int i;
+
+	/* Do nothing unless a trust requirement is in force */
+	if ( ! image_trust_required() )
+		return;
+
+	/* Identify all digest algorithms usable for verification */
+	for_each_table_entry ( algorithm, ASN1_ALGORITHMS ) {
+		digest = algorithm->digest;
+		if ( ! digest )
+			continue;
+		for ( i = 0 ; i < count ; i++ ) {
+			if ( downloader->digest[i] == digest )
+				break;
+		}
+		if ( i < count )
+			continue;
+		if ( count == DOWNLOADER_DIGESTS )
+			return;
+		downloader->digest[count++] = digest;
+		ctxsize += digest->ctxsize;
+	}
+	if ( ! count )
+		return;
+
+	/* Allocate and initialise digest contexts.  Failure here is
+	 * harmless: verification will simply fall back to digesting
+	 * the completed download.
+	 */
+	downloader->ctx = malloc ( ctxsize );
+	downloader_digests_reset ( downloader );
+}
+
+/**
+ * Abandon digest calculation
+ *
+ * @v downloader	Downloader
+ */
+static void downloader_digests_abandon ( struct downloader *downloader ) {
+
+	free ( downloader->ctx );
+	downloader->ctx = NULL;
+}
+
+/**
+ * Add data to digests
+ *
+ * @v downloader	Downloader
+ * @v data		Data
+ * @v len		Length of data
+ */
+static void downloader_digests_add ( struct downloader *downloader,
+				     const void *data, size_t len ) {
+	size_t offset = 0;
+	unsigned int i;
+
+	/* Do nothing if digests are not being calculated */
+	if ( ! downloader->ctx )
+		return;
+
+	/* Update digests */
+	for ( i = 0 ; ( i < DOWNLOADER_DIGESTS ) &&
+		      downloader->digest[i] ; i++ ) {
+		digest_update ( downloader->digest[i],
+				&downloader->ctx[offset], data, len );
+		offset += downloader->digest[i]->ctxsize;
+	}
+	downloader->digested += len;
+}
+
+/**
+ * Update digests with newly downloaded data
+ *
+ * @v downloader	Downloader
+ * @v iobuf		Datagram I/O buffer
+ * @v meta		Data transfer metadata
+ */
+static void downloader_digests_update ( struct downloader *downloader,
+					struct io_buffer *iobuf,
+					struct xfer_metadata *meta ) {
+	size_t pos;
+
+	/* Do nothing if digests are not being calculated */
+	if ( ! downloader->ctx )
+		return;
+
+	/* Calculate delivery position (as per xferbuf_deliver()) */
+	pos = downloader->buffer.pos;
+	if ( meta->flags & XFER_FL_ABS_OFFSET )
+		pos = 0;
+	pos += meta->offset;
+
+	/* Abandon digest calculation if data arrives out of order
+	 * (e.g. via a multicast protocol).
+	 */
+	if ( pos != downloader->digested ) {
+		downloader_digests_abandon ( downloader );
+		return;
+	}
+
+	/* Update digests */
+	downloader_digests_add ( downloader, iobuf->data, iob_len ( iobuf ) );
+}
+
+/**
+ * Finalise digests and attach to image
+ *
+ * @v downloader	Downloader
+ */
+static void downloader_digests_final ( struct downloader *downloader ) {
+	struct digest_algorithm *digest;
+	uint8_t out[IMAGE_DIGEST_MAX_SIZE];
+	size_t offset = 0;
+	unsigned int i;
+
+	/* Do nothing if digests are not being calculated */
+	if ( ! downloader->ctx )
+		return;
+
+	/* Do nothing unless the complete file was digested */
+	if ( downloader->digested != downloader->buffer.len )
+		return;
+
+	/* Finalise digests and cache within image */
+	for ( i = 0 ; ( i < DOWNLOADER_DIGESTS ) &&
+		      downloader->digest[i] ; i++ ) {
+		digest = downloader->digest[i];
+		assert ( digest->digestsize <= sizeof ( out ) );
+		digest_final ( digest, &downloader->ctx[offset], out );
+		image_set_digest ( downloader->image, digest, out );
+		offset += digest->ctxsize;
+	}
+
+	/* Prevent any further updates */
+	downloader_digests_abandon ( downloader );
+}
+
 /**
  * Terminate download
  *
@@ -79,6 +349,14 @@ static void downloader_free ( struct refcnt *refcnt ) {
  */
 static void downloader_finished ( struct downloader *downloader, int rc ) {
 
+	/* Fail if a gzip-compressed stream was truncated */
+	if ( ( rc == 0 ) && downloader->gzip &&
+	     ( downloader->gzip->state != DOWNLOADER_GZIP_TRAILER ) ) {
+		DBGC ( downloader, "DOWNLOADER %p gzip stream truncated\n",
+		       downloader );
+		rc = -EINVAL;
+	}
+
 	/* Log download status */
 	if ( rc == 0 ) {
 		syslog ( LOG_NOTICE, "Downloaded \"%s\"\n",
@@ -88,20 +366,309 @@ static void downloader_finished ( struct downloader *downloader, int rc ) {
 			 downloader->image->name, strerror ( rc ) );
 	}
 
-	/* Update image length */
+	/* Trim buffer allocation and update image length */
+	xferbuf_trim ( &downloader->buffer );
 	downloader->image->len = downloader->buffer.len;
 
+	/* Record digests of downloaded data, if successful */
+	if ( rc == 0 )
+		downloader_digests_final ( downloader );
+
 	/* Shut down interfaces */
 	intf_shutdown ( &downloader->xfer, rc );
 	intf_shutdown ( &downloader->job, rc );
 }
 
+/****************************************************************************
+ *
+ * Streaming gzip extraction
+ *
+ * Compressed downloads are extracted as the data arrives, so that
+ * only the decompressed artifact is ever stored: holding both copies
+ * resident would otherwise double the peak memory requirement.
+ *
+ */
+
+/**
+ * Probe start of stream for gzip compression
+ *
+ * @v downloader	Downloader
+ * @v iobuf		First datagram I/O buffer
+ */
+static void downloader_gzip_probe ( struct downloader *downloader,
+				    struct io_buffer *iobuf ) {
+	const uint8_t *data = iobuf->data;
+	struct downloader_gzip *gzip;
+
+	/* Probe only the first delivered data */
+	if ( downloader->probed )
+		return;
+	downloader->probed = 1;
+
+	/* Do nothing unless gzip extraction is enabled */
+	if ( ! DOWNLOADER_GZIP )
+		return;
+
+	/* Do nothing unless the stream starts with a gzip member
+	 * header using the deflate compression method
+	 */
+	if ( ( iob_len ( iobuf ) < GZIP_HEADER_LEN ) ||
+	     ( data[0] != GZIP_MAGIC0 ) || ( data[1] != GZIP_MAGIC1 ) ||
+	     ( data[2] != GZIP_CM_DEFLATE ) ) {
+		return;
+	}
+
+	/* Allocate extraction context.  Failure is harmless: the
+	 * stream will simply be stored without extraction.
+	 */
+	gzip = zalloc ( sizeof ( *gzip ) );
+	if ( ! gzip )
+		return;
+	gzip->state = DOWNLOADER_GZIP_HEADER;
+	gzip->remaining = GZIP_HEADER_LEN;
+	downloader->gzip = gzip;
+	DBGC ( downloader, "DOWNLOADER %p extracting gzip stream\n",
+	       downloader );
+}
+
+/**
+ * Move to next gzip member header field
+ *
+ * @v gzip		Gzip extraction context
+ */
+static void downloader_gzip_next ( struct downloader_gzip *gzip ) {
+
+	if ( gzip->flags & GZIP_FL_EXTRA ) {
+		gzip->flags &= ~GZIP_FL_EXTRA;
+		gzip->state = DOWNLOADER_GZIP_EXTRA_LEN;
+		gzip->remaining = sizeof ( gzip->extra );
+	} else if ( gzip->flags & GZIP_FL_NAME ) {
+		gzip->flags &= ~GZIP_FL_NAME;
+		gzip->state = DOWNLOADER_GZIP_NAME;
+	} else if ( gzip->flags & GZIP_FL_COMMENT ) {
+		gzip->flags &= ~GZIP_FL_COMMENT;
+		gzip->state = DOWNLOADER_GZIP_COMMENT;
+	} else if ( gzip->flags & GZIP_FL_HCRC ) {
+		gzip->flags &= ~GZIP_FL_HCRC;
+		gzip->state = DOWNLOADER_GZIP_HCRC;
+		gzip->remaining = 2;
+	} else {
+		gzip->state = DOWNLOADER_GZIP_DATA;
+		deflate_init ( &gzip->deflate, DEFLATE_RAW );
+	}
+}
+
+/**
+ * Process one byte of gzip member header
+ *
+ * @v gzip		Gzip extraction context
+ * @v byte		Header byte
+ */
+static void downloader_gzip_byte ( struct downloader_gzip *gzip,
+				   uint8_t byte ) {
+
+	switch ( gzip->state ) {
+	case DOWNLOADER_GZIP_HEADER:
+		if ( gzip->remaining == ( GZIP_HEADER_LEN - GZIP_HEADER_FLG ) )
+			gzip->flags = byte;
+		if ( --gzip->remaining == 0 )
+			downloader_gzip_next ( gzip );
+		break;
+	case DOWNLOADER_GZIP_EXTRA_LEN:
+		/* Extra field length is little-endian */
+		gzip->extra = ( ( gzip->extra >> 8 ) | ( byte << 8 ) );
+		if ( --gzip->remaining == 0 ) {
+			if ( gzip->extra ) {
+				gzip->state = DOWNLOADER_GZIP_EXTRA;
+				gzip->remaining = gzip->extra;
+			} else {
+				downloader_gzip_next ( gzip );
+			}
+		}
+		break;
+	case DOWNLOADER_GZIP_EXTRA:
+	case DOWNLOADER_GZIP_HCRC:
+		if ( --gzip->remaining == 0 )
+			downloader_gzip_next ( gzip );
+		break;
+	case DOWNLOADER_GZIP_NAME:
+	case DOWNLOADER_GZIP_COMMENT:
+		if ( byte == 0 )
+			downloader_gzip_next ( gzip );
+		break;
+	default:
+		assert ( 0 );
+		break;
+	}
+}
+
+/**
+ * Inflate a chunk of compressed data
+ *
+ * @v downloader	Downloader
+ * @v data		Compressed data
+ * @v len		Length of compressed data
+ * @v consumed		Length of compressed data consumed to fill in
+ * @ret rc		Return status code
+ */
+static int downloader_gzip_inflate ( struct downloader *downloader,
+				     const void *data, size_t len,
+				     size_t *consumed ) {
+	struct downloader_gzip *gzip = downloader->gzip;
+	struct image *image = downloader->image;
+	struct deflate_chunk in;
+	struct deflate_chunk out;
+	size_t new_len;
+	int rc;
+
+	/* Measure the decompressed length using a throwaway copy of
+	 * the decompressor state, since the output buffer cannot be
+	 * grown in the middle of an inflation call.
+	 */
+	memcpy ( &gzip->saved, &gzip->deflate, sizeof ( gzip->saved ) );
+	deflate_chunk_init ( &in, virt_to_user ( data ), 0, len );
+	deflate_chunk_init ( &out, image->data, gzip->len, gzip->len );
+	if ( ( rc = deflate_inflate ( &gzip->deflate, &in, &out ) ) != 0 ) {
+		DBGC ( downloader, "DOWNLOADER %p could not inflate: %s\n",
+		       downloader, strerror ( rc ) );
+		return rc;
+	}
+	new_len = out.offset;
+
+	/* Grow output buffer to fit the decompressed data */
+	if ( ( rc = xferbuf_ensure_size ( &downloader->buffer,
+					  new_len ) ) != 0 )
+		return rc;
+
+	/* Restore decompressor state and inflate for real */
+	memcpy ( &gzip->deflate, &gzip->saved, sizeof ( gzip->deflate ) );
+	deflate_chunk_init ( &in, virt_to_user ( data ), 0, len );
+	deflate_chunk_init ( &out, image->data, gzip->len, new_len );
+	if ( ( rc = deflate_inflate ( &gzip->deflate, &in, &out ) ) != 0 )
+		return rc;
+	assert ( out.offset == new_len );
+
+	/* Update digests with the decompressed data, which is what
+	 * any trust check will be verifying.
+	 */
+	downloader_digests_add ( downloader,
+				 user_to_virt ( image->data, gzip->len ),
+				 ( new_len - gzip->len ) );
+
+	/* Update produced length and delivery position */
+	gzip->len = new_len;
+	downloader->buffer.pos = new_len;
+
+	/* Discard the trailer (and any further members) once the
+	 * compressed stream is complete.  Integrity of the
+	 * decompressed data is covered by image verification (and by
+	 * the transport layer), so the trailer CRC adds nothing.
+	 */
+	if ( deflate_finished ( &gzip->deflate ) ) {
+		DBGC ( downloader, "DOWNLOADER %p extracted %zd bytes\n",
+		       downloader, gzip->len );
+		gzip->state = DOWNLOADER_GZIP_TRAILER;
+	}
+
+	*consumed = in.offset;
+	return 0;
+}
+
+/**
+ * Extract newly downloaded gzip-compressed data
+ *
+ * @v downloader	Downloader
+ * @v iobuf		Datagram I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int downloader_gzip_deliver ( struct downloader *downloader,
+				     struct io_buffer *iobuf,
+				     struct xfer_metadata *meta ) {
+	struct downloader_gzip *gzip = downloader->gzip;
+	const uint8_t *data = iobuf->data;
+	size_t remaining = iob_len ( iobuf );
+	size_t consumed;
+	size_t pos;
+	int rc;
+
+	/* Calculate delivery position (as per xferbuf_deliver()) */
+	pos = gzip->in_len;
+	if ( meta->flags & XFER_FL_ABS_OFFSET )
+		pos = 0;
+	pos += meta->offset;
+
+	/* Fail if data arrives out of order: the compressed stream
+	 * is discarded as it is consumed, and so cannot be revisited.
+	 */
+	if ( pos != gzip->in_len ) {
+		DBGC ( downloader, "DOWNLOADER %p cannot extract out-of-order "
+		       "data (expected %zd, got %zd)\n", downloader,
+		       gzip->in_len, pos );
+		rc = -EPROTO;
+		goto err;
+	}
+
+	/* Process data */
+	while ( remaining ) {
+		if ( gzip->state == DOWNLOADER_GZIP_DATA ) {
+			if ( ( rc = downloader_gzip_inflate ( downloader, data,
+							      remaining,
+							      &consumed ) ) !=0)
+				goto err;
+		} else if ( gzip->state == DOWNLOADER_GZIP_TRAILER ) {
+			consumed = remaining;
+		} else {
+			downloader_gzip_byte ( gzip, *data );
+			consumed = 1;
+		}
+		data += consumed;
+		remaining -= consumed;
+		gzip->in_len += consumed;
+	}
+
+	free_iob ( iobuf );
+	return 0;
+
+ err:
+	free_iob ( iobuf );
+	downloader_finished ( downloader, rc );
+	return rc;
+}
+
+/**
+ * Reset gzip extraction (e.g. after a redirection)
+ *
+ * @v downloader	Downloader
+ */
+static void downloader_gzip_reset ( struct downloader *downloader ) {
+
+	/* Discard any partially extracted data */
+	if ( downloader->gzip ) {
+		downloader->buffer.len = 0;
+		downloader->buffer.pos = 0;
+	}
+
+	/* Free extraction context and allow the stream to be reprobed */
+	free ( downloader->gzip );
+	downloader->gzip = NULL;
+	downloader->probed = 0;
+}
+
 /****************************************************************************
  *
  * Job control interface
  *
  */
 
+/**
+ * Refresh platform watchdog
+ *
+ * This is a weak definition, overridden on platforms that maintain a
+ * watchdog timer.
+ */
+__weak void watchdog_refresh ( void ) {}
+
 /**
  * Report progress of download job
  *
@@ -148,6 +715,24 @@ static int downloader_deliver ( struct downloader *downloader,
 				struct xfer_metadata *meta ) {
 	int rc;
 
+	/* Hold off any platform watchdog: received data is proof of
+	 * forward progress.  (Rate limiting is applied by the
+	 * platform implementation.)
+	 */
+	watchdog_refresh();
+
+	/* Probe start of stream for gzip compression */
+	downloader_gzip_probe ( downloader, iobuf );
+
+	/* Extract gzip-compressed streams instead of storing them */
+	if ( downloader->gzip ) {
+		return downloader_gzip_deliver ( downloader,
+						 iob_disown ( iobuf ), meta );
+	}
+
+	/* Update digests before buffer consumes the I/O buffer */
+	downloader_digests_update ( downloader, iobuf, meta );
+
 	/* Add data to buffer */
 	if ( ( rc = xferbuf_deliver ( &downloader->buffer, iob_disown ( iobuf ),
 				      meta ) ) != 0 )
@@ -200,6 +785,12 @@ static int downloader_vredirect ( struct downloader *downloader, int type,
 			goto err;
 	}
 
+	/* Restart digest calculation */
+	downloader_digests_reset ( downloader );
+
+	/* Restart gzip extraction */
+	downloader_gzip_reset ( downloader );
+
 	/* Redirect to new location */
 	if ( ( rc = xfer_vreopen ( &downloader->xfer, type, args ) ) != 0 )
 		goto err;
@@ -270,6 +861,7 @@ int create_downloader ( struct interface *job, struct image *image ) {
 		    &downloader->refcnt );
 	downloader->image = image_get ( image );
 	xferbuf_umalloc_init ( &downloader->buffer, &image->data );
+	downloader_digests_init ( downloader );
 
 	/* Instantiate child objects and attach to our interfaces */
 	if ( ( rc = xfer_open_uri ( &downloader->xfer, image->uri ) ) != 0 )
@@ -128,6 +128,75 @@ static void fbcon_clear ( struct fbcon *fbcon, unsigned int ypos ) {
 	}
 }
 
+/**
+ * Mark region of shadow frame buffer as dirty
+ *
+ * @v fbcon		Frame buffer console
+ * @v left		Left edge (in bytes within a scanline)
+ * @v right		Right edge (in bytes within a scanline)
+ * @v top		Top edge (in pixel rows)
+ * @v bottom		Bottom edge (in pixel rows)
+ */
+static void fbcon_dirty ( struct fbcon *fbcon, size_t left, size_t right,
+			  unsigned int top, unsigned int bottom ) {
+	struct fbcon_dirty *dirty = &fbcon->dirty;
+
+	/* Expand dirty region to cover specified rectangle */
+	if ( left < dirty->left )
+		dirty->left = left;
+	if ( right > dirty->right )
+		dirty->right = right;
+	if ( top < dirty->top )
+		dirty->top = top;
+	if ( bottom > dirty->bottom )
+		dirty->bottom = bottom;
+}
+
+/**
+ * Copy dirty region of shadow frame buffer to frame buffer
+ *
+ * @v fbcon		Frame buffer console
+ *
+ * Drawing operations accumulate into the shadow frame buffer (in
+ * normal cacheable memory) and are copied to the real frame buffer
+ * (which may be in uncacheable memory) as a single batched blit of
+ * the dirty rectangle.
+ */
+static void fbcon_blit ( struct fbcon *fbcon ) {
+	struct fbcon_dirty *dirty = &fbcon->dirty;
+	size_t stride = fbcon->pixel->stride;
+	size_t offset;
+	size_t len;
+	unsigned int y;
+
+	/* Do nothing if dirty region is empty */
+	if ( dirty->bottom <= dirty->top )
+		return;
+
+	/* Copy dirty rectangle to frame buffer.  A full-width
+	 * rectangle is contiguous and can be copied in one go;
+	 * otherwise copy one scanline at a time.
+	 */
+	len = ( dirty->right - dirty->left );
+	offset = ( ( dirty->top * stride ) + dirty->left );
+	if ( len == stride ) {
+		memcpy_user ( fbcon->start, offset, fbcon->shadow, offset,
+			      ( ( dirty->bottom - dirty->top ) * stride ) );
+	} else {
+		for ( y = dirty->top ; y < dirty->bottom ; y++ ) {
+			memcpy_user ( fbcon->start, offset, fbcon->shadow,
+				      offset, len );
+			offset += stride;
+		}
+	}
+
+	/* Mark dirty region as empty */
+	dirty->left = stride;
+	dirty->right = 0;
+	dirty->top = fbcon->pixel->height;
+	dirty->bottom = 0;
+}
+
 /**
  * Store character at specified position
  *
@@ -165,6 +234,8 @@ static void fbcon_draw ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
 	uint8_t bitmask;
 	int transparent;
 	void *src;
+	size_t left;
+	unsigned int top;
 
 	/* Get font character */
 	fbcon->font->glyph ( cell->character, glyph );
@@ -176,6 +247,13 @@ static void fbcon_draw ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
 	pixel_len = fbcon->pixel->len;
 	skip_len = ( fbcon->pixel->stride - fbcon->character.len );
 
+	/* Mark character cell as dirty */
+	left = ( ( fbcon->margin.left * pixel_len ) +
+		 ( xpos * fbcon->character.len ) );
+	top = ( fbcon->margin.top + ( ypos * fbcon->font->height ) );
+	fbcon_dirty ( fbcon, left, ( left + fbcon->character.len ),
+		      top, ( top + fbcon->font->height ) );
+
 	/* Check for transparent background colour */
 	transparent = ( cell->background == FBCON_TRANSPARENT );
 
@@ -185,11 +263,11 @@ static void fbcon_draw ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
 		/* Draw background picture, if applicable */
 		if ( transparent ) {
 			if ( fbcon->picture.start ) {
-				memcpy_user ( fbcon->start, offset,
+				memcpy_user ( fbcon->shadow, offset,
 					      fbcon->picture.start, offset,
 					      fbcon->character.len );
 			} else {
-				memset_user ( fbcon->start, offset, 0,
+				memset_user ( fbcon->shadow, offset, 0,
 					      fbcon->character.len );
 			}
 		}
@@ -204,7 +282,7 @@ static void fbcon_draw ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
 			} else {
 				continue;
 			}
-			copy_to_user ( fbcon->start, offset, src, pixel_len );
+			copy_to_user ( fbcon->shadow, offset, src, pixel_len );
 		}
 
 		/* Move to next row */
@@ -213,18 +291,19 @@ static void fbcon_draw ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
 }
 
 /**
- * Redraw all characters
+ * Redraw rows of characters
  *
  * @v fbcon		Frame buffer console
+ * @v ypos		Starting Y position
  */
-static void fbcon_redraw ( struct fbcon *fbcon ) {
+static void fbcon_redraw ( struct fbcon *fbcon, unsigned int ypos ) {
 	struct fbcon_text_cell cell;
-	size_t offset = 0;
+	size_t offset;
 	unsigned int xpos;
-	unsigned int ypos;
 
 	/* Redraw characters */
-	for ( ypos = 0 ; ypos < fbcon->character.height ; ypos++ ) {
+	offset = ( ypos * fbcon->character.width * sizeof ( cell ) );
+	for ( ; ypos < fbcon->character.height ; ypos++ ) {
 		for ( xpos = 0 ; xpos < fbcon->character.width ; xpos++ ) {
 			copy_from_user ( &cell, fbcon->text.start, offset,
 					 sizeof ( cell ) );
@@ -241,6 +320,8 @@ static void fbcon_redraw ( struct fbcon *fbcon ) {
  */
 static void fbcon_scroll ( struct fbcon *fbcon ) {
 	size_t row_len;
+	size_t left;
+	size_t offset;
 
 	/* Sanity check */
 	assert ( fbcon->ypos == fbcon->character.height );
@@ -254,8 +335,31 @@ static void fbcon_scroll ( struct fbcon *fbcon ) {
 	/* Update cursor position */
 	fbcon->ypos--;
 
-	/* Redraw all characters */
-	fbcon_redraw ( fbcon );
+	/* Redraw characters.  With a background picture, every
+	 * character cell must be redrawn since the picture must not
+	 * scroll along with the text.  Without a picture, the
+	 * character area's pixel rows can simply be shifted up within
+	 * the shadow frame buffer, leaving only the newly cleared
+	 * bottom row to be redrawn.
+	 */
+	if ( fbcon->picture.start ) {
+		fbcon_redraw ( fbcon, 0 );
+	} else {
+		offset = ( fbcon->margin.top * fbcon->pixel->stride );
+		memmove_user ( fbcon->shadow, offset, fbcon->shadow,
+			       ( offset + fbcon->character.stride ),
+			       ( ( fbcon->character.height - 1 ) *
+				 fbcon->character.stride ) );
+		left = ( fbcon->margin.left * fbcon->pixel->len );
+		fbcon_dirty ( fbcon, left,
+			      ( left + ( fbcon->character.width *
+					 fbcon->character.len ) ),
+			      fbcon->margin.top,
+			      ( fbcon->margin.top +
+				( fbcon->character.height *
+				  fbcon->font->height ) ) );
+		fbcon_redraw ( fbcon, ( fbcon->character.height - 1 ) );
+	}
 }
 
 /**
@@ -322,7 +426,7 @@ static void fbcon_handle_ed ( struct ansiesc_context *ctx,
 	fbcon_clear ( fbcon, 0 );
 
 	/* Redraw all characters */
-	fbcon_redraw ( fbcon );
+	fbcon_redraw ( fbcon, 0 );
 
 	/* Reset cursor position */
 	fbcon->xpos = 0;
@@ -489,6 +593,9 @@ void fbcon_putchar ( struct fbcon *fbcon, int character ) {
 
 	/* Show cursor */
 	fbcon_draw_cursor ( fbcon, fbcon->show_cursor );
+
+	/* Copy accumulated changes to frame buffer */
+	fbcon_blit ( fbcon );
 }
 
 /**
@@ -668,6 +775,15 @@ int fbcon_init ( struct fbcon *fbcon, userptr_t start,
 	fbcon_set_default_foreground ( fbcon );
 	fbcon_set_default_background ( fbcon );
 
+	/* Allocate and initialise shadow frame buffer */
+	fbcon->shadow = umalloc ( fbcon->len );
+	if ( ! fbcon->shadow ) {
+		rc = -ENOMEM;
+		goto err_shadow;
+	}
+	fbcon->dirty.left = pixel->stride;
+	fbcon->dirty.top = pixel->height;
+
 	/* Allocate and initialise stored character array */
 	fbcon->text.start = umalloc ( fbcon->character.width *
 				      fbcon->character.height *
@@ -678,8 +794,8 @@ int fbcon_init ( struct fbcon *fbcon, userptr_t start,
 	}
 	fbcon_clear ( fbcon, 0 );
 
-	/* Set framebuffer to all black (including margins) */
-	memset_user ( fbcon->start, 0, 0, fbcon->len );
+	/* Set shadow frame buffer to all black (including margins) */
+	memset_user ( fbcon->shadow, 0, 0, fbcon->len );
 
 	/* Generate pixel buffer from background image, if applicable */
 	if ( config->pixbuf &&
@@ -688,10 +804,14 @@ int fbcon_init ( struct fbcon *fbcon, userptr_t start,
 
 	/* Draw background picture (including margins), if applicable */
 	if ( fbcon->picture.start ) {
-		memcpy_user ( fbcon->start, 0, fbcon->picture.start, 0,
+		memcpy_user ( fbcon->shadow, 0, fbcon->picture.start, 0,
 			      fbcon->len );
 	}
 
+	/* Copy initial screen contents to frame buffer */
+	fbcon_dirty ( fbcon, 0, pixel->stride, 0, pixel->height );
+	fbcon_blit ( fbcon );
+
 	/* Update console width and height */
 	console_set_size ( fbcon->character.width, fbcon->character.height );
 
@@ -701,6 +821,8 @@ int fbcon_init ( struct fbcon *fbcon, userptr_t start,
  err_picture:
 	ufree ( fbcon->text.start );
  err_text:
+	ufree ( fbcon->shadow );
+ err_shadow:
  err_margin:
 	return rc;
 }
@@ -714,4 +836,5 @@ void fbcon_fini ( struct fbcon *fbcon ) {
 
 	ufree ( fbcon->text.start );
 	ufree ( fbcon->picture.start );
+	ufree ( fbcon->shadow );
 }
@@ -24,6 +24,7 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <string.h>
+#include <stdio.h>
 #include <errno.h>
 #include <assert.h>
 #include <byteswap.h>
@@ -39,6 +40,32 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** The system flattened device tree (if present) */
 static struct fdt fdt;
 
+/** Number of cached path lookups
+ *
+ * Boot-time consumers (such as MAC address extraction) tend to query
+ * the same handful of nodes repeatedly, and each uncached lookup
+ * re-walks the structure block token by token.  This is a policy
+ * decision.
+ */
+#define FDT_PATH_CACHE_COUNT 8
+
+/** Maximum length of a cached path */
+#define FDT_PATH_CACHE_LEN 64
+
+/** A cached path lookup */
+struct fdt_path_cache_entry {
+	/** Node path, or empty if entry is unused */
+	char path[FDT_PATH_CACHE_LEN];
+	/** Node offset */
+	unsigned int offset;
+};
+
+/** Path lookup cache */
+static struct fdt_path_cache_entry fdt_path_cache[FDT_PATH_CACHE_COUNT];
+
+/** Path lookup cache eviction rotation */
+static unsigned int fdt_path_cache_next;
+
 /** A position within a device tree */
 struct fdt_cursor {
 	/** Offset within structure block */
@@ -239,10 +266,23 @@ static int fdt_child ( unsigned int offset, const char *name,
  * @ret rc		Return status code
  */
 int fdt_path ( const char *path, unsigned int *offset ) {
+	struct fdt_path_cache_entry *entry;
 	char *tmp = ( ( char * ) path );
 	char *del;
+	unsigned int i;
 	int rc;
 
+	/* Return cached lookup, if any */
+	for ( i = 0 ; i < FDT_PATH_CACHE_COUNT ; i++ ) {
+		entry = &fdt_path_cache[i];
+		if ( entry->path[0] && ( strcmp ( entry->path, path ) == 0 ) ) {
+			*offset = entry->offset;
+			DBGC2 ( &fdt, "FDT found cached path \"%s\" at "
+				"+%#04x\n", path, *offset );
+			return 0;
+		}
+	}
+
 	/* Initialise offset */
 	*offset = 0;
 
@@ -270,6 +310,14 @@ int fdt_path ( const char *path, unsigned int *offset ) {
 			tmp++;
 	}
 
+	/* Cache successful lookup */
+	if ( strlen ( path ) < FDT_PATH_CACHE_LEN ) {
+		entry = &fdt_path_cache[ fdt_path_cache_next++ %
+					 FDT_PATH_CACHE_COUNT ];
+		snprintf ( entry->path, sizeof ( entry->path ), "%s", path );
+		entry->offset = *offset;
+	}
+
 	DBGC2 ( &fdt, "FDT found path \"%s\" at +%#04x\n", path, *offset );
 	return 0;
 }
@@ -375,16 +423,40 @@ const char * fdt_string ( unsigned int offset, const char *name ) {
  * @ret rc		Return status code
  */
 int fdt_mac ( unsigned int offset, struct net_device *netdev ) {
+	struct fdt_cursor pos;
 	struct fdt_descriptor desc;
+	struct fdt_descriptor fallback;
 	size_t len;
-	int rc;
-
-	/* Find applicable MAC address property */
-	if ( ( ( rc = fdt_property ( offset, "mac-address", &desc ) ) != 0 ) &&
-	     ( ( rc = fdt_property ( offset, "local-mac-address",
-				     &desc ) ) != 0 ) ) {
-		return rc;
+	int found = 0;
+
+	/* Find applicable MAC address property.  Both candidate
+	 * properties are checked in a single traversal, since each
+	 * property lookup would otherwise re-walk the node's tokens
+	 * from scratch.
+	 */
+	memset ( &desc, 0, sizeof ( desc ) );
+	memset ( &fallback, 0, sizeof ( fallback ) );
+	pos.offset = offset;
+	pos.depth = -1;
+	while ( fdt_traverse ( &pos, &desc ) == 0 ) {
+		if ( ( pos.depth != 0 ) || ( ! desc.data ) )
+			continue;
+		if ( strcmp ( desc.name, "mac-address" ) == 0 ) {
+			found = 1;
+			break;
+		}
+		if ( strcmp ( desc.name, "local-mac-address" ) == 0 ) {
+			memcpy ( &fallback, &desc, sizeof ( fallback ) );
+			found = 1;
+		}
+	}
+	if ( ! found ) {
+		DBGC ( &fdt, "FDT +%#04x has no MAC address property\n",
+		       offset );
+		return -ENOENT;
 	}
+	if ( ! desc.data )
+		memcpy ( &desc, &fallback, sizeof ( desc ) );
 
 	/* Check length */
 	len = netdev->ll_protocol->hw_addr_len;
@@ -401,6 +473,35 @@ int fdt_mac ( unsigned int offset, struct net_device *netdev ) {
 	return 0;
 }
 
+/**
+ * Find 32-bit integer property
+ *
+ * @v offset		Starting node offset
+ * @v name		Property name
+ * @v value		Value to fill in
+ * @ret rc		Return status code
+ */
+int fdt_u32 ( unsigned int offset, const char *name, uint32_t *value ) {
+	struct fdt_descriptor desc;
+	int rc;
+
+	/* Find property */
+	if ( ( rc = fdt_property ( offset, name, &desc ) ) != 0 )
+		return rc;
+
+	/* Check length */
+	if ( desc.len != sizeof ( *value ) ) {
+		DBGC ( &fdt, "FDT malformed u32 property \"%s\":\n", name );
+		DBGC_HDA ( &fdt, 0, desc.data, desc.len );
+		return -ERANGE;
+	}
+
+	/* Fill in value */
+	*value = be32_to_cpu ( *( ( const uint32_t * ) desc.data ) );
+
+	return 0;
+}
+
 /**
  * Register device tree
  *
@@ -410,6 +511,10 @@ int fdt_mac ( unsigned int offset, struct net_device *netdev ) {
 int register_fdt ( const struct fdt_header *hdr ) {
 	const uint8_t *end;
 
+	/* Invalidate path lookup cache */
+	memset ( fdt_path_cache, 0, sizeof ( fdt_path_cache ) );
+	fdt_path_cache_next = 0;
+
 	/* Record device tree location */
 	fdt.hdr = hdr;
 	fdt.len = be32_to_cpu ( hdr->totalsize );
@@ -34,6 +34,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/list.h>
 #include <ipxe/umalloc.h>
 #include <ipxe/uri.h>
+#include <ipxe/crypto.h>
+#include <ipxe/boottrace.h>
 #include <ipxe/image.h>
 
 /** @file
@@ -183,10 +185,31 @@ int image_set_cmdline ( struct image *image, const char *cmdline ) {
  */
 static int image_probe ( struct image *image ) {
 	struct image_type *type;
+	uint8_t signature[IMAGE_SIGLEN_MAX];
 	int rc;
 
 	/* Try each type in turn */
 	for_each_table_entry ( type, IMAGE_TYPES ) {
+
+		/* Skip types for which the image has no matching
+		 * magic signature, without invoking the (potentially
+		 * expensive) probe method.
+		 */
+		if ( type->siglen ) {
+			assert ( type->siglen <= sizeof ( signature ) );
+			if ( ( type->sigoffset + type->siglen ) > image->len )
+				continue;
+			copy_from_user ( signature, image->data,
+					 type->sigoffset, type->siglen );
+			if ( memcmp ( signature, type->signature,
+				      type->siglen ) != 0 ) {
+				DBGC2 ( image, "IMAGE %s has no %s "
+					"signature\n", image->name,
+					type->name );
+				continue;
+			}
+		}
+
 		if ( ( rc = type->probe ( image ) ) == 0 ) {
 			image->type = type;
 			DBGC ( image, "IMAGE %s is %s\n",
@@ -278,6 +301,83 @@ struct image * find_image ( const char *name ) {
 	return NULL;
 }
 
+/**
+ * Find image by data digest
+ *
+ * @v digest		Digest algorithm
+ * @v value		Digest value
+ * @ret image		Registered image, or NULL
+ *
+ * Only cached digests (as calculated during download) are consulted:
+ * an image whose digest has not been cached will not be matched.
+ */
+struct image * find_image_digest ( struct digest_algorithm *digest,
+				   const void *value ) {
+	struct image *image;
+	uint8_t cached[IMAGE_DIGEST_MAX_SIZE];
+
+	list_for_each_entry ( image, &images, list ) {
+		if ( image_digest ( image, digest, cached ) != 0 )
+			continue;
+		if ( memcmp ( cached, value, digest->digestsize ) == 0 )
+			return image;
+	}
+
+	return NULL;
+}
+
+/**
+ * Find registered image with content identical to an image
+ *
+ * @v image		Image (need not itself be registered)
+ * @ret duplicate	Registered image with identical content, or NULL
+ *
+ * Content identity is established via the cached data digests, with
+ * lengths compared as a guard against digest truncation.  An image
+ * with no cached digests in common with any registered image will
+ * never be matched.
+ */
+struct image * find_image_duplicate ( struct image *image ) {
+	struct image_digest *cached;
+	struct image *duplicate;
+	unsigned int i;
+
+	for ( i = 0 ; i < IMAGE_DIGESTS ; i++ ) {
+
+		/* Ignore empty digest cache entries */
+		cached = &image->digests[i];
+		if ( ! cached->digest )
+			continue;
+
+		/* Look up digest value in the registry */
+		duplicate = find_image_digest ( cached->digest,
+						cached->value );
+		if ( ( ! duplicate ) || ( duplicate == image ) )
+			continue;
+		if ( duplicate->len != image->len )
+			continue;
+
+		DBGC ( image, "IMAGE %s duplicates %s (matching %s digest)\n",
+		       image->name, duplicate->name, cached->digest->name );
+		return duplicate;
+	}
+
+	return NULL;
+}
+
+/**
+ * Wait for background signature verification to complete
+ *
+ * @v image		Image
+ * @ret rc		Return status code
+ *
+ * This is a weak definition, overridden when image trust management
+ * is included in the build.
+ */
+__weak int imgverify_wait ( struct image *image __unused ) {
+	return 0;
+}
+
 /**
  * Execute image
  *
@@ -297,6 +397,13 @@ int image_exec ( struct image *image ) {
 	/* Sanity check */
 	assert ( image->flags & IMAGE_REGISTERED );
 
+	/* Wait for any background signature verification to complete */
+	if ( ( rc = imgverify_wait ( image ) ) != 0 )
+		return rc;
+
+	/* Record boot trace marker */
+	boottrace ( "exec %s", image->name );
+
 	/* Switch current working directory to be that of the image itself */
 	old_cwuri = uri_get ( cwuri );
 	churi ( image->uri );
@@ -481,3 +588,75 @@ int image_set_trust ( int require_trusted, int permanent ) {
 
 	return 0;
 }
+
+/**
+ * Check image trust requirement
+ *
+ * @ret require_trusted	Trusted images are currently required
+ */
+int image_trust_required ( void ) {
+
+	return require_trusted_images;
+}
+
+/**
+ * Record a cached image data digest
+ *
+ * @v image		Image
+ * @v digest		Digest algorithm
+ * @v value		Digest value
+ * @ret rc		Return status code
+ *
+ * The digest cache is advisory: failure to record a digest (e.g.
+ * because the cache is full) is harmless, since the digest can always
+ * be recalculated from the image data.
+ */
+int image_set_digest ( struct image *image, struct digest_algorithm *digest,
+		       const void *value ) {
+	struct image_digest *cached;
+	unsigned int i;
+
+	/* Sanity check */
+	if ( digest->digestsize > IMAGE_DIGEST_MAX_SIZE )
+		return -ENOSPC;
+
+	/* Use existing entry for this algorithm, or first empty entry */
+	for ( i = 0 ; i < IMAGE_DIGESTS ; i++ ) {
+		cached = &image->digests[i];
+		if ( ( cached->digest == NULL ) ||
+		     ( cached->digest == digest ) ) {
+			cached->digest = digest;
+			memcpy ( cached->value, value, digest->digestsize );
+			DBGC ( image, "IMAGE %s cached %s digest\n",
+			       image->name, digest->name );
+			return 0;
+		}
+	}
+
+	return -ENOSPC;
+}
+
+/**
+ * Retrieve a cached image data digest
+ *
+ * @v image		Image
+ * @v digest		Digest algorithm
+ * @v out		Digest value to fill in
+ * @ret rc		Return status code
+ */
+int image_digest ( struct image *image, struct digest_algorithm *digest,
+		   void *out ) {
+	struct image_digest *cached;
+	unsigned int i;
+
+	/* Look for a matching cached digest */
+	for ( i = 0 ; i < IMAGE_DIGESTS ; i++ ) {
+		cached = &image->digests[i];
+		if ( cached->digest == digest ) {
+			memcpy ( out, cached->value, digest->digestsize );
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
@@ -32,6 +32,15 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/** Interface topology generation
+ *
+ * This is incremented whenever any interface is plugged, unplugged,
+ * or has its descriptor changed, thereby invalidating all cached
+ * operation lookups.  It starts at one so that a zeroed cache
+ * generation is always invalid.
+ */
+unsigned int intf_generation = 1;
+
 /*****************************************************************************
  *
  * The null interface
@@ -87,6 +96,7 @@ void intf_plug ( struct interface *intf, struct interface *dest ) {
 	intf_get ( dest );
 	intf_put ( intf->dest );
 	intf->dest = dest;
+	intf_generation++;
 }
 
 /**
@@ -114,6 +124,7 @@ void intf_unplug ( struct interface *intf ) {
 	       INTF_INTF_DBG ( intf, intf->dest ) );
 	intf_put ( intf->dest );
 	intf->dest = &null_intf;
+	intf_generation++;
 }
 
 /**
@@ -123,6 +134,7 @@ void intf_unplug ( struct interface *intf ) {
  */
 void intf_nullify ( struct interface *intf ) {
 	intf->desc = &null_intf_desc;
+	intf_generation++;
 }
 
 /**
@@ -206,8 +218,19 @@ void * intf_get_dest_op_no_passthru_untyped ( struct interface *intf,
  */
 void * intf_get_dest_op_untyped ( struct interface *intf, void *type,
 				  struct interface **dest ) {
+	struct interface *start = intf;
 	void *func;
 
+	/* Use cached lookup, if still valid.  This lookup is
+	 * performed several times per delivered packet, and its
+	 * result cannot change between interface topology changes.
+	 */
+	if ( ( start->cache_generation == intf_generation ) &&
+	     ( start->cache_type == type ) ) {
+		*dest = intf_get ( start->cache_dest );
+		return start->cache_func;
+	}
+
 	while ( 1 ) {
 
 		/* Search for an implementing method provided by the
@@ -215,13 +238,21 @@ void * intf_get_dest_op_untyped ( struct interface *intf, void *type,
 		 */
 		func = intf_get_dest_op_no_passthru_untyped( intf, type, dest );
 		if ( func )
-			return func;
+			break;
 
 		/* Pass through to the underlying interface, if applicable */
 		if ( ! ( intf = intf_get_passthru ( *dest ) ) )
-			return NULL;
+			break;
 		intf_put ( *dest );
 	}
+
+	/* Cache lookup (including a NULL result) */
+	start->cache_type = type;
+	start->cache_func = func;
+	start->cache_dest = *dest;
+	start->cache_generation = intf_generation;
+
+	return func;
 }
 
 /*****************************************************************************
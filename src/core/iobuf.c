@@ -27,6 +27,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <strings.h>
 #include <errno.h>
 #include <ipxe/malloc.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/profile.h>
 #include <ipxe/iobuf.h>
 
 /** @file
@@ -112,6 +114,16 @@ struct io_buffer * alloc_iob_raw ( size_t len, size_t align, size_t offset ) {
 	/* Populate descriptor */
 	iobuf->head = iobuf->data = iobuf->tail = data;
 	iobuf->end = ( data + len );
+	iobuf->pool = NULL;
+	iobuf->flags = 0;
+	iobuf->frag = NULL;
+
+	/* Default the ingress timestamp to the time of allocation, so
+	 * that buffers which bypass the receive queue (e.g. fragment
+	 * reassembly buffers) still carry a defined value.
+	 */
+	if ( PROFILING )
+		iobuf->rx_stamp = profile_timestamp();
 
 	return iobuf;
 }
@@ -138,11 +150,12 @@ struct io_buffer * alloc_iob ( size_t len ) {
 }
 
 /**
- * Free I/O buffer
+ * Free a single I/O buffer fragment
  *
  * @v iobuf	I/O buffer
  */
-void free_iob ( struct io_buffer *iobuf ) {
+static void free_iob_frag ( struct io_buffer *iobuf ) {
+	struct iob_pool *pool;
 	size_t len;
 
 	/* Allow free_iob(NULL) to be valid */
@@ -154,6 +167,20 @@ void free_iob ( struct io_buffer *iobuf ) {
 	assert ( iobuf->data <= iobuf->tail );
 	assert ( iobuf->tail <= iobuf->end );
 
+	/* Recycle into pool, if applicable */
+	pool = iobuf->pool;
+	if ( pool ) {
+		if ( pool->count < pool->max ) {
+			iobuf->data = iobuf->tail = iobuf->head;
+			iobuf->flags = 0;
+			list_add_tail ( &iobuf->list, &pool->free );
+			pool->count++;
+			return;
+		}
+		/* Pool is closed or full: detach buffer */
+		iobuf->pool = NULL;
+	}
+
 	/* Free buffer */
 	len = ( iobuf->end - iobuf->head );
 	if ( iobuf->end == iobuf ) {
@@ -167,6 +194,138 @@ void free_iob ( struct io_buffer *iobuf ) {
 		free_dma ( iobuf->head, len );
 		free ( iobuf );
 	}
+
+	/* Drop pool's reference to its containing object, if
+	 * applicable.  This must happen after freeing the buffer,
+	 * since dropping the reference may free the pool itself.
+	 */
+	if ( pool )
+		ref_put ( pool->refcnt );
+}
+
+/**
+ * Free I/O buffer
+ *
+ * @v iobuf	I/O buffer (i.e. head of fragment chain)
+ *
+ * Frees all fragments in the chain, if the buffer is chained.
+ */
+void free_iob ( struct io_buffer *iobuf ) {
+	struct io_buffer *frag;
+
+	while ( iobuf ) {
+		frag = iobuf;
+		iobuf = frag->frag;
+		frag->frag = NULL;
+		free_iob_frag ( frag );
+	}
+}
+
+/**
+ * Open I/O buffer recycling pool
+ *
+ * @v pool	Pool
+ * @v refcnt	Reference counter of containing object, or NULL
+ * @v len	Payload length of pooled buffers
+ * @v max	Maximum number of recycled buffers
+ *
+ * Primes the pool with @c max buffers.  Priming failures are not
+ * fatal, since the pool will simply be refilled from the heap on
+ * demand.
+ */
+void iob_pool_open ( struct iob_pool *pool, struct refcnt *refcnt,
+		     size_t len, unsigned int max ) {
+	struct list_head primed;
+	struct io_buffer *iobuf;
+	struct io_buffer *tmp;
+	unsigned int i;
+
+	/* Initialise pool */
+	pool->refcnt = refcnt;
+	pool->len = len;
+	pool->count = 0;
+	pool->max = max;
+	INIT_LIST_HEAD ( &pool->free );
+
+	/* Prime pool.  The buffers must all be allocated before any
+	 * are freed, since freeing a buffer will recycle it back into
+	 * the pool.
+	 */
+	INIT_LIST_HEAD ( &primed );
+	for ( i = 0 ; i < max ; i++ ) {
+		iobuf = alloc_iob_pool ( pool, len );
+		if ( ! iobuf )
+			break;
+		list_add ( &iobuf->list, &primed );
+	}
+	list_for_each_entry_safe ( iobuf, tmp, &primed, list ) {
+		list_del ( &iobuf->list );
+		free_iob ( iobuf );
+	}
+}
+
+/**
+ * Allocate I/O buffer from recycling pool
+ *
+ * @v pool	Pool
+ * @v len	Required length of buffer
+ * @ret iobuf	I/O buffer, or NULL if none available
+ *
+ * Reuses a recycled buffer if one is available, falling back to
+ * alloc_iob() otherwise.  A pool that has not been opened behaves as
+ * a plain (non-recycling) allocation.
+ */
+struct io_buffer * alloc_iob_pool ( struct iob_pool *pool, size_t len ) {
+	struct io_buffer *iobuf;
+
+	/* Reuse a recycled buffer, if possible */
+	if ( pool->max && ( len <= pool->len ) ) {
+		iobuf = list_first_entry ( &pool->free, struct io_buffer,
+					   list );
+		if ( iobuf ) {
+			list_del ( &iobuf->list );
+			pool->count--;
+			return iobuf;
+		}
+	}
+
+	/* Allocate a fresh buffer */
+	iobuf = alloc_iob ( len );
+	if ( ! iobuf )
+		return NULL;
+
+	/* Attach buffer to the pool, if open */
+	if ( pool->max ) {
+		iobuf->pool = pool;
+		ref_get ( pool->refcnt );
+	}
+
+	return iobuf;
+}
+
+/**
+ * Close I/O buffer recycling pool
+ *
+ * @v pool	Pool
+ *
+ * Frees all recycled buffers.  Buffers still in flight will detach
+ * themselves from the pool (and release their reference to the
+ * containing object) when eventually freed by their current owner.
+ */
+void iob_pool_close ( struct iob_pool *pool ) {
+	struct io_buffer *iobuf;
+	struct io_buffer *tmp;
+
+	/* Prevent further recycling */
+	pool->max = 0;
+
+	/* Free all recycled buffers */
+	list_for_each_entry_safe ( iobuf, tmp, &pool->free, list ) {
+		list_del ( &iobuf->list );
+		pool->count--;
+		free_iob ( iobuf );
+	}
+	assert ( pool->count == 0 );
 }
 
 /**
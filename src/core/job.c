@@ -33,6 +33,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/** Job activity counter */
+unsigned int job_activity;
+
 /**
  * Get job progress
  *
@@ -234,6 +234,180 @@ static inline void check_blocks ( void ) {
 	}
 }
 
+/** A slab cache of free memory blocks of a single frequently used size */
+struct slab_cache {
+	/** Size of cached blocks
+	 *
+	 * Must be a multiple of MIN_MEMBLOCK_SIZE on all supported
+	 * platforms.
+	 */
+	size_t size;
+	/** Maximum number of cached blocks
+	 *
+	 * This is a policy decision.
+	 */
+	unsigned int max;
+	/** Current number of cached blocks */
+	unsigned int count;
+	/** List of cached blocks */
+	struct list_head list;
+};
+
+/** Slab caches
+ *
+ * Caches are keyed on the rounded-up block size as used internally by
+ * alloc_memblock() and free_memblock().  The chosen sizes cover
+ * reference-counted protocol control structures and typical Ethernet
+ * frame I/O buffers, which are allocated and freed at high rates
+ * during downloads and would otherwise repeatedly walk the free list.
+ *
+ * Cached blocks are accounted as used memory, and will be returned to
+ * the free list (via the cache discarder mechanism) under memory
+ * pressure.
+ */
+static struct slab_cache slab_caches[] = {
+	{ .size = 128, .max = 32,
+	  .list = LIST_HEAD_INIT ( slab_caches[0].list ) },
+	{ .size = 256, .max = 16,
+	  .list = LIST_HEAD_INIT ( slab_caches[1].list ) },
+	{ .size = 2048, .max = 32,
+	  .list = LIST_HEAD_INIT ( slab_caches[2].list ) },
+};
+
+/** Slab caches are currently being discarded */
+static int slab_cache_discarding;
+
+/**
+ * Find slab cache for block size
+ *
+ * @v actual_size	Rounded-up block size
+ * @ret cache		Slab cache, or NULL
+ */
+static struct slab_cache * slab_cache ( size_t actual_size ) {
+	struct slab_cache *cache;
+	unsigned int i;
+
+	for ( i = 0 ; i < ( sizeof ( slab_caches ) /
+			    sizeof ( slab_caches[0] ) ) ; i++ ) {
+		cache = &slab_caches[i];
+		assert ( ( cache->size & ( MIN_MEMBLOCK_SIZE - 1 ) ) == 0 );
+		if ( cache->size == actual_size )
+			return cache;
+	}
+	return NULL;
+}
+
+/**
+ * Allocate a memory block from a slab cache, if possible
+ *
+ * @v actual_size	Rounded-up block size
+ * @v align_mask	Physical alignment mask
+ * @v offset		Offset from physical alignment
+ * @ret ptr		Memory block, or NULL
+ */
+static void * slab_cache_alloc ( size_t actual_size, size_t align_mask,
+				 size_t offset ) {
+	struct slab_cache *cache;
+	struct memory_block *block;
+
+	/* Find applicable slab cache, if any */
+	cache = slab_cache ( actual_size );
+	if ( ! cache )
+		return NULL;
+
+	/* Use first cached block, if any.  We do not search the whole
+	 * cache for a block satisfying an unusual alignment
+	 * constraint; such requests simply fall through to the free
+	 * list.
+	 */
+	block = list_first_entry ( &cache->list, struct memory_block, list );
+	if ( ! block )
+		return NULL;
+	if ( ( ( offset - virt_to_phys ( block ) ) & align_mask ) != 0 )
+		return NULL;
+
+	/* Remove block from cache */
+	list_del ( &block->list );
+	cache->count--;
+
+	return block;
+}
+
+/**
+ * Cache a freed memory block in a slab cache, if possible
+ *
+ * @v ptr		Memory block
+ * @v size		Size of the memory block
+ * @ret cached		Block has been cached
+ */
+static int slab_cache_free ( void *ptr, size_t size ) {
+	struct slab_cache *cache;
+	struct memory_block *block;
+	struct memory_block *cached;
+	size_t actual_size;
+
+	/* Find applicable slab cache, if any */
+	actual_size = ( ( size + MIN_MEMBLOCK_SIZE - 1 ) &
+			~( MIN_MEMBLOCK_SIZE - 1 ) );
+	cache = slab_cache ( actual_size );
+	if ( ! cache )
+		return 0;
+
+	/* Do not cache if the cache is full or being discarded */
+	if ( ( cache->count >= cache->max ) || slab_cache_discarding )
+		return 0;
+
+	/* Check for double frees within the cache */
+	if ( ASSERTING ) {
+		list_for_each_entry ( cached, &cache->list, list )
+			assert ( cached != ptr );
+	}
+
+	/* Add block to cache */
+	VALGRIND_MAKE_MEM_NOACCESS ( ptr, size );
+	block = ptr;
+	VALGRIND_MAKE_MEM_UNDEFINED ( block, sizeof ( *block ) );
+	block->size = actual_size;
+	list_add ( &block->list, &cache->list );
+	cache->count++;
+
+	return 1;
+}
+
+/**
+ * Discard all slab-cached memory blocks
+ *
+ * @ret discarded	Number of cached items discarded
+ */
+static unsigned int slab_cache_discard ( void ) {
+	struct slab_cache *cache;
+	struct memory_block *block;
+	struct memory_block *tmp;
+	unsigned int discarded = 0;
+	unsigned int i;
+
+	for ( i = 0 ; i < ( sizeof ( slab_caches ) /
+			    sizeof ( slab_caches[0] ) ) ; i++ ) {
+		cache = &slab_caches[i];
+		slab_cache_discarding = 1;
+		list_for_each_entry_safe ( block, tmp, &cache->list, list ) {
+			list_del ( &block->list );
+			cache->count--;
+			free_memblock ( block, cache->size );
+			discarded++;
+		}
+		slab_cache_discarding = 0;
+		assert ( cache->count == 0 );
+	}
+
+	return discarded;
+}
+
+/** Slab cache discarder */
+struct cache_discarder slab_cache_discarder __cache_discarder ( CACHE_CHEAP ) ={
+	.discard = slab_cache_discard,
+};
+
 /**
  * Discard some cached data
  *
@@ -312,6 +486,19 @@ void * alloc_memblock ( size_t size, size_t align, size_t offset ) {
 
 	DBGC2 ( &heap, "Allocating %#zx (aligned %#zx+%zx)\n",
 		size, align, offset );
+
+	/* Satisfy allocation from a slab cache, if possible, avoiding
+	 * the linear free list search entirely.
+	 */
+	block = slab_cache_alloc ( actual_size, align_mask, offset );
+	if ( block ) {
+		DBGC2 ( &heap, "Allocated [%p,%p) from slab cache\n", block,
+			( ( ( void * ) block ) + size ) );
+		ptr = block;
+		VALGRIND_MAKE_MEM_UNDEFINED ( ptr, size );
+		goto done;
+	}
+
 	while ( 1 ) {
 		/* Search through blocks for the first one with enough space */
 		list_for_each_entry ( block, &free_blocks, list ) {
@@ -412,6 +599,10 @@ void free_memblock ( void *ptr, size_t size ) {
 	/* Allow for ptr==NULL */
 	if ( ! ptr )
 		return;
+
+	/* Cache block in a slab cache, if possible */
+	if ( slab_cache_free ( ptr, size ) )
+		return;
 	VALGRIND_MAKE_MEM_NOACCESS ( ptr, size );
 
 	/* Sanity checks */
@@ -659,6 +850,34 @@ void mpopulate ( void *start, size_t len ) {
 	usedmem += len;
 }
 
+/**
+ * Collect heap statistics
+ *
+ * @v stats		Heap statistics to fill in
+ *
+ * In addition to the running usage counters, this walks the free list
+ * to compute fragmentation metrics: the largest free block bounds the
+ * largest single allocation that can currently succeed, however much
+ * total free memory remains.
+ */
+void mstat ( struct memory_stats *stats ) {
+	struct memory_block *block;
+
+	memset ( stats, 0, sizeof ( *stats ) );
+	stats->free = freemem;
+	stats->used = usedmem;
+	stats->maxused = maxusedmem;
+
+	/* Walk free list to measure fragmentation */
+	valgrind_make_blocks_defined();
+	list_for_each_entry ( block, &free_blocks, list ) {
+		stats->fragments++;
+		if ( block->size > stats->largest )
+			stats->largest = block->size;
+	}
+	valgrind_make_blocks_noaccess();
+}
+
 /**
  * Initialise the heap
  *
@@ -89,19 +89,30 @@ int monojob_wait ( const char *string, unsigned long timeout ) {
 	unsigned long scaled_completed;
 	unsigned long scaled_total;
 	unsigned int percentage;
+	unsigned int shown = -1U;
+	unsigned int activity;
 	size_t clear_len = 0;
-	int ongoing_rc;
+	int ongoing_rc = 0;
 	int key;
 	int rc;
 
 	if ( string )
 		printf ( "%s...", string );
 	monojob_rc = -EINPROGRESS;
+	memset ( &progress, 0, sizeof ( progress ) );
 	last_check = last_progress = last_display = currticks();
+	activity = ( job_activity - 1 );
 	while ( monojob_rc == -EINPROGRESS ) {
 
 		/* Allow job to progress */
 		step();
+
+		/* Halt the CPU until the next interrupt, if it is safe
+		 * to do so.  This avoids spinning at 100% CPU when the
+		 * only pending work is a timer some way out.
+		 */
+		process_nap();
+
 		now = currticks();
 
 		/* Continue until a timer tick occurs (to minimise
@@ -121,8 +132,17 @@ int monojob_wait ( const char *string, unsigned long timeout ) {
 			}
 		}
 
-		/* Monitor progress */
-		ongoing_rc = job_progress ( &monojob, &progress );
+		/* Monitor progress.  Activity is recorded cheaply at
+		 * the point of data delivery; if none has occurred
+		 * since the last query then the answer cannot have
+		 * changed, and the interface traversal (which may
+		 * cover many chains for parallel downloads) can be
+		 * elided.
+		 */
+		if ( activity != job_activity ) {
+			activity = job_activity;
+			ongoing_rc = job_progress ( &monojob, &progress );
+		}
 
 		/* Reset timeout if progress has been made */
 		if ( completed != progress.completed )
@@ -136,24 +156,34 @@ int monojob_wait ( const char *string, unsigned long timeout ) {
 			break;
 		}
 
-		/* Display progress, if applicable */
+		/* Display progress, if applicable.  Updates are
+		 * quantised to whole percentage points; redrawing an
+		 * unchanged value (on e.g. a serial console) costs far
+		 * more than the progress query itself.
+		 */
 		elapsed = ( now - last_display );
 		if ( string && ( elapsed >= TICKS_PER_SEC ) ) {
-			monojob_clear ( clear_len );
 			/* Normalise progress figures to avoid overflow */
 			scaled_completed = ( progress.completed / 128 );
 			scaled_total = ( progress.total / 128 );
-			if ( scaled_total ) {
-				percentage = ( ( 100 * scaled_completed ) /
-					       scaled_total );
-				clear_len = printf ( "%3d%%", percentage );
-			} else {
-				printf ( "." );
-				clear_len = 0;
-			}
-			if ( progress.message[0] ) {
-				clear_len += printf ( " [%s]",
-						      progress.message );
+			percentage = ( scaled_total ?
+				       ( ( 100 * scaled_completed ) /
+					 scaled_total ) : 0 );
+			if ( ( ! scaled_total ) || ( percentage != shown ) ||
+			     progress.message[0] ) {
+				monojob_clear ( clear_len );
+				if ( scaled_total ) {
+					clear_len = printf ( "%3d%%",
+							     percentage );
+					shown = percentage;
+				} else {
+					printf ( "." );
+					clear_len = 0;
+				}
+				if ( progress.message[0] ) {
+					clear_len += printf ( " [%s]",
+							      progress.message );
+				}
 			}
 			last_display = now;
 		}
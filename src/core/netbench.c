@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2015 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/interface.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/open.h>
+#include <ipxe/process.h>
+#include <ipxe/retry.h>
+#include <ipxe/timer.h>
+#include <ipxe/socket.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/netbench.h>
+
+/** @file
+ *
+ * Network throughput benchmark
+ *
+ * Blasts fixed-size payloads at a remote server (typically a discard
+ * or chargen service) for a fixed duration, counting bytes in both
+ * directions.
+ */
+
+/** Maximum number of transmissions per process step */
+#define NETBENCH_BURST 8
+
+/** A network benchmark */
+struct netbench {
+	/** Reference count */
+	struct refcnt refcnt;
+
+	/** Job control interface */
+	struct interface job;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Transmission process */
+	struct process process;
+	/** Duration timer */
+	struct retry_timer timer;
+
+	/** Payload length */
+	size_t len;
+	/** Start time (in ticks) */
+	unsigned long start;
+	/** Bytes transmitted */
+	uint64_t tx_bytes;
+	/** Bytes received */
+	uint64_t rx_bytes;
+
+	/** Callback function
+	 *
+	 * @v tx_bytes		Bytes transmitted
+	 * @v rx_bytes		Bytes received
+	 * @v elapsed		Elapsed time (in ticks)
+	 */
+	void ( * callback ) ( uint64_t tx_bytes, uint64_t rx_bytes,
+			      unsigned long elapsed );
+};
+
+/**
+ * Close network benchmark
+ *
+ * @v netbench		Network benchmark
+ * @v rc		Reason for close
+ */
+static void netbench_close ( struct netbench *netbench, int rc ) {
+
+	/* Stop timer and transmission process */
+	stop_timer ( &netbench->timer );
+	process_del ( &netbench->process );
+
+	/* Shut down interfaces */
+	intf_shutdown ( &netbench->xfer, rc );
+	intf_shutdown ( &netbench->job, rc );
+}
+
+/**
+ * Handle duration timer expiry
+ *
+ * @v timer		Timer
+ * @v over		Failure indicator
+ */
+static void netbench_expired ( struct retry_timer *timer,
+			       int over __unused ) {
+	struct netbench *netbench =
+		container_of ( timer, struct netbench, timer );
+
+	/* Report results */
+	if ( netbench->callback ) {
+		netbench->callback ( netbench->tx_bytes, netbench->rx_bytes,
+				     ( currticks() - netbench->start ) );
+	}
+
+	/* Terminate benchmark */
+	netbench_close ( netbench, 0 );
+}
+
+/**
+ * Transmit benchmark payloads
+ *
+ * @v netbench		Network benchmark
+ */
+static void netbench_step ( struct netbench *netbench ) {
+	struct io_buffer *iobuf;
+	unsigned int i;
+	int rc;
+
+	/* Transmit a limited burst of payloads per step, to avoid
+	 * starving other processes on sockets (such as UDP) whose
+	 * windows never close.
+	 */
+	for ( i = 0 ; i < NETBENCH_BURST ; i++ ) {
+
+		/* Wait for window to (re)open */
+		if ( xfer_window ( &netbench->xfer ) < netbench->len )
+			break;
+
+		/* Allocate and fill I/O buffer */
+		iobuf = xfer_alloc_iob ( &netbench->xfer, netbench->len );
+		if ( ! iobuf )
+			break;
+		memset ( iob_put ( iobuf, netbench->len ), 0, netbench->len );
+
+		/* Transmit payload */
+		if ( ( rc = xfer_deliver_iob ( &netbench->xfer,
+					       iobuf ) ) != 0 ) {
+			DBGC ( netbench, "NETBENCH %p could not transmit: "
+			       "%s\n", netbench, strerror ( rc ) );
+			break;
+		}
+		netbench->tx_bytes += netbench->len;
+	}
+}
+
+/**
+ * Handle received data
+ *
+ * @v netbench		Network benchmark
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int netbench_deliver ( struct netbench *netbench,
+			      struct io_buffer *iobuf,
+			      struct xfer_metadata *meta __unused ) {
+
+	/* Count and discard received data */
+	netbench->rx_bytes += iob_len ( iobuf );
+	free_iob ( iobuf );
+
+	return 0;
+}
+
+/** Network benchmark data transfer interface operations */
+static struct interface_operation netbench_xfer_op[] = {
+	INTF_OP ( xfer_deliver, struct netbench *, netbench_deliver ),
+	INTF_OP ( intf_close, struct netbench *, netbench_close ),
+};
+
+/** Network benchmark data transfer interface descriptor */
+static struct interface_descriptor netbench_xfer_desc =
+	INTF_DESC ( struct netbench, xfer, netbench_xfer_op );
+
+/** Network benchmark job control interface operations */
+static struct interface_operation netbench_job_op[] = {
+	INTF_OP ( intf_close, struct netbench *, netbench_close ),
+};
+
+/** Network benchmark job control interface descriptor */
+static struct interface_descriptor netbench_job_desc =
+	INTF_DESC ( struct netbench, job, netbench_job_op );
+
+/** Network benchmark process descriptor */
+static struct process_descriptor netbench_process_desc =
+	PROC_DESC ( struct netbench, process, netbench_step );
+
+/**
+ * Create network benchmark
+ *
+ * @v job		Job control interface
+ * @v hostname		Hostname of benchmark server
+ * @v port		Port number
+ * @v tcp		Use TCP rather than UDP
+ * @v len		Payload length
+ * @v duration		Duration (in ticks)
+ * @v callback		Callback function (or NULL)
+ * @ret rc		Return status code
+ */
+int create_netbench ( struct interface *job, const char *hostname,
+		      unsigned int port, int tcp, size_t len,
+		      unsigned long duration,
+		      void ( * callback ) ( uint64_t tx_bytes,
+					    uint64_t rx_bytes,
+					    unsigned long elapsed ) ) {
+	struct netbench *netbench;
+	union {
+		struct sockaddr_tcpip st;
+		struct sockaddr sa;
+	} server;
+	int rc;
+
+	/* Sanity checks */
+	if ( ( ! len ) || ( ! duration ) )
+		return -EINVAL;
+
+	/* Allocate and initialise structure */
+	netbench = zalloc ( sizeof ( *netbench ) );
+	if ( ! netbench )
+		return -ENOMEM;
+	ref_init ( &netbench->refcnt, NULL );
+	intf_init ( &netbench->job, &netbench_job_desc, &netbench->refcnt );
+	intf_init ( &netbench->xfer, &netbench_xfer_desc, &netbench->refcnt );
+	process_init ( &netbench->process, &netbench_process_desc,
+		       &netbench->refcnt );
+	timer_init ( &netbench->timer, netbench_expired, &netbench->refcnt );
+	netbench->len = len;
+	netbench->start = currticks();
+	netbench->callback = callback;
+
+	/* Open socket */
+	memset ( &server, 0, sizeof ( server ) );
+	server.st.st_port = htons ( port );
+	if ( ( rc = xfer_open_named_socket ( &netbench->xfer,
+					     ( tcp ? SOCK_STREAM : SOCK_DGRAM ),
+					     &server.sa, hostname,
+					     NULL ) ) != 0 ) {
+		DBGC ( netbench, "NETBENCH %p could not open socket: %s\n",
+		       netbench, strerror ( rc ) );
+		goto err;
+	}
+
+	/* Start duration timer */
+	start_timer_fixed ( &netbench->timer, duration );
+
+	/* Attach parent interface, mortalise self, and return */
+	intf_plug_plug ( &netbench->job, job );
+	ref_put ( &netbench->refcnt );
+	return 0;
+
+ err:
+	netbench_close ( netbench, rc );
+	ref_put ( &netbench->refcnt );
+	return rc;
+}
@@ -28,6 +28,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <string.h>
 #include <errno.h>
 #include <ipxe/dhcp.h>
+#include <ipxe/init.h>
 #include <ipxe/nvs.h>
 #include <ipxe/nvo.h>
 
@@ -37,6 +38,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/** List of registered non-volatile option blocks */
+struct list_head nvo_blocks = LIST_HEAD_INIT ( nvo_blocks );
+
 /**
  * Calculate checksum over non-volatile stored options
  *
@@ -189,6 +193,26 @@ static int nvo_save ( struct nvo_block *nvo ) {
 	return 0;
 }
 
+/**
+ * Write back any modified non-volatile stored options
+ *
+ * Commits any pending changes in all registered non-volatile option
+ * blocks to the underlying non-volatile storage devices.  Changes
+ * made via nvo_store() are coalesced in RAM until this point, so that
+ * a batch of stored settings results in a single write per block.
+ */
+void nvo_sync ( void ) {
+	struct nvo_block *nvo;
+
+	list_for_each_entry ( nvo, &nvo_blocks, list ) {
+		if ( ! nvo->dirty )
+			continue;
+		if ( nvo_save ( nvo ) != 0 )
+			continue;
+		nvo->dirty = 0;
+	}
+}
+
 /**
  * Check applicability of NVO setting
  *
@@ -226,9 +250,11 @@ static int nvo_store ( struct settings *settings, const struct setting *setting,
 		return rc;
 	}
 
-	/* Save updated options to NVS */
-	if ( ( rc = nvo_save ( nvo ) ) != 0 )
-		return rc;
+	/* Mark options as dirty; they will be written back to NVS by
+	 * the next call to nvo_sync().  Deferring the write allows a
+	 * burst of changes to be coalesced into a single NVS commit.
+	 */
+	nvo->dirty = 1;
 
 	return 0;
 }
@@ -306,6 +332,9 @@ int register_nvo ( struct nvo_block *nvo, struct settings *parent ) {
 					NVO_SETTINGS_NAME ) ) != 0 )
 		goto err_register;
 
+	/* Add to list of registered non-volatile option blocks */
+	list_add_tail ( &nvo->list, &nvo_blocks );
+
 	DBGC ( nvo, "NVO %p registered\n", nvo );
 	return 0;
 	
@@ -322,7 +351,29 @@ int register_nvo ( struct nvo_block *nvo, struct settings *parent ) {
  * @v nvo		Non-volatile options block
  */
 void unregister_nvo ( struct nvo_block *nvo ) {
+
+	/* Write back any unsaved changes */
+	if ( nvo->dirty && ( nvo_save ( nvo ) == 0 ) )
+		nvo->dirty = 0;
+
+	list_del ( &nvo->list );
 	unregister_settings ( &nvo->settings );
 	nvo_realloc ( nvo, 0 );
 	DBGC ( nvo, "NVO %p unregistered\n", nvo );
 }
+
+/**
+ * Write back non-volatile stored options at shutdown
+ *
+ * @v booting		System is shutting down for OS boot
+ */
+static void nvo_shutdown ( int booting __unused ) {
+
+	nvo_sync();
+}
+
+/** Non-volatile stored options startup function */
+struct startup_fn nvo_startup_fn __startup_fn ( STARTUP_NORMAL ) = {
+	.name = "nvo",
+	.shutdown = nvo_shutdown,
+};
@@ -23,9 +23,11 @@
 
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
+#include <stdio.h>
 #include <errno.h>
 #include <ipxe/process.h>
 #include <ipxe/timer.h>
+#include <ipxe/boottrace.h>
 #include <ipxe/pending.h>
 
 /** @file
@@ -37,17 +39,31 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** Total count of pending operations */
 int pending_total;
 
+/** List of currently pending operations */
+struct list_head pending_operations = LIST_HEAD_INIT ( pending_operations );
+
+/** Age of the slowest completed pending operation so far (in ticks) */
+static unsigned long pending_slowest;
+
 /**
  * Mark an operation as pending
  *
  * @v pending		Pending operation
+ * @v name		Owner name (must remain valid while pending)
  */
-void pending_get ( struct pending_operation *pending ) {
+void pending_get ( struct pending_operation *pending, const char *name ) {
+
+	/* Record owner and start time on transition to pending */
+	if ( ! pending->count ) {
+		pending->name = name;
+		pending->started = currticks();
+		list_add_tail ( &pending->list, &pending_operations );
+	}
 
 	pending->count++;
 	pending_total++;
-	DBGC ( pending, "PENDING %p incremented to %d (total %d)\n",
-	       pending, pending->count, pending_total );
+	DBGC ( pending, "PENDING %p \"%s\" incremented to %d (total %d)\n",
+	       pending, pending->name, pending->count, pending_total );
 }
 
 /**
@@ -56,11 +72,48 @@ void pending_get ( struct pending_operation *pending ) {
  * @v pending		Pending operation
  */
 void pending_put ( struct pending_operation *pending ) {
+	unsigned long age;
 
 	if ( pending->count ) {
 		pending_total--;
 		pending->count--;
-		DBGC ( pending, "PENDING %p decremented to %d (total %d)\n",
-		       pending, pending->count, pending_total );
+		DBGC ( pending, "PENDING %p \"%s\" decremented to %d "
+		       "(total %d)\n", pending, pending->name, pending->count,
+		       pending_total );
+
+		/* On transition to no longer pending, record a boot
+		 * trace marker if this was the slowest wait so far.
+		 */
+		if ( ! pending->count ) {
+			list_del ( &pending->list );
+			age = ( currticks() - pending->started );
+			if ( age > pending_slowest ) {
+				pending_slowest = age;
+				boottrace ( "Pending %s completed after "
+					    "%ld ms", pending->name,
+					    ( ( age * 1000 ) /
+					      TICKS_PER_SEC ) );
+			}
+		}
+	}
+}
+
+/**
+ * Print all currently pending operations
+ *
+ * Each waiter is shown with its owner name, pending count, and the
+ * time for which it has been continuously pending.
+ */
+void pending_show ( void ) {
+	struct pending_operation *pending;
+	unsigned long now = currticks();
+	unsigned long ms;
+
+	list_for_each_entry ( pending, &pending_operations, list ) {
+		ms = ( ( ( now - pending->started ) * 1000 ) /
+		       TICKS_PER_SEC );
+		printf ( "Pending x%d for %ld.%03lds: %s\n", pending->count,
+			 ( ms / 1000 ), ( ms % 1000 ),
+			 ( pending->name ? pending->name : "(unnamed)" ) );
 	}
 }
@@ -34,6 +34,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/open.h>
 #include <ipxe/socket.h>
 #include <ipxe/retry.h>
+#include <ipxe/timer.h>
 #include <ipxe/pinger.h>
 
 /** @file
@@ -53,6 +54,24 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define EINFO_EPROTO_SEQ __einfo_uniqify ( EINFO_EPROTO, 0x03, \
 					   "Delayed or out-of-sequence reply" )
 
+/** Number of in-flight probes tracked (must be a power of two)
+ *
+ * This limits the number of transmissions that may be outstanding at
+ * any time when the transmission interval is shorter than the
+ * response timeout.
+ */
+#define PINGER_RING_COUNT 16
+
+/** An in-flight probe */
+struct pinger_probe {
+	/** Sequence number */
+	uint16_t sequence;
+	/** Response is still awaited */
+	int awaited;
+	/** Transmission timestamp (in ticks) */
+	unsigned long started;
+};
+
 /** A pinger */
 struct pinger {
 	/** Reference count */
@@ -67,13 +86,15 @@ struct pinger {
 	struct retry_timer timer;
 	/** Timeout */
 	unsigned long timeout;
+	/** Interval between transmissions */
+	unsigned long interval;
 
 	/** Payload length */
 	size_t len;
 	/** Current sequence number */
 	uint16_t sequence;
-	/** Response for current sequence number is still pending */
-	int pending;
+	/** In-flight probes */
+	struct pinger_probe probes[PINGER_RING_COUNT];
 	/** Number of remaining expiry events (zero to continue indefinitely) */
 	unsigned int remaining;
 	/** Return status */
@@ -84,10 +105,11 @@ struct pinger {
 	 * @v src		Source socket address, or NULL
 	 * @v sequence		Sequence number
 	 * @v len		Payload length
+	 * @v rtt		Round-trip time (in ticks), if known
 	 * @v rc		Status code
 	 */
 	void ( * callback ) ( struct sockaddr *src, unsigned int sequence,
-			      size_t len, int rc );
+			      size_t len, unsigned long rtt, int rc );
 };
 
 /**
@@ -157,6 +179,23 @@ static void pinger_window_changed ( struct pinger *pinger ) {
 		start_timer_nodelay ( &pinger->timer );
 }
 
+/**
+ * Count probes still awaiting a response
+ *
+ * @v pinger		Pinger
+ * @ret awaited		Number of probes still awaiting a response
+ */
+static unsigned int pinger_awaited ( struct pinger *pinger ) {
+	unsigned int awaited = 0;
+	unsigned int i;
+
+	for ( i = 0 ; i < PINGER_RING_COUNT ; i++ ) {
+		if ( pinger->probes[i].awaited )
+			awaited++;
+	}
+	return awaited;
+}
+
 /**
  * Handle timer expiry
  *
@@ -165,13 +204,27 @@ static void pinger_window_changed ( struct pinger *pinger ) {
  */
 static void pinger_expired ( struct retry_timer *timer, int over __unused ) {
 	struct pinger *pinger = container_of ( timer, struct pinger, timer );
+	struct pinger_probe *probe;
 	struct xfer_metadata meta;
 	struct io_buffer *iobuf;
+	unsigned long now = currticks();
+	unsigned int i;
 	int rc;
 
-	/* If no response has been received, notify the callback function */
-	if ( pinger->pending && pinger->callback )
-		pinger->callback ( NULL, pinger->sequence, 0, -ETIMEDOUT );
+	/* Notify the callback function of any probes that have
+	 * exceeded the timeout without receiving a response.
+	 */
+	for ( i = 0 ; i < PINGER_RING_COUNT ; i++ ) {
+		probe = &pinger->probes[i];
+		if ( probe->awaited &&
+		     ( ( now - probe->started ) >= pinger->timeout ) ) {
+			probe->awaited = 0;
+			if ( pinger->callback ) {
+				pinger->callback ( NULL, probe->sequence, 0, 0,
+						   -ETIMEDOUT );
+			}
+		}
+	}
 
 	/* Check for termination */
 	if ( pinger->remaining && ( --pinger->remaining == 0 ) ) {
@@ -182,11 +235,26 @@ static void pinger_expired ( struct retry_timer *timer, int over __unused ) {
 	/* Increase sequence number */
 	pinger->sequence++;
 
+	/* Record in-flight probe.  If an earlier probe is still
+	 * occupying this ring slot then it can no longer be tracked:
+	 * report it as timed out.
+	 */
+	probe = &pinger->probes[ pinger->sequence & ( PINGER_RING_COUNT - 1 ) ];
+	if ( probe->awaited && pinger->callback )
+		pinger->callback ( NULL, probe->sequence, 0, 0, -ETIMEDOUT );
+	probe->sequence = pinger->sequence;
+	probe->awaited = 1;
+	probe->started = now;
+
 	/* Restart timer.  Do this before attempting to transmit, in
-	 * case the transmission attempt fails.
+	 * case the transmission attempt fails.  Use the transmission
+	 * interval while further packets remain to be sent, and the
+	 * full timeout to collect stragglers after the final
+	 * transmission.
 	 */
-	start_timer_fixed ( &pinger->timer, pinger->timeout );
-	pinger->pending = 1;
+	start_timer_fixed ( &pinger->timer,
+			    ( ( pinger->remaining == 1 ) ?
+			      pinger->timeout : pinger->interval ) );
 
 	/* Allocate I/O buffer */
 	iobuf = xfer_alloc_iob ( &pinger->xfer, pinger->len );
@@ -224,12 +292,19 @@ static int pinger_deliver ( struct pinger *pinger, struct io_buffer *iobuf,
 			    struct xfer_metadata *meta ) {
 	size_t len = iob_len ( iobuf );
 	uint16_t sequence = meta->offset;
+	struct pinger_probe *probe;
+	unsigned long rtt = 0;
+	int awaited = 0;
 	int terminate = 0;
 	int rc;
 
-	/* Clear response pending flag, if applicable */
-	if ( sequence == pinger->sequence )
-		pinger->pending = 0;
+	/* Complete in-flight probe, if applicable */
+	probe = &pinger->probes[ sequence & ( PINGER_RING_COUNT - 1 ) ];
+	if ( probe->awaited && ( probe->sequence == sequence ) ) {
+		probe->awaited = 0;
+		rtt = ( currticks() - probe->started );
+		awaited = 1;
+	}
 
 	/* Check for errors */
 	if ( len != pinger->len ) {
@@ -247,21 +322,23 @@ static int pinger_deliver ( struct pinger *pinger, struct io_buffer *iobuf,
 		DBGC ( pinger, "PINGER %p received incorrect data:\n", pinger );
 		DBGC_HDA ( pinger, 0, iobuf->data, iob_len ( iobuf ) );
 		terminate = ( pinger->remaining != 0 );
-	} else if ( sequence != pinger->sequence ) {
-		/* Incorrect sequence number (probably a delayed response):
+	} else if ( ! awaited ) {
+		/* Unexpected sequence number (probably a delayed response):
 		 * report via callback but otherwise ignore.
 		 */
-		DBGC ( pinger, "PINGER %p received sequence %d (expected %d)\n",
-		       pinger, sequence, pinger->sequence );
+		DBGC ( pinger, "PINGER %p received unexpected sequence %d\n",
+		       pinger, sequence );
 		rc = -EPROTO_SEQ;
 		terminate = 0;
 	} else {
 		/* Success: record that a packet was successfully received,
-		 * and terminate if we expect to send no further packets.
+		 * and terminate if we expect to send no further packets
+		 * and no responses remain outstanding.
 		 */
 		rc = 0;
 		pinger->rc = 0;
-		terminate = ( pinger->remaining == 1 );
+		terminate = ( ( pinger->remaining == 1 ) &&
+			      ( pinger_awaited ( pinger ) == 0 ) );
 	}
 
 	/* Discard I/O buffer */
@@ -269,7 +346,7 @@ static int pinger_deliver ( struct pinger *pinger, struct io_buffer *iobuf,
 
 	/* Notify callback function, if applicable */
 	if ( pinger->callback )
-		pinger->callback ( meta->src, sequence, len, rc );
+		pinger->callback ( meta->src, sequence, len, rtt, rc );
 
 	/* Terminate if applicable */
 	if ( terminate )
@@ -304,16 +381,18 @@ static struct interface_descriptor pinger_job_desc =
  * @v job		Job control interface
  * @v hostname		Hostname to ping
  * @v timeout		Timeout (in ticks)
+ * @v interval		Interval between transmissions (in ticks), or zero
  * @v len		Payload length
  * @v count		Number of packets to send (or zero for no limit)
  * @v callback		Callback function (or NULL)
  * @ret rc		Return status code
  */
 int create_pinger ( struct interface *job, const char *hostname,
-		    unsigned long timeout, size_t len, unsigned int count,
+		    unsigned long timeout, unsigned long interval, size_t len,
+		    unsigned int count,
 		    void ( * callback ) ( struct sockaddr *src,
 					  unsigned int sequence, size_t len,
-					  int rc ) ) {
+					  unsigned long rtt, int rc ) ) {
 	struct pinger *pinger;
 	int rc;
 
@@ -321,6 +400,10 @@ int create_pinger ( struct interface *job, const char *hostname,
 	if ( ! timeout )
 		return -EINVAL;
 
+	/* Default to sending one packet per timeout period */
+	if ( ! interval )
+		interval = timeout;
+
 	/* Allocate and initialise structure */
 	pinger = zalloc ( sizeof ( *pinger ) );
 	if ( ! pinger )
@@ -330,6 +413,7 @@ int create_pinger ( struct interface *job, const char *hostname,
 	intf_init ( &pinger->xfer, &pinger_xfer_desc, &pinger->refcnt );
 	timer_init ( &pinger->timer, pinger_expired, &pinger->refcnt );
 	pinger->timeout = timeout;
+	pinger->interval = interval;
 	pinger->len = len;
 	pinger->remaining = ( count ? ( count + 1 /* Initial packet */ ) : 0 );
 	pinger->callback = callback;
@@ -25,6 +25,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <ipxe/list.h>
 #include <ipxe/init.h>
+#include <ipxe/nap.h>
 #include <ipxe/process.h>
 
 /** @file
@@ -120,6 +121,45 @@ void step ( void ) {
 	}
 }
 
+/**
+ * Sleep until the next interrupt, if safe to do so
+ *
+ * This halts the CPU until the next interrupt, unless some component
+ * requires continuous polling (e.g. an open network device that
+ * cannot generate wakeup interrupts) or already has work due (e.g. an
+ * expired retry timer).  Interrupts will wake the CPU for both
+ * keypresses and timer ticks, so this may be used in any loop that
+ * would otherwise spin checking for input or timer expiries.
+ */
+void process_nap ( void ) {
+	struct idle_check *check;
+
+	/* Do nothing if any component requires continuous polling */
+	for_each_table_entry ( check, IDLE_CHECKS ) {
+		if ( check->busy() )
+			return;
+	}
+
+	/* Allow components to prepare for the halt (e.g. by enabling
+	 * interrupt-driven wakeups), abandoning the halt if any
+	 * component fails to prepare.
+	 */
+	for_each_table_entry ( check, IDLE_CHECKS ) {
+		if ( check->prepare && ( check->prepare() != 0 ) )
+			goto err_prepare;
+	}
+
+	/* Sleep until the next interrupt */
+	cpu_nap();
+
+ err_prepare:
+	/* Undo all successful preparations */
+	for_each_table_entry_continue_reverse ( check, IDLE_CHECKS ) {
+		if ( check->finish )
+			check->finish();
+	}
+}
+
 /**
  * Initialise processes
  *
@@ -30,6 +30,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/xfer.h>
 #include <ipxe/open.h>
 #include <ipxe/process.h>
+#include <ipxe/retry.h>
+#include <ipxe/timer.h>
 #include <ipxe/socket.h>
 #include <ipxe/resolv.h>
 
@@ -298,6 +300,15 @@ int resolv ( struct interface *resolv, const char *name,
  ***************************************************************************
  */
 
+/** Delay before probing the second resolved address (in ticks)
+ *
+ * This is the RFC 8305 ("Happy Eyeballs") connection attempt delay:
+ * the preferred (usually IPv6) address is given this much of a head
+ * start before a connection to the other address is attempted in
+ * parallel.
+ */
+#define NAMED_PROBE_INTERVAL ( TICKS_PER_SEC / 4 )
+
 /** A named socket */
 struct named_socket {
 	/** Reference counter */
@@ -312,6 +323,19 @@ struct named_socket {
 	struct sockaddr local;
 	/** Stored local socket address exists */
 	int have_local;
+
+	/** Resolved peer socket addresses, in order of preference */
+	struct sockaddr peers[2];
+	/** Number of resolved peer socket addresses */
+	unsigned int count;
+	/** Connection probe interfaces */
+	struct interface probes[2];
+	/** Connection probes started */
+	int started[2];
+	/** Connection probes failed */
+	int failed[2];
+	/** Connection probe stagger timer */
+	struct retry_timer timer;
 };
 
 /**
@@ -321,7 +345,12 @@ struct named_socket {
  * @v rc		Reason for termination
  */
 static void named_close ( struct named_socket *named, int rc ) {
+	/* Stop timer */
+	stop_timer ( &named->timer );
+
 	/* Shut down interfaces */
+	intf_shutdown ( &named->probes[0], rc );
+	intf_shutdown ( &named->probes[1], rc );
 	intf_shutdown ( &named->resolv, rc );
 	intf_shutdown ( &named->xfer, rc );
 }
@@ -349,15 +378,20 @@ static struct interface_descriptor named_xfer_desc =
 			     resolv );
 
 /**
- * Name resolved
+ * Redirect to resolved socket address
  *
  * @v named		Named socket
  * @v sa		Completed socket address
  */
-static void named_resolv_done ( struct named_socket *named,
-				struct sockaddr *sa ) {
+static void named_redirect ( struct named_socket *named,
+			     struct sockaddr *sa ) {
 	int rc;
 
+	/* Stop timer and close any remaining connection probes */
+	stop_timer ( &named->timer );
+	intf_restart ( &named->probes[0], 0 );
+	intf_restart ( &named->probes[1], 0 );
+
 	/* Nullify data transfer interface */
 	intf_nullify ( &named->xfer );
 
@@ -379,9 +413,198 @@ static void named_resolv_done ( struct named_socket *named,
 	named_close ( named, rc );
 }
 
+/**
+ * Start a connection probe
+ *
+ * @v named		Named socket
+ * @v index		Peer socket address index
+ * @ret rc		Return status code
+ */
+static int named_probe_start ( struct named_socket *named,
+			       unsigned int index ) {
+	int rc;
+
+	/* Mark probe as started */
+	named->started[index] = 1;
+
+	/* Open probe connection */
+	if ( ( rc = xfer_open_socket ( &named->probes[index], named->semantics,
+				       &named->peers[index], NULL ) ) != 0 ) {
+		DBGC ( named, "NAMED %p could not probe %s: %s\n", named,
+		       sock_ntoa ( &named->peers[index] ), strerror ( rc ) );
+		named->failed[index] = 1;
+		return rc;
+	}
+
+	DBGC ( named, "NAMED %p probing %s\n",
+	       named, sock_ntoa ( &named->peers[index] ) );
+	return 0;
+}
+
+/**
+ * Handle change of connection probe flow control window
+ *
+ * @v named		Named socket
+ * @v index		Peer socket address index
+ */
+static void named_probe_window_changed ( struct named_socket *named,
+					 unsigned int index ) {
+
+	/* Ignore updates until the connection is established */
+	if ( ! xfer_window ( &named->probes[index] ) )
+		return;
+
+	/* This connection won the race; redirect the client to the
+	 * same address.
+	 */
+	DBGC ( named, "NAMED %p %s won the race\n",
+	       named, sock_ntoa ( &named->peers[index] ) );
+	named_redirect ( named, &named->peers[index] );
+}
+
+/**
+ * Handle closure of connection probe
+ *
+ * @v named		Named socket
+ * @v index		Peer socket address index
+ * @v rc		Reason for close
+ */
+static void named_probe_closed ( struct named_socket *named,
+				 unsigned int index, int rc ) {
+	unsigned int other = ( index ^ 1 );
+
+	/* Restart interface and mark probe as failed */
+	intf_restart ( &named->probes[index], rc );
+	named->failed[index] = 1;
+	DBGC ( named, "NAMED %p probe %s failed: %s\n", named,
+	       sock_ntoa ( &named->peers[index] ), strerror ( rc ) );
+
+	/* Expedite the other probe, if not already started */
+	stop_timer ( &named->timer );
+	if ( ! named->started[other] ) {
+		if ( named_probe_start ( named, other ) == 0 )
+			return;
+	}
+
+	/* Wait for the other probe, if still running */
+	if ( ! named->failed[other] )
+		return;
+
+	/* Terminate opener if both probes have failed */
+	named_close ( named, rc );
+}
+
+/**
+ * Handle connection probe stagger timer expiry
+ *
+ * @v timer		Connection probe stagger timer
+ * @v over		Failure indicator
+ */
+static void named_expired ( struct retry_timer *timer, int over __unused ) {
+	struct named_socket *named =
+		container_of ( timer, struct named_socket, timer );
+
+	/* Start second connection probe */
+	if ( ! named->started[1] )
+		named_probe_start ( named, 1 );
+}
+
+/** Named socket opener first connection probe operations */
+static void named_probe_a_window_changed ( struct named_socket *named ) {
+	named_probe_window_changed ( named, 0 );
+}
+static void named_probe_a_closed ( struct named_socket *named, int rc ) {
+	named_probe_closed ( named, 0, rc );
+}
+static struct interface_operation named_probe_a_op[] = {
+	INTF_OP ( xfer_window_changed, struct named_socket *,
+		  named_probe_a_window_changed ),
+	INTF_OP ( intf_close, struct named_socket *, named_probe_a_closed ),
+};
+
+/** Named socket opener first connection probe interface descriptor */
+static struct interface_descriptor named_probe_a_desc =
+	INTF_DESC ( struct named_socket, probes[0], named_probe_a_op );
+
+/** Named socket opener second connection probe operations */
+static void named_probe_b_window_changed ( struct named_socket *named ) {
+	named_probe_window_changed ( named, 1 );
+}
+static void named_probe_b_closed ( struct named_socket *named, int rc ) {
+	named_probe_closed ( named, 1, rc );
+}
+static struct interface_operation named_probe_b_op[] = {
+	INTF_OP ( xfer_window_changed, struct named_socket *,
+		  named_probe_b_window_changed ),
+	INTF_OP ( intf_close, struct named_socket *, named_probe_b_closed ),
+};
+
+/** Named socket opener second connection probe interface descriptor */
+static struct interface_descriptor named_probe_b_desc =
+	INTF_DESC ( struct named_socket, probes[1], named_probe_b_op );
+
+/**
+ * Name resolved
+ *
+ * @v named		Named socket
+ * @v sa		Completed socket address
+ */
+static void named_resolv_done ( struct named_socket *named,
+				struct sockaddr *sa ) {
+
+	/* Store socket address, if space remains.  A resolver may
+	 * report more than one address (e.g. both an IPv6 and an IPv4
+	 * address for a dual-stack name); redirection is deferred
+	 * until resolution completes.
+	 */
+	if ( named->count < ( sizeof ( named->peers ) /
+			      sizeof ( named->peers[0] ) ) ) {
+		memcpy ( &named->peers[named->count], sa,
+			 sizeof ( named->peers[0] ) );
+		named->count++;
+	}
+}
+
+/**
+ * Handle completion of name resolution
+ *
+ * @v named		Named socket
+ * @v rc		Reason for close
+ */
+static void named_resolv_close ( struct named_socket *named, int rc ) {
+
+	/* Terminate opener if resolution failed or found no address */
+	if ( ( rc != 0 ) || ( named->count == 0 ) ) {
+		named_close ( named, rc );
+		return;
+	}
+
+	/* Shut down resolver interface */
+	intf_shutdown ( &named->resolv, rc );
+
+	/* Race staggered connection probes if multiple addresses were
+	 * resolved (RFC 8305 "Happy Eyeballs"), redirecting the
+	 * client to whichever address completes a connection first.
+	 * This avoids waiting out a full TCP retry cycle when the
+	 * preferred address family's path is broken.
+	 */
+	if ( ( named->count > 1 ) && ( named->semantics == SOCK_STREAM ) ) {
+		if ( named_probe_start ( named, 0 ) == 0 ) {
+			start_timer_fixed ( &named->timer,
+					    NAMED_PROBE_INTERVAL );
+			return;
+		}
+		if ( named_probe_start ( named, 1 ) == 0 )
+			return;
+	}
+
+	/* Otherwise, redirect immediately to the preferred address */
+	named_redirect ( named, &named->peers[0] );
+}
+
 /** Named socket opener resolver interface operations */
 static struct interface_operation named_resolv_op[] = {
-	INTF_OP ( intf_close, struct named_socket *, named_close ),
+	INTF_OP ( intf_close, struct named_socket *, named_resolv_close ),
 	INTF_OP ( resolv_done, struct named_socket *, named_resolv_done ),
 };
 
@@ -412,6 +635,9 @@ int xfer_open_named_socket ( struct interface *xfer, int semantics,
 	ref_init ( &named->refcnt, NULL );
 	intf_init ( &named->xfer, &named_xfer_desc, &named->refcnt );
 	intf_init ( &named->resolv, &named_resolv_desc, &named->refcnt );
+	intf_init ( &named->probes[0], &named_probe_a_desc, &named->refcnt );
+	intf_init ( &named->probes[1], &named_probe_b_desc, &named->refcnt );
+	timer_init ( &named->timer, named_expired, &named->refcnt );
 	named->semantics = semantics;
 	if ( local ) {
 		memcpy ( &named->local, local, sizeof ( named->local ) );
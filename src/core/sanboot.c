@@ -38,6 +38,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/open.h>
 #include <ipxe/timer.h>
 #include <ipxe/process.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/umalloc.h>
 #include <ipxe/iso9660.h>
 #include <ipxe/dhcp.h>
 #include <ipxe/settings.h>
@@ -85,6 +87,35 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 #define SAN_REOPEN_DELAY_SECS 5
 
+/** Number of blocks in each read cache extent
+ *
+ * This is the number of (exposed) logical blocks fetched from the
+ * SAN target in a single command when filling a cache extent.  Boot
+ * loaders and OS early-boot code tend to issue long runs of small
+ * reads with strong locality, each of which would otherwise cost a
+ * full network round trip.
+ *
+ * This is a policy decision.
+ */
+#define SAN_READAHEAD_COUNT 256
+
+/** Number of consecutive sequential reads required to trigger read-ahead
+ *
+ * This is a policy decision.
+ */
+#define SAN_READAHEAD_THRESHOLD 4
+
+/** Maximum length of a read serviced via the cache
+ *
+ * Reads of at most this many blocks that miss the cache are serviced
+ * by filling a cache extent and copying out the requested range, on
+ * the assumption that nearby blocks will be wanted soon.  Longer
+ * reads are transferred directly into the caller's buffer.
+ *
+ * This is a policy decision.
+ */
+#define SAN_CACHE_READ_MAX 16
+
 /** List of SAN devices */
 LIST_HEAD ( san_devices );
 
@@ -124,6 +155,8 @@ static void sandev_free ( struct refcnt *refcnt ) {
 		uri_put ( sandev->path[i].uri );
 		assert ( sandev->path[i].desc == NULL );
 	}
+	if ( sandev->cache )
+		ufree ( sandev->cache );
 	free ( sandev );
 }
 
@@ -182,6 +215,82 @@ static void sandev_command_expired ( struct retry_timer *timer,
 	sandev_command_close ( sandev, -ETIMEDOUT );
 }
 
+/**
+ * Terminate prefetch command
+ *
+ * @v sandev		SAN device
+ * @v rc		Reason for termination
+ *
+ * On success, the prefetched data is committed to its cache extent.
+ * Prefetch failures are nonfatal: the data will simply be read on
+ * demand instead.
+ */
+static void sandev_prefetch_close ( struct san_device *sandev, int rc ) {
+	struct san_cache_extent *extent;
+
+	/* Ignore if no prefetch is in progress */
+	if ( ! sandev->prefetching )
+		return;
+
+	/* Stop timer */
+	stop_timer ( &sandev->prefetch_timer );
+
+	/* Restart interface */
+	intf_restart ( &sandev->prefetch, rc );
+
+	/* Record status and mark prefetch as complete */
+	sandev->prefetch_rc = rc;
+	sandev->prefetching = 0;
+
+	/* Commit cache extent on success */
+	if ( rc == 0 ) {
+		extent = &sandev->cache_extent[sandev->prefetch_extent];
+		extent->lba = sandev->prefetch_lba;
+		extent->count = sandev->prefetch_count;
+		DBGC ( sandev, "SAN %#02x prefetched [%#08llx,%#08llx)\n",
+		       sandev->drive,
+		       ( ( unsigned long long ) sandev->prefetch_lba ),
+		       ( ( unsigned long long )
+			 ( sandev->prefetch_lba + sandev->prefetch_count ) ) );
+	} else {
+		DBGC ( sandev, "SAN %#02x prefetch failed: %s\n",
+		       sandev->drive, strerror ( rc ) );
+	}
+}
+
+/** SAN device prefetch interface operations */
+static struct interface_operation sandev_prefetch_op[] = {
+	INTF_OP ( intf_close, struct san_device *, sandev_prefetch_close ),
+};
+
+/** SAN device prefetch interface descriptor */
+static struct interface_descriptor sandev_prefetch_desc =
+	INTF_DESC ( struct san_device, prefetch, sandev_prefetch_op );
+
+/**
+ * Handle prefetch command timeout
+ *
+ * @v retry		Retry timer
+ */
+static void sandev_prefetch_expired ( struct retry_timer *timer,
+				      int over __unused ) {
+	struct san_device *sandev =
+		container_of ( timer, struct san_device, prefetch_timer );
+
+	sandev_prefetch_close ( sandev, -ETIMEDOUT );
+}
+
+/**
+ * Wait for any in-progress prefetch to complete
+ *
+ * @v sandev		SAN device
+ */
+static void sandev_prefetch_wait ( struct san_device *sandev ) {
+
+	while ( sandev->prefetching )
+		step();
+}
+
 /**
  * Open SAN path
  *
@@ -232,6 +341,7 @@ static int sanpath_open ( struct san_path *sanpath ) {
  */
 static void sanpath_close ( struct san_path *sanpath, int rc ) {
 	struct san_device *sandev = sanpath->sandev;
+	struct san_path *other;
 
 	/* Record status */
 	sanpath->path_rc = rc;
@@ -245,9 +355,22 @@ static void sanpath_close ( struct san_path *sanpath, int rc ) {
 
 	/* Restart interfaces, avoiding potential loops */
 	if ( sanpath == sandev->active ) {
-		intfs_restart ( rc, &sandev->command, &sanpath->block, NULL );
+		intfs_restart ( rc, &sandev->command, &sandev->prefetch,
+				&sanpath->block, NULL );
 		sandev->active = NULL;
 		sandev_command_close ( sandev, rc );
+		sandev_prefetch_close ( sandev, rc );
+		/* Fail over immediately to another available path,
+		 * if any, thereby avoiding a reconnection delay.
+		 */
+		list_for_each_entry ( other, &sandev->opened, list ) {
+			if ( other->path_rc != 0 )
+				continue;
+			DBGC ( sandev, "SAN %#02x.%d is active\n",
+			       sandev->drive, other->index );
+			sandev->active = other;
+			break;
+		}
 	} else {
 		intf_restart ( &sanpath->block, rc );
 	}
@@ -294,8 +417,8 @@ static size_t sanpath_block_window ( struct san_path *sanpath __unused ) {
 static void sanpath_step ( struct san_path *sanpath ) {
 	struct san_device *sandev = sanpath->sandev;
 
-	/* Ignore if we are already the active device */
-	if ( sanpath == sandev->active )
+	/* Ignore if path has already become available */
+	if ( sanpath->path_rc != -EINPROGRESS )
 		return;
 
 	/* Wait until path has become available */
@@ -305,7 +428,9 @@ static void sanpath_step ( struct san_path *sanpath ) {
 	/* Record status */
 	sanpath->path_rc = 0;
 
-	/* Mark as active path or close as applicable */
+	/* Mark as active path if none exists.  Additional paths
+	 * remain open and are used in rotation by sandev_select().
+	 */
 	if ( ! sandev->active ) {
 		DBGC ( sandev, "SAN %#02x.%d is active\n",
 		       sandev->drive, sanpath->index );
@@ -313,7 +438,6 @@ static void sanpath_step ( struct san_path *sanpath ) {
 	} else {
 		DBGC ( sandev, "SAN %#02x.%d is available\n",
 		       sandev->drive, sanpath->index );
-		sanpath_close ( sanpath, 0 );
 	}
 }
 
@@ -350,8 +474,9 @@ static void sandev_restart ( struct san_device *sandev, int rc ) {
 	/* Clear active path */
 	sandev->active = NULL;
 
-	/* Close any outstanding command */
+	/* Close any outstanding commands */
 	sandev_command_close ( sandev, rc );
+	sandev_prefetch_close ( sandev, rc );
 }
 
 /**
@@ -433,6 +558,35 @@ union san_command_params {
 	struct san_command_rw_params rw;
 };
 
+/**
+ * Select SAN path for next command
+ *
+ * @v sandev		SAN device
+ * @ret sanpath		SAN path
+ *
+ * Commands are distributed in round-robin order across all available
+ * paths, so that a multipath device aggregates the bandwidth of all
+ * of its portals rather than using additional paths only as spares.
+ */
+static struct san_path * sandev_select ( struct san_device *sandev ) {
+	struct san_path *sanpath;
+
+	/* Rotate to the next available path with an open window */
+	list_for_each_entry ( sanpath, &sandev->opened, list ) {
+		if ( sanpath->path_rc != 0 )
+			continue;
+		if ( ! xfer_window ( &sanpath->block ) )
+			continue;
+		list_del ( &sanpath->list );
+		list_add_tail ( &sanpath->list, &sandev->opened );
+		sandev->active = sanpath;
+		return sanpath;
+	}
+
+	/* Fall back to the current active path */
+	return sandev->active;
+}
+
 /**
  * Initiate SAN device read/write command
  *
@@ -442,7 +596,7 @@ union san_command_params {
  */
 static int sandev_command_rw ( struct san_device *sandev,
 			       const union san_command_params *params ) {
-	struct san_path *sanpath = sandev->active;
+	struct san_path *sanpath = sandev_select ( sandev );
 	size_t len = ( params->rw.count * sandev->capacity.blksize );
 	int rc;
 
@@ -471,7 +625,7 @@ static int sandev_command_rw ( struct san_device *sandev,
 static int
 sandev_command_read_capacity ( struct san_device *sandev,
 			       const union san_command_params *params __unused){
-	struct san_path *sanpath = sandev->active;
+	struct san_path *sanpath = sandev_select ( sandev );
 	int rc;
 
 	/* Sanity check */
@@ -624,6 +778,222 @@ static int sandev_rw ( struct san_device *sandev, uint64_t lba,
 	return 0;
 }
 
+/**
+ * Get read cache extent buffer
+ *
+ * @v sandev		SAN device
+ * @v index		Extent index
+ * @ret buffer		Extent buffer
+ */
+static userptr_t sandev_cache_buffer ( struct san_device *sandev,
+				       unsigned int index ) {
+	size_t extent_len = ( SAN_READAHEAD_COUNT * sandev_blksize ( sandev ));
+
+	return userptr_add ( sandev->cache, ( index * extent_len ) );
+}
+
+/**
+ * Find a cache extent containing a range in its entirety
+ *
+ * @v sandev		SAN device
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @ret extent		Cache extent, or NULL
+ */
+static struct san_cache_extent *
+sandev_cache_find ( struct san_device *sandev, uint64_t lba,
+		    unsigned int count ) {
+	struct san_cache_extent *extent;
+	unsigned int i;
+
+	for ( i = 0 ; i < SAN_CACHE_EXTENTS ; i++ ) {
+		extent = &sandev->cache_extent[i];
+		if ( ( lba >= extent->lba ) &&
+		     ( ( lba + count ) <= ( extent->lba + extent->count ) ) ) {
+			return extent;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Attempt to serve a read from the read cache
+ *
+ * @v sandev		SAN device
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @ret rc		Return status code
+ */
+static int sandev_cache_read ( struct san_device *sandev, uint64_t lba,
+			       unsigned int count, userptr_t buffer ) {
+	size_t blksize = sandev_blksize ( sandev );
+	struct san_cache_extent *extent;
+	unsigned int i;
+	uint64_t offset;
+
+	/* Look for an extent containing the range in its entirety */
+	extent = sandev_cache_find ( sandev, lba, count );
+	if ( ! extent )
+		return -ENOENT;
+
+	/* Copy out data */
+	i = ( extent - sandev->cache_extent );
+	offset = ( ( lba - extent->lba ) * blksize );
+	memcpy_user ( buffer, 0, sandev_cache_buffer ( sandev, i ),
+		      offset, ( count * blksize ) );
+	DBGC2 ( sandev, "SAN %#02x cache hit [%#08llx,%#08llx)\n",
+		sandev->drive, ( ( unsigned long long ) lba ),
+		( ( unsigned long long ) ( lba + count ) ) );
+	return 0;
+}
+
+/**
+ * Fill a read cache extent
+ *
+ * @v sandev		SAN device
+ * @v lba		Starting logical block address
+ * @ret rc		Return status code
+ */
+static int sandev_cache_fill ( struct san_device *sandev, uint64_t lba ) {
+	uint64_t blocks = sandev_capacity ( sandev );
+	unsigned int count = SAN_READAHEAD_COUNT;
+	struct san_cache_extent *extent;
+	int rc;
+
+	/* Allocate cache buffer, if not already allocated */
+	if ( ! sandev->cache ) {
+		sandev->cache = umalloc ( SAN_CACHE_EXTENTS *
+					  SAN_READAHEAD_COUNT *
+					  sandev_blksize ( sandev ) );
+		if ( ! sandev->cache )
+			return -ENOMEM;
+	}
+
+	/* Truncate fill at end of device */
+	if ( lba >= blocks )
+		return 0;
+	if ( count > ( blocks - lba ) )
+		count = ( blocks - lba );
+
+	/* Evict extents in round-robin order, and invalidate the
+	 * victim while it is being refilled.
+	 */
+	extent = &sandev->cache_extent[sandev->cache_victim];
+	extent->count = 0;
+
+	/* Read from device into extent */
+	if ( ( rc = sandev_rw ( sandev, lba, count,
+				sandev_cache_buffer ( sandev,
+						      sandev->cache_victim ),
+				block_read ) ) != 0 )
+		return rc;
+	extent->lba = lba;
+	extent->count = count;
+	sandev->cache_victim = ( ( sandev->cache_victim + 1 ) %
+				 SAN_CACHE_EXTENTS );
+	DBGC ( sandev, "SAN %#02x cache fill [%#08llx,%#08llx)\n",
+	       sandev->drive, ( ( unsigned long long ) lba ),
+	       ( ( unsigned long long ) ( lba + count ) ) );
+
+	return 0;
+}
+
+/**
+ * Start filling a cache extent in the background
+ *
+ * @v sandev		SAN device
+ * @v lba		Starting logical block address
+ *
+ * Initiate a read into a cache extent without waiting for it to
+ * complete, so that the next extent of a sequential stream transfers
+ * while the current extent is being consumed.  Failure to start a
+ * prefetch is nonfatal and silently ignored; the data will be read
+ * on demand instead.
+ */
+static void sandev_prefetch_start ( struct san_device *sandev, uint64_t lba ) {
+	uint64_t blocks = sandev_capacity ( sandev );
+	unsigned int count = SAN_READAHEAD_COUNT;
+	struct san_cache_extent *extent;
+	struct san_path *sanpath;
+	unsigned int index;
+	size_t len;
+	int rc;
+
+	/* Ignore if a prefetch is already in progress */
+	if ( sandev->prefetching )
+		return;
+
+	/* Ignore unless the cache buffer has been allocated */
+	if ( ! sandev->cache )
+		return;
+
+	/* Truncate fill at end of device; ignore if nothing remains */
+	if ( lba >= blocks )
+		return;
+	if ( count > ( blocks - lba ) )
+		count = ( blocks - lba );
+
+	/* Ignore if the extent would need to be fragmented */
+	if ( ( count << sandev->blksize_shift ) > sandev->capacity.max_count )
+		return;
+
+	/* Ignore if the start of the range is already cached */
+	if ( sandev_cache_find ( sandev, lba, 1 ) )
+		return;
+
+	/* Ignore unless the device is usable without reopening */
+	if ( sandev_needs_reopen ( sandev ) )
+		return;
+	sanpath = sandev_select ( sandev );
+	if ( ! sanpath )
+		return;
+
+	/* Evict victim extent, and invalidate it while it is being
+	 * refilled.
+	 */
+	index = sandev->cache_victim;
+	extent = &sandev->cache_extent[index];
+	extent->count = 0;
+	sandev->cache_victim = ( ( index + 1 ) % SAN_CACHE_EXTENTS );
+
+	/* Initiate read into extent */
+	len = ( ( count << sandev->blksize_shift ) *
+		sandev->capacity.blksize );
+	if ( ( rc = block_read ( &sanpath->block, &sandev->prefetch,
+				 ( lba << sandev->blksize_shift ),
+				 ( count << sandev->blksize_shift ),
+				 sandev_cache_buffer ( sandev, index ),
+				 len ) ) != 0 ) {
+		DBGC ( sandev, "SAN %#02x.%d could not initiate prefetch: "
+		       "%s\n", sandev->drive, sanpath->index, strerror ( rc ) );
+		return;
+	}
+
+	/* Record prefetch and start expiry timer */
+	sandev->prefetching = 1;
+	sandev->prefetch_lba = lba;
+	sandev->prefetch_count = count;
+	sandev->prefetch_extent = index;
+	start_timer_fixed ( &sandev->prefetch_timer, SAN_COMMAND_TIMEOUT );
+	DBGC2 ( sandev, "SAN %#02x prefetching [%#08llx,%#08llx)\n",
+		sandev->drive, ( ( unsigned long long ) lba ),
+		( ( unsigned long long ) ( lba + count ) ) );
+}
+
+/**
+ * Invalidate the read cache
+ *
+ * @v sandev		SAN device
+ */
+static void sandev_cache_invalidate ( struct san_device *sandev ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < SAN_CACHE_EXTENTS ; i++ )
+		sandev->cache_extent[i].count = 0;
+	sandev->cache_sequential = 0;
+}
+
 /**
  * Read from SAN device
  *
@@ -635,12 +1005,93 @@ static int sandev_rw ( struct san_device *sandev, uint64_t lba,
  */
 int sandev_read ( struct san_device *sandev, uint64_t lba,
 		  unsigned int count, userptr_t buffer ) {
+	struct san_cache_extent *extent;
 	int rc;
 
+	/* Track sequential read streams */
+	if ( lba == sandev->cache_next ) {
+		sandev->cache_sequential++;
+	} else {
+		sandev->cache_sequential = 0;
+	}
+	sandev->cache_next = ( lba + count );
+
+	/* Wait for any in-progress prefetch covering the requested
+	 * range, so that it can be served from the cache.
+	 */
+	if ( sandev->prefetching &&
+	     ( lba >= sandev->prefetch_lba ) &&
+	     ( ( lba + count ) <=
+	       ( sandev->prefetch_lba + sandev->prefetch_count ) ) ) {
+		sandev_prefetch_wait ( sandev );
+	}
+
+	/* Serve from read cache, if possible */
+	if ( sandev_cache_read ( sandev, lba, count, buffer ) == 0 ) {
+
+		/* Advance any in-progress prefetch.  Nothing else
+		 * polls the network between externally issued reads;
+		 * stepping here lets the loader's own request stream
+		 * drive the background transfer forwards.
+		 */
+		if ( sandev->prefetching ) {
+			step();
+			return 0;
+		}
+
+		/* Chain a prefetch of the following extent while the
+		 * current extent is being consumed.
+		 */
+		if ( sandev->cache_sequential >= SAN_READAHEAD_THRESHOLD ) {
+			extent = sandev_cache_find ( sandev, lba, count );
+			assert ( extent != NULL );
+			sandev_prefetch_start ( sandev, ( extent->lba +
+							  extent->count ) );
+		}
+		return 0;
+	}
+
+	/* The requested range must be read from the device.  Wait out
+	 * any in-progress prefetch first: transports with a
+	 * single-command model cannot accept a second concurrent
+	 * command.
+	 */
+	sandev_prefetch_wait ( sandev );
+
+	/* Service short reads by filling a cache extent and copying
+	 * out the requested range.  Early-boot code issues very large
+	 * numbers of short reads with strong locality; batching these
+	 * into extent-sized reads collapses the number of network
+	 * round trips by around two orders of magnitude.  Any failure
+	 * (including a failure to allocate the cache buffer) is
+	 * nonfatal; fall through to reading directly.
+	 */
+	if ( ( count <= SAN_CACHE_READ_MAX ) &&
+	     ( ( sandev_cache_fill ( sandev, lba ) ) == 0 ) &&
+	     ( sandev_cache_read ( sandev, lba, count, buffer ) == 0 ) ) {
+
+		/* Chain a background prefetch of the following extent */
+		if ( sandev->cache_sequential >= SAN_READAHEAD_THRESHOLD ) {
+			sandev_prefetch_start ( sandev, ( lba +
+							  SAN_READAHEAD_COUNT ) );
+		}
+		return 0;
+	}
+
 	/* Read from device */
 	if ( ( rc = sandev_rw ( sandev, lba, count, buffer, block_read ) ) != 0 )
 		return rc;
 
+	/* Read ahead if a sequential stream is established.  The
+	 * requested range has already been read directly into the
+	 * caller's buffer; read ahead only the following blocks, so
+	 * that requested data is never copied via the cache.  The
+	 * read-ahead transfers in the background while subsequent
+	 * reads are served.
+	 */
+	if ( sandev->cache_sequential >= SAN_READAHEAD_THRESHOLD )
+		sandev_prefetch_start ( sandev, ( lba + count ) );
+
 	return 0;
 }
 
@@ -657,6 +1108,14 @@ int sandev_write ( struct san_device *sandev, uint64_t lba,
 		   unsigned int count, userptr_t buffer ) {
 	int rc;
 
+	/* Cancel any in-progress prefetch and invalidate the read
+	 * cache.  Writes during boot are rare enough that
+	 * discriminating against overlapping extents is not
+	 * worthwhile.
+	 */
+	sandev_prefetch_close ( sandev, -ECANCELED );
+	sandev_cache_invalidate ( sandev );
+
 	/* Write to device */
 	if ( ( rc = sandev_rw ( sandev, lba, count, buffer, block_write ) ) != 0 )
 		return rc;
@@ -837,6 +1296,10 @@ struct san_device * alloc_sandev ( struct uri **uris, unsigned int count,
 	ref_init ( &sandev->refcnt, sandev_free );
 	intf_init ( &sandev->command, &sandev_command_desc, &sandev->refcnt );
 	timer_init ( &sandev->timer, sandev_command_expired, &sandev->refcnt );
+	intf_init ( &sandev->prefetch, &sandev_prefetch_desc,
+		    &sandev->refcnt );
+	timer_init ( &sandev->prefetch_timer, sandev_prefetch_expired,
+		     &sandev->refcnt );
 	sandev->priv = ( ( ( void * ) sandev ) + size );
 	sandev->paths = count;
 	INIT_LIST_HEAD ( &sandev->opened );
@@ -32,6 +32,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stddef.h>
 #include <string.h>
 #include <ipxe/init.h>
+#include <ipxe/process.h>
 #include <ipxe/uart.h>
 #include <ipxe/console.h>
 #include <ipxe/serial.h>
@@ -68,6 +69,55 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** Serial console UART */
 struct uart serial_console;
 
+/** Serial console transmit buffer length
+ *
+ * Output is buffered so that a slow UART does not block the caller:
+ * characters are queued here and drained in the background as the
+ * transmitter becomes ready.  The buffer is sized to absorb a
+ * typical burst of debug output; only sustained output in excess of
+ * the line rate will block.  Must be a power of two.
+ */
+#define SERIAL_BUFFER_LEN 4096
+
+/** Serial console transmit buffer */
+static uint8_t serial_buffer[SERIAL_BUFFER_LEN];
+
+/** Serial console transmit buffer producer counter */
+static unsigned int serial_prod;
+
+/** Serial console transmit buffer consumer counter */
+static unsigned int serial_cons;
+
+/**
+ * Get serial console transmit buffer fill level
+ *
+ * @ret fill		Fill level
+ */
+static inline size_t serial_fill ( void ) {
+
+	return ( serial_prod - serial_cons );
+}
+
+/**
+ * Drain serial console transmit buffer, without blocking
+ *
+ */
+static void serial_drain ( void ) {
+	uint8_t lsr;
+
+	/* Transmit queued characters for as long as the transmitter
+	 * holding register is empty
+	 */
+	while ( serial_fill() ) {
+		lsr = uart_read ( &serial_console, UART_LSR );
+		if ( ! ( lsr & UART_LSR_THRE ) )
+			break;
+		uart_write ( &serial_console, UART_THR,
+			     serial_buffer[ serial_cons++ %
+					    SERIAL_BUFFER_LEN ] );
+	}
+}
+
 /**
  * Print a character to serial console
  *
@@ -79,10 +129,40 @@ static void serial_putchar ( int character ) {
 	if ( ! serial_console.base )
 		return;
 
-	/* Transmit character */
-	uart_transmit ( &serial_console, character );
+	/* If the buffer is full, fall back to transmitting
+	 * synchronously at the line rate
+	 */
+	while ( serial_fill() >= SERIAL_BUFFER_LEN ) {
+		uart_transmit ( &serial_console,
+				serial_buffer[ serial_cons++ %
+					       SERIAL_BUFFER_LEN ] );
+	}
+
+	/* Queue character */
+	serial_buffer[ serial_prod++ % SERIAL_BUFFER_LEN ] = character;
+
+	/* Transmit immediately if the transmitter is idle */
+	serial_drain();
 }
 
+/**
+ * Serial console background transmit process
+ *
+ * @v process		Serial console process
+ */
+static void serial_step ( struct process *process __unused ) {
+
+	/* Do nothing if we have no UART */
+	if ( ! serial_console.base )
+		return;
+
+	/* Drain transmit buffer */
+	serial_drain();
+}
+
+/** Serial console process */
+PERMANENT_PROCESS ( serial_process, serial_step );
+
 /**
  * Get character from serial console
  *
@@ -168,6 +248,13 @@ static void serial_shutdown ( int flags __unused ) {
 	if ( ! serial_console.base )
 		return;
 
+	/* Drain transmit buffer */
+	while ( serial_fill() ) {
+		uart_transmit ( &serial_console,
+				serial_buffer[ serial_cons++ %
+					       SERIAL_BUFFER_LEN ] );
+	}
+
 	/* Flush any pending output */
 	uart_flush ( &serial_console );
 
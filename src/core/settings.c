@@ -44,6 +44,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/pci.h>
 #include <ipxe/init.h>
 #include <ipxe/version.h>
+#include <ipxe/timer.h>
 #include <ipxe/settings.h>
 
 /** @file
@@ -52,6 +53,14 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/** Settings generation counter
+ *
+ * This is incremented whenever a setting is stored or the settings
+ * block hierarchy changes, and is used to invalidate cached formatted
+ * setting values.
+ */
+unsigned int settings_generation;
+
 /******************************************************************************
  *
  * Generic settings blocks
@@ -224,6 +233,165 @@ struct settings_operations generic_settings_operations = {
 	.clear = generic_settings_clear,
 };
 
+/******************************************************************************
+ *
+ * Predefined setting index
+ *
+ ******************************************************************************
+ */
+
+/** Number of predefined setting index hash buckets */
+#define SETTING_INDEX_BUCKETS 32
+
+/** A predefined setting index entry */
+struct setting_index_entry {
+	/** Predefined setting */
+	struct setting *setting;
+	/** Next entry within name hash chain */
+	struct setting_index_entry *next_name;
+	/** Next entry within tag hash chain */
+	struct setting_index_entry *next_tag;
+};
+
+/** Predefined setting index entries (one per predefined setting)
+ *
+ * The predefined settings table is fixed at link time, so the index
+ * is built once on first use and never invalidated.
+ */
+static struct setting_index_entry *setting_index_entries;
+
+/** Predefined setting name hash buckets */
+static struct setting_index_entry *setting_index_names[SETTING_INDEX_BUCKETS];
+
+/** Predefined setting tag hash buckets */
+static struct setting_index_entry *setting_index_tags[SETTING_INDEX_BUCKETS];
+
+/**
+ * Calculate setting name hash bucket
+ *
+ * @v name		Setting name
+ * @ret bucket		Hash bucket index
+ */
+static unsigned int setting_index_name_hash ( const char *name ) {
+	unsigned int hash = 0;
+
+	while ( *name )
+		hash = ( ( hash * 31 ) + *(name++) );
+	return ( hash % SETTING_INDEX_BUCKETS );
+}
+
+/**
+ * Calculate setting tag hash bucket
+ *
+ * @v tag		Setting tag
+ * @ret bucket		Hash bucket index
+ */
+static unsigned int setting_index_tag_hash ( uint64_t tag ) {
+	return ( ( tag ^ ( tag >> 32 ) ) % SETTING_INDEX_BUCKETS );
+}
+
+/**
+ * Build predefined setting index
+ *
+ * @ret rc		Return status code
+ */
+static int setting_index_build ( void ) {
+	struct setting *start = table_start ( SETTINGS );
+	struct setting *setting;
+	struct setting_index_entry *entries;
+	struct setting_index_entry *entry;
+	unsigned int count = table_num_entries ( SETTINGS );
+	unsigned int bucket;
+
+	/* Allocate one index entry per predefined setting */
+	entries = malloc ( count * sizeof ( *entries ) );
+	if ( ! entries )
+		return -ENOMEM;
+
+	/* Add entries to hash chains.  Iterate backwards and insert
+	 * at the chain heads, so that chains preserve table order and
+	 * lookups return the same entry as a linear search would.
+	 */
+	entry = entries;
+	for ( setting = ( table_end ( SETTINGS ) - 1 ) ;
+	      setting >= start ; setting-- ) {
+		entry->setting = setting;
+		bucket = setting_index_name_hash ( setting->name );
+		entry->next_name = setting_index_names[bucket];
+		setting_index_names[bucket] = entry;
+		entry->next_tag = NULL;
+		if ( setting->tag ) {
+			bucket = setting_index_tag_hash ( setting->tag );
+			entry->next_tag = setting_index_tags[bucket];
+			setting_index_tags[bucket] = entry;
+		}
+		entry++;
+	}
+
+	/* Record index as built */
+	setting_index_entries = entries;
+
+	return 0;
+}
+
+/**
+ * Find first matching predefined setting
+ *
+ * @v setting		Setting to match against
+ * @v settings		Settings block to check applicability, or NULL
+ * @ret predefined	Matching predefined setting, or NULL
+ *
+ * Searches the predefined settings for an entry matching the given
+ * setting (by tag or by name, as per setting_cmp()) and, if a
+ * settings block is specified, applicable to that block.
+ */
+static struct setting *
+setting_index_match ( const struct setting *setting,
+		      struct settings *settings ) {
+	struct setting_index_entry *entry;
+	struct setting *predefined;
+	unsigned int bucket;
+
+	/* Fall back to a linear search if the index cannot be built */
+	if ( ( ! setting_index_entries ) && ( setting_index_build() != 0 ) ) {
+		for_each_table_entry ( predefined, SETTINGS ) {
+			if ( ( setting_cmp ( setting, predefined ) == 0 ) &&
+			     ( ( ! settings ) ||
+			       setting_applies ( settings, predefined ) ) )
+				return predefined;
+		}
+		return NULL;
+	}
+
+	/* Search tag hash chain, if setting has a tag */
+	if ( setting->tag ) {
+		bucket = setting_index_tag_hash ( setting->tag );
+		for ( entry = setting_index_tags[bucket] ; entry ;
+		      entry = entry->next_tag ) {
+			predefined = entry->setting;
+			if ( ( setting_cmp ( setting, predefined ) == 0 ) &&
+			     ( ( ! settings ) ||
+			       setting_applies ( settings, predefined ) ) )
+				return predefined;
+		}
+	}
+
+	/* Search name hash chain, if setting has a name */
+	if ( setting->name && setting->name[0] ) {
+		bucket = setting_index_name_hash ( setting->name );
+		for ( entry = setting_index_names[bucket] ; entry ;
+		      entry = entry->next_name ) {
+			predefined = entry->setting;
+			if ( ( setting_cmp ( setting, predefined ) == 0 ) &&
+			     ( ( ! settings ) ||
+			       setting_applies ( settings, predefined ) ) )
+				return predefined;
+		}
+	}
+
+	return NULL;
+}
+
 /******************************************************************************
  *
  * Registered settings blocks
@@ -492,6 +660,7 @@ int register_settings ( struct settings *settings, struct settings *parent,
 	ref_get ( parent->refcnt );
 	settings->parent = parent;
 	list_add_tail ( &settings->siblings, &parent->children );
+	settings_generation++;
 	DBGC ( settings, "Settings %p (\"%s\") registered\n",
 	       settings, settings_name ( settings ) );
 
@@ -525,6 +694,7 @@ void unregister_settings ( struct settings *settings ) {
 	ref_put ( settings->parent->refcnt );
 	settings->parent = NULL;
 	list_del ( &settings->siblings );
+	settings_generation++;
 	ref_put ( settings->refcnt );
 
 	/* Apply potentially-updated settings */
@@ -585,20 +755,13 @@ int setting_applies ( struct settings *settings,
  */
 static const struct setting *
 applicable_setting ( struct settings *settings, const struct setting *setting ){
-	const struct setting *applicable;
 
 	/* If setting is already applicable, use it */
 	if ( setting_applies ( settings, setting ) )
 		return setting;
 
 	/* Otherwise, look for a matching predefined setting which does apply */
-	for_each_table_entry ( applicable, SETTINGS ) {
-		if ( ( setting_cmp ( setting, applicable ) == 0 ) &&
-		     ( setting_applies ( settings, applicable ) ) )
-			return applicable;
-	}
-
-	return NULL;
+	return setting_index_match ( setting, settings );
 }
 
 /**
@@ -629,6 +792,7 @@ int store_setting ( struct settings *settings, const struct setting *setting,
 	if ( ( rc = settings->op->store ( settings, setting,
 					  data, len ) ) != 0 )
 		return rc;
+	settings_generation++;
 
 	/* Reprioritise settings if necessary */
 	if ( setting_cmp ( setting, &priority_setting ) == 0 )
@@ -824,6 +988,109 @@ int fetch_raw_setting_copy ( struct settings *settings,
 	return fetch_setting_copy ( settings, setting, NULL, NULL, data );
 }
 
+/**
+ * Fetch multiple settings from within a settings block hierarchy
+ *
+ * @v settings		Settings block
+ * @v fetches		Bulk fetch list
+ * @v count		Number of entries in bulk fetch list
+ * @ret pending		Number of entries remaining unfetched
+ */
+static unsigned int fetch_setting_bulk ( struct settings *settings,
+					 struct settings_fetch *fetches,
+					 unsigned int count ) {
+	const struct setting *applicable;
+	struct settings *child;
+	struct settings_fetch *fetch;
+	struct setting tmp;
+	unsigned int pending = 0;
+	unsigned int i;
+	int len;
+	int check_len;
+
+	/* Find target settings block */
+	settings = settings_target ( settings );
+
+	/* Try this block first for each setting not yet fetched */
+	for ( i = 0 ; i < count ; i++ ) {
+		fetch = &fetches[i];
+
+		/* Skip settings already fetched (or already failed) */
+		if ( fetch->len != -ENOENT )
+			continue;
+
+		/* Skip this block if no applicable setting exists */
+		if ( ( ! settings->op->fetch ) ||
+		     ( ! ( applicable = applicable_setting (
+					settings, &fetch->setting ) ) ) ) {
+			pending++;
+			continue;
+		}
+
+		/* Create modifiable copy of setting, and fetch length */
+		memcpy ( &tmp, applicable, sizeof ( tmp ) );
+		len = settings->op->fetch ( settings, &tmp, NULL, 0 );
+		if ( len < 0 ) {
+			pending++;
+			continue;
+		}
+
+		/* Allocate buffer and fetch setting value */
+		fetch->data = malloc ( len );
+		if ( ! fetch->data ) {
+			fetch->len = -ENOMEM;
+			continue;
+		}
+		check_len = settings->op->fetch ( settings, &tmp,
+						  fetch->data, len );
+		assert ( check_len == len );
+		fetch->len = len;
+	}
+
+	/* Recurse into each child block in turn, while any settings
+	 * remain unfetched.
+	 */
+	list_for_each_entry ( child, &settings->children, siblings ) {
+		if ( ! pending )
+			break;
+		pending = fetch_setting_bulk ( child, fetches, count );
+	}
+
+	return pending;
+}
+
+/**
+ * Fetch multiple settings in a single hierarchy traversal
+ *
+ * @v settings		Settings block, or NULL to search all blocks
+ * @v fetches		Bulk fetch list
+ * @v count		Number of entries in bulk fetch list
+ * @ret found		Number of entries fetched
+ *
+ * For each entry in the bulk fetch list, the setting's value is
+ * fetched into a newly allocated buffer exactly as for
+ * fetch_raw_setting_copy().  The caller is responsible for eventually
+ * freeing each allocated buffer.
+ *
+ * Fetching multiple settings via a single traversal avoids the cost
+ * of re-walking the settings block hierarchy for each individual
+ * setting, which dominates when fetching a large number of settings
+ * (e.g. when constructing a fake DHCP packet).
+ */
+unsigned int fetch_raw_setting_bulk ( struct settings *settings,
+				      struct settings_fetch *fetches,
+				      unsigned int count ) {
+	unsigned int i;
+
+	/* Avoid returning uninitialised data on error */
+	for ( i = 0 ; i < count ; i++ ) {
+		fetches[i].data = NULL;
+		fetches[i].len = -ENOENT;
+	}
+
+	return ( count - fetch_setting_bulk ( settings, fetches, count ) );
+}
+
 /**
  * Fetch value of string setting
  *
@@ -1104,8 +1371,10 @@ void clear_settings ( struct settings *settings ) {
 	settings = settings_target ( settings );
 
 	/* Clear settings, if applicable */
-	if ( settings->op->clear )
+	if ( settings->op->clear ) {
 		settings->op->clear ( settings );
+		settings_generation++;
+	}
 }
 
 /**
@@ -1463,13 +1732,11 @@ int storen_setting ( struct settings *settings, const struct setting *setting,
  * @ret setting		Setting, or NULL
  */
 struct setting * find_setting ( const char *name ) {
-	struct setting *setting;
+	struct setting setting;
 
-	for_each_table_entry ( setting, SETTINGS ) {
-		if ( strcmp ( name, setting->name ) == 0 )
-			return setting;
-	}
-	return NULL;
+	memset ( &setting, 0, sizeof ( setting ) );
+	setting.name = name;
+	return setting_index_match ( &setting, NULL );
 }
 
 /**
@@ -1563,12 +1830,9 @@ int parse_setting_name ( char *name, get_child_settings_t get_child,
 	setting->tag = parse_setting_tag ( setting_name );
 	setting->scope = (*settings)->default_scope;
 	setting->name = setting_name;
-	for_each_table_entry ( predefined, SETTINGS ) {
+	if ( ( predefined = setting_index_match ( setting, NULL ) ) != NULL ) {
 		/* Matches a predefined setting; use that setting */
-		if ( setting_cmp ( predefined, setting ) == 0 ) {
-			memcpy ( setting, predefined, sizeof ( *setting ) );
-			break;
-		}
+		memcpy ( setting, predefined, sizeof ( *setting ) );
 	}
 
 	/* Identify setting type, if specified */
@@ -2271,6 +2535,111 @@ const struct setting_type setting_type_busdevfn __setting_type = {
  ******************************************************************************
  */
 
+/** Number of cached formatted setting values */
+#define EXPAND_CACHE_SIZE 8
+
+/** A cached formatted setting value */
+struct expand_cache_entry {
+	/** Setting name (as used within "${name}"), or NULL if unused */
+	char *name;
+	/** Formatted setting value (empty if setting does not exist) */
+	char *value;
+};
+
+/** Cache of formatted setting values
+ *
+ * Scripts (particularly menu generation loops) tend to expand the
+ * same handful of settings over and over again, and each expansion
+ * otherwise requires a full walk of the settings block hierarchy plus
+ * fetching and formatting.
+ */
+static struct expand_cache_entry expand_cache[EXPAND_CACHE_SIZE];
+
+/** Next expansion cache entry to be evicted */
+static unsigned int expand_cache_evict;
+
+/** Settings generation at which expansion cache was populated */
+static unsigned int expand_cache_generation;
+
+/** Time at which expansion cache was populated */
+static unsigned long expand_cache_ticks;
+
+/**
+ * Discard all cached formatted setting values
+ *
+ */
+static void expand_cache_flush ( void ) {
+	struct expand_cache_entry *entry;
+	unsigned int i;
+
+	for ( i = 0 ; i < EXPAND_CACHE_SIZE ; i++ ) {
+		entry = &expand_cache[i];
+		free ( entry->name );
+		free ( entry->value );
+		entry->name = NULL;
+		entry->value = NULL;
+	}
+}
+
+/**
+ * Look up cached formatted setting value
+ *
+ * @v name		Setting name
+ * @ret value		Formatted setting value, or NULL if not cached
+ *
+ * Cached values are invalidated whenever a setting is stored or the
+ * settings block hierarchy changes, and additionally expire on the
+ * next timer tick, since some settings (e.g. the current time) can
+ * change with no corresponding store.
+ */
+static char * expand_cache_fetch ( const char *name ) {
+	struct expand_cache_entry *entry;
+	unsigned int i;
+
+	/* Discard all cached values if any may be stale */
+	if ( ( expand_cache_generation != settings_generation ) ||
+	     ( expand_cache_ticks != currticks() ) ) {
+		expand_cache_flush();
+		expand_cache_generation = settings_generation;
+		expand_cache_ticks = currticks();
+		return NULL;
+	}
+
+	/* Look up cached value */
+	for ( i = 0 ; i < EXPAND_CACHE_SIZE ; i++ ) {
+		entry = &expand_cache[i];
+		if ( entry->name && ( strcmp ( entry->name, name ) == 0 ) )
+			return entry->value;
+	}
+
+	return NULL;
+}
+
+/**
+ * Store formatted setting value in cache
+ *
+ * @v name		Setting name
+ * @v value		Formatted setting value (empty if non-existent)
+ */
+static void expand_cache_store ( const char *name, const char *value ) {
+	struct expand_cache_entry *entry;
+
+	/* Evict oldest entry */
+	entry = &expand_cache[ expand_cache_evict++ % EXPAND_CACHE_SIZE ];
+	free ( entry->name );
+	free ( entry->value );
+
+	/* Store name and value, or leave entry unused on failure */
+	entry->name = strdup ( name );
+	entry->value = strdup ( value );
+	if ( ( ! entry->name ) || ( ! entry->value ) ) {
+		free ( entry->name );
+		free ( entry->value );
+		entry->name = NULL;
+		entry->value = NULL;
+	}
+}
+
 /**
  * Expand variables within string
  *
@@ -2288,8 +2657,10 @@ char * expand_settings ( const char *string ) {
 	char *end;
 	char *head;
 	char *name;
+	char *key;
 	char *tail;
 	char *value;
+	char *cached;
 	char *tmp;
 	int new_len;
 	int rc;
@@ -2322,18 +2693,33 @@ char * expand_settings ( const char *string ) {
 		*end = '\0';
 		tail = ( end + 1 );
 
-		/* Expand setting */
-		if ( ( rc = parse_setting_name ( name, find_child_settings,
-						 &settings,
-						 &setting ) ) != 0 ) {
-			/* Treat invalid setting names as empty */
-			value = NULL;
+		/* Expand setting, consulting the formatted value cache.
+		 * Copy the name before parsing, since
+		 * parse_setting_name() modifies the name in situ.
+		 */
+		if ( ( cached = expand_cache_fetch ( name ) ) != NULL ) {
+			value = strdup ( cached );
 		} else {
-			/* Fetch and format setting value.  Ignore
-			 * errors; treat non-existent settings as empty.
-			 */
-			fetchf_setting_copy ( settings, &setting, NULL, NULL,
-					      &value );
+			key = strdup ( name );
+			if ( ( rc = parse_setting_name ( name,
+							 find_child_settings,
+							 &settings,
+							 &setting ) ) != 0 ) {
+				/* Treat invalid setting names as empty */
+				value = NULL;
+			} else {
+				/* Fetch and format setting value.
+				 * Ignore errors; treat non-existent
+				 * settings as empty.
+				 */
+				fetchf_setting_copy ( settings, &setting,
+						      NULL, NULL, &value );
+			}
+			if ( key ) {
+				expand_cache_store ( key,
+						     ( value ? value : "" ) );
+				free ( key );
+			}
 		}
 
 		/* Construct expanded string and discard old string */
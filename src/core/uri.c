@@ -37,6 +37,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/vsprintf.h>
 #include <ipxe/params.h>
 #include <ipxe/tcpip.h>
+#include <ipxe/list.h>
+#include <ipxe/malloc.h>
 #include <ipxe/uri.h>
 
 /**
@@ -282,6 +284,115 @@ static void uri_free ( struct refcnt *refcnt ) {
 	free ( uri );
 }
 
+/** Maximum number of interned URIs */
+#define URI_INTERN_MAX 8
+
+/** An interned URI */
+struct interned_uri {
+	/** List of interned URIs */
+	struct list_head list;
+	/** Parsed URI */
+	struct uri *uri;
+	/** Original URI string
+	 *
+	 * Must be at end of structure
+	 */
+	char string[0];
+};
+
+/** List of interned URIs, most recently used first
+ *
+ * Parsed URIs are immutable (uri_dup() exists to create modifiable
+ * copies), so repeated parses of the same string can safely share a
+ * single reference-counted URI.  Redirects and relative resolutions
+ * tend to re-parse the same handful of strings repeatedly.
+ */
+static LIST_HEAD ( interned_uris );
+
+/** Number of interned URIs */
+static unsigned int interned_uri_count;
+
+/**
+ * Find interned URI
+ *
+ * @v uri_string	URI string
+ * @ret uri		Shared URI, or NULL if not interned
+ */
+static struct uri * uri_intern_find ( const char *uri_string ) {
+	struct interned_uri *interned;
+
+	list_for_each_entry ( interned, &interned_uris, list ) {
+		if ( strcmp ( interned->string, uri_string ) == 0 ) {
+			/* Move to head of list */
+			list_del ( &interned->list );
+			list_add ( &interned->list, &interned_uris );
+			return interned->uri;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Intern parsed URI
+ *
+ * @v uri_string	URI string
+ * @v uri		Parsed URI
+ */
+static void uri_intern ( const char *uri_string, struct uri *uri ) {
+	struct interned_uri *interned;
+	size_t len = ( strlen ( uri_string ) + 1 /* NUL */ );
+
+	/* Never share URIs with claimed form parameters */
+	if ( uri->params )
+		return;
+
+	/* Evict least recently used URI if full */
+	if ( interned_uri_count >= URI_INTERN_MAX ) {
+		interned = list_last_entry ( &interned_uris,
+					     struct interned_uri, list );
+		list_del ( &interned->list );
+		uri_put ( interned->uri );
+		free ( interned );
+		interned_uri_count--;
+	}
+
+	/* Allocate and add entry, ignoring failures */
+	interned = zalloc ( sizeof ( *interned ) + len );
+	if ( ! interned )
+		return;
+	interned->uri = uri_get ( uri );
+	memcpy ( interned->string, uri_string, len );
+	list_add ( &interned->list, &interned_uris );
+	interned_uri_count++;
+}
+
+/**
+ * Discard some interned URIs
+ *
+ * @ret discarded	Number of cached items discarded
+ */
+static unsigned int uri_intern_discard ( void ) {
+	struct interned_uri *interned;
+
+	/* Discard least recently used URI, if any */
+	interned = list_last_entry ( &interned_uris, struct interned_uri,
+				     list );
+	if ( ! interned )
+		return 0;
+	list_del ( &interned->list );
+	uri_put ( interned->uri );
+	free ( interned );
+	interned_uri_count--;
+
+	return 1;
+}
+
+/** Interned URI cache discarder */
+struct cache_discarder uri_intern_discarder __cache_discarder ( CACHE_NORMAL )={
+	.discard = uri_intern_discard,
+};
+
 /**
  * Parse URI
  *
@@ -302,6 +413,12 @@ struct uri * parse_uri ( const char *uri_string ) {
 	size_t raw_len;
 	unsigned int field;
 
+	/* Re-use any interned URI for this string */
+	if ( ( uri = uri_intern_find ( uri_string ) ) != NULL ) {
+		DBGC ( uri, "URI reused interned \"%s\"\n", uri_string );
+		return uri_get ( uri );
+	}
+
 	/* Allocate space for URI struct and a copy of the string */
 	raw_len = ( strlen ( uri_string ) + 1 /* NUL */ );
 	uri = zalloc ( sizeof ( *uri ) + raw_len );
@@ -428,6 +545,9 @@ struct uri * parse_uri ( const char *uri_string ) {
 	uri_dump ( uri );
 	DBGC ( uri, "\n" );
 
+	/* Intern parsed URI for re-use */
+	uri_intern ( uri_string, uri );
+
 	return uri;
 }
 
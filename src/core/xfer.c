@@ -29,6 +29,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <errno.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/xfer.h>
+#include <ipxe/job.h>
 #include <ipxe/open.h>
 
 /** @file
@@ -202,6 +203,12 @@ int xfer_deliver ( struct interface *intf,
 	DBGC ( INTF_COL ( intf ), "INTF " INTF_INTF_FMT " deliver %zd\n",
 	       INTF_INTF_DBG ( intf, dest ), iob_len ( iobuf ) );
 
+	/* Record activity for the benefit of anything monitoring
+	 * overall job progress: a data delivery is the signal that a
+	 * progress query may now return a different answer.
+	 */
+	job_activity++;
+
 	if ( op ) {
 		rc = op ( object, iobuf, meta );
 	} else {
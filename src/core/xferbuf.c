@@ -59,6 +59,7 @@ void xferbuf_free ( struct xfer_buffer *xferbuf ) {
 
 	xferbuf->op->realloc ( xferbuf, 0 );
 	xferbuf->len = 0;
+	xferbuf->allocated = 0;
 	xferbuf->pos = 0;
 }
 
@@ -69,24 +70,60 @@ void xferbuf_free ( struct xfer_buffer *xferbuf ) {
  * @v len		Required minimum size
  * @ret rc		Return status code
  */
-static int xferbuf_ensure_size ( struct xfer_buffer *xferbuf, size_t len ) {
+int xferbuf_ensure_size ( struct xfer_buffer *xferbuf, size_t len ) {
+	size_t new_allocated;
 	int rc;
 
 	/* If buffer is already large enough, do nothing */
 	if ( len <= xferbuf->len )
 		return 0;
 
-	/* Extend buffer */
-	if ( ( rc = xferbuf->op->realloc ( xferbuf, len ) ) != 0 ) {
-		DBGC ( xferbuf, "XFERBUF %p could not extend buffer to "
-		       "%zd bytes: %s\n", xferbuf, len, strerror ( rc ) );
-		return rc;
+	/* Extend allocation, if needed.  Grow geometrically, so that
+	 * a buffer filled by a long series of small deliveries is
+	 * copied O(log n) times rather than once per delivery.  If a
+	 * geometric extension fails, fall back to requesting the
+	 * exact required size, since the shortfall may be due solely
+	 * to the overallocation.
+	 */
+	if ( len > xferbuf->allocated ) {
+		new_allocated = ( xferbuf->allocated * 2 );
+		if ( new_allocated < len )
+			new_allocated = len;
+		if ( ( rc = xferbuf->op->realloc ( xferbuf,
+						   new_allocated ) ) != 0 ) {
+			new_allocated = len;
+			rc = xferbuf->op->realloc ( xferbuf, new_allocated );
+		}
+		if ( rc != 0 ) {
+			DBGC ( xferbuf, "XFERBUF %p could not extend buffer "
+			       "to %zd bytes: %s\n", xferbuf, len,
+			       strerror ( rc ) );
+			return rc;
+		}
+		xferbuf->allocated = new_allocated;
 	}
 	xferbuf->len = len;
 
 	return 0;
 }
 
+/**
+ * Trim data transfer buffer allocation to data size
+ *
+ * @v xferbuf		Data transfer buffer
+ *
+ * Shrink the allocation to match the data size, releasing any excess
+ * arising from geometric growth.  A failure to shrink is harmless:
+ * the buffer merely remains overallocated.
+ */
+void xferbuf_trim ( struct xfer_buffer *xferbuf ) {
+
+	if ( ( xferbuf->allocated > xferbuf->len ) && ( xferbuf->len > 0 ) &&
+	     ( xferbuf->op->realloc ( xferbuf, xferbuf->len ) == 0 ) ) {
+		xferbuf->allocated = xferbuf->len;
+	}
+}
+
 /**
  * Write to data transfer buffer
  *
@@ -96,7 +96,8 @@ static void arc4_xor ( void *ctxv, const void *srcv, void *dstv,
 	ctx->j = j;
 }
 
-static void arc4_setiv ( void *ctx __unused, const void *iv __unused )
+static void arc4_setiv ( void *ctx __unused, const void *iv __unused,
+			 size_t ivlen __unused )
 {
 	/* ARC4 does not use a fixed-length IV */
 }
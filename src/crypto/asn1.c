@@ -458,11 +458,22 @@ int asn1_compare ( const struct asn1_cursor *cursor1,
  */
 static struct asn1_algorithm *
 asn1_find_algorithm ( const struct asn1_cursor *cursor ) {
+	static struct asn1_algorithm *cache;
 	struct asn1_algorithm *algorithm;
 
+	/* Check most recently identified algorithm first, since
+	 * certificates within a chain almost always share the same
+	 * signature and public-key algorithms.
+	 */
+	if ( cache && ( asn1_compare ( &cache->oid, cursor ) == 0 ) )
+		return cache;
+
+	/* Search table of algorithms */
 	for_each_table_entry ( algorithm, ASN1_ALGORITHMS ) {
-		if ( asn1_compare ( &algorithm->oid, cursor ) == 0 )
+		if ( asn1_compare ( &algorithm->oid, cursor ) == 0 ) {
+			cache = algorithm;
 			return algorithm;
+		}
 	}
 
 	return NULL;
@@ -119,6 +119,132 @@ void bigint_mod_multiply_raw ( const bigint_element_t *multiplicand0,
 	profile_stop ( &bigint_mod_multiply_profiler );
 }
 
+/**
+ * Calculate negated modular inverse of odd big integer
+ *
+ * @v modulus0		Element 0 of odd big integer modulus
+ * @v inverse0		Element 0 of big integer to hold inverse
+ * @v size		Number of elements in modulus and inverse
+ * @v tmp		Temporary working space
+ *
+ * Calculates the negated inverse of the modulus modulo 2^(size*width)
+ * (i.e. modulo the Montgomery constant R), as required for Montgomery
+ * reduction, using Newton-Raphson iteration to double the number of
+ * correct low-order bits at each step.
+ */
+static void bigint_mont_invert_raw ( const bigint_element_t *modulus0,
+				     bigint_element_t *inverse0,
+				     unsigned int size, void *tmp ) {
+	const bigint_t ( size ) __attribute__ (( may_alias )) *modulus =
+		( ( const void * ) modulus0 );
+	bigint_t ( size ) __attribute__ (( may_alias )) *inverse =
+		( ( void * ) inverse0 );
+	struct {
+		bigint_t ( size ) subtrahend;
+		bigint_t ( size * 2 ) product;
+	} *temp = tmp;
+	bigint_t ( size ) __attribute__ (( may_alias )) *product_low =
+		( ( void * ) &temp->product );
+	unsigned int width = ( 8 * sizeof ( bigint_element_t ) );
+	unsigned int correct;
+	static const uint8_t start[1] = { 0x01 };
+	static const uint8_t two[1] = { 0x02 };
+	static const uint8_t zero[1] = { 0x00 };
+
+	/* Sanity check */
+	assert ( bigint_bit_is_set ( modulus, 0 ) );
+
+	/* An odd modulus is its own inverse modulo 2 */
+	bigint_init ( inverse, start, sizeof ( start ) );
+
+	/* Iterate using inverse' = inverse * ( 2 - modulus * inverse ) */
+	for ( correct = 1 ; correct < ( size * width ) ; correct <<= 1 ) {
+		bigint_multiply ( modulus, inverse, &temp->product );
+		bigint_init ( &temp->subtrahend, two, sizeof ( two ) );
+		bigint_subtract ( product_low, &temp->subtrahend );
+		bigint_multiply ( inverse, &temp->subtrahend, &temp->product );
+		bigint_shrink ( &temp->product, inverse );
+	}
+
+	/* Negate inverse */
+	bigint_init ( &temp->subtrahend, zero, sizeof ( zero ) );
+	bigint_subtract ( inverse, &temp->subtrahend );
+	memcpy ( inverse, &temp->subtrahend, sizeof ( *inverse ) );
+}
+
+/**
+ * Perform Montgomery multiplication of big integers
+ *
+ * @v multiplicand0	Element 0 of big integer to be multiplied
+ * @v multiplier0	Element 0 of big integer to be multiplied
+ * @v modulus0		Element 0 of odd big integer modulus
+ * @v inverse0		Element 0 of negated inverse of modulus modulo R
+ * @v result0		Element 0 of big integer to hold result
+ * @v size		Number of elements in all big integers
+ * @v tmp		Temporary working space
+ *
+ * Calculates result = ( multiplicand * multiplier / R ) mod modulus,
+ * where R is the Montgomery constant 2^(size*width).  The result
+ * buffer may overlap the multiplicand and/or multiplier, since these
+ * are fully consumed before the result is written.
+ */
+static void bigint_mont_multiply_raw ( const bigint_element_t *multiplicand0,
+				       const bigint_element_t *multiplier0,
+				       const bigint_element_t *modulus0,
+				       const bigint_element_t *inverse0,
+				       bigint_element_t *result0,
+				       unsigned int size, void *tmp ) {
+	const bigint_t ( size ) __attribute__ (( may_alias )) *multiplicand =
+		( ( const void * ) multiplicand0 );
+	const bigint_t ( size ) __attribute__ (( may_alias )) *multiplier =
+		( ( const void * ) multiplier0 );
+	const bigint_t ( size ) __attribute__ (( may_alias )) *modulus =
+		( ( const void * ) modulus0 );
+	const bigint_t ( size ) __attribute__ (( may_alias )) *inverse =
+		( ( const void * ) inverse0 );
+	bigint_t ( size ) __attribute__ (( may_alias )) *result =
+		( ( void * ) result0 );
+	struct {
+		bigint_t ( size * 2 ) product;
+		bigint_t ( size * 2 ) multiple;
+		bigint_t ( size ) m;
+	} *temp = tmp;
+	bigint_t ( size ) __attribute__ (( may_alias )) *product_low =
+		( ( void * ) &temp->product );
+	bigint_t ( size ) __attribute__ (( may_alias )) *product_high =
+		( ( void * ) &temp->product.element[size] );
+	int carry;
+
+	/* Perform multiplication */
+	bigint_multiply ( multiplicand, multiplier, &temp->product );
+
+	/* Calculate m = ( product * -modulus^-1 ) mod R */
+	bigint_multiply ( product_low, inverse, &temp->multiple );
+	bigint_shrink ( &temp->multiple, &temp->m );
+
+	/* Add ( m * modulus ), forcing the low half of the product to
+	 * zero and so making the product exactly divisible by R
+	 */
+	bigint_multiply ( &temp->m, modulus, &temp->multiple );
+	bigint_add ( &temp->multiple, &temp->product );
+	carry = ( ! bigint_is_geq ( &temp->product, &temp->multiple ) );
+
+	/* Divide by R (by taking the high half of the product) and
+	 * subtract the modulus at most once to bring the result
+	 * within range, treating a carry out of the addition as the
+	 * (unstorable) topmost bit of the product
+	 */
+	memcpy ( result, product_high, sizeof ( *result ) );
+	if ( carry ) {
+		bigint_subtract ( modulus, result );
+	} else if ( bigint_is_geq ( result, modulus ) ) {
+		bigint_subtract ( modulus, result );
+	}
+
+	/* Sanity check */
+	assert ( bigint_is_geq ( modulus, result ) );
+}
+
 /**
  * Perform modular exponentiation of big integers
  *
@@ -129,6 +255,11 @@ void bigint_mod_multiply_raw ( const bigint_element_t *multiplicand0,
  * @v size		Number of elements in base, modulus, and result
  * @v exponent_size	Number of elements in exponent
  * @v tmp		Temporary working space
+ *
+ * An odd modulus (as used by both RSA and DHE) allows the use of
+ * Montgomery multiplication with a fixed-window exponentiation
+ * ladder.  An even modulus is handled using the older (and much
+ * slower) repeated shift-and-subtract reduction ladder.
  */
 void bigint_mod_exp_raw ( const bigint_element_t *base0,
 			  const bigint_element_t *modulus0,
@@ -145,24 +276,149 @@ void bigint_mod_exp_raw ( const bigint_element_t *base0,
 	bigint_t ( size ) __attribute__ (( may_alias )) *result =
 		( ( void * ) result0 );
 	size_t mod_multiply_len = bigint_mod_multiply_tmp_len ( modulus );
-	struct {
-		bigint_t ( size ) base;
-		bigint_t ( exponent_size ) exponent;
-		uint8_t mod_multiply[mod_multiply_len];
+	unsigned int width = ( 8 * sizeof ( bigint_element_t ) );
+	union {
+		struct {
+			bigint_t ( size )
+				table[ ( 1 << BIGINT_MOD_EXP_WINDOW ) - 1 ];
+			bigint_t ( size ) inverse;
+			bigint_t ( size ) residue;
+			bigint_t ( exponent_size ) exponent;
+			union {
+				struct {
+					bigint_t ( size + 1 ) value;
+					bigint_t ( size + 1 ) modulus;
+				} residue;
+				struct {
+					bigint_t ( size ) subtrahend;
+					bigint_t ( size * 2 ) product;
+				} invert;
+				struct {
+					bigint_t ( size * 2 ) product;
+					bigint_t ( size * 2 ) multiple;
+					bigint_t ( size ) m;
+				} multiply;
+			} scratch;
+		} mont;
+		struct {
+			bigint_t ( size ) base;
+			bigint_t ( exponent_size ) exponent;
+			uint8_t mod_multiply[mod_multiply_len];
+		} ladder;
 	} *temp = tmp;
+	unsigned int window;
+	unsigned int bit;
+	unsigned int i;
 	static const uint8_t start[1] = { 0x01 };
 
-	memcpy ( &temp->base, base, sizeof ( temp->base ) );
-	memcpy ( &temp->exponent, exponent, sizeof ( temp->exponent ) );
-	bigint_init ( result, start, sizeof ( start ) );
+	/* Handle an even modulus using the shift-and-subtract ladder */
+	if ( ! bigint_bit_is_set ( modulus, 0 ) ) {
+		memcpy ( &temp->ladder.base, base,
+			 sizeof ( temp->ladder.base ) );
+		memcpy ( &temp->ladder.exponent, exponent,
+			 sizeof ( temp->ladder.exponent ) );
+		bigint_init ( result, start, sizeof ( start ) );
+		while ( ! bigint_is_zero ( &temp->ladder.exponent ) ) {
+			if ( bigint_bit_is_set ( &temp->ladder.exponent, 0 ) ) {
+				bigint_mod_multiply ( result,
+						      &temp->ladder.base,
+						      modulus, result,
+						      temp->ladder.mod_multiply
+						      );
+			}
+			bigint_ror ( &temp->ladder.exponent );
+			bigint_mod_multiply ( &temp->ladder.base,
+					      &temp->ladder.base, modulus,
+					      &temp->ladder.base,
+					      temp->ladder.mod_multiply );
+		}
+		return;
+	}
+
+	/* Calculate the negated inverse of the modulus modulo R */
+	bigint_mont_invert_raw ( modulus0, temp->mont.inverse.element, size,
+				 &temp->mont.scratch.invert );
 
-	while ( ! bigint_is_zero ( &temp->exponent ) ) {
-		if ( bigint_bit_is_set ( &temp->exponent, 0 ) ) {
-			bigint_mod_multiply ( result, &temp->base, modulus,
-					      result, temp->mod_multiply );
+	/* Calculate ( R mod modulus ) and ( R^2 mod modulus ) by
+	 * repeated doubling, using a temporarily widened copy of the
+	 * modulus to avoid losing the overflow bit
+	 */
+	bigint_grow ( modulus, &temp->mont.scratch.residue.modulus );
+	bigint_init ( &temp->mont.scratch.residue.value, start,
+		      sizeof ( start ) );
+	for ( i = 1 ; i <= ( 2 * size * width ) ; i++ ) {
+		bigint_rol ( &temp->mont.scratch.residue.value );
+		if ( bigint_is_geq ( &temp->mont.scratch.residue.value,
+				     &temp->mont.scratch.residue.modulus ) ) {
+			bigint_subtract ( &temp->mont.scratch.residue.modulus,
+					  &temp->mont.scratch.residue.value );
+		}
+		if ( i == ( size * width ) ) {
+			bigint_shrink ( &temp->mont.scratch.residue.value,
+					&temp->mont.residue );
 		}
-		bigint_ror ( &temp->exponent );
-		bigint_mod_multiply ( &temp->base, &temp->base, modulus,
-				      &temp->base, temp->mod_multiply );
 	}
+	bigint_shrink ( &temp->mont.scratch.residue.value,
+			&temp->mont.table[0] );
+
+	/* Precompute the small powers of the base in Montgomery form,
+	 * converting via multiplication by ( R^2 mod modulus )
+	 * currently held in the first table entry
+	 */
+	memcpy ( &temp->mont.exponent, exponent,
+		 sizeof ( temp->mont.exponent ) );
+	bigint_mont_multiply_raw ( base0, temp->mont.table[0].element,
+				   modulus0, temp->mont.inverse.element,
+				   temp->mont.table[0].element, size,
+				   &temp->mont.scratch.multiply );
+	for ( i = 1 ; i < ( ( 1 << BIGINT_MOD_EXP_WINDOW ) - 1 ) ; i++ ) {
+		bigint_mont_multiply_raw ( temp->mont.table[ i - 1 ].element,
+					   temp->mont.table[0].element,
+					   modulus0,
+					   temp->mont.inverse.element,
+					   temp->mont.table[i].element, size,
+					   &temp->mont.scratch.multiply );
+	}
+
+	/* Initialise result to 1 in Montgomery form (i.e. R mod modulus) */
+	memcpy ( result, &temp->mont.residue, sizeof ( *result ) );
+
+	/* Process exponent bits a window at a time, squaring the
+	 * result once per bit and multiplying in the relevant
+	 * precomputed power of the base for each non-zero window
+	 */
+	bit = bigint_max_set_bit ( &temp->mont.exponent );
+	bit = ( ( bit + BIGINT_MOD_EXP_WINDOW - 1 ) &
+		~( BIGINT_MOD_EXP_WINDOW - 1 ) );
+	while ( bit ) {
+		for ( i = 0 ; i < BIGINT_MOD_EXP_WINDOW ; i++ ) {
+			bigint_mont_multiply_raw ( result0, result0, modulus0,
+						   temp->mont.inverse.element,
+						   result0, size,
+						   &temp->mont.scratch.multiply
+						   );
+		}
+		window = 0;
+		for ( i = 0 ; i < BIGINT_MOD_EXP_WINDOW ; i++ ) {
+			window <<= 1;
+			bit--;
+			if ( bigint_bit_is_set ( &temp->mont.exponent, bit ) )
+				window |= 1;
+		}
+		if ( window ) {
+			bigint_mont_multiply_raw (
+					result0,
+					temp->mont.table[ window - 1 ].element,
+					modulus0, temp->mont.inverse.element,
+					result0, size,
+					&temp->mont.scratch.multiply );
+		}
+	}
+
+	/* Convert result out of Montgomery form */
+	bigint_init ( &temp->mont.residue, start, sizeof ( start ) );
+	bigint_mont_multiply_raw ( result0, temp->mont.residue.element,
+				   modulus0, temp->mont.inverse.element,
+				   result0, size,
+				   &temp->mont.scratch.multiply );
 }
@@ -25,9 +25,11 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <ipxe/init.h>
 #include <ipxe/dhcp.h>
 #include <ipxe/settings.h>
+#include <ipxe/nvo.h>
 #include <ipxe/malloc.h>
 #include <ipxe/crypto.h>
 #include <ipxe/asn1.h>
@@ -265,37 +267,54 @@ static struct setting cert_setting __setting ( SETTING_CRYPTO, cert ) = {
  * @ret rc		Return status code
  */
 static int certstore_apply_settings ( void ) {
-	static struct x509_certificate *cert = NULL;
-	struct x509_certificate *old_cert;
+	static struct x509_chain *certs = NULL;
+	struct x509_chain *old_certs;
+	struct asn1_cursor cursor;
 	void *cert_data;
 	int len;
 	int rc;
 
-	/* Record any existing additional certificate */
-	old_cert = cert;
-	cert = NULL;
+	/* Record any existing additional certificates */
+	old_certs = certs;
+	certs = NULL;
 
-	/* Add additional certificate, if any */
+	/* Add additional certificates, if any.  The setting may
+	 * contain any number of concatenated DER certificates.
+	 */
 	if ( ( len = fetch_raw_setting_copy ( NULL, &cert_setting,
 					      &cert_data ) ) >= 0 ) {
-		if ( ( rc = x509_certificate ( cert_data, len, &cert ) ) == 0 ){
-			DBGC ( &certstore, "CERTSTORE added additional "
-			       "certificate %s\n", x509_name ( cert ) );
-		} else {
-			DBGC ( &certstore, "CERTSTORE could not parse "
-			       "additional certificate: %s\n",
-			       strerror ( rc ) );
-			/* Do not fail; leave as an unusable certificate */
+		certs = x509_alloc_chain();
+		if ( certs ) {
+			cursor.data = cert_data;
+			cursor.len = len;
+			while ( cursor.len ) {
+				if ( ( rc = x509_append_raw ( certs,
+							      cursor.data,
+							      cursor.len )
+				       ) != 0 ) {
+					DBGC ( &certstore, "CERTSTORE could "
+					       "not parse additional "
+					       "certificate: %s\n",
+					       strerror ( rc ) );
+					/* Do not fail; ignore remaining data */
+					break;
+				}
+				DBGC ( &certstore, "CERTSTORE added additional "
+				       "certificate %s\n",
+				       x509_name ( x509_last ( certs ) ) );
+				asn1_skip_any ( &cursor );
+			}
 		}
 		free ( cert_data );
 	}
 
-	/* Free old additional certificiate.  Do this after reparsing
-	 * the additional certificate; in the common case that the
-	 * certificate has not changed, this will allow the stored
-	 * certificate to be reused.
+	/* Free old additional certificates.  Do this after reparsing
+	 * the additional certificates; in the common case that the
+	 * certificates have not changed, this will allow the stored
+	 * certificates to be reused.
 	 */
-	x509_put ( old_cert );
+	if ( old_certs )
+		x509_chain_put ( old_certs );
 
 	return 0;
 }
@@ -304,3 +323,73 @@ static int certstore_apply_settings ( void ) {
 struct settings_applicator certstore_applicator __settings_applicator = {
 	.apply = certstore_apply_settings,
 };
+
+/**
+ * Save certificate to non-volatile storage
+ *
+ * @v cert		X.509 certificate
+ * @ret rc		Return status code
+ *
+ * The certificate is appended to the additional certificate setting
+ * within the first non-volatile option block that has sufficient
+ * space, so that future boots can reuse the certificate without
+ * needing to download it.  Saving is best-effort: many non-volatile
+ * option blocks are too small to hold a certificate.
+ */
+int certstore_save ( struct x509_certificate *cert ) {
+	struct nvo_block *nvo;
+	struct asn1_cursor cursor;
+	struct asn1_cursor entry;
+	void *old;
+	void *new;
+	size_t new_len;
+	int len;
+	int rc;
+
+	/* Fetch any existing saved certificates */
+	len = fetch_raw_setting_copy ( NULL, &cert_setting, &old );
+	if ( len < 0 ) {
+		len = 0;
+		old = NULL;
+	}
+
+	/* Do nothing if certificate is already saved */
+	cursor.data = old;
+	cursor.len = len;
+	while ( cursor.len ) {
+		memcpy ( &entry, &cursor, sizeof ( entry ) );
+		if ( ( asn1_shrink_any ( &entry ) == 0 ) &&
+		     ( asn1_compare ( &entry, &cert->raw ) == 0 ) ) {
+			rc = 0;
+			goto done;
+		}
+		asn1_skip_any ( &cursor );
+	}
+
+	/* Append certificate to saved certificates */
+	new_len = ( len + cert->raw.len );
+	new = realloc ( old, new_len );
+	if ( ! new ) {
+		rc = -ENOMEM;
+		goto done;
+	}
+	old = new;
+	memcpy ( ( new + len ), cert->raw.data, cert->raw.len );
+
+	/* Store in first non-volatile option block with sufficient space */
+	rc = -ENOTSUP;
+	list_for_each_entry ( nvo, &nvo_blocks, list ) {
+		if ( ( rc = store_setting ( &nvo->settings, &cert_setting,
+					    new, new_len ) ) == 0 ) {
+			DBGC ( &certstore, "CERTSTORE saved certificate %s "
+			       "to NVO %p\n", x509_name ( cert ), nvo );
+			goto done;
+		}
+	}
+	DBGC ( &certstore, "CERTSTORE could not save certificate %s: %s\n",
+	       x509_name ( cert ), strerror ( rc ) );
+
+ done:
+	free ( old );
+	return rc;
+}
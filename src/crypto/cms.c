@@ -39,6 +39,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/x509.h>
 #include <ipxe/malloc.h>
 #include <ipxe/uaccess.h>
+#include <ipxe/image.h>
 #include <ipxe/cms.h>
 
 /* Disambiguate the various error causes */
@@ -532,19 +533,29 @@ int cms_signature ( const void *data, size_t len, struct cms_signature **sig ) {
  *
  * @v sig		CMS signature
  * @v info		Signer information
- * @v data		Signed data
- * @v len		Length of signed data
+ * @v image		Signed image
  * @v out		Digest output
  */
 static void cms_digest ( struct cms_signature *sig,
 			 struct cms_signer_info *info,
-			 userptr_t data, size_t len, void *out ) {
+			 struct image *image, void *out ) {
 	struct digest_algorithm *digest = info->digest;
 	uint8_t ctx[ digest->ctxsize ];
 	uint8_t block[ digest->blocksize ];
+	userptr_t data = image->data;
+	size_t len = image->len;
 	size_t offset = 0;
 	size_t frag_len;
 
+	/* Use cached digest, if available (e.g. calculated while the
+	 * image was being downloaded).
+	 */
+	if ( image_digest ( image, digest, out ) == 0 ) {
+		DBGC ( sig, "CMS %p/%p using cached %s digest\n",
+		       sig, info, digest->name );
+		goto done;
+	}
+
 	/* Initialise digest */
 	digest_init ( digest, ctx );
 
@@ -562,6 +573,10 @@ static void cms_digest ( struct cms_signature *sig,
 	/* Finalise digest */
 	digest_final ( digest, ctx, out );
 
+	/* Cache digest for any subsequent verification */
+	image_set_digest ( image, digest, out );
+
+ done:
 	DBGC ( sig, "CMS %p/%p digest value:\n", sig, info );
 	DBGC_HDA ( sig, 0, out, digest->digestsize );
 }
@@ -572,14 +587,13 @@ static void cms_digest ( struct cms_signature *sig,
  * @v sig		CMS signature
  * @v info		Signer information
  * @v cert		Corresponding certificate
- * @v data		Signed data
- * @v len		Length of signed data
+ * @v image		Signed image
  * @ret rc		Return status code
  */
 static int cms_verify_digest ( struct cms_signature *sig,
 			       struct cms_signer_info *info,
 			       struct x509_certificate *cert,
-			       userptr_t data, size_t len ) {
+			       struct image *image ) {
 	struct digest_algorithm *digest = info->digest;
 	struct pubkey_algorithm *pubkey = info->pubkey;
 	struct x509_public_key *public_key = &cert->subject.public_key;
@@ -588,7 +602,7 @@ static int cms_verify_digest ( struct cms_signature *sig,
 	int rc;
 
 	/* Generate digest */
-	cms_digest ( sig, info, data, len, digest_out );
+	cms_digest ( sig, info, image, digest_out );
 
 	/* Initialise public-key algorithm */
 	if ( ( rc = pubkey_init ( pubkey, ctx, public_key->raw.data,
@@ -618,8 +632,7 @@ static int cms_verify_digest ( struct cms_signature *sig,
  *
  * @v sig		CMS signature
  * @v info		Signer information
- * @v data		Signed data
- * @v len		Length of signed data
+ * @v image		Signed image
  * @v time		Time at which to validate certificates
  * @v store		Certificate store, or NULL to use default
  * @v root		Root certificate list, or NULL to use default
@@ -627,7 +640,7 @@ static int cms_verify_digest ( struct cms_signature *sig,
  */
 static int cms_verify_signer_info ( struct cms_signature *sig,
 				    struct cms_signer_info *info,
-				    userptr_t data, size_t len,
+				    struct image *image,
 				    time_t time, struct x509_chain *store,
 				    struct x509_root *root ) {
 	struct x509_certificate *cert;
@@ -660,25 +673,134 @@ static int cms_verify_signer_info ( struct cms_signature *sig,
 	}
 
 	/* Verify digest */
-	if ( ( rc = cms_verify_digest ( sig, info, cert, data, len ) ) != 0 )
+	if ( ( rc = cms_verify_digest ( sig, info, cert, image ) ) != 0 )
 		return rc;
 
 	return 0;
 }
 
+/** Maximum number of digests to calculate in a single pass */
+#define CMS_DIGESTS 8
+
+/** Data block size used when calculating digests in a single pass */
+#define CMS_DIGEST_BLKSIZE 512
+
+/**
+ * Calculate all required digests of CMS-signed data in a single pass
+ *
+ * @v sig		CMS signature
+ * @v image		Signed image
+ * @v name		Required common name, or NULL to check all signatures
+ *
+ * Where several signerInfos use different digest algorithms, digest
+ * the (potentially very large) image data once, updating all digest
+ * contexts in parallel, rather than taking a separate pass over the
+ * data for each signerInfo.  Results are recorded in the image's
+ * digest cache, from which cms_digest() will retrieve them.
+ */
+static void cms_digest_all ( struct cms_signature *sig, struct image *image,
+			     const char *name ) {
+	struct digest_algorithm *digests[CMS_DIGESTS];
+	uint8_t out[IMAGE_DIGEST_MAX_SIZE];
+	uint8_t block[CMS_DIGEST_BLKSIZE];
+	struct cms_signer_info *info;
+	struct x509_certificate *cert;
+	struct digest_algorithm *digest;
+	userptr_t data = image->data;
+	size_t len = image->len;
+	size_t offset = 0;
+	size_t frag_len;
+	size_t ctxsize = 0;
+	size_t ctxoff;
+	unsigned int count = 0;
+	unsigned int i;
+	uint8_t *ctx;
+
+	/* Identify distinct uncached digest algorithms among the
+	 * signerInfos that will be verified.
+	 */
+	list_for_each_entry ( info, &sig->info, list ) {
+		cert = x509_first ( info->chain );
+		if ( name && ( x509_check_name ( cert, name ) != 0 ) )
+			continue;
+		digest = info->digest;
+		if ( digest->digestsize > sizeof ( out ) )
+			continue;
+		if ( image_digest ( image, digest, out ) == 0 )
+			continue;
+		for ( i = 0 ; i < count ; i++ ) {
+			if ( digests[i] == digest )
+				break;
+		}
+		if ( i < count )
+			continue;
+		if ( count == CMS_DIGESTS )
+			return;
+		digests[count++] = digest;
+		ctxsize += digest->ctxsize;
+	}
+
+	/* Do nothing unless a combined pass would save at least one
+	 * pass over the data.
+	 */
+	if ( count < 2 )
+		return;
+
+	/* Allocate digest contexts.  Failure is harmless: each
+	 * signerInfo will simply digest the data for itself.
+	 */
+	ctx = malloc ( ctxsize );
+	if ( ! ctx )
+		return;
+
+	/* Initialise digest contexts */
+	ctxoff = 0;
+	for ( i = 0 ; i < count ; i++ ) {
+		digest_init ( digests[i], &ctx[ctxoff] );
+		ctxoff += digests[i]->ctxsize;
+	}
+
+	/* Process data one block at a time */
+	while ( len ) {
+		frag_len = len;
+		if ( frag_len > sizeof ( block ) )
+			frag_len = sizeof ( block );
+		copy_from_user ( block, data, offset, frag_len );
+		ctxoff = 0;
+		for ( i = 0 ; i < count ; i++ ) {
+			digest_update ( digests[i], &ctx[ctxoff], block,
+					frag_len );
+			ctxoff += digests[i]->ctxsize;
+		}
+		offset += frag_len;
+		len -= frag_len;
+	}
+
+	/* Finalise digests and record in the image's digest cache */
+	ctxoff = 0;
+	for ( i = 0 ; i < count ; i++ ) {
+		digest_final ( digests[i], &ctx[ctxoff], out );
+		image_set_digest ( image, digests[i], out );
+		ctxoff += digests[i]->ctxsize;
+	}
+	DBGC ( sig, "CMS %p calculated %d digests in a single pass\n",
+	       sig, count );
+
+	free ( ctx );
+}
+
 /**
  * Verify CMS signature
  *
  * @v sig		CMS signature
- * @v data		Signed data
- * @v len		Length of signed data
+ * @v image		Signed image
  * @v name		Required common name, or NULL to check all signatures
  * @v time		Time at which to validate certificates
  * @v store		Certificate store, or NULL to use default
  * @v root		Root certificate list, or NULL to use default
  * @ret rc		Return status code
  */
-int cms_verify ( struct cms_signature *sig, userptr_t data, size_t len,
+int cms_verify ( struct cms_signature *sig, struct image *image,
 		 const char *name, time_t time, struct x509_chain *store,
 		 struct x509_root *root ) {
 	struct cms_signer_info *info;
@@ -686,12 +808,15 @@ int cms_verify ( struct cms_signature *sig, userptr_t data, size_t len,
 	int count = 0;
 	int rc;
 
+	/* Calculate any required data digests in a single pass */
+	cms_digest_all ( sig, image, name );
+
 	/* Verify using all signerInfos */
 	list_for_each_entry ( info, &sig->info, list ) {
 		cert = x509_first ( info->chain );
 		if ( name && ( x509_check_name ( cert, name ) != 0 ) )
 			continue;
-		if ( ( rc = cms_verify_signer_info ( sig, info, data, len, time,
+		if ( ( rc = cms_verify_signer_info ( sig, info, image, time,
 						     store, root ) ) != 0 )
 			return rc;
 		count++;
@@ -21,10 +21,51 @@
 
 FILE_LICENCE ( GPL2_OR_LATER );
 
+#include <stdint.h>
 #include <ipxe/crc32.h>
 
 #define CRCPOLY		0xedb88320
 
+/** Number of slicing tables
+ *
+ * Eight tables allow eight bytes to be consumed per iteration of the
+ * main loop, which is roughly an order of magnitude faster than the
+ * original bit-at-a-time loop.  The tables are generated on first
+ * use, trading a few thousand cycles at startup for 8kB of image
+ * size.
+ */
+#define CRC32_SLICES 8
+
+/** CRC32 slicing tables */
+static u32 crc32_table[CRC32_SLICES][256];
+
+/**
+ * Generate CRC32 slicing tables
+ *
+ */
+static void crc32_generate ( void ) {
+	unsigned int i;
+	unsigned int j;
+	u32 crc;
+
+	/* Generate byte-at-a-time table */
+	for ( i = 0 ; i < 256 ; i++ ) {
+		crc = i;
+		for ( j = 0 ; j < 8 ; j++ )
+			crc = ( ( crc >> 1 ) ^ ( ( crc & 1 ) ? CRCPOLY : 0 ) );
+		crc32_table[0][i] = crc;
+	}
+
+	/* Generate remaining tables, each shifted one byte further */
+	for ( i = 0 ; i < 256 ; i++ ) {
+		crc = crc32_table[0][i];
+		for ( j = 1 ; j < CRC32_SLICES ; j++ ) {
+			crc = ( crc32_table[0][ crc & 0xff ] ^ ( crc >> 8 ) );
+			crc32_table[j][i] = crc;
+		}
+	}
+}
+
 /**
  * Calculate 32-bit little-endian CRC checksum
  *
@@ -40,15 +81,42 @@ u32 crc32_le ( u32 seed, const void *data, size_t len )
 {
 	u32 crc = seed;
 	const u8 *src = data;
-	u32 mult;
-	int i;
+	const u32 *src32;
+	u32 lo;
+	u32 hi;
+
+	/* Generate slicing tables on first use */
+	if ( ! crc32_table[0][1] )
+		crc32_generate();
 
+	/* Consume bytes up to a 32-bit boundary */
+	while ( len && ( ( ( intptr_t ) src ) & 0x3 ) ) {
+		crc = ( crc32_table[0][ ( crc ^ *src++ ) & 0xff ] ^
+			( crc >> 8 ) );
+		len--;
+	}
+
+	/* Consume eight bytes per iteration (slicing-by-8) */
+	src32 = ( ( const u32 * ) src );
+	while ( len >= 8 ) {
+		lo = ( *src32++ ^ crc );
+		hi = *src32++;
+		crc = ( crc32_table[7][ ( lo >>  0 ) & 0xff ] ^
+			crc32_table[6][ ( lo >>  8 ) & 0xff ] ^
+			crc32_table[5][ ( lo >> 16 ) & 0xff ] ^
+			crc32_table[4][ ( lo >> 24 ) & 0xff ] ^
+			crc32_table[3][ ( hi >>  0 ) & 0xff ] ^
+			crc32_table[2][ ( hi >>  8 ) & 0xff ] ^
+			crc32_table[1][ ( hi >> 16 ) & 0xff ] ^
+			crc32_table[0][ ( hi >> 24 ) & 0xff ] );
+		len -= 8;
+	}
+
+	/* Consume remaining bytes */
+	src = ( ( const u8 * ) src32 );
 	while ( len-- ) {
-		crc ^= *src++;
-		for ( i = 0; i < 8; i++ ) {
-			mult = ( crc & 1 ) ? CRCPOLY : 0;
-			crc = ( crc >> 1 ) ^ mult;
-		}
+		crc = ( crc32_table[0][ ( crc ^ *src++ ) & 0xff ] ^
+			( crc >> 8 ) );
 	}
 
 	return crc;
@@ -61,8 +61,8 @@ static int cipher_null_setkey ( void *ctx __unused, const void *key __unused,
 	return 0;
 }
 
-static void cipher_null_setiv ( void *ctx __unused,
-				const void *iv __unused ) {
+static void cipher_null_setiv ( void *ctx __unused, const void *iv __unused,
+				size_t ivlen __unused ) {
 	/* Do nothing */
 }
 
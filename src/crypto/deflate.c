@@ -457,15 +457,30 @@ static void deflate_copy ( struct deflate_chunk *out,
 			   userptr_t start, size_t offset, size_t len ) {
 	size_t out_offset = out->offset;
 	size_t copy_len;
+	size_t frag_len;
 
-	/* Copy data one byte at a time, to allow for overlap */
+	/* Copy data in the largest possible non-overlapping
+	 * fragments.  A duplicated string may overlap its own copy,
+	 * in which case each fragment is limited to the duplication
+	 * distance: copying fragment by fragment then correctly
+	 * replicates the repeating pattern.
+	 */
 	if ( out_offset < out->len ) {
 		copy_len = ( out->len - out_offset );
 		if ( copy_len > len )
 			copy_len = len;
-		while ( copy_len-- ) {
-			memcpy_user ( out->data, out_offset++,
-				      start, offset++, 1 );
+		while ( copy_len ) {
+			frag_len = copy_len;
+			if ( ( start == out->data ) &&
+			     ( offset < out_offset ) &&
+			     ( frag_len > ( out_offset - offset ) ) ) {
+				frag_len = ( out_offset - offset );
+			}
+			memcpy_user ( out->data, out_offset, start, offset,
+				      frag_len );
+			out_offset += frag_len;
+			offset += frag_len;
+			copy_len -= frag_len;
 		}
 	}
 	out->offset += len;
@@ -821,8 +836,9 @@ int deflate_inflate ( struct deflate *deflate,
 	}
 
  lzhuf_litlen: {
+		uint8_t literals[64];
+		unsigned int stored = 0;
 		int code;
-		uint8_t byte;
 		unsigned int extra;
 		unsigned int bits;
 
@@ -831,21 +847,40 @@ int deflate_inflate ( struct deflate *deflate,
 
 			/* Decode Huffman code */
 			code = deflate_decode ( deflate, in, &deflate->litlen );
-			if ( code < 0 ) {
-				deflate->resume = &&lzhuf_litlen;
-				return 0;
+
+			/* Store literal values, copying to the output
+			 * buffer only when the batch fills up.
+			 */
+			if ( ( code >= 0 ) && ( code < DEFLATE_LITLEN_END ) ) {
+				DBGCP ( deflate, "DEFLATE %p literal %#02x "
+					"('%c')\n", deflate, code,
+					( isprint ( code ) ? code : '.' ) );
+				literals[stored++] = code;
+				if ( stored == sizeof ( literals ) ) {
+					deflate_copy ( out,
+						       virt_to_user ( literals ),
+						       0, stored );
+					stored = 0;
+				}
+				continue;
+			}
+
+			/* Flush any stored literals before leaving the
+			 * decode loop, since a duplicated string may
+			 * reference them via the output buffer.
+			 */
+			if ( stored ) {
+				deflate_copy ( out, virt_to_user ( literals ),
+					       0, stored );
+				stored = 0;
 			}
 
 			/* Handle according to code type */
-			if ( code < DEFLATE_LITLEN_END ) {
+			if ( code < 0 ) {
 
-				/* Literal value: copy to output buffer */
-				byte = code;
-				DBGCP ( deflate, "DEFLATE %p literal %#02x "
-					"('%c')\n", deflate, byte,
-					( isprint ( byte ) ? byte : '.' ) );
-				deflate_copy ( out, virt_to_user ( &byte ), 0,
-					       sizeof ( byte ) );
+				/* Await further input */
+				deflate->resume = &&lzhuf_litlen;
+				return 0;
 
 			} else if ( code == DEFLATE_LITLEN_END ) {
 
@@ -0,0 +1,343 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Galois/Counter Mode (GCM)
+ *
+ * The GCM algorithm is specified in NIST Special Publication 800-38D.
+ *
+ * Encryption and authentication are performed in a single pass over
+ * the data: each block of ciphertext is produced by counter-mode
+ * encryption and immediately incorporated into the authentication
+ * hash.  Additional authenticated data and data may be accumulated
+ * incrementally and need not be aligned to cipher blocks.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/crypto.h>
+#include <ipxe/gcm.h>
+
+/**
+ * Multiply accumulated hash by hash key in GF(2^128)
+ *
+ * @v key		Hash key (H)
+ * @v hash		Accumulated hash (X) to be updated
+ *
+ * The multiplication is performed bitwise over 64-bit words, using
+ * the field polynomial representation R = 0xe1 || 0^120 defined by
+ * the GCM specification.
+ */
+static void gcm_multiply_key ( const union gcm_block *key,
+			       union gcm_block *hash ) {
+	uint64_t x0 = be64_to_cpu ( hash->qword[0] );
+	uint64_t x1 = be64_to_cpu ( hash->qword[1] );
+	uint64_t v0 = be64_to_cpu ( key->qword[0] );
+	uint64_t v1 = be64_to_cpu ( key->qword[1] );
+	uint64_t z0 = 0;
+	uint64_t z1 = 0;
+	unsigned int carry;
+	unsigned int i;
+
+	/* Iterate over bits of the accumulated hash, most significant
+	 * bit first.
+	 */
+	for ( i = 0 ; i < 128 ; i++ ) {
+
+		/* Accumulate multiplicand if bit is set */
+		if ( x0 & 0x8000000000000000ULL ) {
+			z0 ^= v0;
+			z1 ^= v1;
+		}
+		x0 = ( ( x0 << 1 ) | ( x1 >> 63 ) );
+		x1 <<= 1;
+
+		/* Multiply multiplicand by (x), reducing modulo the
+		 * field polynomial.
+		 */
+		carry = ( v1 & 0x1 );
+		v1 = ( ( v1 >> 1 ) | ( v0 << 63 ) );
+		v0 >>= 1;
+		if ( carry )
+			v0 ^= 0xe100000000000000ULL;
+	}
+
+	/* Store result */
+	hash->qword[0] = cpu_to_be64 ( z0 );
+	hash->qword[1] = cpu_to_be64 ( z1 );
+}
+
+/**
+ * Increment counter value
+ *
+ * @v ctr		Counter
+ */
+static void gcm_count ( union gcm_block *ctr ) {
+
+	/* Increment value in final 32 bits of counter */
+	ctr->word[3] = cpu_to_be32 ( be32_to_cpu ( ctr->word[3] ) + 1 );
+}
+
+/**
+ * Incorporate data into accumulated hash
+ *
+ * @v gcm_ctx		GCM context
+ * @v data		Data
+ * @v len		Length of data
+ * @v total		Running total length to be updated
+ *
+ * The hash block is multiplied by the hash key whenever a full block
+ * has been accumulated; any partial final block is retained in the
+ * accumulated hash to be completed by subsequent data (or padded with
+ * zeroes upon finalisation).
+ */
+static void gcm_absorb ( struct gcm_context *gcm_ctx, const void *data,
+			 size_t len, uint64_t *total ) {
+	const uint8_t *byte = data;
+	size_t offset;
+
+	while ( len-- ) {
+		offset = ( (*total)++ & 0xf );
+		gcm_ctx->hash.byte[offset] ^= *(byte++);
+		if ( offset == 0xf )
+			gcm_multiply_key ( &gcm_ctx->key, &gcm_ctx->hash );
+	}
+}
+
+/**
+ * Encrypt or decrypt data
+ *
+ * @v ctx		Underlying cipher context
+ * @v src		Input data
+ * @v dst		Output data, or NULL for additional data
+ * @v len		Length of data
+ * @v raw_cipher	Underlying cipher algorithm
+ * @v gcm_ctx		GCM context
+ * @v decrypting	Input data is ciphertext
+ */
+static void gcm_cipher ( void *ctx, const void *src, void *dst, size_t len,
+			 struct cipher_algorithm *raw_cipher,
+			 struct gcm_context *gcm_ctx, int decrypting ) {
+	const uint8_t *in = src;
+	uint8_t *out = dst;
+	size_t offset;
+	uint8_t byte;
+
+	/* Avoid prematurely padding the additional data */
+	if ( ! len )
+		return;
+
+	/* Additional data is authenticated but not encrypted, and
+	 * must be provided before any data proper.
+	 */
+	if ( ! out ) {
+		assert ( gcm_ctx->len.data == 0 );
+		gcm_absorb ( gcm_ctx, in, len, &gcm_ctx->len.add );
+		return;
+	}
+
+	/* Pad any remaining additional data with zeroes (by completing
+	 * the current hash block) before processing data proper.
+	 */
+	if ( ( gcm_ctx->len.data == 0 ) && ( gcm_ctx->len.add & 0xf ) )
+		gcm_multiply_key ( &gcm_ctx->key, &gcm_ctx->hash );
+
+	/* Encrypt or decrypt data, incorporating the ciphertext into
+	 * the authentication hash as it is produced or consumed.
+	 */
+	while ( len-- ) {
+
+		/* Generate a new keystream block if needed */
+		offset = ( gcm_ctx->len.data & 0xf );
+		if ( offset == 0 ) {
+			gcm_count ( &gcm_ctx->ctr );
+			cipher_encrypt ( raw_cipher, ctx, &gcm_ctx->ctr,
+					 &gcm_ctx->pad,
+					 sizeof ( gcm_ctx->pad ) );
+		}
+
+		/* Encrypt or decrypt one byte */
+		byte = *(in++);
+		if ( decrypting ) {
+			gcm_ctx->hash.byte[offset] ^= byte;
+			byte ^= gcm_ctx->pad.byte[offset];
+		} else {
+			byte ^= gcm_ctx->pad.byte[offset];
+			gcm_ctx->hash.byte[offset] ^= byte;
+		}
+		*(out++) = byte;
+		gcm_ctx->len.data++;
+
+		/* Multiply hash at the end of each block */
+		if ( offset == 0xf )
+			gcm_multiply_key ( &gcm_ctx->key, &gcm_ctx->hash );
+	}
+}
+
+/**
+ * Set key
+ *
+ * @v ctx		Underlying cipher context
+ * @v key		Key
+ * @v keylen		Key length
+ * @v raw_cipher	Underlying cipher algorithm
+ * @v gcm_ctx		GCM context
+ * @ret rc		Return status code
+ */
+int gcm_setkey ( void *ctx, const void *key, size_t keylen,
+		 struct cipher_algorithm *raw_cipher,
+		 struct gcm_context *gcm_ctx ) {
+	int rc;
+
+	/* Set underlying block cipher key */
+	if ( ( rc = cipher_setkey ( raw_cipher, ctx, key, keylen ) ) != 0 )
+		return rc;
+
+	/* Generate hash key by encrypting an all-zeroes block */
+	memset ( gcm_ctx, 0, sizeof ( *gcm_ctx ) );
+	cipher_encrypt ( raw_cipher, ctx, &gcm_ctx->key, &gcm_ctx->key,
+			 sizeof ( gcm_ctx->key ) );
+
+	return 0;
+}
+
+/**
+ * Set initialisation vector
+ *
+ * @v ctx		Underlying cipher context
+ * @v iv		Initialisation vector
+ * @v ivlen		Initialisation vector length
+ * @v raw_cipher	Underlying cipher algorithm
+ * @v gcm_ctx		GCM context
+ */
+void gcm_setiv ( void *ctx, const void *iv, size_t ivlen,
+		 struct cipher_algorithm *raw_cipher,
+		 struct gcm_context *gcm_ctx ) {
+
+	/* Reset accumulated state */
+	memset ( &gcm_ctx->hash, 0, sizeof ( gcm_ctx->hash ) );
+	memset ( &gcm_ctx->ctr, 0, sizeof ( gcm_ctx->ctr ) );
+	memset ( &gcm_ctx->len, 0, sizeof ( gcm_ctx->len ) );
+
+	/* Construct initial counter value */
+	if ( ivlen == ( sizeof ( gcm_ctx->ctr ) - sizeof ( uint32_t ) ) ) {
+
+		/* An initialisation vector of exactly 96 bits is used
+		 * directly, with a 32-bit counter starting at one.
+		 */
+		memcpy ( gcm_ctx->ctr.byte, iv, ivlen );
+		gcm_ctx->ctr.word[3] = cpu_to_be32 ( 1 );
+
+	} else {
+
+		/* Other lengths are hashed (along with the bit
+		 * length) to produce the initial counter value.
+		 */
+		gcm_absorb ( gcm_ctx, iv, ivlen, &gcm_ctx->len.data );
+		if ( gcm_ctx->len.data & 0xf )
+			gcm_multiply_key ( &gcm_ctx->key, &gcm_ctx->hash );
+		gcm_ctx->hash.qword[1] ^=
+			cpu_to_be64 ( ( ( uint64_t ) ivlen ) * 8 );
+		gcm_multiply_key ( &gcm_ctx->key, &gcm_ctx->hash );
+		memcpy ( &gcm_ctx->ctr, &gcm_ctx->hash,
+			 sizeof ( gcm_ctx->ctr ) );
+		memset ( &gcm_ctx->hash, 0, sizeof ( gcm_ctx->hash ) );
+		memset ( &gcm_ctx->len, 0, sizeof ( gcm_ctx->len ) );
+	}
+
+	/* Generate authentication tag mask */
+	cipher_encrypt ( raw_cipher, ctx, &gcm_ctx->ctr, &gcm_ctx->mask,
+			 sizeof ( gcm_ctx->mask ) );
+}
+
+/**
+ * Encrypt data
+ *
+ * @v ctx		Underlying cipher context
+ * @v src		Data to encrypt
+ * @v dst		Buffer for encrypted data, or NULL for additional data
+ * @v len		Length of data
+ * @v raw_cipher	Underlying cipher algorithm
+ * @v gcm_ctx		GCM context
+ */
+void gcm_encrypt ( void *ctx, const void *src, void *dst, size_t len,
+		   struct cipher_algorithm *raw_cipher,
+		   struct gcm_context *gcm_ctx ) {
+
+	gcm_cipher ( ctx, src, dst, len, raw_cipher, gcm_ctx, 0 );
+}
+
+/**
+ * Decrypt data
+ *
+ * @v ctx		Underlying cipher context
+ * @v src		Data to decrypt
+ * @v dst		Buffer for decrypted data, or NULL for additional data
+ * @v len		Length of data
+ * @v raw_cipher	Underlying cipher algorithm
+ * @v gcm_ctx		GCM context
+ */
+void gcm_decrypt ( void *ctx, const void *src, void *dst, size_t len,
+		   struct cipher_algorithm *raw_cipher,
+		   struct gcm_context *gcm_ctx ) {
+
+	gcm_cipher ( ctx, src, dst, len, raw_cipher, gcm_ctx, 1 );
+}
+
+/**
+ * Generate authentication tag
+ *
+ * @v ctx		Underlying cipher context
+ * @v auth		Authentication tag
+ * @v raw_cipher	Underlying cipher algorithm
+ * @v gcm_ctx		GCM context
+ */
+void gcm_auth ( void *ctx __unused, void *auth,
+		struct cipher_algorithm *raw_cipher __unused,
+		struct gcm_context *gcm_ctx ) {
+	union gcm_block *tag = auth;
+	unsigned int i;
+
+	/* Pad any remaining data with zeroes (by completing the
+	 * current hash block).
+	 */
+	if ( gcm_ctx->len.data ? ( gcm_ctx->len.data & 0xf ) :
+	     ( gcm_ctx->len.add & 0xf ) ) {
+		gcm_multiply_key ( &gcm_ctx->key, &gcm_ctx->hash );
+	}
+
+	/* Incorporate bit lengths of additional data and data */
+	gcm_ctx->hash.qword[0] ^= cpu_to_be64 ( gcm_ctx->len.add * 8 );
+	gcm_ctx->hash.qword[1] ^= cpu_to_be64 ( gcm_ctx->len.data * 8 );
+	gcm_multiply_key ( &gcm_ctx->key, &gcm_ctx->hash );
+
+	/* Generate tag by masking with the encrypted initial counter */
+	for ( i = 0 ; i < sizeof ( tag->byte ) ; i++ )
+		tag->byte[i] = ( gcm_ctx->hash.byte[i] ^
+				 gcm_ctx->mask.byte[i] );
+}
@@ -98,6 +98,71 @@ void hmac_init ( struct digest_algorithm *digest, void *digest_ctx,
 	digest_update ( digest, digest_ctx, k_ipad, sizeof ( k_ipad ) );
 }
 
+/**
+ * Precompute HMAC pad digest contexts
+ *
+ * @v digest		Digest algorithm to use
+ * @v key		Key
+ * @v key_len		Length of key
+ * @v ipad_ctx		Input pad digest context to fill in
+ * @v opad_ctx		Output pad digest context to fill in
+ *
+ * Precompute the digest states resulting from processing the input and
+ * output key pads, allowing the two key pad block computations to be
+ * amortised across multiple MAC operations using the same key (via
+ * hmac_resume() and hmac_final_precomputed()).
+ */
+void hmac_precompute ( struct digest_algorithm *digest, const void *key,
+		       size_t key_len, void *ipad_ctx, void *opad_ctx ) {
+	unsigned char k_pad[digest->blocksize];
+	uint8_t reduced[digest->digestsize];
+	unsigned int i;
+
+	/* Reduce key if necessary */
+	if ( key_len > sizeof ( k_pad ) ) {
+		digest_init ( digest, ipad_ctx );
+		digest_update ( digest, ipad_ctx, key, key_len );
+		digest_final ( digest, ipad_ctx, reduced );
+		key = reduced;
+		key_len = sizeof ( reduced );
+	}
+
+	/* Construct input pad and start inner hash */
+	memset ( k_pad, 0, sizeof ( k_pad ) );
+	memcpy ( k_pad, key, key_len );
+	for ( i = 0 ; i < sizeof ( k_pad ) ; i++ )
+		k_pad[i] ^= 0x36;
+	digest_init ( digest, ipad_ctx );
+	digest_update ( digest, ipad_ctx, k_pad, sizeof ( k_pad ) );
+
+	/* Construct output pad and start outer hash */
+	for ( i = 0 ; i < sizeof ( k_pad ) ; i++ )
+		k_pad[i] ^= ( 0x36 ^ 0x5c );
+	digest_init ( digest, opad_ctx );
+	digest_update ( digest, opad_ctx, k_pad, sizeof ( k_pad ) );
+}
+
+/**
+ * Finalise HMAC using precomputed output pad digest context
+ *
+ * @v digest		Digest algorithm to use
+ * @v digest_ctx	Digest context
+ * @v opad_ctx		Precomputed output pad digest context
+ * @v hmac		HMAC digest to fill in
+ */
+void hmac_final_precomputed ( struct digest_algorithm *digest,
+			      void *digest_ctx, const void *opad_ctx,
+			      void *hmac ) {
+
+	/* Finish inner hash */
+	digest_final ( digest, digest_ctx, hmac );
+
+	/* Perform outer hash, resuming from the precomputed state */
+	memcpy ( digest_ctx, opad_ctx, digest->ctxsize );
+	digest_update ( digest, digest_ctx, hmac, digest->digestsize );
+	digest_final ( digest, digest_ctx, hmac );
+}
+
 /**
  * Finalise HMAC
  *
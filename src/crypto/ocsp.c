@@ -958,8 +958,12 @@ int ocsp_validate ( struct ocsp_check *ocsp, time_t time ) {
 	DBGC2 ( ocsp, "OCSP %p \"%s\" response is valid (at time %lld)\n",
 		ocsp, x509_name ( ocsp->cert ), time );
 
-	/* Mark certificate as passing OCSP verification */
+	/* Mark certificate as passing OCSP verification, recording
+	 * the time at which the status must be rechecked
+	 */
 	ocsp->cert->extensions.auth_info.ocsp.good = 1;
+	ocsp->cert->extensions.auth_info.ocsp.next_update =
+		response->next_update;
 
 	/* Validate certificate against issuer */
 	if ( ( rc = x509_validate ( ocsp->cert, ocsp->issuer, time,
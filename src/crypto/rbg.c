@@ -53,28 +53,74 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stdint.h>
 #include <string.h>
 #include <ipxe/init.h>
+#include <ipxe/process.h>
 #include <ipxe/settings.h>
 #include <ipxe/uuid.h>
 #include <ipxe/crypto.h>
 #include <ipxe/drbg.h>
 #include <ipxe/rbg.h>
 
+/** Low-water mark for the buffered random bit pool
+ *
+ * The pool will be topped up during otherwise idle time once fewer
+ * than this many bytes remain.  The value is chosen to cover a
+ * typical burst of requests (e.g. a TLS client random plus a record
+ * initialisation vector) without a synchronous refill.
+ */
+#define RBG_POOL_LOW 48
+
 /** The RBG */
 struct random_bit_generator rbg;
 
 /**
- * Start up RBG
+ * Refill random bit pool
  *
  * @ret rc		Return status code
  *
- * This is the RBG_Startup function defined in ANS X9.82 Part 4 (April
- * 2011 Draft) Section 9.1.2.2.
+ * Regenerate the entire pool (discarding any unconsumed bytes) with a
+ * single batched DRBG invocation.  This, along with any reseed that
+ * the DRBG decides to perform, is the expensive operation that the
+ * pool exists to keep off the critical path.
  */
-static int rbg_startup ( void ) {
+static int rbg_refill ( void ) {
+	int rc;
+
+	/* Generate a full pool of bits */
+	if ( ( rc = drbg_generate ( &rbg.state, NULL, 0, 0, rbg.pool,
+				    sizeof ( rbg.pool ) ) ) != 0 ) {
+		DBGC ( &rbg, "RBG could not refill pool: %s\n",
+		       strerror ( rc ) );
+		rbg.remaining = 0;
+		return rc;
+	}
+	rbg.remaining = sizeof ( rbg.pool );
+
+	return 0;
+}
+
+/**
+ * Instantiate DRBG, if not already attempted
+ *
+ * @ret rc		Return status code
+ *
+ * Instantiation (and its associated entropy gathering, which can
+ * take hundreds of milliseconds on some platforms) is deferred from
+ * startup to the background refill process, so that it overlaps
+ * with link negotiation and other startup activity instead of
+ * adding to the serial sum of startup latencies.  The first
+ * consumer of random bits joins by instantiating synchronously if
+ * the background process has not yet run.
+ */
+static int rbg_instantiate ( void ) {
 	union uuid uuid;
 	int len;
 	int rc;
 
+	/* Do nothing if instantiation has already been attempted */
+	if ( rbg.instantiated )
+		return 0;
+	rbg.instantiated = 1;
+
 	/* Try to obtain system UUID for use as personalisation
 	 * string, in accordance with ANS X9.82 Part 3-2007 Section
 	 * 8.5.2.  If no UUID is available, proceed without a
@@ -97,22 +143,125 @@ static int rbg_startup ( void ) {
 	return 0;
 }
 
+/**
+ * Generate bits using RBG
+ *
+ * @v additional	Additional input
+ * @v additional_len	Length of additional input
+ * @v prediction_resist	Prediction resistance is required
+ * @v data		Output buffer
+ * @v len		Length of output buffer
+ * @ret rc		Return status code
+ *
+ * This is the RBG_Generate function defined in ANS X9.82 Part 4
+ * (April 2011 Draft) Section 9.1.2.2.
+ */
+int rbg_generate ( const void *additional, size_t additional_len,
+		   int prediction_resist, void *data, size_t len ) {
+	void *slice;
+	int rc;
+
+	/* Instantiate DRBG, if not already done in the background */
+	if ( ( ! rbg.instantiated ) && ( ( rc = rbg_instantiate() ) != 0 ) )
+		return rc;
+
+	/* Bypass the pool for requests that supply additional input,
+	 * require prediction resistance, or exceed the pool size.
+	 * Prediction resistance forces a reseed; discard any buffered
+	 * bits generated prior to the reseed.
+	 */
+	if ( additional_len || prediction_resist ||
+	     ( len > sizeof ( rbg.pool ) ) ) {
+		if ( prediction_resist )
+			rbg.remaining = 0;
+		return drbg_generate ( &rbg.state, additional, additional_len,
+				       prediction_resist, data, len );
+	}
+
+	/* Refill pool if insufficient bits remain */
+	if ( ( len > rbg.remaining ) && ( ( rc = rbg_refill() ) != 0 ) )
+		return rc;
+
+	/* Hand out (and scrub) a slice of the pool */
+	slice = &rbg.pool[ sizeof ( rbg.pool ) - rbg.remaining ];
+	memcpy ( data, slice, len );
+	memset ( slice, 0, len );
+	rbg.remaining -= len;
+
+	/* Top up the pool during otherwise idle time once it runs low */
+	if ( ( rbg.remaining < RBG_POOL_LOW ) &&
+	     ( ! process_running ( &rbg.process ) ) ) {
+		process_add ( &rbg.process );
+	}
+
+	return 0;
+}
+
+/**
+ * Top up random bit pool
+ *
+ * @v rbg		RBG
+ */
+static void rbg_step ( struct random_bit_generator *rbg ) {
+
+	/* Instantiate DRBG, if not already done */
+	if ( ( ! rbg->instantiated ) && ( rbg_instantiate() != 0 ) )
+		return;
+
+	/* Refill pool if still below the low-water mark */
+	if ( rbg->remaining < RBG_POOL_LOW )
+		rbg_refill();
+}
+
+/** Pool refill process descriptor */
+static struct process_descriptor rbg_process_desc =
+	PROC_DESC_ONCE ( struct random_bit_generator, process, rbg_step );
+
+/**
+ * Start up RBG
+ *
+ * @ret rc		Return status code
+ *
+ * This is the RBG_Startup function defined in ANS X9.82 Part 4 (April
+ * 2011 Draft) Section 9.1.2.2.
+ */
+static int rbg_startup ( void ) {
+
+	/* Initialise pool refill process */
+	process_init_stopped ( &rbg.process, &rbg_process_desc, NULL );
+
+	/* Schedule DRBG instantiation and initial pool fill in the
+	 * background, so that neither startup itself nor the first
+	 * consumer pays the generation (and entropy-gathering) cost.
+	 */
+	process_add ( &rbg.process );
+
+	return 0;
+}
+
 /**
  * Shut down RBG
  *
  */
 static void rbg_shutdown ( void ) {
 
+	/* Stop pool refill process */
+	process_del ( &rbg.process );
+
+	/* Scrub pool */
+	memset ( rbg.pool, 0, sizeof ( rbg.pool ) );
+	rbg.remaining = 0;
+
 	/* Uninstantiate DRBG */
 	drbg_uninstantiate ( &rbg.state );
+	rbg.instantiated = 0;
 }
 
 /** RBG startup function */
 static void rbg_startup_fn ( void ) {
 
-	/* Start up RBG.  There is no way to report an error at this
-	 * stage, but a failed startup will result in an invalid DRBG
-	 * that refuses to generate bits.
+	/* Start up RBG.  A failed instantiation will result in an
+	 * invalid DRBG that refuses to generate bits.
 	 */
 	rbg_startup();
 }
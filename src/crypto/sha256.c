@@ -157,6 +157,10 @@ static void sha256_digest ( struct sha256_context *context ) {
 	DBGC_HDA ( context, context->len, &context->ddd.dd.data,
 		   sizeof ( context->ddd.dd.data ) );
 
+	/* Use accelerated implementation, if supported */
+	if ( sha256_accel_digest ( context ) == 0 )
+		goto done;
+
 	/* Convert h[0..7] to host-endian, and initialise a, b, c, d,
 	 * e, f, g, h, and w[0..15]
 	 */
@@ -202,6 +206,7 @@ static void sha256_digest ( struct sha256_context *context ) {
 				      u.ddd.dd.digest.h[i] );
 	}
 
+ done:
 	DBGC ( context, "SHA256 digested:\n" );
 	DBGC_HDA ( context, 0, &context->ddd.dd.digest,
 		   sizeof ( context->ddd.dd.digest ) );
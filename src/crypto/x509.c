@@ -1307,8 +1307,8 @@ int x509_check_time ( struct x509_certificate *cert, time_t time ) {
  * The issuing certificate must have already been validated.
  *
  * Validation results are cached: if a certificate has already been
- * successfully validated then @c issuer, @c time, and @c root will be
- * ignored.
+ * successfully validated (and the cached result has not yet expired)
+ * then @c issuer and @c root will be ignored.
  */
 int x509_validate ( struct x509_certificate *cert,
 		    struct x509_certificate *issuer,
@@ -1320,9 +1320,18 @@ int x509_validate ( struct x509_certificate *cert,
 	if ( ! root )
 		root = &root_certificates;
 
-	/* Return success if certificate has already been validated */
-	if ( x509_is_valid ( cert ) )
-		return 0;
+	/* Return success if certificate has already been validated
+	 * and the cached validation result has not yet expired
+	 */
+	if ( x509_is_valid ( cert ) ) {
+		if ( ( cert->valid_until == 0 ) ||
+		     ( time <= cert->valid_until ) )
+			return 0;
+		DBGC ( cert, "X509 %p \"%s\" cached validation has expired\n",
+		       cert, x509_name ( cert ) );
+		x509_invalidate ( cert );
+		cert->extensions.auth_info.ocsp.good = 0;
+	}
 
 	/* Fail if certificate is invalid at specified time */
 	if ( ( rc = x509_check_time ( cert, time ) ) != 0 )
@@ -1332,6 +1341,7 @@ int x509_validate ( struct x509_certificate *cert,
 	if ( x509_check_root ( cert, root ) == 0 ) {
 		cert->flags |= X509_FL_VALIDATED;
 		cert->path_remaining = ( cert->extensions.basic.path_len + 1 );
+		cert->valid_until = cert->validity.not_after.time;
 		return 0;
 	}
 
@@ -1375,6 +1385,23 @@ int x509_validate ( struct x509_certificate *cert,
 	if ( cert->path_remaining > max_path_remaining )
 		cert->path_remaining = max_path_remaining;
 
+	/* Record time at which this validation result expires, which
+	 * is constrained by our own validity period, the expiry of
+	 * the issuer's cached validation result, and the OCSP
+	 * response's nextUpdate time (where applicable).
+	 */
+	cert->valid_until = cert->validity.not_after.time;
+	if ( issuer->valid_until &&
+	     ( issuer->valid_until < cert->valid_until ) ) {
+		cert->valid_until = issuer->valid_until;
+	}
+	if ( cert->extensions.auth_info.ocsp.good &&
+	     cert->extensions.auth_info.ocsp.next_update &&
+	     ( cert->extensions.auth_info.ocsp.next_update <
+	       cert->valid_until ) ) {
+		cert->valid_until = cert->extensions.auth_info.ocsp.next_update;
+	}
+
 	/* Mark certificate as valid */
 	cert->flags |= X509_FL_VALIDATED;
 
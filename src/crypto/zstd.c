@@ -0,0 +1,1540 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Zstandard decompression
+ *
+ * This is a decompressor for the Zstandard format as defined in RFC
+ * 8878.  It is a one-shot decompressor: the complete compressed input
+ * must be available, and the decompressed output is written directly
+ * to the output data buffer, which thereby also serves as the match
+ * window.  (This suits our use cases, in which both the compressed
+ * and decompressed images are fully resident in memory; it avoids the
+ * need for a separate window buffer.)
+ *
+ * Each compressed block (at most 128kB) is staged into a temporary
+ * buffer so that the entropy decoding stages can operate on directly
+ * addressable memory.
+ *
+ * Dictionaries are not supported.  Content checksums (and the
+ * optional header checksum) are skipped rather than verified;
+ * downloaded images are verified cryptographically where verification
+ * is required.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <assert.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/zstd.h>
+
+/* Error codes */
+#define EINVAL_MAGIC __einfo_error ( EINFO_EINVAL_MAGIC )
+#define EINFO_EINVAL_MAGIC __einfo_uniqify \
+	( EINFO_EINVAL, 0x01, "Invalid magic number" )
+#define EINVAL_TRUNCATED __einfo_error ( EINFO_EINVAL_TRUNCATED )
+#define EINFO_EINVAL_TRUNCATED __einfo_uniqify \
+	( EINFO_EINVAL, 0x02, "Truncated input" )
+#define EINVAL_RESERVED __einfo_error ( EINFO_EINVAL_RESERVED )
+#define EINFO_EINVAL_RESERVED __einfo_uniqify \
+	( EINFO_EINVAL, 0x03, "Reserved value used" )
+#define EINVAL_BLOCK __einfo_error ( EINFO_EINVAL_BLOCK )
+#define EINFO_EINVAL_BLOCK __einfo_uniqify \
+	( EINFO_EINVAL, 0x04, "Invalid block" )
+#define EINVAL_FSE __einfo_error ( EINFO_EINVAL_FSE )
+#define EINFO_EINVAL_FSE __einfo_uniqify \
+	( EINFO_EINVAL, 0x05, "Invalid FSE table description" )
+#define EINVAL_HUF __einfo_error ( EINFO_EINVAL_HUF )
+#define EINFO_EINVAL_HUF __einfo_uniqify \
+	( EINFO_EINVAL, 0x06, "Invalid Huffman tree description" )
+#define EINVAL_LITERALS __einfo_error ( EINFO_EINVAL_LITERALS )
+#define EINFO_EINVAL_LITERALS __einfo_uniqify \
+	( EINFO_EINVAL, 0x07, "Invalid literals section" )
+#define EINVAL_SEQUENCES __einfo_error ( EINFO_EINVAL_SEQUENCES )
+#define EINFO_EINVAL_SEQUENCES __einfo_uniqify \
+	( EINFO_EINVAL, 0x08, "Invalid sequences section" )
+#define EINVAL_OFFSET __einfo_error ( EINFO_EINVAL_OFFSET )
+#define EINFO_EINVAL_OFFSET __einfo_uniqify \
+	( EINFO_EINVAL, 0x09, "Invalid match offset" )
+#define EINVAL_LENGTH __einfo_error ( EINFO_EINVAL_LENGTH )
+#define EINFO_EINVAL_LENGTH __einfo_uniqify \
+	( EINFO_EINVAL, 0x0a, "Incorrect decompressed length" )
+#define ENOTSUP_DICT __einfo_error ( EINFO_ENOTSUP_DICT )
+#define EINFO_ENOTSUP_DICT __einfo_uniqify \
+	( EINFO_ENOTSUP, 0x01, "Dictionaries not supported" )
+#define ENOTSUP_LEN __einfo_error ( EINFO_ENOTSUP_LEN )
+#define EINFO_ENOTSUP_LEN __einfo_uniqify \
+	( EINFO_ENOTSUP, 0x02, "No frame content size present" )
+
+/** Zstandard frame magic number */
+#define ZSTD_MAGIC 0xfd2fb528UL
+
+/** Skippable frame magic number (low bits masked off) */
+#define ZSTD_MAGIC_SKIP 0x184d2a50UL
+
+/** Skippable frame magic number mask */
+#define ZSTD_MAGIC_SKIP_MASK 0xfffffff0UL
+
+/** Frame header descriptor: dictionary ID flag */
+#define ZSTD_FHD_DICT( fhd ) ( ( (fhd) >> 0 ) & 0x3 )
+
+/** Frame header descriptor: content checksum flag */
+#define ZSTD_FHD_CKSUM( fhd ) ( ( (fhd) >> 2 ) & 0x1 )
+
+/** Frame header descriptor: reserved bit */
+#define ZSTD_FHD_RESERVED( fhd ) ( ( (fhd) >> 3 ) & 0x1 )
+
+/** Frame header descriptor: single segment flag */
+#define ZSTD_FHD_SINGLE( fhd ) ( ( (fhd) >> 5 ) & 0x1 )
+
+/** Frame header descriptor: frame content size flag */
+#define ZSTD_FHD_FCS( fhd ) ( ( (fhd) >> 6 ) & 0x3 )
+
+/** Maximum block size */
+#define ZSTD_MAX_BLOCK 0x20000
+
+/** Block header: last block flag */
+#define ZSTD_BLOCK_LAST( bh ) ( ( (bh) >> 0 ) & 0x1 )
+
+/** Block header: block type */
+#define ZSTD_BLOCK_TYPE( bh ) ( ( (bh) >> 1 ) & 0x3 )
+
+/** Block header: block size */
+#define ZSTD_BLOCK_SIZE( bh ) ( ( (bh) >> 3 ) & 0x1fffff )
+
+/** Block types */
+enum zstd_block_type {
+	/** Raw (uncompressed) block */
+	ZSTD_BLOCK_RAW = 0,
+	/** Run-length encoded block */
+	ZSTD_BLOCK_RLE,
+	/** Compressed block */
+	ZSTD_BLOCK_COMPRESSED,
+	/** Reserved */
+	ZSTD_BLOCK_RESERVED,
+};
+
+/** Literals types */
+enum zstd_lit_type {
+	/** Raw (uncompressed) literals */
+	ZSTD_LIT_RAW = 0,
+	/** Run-length encoded literals */
+	ZSTD_LIT_RLE,
+	/** Huffman-compressed literals */
+	ZSTD_LIT_COMPRESSED,
+	/** Huffman-compressed literals, reusing the previous tree */
+	ZSTD_LIT_TREELESS,
+};
+
+/** Maximum Huffman code length */
+#define ZSTD_HUF_MAX_BITS 11
+
+/** Maximum number of Huffman-coded symbols */
+#define ZSTD_HUF_MAX_SYMS 256
+
+/** Maximum FSE accuracy log (for any table) */
+#define ZSTD_FSE_MAX_LOG 9
+
+/** Maximum FSE accuracy log for Huffman weights */
+#define ZSTD_FSE_WEIGHT_LOG 6
+
+/** Maximum FSE accuracy log for literals lengths */
+#define ZSTD_FSE_LL_LOG 9
+
+/** Maximum FSE accuracy log for offsets */
+#define ZSTD_FSE_OF_LOG 8
+
+/** Maximum FSE accuracy log for match lengths */
+#define ZSTD_FSE_ML_LOG 9
+
+/** Number of literals length codes */
+#define ZSTD_LL_CODES 36
+
+/** Number of offset codes
+ *
+ * This is the largest offset code usable within our maximum supported
+ * window (i.e. the output buffer, which cannot exceed the address
+ * space).
+ */
+#define ZSTD_OF_CODES 32
+
+/** Number of match length codes */
+#define ZSTD_ML_CODES 53
+
+/** Sequence compression modes */
+enum zstd_seq_mode {
+	/** Predefined distribution */
+	ZSTD_SEQ_PREDEFINED = 0,
+	/** Run-length encoding (a single repeated symbol) */
+	ZSTD_SEQ_RLE,
+	/** FSE-compressed distribution */
+	ZSTD_SEQ_FSE,
+	/** Reuse distribution from previous block */
+	ZSTD_SEQ_REPEAT,
+};
+
+/** An FSE decoding table */
+struct zstd_fse {
+	/** Symbols */
+	uint8_t symbol[ 1 << ZSTD_FSE_MAX_LOG ];
+	/** Numbers of bits for state transitions */
+	uint8_t bits[ 1 << ZSTD_FSE_MAX_LOG ];
+	/** Baseline states for state transitions */
+	uint16_t base[ 1 << ZSTD_FSE_MAX_LOG ];
+	/** Accuracy log (table size is 2^log entries) */
+	unsigned int log;
+	/** Table contains a valid distribution */
+	int valid;
+};
+
+/** A Huffman decoding table */
+struct zstd_huf {
+	/** Symbols */
+	uint8_t symbol[ 1 << ZSTD_HUF_MAX_BITS ];
+	/** Numbers of bits for state transitions */
+	uint8_t bits[ 1 << ZSTD_HUF_MAX_BITS ];
+	/** Maximum code length (zero if table is not valid) */
+	unsigned int max_bits;
+};
+
+/** A decompressor */
+struct zstd {
+	/** Literals Huffman table (persists between blocks) */
+	struct zstd_huf huf;
+	/** Literals length FSE table (persists between blocks) */
+	struct zstd_fse ll;
+	/** Offset FSE table (persists between blocks) */
+	struct zstd_fse of;
+	/** Match length FSE table (persists between blocks) */
+	struct zstd_fse ml;
+	/** Repeated offset history */
+	unsigned long rep[3];
+	/** Offset of current frame within output buffer
+	 *
+	 * Matches may not reference data before this offset.
+	 */
+	size_t base;
+};
+
+/** A forward bitstream
+ *
+ * Bits are read from the least significant bit of each byte upwards,
+ * starting from the first byte.
+ */
+struct zstd_fbits {
+	/** Data */
+	const uint8_t *src;
+	/** Length of data (in bits) */
+	size_t len;
+	/** Current position (in bits) */
+	size_t pos;
+};
+
+/** A reverse bitstream
+ *
+ * The stream is read starting from the final byte, in which the
+ * highest set bit is a marker (and is not part of the stream).  Reads
+ * consume the requested number of bits downwards; reads beyond the
+ * start of the stream produce zero bits.
+ */
+struct zstd_rbits {
+	/** Data */
+	const uint8_t *src;
+	/** Current position (in bits remaining) */
+	ssize_t pos;
+};
+
+/** A parsed frame header */
+struct zstd_frame_header {
+	/** Content checksum is present */
+	int cksum;
+	/** Frame content size is present */
+	int has_fcs;
+	/** Frame content size */
+	uint64_t fcs;
+};
+
+/** Literals length code baselines */
+static const uint32_t zstd_ll_base[ZSTD_LL_CODES] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 18,
+	20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048,
+	4096, 8192, 16384, 32768, 65536,
+};
+
+/** Literals length code extra bits */
+static const uint8_t zstd_ll_bits[ZSTD_LL_CODES] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2,
+	2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+};
+
+/** Match length code baselines */
+static const uint32_t zstd_ml_base[ZSTD_ML_CODES] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
+	20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+	35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515,
+	1027, 2051, 4099, 8195, 16387, 32771, 65539,
+};
+
+/** Match length code extra bits */
+static const uint8_t zstd_ml_bits[ZSTD_ML_CODES] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 3, 3, 4, 4,
+	5, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+};
+
+/** Predefined literals length distribution */
+static const int16_t zstd_ll_default[ZSTD_LL_CODES] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1, -1, -1, -1, -1,
+};
+
+/** Predefined literals length distribution accuracy log */
+#define ZSTD_LL_DEFAULT_LOG 6
+
+/** Predefined offset distribution */
+static const int16_t zstd_of_default[29] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, -1, -1, -1, -1, -1,
+};
+
+/** Predefined offset distribution accuracy log */
+#define ZSTD_OF_DEFAULT_LOG 5
+
+/** Predefined match length distribution */
+static const int16_t zstd_ml_default[ZSTD_ML_CODES] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+/** Predefined match length distribution accuracy log */
+#define ZSTD_ML_DEFAULT_LOG 6
+
+/**
+ * Find highest set bit
+ *
+ * @v value		Value (must be non-zero)
+ * @ret bit		Highest set bit (0-based)
+ */
+static inline unsigned int zstd_hibit ( unsigned long value ) {
+
+	assert ( value != 0 );
+	return ( flsl ( value ) - 1 );
+}
+
+/**
+ * Read bits from a forward bitstream
+ *
+ * @v bs		Forward bitstream
+ * @v bits		Number of bits to read
+ * @v value		Value to fill in
+ * @ret rc		Return status code
+ */
+static int zstd_fbits_pull ( struct zstd_fbits *bs, unsigned int bits,
+			     unsigned int *value ) {
+	unsigned int i;
+	size_t pos;
+
+	if ( ( bs->pos + bits ) > bs->len )
+		return -EINVAL_TRUNCATED;
+	*value = 0;
+	for ( i = 0 ; i < bits ; i++ ) {
+		pos = bs->pos++;
+		*value |= ( ( ( bs->src[ pos >> 3 ] >> ( pos & 0x7 ) ) & 0x1 )
+			    << i );
+	}
+	return 0;
+}
+
+/**
+ * Align a forward bitstream to the next byte boundary
+ *
+ * @v bs		Forward bitstream
+ */
+static void zstd_fbits_align ( struct zstd_fbits *bs ) {
+
+	bs->pos = ( ( bs->pos + 0x7 ) & ~( ( size_t ) 0x7 ) );
+}
+
+/**
+ * Initialise a reverse bitstream
+ *
+ * @v bs		Reverse bitstream
+ * @v src		Data
+ * @v len		Length of data
+ * @ret rc		Return status code
+ */
+static int zstd_rbits_init ( struct zstd_rbits *bs, const uint8_t *src,
+			     size_t len ) {
+
+	/* The final byte must contain the end-of-stream marker bit */
+	if ( ( len == 0 ) || ( src[ len - 1 ] == 0 ) )
+		return -EINVAL_TRUNCATED;
+
+	bs->src = src;
+	bs->pos = ( ( ( len - 1 ) * 8 ) + zstd_hibit ( src[ len - 1 ] ) );
+	return 0;
+}
+
+/**
+ * Read bits from a reverse bitstream
+ *
+ * @v bs		Reverse bitstream
+ * @v bits		Number of bits to read
+ * @ret value		Value
+ *
+ * Reads beyond the start of the stream produce zero bits; this is
+ * relied upon by the Huffman weight decoding algorithm, in which the
+ * final state transitions deliberately exhaust the stream.
+ */
+static unsigned long zstd_rbits_pull ( struct zstd_rbits *bs,
+				       unsigned int bits ) {
+	unsigned long value = 0;
+	unsigned int i;
+	ssize_t pos;
+
+	bs->pos -= bits;
+	for ( i = 0 ; i < bits ; i++ ) {
+		pos = ( bs->pos + i );
+		if ( pos < 0 )
+			continue;
+		value |= ( ( ( unsigned long )
+			     ( ( bs->src[ pos >> 3 ] >> ( pos & 0x7 ) )
+			       & 0x1 ) ) << i );
+	}
+	return value;
+}
+
+/**
+ * Build an FSE decoding table from a distribution
+ *
+ * @v fse		FSE table to fill in
+ * @v probs		Normalised probabilities (-1 meaning "less than 1")
+ * @v count		Number of symbols
+ * @v log		Accuracy log
+ */
+static void zstd_fse_build ( struct zstd_fse *fse, const int16_t *probs,
+			     unsigned int count, unsigned int log ) {
+	uint16_t cells[ZSTD_HUF_MAX_SYMS];
+	unsigned int size = ( 1 << log );
+	unsigned int step = ( ( size >> 1 ) + ( size >> 3 ) + 3 );
+	unsigned int mask = ( size - 1 );
+	unsigned int high = size;
+	unsigned int pos = 0;
+	unsigned int sym;
+	unsigned int next;
+	unsigned int i;
+
+	assert ( log <= ZSTD_FSE_MAX_LOG );
+	assert ( count <= ( sizeof ( cells ) / sizeof ( cells[0] ) ) );
+
+	/* Symbols with "less than 1" probability are allocated a
+	 * single cell each, starting from the end of the table and
+	 * retreating.
+	 */
+	for ( sym = 0 ; sym < count ; sym++ ) {
+		if ( probs[sym] == -1 ) {
+			fse->symbol[--high] = sym;
+			cells[sym] = 1;
+		}
+	}
+
+	/* All remaining symbols are spread over the table in natural
+	 * order, each occupying as many cells as its probability,
+	 * using the standard FSE spread function.
+	 */
+	for ( sym = 0 ; sym < count ; sym++ ) {
+		if ( probs[sym] <= 0 )
+			continue;
+		cells[sym] = probs[sym];
+		for ( i = 0 ; i < ( ( unsigned int ) probs[sym] ) ; i++ ) {
+			fse->symbol[pos] = sym;
+			do {
+				pos = ( ( pos + step ) & mask );
+			} while ( pos >= high );
+		}
+	}
+	assert ( pos == 0 );
+
+	/* Calculate state transitions */
+	for ( i = 0 ; i < size ; i++ ) {
+		sym = fse->symbol[i];
+		next = cells[sym]++;
+		fse->bits[i] = ( log - zstd_hibit ( next ) );
+		fse->base[i] = ( ( next << fse->bits[i] ) - size );
+	}
+
+	fse->log = log;
+	fse->valid = 1;
+}
+
+/**
+ * Build a single-symbol (RLE) FSE decoding table
+ *
+ * @v fse		FSE table to fill in
+ * @v symbol		Symbol
+ */
+static void zstd_fse_rle ( struct zstd_fse *fse, unsigned int symbol ) {
+
+	fse->symbol[0] = symbol;
+	fse->bits[0] = 0;
+	fse->base[0] = 0;
+	fse->log = 0;
+	fse->valid = 1;
+}
+
+/**
+ * Read an FSE table description and build the decoding table
+ *
+ * @v fse		FSE table to fill in
+ * @v bs		Forward bitstream
+ * @v max_log		Maximum permitted accuracy log
+ * @v max_count		Maximum permitted number of symbols
+ * @ret rc		Return status code
+ */
+static int zstd_fse_read ( struct zstd_fse *fse, struct zstd_fbits *bs,
+			   unsigned int max_log, unsigned int max_count ) {
+	int16_t probs[ZSTD_HUF_MAX_SYMS];
+	unsigned int remaining;
+	unsigned int count = 0;
+	unsigned int log;
+	unsigned int bits;
+	unsigned int lower;
+	unsigned int threshold;
+	unsigned int value;
+	unsigned int repeat;
+	int prob;
+	int rc;
+
+	/* Read accuracy log */
+	if ( ( rc = zstd_fbits_pull ( bs, 4, &value ) ) != 0 )
+		return rc;
+	log = ( value + 5 );
+	if ( log > max_log )
+		return -EINVAL_FSE;
+
+	/* Read probabilities */
+	remaining = ( ( 1 << log ) + 1 );
+	while ( remaining > 1 ) {
+		if ( count >= max_count )
+			return -EINVAL_FSE;
+
+		/* Read a variable-length probability value: small
+		 * values use one fewer bit.
+		 */
+		bits = ( zstd_hibit ( remaining ) + 1 );
+		if ( ( rc = zstd_fbits_pull ( bs, bits, &value ) ) != 0 )
+			return rc;
+		lower = ( ( 1 << ( bits - 1 ) ) - 1 );
+		threshold = ( ( 1 << bits ) - 1 - remaining );
+		if ( ( value & lower ) < threshold ) {
+			bs->pos--;
+			value &= lower;
+		} else if ( value > lower ) {
+			value -= threshold;
+		}
+		prob = ( ( ( int ) value ) - 1 );
+		remaining -= ( ( prob < 0 ) ? -prob : prob );
+		probs[count++] = prob;
+
+		/* A zero probability is followed by a two-bit repeat
+		 * count for additional zero-probability symbols.
+		 */
+		if ( prob == 0 ) {
+			do {
+				if ( ( rc = zstd_fbits_pull ( bs, 2,
+							      &repeat ) ) != 0 )
+					return rc;
+				if ( ( count + repeat ) > max_count )
+					return -EINVAL_FSE;
+				memset ( &probs[count], 0,
+					 ( repeat * sizeof ( probs[0] ) ) );
+				count += repeat;
+			} while ( repeat == 3 );
+		}
+	}
+	zstd_fbits_align ( bs );
+
+	/* Build table */
+	zstd_fse_build ( fse, probs, count, log );
+
+	return 0;
+}
+
+/**
+ * Build a Huffman decoding table from a set of weights
+ *
+ * @v huf		Huffman table to fill in
+ * @v weights		Weights (excluding the implied final weight)
+ * @v count		Number of weights
+ * @ret rc		Return status code
+ */
+static int zstd_huf_build ( struct zstd_huf *huf, const uint8_t *weights,
+			    unsigned int count ) {
+	unsigned int rank[ ZSTD_HUF_MAX_BITS + 1 ];
+	unsigned int idx[ ZSTD_HUF_MAX_BITS + 1 ];
+	unsigned long sum = 0;
+	unsigned long left;
+	unsigned int max_bits;
+	unsigned int last;
+	unsigned int weight;
+	unsigned int cells;
+	unsigned int sym;
+	unsigned int i;
+	uint8_t all[ ZSTD_HUF_MAX_SYMS ];
+
+	/* Check and sum weights */
+	if ( count >= ZSTD_HUF_MAX_SYMS )
+		return -EINVAL_HUF;
+	for ( sym = 0 ; sym < count ; sym++ ) {
+		weight = weights[sym];
+		if ( weight > ZSTD_HUF_MAX_BITS )
+			return -EINVAL_HUF;
+		all[sym] = weight;
+		if ( weight )
+			sum += ( 1UL << ( weight - 1 ) );
+	}
+	if ( sum == 0 )
+		return -EINVAL_HUF;
+
+	/* Deduce the final weight, which completes the sum to a power
+	 * of two.
+	 */
+	max_bits = ( zstd_hibit ( sum ) + 1 );
+	if ( max_bits > ZSTD_HUF_MAX_BITS )
+		return -EINVAL_HUF;
+	left = ( ( 1UL << max_bits ) - sum );
+	if ( left & ( left - 1 ) )
+		return -EINVAL_HUF;
+	last = ( zstd_hibit ( left ) + 1 );
+	all[count++] = last;
+
+	/* Count symbols of each weight, and calculate the starting
+	 * table index for each weight (symbols with lower weights,
+	 * i.e. longer codes, occupy lower table indices).
+	 */
+	memset ( rank, 0, sizeof ( rank ) );
+	for ( sym = 0 ; sym < count ; sym++ )
+		rank[ all[sym] ]++;
+	idx[1] = 0;
+	for ( weight = 2 ; weight <= max_bits ; weight++ ) {
+		idx[weight] = ( idx[ weight - 1 ] +
+				( rank[ weight - 1 ] <<
+				  ( weight - 2 ) ) );
+	}
+
+	/* Fill the decoding table */
+	for ( sym = 0 ; sym < count ; sym++ ) {
+		weight = all[sym];
+		if ( ! weight )
+			continue;
+		cells = ( 1 << ( weight - 1 ) );
+		for ( i = 0 ; i < cells ; i++ ) {
+			huf->symbol[ idx[weight] + i ] = sym;
+			huf->bits[ idx[weight] + i ] =
+				( max_bits + 1 - weight );
+		}
+		idx[weight] += cells;
+	}
+	if ( idx[max_bits] != ( 1U << max_bits ) )
+		return -EINVAL_HUF;
+
+	huf->max_bits = max_bits;
+	return 0;
+}
+
+/**
+ * Read a Huffman tree description and build the decoding table
+ *
+ * @v zstd		Decompressor
+ * @v src		Tree description
+ * @v len		Maximum available length
+ * @v used		Length consumed to fill in
+ * @ret rc		Return status code
+ */
+static int zstd_huf_read ( struct zstd *zstd, const uint8_t *src, size_t len,
+			   size_t *used ) {
+	struct zstd_fse fse;
+	struct zstd_fbits fbs;
+	struct zstd_rbits rbs;
+	uint8_t weights[ ZSTD_HUF_MAX_SYMS ];
+	unsigned int count = 0;
+	unsigned int header;
+	unsigned int state1;
+	unsigned int state2;
+	size_t pos;
+	int rc;
+
+	/* Read header byte */
+	if ( len < 1 )
+		return -EINVAL_TRUNCATED;
+	header = src[0];
+
+	if ( header >= 128 ) {
+
+		/* Weights are stored directly, four bits each */
+		count = ( header - 127 );
+		*used = ( 1 + ( ( count + 1 ) / 2 ) );
+		if ( *used > len )
+			return -EINVAL_TRUNCATED;
+		for ( pos = 0 ; pos < count ; pos++ ) {
+			weights[pos] = ( ( pos & 1 ) ?
+					 ( src[ 1 + ( pos / 2 ) ] & 0xf ) :
+					 ( src[ 1 + ( pos / 2 ) ] >> 4 ) );
+		}
+
+	} else {
+
+		/* Weights are FSE-compressed, using two interleaved
+		 * states which decode alternately until the bitstream
+		 * is exhausted.
+		 */
+		*used = ( 1 + header );
+		if ( *used > len )
+			return -EINVAL_TRUNCATED;
+		fbs.src = &src[1];
+		fbs.len = ( header * 8 );
+		fbs.pos = 0;
+		if ( ( rc = zstd_fse_read ( &fse, &fbs, ZSTD_FSE_WEIGHT_LOG,
+					    ZSTD_HUF_MAX_SYMS ) ) != 0 )
+			return rc;
+		pos = ( fbs.pos / 8 );
+		if ( ( rc = zstd_rbits_init ( &rbs, &fbs.src[pos],
+					      ( header - pos ) ) ) != 0 )
+			return rc;
+		state1 = zstd_rbits_pull ( &rbs, fse.log );
+		state2 = zstd_rbits_pull ( &rbs, fse.log );
+		while ( 1 ) {
+			if ( count >= ( ZSTD_HUF_MAX_SYMS - 1 ) )
+				return -EINVAL_HUF;
+			weights[count++] = fse.symbol[state1];
+			state1 = ( fse.base[state1] +
+				   zstd_rbits_pull ( &rbs,
+						     fse.bits[state1] ) );
+			if ( rbs.pos < 0 ) {
+				weights[count++] = fse.symbol[state2];
+				break;
+			}
+			if ( count >= ( ZSTD_HUF_MAX_SYMS - 1 ) )
+				return -EINVAL_HUF;
+			weights[count++] = fse.symbol[state2];
+			state2 = ( fse.base[state2] +
+				   zstd_rbits_pull ( &rbs,
+						     fse.bits[state2] ) );
+			if ( rbs.pos < 0 ) {
+				weights[count++] = fse.symbol[state1];
+				break;
+			}
+		}
+	}
+
+	/* Build decoding table */
+	return zstd_huf_build ( &zstd->huf, weights, count );
+}
+
+/**
+ * Decode a single Huffman-compressed literals stream
+ *
+ * @v huf		Huffman table
+ * @v src		Compressed stream
+ * @v len		Length of compressed stream
+ * @v out		Output buffer
+ * @v count		Expected number of decoded bytes
+ * @ret rc		Return status code
+ */
+static int zstd_huf_stream ( struct zstd_huf *huf, const uint8_t *src,
+			     size_t len, uint8_t *out, size_t count ) {
+	struct zstd_rbits bs;
+	unsigned int state;
+	size_t i;
+	int rc;
+
+	if ( ( rc = zstd_rbits_init ( &bs, src, len ) ) != 0 )
+		return rc;
+	state = zstd_rbits_pull ( &bs, huf->max_bits );
+	for ( i = 0 ; i < count ; i++ ) {
+		out[i] = huf->symbol[state];
+		state = ( ( ( state << huf->bits[state] ) +
+			    zstd_rbits_pull ( &bs, huf->bits[state] ) ) &
+			  ( ( 1 << huf->max_bits ) - 1 ) );
+	}
+	return 0;
+}
+
+/**
+ * Decode the literals section of a block
+ *
+ * @v zstd		Decompressor
+ * @v src		Block data
+ * @v len		Length of block data
+ * @v litbuf		Allocated literals buffer to fill in (or NULL if
+ *			the literals are used directly from the block data;
+ *			left unaltered on error)
+ * @v lit		Decoded literals pointer to fill in
+ * @v lit_len		Decoded literals length to fill in
+ * @v used		Length consumed to fill in
+ * @ret rc		Return status code
+ */
+static int zstd_literals ( struct zstd *zstd, const uint8_t *src, size_t len,
+			   uint8_t **litbuf, const uint8_t **lit,
+			   size_t *lit_len, size_t *used ) {
+	unsigned long header = 0;
+	unsigned int type;
+	unsigned int format;
+	unsigned int streams;
+	size_t hdr_len;
+	size_t regen;
+	size_t comp;
+	size_t sizes[4];
+	size_t counts[4];
+	size_t pos;
+	size_t tree_len;
+	uint8_t *buf;
+	unsigned int i;
+	int rc;
+
+	/* Read literals section header (up to five bytes, little-endian) */
+	for ( i = 0 ; ( i < 5 ) && ( i < len ) ; i++ )
+		header |= ( ( ( unsigned long ) src[i] ) << ( 8 * i ) );
+	if ( len < 1 )
+		return -EINVAL_TRUNCATED;
+	type = ( header & 0x3 );
+
+	if ( ( type == ZSTD_LIT_RAW ) || ( type == ZSTD_LIT_RLE ) ) {
+
+		/* Sizes for raw and RLE literals */
+		if ( ! ( header & 0x4 ) ) {
+			hdr_len = 1;
+			regen = ( ( header >> 3 ) & 0x1f );
+		} else if ( ( ( header >> 2 ) & 0x3 ) == 1 ) {
+			hdr_len = 2;
+			regen = ( ( header >> 4 ) & 0xfff );
+		} else {
+			hdr_len = 3;
+			regen = ( ( header >> 4 ) & 0xfffff );
+		}
+		if ( regen > ZSTD_MAX_BLOCK )
+			return -EINVAL_LITERALS;
+
+		if ( type == ZSTD_LIT_RAW ) {
+			*used = ( hdr_len + regen );
+			if ( *used > len )
+				return -EINVAL_TRUNCATED;
+			*litbuf = NULL;
+			*lit = &src[hdr_len];
+		} else {
+			*used = ( hdr_len + 1 );
+			if ( *used > len )
+				return -EINVAL_TRUNCATED;
+			buf = malloc ( regen );
+			if ( ( ! buf ) && regen )
+				return -ENOMEM;
+			if ( regen )
+				memset ( buf, src[hdr_len], regen );
+			*litbuf = buf;
+			*lit = buf;
+		}
+		*lit_len = regen;
+		return 0;
+	}
+
+	/* Sizes for Huffman-compressed literals */
+	format = ( ( header >> 2 ) & 0x3 );
+	switch ( format ) {
+	case 0:
+	case 1:
+		hdr_len = 3;
+		regen = ( ( header >> 4 ) & 0x3ff );
+		comp = ( ( header >> 14 ) & 0x3ff );
+		streams = ( format ? 4 : 1 );
+		break;
+	case 2:
+		hdr_len = 4;
+		regen = ( ( header >> 4 ) & 0x3fff );
+		comp = ( ( header >> 18 ) & 0x3fff );
+		streams = 4;
+		break;
+	default:
+		hdr_len = 5;
+		regen = ( ( header >> 4 ) & 0x3ffff );
+		comp = ( ( header >> 22 ) & 0x3ffff );
+		streams = 4;
+		break;
+	}
+	if ( regen > ZSTD_MAX_BLOCK )
+		return -EINVAL_LITERALS;
+	*used = ( hdr_len + comp );
+	if ( *used > len )
+		return -EINVAL_TRUNCATED;
+	src += hdr_len;
+
+	/* Read Huffman tree description, if present */
+	if ( type == ZSTD_LIT_COMPRESSED ) {
+		if ( ( rc = zstd_huf_read ( zstd, src, comp,
+					    &tree_len ) ) != 0 )
+			return rc;
+		src += tree_len;
+		comp -= tree_len;
+	} else if ( ! zstd->huf.max_bits ) {
+		/* Treeless literals with no previous tree */
+		return -EINVAL_LITERALS;
+	}
+
+	/* Determine stream sizes */
+	if ( streams == 1 ) {
+		sizes[0] = comp;
+		counts[0] = regen;
+	} else {
+		if ( comp < 6 )
+			return -EINVAL_TRUNCATED;
+		sizes[0] = ( src[0] | ( src[1] << 8 ) );
+		sizes[1] = ( src[2] | ( src[3] << 8 ) );
+		sizes[2] = ( src[4] | ( src[5] << 8 ) );
+		src += 6;
+		comp -= 6;
+		if ( ( sizes[0] + sizes[1] + sizes[2] ) > comp )
+			return -EINVAL_LITERALS;
+		sizes[3] = ( comp - sizes[0] - sizes[1] - sizes[2] );
+		counts[0] = counts[1] = counts[2] = ( ( regen + 3 ) / 4 );
+		if ( regen < ( 3 * counts[0] ) )
+			return -EINVAL_LITERALS;
+		counts[3] = ( regen - ( 3 * counts[0] ) );
+	}
+
+	/* Allocate literals buffer and decode streams */
+	buf = malloc ( regen );
+	if ( ( ! buf ) && regen )
+		return -ENOMEM;
+	pos = 0;
+	for ( i = 0 ; i < streams ; i++ ) {
+		if ( ( rc = zstd_huf_stream ( &zstd->huf, src, sizes[i],
+					      &buf[pos], counts[i] ) ) != 0 ) {
+			free ( buf );
+			return rc;
+		}
+		src += sizes[i];
+		pos += counts[i];
+	}
+	assert ( pos == regen );
+
+	*litbuf = buf;
+	*lit = buf;
+	*lit_len = regen;
+	return 0;
+}
+
+/**
+ * Copy literals to the output buffer
+ *
+ * @v out		Output data chunk
+ * @v lit		Literals
+ * @v len		Length of literals
+ * @ret rc		Return status code
+ */
+static int zstd_copy_literals ( struct zstd_chunk *out, const uint8_t *lit,
+				size_t len ) {
+
+	if ( len > ( out->len - out->offset ) )
+		return -ENOBUFS;
+	copy_to_user ( out->data, out->offset, lit, len );
+	out->offset += len;
+	return 0;
+}
+
+/**
+ * Copy a match from previously decompressed data
+ *
+ * @v zstd		Decompressor
+ * @v out		Output data chunk
+ * @v offset		Match offset (distance backwards)
+ * @v len		Match length
+ * @ret rc		Return status code
+ */
+static int zstd_copy_match ( struct zstd *zstd, struct zstd_chunk *out,
+			     unsigned long offset, size_t len ) {
+	size_t src;
+	size_t frag;
+
+	/* Matches may not reach back beyond the start of the frame */
+	if ( ( offset == 0 ) ||
+	     ( offset > ( out->offset - zstd->base ) ) )
+		return -EINVAL_OFFSET;
+	if ( len > ( out->len - out->offset ) )
+		return -ENOBUFS;
+
+	/* Copy match, allowing for overlap (in which case the
+	 * available source region doubles with each copy).
+	 */
+	src = ( out->offset - offset );
+	while ( len ) {
+		frag = ( out->offset - src );
+		if ( frag > len )
+			frag = len;
+		memcpy_user ( out->data, out->offset, out->data, src, frag );
+		out->offset += frag;
+		len -= frag;
+	}
+	return 0;
+}
+
+/**
+ * Decode and execute the sequences section of a block
+ *
+ * @v zstd		Decompressor
+ * @v src		Sequences section
+ * @v len		Length of sequences section
+ * @v lit		Decoded literals
+ * @v lit_len		Length of decoded literals
+ * @v out		Output data chunk
+ * @ret rc		Return status code
+ */
+static int zstd_sequences ( struct zstd *zstd, const uint8_t *src, size_t len,
+			    const uint8_t *lit, size_t lit_len,
+			    struct zstd_chunk *out ) {
+	struct zstd_fbits fbs;
+	struct zstd_rbits rbs;
+	unsigned int nseq;
+	unsigned int modes;
+	unsigned int mode;
+	unsigned int ll_state;
+	unsigned int of_state;
+	unsigned int ml_state;
+	unsigned int ll_code;
+	unsigned int of_code;
+	unsigned int ml_code;
+	unsigned long of_value;
+	unsigned long offset;
+	unsigned long tmp;
+	size_t ll;
+	size_t ml;
+	size_t pos;
+	unsigned int i;
+	int rc;
+
+	/* Read number of sequences */
+	if ( len < 1 )
+		return -EINVAL_TRUNCATED;
+	if ( src[0] == 0 ) {
+		nseq = 0;
+		src++;
+		len--;
+	} else if ( src[0] < 128 ) {
+		nseq = src[0];
+		src++;
+		len--;
+	} else if ( src[0] < 255 ) {
+		if ( len < 2 )
+			return -EINVAL_TRUNCATED;
+		nseq = ( ( ( src[0] - 128 ) << 8 ) + src[1] );
+		src += 2;
+		len -= 2;
+	} else {
+		if ( len < 3 )
+			return -EINVAL_TRUNCATED;
+		nseq = ( src[1] + ( src[2] << 8 ) + 0x7f00 );
+		src += 3;
+		len -= 3;
+	}
+
+	/* If there are no sequences, the block output is simply the
+	 * literals.
+	 */
+	if ( nseq == 0 )
+		return zstd_copy_literals ( out, lit, lit_len );
+
+	/* Read compression modes and table descriptions (in the order
+	 * literals lengths, offsets, match lengths).
+	 */
+	if ( len < 1 )
+		return -EINVAL_TRUNCATED;
+	modes = src[0];
+	src++;
+	len--;
+	if ( modes & 0x3 )
+		return -EINVAL_RESERVED;
+	fbs.src = src;
+	fbs.len = ( len * 8 );
+	fbs.pos = 0;
+	for ( i = 0 ; i < 3 ; i++ ) {
+		struct zstd_fse *fse;
+		const int16_t *dist;
+		unsigned int dist_count;
+		unsigned int dist_log;
+		unsigned int max_log;
+		unsigned int max_count;
+		unsigned int symbol;
+
+		switch ( i ) {
+		case 0:
+			mode = ( ( modes >> 6 ) & 0x3 );
+			fse = &zstd->ll;
+			dist = zstd_ll_default;
+			dist_count = ZSTD_LL_CODES;
+			dist_log = ZSTD_LL_DEFAULT_LOG;
+			max_log = ZSTD_FSE_LL_LOG;
+			max_count = ZSTD_LL_CODES;
+			break;
+		case 1:
+			mode = ( ( modes >> 4 ) & 0x3 );
+			fse = &zstd->of;
+			dist = zstd_of_default;
+			dist_count = ( sizeof ( zstd_of_default ) /
+				       sizeof ( zstd_of_default[0] ) );
+			dist_log = ZSTD_OF_DEFAULT_LOG;
+			max_log = ZSTD_FSE_OF_LOG;
+			max_count = ZSTD_OF_CODES;
+			break;
+		default:
+			mode = ( ( modes >> 2 ) & 0x3 );
+			fse = &zstd->ml;
+			dist = zstd_ml_default;
+			dist_count = ZSTD_ML_CODES;
+			dist_log = ZSTD_ML_DEFAULT_LOG;
+			max_log = ZSTD_FSE_ML_LOG;
+			max_count = ZSTD_ML_CODES;
+			break;
+		}
+
+		switch ( mode ) {
+		case ZSTD_SEQ_PREDEFINED:
+			zstd_fse_build ( fse, dist, dist_count, dist_log );
+			break;
+		case ZSTD_SEQ_RLE:
+			if ( ( rc = zstd_fbits_pull ( &fbs, 8,
+						      &symbol ) ) != 0 )
+				return rc;
+			if ( symbol >= max_count )
+				return -EINVAL_SEQUENCES;
+			zstd_fse_rle ( fse, symbol );
+			break;
+		case ZSTD_SEQ_FSE:
+			if ( ( rc = zstd_fse_read ( fse, &fbs, max_log,
+						    max_count ) ) != 0 )
+				return rc;
+			break;
+		case ZSTD_SEQ_REPEAT:
+			if ( ! fse->valid )
+				return -EINVAL_SEQUENCES;
+			break;
+		}
+	}
+
+	/* The remainder of the section is a reverse bitstream */
+	pos = ( fbs.pos / 8 );
+	if ( ( rc = zstd_rbits_init ( &rbs, &fbs.src[pos],
+				      ( len - pos ) ) ) != 0 )
+		return rc;
+	ll_state = zstd_rbits_pull ( &rbs, zstd->ll.log );
+	of_state = zstd_rbits_pull ( &rbs, zstd->of.log );
+	ml_state = zstd_rbits_pull ( &rbs, zstd->ml.log );
+
+	/* Decode and execute sequences */
+	pos = 0;
+	for ( i = 0 ; i < nseq ; i++ ) {
+
+		/* Look up codes and read extra bits (in the order
+		 * offset, match length, literals length).
+		 */
+		ll_code = zstd->ll.symbol[ll_state];
+		of_code = zstd->of.symbol[of_state];
+		ml_code = zstd->ml.symbol[ml_state];
+		if ( ( ll_code >= ZSTD_LL_CODES ) ||
+		     ( of_code >= ZSTD_OF_CODES ) ||
+		     ( ml_code >= ZSTD_ML_CODES ) )
+			return -EINVAL_SEQUENCES;
+		of_value = ( ( 1UL << of_code ) +
+			     zstd_rbits_pull ( &rbs, of_code ) );
+		ml = ( zstd_ml_base[ml_code] +
+		       zstd_rbits_pull ( &rbs, zstd_ml_bits[ml_code] ) );
+		ll = ( zstd_ll_base[ll_code] +
+		       zstd_rbits_pull ( &rbs, zstd_ll_bits[ll_code] ) );
+
+		/* Resolve offset against the repeated offset history */
+		if ( of_value > 3 ) {
+			offset = ( of_value - 3 );
+			zstd->rep[2] = zstd->rep[1];
+			zstd->rep[1] = zstd->rep[0];
+			zstd->rep[0] = offset;
+		} else {
+			if ( ll == 0 )
+				of_value++;
+			switch ( of_value ) {
+			case 1:
+				offset = zstd->rep[0];
+				break;
+			case 2:
+				offset = zstd->rep[1];
+				zstd->rep[1] = zstd->rep[0];
+				zstd->rep[0] = offset;
+				break;
+			case 3:
+				offset = zstd->rep[2];
+				zstd->rep[2] = zstd->rep[1];
+				zstd->rep[1] = zstd->rep[0];
+				zstd->rep[0] = offset;
+				break;
+			default:
+				offset = ( zstd->rep[0] - 1 );
+				if ( offset == 0 )
+					return -EINVAL_OFFSET;
+				zstd->rep[2] = zstd->rep[1];
+				zstd->rep[1] = zstd->rep[0];
+				zstd->rep[0] = offset;
+				break;
+			}
+		}
+
+		/* Update states (in the order literals length, match
+		 * length, offset), except after the final sequence.
+		 */
+		if ( i != ( nseq - 1 ) ) {
+			tmp = zstd_rbits_pull ( &rbs,
+						zstd->ll.bits[ll_state] );
+			ll_state = ( zstd->ll.base[ll_state] + tmp );
+			tmp = zstd_rbits_pull ( &rbs,
+						zstd->ml.bits[ml_state] );
+			ml_state = ( zstd->ml.base[ml_state] + tmp );
+			tmp = zstd_rbits_pull ( &rbs,
+						zstd->of.bits[of_state] );
+			of_state = ( zstd->of.base[of_state] + tmp );
+		}
+
+		/* Execute sequence */
+		if ( ( pos + ll ) > lit_len )
+			return -EINVAL_SEQUENCES;
+		if ( ( rc = zstd_copy_literals ( out, &lit[pos], ll ) ) != 0 )
+			return rc;
+		pos += ll;
+		if ( ( rc = zstd_copy_match ( zstd, out, offset,
+					      ml ) ) != 0 )
+			return rc;
+	}
+
+	/* Copy any remaining literals */
+	return zstd_copy_literals ( out, &lit[pos], ( lit_len - pos ) );
+}
+
+/**
+ * Decompress a compressed block
+ *
+ * @v zstd		Decompressor
+ * @v src		Block data
+ * @v len		Length of block data
+ * @v out		Output data chunk
+ * @ret rc		Return status code
+ */
+static int zstd_block ( struct zstd *zstd, const uint8_t *src, size_t len,
+			struct zstd_chunk *out ) {
+	const uint8_t *lit;
+	uint8_t *litbuf;
+	size_t lit_len;
+	size_t used;
+	int rc;
+
+	/* Decode literals section */
+	if ( ( rc = zstd_literals ( zstd, src, len, &litbuf, &lit, &lit_len,
+				    &used ) ) != 0 )
+		goto err_literals;
+
+	/* Decode and execute sequences section */
+	if ( ( rc = zstd_sequences ( zstd, &src[used], ( len - used ),
+				     lit, lit_len, out ) ) != 0 )
+		goto err_sequences;
+
+ err_sequences:
+	free ( litbuf );
+ err_literals:
+	return rc;
+}
+
+/**
+ * Read a little-endian value from the input data chunk
+ *
+ * @v in		Input data chunk
+ * @v len		Length of value
+ * @v value		Value to fill in
+ * @ret rc		Return status code
+ */
+static int zstd_pull ( struct zstd_chunk *in, size_t len, uint64_t *value ) {
+	uint8_t bytes[8];
+	unsigned int i;
+
+	assert ( len <= sizeof ( bytes ) );
+	if ( len > ( in->len - in->offset ) )
+		return -EINVAL_TRUNCATED;
+	copy_from_user ( bytes, in->data, in->offset, len );
+	in->offset += len;
+	*value = 0;
+	for ( i = 0 ; i < len ; i++ )
+		*value |= ( ( ( uint64_t ) bytes[i] ) << ( 8 * i ) );
+	return 0;
+}
+
+/**
+ * Parse a frame header
+ *
+ * @v in		Input data chunk
+ * @v header		Parsed frame header to fill in
+ * @ret rc		Return status code
+ *
+ * Consumes the frame magic number and header.  Any skippable frames
+ * are skipped.
+ */
+static int zstd_frame_header ( struct zstd_chunk *in,
+			       struct zstd_frame_header *header ) {
+	static const uint8_t did_len[4] = { 0, 1, 2, 4 };
+	uint64_t magic;
+	uint64_t fhd;
+	uint64_t skip;
+	uint64_t value;
+	int rc;
+
+	/* Read magic number, skipping any skippable frames */
+	while ( 1 ) {
+		if ( ( rc = zstd_pull ( in, 4, &magic ) ) != 0 )
+			return rc;
+		if ( ( magic & ZSTD_MAGIC_SKIP_MASK ) != ZSTD_MAGIC_SKIP )
+			break;
+		if ( ( rc = zstd_pull ( in, 4, &skip ) ) != 0 )
+			return rc;
+		if ( skip > ( in->len - in->offset ) )
+			return -EINVAL_TRUNCATED;
+		in->offset += skip;
+	}
+	if ( magic != ZSTD_MAGIC )
+		return -EINVAL_MAGIC;
+
+	/* Read frame header descriptor */
+	if ( ( rc = zstd_pull ( in, 1, &fhd ) ) != 0 )
+		return rc;
+	if ( ZSTD_FHD_RESERVED ( fhd ) )
+		return -EINVAL_RESERVED;
+	header->cksum = ZSTD_FHD_CKSUM ( fhd );
+
+	/* Read and ignore window descriptor, if present.  We use the
+	 * complete output buffer as the window, and so never need to
+	 * restrict the window size.
+	 */
+	if ( ! ZSTD_FHD_SINGLE ( fhd ) ) {
+		if ( ( rc = zstd_pull ( in, 1, &value ) ) != 0 )
+			return rc;
+	}
+
+	/* Refuse dictionaries */
+	if ( did_len[ ZSTD_FHD_DICT ( fhd ) ] ) {
+		if ( ( rc = zstd_pull ( in, did_len[ ZSTD_FHD_DICT ( fhd ) ],
+					&value ) ) != 0 )
+			return rc;
+		if ( value != 0 )
+			return -ENOTSUP_DICT;
+	}
+
+	/* Read frame content size, if present */
+	header->has_fcs = 0;
+	header->fcs = 0;
+	switch ( ZSTD_FHD_FCS ( fhd ) ) {
+	case 0:
+		if ( ZSTD_FHD_SINGLE ( fhd ) ) {
+			if ( ( rc = zstd_pull ( in, 1, &header->fcs ) ) != 0 )
+				return rc;
+			header->has_fcs = 1;
+		}
+		break;
+	case 1:
+		if ( ( rc = zstd_pull ( in, 2, &header->fcs ) ) != 0 )
+			return rc;
+		header->fcs += 256;
+		header->has_fcs = 1;
+		break;
+	case 2:
+		if ( ( rc = zstd_pull ( in, 4, &header->fcs ) ) != 0 )
+			return rc;
+		header->has_fcs = 1;
+		break;
+	default:
+		if ( ( rc = zstd_pull ( in, 8, &header->fcs ) ) != 0 )
+			return rc;
+		header->has_fcs = 1;
+		break;
+	}
+
+	return 0;
+}
+
+/**
+ * Decompress a single frame
+ *
+ * @v zstd		Decompressor
+ * @v in		Input data chunk
+ * @v out		Output data chunk
+ * @ret rc		Return status code
+ */
+static int zstd_frame ( struct zstd *zstd, struct zstd_chunk *in,
+			struct zstd_chunk *out ) {
+	struct zstd_frame_header header;
+	uint64_t bh;
+	uint64_t byte;
+	uint64_t cksum;
+	unsigned int type;
+	size_t size;
+	size_t remaining;
+	uint8_t *buf;
+	int last;
+	int rc;
+
+	/* Parse frame header */
+	if ( ( rc = zstd_frame_header ( in, &header ) ) != 0 )
+		return rc;
+
+	/* Reset per-frame state.  Matches and table reuse may not
+	 * cross a frame boundary.
+	 */
+	zstd->huf.max_bits = 0;
+	zstd->ll.valid = 0;
+	zstd->of.valid = 0;
+	zstd->ml.valid = 0;
+	zstd->rep[0] = 1;
+	zstd->rep[1] = 4;
+	zstd->rep[2] = 8;
+	zstd->base = out->offset;
+
+	/* Process blocks */
+	do {
+		if ( ( rc = zstd_pull ( in, 3, &bh ) ) != 0 )
+			return rc;
+		last = ZSTD_BLOCK_LAST ( bh );
+		type = ZSTD_BLOCK_TYPE ( bh );
+		size = ZSTD_BLOCK_SIZE ( bh );
+		switch ( type ) {
+		case ZSTD_BLOCK_RAW:
+			if ( size > ( in->len - in->offset ) )
+				return -EINVAL_TRUNCATED;
+			if ( size > ( out->len - out->offset ) )
+				return -ENOBUFS;
+			memcpy_user ( out->data, out->offset, in->data,
+				      in->offset, size );
+			in->offset += size;
+			out->offset += size;
+			break;
+		case ZSTD_BLOCK_RLE:
+			if ( ( rc = zstd_pull ( in, 1, &byte ) ) != 0 )
+				return rc;
+			if ( size > ( out->len - out->offset ) )
+				return -ENOBUFS;
+			memset_user ( out->data, out->offset, byte, size );
+			out->offset += size;
+			break;
+		case ZSTD_BLOCK_COMPRESSED:
+			if ( size > ZSTD_MAX_BLOCK )
+				return -EINVAL_BLOCK;
+			if ( size > ( in->len - in->offset ) )
+				return -EINVAL_TRUNCATED;
+			buf = malloc ( size );
+			if ( ! buf )
+				return -ENOMEM;
+			copy_from_user ( buf, in->data, in->offset, size );
+			in->offset += size;
+			rc = zstd_block ( zstd, buf, size, out );
+			free ( buf );
+			if ( rc != 0 )
+				return rc;
+			break;
+		default:
+			return -EINVAL_RESERVED;
+		}
+	} while ( ! last );
+
+	/* Skip content checksum, if present */
+	if ( header.cksum ) {
+		if ( ( rc = zstd_pull ( in, 4, &cksum ) ) != 0 )
+			return rc;
+	}
+
+	/* Check decompressed length, if known */
+	remaining = ( out->offset - zstd->base );
+	if ( header.has_fcs && ( header.fcs != remaining ) )
+		return -EINVAL_LENGTH;
+
+	return 0;
+}
+
+/**
+ * Get decompressed length
+ *
+ * @v in		Input data chunk
+ * @v len		Decompressed length to fill in
+ * @ret rc		Return status code
+ *
+ * Returns the frame content size recorded in the first (non-skippable)
+ * frame header.  Inputs consisting of multiple concatenated frames
+ * will under-report the total length; such inputs are rare, and will
+ * be detected when decompression overruns the output buffer.
+ */
+int zstd_decompressed_len ( const struct zstd_chunk *in, uint64_t *len ) {
+	struct zstd_frame_header header;
+	struct zstd_chunk tmp;
+	int rc;
+
+	memcpy ( &tmp, in, sizeof ( tmp ) );
+	if ( ( rc = zstd_frame_header ( &tmp, &header ) ) != 0 )
+		return rc;
+	if ( ! header.has_fcs )
+		return -ENOTSUP_LEN;
+	*len = header.fcs;
+	return 0;
+}
+
+/**
+ * Decompress data
+ *
+ * @v in		Compressed data chunk
+ * @v out		Output data chunk
+ * @ret rc		Return status code
+ *
+ * Decompresses all frames from the current input offset to the end of
+ * the input chunk.
+ */
+int zstd_decompress ( struct zstd_chunk *in, struct zstd_chunk *out ) {
+	struct zstd *zstd;
+	int rc = 0;
+
+	/* Allocate decompressor */
+	zstd = zalloc ( sizeof ( *zstd ) );
+	if ( ! zstd )
+		return -ENOMEM;
+
+	/* Decompress all frames */
+	while ( in->offset < in->len ) {
+		if ( ( rc = zstd_frame ( zstd, in, out ) ) != 0 )
+			break;
+	}
+
+	free ( zstd );
+	return rc;
+}
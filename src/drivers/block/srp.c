@@ -112,6 +112,13 @@ struct srp_device {
 	uint32_t memory_handle;
 	/** Login completed successfully */
 	int logged_in;
+	/** Request limit
+	 *
+	 * This is the number of commands that the target has granted
+	 * us credit to have outstanding, as communicated via the
+	 * request limit deltas in login and SCSI response IUs.
+	 */
+	unsigned int credits;
 
 	/** List of active commands */
 	struct list_head commands;
@@ -346,9 +353,11 @@ static int srp_login_rsp ( struct srp_device *srpdev,
 	       srpdev, ntohl ( login_rsp->tag.dwords[1] ) );
 	DBGC_HDA ( srpdev, 0, data, len );
 
-	/* Mark as logged in */
+	/* Mark as logged in and record initial request limit */
 	srpdev->logged_in = 1;
-	DBGC ( srpdev, "SRP %p logged in\n", srpdev );
+	srpdev->credits += ntohl ( login_rsp->request_limit_delta );
+	DBGC ( srpdev, "SRP %p logged in with %d credits\n",
+	       srpdev, srpdev->credits );
 
 	/* Notify of window change */
 	xfer_window_changed ( &srpdev->scsi );
@@ -402,12 +411,17 @@ static int srp_cmd ( struct srp_device *srpdev,
 	struct srp_memory_descriptor *data_in;
 	int rc;
 
-	/* Sanity check */
+	/* Sanity checks */
 	if ( ! srpdev->logged_in ) {
 		DBGC ( srpdev, "SRP %p tag %08x cannot send CMD before "
 		       "login completes\n", srpdev, tag );
 		return -EBUSY;
 	}
+	if ( ! srpdev->credits ) {
+		DBGC ( srpdev, "SRP %p tag %08x cannot send CMD with no "
+		       "remaining credits\n", srpdev, tag );
+		return -EBUSY;
+	}
 
 	/* Allocate I/O buffer */
 	iobuf = xfer_alloc_iob ( &srpdev->socket, SRP_MAX_I_T_IU_LEN );
@@ -453,6 +467,9 @@ static int srp_cmd ( struct srp_device *srpdev,
 		return rc;
 	}
 
+	/* Consume a request limit credit */
+	srpdev->credits--;
+
 	return 0;
 }
 
@@ -493,6 +510,10 @@ static int srp_rsp ( struct srp_device *srpdev,
 		( ( rsp->valid & SRP_RSP_VALID_SNSVALID ) ? " sns" : "" ),
 		( ( rsp->valid & SRP_RSP_VALID_RSPVALID ) ? " rsp" : "" ) );
 
+	/* Replenish request limit credits and notify of window change */
+	srpdev->credits += ntohl ( rsp->request_limit_delta );
+	xfer_window_changed ( &srpdev->scsi );
+
 	/* Identify command by tag */
 	srpcmd = srp_find_tag ( srpdev, ntohl ( rsp->tag.dwords[1] ) );
 	if ( ! srpcmd ) {
@@ -674,7 +695,8 @@ static int srpdev_deliver ( struct srp_device *srpdev,
  * @ret len		Length of window
  */
 static size_t srpdev_window ( struct srp_device *srpdev ) {
-	return ( srpdev->logged_in ? ~( ( size_t ) 0 ) : 0 );
+	return ( ( srpdev->logged_in && srpdev->credits ) ?
+		 ~( ( size_t ) 0 ) : 0 );
 }
 
 /** SRP device socket interface operations */
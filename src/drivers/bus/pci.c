@@ -33,6 +33,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <errno.h>
 #include <ipxe/tables.h>
 #include <ipxe/device.h>
+#include <ipxe/process.h>
+#include <ipxe/settings.h>
 #include <ipxe/pci.h>
 
 /** @file
@@ -43,6 +45,32 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 static void pcibus_remove ( struct root_device *rootdev );
 
+/** PCI boot device hint setting
+ *
+ * May be set to the bus:dev.fn address (as per ${busloc}) of the
+ * expected boot device.  If set, the hinted device is probed first
+ * and the remainder of the bus scan is deferred to the background,
+ * so that the boot device can start (e.g. begin DHCP) without
+ * waiting for every other function to be enumerated.
+ */
+const struct setting pciboot_setting __setting ( SETTING_MISC, pciboot ) = {
+	.name = "pciboot",
+	.description = "PCI boot device bus:dev.fn address",
+	.type = &setting_type_uint32,
+};
+
+/** PCI bus deferred scan state */
+struct pci_scan {
+	/** Background process */
+	struct process process;
+	/** Root device */
+	struct root_device *rootdev;
+	/** Next bus:dev.fn address to scan */
+	unsigned int busdevfn;
+	/** Already-probed bus:dev.fn address to skip, or negative */
+	int skip;
+};
+
 /**
  * Read PCI BAR
  *
@@ -311,19 +339,23 @@ void pci_remove ( struct pci_device *pci ) {
 }
 
 /**
- * Probe PCI root bus
+ * Probe a range of PCI bus addresses
  *
  * @v rootdev		PCI bus root device
- *
- * Scans the PCI bus for devices and registers all devices it can
- * find.
+ * @v first		First bus:dev.fn address to probe
+ * @v end		Bus:dev.fn address upper bound (exclusive)
+ * @v skip		Bus:dev.fn address to skip, or negative
+ * @v count		Number of probed devices to update, or NULL
+ * @ret rc		Return status code
  */
-static int pcibus_probe ( struct root_device *rootdev ) {
+static int pcibus_probe_range ( struct root_device *rootdev,
+				unsigned int first, unsigned int end,
+				int skip, unsigned int *count ) {
 	struct pci_device *pci = NULL;
-	int busdevfn = 0;
+	int busdevfn;
 	int rc;
 
-	for ( busdevfn = 0 ; 1 ; busdevfn++ ) {
+	for ( busdevfn = first ; busdevfn < ( ( int ) end ) ; busdevfn++ ) {
 
 		/* Allocate struct pci_device */
 		if ( ! pci )
@@ -335,9 +367,13 @@ static int pcibus_probe ( struct root_device *rootdev ) {
 
 		/* Find next PCI device, if any */
 		busdevfn = pci_find_next ( pci, busdevfn );
-		if ( busdevfn < 0 )
+		if ( ( busdevfn < 0 ) || ( busdevfn >= ( ( int ) end ) ) )
 			break;
 
+		/* Skip any already-probed device */
+		if ( busdevfn == skip )
+			continue;
+
 		/* Look for a driver */
 		if ( ( rc = pci_find_driver ( pci ) ) != 0 ) {
 			DBGC ( pci, PCI_FMT " (%04x:%04x class %06x) has no "
@@ -354,6 +390,8 @@ static int pcibus_probe ( struct root_device *rootdev ) {
 		if ( ( rc = pci_probe ( pci ) ) == 0 ) {
 			/* pcidev registered, we can drop our ref */
 			pci = NULL;
+			if ( count )
+				(*count)++;
 		} else {
 			/* Not registered; re-use struct pci_device */
 			list_del ( &pci->dev.siblings );
@@ -365,6 +403,90 @@ static int pcibus_probe ( struct root_device *rootdev ) {
 
  err:
 	free ( pci );
+	return rc;
+}
+
+/**
+ * Perform one step of a deferred PCI bus scan
+ *
+ * @v scan		Deferred scan state
+ *
+ * Probes at most one bus per step, so that the boot device (probed
+ * before the deferred scan was started) is not starved of attention
+ * while the remaining devices are enumerated.
+ */
+static void pcibus_scan_step ( struct pci_scan *scan ) {
+	unsigned int end;
+
+	/* Probe a single bus */
+	end = PCI_BUSDEVFN ( 0, ( PCI_BUS ( scan->busdevfn ) + 1 ), 0, 0 );
+	pcibus_probe_range ( scan->rootdev, scan->busdevfn, end, scan->skip,
+			     NULL );
+	scan->busdevfn = end;
+
+	/* Stop once all buses have been scanned */
+	if ( scan->busdevfn >=
+	     ( ( unsigned int ) PCI_BUSDEVFN ( 0, pci_num_bus(), 0, 0 ) ) ) {
+		DBGC ( scan, "PCI deferred bus scan complete\n" );
+		process_del ( &scan->process );
+		scan->rootdev = NULL;
+	}
+}
+
+/** PCI bus deferred scan process descriptor */
+static struct process_descriptor pcibus_scan_desc =
+	PROC_DESC ( struct pci_scan, process, pcibus_scan_step );
+
+/** PCI bus deferred scan state */
+static struct pci_scan pcibus_scan;
+
+/**
+ * Probe PCI root bus
+ *
+ * @v rootdev		PCI bus root device
+ *
+ * Scans the PCI bus for devices and registers all devices it can
+ * find.
+ */
+static int pcibus_probe ( struct root_device *rootdev ) {
+	unsigned long hint;
+	unsigned int boot;
+	unsigned int count = 0;
+	int rc;
+
+	/* If a boot device hint is configured, probe that device
+	 * first and defer the rest of the scan to the background.
+	 */
+	if ( fetch_uint_setting ( NULL, &pciboot_setting, &hint ) > 0 ) {
+		boot = hint;
+		if ( ( rc = pcibus_probe_range ( rootdev, boot, ( boot + 1 ),
+						 -1, &count ) ) != 0 )
+			goto err;
+		if ( count ) {
+			DBGC ( &pcibus_scan, "PCI deferring bus scan (boot "
+			       "device %04x:%02x:%02x.%x)\n",
+			       PCI_SEG ( boot ), PCI_BUS ( boot ),
+			       PCI_SLOT ( boot ), PCI_FUNC ( boot ) );
+			pcibus_scan.rootdev = rootdev;
+			pcibus_scan.busdevfn = 0;
+			pcibus_scan.skip = boot;
+			process_init ( &pcibus_scan.process, &pcibus_scan_desc,
+				       NULL );
+			return 0;
+		}
+		/* Hinted device did not probe; fall back to full scan */
+	}
+
+	/* Scan all buses synchronously */
+	if ( ( rc = pcibus_probe_range ( rootdev, 0,
+					 PCI_BUSDEVFN ( 0, pci_num_bus(),
+							0, 0 ),
+					 -1, NULL ) ) != 0 )
+		goto err;
+
+	return 0;
+
+ err:
 	pcibus_remove ( rootdev );
 	return rc;
 }
@@ -378,6 +500,12 @@ static void pcibus_remove ( struct root_device *rootdev ) {
 	struct pci_device *pci;
 	struct pci_device *tmp;
 
+	/* Stop any deferred bus scan */
+	if ( pcibus_scan.rootdev ) {
+		process_del ( &pcibus_scan.process );
+		pcibus_scan.rootdev = NULL;
+	}
+
 	list_for_each_entry_safe ( pci, tmp, &rootdev->dev.children,
 				   dev.siblings ) {
 		pci_remove ( pci );
@@ -80,6 +80,10 @@ void *vring_get_buf(struct vring_virtqueue *vq, unsigned int *len)
 
    vq->last_used_idx++;
 
+   /* Re-arm the interrupt for the next used buffer, if applicable */
+   if (vq->event_idx && vq->cb_enabled)
+           vring_used_event(vr) = vq->last_used_idx;
+
    return opaque;
 }
 
@@ -126,12 +130,24 @@ void vring_kick(struct virtio_pci_modern_device *vdev, unsigned int ioaddr,
                 struct vring_virtqueue *vq, int num_added)
 {
    struct vring *vr = &vq->vring;
+   u16 old;
+   int notify;
 
    wmb();
-   vr->avail->idx += num_added;
+   old = vr->avail->idx;
+   vr->avail->idx = old + num_added;
 
    mb();
-   if (!(vr->used->flags & VRING_USED_F_NO_NOTIFY)) {
+   if (vq->event_idx) {
+           /* Notify only if the device has not yet seen (or been
+            * notified of) an available index beyond avail_event.
+            */
+           notify = vring_need_event(vring_avail_event(vr),
+                                     vr->avail->idx, old);
+   } else {
+           notify = !(vr->used->flags & VRING_USED_F_NO_NOTIFY);
+   }
+   if (notify) {
            if (vdev) {
                    /* virtio 1.0 */
                    vpm_notify(vdev, vq);
@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <linux_api.h>
+#include <ipxe/linux.h>
+#include <ipxe/device.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/ethernet.h>
+#include <ipxe/settings.h>
+#include <ipxe/pcap.h>
+
+/** @file
+ *
+ * Captured trace replay driver
+ *
+ * Feed a captured packet trace (in the standard packet capture file
+ * format, as produced by the "pcap" command) back into the network
+ * stack.  Exactly one frame is delivered per poll, so a given trace
+ * produces an identical sequence of stack events on every run,
+ * independent of wall-clock time.  This provides a deterministic
+ * offline benchmark rig for protocol-layer changes.
+ *
+ * Usage, under the Linux userspace build:
+ *
+ *   ./ipxe.linux --net replay,file=/path/to/trace.pcap
+ *
+ * Transmitted frames are discarded; a trace replays the remote side
+ * of a conversation exactly as originally observed.
+ */
+
+/** Maximum sane length of a single captured frame */
+#define REPLAY_MAX_LEN 65536
+
+/** A replay device */
+struct replay_nic {
+	/** Trace file name */
+	char *filename;
+	/** File descriptor of the opened trace file */
+	int fd;
+	/** End of trace (or unrecoverable error) has been reached */
+	int finished;
+};
+
+/**
+ * Read an exact number of bytes from the trace file
+ *
+ * @v nic		Replay device
+ * @v data		Data buffer
+ * @v len		Length to read
+ * @ret rc		Return status code
+ *
+ * Returns -ENOENT at a clean end of trace.
+ */
+static int replay_read ( struct replay_nic *nic, void *data, size_t len ) {
+	int ret;
+
+	ret = linux_read ( nic->fd, data, len );
+	if ( ret == 0 )
+		return -ENOENT;
+	if ( ret < 0 ) {
+		DBGC ( nic, "REPLAY %p read failed (%s)\n",
+		       nic, linux_strerror ( linux_errno ) );
+		return -EIO;
+	}
+	if ( ( ( size_t ) ret ) != len ) {
+		DBGC ( nic, "REPLAY %p truncated trace\n", nic );
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/**
+ * Open the trace file
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+static int replay_open ( struct net_device *netdev ) {
+	struct replay_nic *nic = netdev->priv;
+	struct pcap_file_header hdr;
+	int rc;
+
+	/* Open trace file */
+	nic->fd = linux_open ( nic->filename, O_RDONLY );
+	if ( nic->fd < 0 ) {
+		DBGC ( nic, "REPLAY %p open('%s') = %d (%s)\n", nic,
+		       nic->filename, nic->fd,
+		       linux_strerror ( linux_errno ) );
+		return nic->fd;
+	}
+
+	/* Read and validate file header */
+	if ( ( rc = replay_read ( nic, &hdr, sizeof ( hdr ) ) ) != 0 )
+		goto err_hdr;
+	if ( hdr.magic != PCAP_MAGIC ) {
+		DBGC ( nic, "REPLAY %p bad magic %#08x\n", nic, hdr.magic );
+		rc = -EINVAL;
+		goto err_hdr;
+	}
+	if ( hdr.network != PCAP_LINKTYPE_ETHERNET ) {
+		DBGC ( nic, "REPLAY %p unsupported link type %d\n",
+		       nic, hdr.network );
+		rc = -ENOTSUP;
+		goto err_hdr;
+	}
+
+	nic->finished = 0;
+	return 0;
+
+ err_hdr:
+	linux_close ( nic->fd );
+	return rc;
+}
+
+/**
+ * Close the trace file
+ *
+ * @v netdev		Network device
+ */
+static void replay_close ( struct net_device *netdev ) {
+	struct replay_nic *nic = netdev->priv;
+
+	linux_close ( nic->fd );
+}
+
+/**
+ * Discard a transmitted frame
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ *
+ * The trace replays the remote side of the conversation; frames
+ * transmitted by the stack have nowhere to go.
+ */
+static int replay_transmit ( struct net_device *netdev,
+			     struct io_buffer *iobuf ) {
+	struct replay_nic *nic = netdev->priv;
+
+	DBGC2 ( nic, "REPLAY %p discarded %zd transmitted bytes\n",
+		nic, iob_len ( iobuf ) );
+	netdev_tx_complete ( netdev, iobuf );
+
+	return 0;
+}
+
+/**
+ * Deliver the next captured frame
+ *
+ * @v netdev		Network device
+ */
+static void replay_poll ( struct net_device *netdev ) {
+	struct replay_nic *nic = netdev->priv;
+	struct pcap_record_header hdr;
+	struct io_buffer *iobuf;
+	int rc;
+
+	/* Do nothing once the end of the trace has been reached */
+	if ( nic->finished )
+		return;
+
+	/* Read record header */
+	if ( ( rc = replay_read ( nic, &hdr, sizeof ( hdr ) ) ) != 0 ) {
+		if ( rc == -ENOENT ) {
+			DBGC ( nic, "REPLAY %p end of trace\n", nic );
+		} else {
+			netdev_rx_err ( netdev, NULL, rc );
+		}
+		nic->finished = 1;
+		return;
+	}
+	if ( hdr.incl_len > REPLAY_MAX_LEN ) {
+		DBGC ( nic, "REPLAY %p implausible frame length %d\n",
+		       nic, hdr.incl_len );
+		netdev_rx_err ( netdev, NULL, -EINVAL );
+		nic->finished = 1;
+		return;
+	}
+
+	/* Allocate I/O buffer and read frame */
+	iobuf = alloc_iob ( hdr.incl_len );
+	if ( ! iobuf ) {
+		netdev_rx_err ( netdev, NULL, -ENOMEM );
+		return;
+	}
+	if ( ( rc = replay_read ( nic, iobuf->data,
+				  hdr.incl_len ) ) != 0 ) {
+		netdev_rx_err ( netdev, iobuf, rc );
+		nic->finished = 1;
+		return;
+	}
+	iob_put ( iobuf, hdr.incl_len );
+
+	/* Deliver frame */
+	DBGC2 ( nic, "REPLAY %p delivered %d bytes\n", nic, hdr.incl_len );
+	netdev_rx ( netdev, iobuf );
+}
+
+/**
+ * Set interrupt enabled state
+ *
+ * @v netdev		Network device
+ * @v enable		Interrupts should be enabled
+ *
+ * Not used on Linux; provide a dummy implementation.
+ */
+static void replay_irq ( struct net_device *netdev, int enable ) {
+	struct replay_nic *nic = netdev->priv;
+
+	DBGC ( nic, "REPLAY %p irq enable = %d\n", nic, enable );
+}
+
+/** Replay operations */
+static struct net_device_operations replay_operations = {
+	.open		= replay_open,
+	.close		= replay_close,
+	.transmit	= replay_transmit,
+	.poll		= replay_poll,
+	.irq		= replay_irq,
+};
+
+/**
+ * Handle a device request for the replay driver
+ *
+ * @v device		Linux device
+ * @v request		Device creation request
+ * @ret rc		Return status code
+ */
+static int replay_probe ( struct linux_device *device,
+			  struct linux_device_request *request ) {
+	struct linux_setting *file_setting;
+	struct net_device *netdev;
+	struct replay_nic *nic;
+	int rc;
+
+	netdev = alloc_etherdev ( sizeof ( *nic ) );
+	if ( ! netdev )
+		return -ENOMEM;
+
+	netdev_init ( netdev, &replay_operations );
+	nic = netdev->priv;
+	linux_set_drvdata ( device, netdev );
+	netdev->dev = &device->dev;
+	memset ( nic, 0, sizeof ( *nic ) );
+
+	/* Look for the mandatory file setting */
+	file_setting = linux_find_setting ( "file", &request->settings );
+	if ( ! file_setting ) {
+		printf ( "replay missing a mandatory file setting\n" );
+		rc = -EINVAL;
+		goto err_settings;
+	}
+
+	nic->filename = file_setting->value;
+	snprintf ( device->dev.name, sizeof ( device->dev.name ), "replay" );
+	device->dev.desc.bus_type = BUS_TYPE_TAP;
+	file_setting->applied = 1;
+
+	/* Apply rest of the settings */
+	linux_apply_settings ( &request->settings,
+			       &netdev->settings.settings );
+
+	/* Register network device */
+	if ( ( rc = register_netdev ( netdev ) ) != 0 )
+		goto err_register;
+
+	netdev_link_up ( netdev );
+
+	return 0;
+
+ err_settings:
+ err_register:
+	netdev_nullify ( netdev );
+	netdev_put ( netdev );
+	return rc;
+}
+
+/**
+ * Remove the device
+ *
+ * @v device		Linux device
+ */
+static void replay_remove ( struct linux_device *device ) {
+	struct net_device *netdev = linux_get_drvdata ( device );
+
+	unregister_netdev ( netdev );
+	netdev_nullify ( netdev );
+	netdev_put ( netdev );
+}
+
+/** Replay linux_driver */
+struct linux_driver replay_driver __linux_driver = {
+	.name = "replay",
+	.probe = replay_probe,
+	.remove = replay_remove,
+	.can_probe = 1,
+};
@@ -60,16 +60,20 @@ static struct profiler axge_out_profiler __profiler =
  * The Linux and FreeBSD drivers have set of magic constants which are
  * chosen based on both the Ethernet and USB link speeds.
  *
- * Experimentation shows that setting the "timer" value to zero seems
- * to prevent the device from ever coalescing multiple packets into a
- * single bulk IN transfer.  This allows us to get away with using a
- * 2kB receive I/O buffer and a zerocopy receive path.
+ * These values (matching the other drivers' USB 3.0 settings) allow
+ * the device to coalesce received packets, up to the aggregation
+ * limit implied by the "size" value (in units of 1kB).  One bulk IN
+ * transfer then carries many full-sized Ethernet frames, which is
+ * required to sustain gigabit rates: with coalescing disabled,
+ * throughput is capped at one frame per bulk IN completion.  The
+ * receive buffer size (@c AXGE_IN_MTU) must be large enough to hold a
+ * maximal aggregated transfer.
  */
 static struct axge_bulk_in_control axge_bicr = {
 	.ctrl = 7,
-	.timer = cpu_to_le16 ( 0 ),
-	.size = 0,
-	.ifg = 0,
+	.timer = cpu_to_le16 ( 0x004f ),
+	.size = 0x12,
+	.ifg = 0xff,
 };
 
 /******************************************************************************
@@ -154,15 +154,19 @@ struct axge_device {
 
 /** Bulk IN maximum fill level
  *
- * This is a policy decision.
+ * This is a policy decision.  With packet coalescing enabled each
+ * buffer carries many frames, so fewer transfers need to be in
+ * flight to keep the endpoint busy.
  */
-#define AXGE_IN_MAX_FILL 8
+#define AXGE_IN_MAX_FILL 4
 
 /** Bulk IN buffer size
  *
- * This is a policy decision.
+ * Must be large enough to hold a maximal aggregated transfer, as
+ * configured via the "size" field of the bulk IN control register
+ * (in units of 1kB).
  */
-#define AXGE_IN_MTU 2048
+#define AXGE_IN_MTU ( 0x12 * 1024 )
 
 /** Amount of space to reserve at start of bulk IN buffers
  *
@@ -23,6 +23,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <assert.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/netdevice.h>
 #include <ipxe/ethernet.h>
@@ -57,12 +58,28 @@ struct snp_nic {
 
 	/** Current transmit buffer */
 	struct io_buffer *txbuf;
-	/** Current receive buffer */
-	struct io_buffer *rxbuf;
+	/** Pre-allocated receive buffers */
+	struct list_head rxbufs;
+	/** Number of pre-allocated receive buffers */
+	unsigned int rxfill;
 };
 
-/** Maximum number of received packets per poll */
-#define SNP_RX_QUOTA 4
+/** Maximum number of received packets per poll
+ *
+ * Firmware SNP implementations tend to have a high fixed overhead per
+ * call, so drain the receive queue fairly deeply on each poll to
+ * amortise that overhead, while still bounding the time spent away
+ * from the rest of the stack.
+ */
+#define SNP_RX_QUOTA 16
+
+/** Number of pre-allocated receive buffers
+ *
+ * Buffers are allocated outside of the receive loop and retained
+ * across polls, avoiding a round trip through the allocator for each
+ * received packet.
+ */
+#define SNP_RX_FILL 16
 
 /**
  * Format SNP MAC address (for debugging)
@@ -190,6 +207,12 @@ static void snpnet_poll_tx ( struct net_device *netdev ) {
 	EFI_STATUS efirc;
 	int rc;
 
+	/* Do nothing unless a transmission is in progress: this avoids
+	 * a (slow) firmware call per poll on an idle transmit path.
+	 */
+	if ( ! snp->txbuf )
+		return;
+
 	/* Get status */
 	txbuf = NULL;
 	if ( ( efirc = snp->snp->GetStatus ( snp->snp, &irq, &txbuf ) ) != 0 ) {
@@ -218,6 +241,28 @@ static void snpnet_poll_tx ( struct net_device *netdev ) {
 	netdev_tx_complete ( netdev, iobuf );
 }
 
+/**
+ * Refill pre-allocated receive buffers
+ *
+ * @v netdev		Network device
+ */
+static void snpnet_rx_refill ( struct net_device *netdev ) {
+	struct snp_nic *snp = netdev->priv;
+	struct io_buffer *iobuf;
+
+	/* Top up buffer pool.  Allocation failure is harmless: any
+	 * remaining buffers will simply be used (and refilled) on
+	 * subsequent polls.
+	 */
+	while ( snp->rxfill < SNP_RX_FILL ) {
+		iobuf = alloc_iob ( snp->mtu );
+		if ( ! iobuf )
+			break;
+		list_add_tail ( &iobuf->list, &snp->rxbufs );
+		snp->rxfill++;
+	}
+}
+
 /**
  * Poll for received packets
  *
@@ -225,31 +270,35 @@ static void snpnet_poll_tx ( struct net_device *netdev ) {
  */
 static void snpnet_poll_rx ( struct net_device *netdev ) {
 	struct snp_nic *snp = netdev->priv;
+	struct io_buffer *iobuf;
 	UINTN len;
 	unsigned int quota;
 	EFI_STATUS efirc;
 	int rc;
 
+	/* Replenish buffer pool (outside of the receive loop) */
+	snpnet_rx_refill ( netdev );
+
 	/* Retrieve up to SNP_RX_QUOTA packets */
 	for ( quota = SNP_RX_QUOTA ; quota ; quota-- ) {
 
-		/* Allocate buffer, if required */
-		if ( ! snp->rxbuf ) {
-			snp->rxbuf = alloc_iob ( snp->mtu );
-			if ( ! snp->rxbuf ) {
-				/* Leave for next poll */
-				break;
-			}
+		/* Use next pre-allocated buffer, if any */
+		iobuf = list_first_entry ( &snp->rxbufs, struct io_buffer,
+					   list );
+		if ( ! iobuf ) {
+			/* Leave for next poll */
+			break;
 		}
 
 		/* Receive packet */
-		len = iob_tailroom ( snp->rxbuf );
+		len = iob_tailroom ( iobuf );
 		if ( ( efirc = snp->snp->Receive ( snp->snp, NULL, &len,
-						   snp->rxbuf->data, NULL,
+						   iobuf->data, NULL,
 						   NULL, NULL ) ) != 0 ) {
 
 			/* EFI_NOT_READY is just the usual "no packet"
-			 * status indication; ignore it.
+			 * status indication; ignore it.  The buffer
+			 * remains in the pool for the next poll.
 			 */
 			if ( efirc == EFI_NOT_READY )
 				break;
@@ -262,10 +311,11 @@ static void snpnet_poll_rx ( struct net_device *netdev ) {
 			break;
 		}
 
-		/* Hand off to network stack */
-		iob_put ( snp->rxbuf, len );
-		netdev_rx ( netdev, snp->rxbuf );
-		snp->rxbuf = NULL;
+		/* Remove from pool and hand off to network stack */
+		list_del ( &iobuf->list );
+		snp->rxfill--;
+		iob_put ( iobuf, len );
+		netdev_rx ( netdev, iobuf );
 	}
 }
 
@@ -377,6 +427,8 @@ static int snpnet_open ( struct net_device *netdev ) {
  */
 static void snpnet_close ( struct net_device *netdev ) {
 	struct snp_nic *snp = netdev->priv;
+	struct io_buffer *iobuf;
+	struct io_buffer *tmp;
 	EFI_STATUS efirc;
 	int rc;
 
@@ -394,11 +446,13 @@ static void snpnet_close ( struct net_device *netdev ) {
 		snp->txbuf = NULL;
 	}
 
-	/* Discard receive buffer, if applicable */
-	if ( snp->rxbuf ) {
-		free_iob ( snp->rxbuf );
-		snp->rxbuf = NULL;
+	/* Discard pre-allocated receive buffers, if any */
+	list_for_each_entry_safe ( iobuf, tmp, &snp->rxbufs, list ) {
+		list_del ( &iobuf->list );
+		free_iob ( iobuf );
+		snp->rxfill--;
 	}
+	assert ( snp->rxfill == 0 );
 }
 
 /** SNP network device operations */
@@ -449,6 +503,7 @@ int snpnet_start ( struct efi_device *efidev ) {
 	snp = netdev->priv;
 	snp->efidev = efidev;
 	snp->snp = interface;
+	INIT_LIST_HEAD ( &snp->rxbufs );
 	mode = snp->snp->Mode;
 	efidev_set_drvdata ( efidev, netdev );
 
@@ -573,21 +573,19 @@ static int ena_get_device_attributes ( struct net_device *netdev ) {
 }
 
 /**
- * Get statistics (for debugging)
+ * Get statistics
  *
- * @v ena		ENA device
+ * @v netdev		Network device
  * @ret rc		Return status code
  */
-static int ena_get_stats ( struct ena_nic *ena ) {
+static int ena_get_stats ( struct net_device *netdev ) {
+	struct ena_nic *ena = netdev->priv;
 	union ena_aq_req *req;
 	union ena_acq_rsp *rsp;
 	struct ena_get_stats_rsp *stats;
+	uint64_t drops;
 	int rc;
 
-	/* Do nothing unless debug messages are enabled */
-	if ( ! DBG_LOG )
-		return 0;
-
 	/* Construct request */
 	req = ena_admin_req ( ena );
 	req->header.opcode = ENA_GET_STATS;
@@ -609,6 +607,14 @@ static int ena_get_stats ( struct ena_nic *ena ) {
 	       ( ( unsigned long long ) le64_to_cpu ( stats->rx_packets ) ),
 	       ( ( unsigned long long ) le64_to_cpu ( stats->rx_drops ) ) );
 
+	/* Record device-level receive drops (e.g. from ring
+	 * exhaustion) in the network device statistics, so that
+	 * starvation is visible without a debug build.
+	 */
+	drops = le64_to_cpu ( stats->rx_drops );
+	for ( ; ena->rx_drops < drops ; ena->rx_drops++ )
+		netdev_rx_err ( netdev, NULL, -ENOBUFS );
+
 	return 0;
 }
 
@@ -633,11 +639,18 @@ static void ena_refill_rx ( struct net_device *netdev ) {
 	size_t len = netdev->max_pkt_len;
 	unsigned int refilled = 0;
 
+	/* Defer refilling until the watermark is reached, to batch
+	 * descriptor and doorbell writes.
+	 */
+	if ( ( ENA_RX_COUNT - ( ena->rx.sq.prod - ena->rx.cq.cons ) ) <
+	     ENA_RX_WATERMARK )
+		return;
+
 	/* Refill queue */
 	while ( ( ena->rx.sq.prod - ena->rx.cq.cons ) < ENA_RX_COUNT ) {
 
 		/* Allocate I/O buffer */
-		iobuf = alloc_iob ( len );
+		iobuf = alloc_iob_pool ( &ena->rx_pool, len );
 		if ( ! iobuf ) {
 			/* Wait for next refill */
 			break;
@@ -711,6 +724,10 @@ static int ena_open ( struct net_device *netdev ) {
 	if ( ( rc = ena_create_qp ( ena, &ena->rx ) ) != 0 )
 		goto err_create_rx;
 
+	/* Open receive buffer pool */
+	iob_pool_open ( &ena->rx_pool, &netdev->refcnt, netdev->max_pkt_len,
+			ENA_RX_COUNT );
+
 	/* Refill receive queue */
 	ena_refill_rx ( netdev );
 
@@ -731,8 +748,8 @@ static int ena_open ( struct net_device *netdev ) {
 static void ena_close ( struct net_device *netdev ) {
 	struct ena_nic *ena = netdev->priv;
 
-	/* Dump statistics (for debugging) */
-	ena_get_stats ( ena );
+	/* Retrieve and record final statistics */
+	ena_get_stats ( netdev );
 
 	/* Destroy receive queue pair */
 	ena_destroy_qp ( ena, &ena->rx );
@@ -740,6 +757,9 @@ static void ena_close ( struct net_device *netdev ) {
 	/* Discard any unused receive buffers */
 	ena_empty_rx ( ena );
 
+	/* Close receive buffer pool */
+	iob_pool_close ( &ena->rx_pool );
+
 	/* Destroy transmit queue pair */
 	ena_destroy_qp ( ena, &ena->tx );
 }
@@ -754,40 +774,59 @@ static void ena_close ( struct net_device *netdev ) {
 static int ena_transmit ( struct net_device *netdev, struct io_buffer *iobuf ) {
 	struct ena_nic *ena = netdev->priv;
 	struct ena_tx_sqe *sqe;
+	struct io_buffer *frag;
+	unsigned int frags;
 	unsigned int index;
+	uint8_t flags;
 	physaddr_t address;
 	size_t len;
 
-	/* Get next submission queue entry */
-	if ( ( ena->tx.sq.prod - ena->tx.cq.cons ) >= ENA_TX_COUNT ) {
+	/* Count fragments */
+	frags = iob_nfrags ( iobuf );
+
+	/* Check that sufficient submission queue entries are available */
+	if ( ( ena->tx.sq.prod + frags - ena->tx_reclaimed ) > ENA_TX_COUNT ) {
 		DBGC ( ena, "ENA %p out of transmit descriptors\n", ena );
 		return -ENOBUFS;
 	}
-	index = ( ena->tx.sq.prod % ENA_TX_COUNT );
-	sqe = &ena->tx.sq.sqe.tx[index];
-
-	/* Construct submission queue entry */
-	address = virt_to_bus ( iobuf->data );
-	len = iob_len ( iobuf );
-	sqe->len = cpu_to_le16 ( len );
-	sqe->id = ena->tx.sq.prod;
-	sqe->address = cpu_to_le64 ( address );
-	wmb();
-	sqe->flags = ( ENA_SQE_FIRST | ENA_SQE_LAST | ENA_SQE_CPL |
-		       ena->tx.sq.phase );
-	wmb();
 
-	/* Increment producer counter */
-	ena->tx.sq.prod++;
-	if ( ( ena->tx.sq.prod % ENA_TX_COUNT ) == 0 )
-		ena->tx.sq.phase ^= ENA_SQE_PHASE;
+	/* Construct one submission queue entry per fragment,
+	 * requesting a completion only for the final entry.
+	 */
+	iob_for_each_frag ( frag, iobuf ) {
+		index = ( ena->tx.sq.prod % ENA_TX_COUNT );
+		sqe = &ena->tx.sq.sqe.tx[index];
+		address = virt_to_bus ( frag->data );
+		len = iob_len ( frag );
+		sqe->len = cpu_to_le16 ( len );
+		sqe->id = ena->tx.sq.prod;
+		sqe->address = cpu_to_le64 ( address );
+		flags = ena->tx.sq.phase;
+		if ( frag == iobuf )
+			flags |= ENA_SQE_FIRST;
+		if ( ! frag->frag )
+			flags |= ( ENA_SQE_LAST | ENA_SQE_CPL );
+		wmb();
+		sqe->flags = flags;
+		wmb();
+
+		/* Increment producer counter */
+		ena->tx.sq.prod++;
+		if ( ( ena->tx.sq.prod % ENA_TX_COUNT ) == 0 )
+			ena->tx.sq.phase ^= ENA_SQE_PHASE;
+
+		DBGC2 ( ena, "ENA %p TX %d at [%08llx,%08llx)\n", ena, sqe->id,
+			( ( unsigned long long ) address ),
+			( ( unsigned long long ) address + len ) );
+	}
+
+	/* Record fragment count, for reclaiming entries on completion */
+	ena->tx_frags[ ena->tx_pkts % ENA_TX_COUNT ] = frags;
+	ena->tx_pkts++;
 
 	/* Ring doorbell */
 	writel ( ena->tx.sq.prod, ( ena->regs + ena->tx.sq.doorbell ) );
 
-	DBGC2 ( ena, "ENA %p TX %d at [%08llx,%08llx)\n", ena, sqe->id,
-		( ( unsigned long long ) address ),
-		( ( unsigned long long ) address + len ) );
 	return 0;
 }
 
@@ -801,8 +840,11 @@ static void ena_poll_tx ( struct net_device *netdev ) {
 	struct ena_tx_cqe *cqe;
 	unsigned int index;
 
-	/* Check for completed packets */
-	while ( ena->tx.cq.cons != ena->tx.sq.prod ) {
+	/* Check for completed packets.  The completion queue receives
+	 * one entry per packet, while the submission queue consumes
+	 * one entry per fragment.
+	 */
+	while ( ena->tx.cq.cons != ena->tx_pkts ) {
 
 		/* Get next completion queue entry */
 		index = ( ena->tx.cq.cons & ena->tx.cq.mask );
@@ -814,6 +856,10 @@ static void ena_poll_tx ( struct net_device *netdev ) {
 		DBGC2 ( ena, "ENA %p TX %d complete\n", ena,
 			( le16_to_cpu ( cqe->id ) >> 2 /* Don't ask */ ) );
 
+		/* Reclaim this packet's submission queue entries */
+		ena->tx_reclaimed +=
+			ena->tx_frags[ ena->tx.cq.cons % ENA_TX_COUNT ];
+
 		/* Increment consumer counter */
 		ena->tx.cq.cons++;
 		if ( ! ( ena->tx.cq.cons & ena->tx.cq.mask ) )
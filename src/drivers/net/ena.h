@@ -11,6 +11,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
 #include <ipxe/if_ether.h>
+#include <ipxe/iobuf.h>
 
 /** BAR size */
 #define ENA_BAR_SIZE 16384
@@ -25,10 +26,28 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define ENA_ACQ_COUNT 2
 
 /** Number of transmit queue entries */
+#ifndef ENA_TX_COUNT
 #define ENA_TX_COUNT 16
+#endif
 
-/** Number of receive queue entries */
-#define ENA_RX_COUNT 16
+/** Number of receive queue entries
+ *
+ * Must be a power of two no larger than 128, since queue counts are
+ * exchanged as 8-bit values.  The default is sized to ride out
+ * receive bursts at multi-gigabit instance speeds, and may be
+ * overridden at build time.
+ */
+#ifndef ENA_RX_COUNT
+#define ENA_RX_COUNT 64
+#endif
+
+/** Receive queue refill watermark
+ *
+ * Refilling is deferred until at least this many receive buffers
+ * have been consumed, so that descriptor and doorbell writes are
+ * batched.
+ */
+#define ENA_RX_WATERMARK ( ENA_RX_COUNT / 4 )
 
 /** Base address low register offset */
 #define ENA_BASE_LO 0x0
@@ -579,10 +598,20 @@ struct ena_nic {
 	struct ena_acq acq;
 	/** Transmit queue */
 	struct ena_qp tx;
+	/** Transmit packet counter */
+	unsigned int tx_pkts;
+	/** Reclaimed transmit submission queue entry counter */
+	unsigned int tx_reclaimed;
+	/** Per-packet transmit fragment counts */
+	uint8_t tx_frags[ENA_TX_COUNT];
 	/** Receive queue */
 	struct ena_qp rx;
 	/** Receive I/O buffers */
 	struct io_buffer *rx_iobuf[ENA_RX_COUNT];
+	/** Receive buffer recycling pool */
+	struct iob_pool rx_pool;
+	/** Last known device receive drop count */
+	uint64_t rx_drops;
 };
 
 #endif /* _ENA_H */
@@ -576,7 +576,7 @@ void intel_refill_rx ( struct intel_nic *intel ) {
 	while ( ( intel->rx.prod - intel->rx.cons ) < INTEL_RX_FILL ) {
 
 		/* Allocate I/O buffer */
-		iobuf = alloc_iob ( INTEL_RX_MAX_LEN );
+		iobuf = alloc_iob_pool ( &intel->rx_pool, INTEL_RX_MAX_LEN );
 		if ( ! iobuf ) {
 			/* Wait for next refill */
 			break;
@@ -681,6 +681,10 @@ static int intel_open ( struct net_device *netdev ) {
 		  INTEL_RCTL_BAM | INTEL_RCTL_BSIZE_2048 | INTEL_RCTL_SECRC );
 	writel ( rctl, intel->regs + INTEL_RCTL );
 
+	/* Prime receive buffer recycling pool */
+	iob_pool_open ( &intel->rx_pool, &netdev->refcnt, INTEL_RX_MAX_LEN,
+			INTEL_NUM_RX_DESC );
+
 	/* Fill receive ring */
 	intel_refill_rx ( intel );
 
@@ -723,6 +727,9 @@ static void intel_close ( struct net_device *netdev ) {
 	/* Discard any unused receive buffers */
 	intel_empty_rx ( intel );
 
+	/* Close receive buffer recycling pool */
+	iob_pool_close ( &intel->rx_pool );
+
 	/* Destroy transmit descriptor ring */
 	intel_destroy_ring ( intel, &intel->tx );
 
@@ -740,36 +747,52 @@ static void intel_close ( struct net_device *netdev ) {
 int intel_transmit ( struct net_device *netdev, struct io_buffer *iobuf ) {
 	struct intel_nic *intel = netdev->priv;
 	struct intel_descriptor *tx;
+	struct io_buffer *frag;
+	unsigned int frags;
 	unsigned int tx_idx;
 	unsigned int tx_tail;
 	physaddr_t address;
 	size_t len;
 
-	/* Get next transmit descriptor */
-	if ( ( intel->tx.prod - intel->tx.cons ) >= INTEL_TX_FILL ) {
+	/* Count fragments */
+	frags = iob_nfrags ( iobuf );
+
+	/* Check that sufficient transmit descriptors are available */
+	if ( ( intel->tx.prod + frags - intel->tx.cons ) > INTEL_TX_FILL ) {
 		DBGC ( intel, "INTEL %p out of transmit descriptors\n", intel );
 		return -ENOBUFS;
 	}
-	tx_idx = ( intel->tx.prod++ % INTEL_NUM_TX_DESC );
-	tx_tail = ( intel->tx.prod % INTEL_NUM_TX_DESC );
-	tx = &intel->tx.desc[tx_idx];
 
-	/* Populate transmit descriptor */
-	address = virt_to_bus ( iobuf->data );
-	len = iob_len ( iobuf );
-	intel->tx.describe ( tx, address, len );
+	/* Populate one transmit descriptor per fragment */
+	iob_for_each_frag ( frag, iobuf ) {
+
+		/* Get next transmit descriptor */
+		tx_idx = ( intel->tx.prod++ % INTEL_NUM_TX_DESC );
+		tx = &intel->tx.desc[tx_idx];
+
+		/* Populate transmit descriptor */
+		address = virt_to_bus ( frag->data );
+		len = iob_len ( frag );
+		intel->tx.describe ( tx, address, len );
+
+		/* Mark all but the final fragment as mid-packet */
+		intel->tx_eop[tx_idx] = ( frag->frag == NULL );
+		if ( frag->frag )
+			tx->command &= ~INTEL_DESC_CMD_EOP;
+
+		DBGC2 ( intel, "INTEL %p TX %d is [%llx,%llx)\n", intel,
+			tx_idx, ( ( unsigned long long ) address ),
+			( ( unsigned long long ) address + len ) );
+	}
 	wmb();
 
 	/* Notify card that there are packets ready to transmit */
+	tx_tail = ( intel->tx.prod % INTEL_NUM_TX_DESC );
 	profile_start ( &intel_vm_tx_profiler );
 	writel ( tx_tail, intel->regs + intel->tx.reg + INTEL_xDT );
 	profile_stop ( &intel_vm_tx_profiler );
 	profile_exclude ( &intel_vm_tx_profiler );
 
-	DBGC2 ( intel, "INTEL %p TX %d is [%llx,%llx)\n", intel, tx_idx,
-		( ( unsigned long long ) address ),
-		( ( unsigned long long ) address + len ) );
-
 	return 0;
 }
 
@@ -796,8 +819,9 @@ void intel_poll_tx ( struct net_device *netdev ) {
 
 		DBGC2 ( intel, "INTEL %p TX %d complete\n", intel, tx_idx );
 
-		/* Complete TX descriptor */
-		netdev_tx_complete_next ( netdev );
+		/* Complete packet on its final descriptor only */
+		if ( intel->tx_eop[tx_idx] )
+			netdev_tx_complete_next ( netdev );
 		intel->tx.cons++;
 	}
 }
@@ -11,6 +11,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
 #include <ipxe/if_ether.h>
+#include <ipxe/iobuf.h>
 #include <ipxe/nvs.h>
 
 /** Intel BAR size */
@@ -142,13 +143,19 @@ struct intel_descriptor {
 
 /** Number of receive descriptors
  *
- * Minimum value is 8, since the descriptor ring length must be a
- * multiple of 128.
+ * Must be a multiple of 8, since the descriptor ring length must be a
+ * multiple of 128 bytes.  The default is sized to absorb receive
+ * bursts on multi-gigabit devices without dropping, and may be
+ * overridden at build time.
  */
-#define INTEL_NUM_RX_DESC 16
+#ifndef INTEL_NUM_RX_DESC
+#define INTEL_NUM_RX_DESC 64
+#endif
 
 /** Receive descriptor ring fill level */
-#define INTEL_RX_FILL 8
+#ifndef INTEL_RX_FILL
+#define INTEL_RX_FILL ( INTEL_NUM_RX_DESC / 2 )
+#endif
 
 /** Receive buffer length */
 #define INTEL_RX_MAX_LEN 2048
@@ -296,10 +303,18 @@ struct intel_nic {
 
 	/** Transmit descriptor ring */
 	struct intel_ring tx;
+	/** Transmit end-of-packet markers
+	 *
+	 * Tracked in software, since descriptor write-back is not
+	 * guaranteed to preserve the command field.
+	 */
+	uint8_t tx_eop[INTEL_NUM_TX_DESC];
 	/** Receive descriptor ring */
 	struct intel_ring rx;
 	/** Receive I/O buffers */
 	struct io_buffer *rx_iobuf[INTEL_NUM_RX_DESC];
+	/** Receive I/O buffer recycling pool */
+	struct iob_pool rx_pool;
 };
 
 /** Driver flags */
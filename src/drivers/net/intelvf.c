@@ -150,13 +150,15 @@ int intelvf_mbox_msg ( struct intel_nic *intel, union intelvf_msg *msg ) {
 	struct intel_mailbox *mbox = &intel->mbox;
 	uint32_t ctrl;
 	uint32_t seen = 0;
-	unsigned int i;
+	unsigned int delay = INTELVF_MBOX_FAST_WAIT_US;
+	unsigned int waited;
 
 	/* Sanity check */
 	assert ( ! ( msg->hdr & INTELVF_MSG_RESPONSE ) );
 
 	/* Handle mailbox */
-	for ( i = 0 ; i < INTELVF_MBOX_MAX_WAIT_MS ; i++ ) {
+	for ( waited = 0 ; waited < ( INTELVF_MBOX_MAX_WAIT_MS * 1000 ) ;
+	      waited += delay ) {
 
 		/* Attempt to claim mailbox, if we have not yet sent
 		 * our message.
@@ -211,8 +213,13 @@ int intelvf_mbox_msg ( struct intel_nic *intel, union intelvf_msg *msg ) {
 			return 0;
 		}
 
-		/* Delay */
-		mdelay ( 1 );
+		/* Delay, backing off exponentially from microsecond
+		 * to millisecond granularity.
+		 */
+		udelay ( delay );
+		delay <<= 1;
+		if ( delay > INTELVF_MBOX_SLOW_WAIT_US )
+			delay = INTELVF_MBOX_SLOW_WAIT_US;
 	}
 
 	DBGC ( intel, "INTEL %p timed out waiting for mailbox (seen %08x)\n",
@@ -141,6 +141,19 @@ union intelvf_msg {
  */
 #define INTELVF_MBOX_MAX_WAIT_MS 500
 
+/** Initial delay between mailbox polls
+ *
+ * The PF driver will typically respond to a mailbox message within a
+ * few microseconds.  Poll at microsecond granularity initially
+ * (backing off exponentially to millisecond granularity) so that a
+ * responsive PF does not leave us sleeping through whole milliseconds
+ * per message.
+ */
+#define INTELVF_MBOX_FAST_WAIT_US 10
+
+/** Maximum delay between mailbox polls */
+#define INTELVF_MBOX_SLOW_WAIT_US 1000
+
 extern int intelvf_mbox_msg ( struct intel_nic *intel, union intelvf_msg *msg );
 extern int intelvf_mbox_poll ( struct intel_nic *intel );
 extern int intelvf_mbox_wait ( struct intel_nic *intel );
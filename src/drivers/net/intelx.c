@@ -256,6 +256,10 @@ static int intelx_open ( struct net_device *netdev ) {
 	rxctrl |= INTELX_RXCTRL_RXEN;
 	writel ( rxctrl, intel->regs + INTELX_RXCTRL );
 
+	/* Prime receive buffer recycling pool */
+	iob_pool_open ( &intel->rx_pool, &netdev->refcnt, INTEL_RX_MAX_LEN,
+			INTEL_NUM_RX_DESC );
+
 	/* Fill receive ring */
 	intel_refill_rx ( intel );
 
@@ -297,6 +301,9 @@ static void intelx_close ( struct net_device *netdev ) {
 	/* Discard any unused receive buffers */
 	intel_empty_rx ( intel );
 
+	/* Close receive buffer recycling pool */
+	iob_pool_close ( &intel->rx_pool );
+
 	/* Destroy transmit descriptor ring */
 	intel_destroy_ring ( intel, &intel->tx );
 
@@ -213,6 +213,7 @@ static int intelxvf_mbox_queues ( struct intel_nic *intel, int *vlan_thing ) {
  */
 static int intelxvf_open ( struct net_device *netdev ) {
 	struct intel_nic *intel = netdev->priv;
+	uint8_t hw_addr[ETH_ALEN];
 	uint32_t rxdctl;
 	uint32_t srrctl;
 	uint32_t dca_rxctrl;
@@ -223,8 +224,10 @@ static int intelxvf_open ( struct net_device *netdev ) {
 	/* Reset the function */
 	intelxvf_reset ( intel );
 
-	/* Notify PF that reset is complete */
-	if ( ( rc = intelvf_mbox_reset ( intel, NULL ) ) != 0 ) {
+	/* Notify PF that reset is complete, and fetch the MAC address
+	 * installed by the PF as part of handling the reset.
+	 */
+	if ( ( rc = intelvf_mbox_reset ( intel, hw_addr ) ) != 0 ) {
 		DBGC ( intel, "INTEL %p could not reset: %s\n",
 		       intel, strerror ( rc ) );
 		goto err_mbox_reset;
@@ -239,8 +242,12 @@ static int intelxvf_open ( struct net_device *netdev ) {
 	 */
 	intelxvf_mbox_version ( intel, INTELXVF_MSG_VERSION_1_1 );
 
-	/* Set MAC address */
-	if ( ( rc = intelvf_mbox_set_mac ( intel, netdev->ll_addr ) ) != 0 ) {
+	/* Set MAC address, unless the PF has already installed the
+	 * correct address while handling our reset message, in which
+	 * case the extra mailbox round trip would be a no-op.
+	 */
+	if ( ( memcmp ( hw_addr, netdev->ll_addr, ETH_ALEN ) != 0 ) &&
+	     ( ( rc = intelvf_mbox_set_mac ( intel, netdev->ll_addr ) ) != 0 )){
 		DBGC ( intel, "INTEL %p could not set MAC address: %s\n",
 		       intel, strerror ( rc ) );
 		goto err_mbox_set_mac;
@@ -309,6 +316,10 @@ static int intelxvf_open ( struct net_device *netdev ) {
 	dca_rxctrl &= ~INTELXVF_DCA_RXCTRL_MUST_BE_ZERO;
 	writel ( dca_rxctrl, intel->regs + INTELXVF_DCA_RXCTRL );
 
+	/* Prime receive buffer recycling pool */
+	iob_pool_open ( &intel->rx_pool, &netdev->refcnt, INTEL_RX_MAX_LEN,
+			INTEL_NUM_RX_DESC );
+
 	/* Fill receive ring */
 	intel_refill_rx ( intel );
 
@@ -342,6 +353,9 @@ static void intelxvf_close ( struct net_device *netdev ) {
 	/* Discard any unused receive buffers */
 	intel_empty_rx ( intel );
 
+	/* Close receive buffer recycling pool */
+	iob_pool_close ( &intel->rx_pool );
+
 	/* Destroy transmit descriptor ring */
 	intel_destroy_ring ( intel, &intel->tx );
 
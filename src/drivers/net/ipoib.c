@@ -753,9 +753,29 @@ void ipoib_join_complete ( struct ib_mc_membership *membership, int rc ) {
 	struct ipoib_device *ipoib = container_of ( membership,
 						    struct ipoib_device,
 						    broadcast.membership );
+	struct net_device *netdev = ipoib->netdev;
+	size_t max_pkt_len;
+
+	/* Size link MTU to match broadcast group MTU, if known.  The
+	 * group MTU is the fabric's effective datagram MTU: packets
+	 * larger than this will be dropped by the subnet, and packets
+	 * smaller than this waste available fabric bandwidth.
+	 */
+	if ( ( rc == 0 ) && membership->mtu ) {
+		max_pkt_len = membership->mtu;
+		if ( max_pkt_len > IB_MAX_PAYLOAD_SIZE )
+			max_pkt_len = IB_MAX_PAYLOAD_SIZE;
+		if ( max_pkt_len != netdev->max_pkt_len ) {
+			DBGC ( ipoib, "IPoIB %p using %zd byte packets\n",
+			       ipoib, max_pkt_len );
+			netdev->max_pkt_len = max_pkt_len;
+			netdev->mtu = ( max_pkt_len -
+					netdev->ll_protocol->ll_header_len );
+		}
+	}
 
 	/* Record join status as link status */
-	netdev_link_err ( ipoib->netdev, rc );
+	netdev_link_err ( netdev, rc );
 }
 
 /**
@@ -501,6 +501,24 @@ static void netfront_destroy_ring ( struct netfront_nic *netfront,
  ******************************************************************************
  */
 
+/**
+ * Suppress backend event notifications
+ *
+ * @v netfront		Netfront device
+ *
+ * We poll unconditionally and so have no need of event notifications
+ * from the backend.  Keeping the response event index permanently
+ * ahead of the response producer index saves the backend from issuing
+ * an event-channel hypercall for each batch of completed descriptors.
+ */
+static void netfront_suppress_events ( struct netfront_nic *netfront ) {
+
+	netfront->tx_sring->rsp_event =
+		( netfront->tx_fring.rsp_cons + NETFRONT_RSP_EVENT_LEAD );
+	netfront->rx_sring->rsp_event =
+		( netfront->rx_fring.rsp_cons + NETFRONT_RSP_EVENT_LEAD );
+}
+
 /**
  * Refill receive descriptor ring
  *
@@ -582,6 +600,9 @@ static int netfront_open ( struct net_device *netdev ) {
 	FRONT_RING_INIT ( &netfront->rx_fring, netfront->rx_sring, PAGE_SIZE );
 	assert ( RING_SIZE ( &netfront->rx_fring ) >= netfront->rx.count );
 
+	/* Suppress backend event notifications on both rings */
+	netfront_suppress_events ( netfront );
+
 	/* Create event channel */
 	if ( ( rc = netfront_create_event ( netfront ) ) != 0 )
 		goto err_create_event;
@@ -823,6 +844,7 @@ static void netfront_poll_rx ( struct net_device *netdev ) {
  * @v netdev		Network device
  */
 static void netfront_poll ( struct net_device *netdev ) {
+	struct netfront_nic *netfront = netdev->priv;
 
 	/* Poll for TX completions */
 	netfront_poll_tx ( netdev );
@@ -832,6 +854,9 @@ static void netfront_poll ( struct net_device *netdev ) {
 
 	/* Refill RX descriptor ring */
 	netfront_refill_rx ( netdev );
+
+	/* Keep backend event notifications suppressed */
+	netfront_suppress_events ( netfront );
 }
 
 /** Network device operations */
@@ -18,6 +18,15 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** Number of receive ring entries */
 #define NETFRONT_NUM_RX_DESC 32
 
+/** Response event index lead
+ *
+ * Keeping the response event index this far ahead of the response
+ * consumer index suppresses backend event notifications, which we
+ * never consume.  The lead must exceed the shared ring size, and is
+ * refreshed on every poll.
+ */
+#define NETFRONT_RSP_EVENT_LEAD 0x10000
+
 /** Receive ring fill level
  *
  * The xen-netback driver from kernels 3.18 to 4.2 inclusive have a
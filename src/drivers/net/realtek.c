@@ -448,7 +448,16 @@ static void realtek_check_link ( struct net_device *netdev ) {
 	int link_up;
 
 	/* Determine link state */
-	if ( rtl->have_phy_regs ) {
+	if ( rtl->is_8125 ) {
+		/* The integrated PHY is not accessible via PHYAR, but
+		 * the PHYSTATUS register remains present (with
+		 * additional speed bits that we do not decode).
+		 */
+		phystatus = readb ( rtl->regs + RTL_PHYSTATUS );
+		link_up = ( phystatus & RTL_PHYSTATUS_LINKSTS );
+		DBGC ( rtl, "REALTEK %p PHY status is %02x (Link%s)\n",
+		       rtl, phystatus, ( link_up ? "Up" : "Down" ) );
+	} else if ( rtl->have_phy_regs ) {
 		mii_dump ( &rtl->mii );
 		phystatus = readb ( rtl->regs + RTL_PHYSTATUS );
 		link_up = ( phystatus & RTL_PHYSTATUS_LINKSTS );
@@ -635,7 +644,9 @@ static void realtek_destroy_ring ( struct realtek_nic *rtl,
 static void realtek_refill_rx ( struct realtek_nic *rtl ) {
 	struct realtek_descriptor *rx;
 	struct io_buffer *iobuf;
+	unsigned int refilled = 0;
 	unsigned int rx_idx;
+	unsigned int i;
 	physaddr_t address;
 	int is_last;
 
@@ -643,37 +654,58 @@ static void realtek_refill_rx ( struct realtek_nic *rtl ) {
 	if ( rtl->legacy )
 		return;
 
+	/* Defer refilling until a batch of descriptors is empty, to
+	 * amortise the cost of the descriptor writes and barriers.
+	 */
+	if ( ( RTL_NUM_RX_DESC - ( rtl->rx.prod - rtl->rx.cons ) )
+	     < RTL_RX_WATERMARK )
+		return;
+
+	/* Populate all empty descriptors (without yet transferring
+	 * ownership to the card).
+	 */
 	while ( ( rtl->rx.prod - rtl->rx.cons ) < RTL_NUM_RX_DESC ) {
 
 		/* Allocate I/O buffer */
-		iobuf = alloc_iob ( RTL_RX_MAX_LEN );
+		iobuf = alloc_iob_pool ( &rtl->rx_pool, RTL_RX_MAX_LEN );
 		if ( ! iobuf ) {
 			/* Wait for next refill */
-			return;
+			break;
 		}
 
 		/* Get next receive descriptor */
 		rx_idx = ( rtl->rx.prod++ % RTL_NUM_RX_DESC );
-		is_last = ( rx_idx == ( RTL_NUM_RX_DESC - 1 ) );
 		rx = &rtl->rx.desc[rx_idx];
 
 		/* Populate receive descriptor */
 		address = virt_to_bus ( iobuf->data );
 		rx->address = cpu_to_le64 ( address );
 		rx->length = cpu_to_le16 ( RTL_RX_MAX_LEN );
-		wmb();
-		rx->flags = ( cpu_to_le16 ( RTL_DESC_OWN ) |
-			      ( is_last ? cpu_to_le16 ( RTL_DESC_EOR ) : 0 ) );
-		wmb();
 
 		/* Record I/O buffer */
 		assert ( rtl->rx_iobuf[rx_idx] == NULL );
 		rtl->rx_iobuf[rx_idx] = iobuf;
+		refilled++;
 
 		DBGC2 ( rtl, "REALTEK %p RX %d is [%llx,%llx)\n", rtl, rx_idx,
 			( ( unsigned long long ) address ),
 			( ( unsigned long long ) address + RTL_RX_MAX_LEN ) );
 	}
+
+	/* Hand ownership of the whole batch to the card, with a
+	 * single memory barrier to order the descriptor writes.
+	 */
+	if ( ! refilled )
+		return;
+	wmb();
+	for ( i = ( rtl->rx.prod - refilled ) ; i != rtl->rx.prod ; i++ ) {
+		rx_idx = ( i % RTL_NUM_RX_DESC );
+		is_last = ( rx_idx == ( RTL_NUM_RX_DESC - 1 ) );
+		rx = &rtl->rx.desc[rx_idx];
+		rx->flags = ( cpu_to_le16 ( RTL_DESC_OWN ) |
+			      ( is_last ? cpu_to_le16 ( RTL_DESC_EOR ) : 0 ) );
+	}
+	wmb();
 }
 
 /**
@@ -717,14 +749,25 @@ static int realtek_open ( struct net_device *netdev ) {
 
 	/* Configure receiver */
 	rcr = readl ( rtl->regs + RTL_RCR );
-	rcr &= ~( RTL_RCR_STOP_WORKING | RTL_RCR_RXFTH_MASK |
-		  RTL_RCR_RBLEN_MASK | RTL_RCR_MXDMA_MASK );
-	rcr |= ( RTL_RCR_RXFTH_DEFAULT | RTL_RCR_RBLEN_DEFAULT |
-		 RTL_RCR_MXDMA_DEFAULT | RTL_RCR_WRAP | RTL_RCR_AB |
-		 RTL_RCR_AM | RTL_RCR_APM | RTL_RCR_AAP );
+	if ( rtl->is_8125 ) {
+		/* The FIFO threshold and buffer length fields are not
+		 * present; the fetch count field replaces them.
+		 */
+		rcr &= ~( RTL_RCR_RXFETCH_MASK | RTL_RCR_MXDMA_MASK );
+		rcr |= ( RTL_RCR_RXFETCH_DEFAULT | RTL_RCR_MXDMA_DEFAULT |
+			 RTL_RCR_AB | RTL_RCR_AM | RTL_RCR_APM | RTL_RCR_AAP );
+	} else {
+		rcr &= ~( RTL_RCR_STOP_WORKING | RTL_RCR_RXFTH_MASK |
+			  RTL_RCR_RBLEN_MASK | RTL_RCR_MXDMA_MASK );
+		rcr |= ( RTL_RCR_RXFTH_DEFAULT | RTL_RCR_RBLEN_DEFAULT |
+			 RTL_RCR_MXDMA_DEFAULT | RTL_RCR_WRAP | RTL_RCR_AB |
+			 RTL_RCR_AM | RTL_RCR_APM | RTL_RCR_AAP );
+	}
 	writel ( rcr, rtl->regs + RTL_RCR );
 
-	/* Fill receive ring */
+	/* Prime receive buffer pool and fill receive ring */
+	iob_pool_open ( &rtl->rx_pool, &netdev->refcnt, RTL_RX_MAX_LEN,
+			RTL_NUM_RX_DESC );
 	realtek_refill_rx ( rtl );
 
 	/* Update link state */
@@ -766,6 +809,9 @@ static void realtek_close ( struct net_device *netdev ) {
 		rtl->rx_iobuf[i] = NULL;
 	}
 
+	/* Discard receive buffer pool */
+	iob_pool_close ( &rtl->rx_pool );
+
 	/* Destroy transmit descriptor ring */
 	realtek_destroy_ring ( rtl, &rtl->tx );
 }
@@ -826,7 +872,12 @@ static int realtek_transmit ( struct net_device *netdev,
 		wmb();
 
 		/* Notify card that there are packets ready to transmit */
-		writeb ( RTL_TPPOLL_NPQ, rtl->regs + rtl->tppoll );
+		if ( rtl->is_8125 ) {
+			writew ( RTL_TPPOLL_8125_NPQ,
+				 rtl->regs + RTL_TPPOLL_8125 );
+		} else {
+			writeb ( RTL_TPPOLL_NPQ, rtl->regs + rtl->tppoll );
+		}
 	}
 
 	DBGC2 ( rtl, "REALTEK %p TX %d is [%llx,%llx)\n", rtl, tx_idx,
@@ -990,13 +1041,23 @@ static void realtek_poll_rx ( struct net_device *netdev ) {
  */
 static void realtek_poll ( struct net_device *netdev ) {
 	struct realtek_nic *rtl = netdev->priv;
-	uint16_t isr;
+	uint32_t isr;
 
-	/* Check for and acknowledge interrupts */
-	isr = readw ( rtl->regs + RTL_ISR );
-	if ( ! isr )
-		return;
-	writew ( isr, rtl->regs + RTL_ISR );
+	/* Check for and acknowledge interrupts.  The status register
+	 * is relocated (and widened) on the 8125, but the bits we
+	 * care about retain their meanings.
+	 */
+	if ( rtl->is_8125 ) {
+		isr = readl ( rtl->regs + RTL_ISR_8125 );
+		if ( ! isr )
+			return;
+		writel ( isr, rtl->regs + RTL_ISR_8125 );
+	} else {
+		isr = readw ( rtl->regs + RTL_ISR );
+		if ( ! isr )
+			return;
+		writew ( isr, rtl->regs + RTL_ISR );
+	}
 
 	/* Poll for TX completions, if applicable */
 	if ( isr & ( RTL_IRQ_TER | RTL_IRQ_TOK ) )
@@ -1022,12 +1083,16 @@ static void realtek_poll ( struct net_device *netdev ) {
  */
 static void realtek_irq ( struct net_device *netdev, int enable ) {
 	struct realtek_nic *rtl = netdev->priv;
-	uint16_t imr;
+	uint32_t imr;
 
 	/* Set interrupt mask */
 	imr = ( enable ? ( RTL_IRQ_PUN_LINKCHG | RTL_IRQ_TER | RTL_IRQ_TOK |
 			   RTL_IRQ_RER | RTL_IRQ_ROK ) : 0 );
-	writew ( imr, rtl->regs + RTL_IMR );
+	if ( rtl->is_8125 ) {
+		writel ( imr, rtl->regs + RTL_IMR_8125 );
+	} else {
+		writew ( imr, rtl->regs + RTL_IMR );
+	}
 }
 
 /** Realtek network device operations */
@@ -1057,6 +1122,17 @@ static void realtek_detect ( struct realtek_nic *rtl ) {
 	uint16_t cpcr;
 	uint16_t check_cpcr;
 
+	/* The RTL8125 and RTL8126 are identified by PCI ID, since the
+	 * probes below would corrupt their relocated interrupt
+	 * registers.  They use the same descriptor-based datapath but
+	 * do not expose the PHY via the PHYAR register.
+	 */
+	if ( rtl->is_8125 ) {
+		DBGC ( rtl, "REALTEK %p is an RTL8125/RTL8126\n", rtl );
+		writew ( RTL_RX_MAX_LEN, rtl->regs + RTL_RMS );
+		return;
+	}
+
 	/* The RX Packet Maximum Size register is present only on
 	 * 8169.  Try to set to our intended MTU.
 	 */
@@ -1121,6 +1197,7 @@ static int realtek_probe ( struct pci_device *pci ) {
 	pci_set_drvdata ( pci, netdev );
 	netdev->dev = &pci->dev;
 	memset ( rtl, 0, sizeof ( *rtl ) );
+	rtl->is_8125 = ( !! ( pci->id->driver_data & RTL_FL_8125 ) );
 	realtek_init_ring ( &rtl->tx, RTL_NUM_TX_DESC, RTL_TNPDS );
 	realtek_init_ring ( &rtl->rx, RTL_NUM_RX_DESC, RTL_RDSAR );
 
@@ -1232,6 +1309,9 @@ static struct pci_device_id realtek_nics[] = {
 	PCI_ROM ( 0x021b, 0x8139, "hne300",	"Compaq HNE-300", 0 ),
 	PCI_ROM ( 0x02ac, 0x1012, "s1012",	"SpeedStream 1012", 0 ),
 	PCI_ROM ( 0x0357, 0x000a, "ttpmon",	"TTTech TTP-Monitoring", 0 ),
+	PCI_ROM ( 0x10ec, 0x3000, "rtl3000",	"Killer E3000", RTL_FL_8125 ),
+	PCI_ROM ( 0x10ec, 0x8125, "rtl8125",	"RTL8125 2.5GbE", RTL_FL_8125 ),
+	PCI_ROM ( 0x10ec, 0x8126, "rtl8126",	"RTL8126 5GbE", RTL_FL_8125 ),
 	PCI_ROM ( 0x10ec, 0x8129, "rtl8129",	"RTL-8129", 0 ),
 	PCI_ROM ( 0x10ec, 0x8136, "rtl8136",	"RTL8101E/RTL8102E", 0 ),
 	PCI_ROM ( 0x10ec, 0x8138, "rtl8138",	"RT8139 (B/C)", 0 ),
@@ -13,6 +13,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/spi_bit.h>
 #include <ipxe/nvo.h>
 #include <ipxe/if_ether.h>
+#include <ipxe/iobuf.h>
 
 /** PCI memory BAR size */
 #define RTL_BAR_SIZE 0x100
@@ -121,6 +122,12 @@ enum realtek_legacy_status {
 #define RTL_TPPOLL_8169 0x38
 #define RTL_TPPOLL_NPQ		0x40	/**< Normal Priority Queue Polling */
 
+/** Interrupt Mask Register (dword, 8125 only) */
+#define RTL_IMR_8125 0x38
+
+/** Interrupt Status Register (dword, 8125 only) */
+#define RTL_ISR_8125 0x3c
+
 /** Interrupt Mask Register (word) */
 #define RTL_IMR 0x3c
 #define RTL_IRQ_PUN_LINKCHG	0x0020	/**< Packet underrun / link change */
@@ -150,6 +157,9 @@ enum realtek_legacy_status {
 #define RTL_RCR_MXDMA(x)	( (x) << 8 ) /**< Max DMA burst size */
 #define RTL_RCR_MXDMA_MASK	RTL_RCR_MXDMA ( 0x7 )
 #define RTL_RCR_MXDMA_DEFAULT	RTL_RCR_MXDMA ( 0x7 /* Unlimited */ )
+#define RTL_RCR_RXFETCH(x)	( (x) << 27 ) /**< Fetch count (8125 only) */
+#define RTL_RCR_RXFETCH_MASK	RTL_RCR_RXFETCH ( 0xfUL )
+#define RTL_RCR_RXFETCH_DEFAULT	RTL_RCR_RXFETCH ( 0x8UL )
 #define RTL_RCR_WRAP		0x00000080UL /**< Overrun receive buffer */
 #define RTL_RCR_9356SEL		0x00000040UL /**< EEPROM is a 93C56 */
 #define RTL_RCR_AB		0x00000008UL /**< Accept broadcast packets */
@@ -220,6 +230,10 @@ enum realtek_legacy_status {
 #define RTL_PHYSTATUS_LINKSTS	0x02	/**< Link ok */
 #define RTL_PHYSTATUS_FULLDUP	0x01	/**< Full duplex */
 
+/** Transmit Priority Polling Register (word, 8125 only) */
+#define RTL_TPPOLL_8125 0x90
+#define RTL_TPPOLL_8125_NPQ	0x0001	/**< Normal Priority Queue Polling */
+
 /** Transmit Priority Polling Register (byte, 8139C+ only) */
 #define RTL_TPPOLL_8139CP 0xd9
 
@@ -236,8 +250,23 @@ enum realtek_legacy_status {
 /** Receive Descriptor Start Address Register (qword) */
 #define RTL_RDSAR 0xe4
 
-/** Number of receive descriptors */
-#define RTL_NUM_RX_DESC 4
+/** Number of receive descriptors
+ *
+ * The descriptor-based datapath places no hardware limit on the ring
+ * size.  A deeper ring is needed to avoid overruns between polls on
+ * multi-gigabit parts such as the RTL8125.
+ */
+#ifndef RTL_NUM_RX_DESC
+#define RTL_NUM_RX_DESC 16
+#endif
+
+/** Receive descriptor refill watermark
+ *
+ * Refilling is performed in batches, deferred until at least this
+ * many descriptors are empty, to amortise the cost of the descriptor
+ * writes and memory barriers.
+ */
+#define RTL_RX_WATERMARK ( RTL_NUM_RX_DESC / 4 )
 
 /** Receive buffer length */
 #define RTL_RX_MAX_LEN \
@@ -272,6 +301,12 @@ realtek_init_ring ( struct realtek_ring *ring, unsigned int count,
 	ring->reg = reg;
 }
 
+/** Driver flags */
+enum realtek_flags {
+	/** Device is an RTL8125/RTL8126 */
+	RTL_FL_8125 = 0x0001,
+};
+
 /** A Realtek network card */
 struct realtek_nic {
 	/** Registers */
@@ -289,6 +324,8 @@ struct realtek_nic {
 
 	/** Legacy datapath mode */
 	int legacy;
+	/** Device is an RTL8125/RTL8126 */
+	int is_8125;
 	/** PHYAR and PHYSTATUS registers are present */
 	int have_phy_regs;
 	/** TPPoll register offset */
@@ -298,6 +335,8 @@ struct realtek_nic {
 	struct realtek_ring tx;
 	/** Receive descriptor ring */
 	struct realtek_ring rx;
+	/** Receive I/O buffer pool */
+	struct iob_pool rx_pool;
 	/** Receive I/O buffers */
 	struct io_buffer *rx_iobuf[RTL_NUM_RX_DESC];
 	/** Receive buffer (legacy mode) */
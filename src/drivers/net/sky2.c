@@ -58,7 +58,11 @@ FILE_LICENCE ( GPL2_ONLY );
  * #defines) you'll get bad bugs.
  */
 
-#define RX_LE_SIZE	    	128
+/* Use double the minimum ring size; the corresponding increase in
+ * posted receive buffers avoids dropping back-to-back frames when a
+ * burst arrives between polls.
+ */
+#define RX_LE_SIZE	    	256
 #define RX_LE_BYTES		(RX_LE_SIZE*sizeof(struct sky2_rx_le))
 #define RX_RING_ALIGN		4096
 #define RX_PENDING		(RX_LE_SIZE/6 - 2)
@@ -1009,7 +1013,8 @@ static struct io_buffer *sky2_rx_alloc(struct sky2_port *sky2)
 {
 	struct io_buffer *iob;
 
-	iob = alloc_iob(sky2->rx_data_size + ETH_DATA_ALIGN);
+	iob = alloc_iob_pool(&sky2->rx_pool,
+			     sky2->rx_data_size + ETH_DATA_ALIGN);
 	if (!iob)
 		return NULL;
 
@@ -1076,6 +1081,12 @@ static int sky2_rx_start(struct sky2_port *sky2)
 
 	sky2->rx_data_size = size;
 
+	/* Recycle receive buffers rather than hitting the heap for
+	 * every received frame.
+	 */
+	iob_pool_open(&sky2->rx_pool, &sky2->netdev->refcnt,
+		      size + ETH_DATA_ALIGN, RX_PENDING);
+
 	/* Fill Rx ring */
 	for (i = 0; i < RX_PENDING; i++) {
 		re = sky2->rx_ring + i;
@@ -1106,6 +1117,7 @@ static int sky2_rx_start(struct sky2_port *sky2)
 	return 0;
 nomem:
 	sky2_rx_clean(sky2);
+	iob_pool_close(&sky2->rx_pool);
 	return -ENOMEM;
 }
 
@@ -1378,6 +1390,7 @@ static void sky2_down(struct net_device *dev)
 
 	sky2_tx_clean(dev);
 	sky2_rx_clean(sky2);
+	iob_pool_close(&sky2->rx_pool);
 
 	sky2_free_rings(sky2);
 
@@ -2052,6 +2052,7 @@ struct sky2_port {
 	u16		     rx_next;		/* next re to check */
 	u16		     rx_put;		/* next le index to use */
 	u16		     rx_data_size;
+	struct iob_pool	     rx_pool;		/* recycled rx buffers */
 
 	u32		     rx_le_map;
 	u32		     tx_le_map;
@@ -148,7 +148,7 @@ err_out:
  * the networking, so no interrupts or new tx packets will
  * end up in the driver.
  */
-static int tg3_rx_prodring_alloc(struct tg3 __unused *tp,
+static int tg3_rx_prodring_alloc(struct tg3 *tp,
 				 struct tg3_rx_prodring_set *tpr)
 {	DBGP("%s\n", __func__);
 
@@ -166,7 +166,7 @@ static int tg3_rx_prodring_alloc(struct tg3 __unused *tp,
 		struct tg3_rx_buffer_desc *rxd;
 
 		rxd = &tpr->rx_std[i];
-		rxd->idx_len = (TG3_RX_STD_DMA_SZ - 64 - 2) << RXD_LEN_SHIFT;
+		rxd->idx_len = TG3_RX_FRAME_SZ(tp) << RXD_LEN_SHIFT;
 		rxd->type_flags = (RXD_FLAG_END << RXD_FLAGS_SHIFT);
 		rxd->opaque = (RXD_OPAQUE_RING_STD |
 			       (i << RXD_OPAQUE_INDEX_SHIFT));
@@ -368,6 +368,7 @@ static void tg3_tx_complete(struct net_device *dev)
 static int tg3_alloc_rx_iob(struct tg3_rx_prodring_set *tpr, u32 dest_idx_unmasked)
 {	DBGP("%s\n", __func__);
 
+	struct tg3 *tp = container_of(tpr, struct tg3, prodring);
 	struct tg3_rx_buffer_desc *desc;
 	struct io_buffer *iob;
 	dma_addr_t mapping;
@@ -382,7 +383,7 @@ static int tg3_alloc_rx_iob(struct tg3_rx_prodring_set *tpr, u32 dest_idx_unmask
 	 * Callers depend upon this behavior and assume that
 	 * we leave everything unchanged if we fail.
 	 */
-	iob = alloc_iob(TG3_RX_STD_DMA_SZ);
+	iob = alloc_iob(TG3_RX_STD_DMA_SZ(tp));
 	if (iob == NULL)
 		return -ENOMEM;
 
@@ -455,6 +456,17 @@ static void tg3_rx_complete(struct net_device *dev)
 			len = ((desc->idx_len & RXD_LEN_MASK) >> RXD_LEN_SHIFT) -
 			        ETH_FCS_LEN;
 			iob_put(iob, len);
+
+			/* The hardware TCP/UDP checksum includes the
+			 * pseudo-header (see tg3_reset_hw), so a
+			 * value of 0xffff indicates a verified
+			 * checksum.
+			 */
+			if ((desc->type_flags & RXD_FLAG_TCPUDP_CSUM) &&
+			    ((desc->ip_tcp_csum & RXD_TCPCSUM_MASK) ==
+			     0xffff))
+				iob->flags |= IOB_FL_CSUM_OK;
+
 			netdev_rx(dev, iob);
 
 			DBGC2(dev, "Received packet: %d bytes %d %d\n", len, sw_idx, hw_idx);
@@ -815,6 +827,20 @@ static int tg3_init_one(struct pci_device *pdev)
 
 	tp->coal_now = HOSTCC_MODE_NOW;
 
+	/* These chips accept jumbo-sized buffers on their standard
+	 * receive ring.  Declare the capability, but leave the
+	 * default MTU at the ethernet standard; receive buffers are
+	 * sized from the configured MTU at open time.
+	 */
+	if (GET_ASIC_REV(tp->pci_chip_rev_id) == ASIC_REV_5714 ||
+	    GET_ASIC_REV(tp->pci_chip_rev_id) == ASIC_REV_5780 ||
+	    GET_ASIC_REV(tp->pci_chip_rev_id) == ASIC_REV_5717 ||
+	    GET_ASIC_REV(tp->pci_chip_rev_id) == ASIC_REV_5719 ||
+	    GET_ASIC_REV(tp->pci_chip_rev_id) == ASIC_REV_5720) {
+		dev->max_pkt_len = TG3_MAX_JUMBO_PKT_LEN;
+		dev->mtu = ETH_MAX_MTU;
+	}
+
 	err = register_netdev(dev);
 	if (err) {
 		DBGC(&pdev->dev, "Cannot register net device, aborting\n");
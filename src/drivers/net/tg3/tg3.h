@@ -3312,7 +3312,13 @@ struct tg3 {
 
 #define	TG3_DMA_ALIGNMENT	16
 
-#define TG3_RX_STD_DMA_SZ		(1536 + 64 + 2)
+/* MTU + ethernet header + optional VLAN tag + FCS */
+#define TG3_RX_FRAME_SZ(tp)	((tp)->dev->mtu + ETH_HLEN + 4 + ETH_FCS_LEN)
+#define TG3_RX_STD_DMA_SZ(tp)	(TG3_RX_FRAME_SZ(tp) + 64 + 2)
+
+/* Maximum packet length (for a 9000-byte jumbo MTU) on chips whose
+ * standard receive ring accepts jumbo-sized buffers */
+#define TG3_MAX_JUMBO_PKT_LEN	(9000 + ETH_HLEN)
 
 static inline void tw32_mailbox_flush(struct tg3 *tp, u32 off, u32 val)
 {
@@ -2152,9 +2152,8 @@ static int tg3_reset_hw(struct tg3 *tp, int reset_phy)
 
 	__tg3_set_mac_addr(tp,0);
 
-#define	TG3_MAX_MTU	1522
 	/* MTU + ethernet header + FCS + optional VLAN tag */
-	tw32(MAC_RX_MTU_SIZE, TG3_MAX_MTU);
+	tw32(MAC_RX_MTU_SIZE, TG3_RX_FRAME_SZ(tp));
 
 	/* The slot time is changed by tg3_setup_phy if we
 	 * run at gigabit with half duplex.
@@ -99,6 +99,9 @@ struct virtnet_nic {
 	/** Pending rx packet count */
 	unsigned int rx_num_iobufs;
 
+	/** RX buffer recycling pool */
+	struct iob_pool rx_pool;
+
 	/** Virtio net dummy packet headers */
 	struct virtio_net_hdr_modern empty_header[QUEUE_NB];
 };
@@ -108,45 +111,67 @@ struct virtnet_nic {
  * @v netdev		Network device
  * @v vq_idx		Virtqueue index (RX_INDEX or TX_INDEX)
  * @v iobuf		I/O buffer
+ * @v num_added		Number of iobufs already added since the last kick
  *
- * The virtqueue is kicked after the iobuf has been added.
+ * The caller is responsible for kicking the virtqueue (once per batch
+ * of added iobufs).
  */
 static void virtnet_enqueue_iob ( struct net_device *netdev,
-				  int vq_idx, struct io_buffer *iobuf ) {
+				  int vq_idx, struct io_buffer *iobuf,
+				  int num_added ) {
 	struct virtnet_nic *virtnet = netdev->priv;
 	struct vring_virtqueue *vq = &virtnet->virtqueue[vq_idx];
 	struct virtio_net_hdr_modern *header = &virtnet->empty_header[vq_idx];
-	unsigned int out = ( vq_idx == TX_INDEX ) ? 2 : 0;
-	unsigned int in = ( vq_idx == TX_INDEX ) ? 0 : 2;
 	size_t header_len = ( virtnet->virtio_version ?
 			      sizeof ( *header ) : sizeof ( header->legacy ) );
-	struct vring_list list[] = {
-		{
-			/* Share a single zeroed virtio net header between all
-			 * packets in a ring.  This works because this driver
-			 * does not use any advanced features so none of the
-			 * header fields get used.
-			 *
-			 * Some host implementations (notably Google Compute
-			 * Platform) are known to unconditionally write back
-			 * to header->flags for received packets.  Work around
-			 * this by using separate RX and TX headers.
-			 */
-			.addr = ( char* ) header,
-			.length = header_len,
-		},
-		{
-			.addr = ( char* ) iobuf->data,
-			.length = iob_len ( iobuf ),
-		},
-	};
+	struct vring_list list[ 1 /* header */ + IOB_MAX_FRAGS ];
+	unsigned int entries = 0;
+	unsigned int out;
+	unsigned int in;
+	struct io_buffer *frag;
+
+	/* Share a single zeroed virtio net header between all packets
+	 * in a ring.  This works because this driver does not use any
+	 * advanced features so none of the header fields get used.
+	 *
+	 * Some host implementations (notably Google Compute Platform)
+	 * are known to unconditionally write back to header->flags
+	 * for received packets.  Work around this by using separate
+	 * RX and TX headers.
+	 */
+	list[entries].addr = ( char * ) header;
+	list[entries].length = header_len;
+	entries++;
+
+	/* Add one scatter list entry per fragment */
+	iob_for_each_frag ( frag, iobuf ) {
+		assert ( entries < ( sizeof ( list ) / sizeof ( list[0] ) ) );
+		list[entries].addr = ( char * ) frag->data;
+		list[entries].length = iob_len ( frag );
+		entries++;
+	}
+	out = ( vq_idx == TX_INDEX ) ? entries : 0;
+	in = ( vq_idx == TX_INDEX ) ? 0 : entries;
 
 	DBGC2 ( virtnet, "VIRTIO-NET %p enqueuing iobuf %p on vq %d\n",
 		virtnet, iobuf, vq_idx );
 
-	vring_add_buf ( vq, list, out, in, iobuf, 0 );
+	vring_add_buf ( vq, list, out, in, iobuf, num_added );
+}
+
+/** Kick a virtqueue
+ *
+ * @v netdev		Network device
+ * @v vq_idx		Virtqueue index (RX_INDEX or TX_INDEX)
+ * @v num_added		Number of iobufs added since the last kick
+ */
+static void virtnet_kick ( struct net_device *netdev, int vq_idx,
+			   int num_added ) {
+	struct virtnet_nic *virtnet = netdev->priv;
+	struct vring_virtqueue *vq = &virtnet->virtqueue[vq_idx];
+
 	vring_kick ( virtnet->virtio_version ? &virtnet->vdev : NULL,
-		     virtnet->ioaddr, vq, 1 );
+		     virtnet->ioaddr, vq, num_added );
 }
 
 /** Try to keep rx virtqueue filled with iobufs
@@ -156,12 +181,13 @@ static void virtnet_enqueue_iob ( struct net_device *netdev,
 static void virtnet_refill_rx_virtqueue ( struct net_device *netdev ) {
 	struct virtnet_nic *virtnet = netdev->priv;
 	size_t len = ( netdev->max_pkt_len + 4 /* VLAN */ );
+	int num_added = 0;
 
 	while ( virtnet->rx_num_iobufs < NUM_RX_BUF ) {
 		struct io_buffer *iobuf;
 
 		/* Try to allocate a buffer, stop for now if out of memory */
-		iobuf = alloc_iob ( len );
+		iobuf = alloc_iob_pool ( &virtnet->rx_pool, len );
 		if ( ! iobuf )
 			break;
 
@@ -171,9 +197,14 @@ static void virtnet_refill_rx_virtqueue ( struct net_device *netdev ) {
 		/* Mark packet length until we know the actual size */
 		iob_put ( iobuf, len );
 
-		virtnet_enqueue_iob ( netdev, RX_INDEX, iobuf );
+		virtnet_enqueue_iob ( netdev, RX_INDEX, iobuf, num_added );
 		virtnet->rx_num_iobufs++;
+		num_added++;
 	}
+
+	/* Notify the host once for the entire batch */
+	if ( num_added )
+		virtnet_kick ( netdev, RX_INDEX, num_added );
 }
 
 /** Helper to free all virtqueue memory
@@ -226,6 +257,8 @@ static int virtnet_open_legacy ( struct net_device *netdev ) {
 	/* Initialize rx packets */
 	INIT_LIST_HEAD ( &virtnet->rx_iobufs );
 	virtnet->rx_num_iobufs = 0;
+	iob_pool_open ( &virtnet->rx_pool, &netdev->refcnt,
+			( netdev->max_pkt_len + 4 /* VLAN */ ), NUM_RX_BUF );
 	virtnet_refill_rx_virtqueue ( netdev );
 
 	/* Disable interrupts before starting */
@@ -234,7 +267,17 @@ static int virtnet_open_legacy ( struct net_device *netdev ) {
 	/* Driver is ready */
 	features = vp_get_features ( ioaddr );
 	vp_set_features ( ioaddr, features & ( ( 1 << VIRTIO_NET_F_MAC ) |
-					       ( 1 << VIRTIO_NET_F_MTU ) ) );
+					       ( 1 << VIRTIO_NET_F_MTU ) |
+					       ( 1 << VIRTIO_RING_F_EVENT_IDX ) ) );
+
+	/* Use event indices to suppress notifications, if supported */
+	if ( features & ( 1 << VIRTIO_RING_F_EVENT_IDX ) ) {
+		for ( i = 0; i < QUEUE_NB; i++ ) {
+			virtnet->virtqueue[i].event_idx = 1;
+			vring_disable_cb ( &virtnet->virtqueue[i] );
+		}
+	}
+
 	vp_set_status ( ioaddr, VIRTIO_CONFIG_S_DRIVER | VIRTIO_CONFIG_S_DRIVER_OK );
 	return 0;
 }
@@ -258,6 +301,7 @@ static int virtnet_open_modern ( struct net_device *netdev ) {
 	vpm_set_features ( &virtnet->vdev, features & (
 		( 1ULL << VIRTIO_NET_F_MAC ) |
 		( 1ULL << VIRTIO_NET_F_MTU ) |
+		( 1ULL << VIRTIO_RING_F_EVENT_IDX ) |
 		( 1ULL << VIRTIO_F_VERSION_1 ) |
 		( 1ULL << VIRTIO_F_ANY_LAYOUT ) |
 		( 1ULL << VIRTIO_F_IOMMU_PLATFORM ) ) );
@@ -288,6 +332,14 @@ static int virtnet_open_modern ( struct net_device *netdev ) {
 		return -ENOENT;
 	}
 
+	/* Use event indices to suppress notifications, if supported */
+	if ( features & ( 1ULL << VIRTIO_RING_F_EVENT_IDX ) ) {
+		int i;
+
+		for ( i = 0; i < QUEUE_NB; i++ )
+			virtnet->virtqueue[i].event_idx = 1;
+	}
+
 	/* Disable interrupts before starting */
 	netdev_irq ( netdev, 0 );
 
@@ -296,6 +348,8 @@ static int virtnet_open_modern ( struct net_device *netdev ) {
 	/* Initialize rx packets */
 	INIT_LIST_HEAD ( &virtnet->rx_iobufs );
 	virtnet->rx_num_iobufs = 0;
+	iob_pool_open ( &virtnet->rx_pool, &netdev->refcnt,
+			( netdev->max_pkt_len + 4 /* VLAN */ ), NUM_RX_BUF );
 	virtnet_refill_rx_virtqueue ( netdev );
 	return 0;
 }
@@ -333,12 +387,19 @@ static void virtnet_close ( struct net_device *netdev ) {
 	/* Virtqueues can be freed now that NIC is reset */
 	virtnet_free_virtqueues ( netdev );
 
-	/* Free rx iobufs */
+	/* Free rx iobufs (removing each from the tracking list first,
+	 * since freeing a pooled buffer will recycle it onto the
+	 * pool's own list).
+	 */
 	list_for_each_entry_safe ( iobuf, next_iobuf, &virtnet->rx_iobufs, list ) {
+		list_del ( &iobuf->list );
 		free_iob ( iobuf );
 	}
 	INIT_LIST_HEAD ( &virtnet->rx_iobufs );
 	virtnet->rx_num_iobufs = 0;
+
+	/* Close rx buffer pool */
+	iob_pool_close ( &virtnet->rx_pool );
 }
 
 /** Transmit packet
@@ -349,7 +410,8 @@ static void virtnet_close ( struct net_device *netdev ) {
  */
 static int virtnet_transmit ( struct net_device *netdev,
 			      struct io_buffer *iobuf ) {
-	virtnet_enqueue_iob ( netdev, TX_INDEX, iobuf );
+	virtnet_enqueue_iob ( netdev, TX_INDEX, iobuf, 0 );
+	virtnet_kick ( netdev, TX_INDEX, 1 );
 	return 0;
 }
 
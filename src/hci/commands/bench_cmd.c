@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2015 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <string.h>
+#include <getopt.h>
+#include <ipxe/command.h>
+#include <ipxe/parseopt.h>
+#include <ipxe/timer.h>
+#include <ipxe/sanboot.h>
+#include <usr/bench.h>
+
+/** @file
+ *
+ * Benchmark commands
+ *
+ */
+
+/** Default network benchmark port (the discard service) */
+#define NETBENCH_DEFAULT_PORT 9
+
+/** Default network benchmark payload length */
+#define NETBENCH_DEFAULT_LEN 1024
+
+/** Default network benchmark duration (in seconds) */
+#define NETBENCH_DEFAULT_SECONDS 3
+
+/** Default disk benchmark length per pass (in megabytes) */
+#define DISKBENCH_DEFAULT_MEGABYTES 16
+
+/** "netbench" options */
+struct netbench_options {
+	/** Port number */
+	unsigned int port;
+	/** Use TCP rather than UDP */
+	int tcp;
+	/** Payload length */
+	unsigned int len;
+	/** Duration (in seconds) */
+	unsigned int seconds;
+};
+
+/** "netbench" option list */
+static struct option_descriptor netbench_opts[] = {
+	OPTION_DESC ( "port", 'p', required_argument,
+		      struct netbench_options, port, parse_integer ),
+	OPTION_DESC ( "tcp", 't', no_argument,
+		      struct netbench_options, tcp, parse_flag ),
+	OPTION_DESC ( "length", 'l', required_argument,
+		      struct netbench_options, len, parse_integer ),
+	OPTION_DESC ( "seconds", 's', required_argument,
+		      struct netbench_options, seconds, parse_integer ),
+};
+
+/** "netbench" command descriptor */
+static struct command_descriptor netbench_cmd =
+	COMMAND_DESC ( struct netbench_options, netbench_opts, 1, 1,
+		       "<server>" );
+
+/**
+ * The "netbench" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int netbench_exec ( int argc, char **argv ) {
+	struct netbench_options opts;
+	const char *hostname;
+	int rc;
+
+	/* Initialise options */
+	memset ( &opts, 0, sizeof ( opts ) );
+	opts.port = NETBENCH_DEFAULT_PORT;
+	opts.len = NETBENCH_DEFAULT_LEN;
+	opts.seconds = NETBENCH_DEFAULT_SECONDS;
+
+	/* Parse options */
+	if ( ( rc = reparse_options ( argc, argv, &netbench_cmd,
+				      &opts ) ) != 0 )
+		return rc;
+
+	/* Parse server name */
+	hostname = argv[optind];
+
+	/* Run benchmark */
+	if ( ( rc = netbench ( hostname, opts.port, opts.tcp, opts.len,
+			       ( opts.seconds * TICKS_PER_SEC ) ) ) != 0 )
+		return rc;
+
+	return 0;
+}
+
+/** "diskbench" options */
+struct diskbench_options {
+	/** Drive number */
+	unsigned int drive;
+	/** Length per pass (in megabytes) */
+	unsigned int megabytes;
+};
+
+/** "diskbench" option list */
+static struct option_descriptor diskbench_opts[] = {
+	OPTION_DESC ( "drive", 'd', required_argument,
+		      struct diskbench_options, drive, parse_integer ),
+	OPTION_DESC ( "size", 's', required_argument,
+		      struct diskbench_options, megabytes, parse_integer ),
+};
+
+/** "diskbench" command descriptor */
+static struct command_descriptor diskbench_cmd =
+	COMMAND_DESC ( struct diskbench_options, diskbench_opts, 0, 0, NULL );
+
+/**
+ * The "diskbench" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int diskbench_exec ( int argc, char **argv ) {
+	struct diskbench_options opts;
+	int rc;
+
+	/* Initialise options */
+	memset ( &opts, 0, sizeof ( opts ) );
+	opts.drive = san_default_drive();
+	opts.megabytes = DISKBENCH_DEFAULT_MEGABYTES;
+
+	/* Parse options */
+	if ( ( rc = reparse_options ( argc, argv, &diskbench_cmd,
+				      &opts ) ) != 0 )
+		return rc;
+
+	/* Run benchmark */
+	if ( ( rc = diskbench ( opts.drive,
+				( ( ( size_t ) opts.megabytes ) << 20 ) ) ) !=0)
+		return rc;
+
+	return 0;
+}
+
+/** "cryptobench" options */
+struct cryptobench_options {};
+
+/** "cryptobench" option list */
+static struct option_descriptor cryptobench_opts[] = {};
+
+/** "cryptobench" command descriptor */
+static struct command_descriptor cryptobench_cmd =
+	COMMAND_DESC ( struct cryptobench_options, cryptobench_opts, 0, 0,
+		       NULL );
+
+/**
+ * The "cryptobench" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int cryptobench_exec ( int argc, char **argv ) {
+	struct cryptobench_options opts;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &cryptobench_cmd,
+				    &opts ) ) != 0 )
+		return rc;
+
+	/* Run benchmark */
+	if ( ( rc = cryptobench() ) != 0 )
+		return rc;
+
+	return 0;
+}
+
+/** Benchmark commands */
+struct command bench_commands[] __command = {
+	{
+		.name = "netbench",
+		.exec = netbench_exec,
+	},
+	{
+		.name = "diskbench",
+		.exec = diskbench_exec,
+	},
+	{
+		.name = "cryptobench",
+		.exec = cryptobench_exec,
+	},
+};
@@ -50,6 +50,8 @@ struct imgsingle_options {
 	int replace;
 	/** Free image after execution */
 	int autofree;
+	/** Download multiple images in parallel */
+	int parallel;
 };
 
 /** "img{single}" option list */
@@ -184,9 +186,21 @@ static int imgsingle_exec ( int argc, char **argv,
 	return rc;
 }
 
+/** "imgfetch" option list */
+static struct option_descriptor imgfetch_opts[] = {
+	OPTION_DESC ( "name", 'n', required_argument,
+		      struct imgsingle_options, name, parse_string ),
+	OPTION_DESC ( "timeout", 't', required_argument,
+		      struct imgsingle_options, timeout, parse_timeout ),
+	OPTION_DESC ( "autofree", 'a', no_argument,
+		      struct imgsingle_options, autofree, parse_flag ),
+	OPTION_DESC ( "parallel", 'p', no_argument,
+		      struct imgsingle_options, parallel, parse_flag ),
+};
+
 /** "imgfetch" command descriptor */
 static struct command_descriptor imgfetch_cmd =
-	COMMAND_DESC ( struct imgsingle_options, opts.imgsingle,
+	COMMAND_DESC ( struct imgsingle_options, imgfetch_opts,
 		       1, MAX_ARGUMENTS, "<uri> [<arguments>...]" );
 
 /** "imgfetch" family command descriptor */
@@ -203,9 +217,67 @@ struct imgsingle_descriptor imgfetch_desc = {
  * @ret rc		Return status code
  */
 static int imgfetch_exec ( int argc, char **argv ) {
+	struct imgsingle_options opts;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &imgfetch_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Download all URIs in parallel, if applicable.  The
+	 * remaining arguments are treated as additional URIs rather
+	 * than as an image command line.
+	 */
+	if ( opts.parallel ) {
+		return imgdownload_multiple ( &argv[optind],
+					      ( argc - optind ),
+					      opts.timeout );
+	}
+
+	/* Otherwise, fall through to the usual single-image handling */
+	reset_getopt();
 	return imgsingle_exec ( argc, argv, &imgfetch_desc );
 }
 
+/** "prefetch" options */
+struct prefetch_options {};
+
+/** "prefetch" option list */
+static struct option_descriptor prefetch_opts[] = {};
+
+/** "prefetch" command descriptor */
+static struct command_descriptor prefetch_cmd =
+	COMMAND_DESC ( struct prefetch_options, prefetch_opts,
+		       1, MAX_ARGUMENTS, "<uri> [<uri>...]" );
+
+/**
+ * The "prefetch" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int prefetch_exec ( int argc, char **argv ) {
+	struct prefetch_options opts;
+	int i;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &prefetch_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Start background prefetch of each URI */
+	for ( i = optind ; i < argc ; i++ ) {
+		if ( ( rc = imgprefetch ( argv[i] ) ) != 0 ) {
+			printf ( "Could not prefetch %s: %s\n",
+				 argv[i], strerror ( rc ) );
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
 /**
  * "imgselect" command action
  *
@@ -406,6 +478,10 @@ struct command image_commands[] __command = {
 		.name = "initrd",
 		.exec = imgfetch_exec, /* synonym for "imgfetch" */
 	},
+	{
+		.name = "prefetch",
+		.exec = prefetch_exec,
+	},
 	{
 		.name = "kernel",
 		.exec = imgselect_exec, /* synonym for "imgselect" */
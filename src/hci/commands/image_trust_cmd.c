@@ -90,6 +90,8 @@ struct imgverify_options {
 	char *signer;
 	/** Keep signature after verification */
 	int keep;
+	/** Verify in the background */
+	int async;
 	/** Download timeout */
 	unsigned long timeout;
 };
@@ -100,6 +102,8 @@ static struct option_descriptor imgverify_opts[] = {
 		      struct imgverify_options, signer, parse_string ),
 	OPTION_DESC ( "keep", 'k', no_argument,
 		      struct imgverify_options, keep, parse_flag ),
+	OPTION_DESC ( "async", 'a', no_argument,
+		      struct imgverify_options, async, parse_flag ),
 	OPTION_DESC ( "timeout", 't', required_argument,
 		      struct imgverify_options, timeout, parse_timeout),
 };
@@ -143,8 +147,16 @@ static int imgverify_exec ( int argc, char **argv ) {
 				 &signature ) ) != 0 )
 		goto err_acquire_signature;
 
-	/* Verify image */
-	if ( ( rc = imgverify ( image, signature, opts.signer ) ) != 0 ) {
+	/* Verify image.  If --async was specified then verification
+	 * continues as a background job, overlapping any subsequent
+	 * downloads; imgexec will wait for it to complete.
+	 */
+	if ( opts.async ) {
+		rc = imgverify_start ( image, signature, opts.signer );
+	} else {
+		rc = imgverify ( image, signature, opts.signer );
+	}
+	if ( rc != 0 ) {
 		printf ( "Could not verify: %s\n", strerror ( rc ) );
 		goto err_verify;
 	}
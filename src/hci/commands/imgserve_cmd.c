@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <string.h>
+#include <stdio.h>
+#include <getopt.h>
+#include <ipxe/command.h>
+#include <ipxe/parseopt.h>
+#include <ipxe/imgshare.h>
+
+/** @file
+ *
+ * Image serving command
+ *
+ */
+
+/** "imgserve" options */
+struct imgserve_options {};
+
+/** "imgserve" option list */
+static struct option_descriptor imgserve_opts[] = {};
+
+/** "imgserve" command descriptor */
+static struct command_descriptor imgserve_cmd =
+	COMMAND_DESC ( struct imgserve_options, imgserve_opts, 0, 0, NULL );
+
+/**
+ * The "imgserve" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int imgserve_exec ( int argc, char **argv ) {
+	struct imgserve_options opts;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &imgserve_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Start serving registered images */
+	if ( ( rc = imgshare_serve() ) != 0 ) {
+		printf ( "Could not serve images: %s\n", strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/** Image serving command */
+struct command imgserve_command __command = {
+	.name = "imgserve",
+	.exec = imgserve_exec,
+};
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <ipxe/command.h>
+#include <ipxe/parseopt.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/impair.h>
+
+/** @file
+ *
+ * Network impairment commands
+ *
+ */
+
+/** "impair" options */
+struct impair_options {
+	/** Link bandwidth (in kilobytes per second) */
+	unsigned int bandwidth;
+	/** Added latency (in milliseconds) */
+	unsigned int delay;
+	/** Loss rate (per mille) */
+	unsigned int loss;
+};
+
+/** "impair" option list */
+static struct option_descriptor impair_opts[] = {
+	OPTION_DESC ( "bandwidth", 'b', required_argument,
+		      struct impair_options, bandwidth, parse_integer ),
+	OPTION_DESC ( "delay", 'd', required_argument,
+		      struct impair_options, delay, parse_integer ),
+	OPTION_DESC ( "loss", 'l', required_argument,
+		      struct impair_options, loss, parse_integer ),
+};
+
+/** "impair" command descriptor */
+static struct command_descriptor impair_cmd =
+	COMMAND_DESC ( struct impair_options, impair_opts, 1, 1,
+		       "<interface>" );
+
+/**
+ * "impair" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ *
+ * With no options, any existing impairment is removed.
+ */
+static int impair_exec ( int argc, char **argv ) {
+	struct impair_options opts;
+	struct net_device *netdev;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &impair_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Parse network device */
+	if ( ( rc = parse_netdev ( argv[optind], &netdev ) ) != 0 )
+		return rc;
+
+	/* (Re)configure impairment */
+	if ( ( rc = impair_set ( netdev, opts.bandwidth, opts.delay,
+				 opts.loss ) ) != 0 ) {
+		printf ( "Could not impair %s: %s\n",
+			 netdev->name, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/** Network impairment command */
+struct command impair_command __command = {
+	.name = "impair",
+	.exec = impair_exec,
+};
@@ -37,10 +37,16 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 
 /** "ntp" options */
-struct ntp_options {};
+struct ntp_options {
+	/** Synchronise in the background */
+	int background;
+};
 
 /** "ntp" option list */
-static struct option_descriptor ntp_opts[] = {};
+static struct option_descriptor ntp_opts[] = {
+	OPTION_DESC ( "background", 'b', no_argument,
+		      struct ntp_options, background, parse_flag ),
+};
 
 /** "ntp" command descriptor */
 static struct command_descriptor ntp_cmd =
@@ -65,8 +71,13 @@ static int ntp_exec ( int argc, char **argv ) {
 	/* Parse hostname */
 	hostname = argv[optind];
 
-	/* Get time and date via NTP */
-	if ( ( rc = ntp ( hostname ) ) != 0 ) {
+	/* Get time and date via NTP, in the background if requested */
+	if ( opts.background ) {
+		rc = ntp_start ( hostname );
+	} else {
+		rc = ntp ( hostname );
+	}
+	if ( rc != 0 ) {
 		printf ( "Could not get time and date: %s\n", strerror ( rc ) );
 		return rc;
 	}
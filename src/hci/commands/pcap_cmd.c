@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <ipxe/command.h>
+#include <ipxe/parseopt.h>
+#include <ipxe/pcap.h>
+
+/** @file
+ *
+ * Packet capture commands
+ *
+ */
+
+/** "pcap" options */
+struct pcap_options {
+	/** Capture buffer size */
+	unsigned int size;
+};
+
+/** "pcap" option list */
+static struct option_descriptor pcap_opts[] = {
+	OPTION_DESC ( "size", 's', required_argument,
+		      struct pcap_options, size, parse_integer ),
+};
+
+/** "pcap" command descriptor */
+static struct command_descriptor pcap_cmd =
+	COMMAND_DESC ( struct pcap_options, pcap_opts, 0, 1, "[<name>]" );
+
+/**
+ * "pcap" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ *
+ * With a name, start capturing ingress frames.  Without a name, stop
+ * the capture in progress and register the captured trace as an
+ * image.
+ */
+static int pcap_exec ( int argc, char **argv ) {
+	struct pcap_options opts;
+	const char *name;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &pcap_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Start or stop capture as applicable */
+	if ( optind < argc ) {
+		name = argv[optind];
+		rc = pcap_start ( name, opts.size );
+	} else {
+		rc = pcap_stop();
+	}
+	if ( rc != 0 ) {
+		printf ( "Could not capture: %s\n", strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/** Packet capture command */
+struct command pcap_command __command = {
+	.name = "pcap",
+	.exec = pcap_exec,
+};
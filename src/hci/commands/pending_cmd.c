@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2015 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <ipxe/command.h>
+#include <ipxe/parseopt.h>
+#include <ipxe/pending.h>
+
+/** @file
+ *
+ * Pending operations command
+ *
+ */
+
+/** "pending" options */
+struct pending_options {};
+
+/** "pending" option list */
+static struct option_descriptor pending_opts[] = {};
+
+/** "pending" command descriptor */
+static struct command_descriptor pending_cmd =
+	COMMAND_DESC ( struct pending_options, pending_opts, 0, 0, NULL );
+
+/**
+ * The "pending" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int pending_exec ( int argc, char **argv ) {
+	struct pending_options opts;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &pending_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Show current waiters */
+	pending_show();
+
+	return 0;
+}
+
+/** Pending operations command */
+struct command pending_command __command = {
+	.name = "pending",
+	.exec = pending_exec,
+};
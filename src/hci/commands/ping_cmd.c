@@ -52,6 +52,8 @@ struct ping_options {
 	unsigned int size;
 	/** Timeout (in ms) */
 	unsigned long timeout;
+	/** Interval between transmissions (in ms) */
+	unsigned long interval;
 	/** Number of packets to send (or zero for no limit) */
 	unsigned int count;
 	/** Inhibit output */
@@ -64,6 +66,8 @@ static struct option_descriptor ping_opts[] = {
 		      struct ping_options, size, parse_integer ),
 	OPTION_DESC ( "timeout", 't', required_argument,
 		      struct ping_options, timeout, parse_timeout ),
+	OPTION_DESC ( "interval", 'i', required_argument,
+		      struct ping_options, interval, parse_timeout ),
 	OPTION_DESC ( "count", 'c', required_argument,
 		      struct ping_options, count, parse_integer ),
 	OPTION_DESC ( "quiet", 'q', no_argument,
@@ -99,7 +103,7 @@ static int ping_exec ( int argc, char **argv ) {
 	hostname = argv[optind];
 
 	/* Ping */
-	if ( ( rc = ping ( hostname, opts.timeout, opts.size,
+	if ( ( rc = ping ( hostname, opts.timeout, opts.interval, opts.size,
 			   opts.count, opts.quiet ) ) != 0 )
 		return rc;
 
@@ -36,10 +36,16 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 
 /** "profstat" options */
-struct profstat_options {};
+struct profstat_options {
+	/** Export via system logger */
+	int export;
+};
 
 /** "profstat" option list */
-static struct option_descriptor profstat_opts[] = {};
+static struct option_descriptor profstat_opts[] = {
+	OPTION_DESC ( "export", 'e', no_argument,
+		      struct profstat_options, export, parse_flag ),
+};
 
 /** "profstat" command descriptor */
 static struct command_descriptor profstat_cmd =
@@ -60,7 +66,11 @@ static int profstat_exec ( int argc, char **argv ) {
 	if ( ( rc = parse_options ( argc, argv, &profstat_cmd, &opts ) ) != 0 )
 		return rc;
 
-	profstat();
+	if ( opts.export ) {
+		profstat_export();
+	} else {
+		profstat();
+	}
 
 	return 0;
 }
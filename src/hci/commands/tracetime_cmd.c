@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2015 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <ipxe/command.h>
+#include <ipxe/parseopt.h>
+#include <ipxe/boottrace.h>
+
+/** @file
+ *
+ * Boot trace command
+ *
+ */
+
+/** "tracetime" options */
+struct tracetime_options {};
+
+/** "tracetime" option list */
+static struct option_descriptor tracetime_opts[] = {};
+
+/** "tracetime" command descriptor */
+static struct command_descriptor tracetime_cmd =
+	COMMAND_DESC ( struct tracetime_options, tracetime_opts, 0, 0, NULL );
+
+/**
+ * The "tracetime" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int tracetime_exec ( int argc, char **argv ) {
+	struct tracetime_options opts;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &tracetime_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Show recorded boot trace markers */
+	boottrace_show();
+
+	return 0;
+}
+
+/** Boot trace command */
+struct command tracetime_command __command = {
+	.name = "tracetime",
+	.exec = tracetime_exec,
+};
@@ -171,7 +171,23 @@ static void kill_eol ( struct edit_string *string ) {
  * @v replacement	Replacement string
  */
 void replace_string ( struct edit_string *string, const char *replacement ) {
-	string->cursor = 0;
+	const char *buf = string->buf;
+	size_t prefix_len = 0;
+
+	/* Skip over any common prefix, which does not need to be
+	 * modified (or redrawn by a caller using the edit history)
+	 */
+	while ( buf[prefix_len] &&
+		( buf[prefix_len] == replacement[prefix_len] ) ) {
+		prefix_len++;
+	}
+	replacement += prefix_len;
+
+	/* Record current cursor position in the edit history */
+	string->last_cursor = string->cursor;
+
+	/* Replace all text following the common prefix */
+	string->cursor = prefix_len;
 	insert_delete ( string, ~( ( size_t ) 0 ), replacement );
 }
 
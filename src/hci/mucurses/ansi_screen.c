@@ -50,6 +50,11 @@ static void ansiscr_erase ( struct _curses_screen *scr, attr_t attrs ) {
 	printf ( "\033[2J" );
 }
 
+static void ansiscr_clrtoeol ( struct _curses_screen *scr, attr_t attrs ) {
+	ansiscr_attrs ( scr, attrs );
+	printf ( "\033[K" );
+}
+
 static void ansiscr_movetoyx ( struct _curses_screen *scr,
 			       unsigned int y, unsigned int x ) {
 	if ( ( x != scr->curs_x ) || ( y != scr->curs_y ) ) {
@@ -94,6 +99,7 @@ SCREEN _ansi_screen = {
 	.init		= ansiscr_init,
 	.exit		= ansiscr_exit,
 	.erase		= ansiscr_erase,
+	.clrtoeol	= ansiscr_clrtoeol,
 	.movetoyx	= ansiscr_movetoyx,
 	.putc		= ansiscr_putc,
 	.getc		= ansiscr_getc,
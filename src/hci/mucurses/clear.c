@@ -37,6 +37,17 @@ int wclrtobot ( WINDOW *win ) {
 int wclrtoeol ( WINDOW *win ) {
 	struct cursor_pos pos;
 
+	/* Use the screen's clear-to-end-of-line primitive (a short
+	 * escape sequence, on ANSI screens) where the window extends
+	 * to the screen's right edge, rather than transmitting a
+	 * window width's worth of spaces.
+	 */
+	if ( ( win->ori_x + win->width ) == ( unsigned int ) COLS ) {
+		wmove ( win, win->curs_y, win->curs_x );
+		win->scr->clrtoeol ( win->scr, win->attrs );
+		return OK;
+	}
+
 	_store_curs_pos( win, &pos );
 	while ( ( win->curs_y - pos.y ) == 0 ) {
 		_wputc( win, ' ', WRAP );
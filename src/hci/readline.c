@@ -169,6 +169,31 @@ static const char * history_move ( struct readline_history *history,
 	return new_string;
 }
 
+/**
+ * Find a history entry containing a search string
+ *
+ * @v history		History buffer
+ * @v search		Search string
+ * @v min_depth		Minimum depth within history buffer
+ * @ret depth		Depth of matching entry, or negative error
+ */
+static int history_find ( struct readline_history *history,
+			  const char *search, unsigned int min_depth ) {
+	const char *string;
+	unsigned int depth;
+
+	for ( depth = min_depth ; depth <= READLINE_HISTORY_MAX_DEPTH ;
+	      depth++ ) {
+		string = history_fetch ( history, depth );
+		if ( ! string )
+			break;
+		if ( strstr ( string, search ) )
+			return depth;
+	}
+
+	return -ENOENT;
+}
+
 /**
  * Append new history entry
  *
@@ -242,6 +267,65 @@ void history_free ( struct readline_history *history ) {
 	}
 }
 
+/**
+ * Handle keypress during incremental history search
+ *
+ * @v string		Editable string
+ * @v history		History buffer
+ * @v search		Search string buffer
+ * @v search_len	Length of search string (updated)
+ * @v key		Key pressed by user
+ * @ret key		Key for normal processing, or zero if consumed
+ *
+ * The current match is displayed in place via the normal edit string
+ * machinery; since replace_string() modifies only the text following
+ * any common prefix, refining the search string typically redraws
+ * little or nothing.
+ */
+static int isearch_key ( struct edit_string *string,
+			 struct readline_history *history,
+			 char *search, size_t *search_len, int key ) {
+	const char *new_string;
+	unsigned int min_depth;
+	int depth;
+
+	/* Determine search action */
+	if ( ( key >= 0x20 ) && ( key <= 0x7e ) &&
+	     ( *search_len < ( READLINE_MAX - 1 ) ) ) {
+		/* Extend search string; the current match may still
+		 * qualify, so search from the current depth.
+		 */
+		search[ (*search_len)++ ] = key;
+		search[ *search_len ] = '\0';
+		min_depth = ( history->depth ? history->depth : 1 );
+	} else if ( key == CTRL_R ) {
+		/* Find next match */
+		min_depth = ( history->depth + 1 );
+	} else if ( key == KEY_BACKSPACE ) {
+		/* Shorten search string and restart search */
+		if ( *search_len )
+			search[ --(*search_len) ] = '\0';
+		min_depth = 1;
+	} else {
+		/* Terminate search; key will be processed as normal */
+		return key;
+	}
+
+	/* Find and display match, if any */
+	depth = history_find ( history, search, min_depth );
+	if ( depth > 0 ) {
+		new_string = history_move ( history,
+					    ( depth - ( int ) history->depth ),
+					    string->buf );
+		if ( new_string ) {
+			replace_string ( string, new_string );
+			sync_console ( string );
+		}
+	}
+
+	return 0;
+}
+
 /**
  * Read line from console (with history)
  *
@@ -257,7 +341,10 @@ void history_free ( struct readline_history *history ) {
 int readline_history ( const char *prompt, const char *prefill,
 		       struct readline_history *history, char **line ) {
 	char buf[READLINE_MAX];
+	char search[READLINE_MAX];
 	struct edit_string string;
+	size_t search_len = 0;
+	int searching = 0;
 	int key;
 	int move_by;
 	const char *new_string;
@@ -285,8 +372,20 @@ int readline_history ( const char *prompt, const char *prefill,
 	}
 
 	while ( 1 ) {
+		/* Get key */
+		key = getkey ( 0 );
+
+		/* Handle incremental history search, if applicable */
+		if ( searching ) {
+			key = isearch_key ( &string, history, search,
+					    &search_len, key );
+			if ( ! key )
+				continue;
+			searching = 0;
+		}
+
 		/* Handle keypress */
-		key = edit_string ( &string, getkey ( 0 ) );
+		key = edit_string ( &string, key );
 		sync_console ( &string );
 		move_by = 0;
 		switch ( key ) {
@@ -304,6 +403,14 @@ int readline_history ( const char *prompt, const char *prefill,
 		case KEY_DOWN:
 			move_by = -1;
 			break;
+		case CTRL_R:
+			/* Enter incremental history search */
+			if ( history ) {
+				search[0] = '\0';
+				search_len = 0;
+				searching = 1;
+			}
+			break;
 		default:
 			/* Do nothing */
 			break;
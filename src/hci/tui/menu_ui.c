@@ -127,8 +127,22 @@ static void draw_menu_item ( struct menu_ui *ui, unsigned int index ) {
 				 timeout_buf, timeout_len );
 		}
 
+		/* Strip trailing spaces from unhighlighted rows:
+		 * clearing to end of line is far cheaper to transmit
+		 * over a serial console than the padding itself.
+		 * Highlighted rows must be painted in full, since the
+		 * padding carries the highlight background.
+		 */
+		if ( index != ui->scroll.current ) {
+			len = ( sizeof ( buf ) - 1 );
+			while ( len && ( buf[ len - 1 ] == ' ' ) )
+				buf[ --len ] = '\0';
+		}
+
 		/* Print row */
 		printw ( "%s", buf );
+		if ( index != ui->scroll.current )
+			clrtoeol();
 
 		/* Reset attributes */
 		color_set ( CPAIR_NORMAL, NULL );
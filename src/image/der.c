@@ -115,6 +115,8 @@ static int der_probe ( struct image *image ) {
 /** DER image type */
 struct image_type der_image_type __image_type ( PROBE_NORMAL ) = {
 	.name = "DER",
+	.signature = "\x30", /* ASN1_SEQUENCE */
+	.siglen = 1,
 	.probe = der_probe,
 	.asn1 = der_asn1,
 };
@@ -324,6 +324,8 @@ static int efi_image_probe ( struct image *image ) {
 /** EFI image type */
 struct image_type efi_image_type __image_type ( PROBE_NORMAL ) = {
 	.name = "EFI",
+	.signature = "MZ",
+	.siglen = 2,
 	.probe = efi_image_probe,
 	.exec = efi_image_exec,
 };
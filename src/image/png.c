@@ -352,71 +352,74 @@ static int png_image_data ( struct image *image, struct png_context *png,
 }
 
 /**
- * Unfilter byte using the "None" filter
+ * Unfilter scanline using the "None" filter
  *
- * @v current		Filtered current byte
- * @v left		Unfiltered left byte
- * @v above		Unfiltered above byte
- * @v above_left	Unfiltered above-left byte
- * @ret current		Unfiltered current byte
+ * @v current		Scanline to unfilter
+ * @v previous		Previous (unfiltered) scanline
+ * @v len		Scanline length (excluding filter byte)
+ * @v pixel_len		Pixel length
  */
-static unsigned int png_unfilter_none ( unsigned int current,
-					unsigned int left __unused,
-					unsigned int above __unused,
-					unsigned int above_left __unused ) {
+static void png_unfilter_none ( uint8_t *current __unused,
+				uint8_t *previous __unused,
+				size_t len __unused,
+				size_t pixel_len __unused ) {
 
-	return current;
+	/* Nothing to do */
 }
 
 /**
- * Unfilter byte using the "Sub" filter
+ * Unfilter scanline using the "Sub" filter
  *
- * @v current		Filtered current byte
- * @v left		Unfiltered left byte
- * @v above		Unfiltered above byte
- * @v above_left	Unfiltered above-left byte
- * @ret current		Unfiltered current byte
+ * @v current		Scanline to unfilter
+ * @v previous		Previous (unfiltered) scanline
+ * @v len		Scanline length (excluding filter byte)
+ * @v pixel_len		Pixel length
  */
-static unsigned int png_unfilter_sub ( unsigned int current,
-				       unsigned int left,
-				       unsigned int above __unused,
-				       unsigned int above_left __unused ) {
-
-	return ( current + left );
+static void png_unfilter_sub ( uint8_t *current,
+			       uint8_t *previous __unused,
+			       size_t len, size_t pixel_len ) {
+	size_t i;
+
+	/* Left bytes for the first pixel are taken to be zero */
+	for ( i = pixel_len ; i < len ; i++ )
+		current[i] += current[ i - pixel_len ];
 }
 
 /**
- * Unfilter byte using the "Up" filter
+ * Unfilter scanline using the "Up" filter
  *
- * @v current		Filtered current byte
- * @v left		Unfiltered left byte
- * @v above		Unfiltered above byte
- * @v above_left	Unfiltered above-left byte
- * @ret current		Unfiltered current byte
+ * @v current		Scanline to unfilter
+ * @v previous		Previous (unfiltered) scanline
+ * @v len		Scanline length (excluding filter byte)
+ * @v pixel_len		Pixel length
  */
-static unsigned int png_unfilter_up ( unsigned int current,
-				      unsigned int left __unused,
-				      unsigned int above,
-				      unsigned int above_left __unused ) {
+static void png_unfilter_up ( uint8_t *current, uint8_t *previous,
+			      size_t len, size_t pixel_len __unused ) {
+	size_t i;
 
-	return ( current + above );
+	for ( i = 0 ; i < len ; i++ )
+		current[i] += previous[i];
 }
 
 /**
- * Unfilter byte using the "Average" filter
+ * Unfilter scanline using the "Average" filter
  *
- * @v current		Filtered current byte
- * @v left		Unfiltered left byte
- * @v above		Unfiltered above byte
- * @v above_left	Unfiltered above-left byte
- * @ret current		Unfiltered current byte
+ * @v current		Scanline to unfilter
+ * @v previous		Previous (unfiltered) scanline
+ * @v len		Scanline length (excluding filter byte)
+ * @v pixel_len		Pixel length
  */
-static unsigned int png_unfilter_average ( unsigned int current,
-					   unsigned int left,
-					   unsigned int above,
-					   unsigned int above_left __unused ) {
-
-	return ( current + ( ( above + left ) >> 1 ) );
+static void png_unfilter_average ( uint8_t *current, uint8_t *previous,
+				   size_t len, size_t pixel_len ) {
+	size_t i;
+
+	/* Left bytes for the first pixel are taken to be zero */
+	for ( i = 0 ; i < pixel_len ; i++ )
+		current[i] += ( previous[i] >> 1 );
+	for ( ; i < len ; i++ ) {
+		current[i] += ( ( current[ i - pixel_len ] +
+				  previous[i] ) >> 1 );
+	}
 }
 
 /**
@@ -449,37 +452,42 @@ static unsigned int png_paeth_predictor ( unsigned int a, unsigned int b,
 }
 
 /**
- * Unfilter byte using the "Paeth" filter
+ * Unfilter scanline using the "Paeth" filter
  *
- * @v current		Filtered current byte
- * @v above_left	Unfiltered above-left byte
- * @v above		Unfiltered above byte
- * @v left		Unfiltered left byte
- * @ret current		Unfiltered current byte
+ * @v current		Scanline to unfilter
+ * @v previous		Previous (unfiltered) scanline
+ * @v len		Scanline length (excluding filter byte)
+ * @v pixel_len		Pixel length
  */
-static unsigned int png_unfilter_paeth ( unsigned int current,
-					 unsigned int left,
-					 unsigned int above,
-					 unsigned int above_left ) {
+static void png_unfilter_paeth ( uint8_t *current, uint8_t *previous,
+				 size_t len, size_t pixel_len ) {
+	size_t i;
 
-	return ( current + png_paeth_predictor ( left, above, above_left ) );
+	/* Left and above-left bytes for the first pixel are taken to
+	 * be zero, for which the Paeth predictor degenerates to the
+	 * above byte.
+	 */
+	for ( i = 0 ; i < pixel_len ; i++ )
+		current[i] += previous[i];
+	for ( ; i < len ; i++ ) {
+		current[i] += png_paeth_predictor ( current[ i - pixel_len ],
+						    previous[i],
+						    previous[ i - pixel_len ] );
+	}
 }
 
 /** A PNG filter */
 struct png_filter {
 	/**
-	 * Unfilter byte
+	 * Unfilter scanline
 	 *
-	 * @v current		Filtered current byte
-	 * @v left		Unfiltered left byte
-	 * @v above		Unfiltered above byte
-	 * @v above_left	Unfiltered above-left byte
-	 * @ret current		Unfiltered current byte
+	 * @v current		Scanline to unfilter
+	 * @v previous		Previous (unfiltered) scanline
+	 * @v len		Scanline length (excluding filter byte)
+	 * @v pixel_len		Pixel length
 	 */
-	unsigned int ( * unfilter ) ( unsigned int current,
-				      unsigned int left,
-				      unsigned int above,
-				      unsigned int above_left );
+	void ( * unfilter ) ( uint8_t *current, uint8_t *previous,
+			      size_t len, size_t pixel_len );
 };
 
 /** PNG filter types */
@@ -503,23 +511,21 @@ static struct png_filter png_filters[] = {
  * data buffer, since the size is determined by the image dimensions.
  */
 static int png_unfilter_pass ( struct image *image, struct png_context *png,
-			       struct png_interlace *interlace ) {
+			       struct png_interlace *interlace,
+			       uint8_t *current, uint8_t *previous ) {
 	size_t offset = png->raw.offset;
 	size_t pixel_len = png_pixel_len ( png );
 	size_t scanline_len = png_scanline_len ( png, interlace );
+	size_t len = ( scanline_len - 1 /* filter byte */ );
 	struct png_filter *filter;
 	unsigned int scanline;
-	unsigned int byte;
 	uint8_t filter_type;
-	uint8_t left;
-	uint8_t above;
-	uint8_t above_left;
-	uint8_t current;
+	uint8_t *tmp;
 
 	/* On the first scanline of a pass, above bytes are assumed to
 	 * be zero.
 	 */
-	above = 0;
+	memset ( previous, 0, len );
 
 	/* Iterate over each scanline in turn */
 	for ( scanline = 0 ; scanline < interlace->height ; scanline++ ) {
@@ -538,41 +544,22 @@ static int png_unfilter_pass ( struct image *image, struct png_context *png,
 		DBGC2 ( image, "PNG %s pass %d scanline %d filter type %d\n",
 			image->name, interlace->pass, scanline, filter_type );
 
-		/* At the start of a line, both above-left and left
-		 * bytes are taken to be zero.
+		/* Unfilter one whole scanline at a time.  The
+		 * per-filter loops operate on plain byte arrays and
+		 * so can be vectorised by the compiler, and we avoid
+		 * issuing several user copies per byte.
 		 */
-		left = 0;
-		above_left = 0;
-
-		/* Iterate over each byte (not pixel) in turn */
-		for ( byte = 0 ; byte < ( scanline_len - 1 ) ; byte++ ) {
-
-			/* Extract predictor bytes, if applicable */
-			if ( byte >= pixel_len ) {
-				copy_from_user ( &left, png->raw.data,
-						 ( offset - pixel_len ),
-						 sizeof ( left ) );
-			}
-			if ( scanline > 0 ) {
-				copy_from_user ( &above, png->raw.data,
-						 ( offset - scanline_len ),
-						 sizeof ( above ) );
-			}
-			if ( ( scanline > 0 ) && ( byte >= pixel_len ) ) {
-				copy_from_user ( &above_left, png->raw.data,
-						 ( offset - scanline_len -
-						   pixel_len ),
-						 sizeof ( above_left ) );
-			}
+		copy_from_user ( current, png->raw.data, offset, len );
+		filter->unfilter ( current, previous, len, pixel_len );
+		copy_to_user ( png->raw.data, offset, current, len );
+		offset += len;
 
-			/* Unfilter current byte */
-			copy_from_user ( &current, png->raw.data,
-					 offset, sizeof ( current ) );
-			current = filter->unfilter ( current, left, above,
-						     above_left );
-			copy_to_user ( png->raw.data, offset++,
-				       &current, sizeof ( current ) );
-		}
+		/* Current scanline becomes the next scanline's
+		 * previous scanline.
+		 */
+		tmp = current;
+		current = previous;
+		previous = tmp;
 	}
 
 	/* Update offset */
@@ -593,9 +580,25 @@ static int png_unfilter_pass ( struct image *image, struct png_context *png,
  */
 static int png_unfilter ( struct image *image, struct png_context *png ) {
 	struct png_interlace interlace;
+	size_t scanline_len;
+	size_t max_len = 0;
+	uint8_t *scanlines;
 	unsigned int pass;
 	int rc;
 
+	/* Allocate scanline buffers, sized for the longest scanline */
+	for ( pass = 0 ; pass < png->passes ; pass++ ) {
+		png_interlace ( png, pass, &interlace );
+		scanline_len = png_scanline_len ( png, &interlace );
+		if ( scanline_len > max_len )
+			max_len = scanline_len;
+	}
+	scanlines = malloc ( 2 * max_len );
+	if ( ! scanlines ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
 	/* Process each interlace pass */
 	png->raw.offset = 0;
 	for ( pass = 0 ; pass < png->passes ; pass++ ) {
@@ -608,13 +611,18 @@ static int png_unfilter ( struct image *image, struct png_context *png ) {
 			continue;
 
 		/* Unfilter this pass */
-		if ( ( rc = png_unfilter_pass ( image, png,
-						&interlace ) ) != 0 )
-			return rc;
+		if ( ( rc = png_unfilter_pass ( image, png, &interlace,
+						scanlines,
+						( scanlines + max_len ) ) ) !=0)
+			goto err_pass;
 	}
 	assert ( png->raw.offset == png->raw.len );
 
-	return 0;
+	rc = 0;
+ err_pass:
+	free ( scanlines );
+ err_alloc:
+	return rc;
 }
 
 /**
@@ -637,6 +645,73 @@ static inline unsigned int png_pixel ( unsigned int raw, unsigned int alpha,
 	return ( ( ( ( ( 0xff00 * raw * alpha ) / max ) / max ) + 0x80 ) >> 8 );
 }
 
+/**
+ * Fill one interlace pass of PNG pixels from an 8-bit palette image
+ *
+ * @v image		PNG image
+ * @v png		PNG context
+ * @v interlace		Interlace pass
+ * @ret rc		Return status code
+ *
+ * Palette images with a bit depth of 8 and a contiguous output row
+ * (i.e. an interlace X stride of one) can be converted by a direct
+ * per-scanline lookup through the palette, avoiding the generic
+ * bit-extraction machinery.
+ */
+static int png_pixels_pass_indexed ( struct image *image,
+				     struct png_context *png,
+				     struct png_interlace *interlace ) {
+	size_t raw_offset = png->raw.offset;
+	size_t pixbuf_y_offset;
+	size_t pixbuf_y_stride;
+	size_t row_len;
+	uint32_t *pixels;
+	uint8_t *index;
+	unsigned int x;
+	unsigned int y;
+
+	/* Allocate scanline buffers */
+	row_len = ( interlace->width * sizeof ( pixels[0] ) );
+	pixels = malloc ( row_len + interlace->width );
+	if ( ! pixels )
+		return -ENOMEM;
+	index = ( ( ( void * ) pixels ) + row_len );
+
+	/* Calculate pixel buffer offset and stride */
+	pixbuf_y_offset = ( ( ( interlace->y_indent * png->pixbuf->width ) +
+			      interlace->x_indent ) * sizeof ( pixels[0] ) );
+	pixbuf_y_stride = ( interlace->y_stride * png->pixbuf->width *
+			    sizeof ( pixels[0] ) );
+	DBGC2 ( image, "PNG %s pass %d %dx%d at (%d,%d) indexed\n",
+		image->name, interlace->pass, interlace->width,
+		interlace->height, interlace->x_indent, interlace->y_indent );
+
+	/* Iterate over each scanline in turn */
+	for ( y = 0 ; y < interlace->height ; y++ ) {
+
+		/* Skip filter byte */
+		raw_offset++;
+
+		/* Convert scanline via palette lookup */
+		copy_from_user ( index, png->raw.data, raw_offset,
+				 interlace->width );
+		for ( x = 0 ; x < interlace->width ; x++ )
+			pixels[x] = png->palette[ index[x] ];
+		copy_to_user ( png->pixbuf->data, pixbuf_y_offset, pixels,
+			       row_len );
+
+		/* Move to next row */
+		raw_offset += interlace->width;
+		pixbuf_y_offset += pixbuf_y_stride;
+	}
+
+	/* Update offset */
+	png->raw.offset = raw_offset;
+
+	free ( pixels );
+	return 0;
+}
+
 /**
  * Fill one interlace pass of PNG pixels
  *
@@ -673,6 +748,14 @@ static void png_pixels_pass ( struct image *image,
 	uint8_t current = 0;
 	uint32_t pixel;
 
+	/* Use palette lookup fast path, if applicable (falling back
+	 * to the generic path on allocation failure).
+	 */
+	if ( is_indexed && ( png->depth == 8 ) &&
+	     ( interlace->x_stride == 1 ) &&
+	     ( png_pixels_pass_indexed ( image, png, interlace ) == 0 ) )
+		return;
+
 	/* We only ever use the top byte of 16-bit pixels.  Model this
 	 * as a bit depth of 8 with a stride of more than one.
 	 */
@@ -1006,6 +1089,8 @@ static int png_probe ( struct image *image ) {
 /** PNG image type */
 struct image_type png_image_type __image_type ( PROBE_NORMAL ) = {
 	.name = "PNG",
+	.signature = &png_signature,
+	.siglen = sizeof ( png_signature ),
 	.probe = png_probe,
 	.pixbuf = png_pixbuf,
 };
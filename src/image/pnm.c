@@ -414,6 +414,8 @@ static int pnm_probe ( struct image *image ) {
 /** PNM image type */
 struct image_type pnm_image_type __image_type ( PROBE_NORMAL ) = {
 	.name = "PNM",
+	.signature = "P",
+	.siglen = 1,
 	.probe = pnm_probe,
 	.pixbuf = pnm_pixbuf,
 };
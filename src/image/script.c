@@ -50,6 +50,27 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 static size_t script_offset;
 
+/** A script label
+ *
+ * Labels are collected in a single pass when script execution
+ * begins, so that "goto" is a table lookup rather than a rescan of
+ * the entire script.
+ */
+struct script_label {
+	/** List of labels within the current script */
+	struct list_head list;
+	/** Offset of labelled line within script */
+	size_t offset;
+	/** Label name */
+	char name[0];
+};
+
+/** Label jump table for current script (if any)
+ *
+ * This is a global for the same reason as the script offset.
+ */
+static struct list_head *script_labels;
+
 /**
  * Process script lines
  *
@@ -164,6 +185,47 @@ static int terminate_on_exit_or_failure ( int rc ) {
 		 ( rc != 0 ) );
 }
 
+/**
+ * Record script label
+ *
+ * @v image		Script
+ * @v offset		Offset within script
+ * @v label		Label, or NULL
+ * @v command		Command
+ * @ret rc		Return status code
+ */
+static int script_record_label ( struct image *image __unused, size_t offset,
+				 const char *label,
+				 const char *command __unused ) {
+	struct script_label *scriptlbl;
+
+	/* Do nothing unless line has a label */
+	if ( ! label )
+		return 0;
+
+	/* Allocate and record label */
+	scriptlbl = malloc ( sizeof ( *scriptlbl ) + strlen ( label ) +
+			     1 /* NUL */ );
+	if ( ! scriptlbl )
+		return -ENOMEM;
+	scriptlbl->offset = offset;
+	strcpy ( scriptlbl->name, label );
+	list_add_tail ( &scriptlbl->list, script_labels );
+
+	return 0;
+}
+
+/**
+ * Terminate script processing on failure
+ *
+ * @v rc		Line processing status
+ * @ret terminate	Terminate script processing
+ */
+static int terminate_on_failure ( int rc ) {
+
+	return ( rc != 0 );
+}
+
 /**
  * Execute script line
  *
@@ -195,6 +257,10 @@ static int script_exec_line ( struct image *image, size_t offset,
  */
 static int script_exec ( struct image *image ) {
 	size_t saved_offset;
+	struct list_head *saved_labels;
+	struct list_head labels;
+	struct script_label *scriptlbl;
+	struct script_label *tmp;
 	int rc;
 
 	/* Temporarily de-register image, so that a "boot" command
@@ -204,13 +270,32 @@ static int script_exec ( struct image *image ) {
 
 	/* Preserve state of any currently-running script */
 	saved_offset = script_offset;
+	saved_labels = script_labels;
+
+	/* Build label jump table in a single pass, so that "goto"
+	 * does not need to rescan the script.  Failure is harmless:
+	 * "goto" will simply fall back to scanning the script.
+	 */
+	INIT_LIST_HEAD ( &labels );
+	script_labels = &labels;
+	if ( process_script ( image, script_record_label,
+			      terminate_on_failure ) != 0 ) {
+		script_labels = NULL;
+	}
 
 	/* Process script */
 	rc = process_script ( image, script_exec_line,
 			      terminate_on_exit_or_failure );
 
+	/* Free label jump table */
+	list_for_each_entry_safe ( scriptlbl, tmp, &labels, list ) {
+		list_del ( &scriptlbl->list );
+		free ( scriptlbl );
+	}
+
 	/* Restore saved state */
 	script_offset = saved_offset;
+	script_labels = saved_labels;
 
 	/* Re-register image (unless we have been replaced) */
 	if ( ! image->replacement )
@@ -254,6 +339,8 @@ static int script_probe ( struct image *image ) {
 /** Script image type */
 struct image_type script_image_type __image_type ( PROBE_NORMAL ) = {
 	.name = "script",
+	.signature = "#!",
+	.siglen = 2,
 	.probe = script_probe,
 	.exec = script_exec,
 };
@@ -321,6 +408,7 @@ static int terminate_on_label_found ( int rc ) {
  */
 static int goto_exec ( int argc, char **argv ) {
 	struct goto_options opts;
+	struct script_label *scriptlbl;
 	size_t saved_offset;
 	int rc;
 
@@ -338,6 +426,23 @@ static int goto_exec ( int argc, char **argv ) {
 	/* Parse label */
 	goto_label = argv[optind];
 
+	/* Use label jump table, if available */
+	if ( script_labels ) {
+		list_for_each_entry ( scriptlbl, script_labels, list ) {
+			if ( strcmp ( scriptlbl->name, goto_label ) == 0 ) {
+				script_offset = scriptlbl->offset;
+				DBGC ( current_image, "[%04zx] Gone to :%s\n",
+				       script_offset, goto_label );
+				shell_stop ( SHELL_STOP_COMMAND );
+				return 0;
+			}
+		}
+		rc = -ENOENT;
+		DBGC ( current_image, "[%04zx] No such label :%s\n",
+		       script_offset, goto_label );
+		return rc;
+	}
+
 	/* Find label */
 	saved_offset = script_offset;
 	if ( ( rc = process_script ( current_image, goto_find_label,
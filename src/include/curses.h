@@ -45,6 +45,13 @@ typedef struct _curses_screen {
 	 * @v attrs	attributes
 	 */
 	void ( * erase ) ( struct _curses_screen *scr, attr_t attrs );
+	/**
+	 * Clear from current cursor position to end of line
+	 *
+	 * @v scr	screen on which to operate
+	 * @v attrs	attributes
+	 */
+	void ( * clrtoeol ) ( struct _curses_screen *scr, attr_t attrs );
 	/**
 	 * Move cursor to position specified by x,y coords
 	 *
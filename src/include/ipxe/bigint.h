@@ -29,6 +29,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 	( ( (len) + sizeof ( bigint_element_t ) - 1 ) /			\
 	  sizeof ( bigint_element_t ) )
 
+/** Window size (in bits) used for modular exponentiation */
+#define BIGINT_MOD_EXP_WINDOW 4
+
 /**
  * Determine number of elements in big-integer type
  *
@@ -250,10 +253,34 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 	unsigned int exponent_size = bigint_size (exponent);		\
 	size_t mod_multiply_len =					\
 		bigint_mod_multiply_tmp_len (modulus);			\
-	sizeof ( struct {						\
-		bigint_t ( size ) temp_base;				\
-		bigint_t ( exponent_size ) temp_exponent;		\
-		uint8_t mod_multiply[mod_multiply_len];			\
+	sizeof ( union {						\
+		struct {						\
+			bigint_t ( size )				\
+			      temp_table[ ( 1 << BIGINT_MOD_EXP_WINDOW ) - 1 ];\
+			bigint_t ( size ) temp_inverse;			\
+			bigint_t ( size ) temp_residue;			\
+			bigint_t ( exponent_size ) temp_exponent;	\
+			union {						\
+				struct {				\
+					bigint_t ( size + 1 ) temp_value; \
+					bigint_t ( size + 1 ) temp_modulus; \
+				} temp_residue;				\
+				struct {				\
+					bigint_t ( size ) temp_subtrahend; \
+					bigint_t ( size * 2 ) temp_product; \
+				} temp_invert;				\
+				struct {				\
+					bigint_t ( size * 2 ) temp_product; \
+					bigint_t ( size * 2 ) temp_multiple; \
+					bigint_t ( size ) temp_m;	\
+				} temp_multiply;			\
+			} temp_scratch;					\
+		} temp_mont;						\
+		struct {						\
+			bigint_t ( size ) temp_base;			\
+			bigint_t ( exponent_size ) temp_exponent;	\
+			uint8_t mod_multiply[mod_multiply_len];		\
+		} temp_ladder;						\
 	} ); } )
 
 #include <bits/bigint.h>
@@ -0,0 +1,47 @@
+#ifndef _IPXE_BOOTTRACE_H
+#define _IPXE_BOOTTRACE_H
+
+/** @file
+ *
+ * Boot-time trace markers
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** Number of boot trace entries */
+#define BOOTTRACE_COUNT 64
+
+/** Maximum length of a boot trace marker label (including NUL) */
+#define BOOTTRACE_LABEL_LEN 40
+
+/** A boot trace entry */
+struct boottrace_entry {
+	/** Timestamp (in ticks) */
+	unsigned long ticks;
+	/** Marker label */
+	char label[BOOTTRACE_LABEL_LEN];
+};
+
+extern unsigned int trace_level;
+
+extern void boottrace ( const char *fmt, ... )
+	__attribute__ (( format ( printf, 1, 2 ) ));
+extern void boottrace_show ( void );
+
+/**
+ * Record runtime-gated trace marker
+ *
+ * @v level		Minimum trace level at which to record
+ * @v ...		Format string and arguments
+ *
+ * Trace points are always compiled in (even in non-debug builds) but
+ * cost only a single well-predicted comparison unless the trace
+ * level has been raised via the "debuglevel" setting.
+ */
+#define tracepoint( level, ... ) do {				\
+		if ( trace_level >= (level) )			\
+			boottrace ( __VA_ARGS__ );		\
+	} while ( 0 )
+
+#endif /* _IPXE_BOOTTRACE_H */
@@ -64,16 +64,23 @@ struct cipher_algorithm {
 	 *
 	 * @v ctx		Context
 	 * @v iv		Initialisation vector
+	 * @v ivlen		Initialisation vector length
 	 */
-	void ( * setiv ) ( void *ctx, const void *iv );
+	void ( * setiv ) ( void *ctx, const void *iv, size_t ivlen );
 	/** Encrypt data
 	 *
 	 * @v ctx		Context
 	 * @v src		Data to encrypt
-	 * @v dst		Buffer for encrypted data
+	 * @v dst		Buffer for encrypted data, or NULL
 	 * @v len		Length of data
 	 *
 	 * @v len is guaranteed to be a multiple of @c blocksize.
+	 *
+	 * For authenticating ciphers, data to be authenticated but
+	 * not encrypted (i.e. additional authenticated data) may be
+	 * passed by specifying a NULL value for @c dst.  Any such
+	 * additional data must be passed before any data to be
+	 * encrypted.
 	 */
 	void ( * encrypt ) ( void *ctx, const void *src, void *dst,
 			     size_t len );
@@ -81,13 +88,27 @@ struct cipher_algorithm {
 	 *
 	 * @v ctx		Context
 	 * @v src		Data to decrypt
-	 * @v dst		Buffer for decrypted data
+	 * @v dst		Buffer for decrypted data, or NULL
 	 * @v len		Length of data
 	 *
 	 * @v len is guaranteed to be a multiple of @c blocksize.
+	 *
+	 * For authenticating ciphers, data to be authenticated but
+	 * not decrypted (i.e. additional authenticated data) may be
+	 * passed by specifying a NULL value for @c dst.  Any such
+	 * additional data must be passed before any data to be
+	 * decrypted.
 	 */
 	void ( * decrypt ) ( void *ctx, const void *src, void *dst,
 			     size_t len );
+	/** Authentication tag size (if applicable) */
+	size_t authsize;
+	/** Generate authentication tag (if applicable)
+	 *
+	 * @v ctx		Context
+	 * @v auth		Authentication tag
+	 */
+	void ( * auth ) ( void *ctx, void *auth );
 };
 
 /** A public key algorithm */
@@ -184,14 +205,52 @@ static inline void digest_final ( struct digest_algorithm *digest,
 	digest->final ( ctx, out );
 }
 
+/** An independent buffer within a multi-buffer digest operation */
+struct digest_multi_buffer {
+	/** Data to digest */
+	const void *data;
+	/** Length of data */
+	size_t len;
+	/** Buffer for digest output */
+	void *out;
+};
+
+/**
+ * Compute digests over multiple independent buffers
+ *
+ * @v digest		Digest algorithm
+ * @v buffers		Independent buffers
+ * @v count		Number of buffers
+ *
+ * Callers that have several independent blocks to digest (such as
+ * PeerDist segment identification) should present them all in a
+ * single call, rather than digesting each block individually.  This
+ * gives an implementation capable of interleaving independent
+ * streams (e.g. in SIMD lanes) a call site at which all streams are
+ * visible at once.  The portable implementation simply processes the
+ * buffers sequentially.
+ */
+static inline void digest_multi ( struct digest_algorithm *digest,
+				  struct digest_multi_buffer *buffers,
+				  unsigned int count ) {
+	uint8_t ctx[digest->ctxsize];
+	unsigned int i;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		digest_init ( digest, ctx );
+		digest_update ( digest, ctx, buffers[i].data, buffers[i].len );
+		digest_final ( digest, ctx, buffers[i].out );
+	}
+}
+
 static inline int cipher_setkey ( struct cipher_algorithm *cipher,
 				  void *ctx, const void *key, size_t keylen ) {
 	return cipher->setkey ( ctx, key, keylen );
 }
 
 static inline void cipher_setiv ( struct cipher_algorithm *cipher,
-				  void *ctx, const void *iv ) {
-	cipher->setiv ( ctx, iv );
+				  void *ctx, const void *iv, size_t ivlen ) {
+	cipher->setiv ( ctx, iv, ivlen );
 }
 
 static inline void cipher_encrypt ( struct cipher_algorithm *cipher,
@@ -214,10 +273,19 @@ static inline void cipher_decrypt ( struct cipher_algorithm *cipher,
 	cipher_decrypt ( (cipher), (ctx), (src), (dst), (len) );	\
 	} while ( 0 )
 
+static inline void cipher_auth ( struct cipher_algorithm *cipher, void *ctx,
+				 void *auth ) {
+	cipher->auth ( ctx, auth );
+}
+
 static inline int is_stream_cipher ( struct cipher_algorithm *cipher ) {
 	return ( cipher->blocksize == 1 );
 }
 
+static inline int is_auth_cipher ( struct cipher_algorithm *cipher ) {
+	return ( cipher->authsize != 0 );
+}
+
 static inline int pubkey_init ( struct pubkey_algorithm *pubkey, void *ctx,
 				const void *key, size_t key_len ) {
 	return pubkey->init ( ctx, key, key_len );
@@ -433,6 +433,16 @@ struct dhcp_netdev_desc {
 /** Use cached network settings (obsolete; do not reuse this value) */
 #define DHCP_EB_USE_CACHED DHCP_ENCAP_OPT ( DHCP_EB_ENCAP, 0xb2 )
 
+/** Cached lease hint
+ *
+ * This records the most recently obtained lease (address, server, and
+ * expiry time), allowing a subsequent DHCP session to attempt to
+ * reclaim the lease via an INIT-REBOOT request rather than starting
+ * with a full discovery.  When held in a non-volatile settings block,
+ * this allows a warm reboot to skip the discovery round trips.
+ */
+#define DHCP_EB_LAST_LEASE DHCP_ENCAP_OPT ( DHCP_EB_ENCAP, 0xb3 )
+
 /** SAN retry count
  *
  * This is the maximum number of times that SAN operations will be
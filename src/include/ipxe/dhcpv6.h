@@ -126,6 +126,9 @@ struct dhcpv6_status_code_option {
 /** DHCPv6 status code option */
 #define DHCPV6_STATUS_CODE 13
 
+/** DHCPv6 rapid commit option */
+#define DHCPV6_RAPID_COMMIT 14
+
 /** DHCPv6 user class */
 struct dhcpv6_user_class {
 	/** Length */
@@ -80,6 +80,9 @@ struct dns_header {
 /** Recursion desired flag */
 #define DNS_FLAG_RD 0x0100
 
+/** Truncation flag */
+#define DNS_FLAG_TC 0x0200
+
 /** A DNS question */
 struct dns_question {
 	/** Query type */
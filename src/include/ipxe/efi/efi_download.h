@@ -134,6 +134,55 @@ EFI_STATUS
   IN IPXE_DOWNLOAD_PROTOCOL *This
   );
 
+/** A destination extent for a scatter download
+ *
+ * Describes a region of the downloaded file and the buffer into which
+ * that region should be placed as it arrives.
+ */
+typedef struct {
+  /** Destination buffer for this extent */
+  VOID *Buffer;
+  /** Offset of this extent within the downloaded file */
+  UINTN FileOffset;
+  /** Length of this extent in bytes */
+  UINTN Length;
+} IPXE_DOWNLOAD_EXTENT;
+
+/**
+ * Start downloading a file directly into caller-provided buffers.
+ *
+ * Data is scattered into the registered destination extents as it
+ * arrives, without passing through an intermediate accumulation
+ * buffer; portions of the file lying outside all registered extents
+ * are discarded.  The caller must ensure that the extent buffers
+ * remain valid until the Finish callback has been invoked.
+ *
+ * Not all protocols will deliver data in order, and the amount of
+ * data actually delivered into the extents is not reported; clients
+ * requiring validation should cover the file with extents and check
+ * the final length via other means (e.g. a HEAD request).
+ *
+ * @v This		iPXE Download Protocol instance
+ * @v Url		URL to download from
+ * @v Extents		Array of destination extents
+ * @v ExtentCount	Number of destination extents
+ * @v FinishCallback	Callback that will be invoked when the download ends
+ * @v Context		Context passed to the Finish callback
+ * @v File		Token that can be used to abort the download
+ * @ret Status		EFI status code
+ */
+typedef
+EFI_STATUS
+(EFIAPI *IPXE_DOWNLOAD_START_EXTENTS)(
+  IN IPXE_DOWNLOAD_PROTOCOL *This,
+  IN CHAR8 *Url,
+  IN IPXE_DOWNLOAD_EXTENT *Extents,
+  IN UINTN ExtentCount,
+  IN IPXE_DOWNLOAD_FINISH_CALLBACK FinishCallback,
+  IN VOID *Context,
+  OUT IPXE_DOWNLOAD_FILE *File
+  );
+
 /**
  * The iPXE Download Protocol.
  *
@@ -144,6 +193,7 @@ struct _IPXE_DOWNLOAD_PROTOCOL {
    IPXE_DOWNLOAD_START Start;
    IPXE_DOWNLOAD_ABORT Abort;
    IPXE_DOWNLOAD_POLL Poll;
+   IPXE_DOWNLOAD_START_EXTENTS StartExtents;
 };
 
 #define IPXE_DOWNLOAD_PROTOCOL_GUID \
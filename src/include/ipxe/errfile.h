@@ -75,6 +75,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define ERRFILE_sanboot		       ( ERRFILE_CORE | 0x00230000 )
 #define ERRFILE_dummy_sanboot	       ( ERRFILE_CORE | 0x00240000 )
 #define ERRFILE_fdt		       ( ERRFILE_CORE | 0x00250000 )
+#define ERRFILE_netbench	       ( ERRFILE_CORE | 0x00260000 )
 
 #define ERRFILE_eisa		     ( ERRFILE_DRIVER | 0x00000000 )
 #define ERRFILE_isa		     ( ERRFILE_DRIVER | 0x00010000 )
@@ -198,6 +199,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define ERRFILE_axge		     ( ERRFILE_DRIVER | 0x00c10000 )
 #define ERRFILE_thunderx	     ( ERRFILE_DRIVER | 0x00c20000 )
 #define ERRFILE_af_packet	     ( ERRFILE_DRIVER | 0x00c30000 )
+#define ERRFILE_replay		     ( ERRFILE_DRIVER | 0x00c40000 )
 #define ERRFILE_sfc_hunt	     ( ERRFILE_DRIVER | 0x00c40000 )
 #define ERRFILE_efx_hunt	     ( ERRFILE_DRIVER | 0x00c50000 )
 #define ERRFILE_exanic		     ( ERRFILE_DRIVER | 0x00c60000 )
@@ -284,6 +286,15 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define ERRFILE_xsigo			( ERRFILE_NET | 0x00480000 )
 #define ERRFILE_ntp			( ERRFILE_NET | 0x00490000 )
 #define ERRFILE_httpntlm		( ERRFILE_NET | 0x004a0000 )
+#define ERRFILE_httpgzip		( ERRFILE_NET | 0x004b0000 )
+#define ERRFILE_httpzstd		( ERRFILE_NET | 0x004c0000 )
+#define ERRFILE_igmp			( ERRFILE_NET | 0x004d0000 )
+#define ERRFILE_mld			( ERRFILE_NET | 0x004e0000 )
+#define ERRFILE_nvmetcp			( ERRFILE_NET | 0x004f0000 )
+#define ERRFILE_imgshare		( ERRFILE_NET | 0x00500000 )
+#define ERRFILE_fakedhcp		( ERRFILE_NET | 0x00510000 )
+#define ERRFILE_pcap			( ERRFILE_NET | 0x00520000 )
+#define ERRFILE_impair			( ERRFILE_NET | 0x00530000 )
 
 #define ERRFILE_image		      ( ERRFILE_IMAGE | 0x00000000 )
 #define ERRFILE_elf		      ( ERRFILE_IMAGE | 0x00010000 )
@@ -379,6 +390,12 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define ERRFILE_acpi_settings	      ( ERRFILE_OTHER | 0x00500000 )
 #define ERRFILE_ntlm		      ( ERRFILE_OTHER | 0x00510000 )
 #define ERRFILE_efi_blacklist	      ( ERRFILE_OTHER | 0x00520000 )
+#define ERRFILE_zstd		      ( ERRFILE_OTHER | 0x00530000 )
+#define ERRFILE_bench		      ( ERRFILE_OTHER | 0x00540000 )
+#define ERRFILE_pingmgmt	      ( ERRFILE_OTHER | 0x00550000 )
+#define ERRFILE_certstore	      ( ERRFILE_OTHER | 0x00560000 )
+#define ERRFILE_efi_nvo		      ( ERRFILE_OTHER | 0x00570000 )
+#define ERRFILE_ntpmgmt		      ( ERRFILE_OTHER | 0x00580000 )
 
 /** @} */
 
@@ -108,6 +108,24 @@ struct fbcon_picture {
 	userptr_t start;
 };
 
+/** A frame buffer dirty region
+ *
+ * The dirty region is a rectangle within the shadow frame buffer
+ * which has not yet been copied to the real frame buffer.  Horizontal
+ * edges are in bytes within a scanline; vertical edges are in pixel
+ * rows.  Both ranges are half-open intervals.
+ */
+struct fbcon_dirty {
+	/** Left edge (in bytes within a scanline) */
+	size_t left;
+	/** Right edge (in bytes within a scanline) */
+	size_t right;
+	/** Top edge (in pixel rows) */
+	unsigned int top;
+	/** Bottom edge (in pixel rows) */
+	unsigned int bottom;
+};
+
 /** A frame buffer console */
 struct fbcon {
 	/** Start address */
@@ -142,6 +160,10 @@ struct fbcon {
 	struct fbcon_text text;
 	/** Background picture */
 	struct fbcon_picture picture;
+	/** Shadow frame buffer */
+	userptr_t shadow;
+	/** Dirty region */
+	struct fbcon_dirty dirty;
 	/** Display cursor */
 	int show_cursor;
 };
@@ -354,6 +354,8 @@ struct fc_peer {
 	struct fc_port *port;
 	/** Peer port ID, if known */
 	struct fc_port_id port_id;
+	/** Maximum receive data field size, as negotiated at login */
+	size_t mtu;
 
 	/** List of upper-layer protocols */
 	struct list_head ulps;
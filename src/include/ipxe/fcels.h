@@ -167,6 +167,9 @@ struct fc_login_common {
 /** Fibre Channel default MTU */
 #define FC_LOGIN_DEFAULT_MTU 1452
 
+/** Fibre Channel minimum valid MTU */
+#define FC_LOGIN_MIN_MTU 256
+
 /** Default maximum number of concurrent sequences */
 #define FC_LOGIN_DEFAULT_MAX_SEQ 255
 
@@ -17,6 +17,15 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** Fragment reassembly timeout */
 #define FRAGMENT_TIMEOUT ( TICKS_PER_SEC / 2 )
 
+/** Maximum number of concurrent fragment reassembly buffers
+ *
+ * Each reassembly buffer can grow to the size of a full reassembled
+ * packet, so this budget bounds the memory consumable by a burst of
+ * unrelated (or hostile) fragment streams.  When the budget is
+ * exhausted, the least recently used buffer is evicted.
+ */
+#define FRAGMENT_MAX 8
+
 /** A fragment reassembly buffer */
 struct fragment {
 	/* List of fragment reassembly buffers */
@@ -33,8 +42,15 @@ struct fragment {
 
 /** A fragment reassembler */
 struct fragment_reassembler {
-	/** List of fragment reassembly buffers */
+	/** List of fragment reassembly buffers
+	 *
+	 * Maintained in most-recently-used order, so that the active
+	 * fragment stream is found at the head of the list and the
+	 * eviction candidate at the tail.
+	 */
 	struct list_head list;
+	/** Number of fragment reassembly buffers */
+	unsigned int count;
 	/**
 	 * Check if fragment matches fragment reassembly buffer
 	 *
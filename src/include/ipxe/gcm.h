@@ -0,0 +1,121 @@
+#ifndef _IPXE_GCM_H
+#define _IPXE_GCM_H
+
+/** @file
+ *
+ * Galois/Counter Mode (GCM)
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/crypto.h>
+
+/** A GCM block */
+union gcm_block {
+	/** Viewed as an array of bytes */
+	uint8_t byte[16];
+	/** Viewed as an array of 32-bit words */
+	uint32_t word[4];
+	/** Viewed as an array of 64-bit words */
+	uint64_t qword[2];
+} __attribute__ (( packed ));
+
+/** GCM block lengths */
+struct gcm_lengths {
+	/** Additional data length (in bytes) */
+	uint64_t add;
+	/** Data length (in bytes) */
+	uint64_t data;
+};
+
+/** A GCM context */
+struct gcm_context {
+	/** Hash key (H) */
+	union gcm_block key;
+	/** Accumulated hash (X) */
+	union gcm_block hash;
+	/** Counter (Y) */
+	union gcm_block ctr;
+	/** Authentication tag mask (E(K,Y[0])) */
+	union gcm_block mask;
+	/** Current keystream block (E(K,Y[i])) */
+	union gcm_block pad;
+	/** Accumulated lengths */
+	struct gcm_lengths len;
+};
+
+extern int gcm_setkey ( void *ctx, const void *key, size_t keylen,
+			struct cipher_algorithm *raw_cipher,
+			struct gcm_context *gcm_ctx );
+extern void gcm_setiv ( void *ctx, const void *iv, size_t ivlen,
+			struct cipher_algorithm *raw_cipher,
+			struct gcm_context *gcm_ctx );
+extern void gcm_encrypt ( void *ctx, const void *src, void *dst, size_t len,
+			  struct cipher_algorithm *raw_cipher,
+			  struct gcm_context *gcm_ctx );
+extern void gcm_decrypt ( void *ctx, const void *src, void *dst, size_t len,
+			  struct cipher_algorithm *raw_cipher,
+			  struct gcm_context *gcm_ctx );
+extern void gcm_auth ( void *ctx __unused, void *auth,
+		       struct cipher_algorithm *raw_cipher __unused,
+		       struct gcm_context *gcm_ctx );
+
+/**
+ * Create a Galois/Counter mode of behaviour of an existing cipher
+ *
+ * @v _gcm_name		Name for the new GCM cipher
+ * @v _gcm_cipher	New cipher algorithm
+ * @v _raw_cipher	Underlying cipher algorithm
+ * @v _raw_context	Context structure for the underlying cipher
+ * @v _blocksize	Cipher block size
+ */
+#define GCM_CIPHER( _gcm_name, _gcm_cipher, _raw_cipher, _raw_context,	\
+		    _blocksize )					\
+struct _gcm_name ## _context {						\
+	_raw_context raw_ctx;						\
+	struct gcm_context gcm_ctx;					\
+};									\
+static int _gcm_name ## _setkey ( void *ctx, const void *key,		\
+				  size_t keylen ) {			\
+	struct _gcm_name ## _context * _gcm_name ## _ctx = ctx;		\
+	return gcm_setkey ( &_gcm_name ## _ctx->raw_ctx, key, keylen,	\
+			    &_raw_cipher, &_gcm_name ## _ctx->gcm_ctx );\
+}									\
+static void _gcm_name ## _setiv ( void *ctx, const void *iv,		\
+				  size_t ivlen ) {			\
+	struct _gcm_name ## _context * _gcm_name ## _ctx = ctx;		\
+	gcm_setiv ( &_gcm_name ## _ctx->raw_ctx, iv, ivlen,		\
+		    &_raw_cipher, &_gcm_name ## _ctx->gcm_ctx );	\
+}									\
+static void _gcm_name ## _encrypt ( void *ctx, const void *src,		\
+				    void *dst, size_t len ) {		\
+	struct _gcm_name ## _context * _gcm_name ## _ctx = ctx;		\
+	gcm_encrypt ( &_gcm_name ## _ctx->raw_ctx, src, dst, len,	\
+		      &_raw_cipher, &_gcm_name ## _ctx->gcm_ctx );	\
+}									\
+static void _gcm_name ## _decrypt ( void *ctx, const void *src,		\
+				    void *dst, size_t len ) {		\
+	struct _gcm_name ## _context * _gcm_name ## _ctx = ctx;		\
+	gcm_decrypt ( &_gcm_name ## _ctx->raw_ctx, src, dst, len,	\
+		      &_raw_cipher, &_gcm_name ## _ctx->gcm_ctx );	\
+}									\
+static void _gcm_name ## _auth ( void *ctx, void *auth ) {		\
+	struct _gcm_name ## _context * _gcm_name ## _ctx = ctx;		\
+	gcm_auth ( &_gcm_name ## _ctx->raw_ctx, auth,			\
+		   &_raw_cipher, &_gcm_name ## _ctx->gcm_ctx );		\
+}									\
+struct cipher_algorithm _gcm_cipher = {					\
+	.name		= #_gcm_name,					\
+	.ctxsize	= sizeof ( struct _gcm_name ## _context ),	\
+	.blocksize	= 1,						\
+	.setkey		= _gcm_name ## _setkey,				\
+	.setiv		= _gcm_name ## _setiv,				\
+	.encrypt	= _gcm_name ## _encrypt,			\
+	.decrypt	= _gcm_name ## _decrypt,			\
+	.authsize	= _blocksize,					\
+	.auth		= _gcm_name ## _auth,				\
+};
+
+#endif /* _IPXE_GCM_H */
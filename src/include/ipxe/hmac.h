@@ -8,8 +8,21 @@
 
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
+#include <string.h>
 #include <ipxe/crypto.h>
 
+/**
+ * Resume HMAC from precomputed input pad digest context
+ *
+ * @v digest		Digest algorithm to use
+ * @v digest_ctx	Digest context
+ * @v ipad_ctx		Precomputed input pad digest context
+ */
+static inline void hmac_resume ( struct digest_algorithm *digest,
+				 void *digest_ctx, const void *ipad_ctx ) {
+	memcpy ( digest_ctx, ipad_ctx, digest->ctxsize );
+}
+
 /**
  * Update HMAC
  *
@@ -26,7 +39,12 @@ static inline void hmac_update ( struct digest_algorithm *digest,
 
 extern void hmac_init ( struct digest_algorithm *digest, void *digest_ctx,
 			void *key, size_t *key_len );
+extern void hmac_precompute ( struct digest_algorithm *digest, const void *key,
+			      size_t key_len, void *ipad_ctx, void *opad_ctx );
 extern void hmac_final ( struct digest_algorithm *digest, void *digest_ctx,
 			 void *key, size_t *key_len, void *hmac );
+extern void hmac_final_precomputed ( struct digest_algorithm *digest,
+				     void *digest_ctx, const void *opad_ctx,
+				     void *hmac );
 
 #endif /* _IPXE_HMAC_H */
@@ -88,6 +88,8 @@ struct http_connection {
 	struct interface xfer;
 	/** Pooled connection */
 	struct pooled_connection pool;
+	/** List of all connections */
+	struct list_head list;
 };
 
 /******************************************************************************
@@ -149,6 +151,15 @@ struct http_request_content {
 	const void *data;
 	/** Content length */
 	size_t len;
+	/** Content body stream (if any)
+	 *
+	 * If non-NULL, then the content body is streamed: it is
+	 * delivered via this data transfer interface (using chunked
+	 * transfer encoding) rather than copied from @c data, and @c
+	 * len must be zero.  Closing the stream interface marks the
+	 * end of the body.
+	 */
+	struct interface *body;
 };
 
 /** HTTP request Basic authentication descriptor */
@@ -189,6 +200,8 @@ struct http_request_auth_ntlm {
 struct http_request_auth {
 	/** Authentication scheme (if any) */
 	struct http_authentication *auth;
+	/** Challenge preloaded from a cached session (if any) */
+	char *challenge;
 	/** Per-scheme information */
 	union {
 		/** Basic authentication descriptor */
@@ -340,6 +353,10 @@ struct http_response {
 	int rc;
 	/** Redirection location */
 	const char *location;
+	/** Entity tag validator, if any */
+	const char *etag;
+	/** Last modification time validator, if any */
+	const char *last_modified;
 	/** Transfer descriptor */
 	struct http_response_transfer transfer;
 	/** Content descriptor */
@@ -425,6 +442,8 @@ struct http_transaction {
 	struct interface transfer;
 	/** Server connection */
 	struct interface conn;
+	/** Request body stream */
+	struct interface stream;
 	/** Transmit process */
 	struct process process;
 	/** Reconnection timer */
@@ -445,6 +464,13 @@ struct http_transaction {
 	size_t len;
 	/** Chunk length remaining */
 	size_t remaining;
+
+	/** Resumption validator (copied from a previous response) */
+	char *validator;
+	/** Number of resume attempts */
+	unsigned int resumed;
+	/** Awaiting response to a resumed range request */
+	int resuming;
 };
 
 /******************************************************************************
@@ -518,6 +544,14 @@ struct http_content_encoding {
 struct http_authentication {
 	/** Name (e.g. "Digest") */
 	const char *name;
+	/** Authentication is bound to a single connection
+	 *
+	 * Some schemes (e.g. NTLM) break the stateless nature of HTTP
+	 * and tie the authentication exchange to an individual
+	 * connection, preventing challenges from being reused across
+	 * connections.
+	 */
+	int conn;
 	/** Parse remaining "WWW-Authenticate" header line
 	 *
 	 * @v http		HTTP transaction
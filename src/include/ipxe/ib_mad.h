@@ -162,6 +162,9 @@ struct ib_port_info {
 #define IB_MTU_2048			0x04
 #define IB_MTU_4096			0x05
 
+/** Convert an encoded MTU to a size in bytes */
+#define IB_MTU_SIZE( mtu )		( 128 << (mtu) )
+
 #define IB_VL_0				0x01
 #define IB_VL_0_1			0x02
 #define IB_VL_0_3			0x03
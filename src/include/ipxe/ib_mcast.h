@@ -21,6 +21,11 @@ struct ib_mc_membership {
 	struct ib_address_vector *av;
 	/** Attached to multicast GID */
 	int attached;
+	/** Multicast group MTU (in bytes)
+	 *
+	 * Filled in upon join completion, or zero if not yet known.
+	 */
+	size_t mtu;
 	/** Multicast group join transaction */
 	struct ib_mad_transaction *madx;
 	/** Handle join success/failure
@@ -0,0 +1,57 @@
+#ifndef _IPXE_IGMP_H
+#define _IPXE_IGMP_H
+
+/** @file
+ *
+ * Internet Group Management Protocol
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/in.h>
+#include <ipxe/netdevice.h>
+
+/** An IGMP message
+ *
+ * IGMPv3 queries carry additional fields after the group address;
+ * these are not needed in order to generate a valid response and are
+ * ignored.
+ */
+struct igmp_header {
+	/** Type */
+	uint8_t type;
+	/** Maximum response time (in 1/10 second units)
+	 *
+	 * This is zero in IGMPv1 queries.
+	 */
+	uint8_t max_resp;
+	/** Checksum */
+	uint16_t chksum;
+	/** Group address */
+	struct in_addr group;
+} __attribute__ (( packed ));
+
+/** IGMP membership query */
+#define IGMP_MEMBERSHIP_QUERY 0x11
+
+/** IGMPv1 membership report */
+#define IGMP_V1_MEMBERSHIP_REPORT 0x12
+
+/** IGMPv2 membership report */
+#define IGMP_V2_MEMBERSHIP_REPORT 0x16
+
+/** IGMPv2 leave group */
+#define IGMP_V2_LEAVE_GROUP 0x17
+
+/** All-systems group address (224.0.0.1) */
+#define INADDR_ALL_SYSTEMS htonl ( 0xe0000001 )
+
+/** All-routers group address (224.0.0.2) */
+#define INADDR_ALL_ROUTERS htonl ( 0xe0000002 )
+
+extern int igmp_join ( struct net_device *netdev, struct in_addr group );
+extern void igmp_leave ( struct net_device *netdev, struct in_addr group );
+
+#endif /* _IPXE_IGMP_H */
@@ -19,6 +19,24 @@ struct uri;
 struct pixel_buffer;
 struct asn1_cursor;
 struct image_type;
+struct digest_algorithm;
+
+/** Maximum digest size within an image digest cache entry */
+#define IMAGE_DIGEST_MAX_SIZE 64
+
+/** A cached image data digest */
+struct image_digest {
+	/** Digest algorithm (or NULL if entry is empty) */
+	struct digest_algorithm *digest;
+	/** Digest value */
+	uint8_t value[IMAGE_DIGEST_MAX_SIZE];
+};
+
+/** Number of cached digests per image
+ *
+ * This is a policy decision.
+ */
+#define IMAGE_DIGESTS 4
 
 /** An executable image */
 struct image {
@@ -42,6 +60,15 @@ struct image {
 	/** Length of raw file image */
 	size_t len;
 
+	/** Cached data digests
+	 *
+	 * These are digests of the raw file image, calculated
+	 * opportunistically (e.g. while the image is being
+	 * downloaded) so that subsequent verification does not
+	 * require an additional pass over the data.
+	 */
+	struct image_digest digests[IMAGE_DIGESTS];
+
 	/** Image type, if known */
 	struct image_type *type;
 
@@ -76,6 +103,18 @@ struct image {
 struct image_type {
 	/** Name of this image type */
 	char *name;
+	/** Magic signature offset (if applicable) */
+	size_t sigoffset;
+	/** Magic signature (if applicable) */
+	const void *signature;
+	/** Magic signature length
+	 *
+	 * If non-zero, then the probe method will be invoked only if
+	 * the magic signature matches the image content.  Types that
+	 * cannot be identified by a fixed-offset signature should
+	 * leave this as zero.
+	 */
+	size_t siglen;
 	/**
 	 * Probe image
 	 *
@@ -115,6 +154,9 @@ struct image_type {
 			 struct asn1_cursor **cursor );
 };
 
+/** Maximum length of an image type magic signature */
+#define IMAGE_SIGLEN_MAX 8
+
 /**
  * Multiboot image probe priority
  *
@@ -178,11 +220,21 @@ extern int image_set_cmdline ( struct image *image, const char *cmdline );
 extern int register_image ( struct image *image );
 extern void unregister_image ( struct image *image );
 struct image * find_image ( const char *name );
+extern struct image * find_image_digest ( struct digest_algorithm *digest,
+					  const void *value );
+extern struct image * find_image_duplicate ( struct image *image );
+extern int imgverify_wait ( struct image *image );
 extern int image_exec ( struct image *image );
 extern int image_replace ( struct image *replacement );
 extern int image_select ( struct image *image );
 extern struct image * image_find_selected ( void );
 extern int image_set_trust ( int require_trusted, int permanent );
+extern int image_trust_required ( void );
+extern int image_set_digest ( struct image *image,
+			      struct digest_algorithm *digest,
+			      const void *value );
+extern int image_digest ( struct image *image,
+			  struct digest_algorithm *digest, void *out );
 extern int image_pixbuf ( struct image *image, struct pixel_buffer **pixbuf );
 extern int image_asn1 ( struct image *image, size_t offset,
 			struct asn1_cursor **cursor );
@@ -0,0 +1,14 @@
+#ifndef _IPXE_IMGSHARE_H
+#define _IPXE_IMGSHARE_H
+
+/** @file
+ *
+ * Peer-to-peer image sharing
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+extern int imgshare_serve ( void );
+
+#endif /* _IPXE_IMGSHARE_H */
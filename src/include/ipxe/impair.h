@@ -0,0 +1,19 @@
+#ifndef _IPXE_IMPAIR_H
+#define _IPXE_IMPAIR_H
+
+/** @file
+ *
+ * Network impairment
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+struct net_device;
+struct io_buffer;
+
+extern int impair_set ( struct net_device *netdev, unsigned long kbps,
+			unsigned long delay_ms, unsigned int loss );
+extern int impair_tx ( struct net_device *netdev, struct io_buffer *iobuf );
+
+#endif /* _IPXE_IMPAIR_H */
@@ -10,6 +10,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /* Protocol numbers */
 
 #define IP_ICMP		1
+#define IP_IGMP		2
 #define IP_TCP		6
 #define IP_UDP		17
 #define IP_ICMP6	58
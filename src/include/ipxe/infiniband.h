@@ -47,7 +47,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  * This is currently hard-coded in various places (drivers, subnet
  * management agent, etc.) to 2048.
  */
+#ifndef IB_MAX_PAYLOAD_SIZE
 #define IB_MAX_PAYLOAD_SIZE 2048
+#endif
 
 struct ib_device;
 struct ib_queue_pair;
@@ -129,8 +129,28 @@ struct interface {
 	 * Used by intf_reinit().
 	 */
 	struct interface_descriptor *original;
+
+	/** Cached operation lookup type
+	 *
+	 * Operation lookups walk the destination's operation table
+	 * (and potentially a chain of pass-through interfaces) and
+	 * are performed several times per delivered packet.  The
+	 * result is fully determined by the interface topology, so
+	 * the most recent lookup is cached and remains valid until
+	 * the next topology change (as indicated by
+	 * @c intf_generation).
+	 */
+	void *cache_type;
+	/** Cached operation method (may be NULL) */
+	void *cache_func;
+	/** Cached destination interface */
+	struct interface *cache_dest;
+	/** Interface topology generation at time of caching */
+	unsigned int cache_generation;
 };
 
+extern unsigned int intf_generation;
+
 extern void intf_plug ( struct interface *intf, struct interface *dest );
 extern void intf_plug_plug ( struct interface *a, struct interface *b );
 extern void intf_unplug ( struct interface *intf );
@@ -177,6 +197,7 @@ static inline void intf_init ( struct interface *intf,
 	intf->refcnt = refcnt;
 	intf->desc = desc;
 	intf->original = desc;
+	intf->cache_generation = 0;
 }
 
 /**
@@ -189,6 +210,7 @@ static inline void intf_init ( struct interface *intf,
 		.refcnt = NULL,			\
 		.desc = &(descriptor),		\
 		.original = &(descriptor),	\
+		.cache_generation = 0,		\
 	}
 
 /**
@@ -257,6 +279,9 @@ static inline void intf_reinit ( struct interface *intf ) {
 
 	/* Restore original interface descriptor */
 	intf->desc = intf->original;
+
+	/* Invalidate all cached operation lookups */
+	intf_generation++;
 }
 
 #endif /* _IPXE_INTERFACE_H */
@@ -13,6 +13,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <assert.h>
 #include <ipxe/list.h>
 
+struct refcnt;
+
 /**
  * Minimum I/O buffer length
  *
@@ -46,6 +48,90 @@ struct io_buffer {
 	void *tail;
 	/** End of the buffer */
         void *end;
+
+	/** Recycling pool of which this buffer is a member, if any */
+	struct iob_pool *pool;
+
+	/** Flags
+	 *
+	 * This is the bitwise OR of zero or more IOB_FL_XXX
+	 * constants.  Flags are cleared when a buffer is allocated or
+	 * recycled.
+	 */
+	unsigned int flags;
+
+	/** Ingress timestamp
+	 *
+	 * Maintained only in profiling builds.  Recorded when the
+	 * buffer is added to a network device's receive queue, so
+	 * that the latency accumulated by each stage of receive
+	 * processing (rather than just each stage's own processing
+	 * time) can be measured.
+	 */
+	unsigned long rx_stamp;
+
+	/** Next fragment in a fragment chain, if any
+	 *
+	 * Most I/O buffers are single contiguous allocations; support
+	 * for fragment chains is opt-in.  A chain must be handed only
+	 * to consumers that are known to understand chains (such as a
+	 * network device whose driver supports scatter-gather
+	 * transmission); all other code sees only the first fragment.
+	 */
+	struct io_buffer *frag;
+};
+
+/** Transport-layer checksum has already been verified
+ *
+ * Set by a network driver when its hardware has validated the TCP or
+ * UDP checksum (including the pseudo-header) of a received packet,
+ * allowing software checksum verification to be skipped.
+ */
+#define IOB_FL_CSUM_OK 0x0001
+
+/** Maximum number of fragments in an I/O buffer chain
+ *
+ * This is a policy decision, allowing drivers to size scatter-gather
+ * descriptor lists at compile time.
+ */
+#define IOB_MAX_FRAGS 8
+
+/**
+ * Iterate over each fragment of an I/O buffer chain
+ *
+ * @v frag	Fragment
+ * @v iobuf	I/O buffer (i.e. head of fragment chain)
+ */
+#define iob_for_each_frag( frag, iobuf ) \
+	for ( (frag) = (iobuf) ; (frag) ; (frag) = (frag)->frag )
+
+/** An I/O buffer recycling pool
+ *
+ * A pool allows I/O buffers of a single size to be recycled when
+ * freed, rather than being returned to the heap.  This converts the
+ * per-packet receive buffer allocation performed by network drivers
+ * into a pair of list operations.
+ */
+struct iob_pool {
+	/** Reference counter of containing object, if any
+	 *
+	 * A reference is held for each buffer belonging to the pool
+	 * (whether recycled or in flight), guaranteeing that the pool
+	 * itself remains valid for the lifetime of its buffers.
+	 */
+	struct refcnt *refcnt;
+	/** List of recycled buffers */
+	struct list_head free;
+	/** Payload length of pooled buffers */
+	size_t len;
+	/** Current number of recycled buffers */
+	unsigned int count;
+	/** Maximum number of recycled buffers
+	 *
+	 * Zero for a pool that is closed (or was never opened),
+	 * preventing any recycling.
+	 */
+	unsigned int max;
 };
 
 /**
@@ -188,6 +274,51 @@ static inline void iob_populate ( struct io_buffer *iobuf,
 	iobuf->head = iobuf->data = data;
 	iobuf->tail = ( data + len );
 	iobuf->end = ( data + max_len );
+	iobuf->pool = NULL;
+	iobuf->frag = NULL;
+}
+
+/**
+ * Append a fragment to an I/O buffer chain
+ *
+ * @v iobuf	I/O buffer (i.e. head of fragment chain)
+ * @v frag	Fragment (or chain of fragments) to append
+ */
+static inline void iob_chain ( struct io_buffer *iobuf,
+			       struct io_buffer *frag ) {
+	while ( iobuf->frag )
+		iobuf = iobuf->frag;
+	iobuf->frag = frag;
+}
+
+/**
+ * Count fragments in an I/O buffer chain
+ *
+ * @v iobuf	I/O buffer (i.e. head of fragment chain)
+ * @ret nfrags	Number of fragments
+ */
+static inline unsigned int iob_nfrags ( struct io_buffer *iobuf ) {
+	struct io_buffer *frag;
+	unsigned int nfrags = 0;
+
+	iob_for_each_frag ( frag, iobuf )
+		nfrags++;
+	return nfrags;
+}
+
+/**
+ * Calculate total length of data in an I/O buffer chain
+ *
+ * @v iobuf	I/O buffer (i.e. head of fragment chain)
+ * @ret len	Total length of data in all fragments
+ */
+static inline size_t iob_chain_len ( struct io_buffer *iobuf ) {
+	struct io_buffer *frag;
+	size_t len = 0;
+
+	iob_for_each_frag ( frag, iobuf )
+		len += iob_len ( frag );
+	return len;
 }
 
 /**
@@ -214,6 +345,10 @@ extern struct io_buffer * __malloc alloc_iob_raw ( size_t len, size_t align,
 						   size_t offset );
 extern struct io_buffer * __malloc alloc_iob ( size_t len );
 extern void free_iob ( struct io_buffer *iobuf );
+extern void iob_pool_open ( struct iob_pool *pool, struct refcnt *refcnt,
+			    size_t len, unsigned int max );
+extern struct io_buffer * alloc_iob_pool ( struct iob_pool *pool, size_t len );
+extern void iob_pool_close ( struct iob_pool *pool );
 extern void iob_pad ( struct io_buffer *iobuf, size_t min_len );
 extern int iob_ensure_headroom ( struct io_buffer *iobuf, size_t len );
 extern struct io_buffer * iob_concatenate ( struct list_head *list );
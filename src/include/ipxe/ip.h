@@ -31,6 +31,14 @@ struct io_buffer;
 #define IP_TOS		0
 #define IP_TTL		64
 
+/** Minimum believable path MTU
+ *
+ * Reported path MTUs below this value are assumed to be bogus (or
+ * sent by ancient routers that do not report a next-hop MTU at all)
+ * and are ignored.  This is a policy decision.
+ */
+#define IP_MIN_PMTU	576
+
 /** An IPv4 packet header */
 struct iphdr {
 	uint8_t  verhdrlen;
@@ -68,6 +76,12 @@ struct ipv4_miniroute {
 	struct in_addr netmask;
 	/** Gateway address */
 	struct in_addr gateway;
+	/** Discovered path MTU, or zero if not discovered
+	 *
+	 * Learned from ICMP fragmentation-needed messages for
+	 * destinations reached via this route.
+	 */
+	size_t pmtu;
 };
 
 extern struct list_head ipv4_miniroutes;
@@ -75,6 +89,7 @@ extern struct list_head ipv4_miniroutes;
 extern struct net_protocol ipv4_protocol __net_protocol;
 
 extern int ipv4_has_any_addr ( struct net_device *netdev );
+extern void ipv4_pmtu_update ( struct in_addr dest, size_t pmtu );
 extern int parse_ipv4_setting ( const struct setting_type *type,
 				const char *value, void *buf, size_t len );
 extern int format_ipv4_setting ( const struct setting_type *type,
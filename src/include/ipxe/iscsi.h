@@ -14,6 +14,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/scsi.h>
 #include <ipxe/chap.h>
 #include <ipxe/refcnt.h>
+#include <ipxe/list.h>
 #include <ipxe/xfer.h>
 #include <ipxe/process.h>
 #include <ipxe/acpi.h>
@@ -121,8 +122,10 @@ struct iscsi_bhs_common_response {
 	uint32_t statsn;
 	/** Expected command sequence number */
 	uint32_t expcmdsn;
+	/** Maximum command sequence number */
+	uint32_t maxcmdsn;
 	/** Fields specific to the PDU type */
-	uint8_t other_d[16];
+	uint8_t other_d[12];
 };
 
 /**
@@ -531,6 +534,24 @@ enum iscsi_rx_state {
 	ISCSI_RX_DATA_PADDING,
 };
 
+/** An iSCSI command */
+struct iscsi_command {
+	/** Reference counter */
+	struct refcnt refcnt;
+	/** iSCSI session */
+	struct iscsi_session *iscsi;
+	/** List of outstanding commands */
+	struct list_head list;
+	/** SCSI command interface */
+	struct interface data;
+	/** SCSI command */
+	struct scsi_cmd command;
+	/** Initiator task tag */
+	uint32_t itt;
+	/** Command PDU has been transmitted */
+	int issued;
+};
+
 /** An iSCSI session */
 struct iscsi_session {
 	/** Reference counter */
@@ -538,8 +559,6 @@ struct iscsi_session {
 
 	/** SCSI command-issuing interface */
 	struct interface control;
-	/** SCSI command interface */
-	struct interface data;
 	/** Transport-layer socket */
 	struct interface socket;
 
@@ -585,8 +604,8 @@ struct iscsi_session {
 	uint16_t isid_iana_qual;
 	/** Initiator task tag
 	 *
-	 * This is the tag of the current command.  It is incremented
-	 * whenever a new command is started.
+	 * This is the tag of the current login request.  Tags for
+	 * SCSI commands are assigned per command.
 	 */
 	uint32_t itt;
 	/** Target transfer tag
@@ -611,10 +630,18 @@ struct iscsi_session {
 	 *
 	 * This is the sequence number of the current command, used to
 	 * fill out the CmdSN field in iSCSI request PDUs.  It is
-	 * updated with the value of the ExpCmdSN field whenever we
-	 * receive an iSCSI response PDU containing such a field.
+	 * advanced whenever a command PDU is transmitted, and updated
+	 * with the value of the ExpCmdSN field whenever we receive an
+	 * iSCSI response PDU advertising a later value.
 	 */
 	uint32_t cmdsn;
+	/** Maximum command sequence number
+	 *
+	 * This is the most recent MaxCmdSN value advertised by the
+	 * target.  We may not transmit a command PDU with a CmdSN
+	 * exceeding this value.
+	 */
+	uint32_t maxcmdsn;
 	/** Status sequence number
 	 *
 	 * This is the most recent status sequence number present in
@@ -642,8 +669,10 @@ struct iscsi_session {
 	/** Buffer for received data (not always used) */
 	void *rx_buffer;
 
-	/** Current SCSI command, if any */
-	struct scsi_cmd *command;
+	/** List of outstanding SCSI commands */
+	struct list_head commands;
+	/** Command for which a data-out transfer is in progress, if any */
+	struct iscsi_command *transfer;
 
 	/** Target socket address (for boot firmware table) */
 	struct sockaddr target_sockaddr;
@@ -32,6 +32,16 @@ struct job_progress {
 	char message[32];
 };
 
+/** Job activity counter
+ *
+ * This is incremented whenever an event occurs (such as a data
+ * delivery) that may change the answer to a job_progress() query.  It
+ * allows progress consumers to avoid repeatedly traversing an
+ * interface chain (or, for parallel downloads, many chains) merely to
+ * reobtain an unchanged answer.
+ */
+extern unsigned int job_activity;
+
 extern int job_progress ( struct interface *intf,
 			  struct job_progress *progress );
 #define job_progress_TYPE( object_type ) \
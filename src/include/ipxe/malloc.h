@@ -25,10 +25,25 @@ extern size_t freemem;
 extern size_t usedmem;
 extern size_t maxusedmem;
 
+/** Heap statistics */
+struct memory_stats {
+	/** Total free memory */
+	size_t free;
+	/** Total used memory */
+	size_t used;
+	/** Maximum used memory */
+	size_t maxused;
+	/** Largest free block */
+	size_t largest;
+	/** Number of free blocks */
+	unsigned int fragments;
+};
+
 extern void * __malloc alloc_memblock ( size_t size, size_t align,
 					size_t offset );
 extern void free_memblock ( void *ptr, size_t size );
 extern void mpopulate ( void *start, size_t len );
+extern void mstat ( struct memory_stats *stats );
 extern void mdumpfree ( void );
 
 /**
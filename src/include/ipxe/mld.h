@@ -0,0 +1,46 @@
+#ifndef _IPXE_MLD_H
+#define _IPXE_MLD_H
+
+/** @file
+ *
+ * Multicast Listener Discovery
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/in.h>
+#include <ipxe/icmp.h>
+#include <ipxe/netdevice.h>
+
+/** An MLD message
+ *
+ * MLDv2 queries carry additional fields after the group address;
+ * these are not needed in order to generate a valid response and are
+ * ignored.
+ */
+struct mld_header {
+	/** ICMPv6 header */
+	struct icmp_header icmp;
+	/** Maximum response delay (in milliseconds) */
+	uint16_t max_resp;
+	/** Reserved */
+	uint16_t reserved;
+	/** Group address */
+	struct in6_addr group;
+} __attribute__ (( packed ));
+
+/** MLD listener query */
+#define MLD_LISTENER_QUERY 130
+
+/** MLD listener report */
+#define MLD_LISTENER_REPORT 131
+
+/** MLD listener done */
+#define MLD_LISTENER_DONE 132
+
+extern int mld_join ( struct net_device *netdev, struct in6_addr *group );
+extern void mld_leave ( struct net_device *netdev, struct in6_addr *group );
+
+#endif /* _IPXE_MLD_H */
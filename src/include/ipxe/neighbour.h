@@ -58,6 +58,13 @@ struct neighbour {
 
 	/** Pending I/O buffers */
 	struct list_head tx_queue;
+
+	/** Discovery failure status code (if any)
+	 *
+	 * A failed entry is retained for a holddown period as a
+	 * negative cache entry, with the holddown timer running.
+	 */
+	int rc;
 };
 
 /**
@@ -0,0 +1,22 @@
+#ifndef _IPXE_NETBENCH_H
+#define _IPXE_NETBENCH_H
+
+/** @file
+ *
+ * Network throughput benchmark
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/interface.h>
+
+extern int create_netbench ( struct interface *job, const char *hostname,
+			     unsigned int port, int tcp, size_t len,
+			     unsigned long duration,
+			     void ( * callback ) ( uint64_t tx_bytes,
+						   uint64_t rx_bytes,
+						   unsigned long elapsed ) );
+
+#endif /* _IPXE_NETBENCH_H */
@@ -16,6 +16,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/settings.h>
 #include <ipxe/interface.h>
 #include <ipxe/retry.h>
+#include <ipxe/timer.h>
 
 struct io_buffer;
 struct net_device;
@@ -107,6 +108,9 @@ struct net_protocol {
 /** Packet is a broadcast packet */
 #define LL_BROADCAST 0x0002
 
+/** Packet is a link-layer control packet (e.g. LACP or STP) */
+#define LL_CONTROL 0x0004
+
 /**
  * A link-layer protocol
  *
@@ -283,6 +287,9 @@ struct net_device_error {
 /** Maximum number of unique errors that we will keep track of */
 #define NETDEV_MAX_UNIQUE_ERRORS 4
 
+/** Statistics rate estimation window (in ticks) */
+#define NETDEV_RATE_WINDOW TICKS_PER_SEC
+
 /** Network device statistics */
 struct net_device_stats {
 	/** Count of successful completions */
@@ -291,6 +298,12 @@ struct net_device_stats {
 	unsigned int bad;
 	/** Error breakdowns */
 	struct net_device_error errors[NETDEV_MAX_UNIQUE_ERRORS];
+	/** Rate estimation window start time (in ticks) */
+	unsigned long window_start;
+	/** Count of successful completions at start of window */
+	unsigned int window_good;
+	/** Estimated completion rate (in completions per second) */
+	unsigned int rate;
 };
 
 /** A network device configuration */
@@ -411,6 +424,14 @@ struct net_device {
 	struct list_head tx_queue;
 	/** Deferred TX packet queue */
 	struct list_head tx_deferred;
+	/** TX queue occupancy
+	 *
+	 * This is the number of packets currently in the TX queue and
+	 * deferred TX queue.
+	 */
+	unsigned int tx_count;
+	/** TX queue occupancy high-water mark */
+	unsigned int tx_max;
 	/** RX packet queue */
 	struct list_head rx_queue;
 	/** TX statistics */
@@ -676,6 +697,22 @@ netdev_irq_enabled ( struct net_device *netdev ) {
 	return ( netdev->state & NETDEV_IRQ_ENABLED );
 }
 
+/**
+ * Check whether or not network device transmit queue is congested
+ *
+ * @v netdev		Network device
+ * @ret congested	Transmit queue is congested
+ *
+ * The transmit queue is congested whenever packets have had to be
+ * deferred due to a full transmit descriptor ring.  Protocols may use
+ * this as a backpressure signal, delaying the generation of new
+ * packets until transmit completions have drained the backlog.
+ */
+static inline __attribute__ (( always_inline )) int
+netdev_tx_congested ( struct net_device *netdev ) {
+	return ( ! list_empty ( &netdev->tx_deferred ) );
+}
+
 /**
  * Check whether or not network device receive queue processing is frozen
  *
@@ -713,6 +750,8 @@ extern int netdev_open ( struct net_device *netdev );
 extern void netdev_close ( struct net_device *netdev );
 extern void unregister_netdev ( struct net_device *netdev );
 extern void netdev_irq ( struct net_device *netdev, int enable );
+extern int netdev_wake ( struct net_device *netdev );
+extern void netdev_unwake ( struct net_device *netdev );
 extern struct net_device * find_netdev ( const char *name );
 extern struct net_device * find_netdev_by_index ( unsigned int index );
 extern struct net_device * find_netdev_by_location ( unsigned int bus_type,
@@ -104,6 +104,15 @@ struct ntp_header {
  */
 #define NTP_MAX_TIMEOUT ( 10 * TICKS_PER_SEC )
 
+/** NTP number of samples per synchronisation
+ *
+ * A single sample is in error by the full path asymmetry; taking a
+ * short burst of samples and applying the one with the lowest round
+ * trip time bounds this error by the best observed path.  This is a
+ * policy decision.
+ */
+#define NTP_BURST_COUNT 4
+
 extern int start_ntp ( struct interface *job, const char *hostname );
 
 #endif /* _IPXE_NTP_H */
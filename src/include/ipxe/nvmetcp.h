@@ -0,0 +1,460 @@
+#ifndef _IPXE_NVMETCP_H
+#define _IPXE_NVMETCP_H
+
+/** @file
+ *
+ * NVMe over TCP protocol
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/interface.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/uuid.h>
+#include <ipxe/refcnt.h>
+
+/** Default NVMe/TCP port */
+#define NVMETCP_PORT 4420
+
+/** NVMe qualified name prefix */
+#define NVMETCP_NQN_PREFIX "nqn.2014-08.org.nvmexpress"
+
+/** Maximum length of an NVMe qualified name (including the NUL) */
+#define NVME_NQN_LEN 256
+
+/** An NVMe/TCP PDU common header */
+struct nvmetcp_pdu_header {
+	/** PDU type */
+	uint8_t type;
+	/** Flags */
+	uint8_t flags;
+	/** PDU header length */
+	uint8_t hlen;
+	/** PDU data offset (if data is present) */
+	uint8_t pdo;
+	/** PDU total length (little-endian) */
+	uint32_t plen;
+} __attribute__ (( packed ));
+
+/** Initialise connection request PDU type */
+#define NVMETCP_ICREQ 0x00
+
+/** Initialise connection response PDU type */
+#define NVMETCP_ICRESP 0x01
+
+/** Host to controller termination request PDU type */
+#define NVMETCP_H2C_TERM 0x02
+
+/** Controller to host termination request PDU type */
+#define NVMETCP_C2H_TERM 0x03
+
+/** Command capsule PDU type */
+#define NVMETCP_CMD 0x04
+
+/** Response capsule PDU type */
+#define NVMETCP_RSP 0x05
+
+/** Host to controller data PDU type */
+#define NVMETCP_H2C_DATA 0x06
+
+/** Controller to host data PDU type */
+#define NVMETCP_C2H_DATA 0x07
+
+/** Ready to transfer PDU type */
+#define NVMETCP_R2T 0x09
+
+/** Data PDU is the last for this command or transfer tag */
+#define NVMETCP_FLAG_LAST 0x04
+
+/** Data PDU indicates command success (no response capsule follows) */
+#define NVMETCP_FLAG_SUCCESS 0x08
+
+/** An NVMe/TCP initialise connection request PDU */
+struct nvmetcp_icreq {
+	/** Common header */
+	struct nvmetcp_pdu_header header;
+	/** PDU format version (little-endian) */
+	uint16_t pfv;
+	/** Host PDU data alignment */
+	uint8_t hpda;
+	/** Digest flags */
+	uint8_t dgst;
+	/** Maximum number of outstanding R2Ts, zero-based (little-endian) */
+	uint32_t maxr2t;
+	/** Reserved */
+	uint8_t reserved[112];
+} __attribute__ (( packed ));
+
+/** An NVMe/TCP initialise connection response PDU */
+struct nvmetcp_icresp {
+	/** Common header */
+	struct nvmetcp_pdu_header header;
+	/** PDU format version (little-endian) */
+	uint16_t pfv;
+	/** Controller PDU data alignment */
+	uint8_t cpda;
+	/** Digest flags */
+	uint8_t dgst;
+	/** Maximum host to controller data length (little-endian) */
+	uint32_t maxh2cdata;
+	/** Reserved */
+	uint8_t reserved[112];
+} __attribute__ (( packed ));
+
+/** An NVMe scatter-gather list descriptor */
+struct nvme_sgl {
+	/** Address (little-endian) */
+	uint64_t addr;
+	/** Length (little-endian) */
+	uint32_t len;
+	/** Reserved */
+	uint8_t reserved[3];
+	/** Descriptor type and subtype */
+	uint8_t type;
+} __attribute__ (( packed ));
+
+/** In-capsule data block SGL descriptor type */
+#define NVME_SGL_DATA_OFFSET 0x01
+
+/** Transport data block SGL descriptor type */
+#define NVME_SGL_TRANSPORT 0x5a
+
+/** An NVMe submission queue entry */
+struct nvme_sqe {
+	/** Opcode */
+	uint8_t opcode;
+	/** Flags */
+	uint8_t flags;
+	/** Command identifier (little-endian) */
+	uint16_t cid;
+	/** Namespace identifier (little-endian) */
+	uint32_t nsid;
+	/** Reserved */
+	uint8_t reserved[8];
+	/** Metadata pointer (little-endian) */
+	uint64_t mptr;
+	/** Data pointer */
+	struct nvme_sgl sgl;
+	/** Command dwords 10-15 (little-endian) */
+	uint32_t cdw10[6];
+} __attribute__ (( packed ));
+
+/** SGLs are used for this command */
+#define NVME_SQE_FLAG_SGL 0x40
+
+/** Identify admin command opcode */
+#define NVME_IDENTIFY 0x06
+
+/** Write I/O command opcode */
+#define NVME_WRITE 0x01
+
+/** Read I/O command opcode */
+#define NVME_READ 0x02
+
+/** An NVMe over Fabrics connect request */
+struct nvme_connect {
+	/** Record format (little-endian) */
+	uint16_t recfmt;
+	/** Queue identifier (little-endian) */
+	uint16_t qid;
+	/** Submission queue size, zero-based (little-endian) */
+	uint16_t sqsize;
+	/** Connect attributes */
+	uint8_t cattr;
+	/** Reserved */
+	uint8_t reserved_a;
+	/** Keep alive timeout in milliseconds (little-endian) */
+	uint32_t kato;
+	/** Reserved */
+	uint8_t reserved_b[12];
+} __attribute__ (( packed ));
+
+/** An NVMe over Fabrics property request */
+struct nvme_property {
+	/** Attributes (property size) */
+	uint8_t attrib;
+	/** Reserved */
+	uint8_t reserved_a[3];
+	/** Property offset (little-endian) */
+	uint32_t offset;
+	/** Property value (little-endian, set only) */
+	uint64_t value;
+	/** Reserved */
+	uint8_t reserved_b[8];
+} __attribute__ (( packed ));
+
+/** An NVMe over Fabrics submission queue entry */
+struct nvme_fabrics_sqe {
+	/** Opcode */
+	uint8_t opcode;
+	/** Reserved */
+	uint8_t reserved_a;
+	/** Command identifier (little-endian) */
+	uint16_t cid;
+	/** Fabrics command type */
+	uint8_t fctype;
+	/** Reserved */
+	uint8_t reserved_b[19];
+	/** Data pointer */
+	struct nvme_sgl sgl;
+	/** Command type specific */
+	union {
+		/** Connect request */
+		struct nvme_connect connect;
+		/** Property request */
+		struct nvme_property property;
+		/** Padding */
+		uint8_t pad[24];
+	} u;
+} __attribute__ (( packed ));
+
+/** Fabrics command opcode */
+#define NVME_FABRICS 0x7f
+
+/** Property set fabrics command type */
+#define NVME_FABRICS_PROPERTY_SET 0x00
+
+/** Connect fabrics command type */
+#define NVME_FABRICS_CONNECT 0x01
+
+/** Property get fabrics command type */
+#define NVME_FABRICS_PROPERTY_GET 0x04
+
+/** Controller configuration property offset */
+#define NVME_REG_CC 0x14
+
+/** Controller configuration value (enabled, IOSQES=6, IOCQES=4) */
+#define NVME_CC_VALUE 0x00460001UL
+
+/** Controller status property offset */
+#define NVME_REG_CSTS 0x1c
+
+/** Controller status: ready */
+#define NVME_CSTS_RDY 0x00000001UL
+
+/** Controller status: fatal status */
+#define NVME_CSTS_CFS 0x00000002UL
+
+/** Dynamic controller identifier (used before connecting) */
+#define NVME_CNTLID_DYNAMIC 0xffff
+
+/** An NVMe over Fabrics connect request data block */
+struct nvme_connect_data {
+	/** Host identifier */
+	union uuid hostid;
+	/** Controller identifier (little-endian) */
+	uint16_t cntlid;
+	/** Reserved */
+	uint8_t reserved_a[238];
+	/** Subsystem NVMe qualified name */
+	char subnqn[NVME_NQN_LEN];
+	/** Host NVMe qualified name */
+	char hostnqn[NVME_NQN_LEN];
+	/** Reserved */
+	uint8_t reserved_b[256];
+} __attribute__ (( packed ));
+
+/** An NVMe completion queue entry */
+struct nvme_cqe {
+	/** Command specific result dword 0 (little-endian) */
+	uint32_t dw0;
+	/** Command specific result dword 1 (little-endian) */
+	uint32_t dw1;
+	/** Submission queue head pointer (little-endian) */
+	uint16_t sqhd;
+	/** Submission queue identifier (little-endian) */
+	uint16_t sqid;
+	/** Command identifier (little-endian) */
+	uint16_t cid;
+	/** Phase tag and status (little-endian) */
+	uint16_t status;
+} __attribute__ (( packed ));
+
+/** An NVMe/TCP command capsule PDU */
+struct nvmetcp_cmd {
+	/** Common header */
+	struct nvmetcp_pdu_header header;
+	/** Submission queue entry */
+	union {
+		/** Standard submission queue entry */
+		struct nvme_sqe sqe;
+		/** Fabrics submission queue entry */
+		struct nvme_fabrics_sqe fabrics;
+	} u;
+} __attribute__ (( packed ));
+
+/** An NVMe/TCP response capsule PDU */
+struct nvmetcp_rsp {
+	/** Common header */
+	struct nvmetcp_pdu_header header;
+	/** Completion queue entry */
+	struct nvme_cqe cqe;
+} __attribute__ (( packed ));
+
+/** An NVMe/TCP data PDU (C2HData or H2CData) */
+struct nvmetcp_data {
+	/** Common header */
+	struct nvmetcp_pdu_header header;
+	/** Command capsule identifier (little-endian) */
+	uint16_t cccid;
+	/** Transfer tag (little-endian, H2CData only) */
+	uint16_t ttag;
+	/** Data offset (little-endian) */
+	uint32_t datao;
+	/** Data length (little-endian) */
+	uint32_t datal;
+	/** Reserved */
+	uint8_t reserved[4];
+} __attribute__ (( packed ));
+
+/** An NVMe/TCP ready to transfer PDU */
+struct nvmetcp_r2t {
+	/** Common header */
+	struct nvmetcp_pdu_header header;
+	/** Command capsule identifier (little-endian) */
+	uint16_t cccid;
+	/** Transfer tag (little-endian) */
+	uint16_t ttag;
+	/** Requested data offset (little-endian) */
+	uint32_t r2to;
+	/** Requested data length (little-endian) */
+	uint32_t r2tl;
+	/** Reserved */
+	uint8_t reserved[4];
+} __attribute__ (( packed ));
+
+/** A received NVMe/TCP PDU header */
+union nvmetcp_pdu {
+	/** Common header */
+	struct nvmetcp_pdu_header header;
+	/** Initialise connection response */
+	struct nvmetcp_icresp icresp;
+	/** Response capsule */
+	struct nvmetcp_rsp rsp;
+	/** Data PDU */
+	struct nvmetcp_data data;
+	/** Ready to transfer */
+	struct nvmetcp_r2t r2t;
+	/** Raw bytes */
+	uint8_t bytes[128];
+};
+
+/** An NVMe LBA format descriptor */
+struct nvme_lbaf {
+	/** Metadata size (little-endian) */
+	uint16_t ms;
+	/** LBA data size (log2) */
+	uint8_t lbads;
+	/** Relative performance */
+	uint8_t rp;
+} __attribute__ (( packed ));
+
+/** An NVMe Identify Namespace data structure (partial) */
+struct nvme_identity {
+	/** Namespace size in logical blocks (little-endian) */
+	uint64_t nsze;
+	/** Namespace capacity (little-endian) */
+	uint64_t ncap;
+	/** Namespace utilisation (little-endian) */
+	uint64_t nuse;
+	/** Namespace features */
+	uint8_t nsfeat;
+	/** Number of LBA formats, zero-based */
+	uint8_t nlbaf;
+	/** Formatted LBA size */
+	uint8_t flbas;
+	/** Metadata capabilities */
+	uint8_t mc;
+	/** Reserved (fields we do not use) */
+	uint8_t reserved[100];
+	/** LBA format descriptors */
+	struct nvme_lbaf lbaf[16];
+} __attribute__ (( packed ));
+
+/** Length of an Identify data structure */
+#define NVME_IDENTIFY_LEN 4096
+
+/** Identify Namespace CNS value */
+#define NVME_IDENTIFY_NS 0x00
+
+/** Formatted LBA size: format index mask */
+#define NVME_FLBAS_FORMAT( flbas ) ( (flbas) & 0x0f )
+
+/** Formatted LBA size: metadata transferred inline */
+#define NVME_FLBAS_EXTENDED 0x10
+
+/** An NVMe/TCP queue (one TCP connection) */
+struct nvmetcp_queue {
+	/** Containing session */
+	struct nvmetcp_session *nvmetcp;
+	/** Queue identifier */
+	uint16_t qid;
+	/** Transport-layer socket */
+	struct interface socket;
+
+	/** Received PDU header */
+	union nvmetcp_pdu rx;
+	/** Byte offset within current received PDU */
+	size_t rx_offset;
+	/** Maximum host to controller data length per PDU */
+	uint32_t maxh2cdata;
+};
+
+/** An NVMe/TCP session */
+struct nvmetcp_session {
+	/** Reference counter */
+	struct refcnt refcnt;
+	/** Block device interface */
+	struct interface block;
+
+	/** Target address */
+	char *target_address;
+	/** Target port */
+	unsigned int target_port;
+	/** Subsystem NVMe qualified name */
+	char *subnqn;
+	/** Host NVMe qualified name */
+	char *hostnqn;
+	/** Host identifier */
+	union uuid hostid;
+	/** Namespace identifier */
+	uint32_t nsid;
+	/** Controller identifier (valid once connected) */
+	uint16_t cntlid;
+
+	/** Session state */
+	unsigned int state;
+	/** Number of controller readiness polls remaining */
+	unsigned int ready_polls;
+	/** Command identifier counter */
+	uint16_t cid;
+
+	/** Admin queue */
+	struct nvmetcp_queue admin;
+	/** I/O queue */
+	struct nvmetcp_queue io;
+	/** List of outstanding commands */
+	struct list_head commands;
+};
+
+/** NVMe/TCP session states */
+enum nvmetcp_state {
+	/** Sent ICReq on admin queue, awaiting ICResp */
+	NVMETCP_STATE_ADMIN_ICREQ = 0,
+	/** Sent Connect on admin queue, awaiting response */
+	NVMETCP_STATE_ADMIN_CONNECT,
+	/** Sent controller configuration, awaiting response */
+	NVMETCP_STATE_ENABLE,
+	/** Polling controller status, awaiting readiness */
+	NVMETCP_STATE_WAIT_READY,
+	/** Sent ICReq on I/O queue, awaiting ICResp */
+	NVMETCP_STATE_IO_ICREQ,
+	/** Sent Connect on I/O queue, awaiting response */
+	NVMETCP_STATE_IO_CONNECT,
+	/** Session established */
+	NVMETCP_STATE_READY,
+};
+
+#endif /* _IPXE_NVMETCP_H */
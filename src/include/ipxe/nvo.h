@@ -11,6 +11,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
 #include <ipxe/dhcpopts.h>
+#include <ipxe/list.h>
 #include <ipxe/settings.h>
 
 struct nvs_device;
@@ -22,6 +23,8 @@ struct refcnt;
 struct nvo_block {
 	/** Settings block */
 	struct settings settings;
+	/** List of registered non-volatile option blocks */
+	struct list_head list;
 	/** Underlying non-volatile storage device */
 	struct nvs_device *nvs;
 	/** Address within NVS device */
@@ -30,6 +33,8 @@ struct nvo_block {
 	size_t len;
 	/** Option-containing data */
 	void *data;
+	/** Data has been modified since last save */
+	int dirty;
 	/**
 	 * Resize non-volatile stored option block
 	 *
@@ -51,7 +56,10 @@ extern void nvo_init ( struct nvo_block *nvo, struct nvs_device *nvs,
 		       size_t address, size_t len,
 		       int ( * resize ) ( struct nvo_block *nvo, size_t len ),
 		       struct refcnt *refcnt );
+extern struct list_head nvo_blocks;
+
 extern int register_nvo ( struct nvo_block *nvo, struct settings *parent );
 extern void unregister_nvo ( struct nvo_block *nvo );
+extern void nvo_sync ( void );
 
 #endif /* _IPXE_NVO_H */
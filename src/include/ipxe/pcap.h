@@ -0,0 +1,70 @@
+#ifndef _IPXE_PCAP_H
+#define _IPXE_PCAP_H
+
+/** @file
+ *
+ * Packet capture
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+
+struct net_device;
+struct io_buffer;
+
+/** Packet capture file magic number */
+#define PCAP_MAGIC 0xa1b2c3d4UL
+
+/** Packet capture file format major version */
+#define PCAP_VERSION_MAJOR 2
+
+/** Packet capture file format minor version */
+#define PCAP_VERSION_MINOR 4
+
+/** Packet capture link type: Ethernet */
+#define PCAP_LINKTYPE_ETHERNET 1
+
+/** A packet capture file header */
+struct pcap_file_header {
+	/** Magic number */
+	uint32_t magic;
+	/** Major version number */
+	uint16_t version_major;
+	/** Minor version number */
+	uint16_t version_minor;
+	/** Timezone correction (unused) */
+	int32_t thiszone;
+	/** Timestamp accuracy (unused) */
+	uint32_t sigfigs;
+	/** Maximum captured length of each packet */
+	uint32_t snaplen;
+	/** Link type */
+	uint32_t network;
+} __attribute__ (( packed ));
+
+/** A packet capture record header */
+struct pcap_record_header {
+	/** Timestamp (seconds) */
+	uint32_t ts_sec;
+	/** Timestamp (microseconds) */
+	uint32_t ts_usec;
+	/** Captured length */
+	uint32_t incl_len;
+	/** Original length */
+	uint32_t orig_len;
+} __attribute__ (( packed ));
+
+/** Default capture buffer length
+ *
+ * This is a policy decision.
+ */
+#define PCAP_DEFAULT_LEN ( 512 * 1024 )
+
+extern int pcap_start ( const char *name, size_t len );
+extern int pcap_stop ( void );
+extern void pcap_record ( struct net_device *netdev,
+			  struct io_buffer *iobuf );
+
+#endif /* _IPXE_PCAP_H */
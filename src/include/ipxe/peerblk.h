@@ -77,6 +77,8 @@ struct peerdist_block {
 	struct cipher_algorithm *cipher;
 	/** Cipher context (dynamically allocated as needed) */
 	void *cipherctx;
+	/** Decryption chunk buffer (dynamically allocated as needed) */
+	void *cipherbuf;
 
 	/** Segment index */
 	unsigned int segment;
@@ -111,6 +113,8 @@ struct peerdist_block {
 	struct peerdisc_client discovery;
 	/** Current position in discovered peer list */
 	struct peerdisc_peer *peer;
+	/** Peer with a download attempt currently in progress (if any) */
+	struct peerdisc_peer *busy;
 	/** Block download queue */
 	struct peerdist_block_queue *queue;
 	/** List of queued block downloads */
@@ -71,6 +71,12 @@ struct peerdisc_segment {
 struct peerdisc_peer {
 	/** List of peers */
 	struct list_head list;
+	/** Number of block download attempts currently in progress */
+	unsigned int inflight;
+	/** Number of successfully completed block download attempts */
+	unsigned int completed;
+	/** Number of consecutive failed block download attempts */
+	unsigned int failures;
 	/** Peer location */
 	char location[0];
 };
@@ -9,10 +9,18 @@
 
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
+#include <ipxe/list.h>
+
 /** A pending operation */
 struct pending_operation {
 	/** Pending count */
 	unsigned int count;
+	/** Owner name */
+	const char *name;
+	/** List of currently pending operations */
+	struct list_head list;
+	/** Time at which operation became pending (in ticks) */
+	unsigned long started;
 };
 
 /**
@@ -26,6 +34,7 @@ static inline int is_pending ( struct pending_operation *pending ) {
 }
 
 extern int pending_total;
+extern struct list_head pending_operations;
 
 /**
  * Check if any operations are pending
@@ -36,7 +45,9 @@ static inline int have_pending ( void ) {
 	return ( pending_total != 0 );
 }
 
-extern void pending_get ( struct pending_operation *pending );
+extern void pending_get ( struct pending_operation *pending,
+			  const char *name );
 extern void pending_put ( struct pending_operation *pending );
+extern void pending_show ( void );
 
 #endif /* _IPXE_PENDING_H */
@@ -14,11 +14,12 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/socket.h>
 
 extern int create_pinger ( struct interface *job, const char *hostname,
-			   unsigned long timeout, size_t len,
-			   unsigned int count,
+			   unsigned long timeout, unsigned long interval,
+			   size_t len, unsigned int count,
 			   void ( * callback ) ( struct sockaddr *peer,
 						 unsigned int sequence,
 						 size_t len,
+						 unsigned long rtt,
 						 int rc ) );
 
 #endif /* _IPXE_PINGER_H */
@@ -116,11 +116,50 @@ struct process_descriptor {
 		.reschedule = 1,					      \
 	}
 
+/** A scheduler idle check
+ *
+ * Idle checks are used to determine whether or not it is safe for the
+ * scheduler to halt the CPU while waiting for the next interrupt.
+ */
+struct idle_check {
+	/** Name */
+	const char *name;
+	/**
+	 * Check for work requiring continuous polling
+	 *
+	 * @ret busy		Polling must continue
+	 */
+	int ( * busy ) ( void );
+	/**
+	 * Prepare to halt the CPU (optional)
+	 *
+	 * @ret rc		Return status code
+	 *
+	 * This may be used to enable interrupt-driven wakeups.  If
+	 * preparation fails then the CPU will not be halted.
+	 */
+	int ( * prepare ) ( void );
+	/**
+	 * Resume polling after halting the CPU (optional)
+	 *
+	 * This will be called only if the corresponding prepare()
+	 * method succeeded.
+	 */
+	void ( * finish ) ( void );
+};
+
+/** Scheduler idle check table */
+#define IDLE_CHECKS __table ( struct idle_check, "idle_checks" )
+
+/** Declare a scheduler idle check */
+#define __idle_check __table_entry ( IDLE_CHECKS, 01 )
+
 extern void * __attribute__ (( pure ))
 process_object ( struct process *process );
 extern void process_add ( struct process *process );
 extern void process_del ( struct process *process );
 extern void step ( void );
+extern void process_nap ( void );
 
 /**
  * Initialise a static process
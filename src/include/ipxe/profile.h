@@ -14,12 +14,35 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #ifndef PROFILING
 #ifdef NDEBUG
+#ifdef PROFILING_SAMPLED
+#define PROFILING 1
+#else
 #define PROFILING 0
+#endif
 #else
 #define PROFILING 1
 #endif
 #endif
 
+/** Sampling interval (as a power of two)
+ *
+ * In sampled mode (enabled in non-debug builds via the
+ * PROFILING_SAMPLED build option), only one in every
+ * 2^PROFILING_SAMPLE_SHIFT events updates the statistics.  The
+ * remaining events cost only a counter increment, which is cheap
+ * enough for production builds.
+ */
+#ifndef PROFILING_SAMPLE_SHIFT
+#define PROFILING_SAMPLE_SHIFT 6
+#endif
+
+/** Sample decimation mask (zero when every event is recorded) */
+#if defined ( NDEBUG ) && defined ( PROFILING_SAMPLED )
+#define PROFILING_SAMPLE_MASK ( ( 1U << PROFILING_SAMPLE_SHIFT ) - 1 )
+#else
+#define PROFILING_SAMPLE_MASK 0
+#endif
+
 /**
  * A data structure for storing profiling information
  */
@@ -48,6 +71,8 @@ struct profiler {
 	 * (i.e. one less than would be returned by flsll(raw_accvar)).
 	 */
 	unsigned int accvar_msb;
+	/** Sample decimation counter (used in sampled mode) */
+	unsigned int decimate;
 };
 
 /** Profiler table */
@@ -144,6 +169,14 @@ profile_stop_at ( struct profiler *profiler, unsigned long stopped ) {
 
 	/* If profiling is active then record end timestamp and update stats */
 	if ( PROFILING ) {
+
+		/* In sampled mode, discard all but one in every
+		 * 2^PROFILING_SAMPLE_SHIFT events.
+		 */
+		if ( PROFILING_SAMPLE_MASK &&
+		     ( profiler->decimate++ & PROFILING_SAMPLE_MASK ) )
+			return;
+
 		profiler->stopped = ( stopped - profile_excluded );
 		profile_update ( profiler, profile_elapsed ( profiler ) );
 	}
@@ -198,8 +231,17 @@ static inline __attribute__ (( always_inline )) void
 profile_custom ( struct profiler *profiler, unsigned long sample ) {
 
 	/* If profiling is active then update stats */
-	if ( PROFILING )
+	if ( PROFILING ) {
+
+		/* In sampled mode, discard all but one in every
+		 * 2^PROFILING_SAMPLE_SHIFT events.
+		 */
+		if ( PROFILING_SAMPLE_MASK &&
+		     ( profiler->decimate++ & PROFILING_SAMPLE_MASK ) )
+			return;
+
 		profile_update ( profiler, sample );
+	}
 }
 
 #endif /* _IPXE_PROFILE_H */
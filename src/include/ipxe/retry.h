@@ -39,6 +39,8 @@ struct retry_timer {
 	unsigned long max;
 	/** Start time (in ticks) */
 	unsigned long start;
+	/** Expiry time (in ticks) */
+	unsigned long expiry;
 	/** Retry count */
 	unsigned int count;
 	/** Timer expired callback
@@ -88,6 +90,7 @@ extern void start_timer_fixed ( struct retry_timer *timer,
 				unsigned long timeout );
 extern void stop_timer ( struct retry_timer *timer );
 extern void retry_poll ( void );
+extern unsigned long retry_deadline ( void );
 
 /**
  * Start timer with no delay
@@ -43,6 +43,20 @@ struct san_path {
 	struct acpi_descriptor *desc;
 };
 
+/** Number of SAN read cache extents
+ *
+ * This is a policy decision.
+ */
+#define SAN_CACHE_EXTENTS 16
+
+/** A SAN read cache extent */
+struct san_cache_extent {
+	/** Starting logical block address */
+	uint64_t lba;
+	/** Number of valid blocks (or zero if extent is empty) */
+	unsigned int count;
+};
+
 /** A SAN device */
 struct san_device {
 	/** Reference count */
@@ -74,6 +88,32 @@ struct san_device {
 	/** Drive is a CD-ROM */
 	int is_cdrom;
 
+	/** Read cache buffer (if allocated) */
+	userptr_t cache;
+	/** Read cache extents */
+	struct san_cache_extent cache_extent[SAN_CACHE_EXTENTS];
+	/** Next read cache extent eviction candidate */
+	unsigned int cache_victim;
+	/** Next expected LBA of a sequential read stream */
+	uint64_t cache_next;
+	/** Number of consecutive sequential reads observed */
+	unsigned int cache_sequential;
+
+	/** Prefetch command interface */
+	struct interface prefetch;
+	/** Prefetch command timeout timer */
+	struct retry_timer prefetch_timer;
+	/** Prefetch command status */
+	int prefetch_rc;
+	/** Prefetch starting logical block address */
+	uint64_t prefetch_lba;
+	/** Prefetch block count */
+	unsigned int prefetch_count;
+	/** Prefetch target cache extent */
+	unsigned int prefetch_extent;
+	/** Prefetch is in progress */
+	int prefetching;
+
 	/** Driver private data */
 	void *priv;
 
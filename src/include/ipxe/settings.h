@@ -302,6 +302,16 @@ struct generic_settings {
 	struct list_head list;
 };
 
+/** A bulk setting fetch */
+struct settings_fetch {
+	/** Setting to fetch */
+	struct setting setting;
+	/** Setting data (allocated by the fetcher on success) */
+	void *data;
+	/** Length of setting data, or negative error */
+	int len;
+};
+
 /** A child settings block locator function */
 typedef struct settings * ( *get_child_settings_t ) ( struct settings *settings,
 						      const char *name );
@@ -314,6 +324,14 @@ extern int generic_settings_fetch ( struct settings *settings,
 				    void *data, size_t len );
 extern void generic_settings_clear ( struct settings *settings );
 
+/** Settings generation counter
+ *
+ * This is incremented whenever a setting is stored or the settings
+ * block hierarchy changes, and may be used to invalidate caches of
+ * derived setting values.
+ */
+extern unsigned int settings_generation;
+
 extern int register_settings ( struct settings *settings,
 			       struct settings *parent, const char *name );
 extern void unregister_settings ( struct settings *settings );
@@ -338,6 +356,9 @@ extern int fetch_raw_setting ( struct settings *settings,
 extern int fetch_raw_setting_copy ( struct settings *settings,
 				    const struct setting *setting,
 				    void **data );
+extern unsigned int fetch_raw_setting_bulk ( struct settings *settings,
+					     struct settings_fetch *fetches,
+					     unsigned int count );
 extern int fetch_string_setting ( struct settings *settings,
 				  const struct setting *setting,
 				  char *data, size_t len );
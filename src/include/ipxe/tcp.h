@@ -144,6 +144,8 @@ struct tcp_options {
 	const struct tcp_window_scale_option *wsopt;
 	/** SACK permitted option, if present */
 	const struct tcp_sack_permitted_option *spopt;
+	/** SACK option, if present */
+	const struct tcp_sack_option *sackopt;
 	/** Timestamp option, if present */
 	const struct tcp_timestamp_option *tsopt;
 };
@@ -355,6 +357,17 @@ struct tcp_options {
  */
 #define TCP_MAX_WINDOW_SIZE	( 256 * 1024 )
 
+/**
+ * Initial advertised window size
+ *
+ * The advertised receive window starts at this value and grows with
+ * the volume of delivered data (mirroring the sender-side slow start
+ * that we, as effectively a pure receiver, cannot rely on the peer to
+ * pace), so that a newly opened or recently lossy connection does not
+ * invite a full-window burst through constrained intermediate buffers.
+ */
+#define TCP_INIT_WINDOW_SIZE	( 8 * TCP_PATH_MTU )
+
 /**
  * Path MTU
  *
@@ -386,6 +399,31 @@ struct tcp_options {
  */
 #define TCP_KEEPALIVE_DELAY ( 15 * TICKS_PER_SEC )
 
+/** TCP keepalive probe count
+ *
+ * We presume that the peer has died after this number of consecutive
+ * keepalive probes has elicited no response, and close the
+ * connection.  This is a policy decision.
+ */
+#define TCP_KEEPALIVE_COUNT 4
+
+/** TCP delayed acknowledgement timeout
+ *
+ * Received in-sequence data segments are acknowledged within this
+ * period even if no further segment arrives to trigger an
+ * acknowledgement.  RFC 1122 permits a delay of up to 500ms; we use a
+ * shorter delay to avoid unduly slowing the peer's congestion window
+ * growth.  This is a policy decision.
+ */
+#define TCP_DELACK_TIMEOUT ( TICKS_PER_SEC / 10 )
+
+/** TCP delayed acknowledgement segment count
+ *
+ * An acknowledgement is sent at least once per this number of
+ * received in-sequence data segments, as required by RFC 1122.
+ */
+#define TCP_DELACK_MAX 2
+
 /**
  * TCP maximum header length
  *
@@ -172,6 +172,13 @@ struct tcpip_net_protocol {
 	 * @ret netdev		Network device, or NULL
 	 */
 	struct net_device * ( * netdev ) ( struct sockaddr_tcpip *dest );
+	/**
+	 * Determine discovered path MTU (optional)
+	 *
+	 * @v st_dest		Destination address
+	 * @ret pmtu		Path MTU, or zero if not discovered
+	 */
+	size_t ( * pmtu ) ( struct sockaddr_tcpip *dest );
 };
 
 /** TCP/IP transport-layer protocol table */
@@ -38,6 +38,18 @@ struct tls_header {
 	uint16_t length;
 } __attribute__ (( packed ));
 
+/** A TLS authentication header for AEAD cipher suites
+ *
+ * This is the additional authenticated data for each record, as
+ * defined in RFC 5246 section 6.2.3.3.
+ */
+struct tls_auth_header {
+	/** Sequence number */
+	uint64_t seq;
+	/** TLS header (with unencrypted payload length) */
+	struct tls_header header;
+} __attribute__ (( packed ));
+
 /** TLS version 1.0 */
 #define TLS_VERSION_TLS_1_0 0x0301
 
@@ -71,6 +83,7 @@ struct tls_header {
 #define TLS_CERTIFICATE_VERIFY 15
 #define TLS_CLIENT_KEY_EXCHANGE 16
 #define TLS_FINISHED 20
+#define TLS_CERTIFICATE_STATUS 22
 
 /* TLS alert levels */
 #define TLS_ALERT_WARNING 1
@@ -83,6 +96,7 @@ struct tls_header {
 #define TLS_RSA_WITH_AES_256_CBC_SHA 0x0035
 #define TLS_RSA_WITH_AES_128_CBC_SHA256 0x003c
 #define TLS_RSA_WITH_AES_256_CBC_SHA256 0x003d
+#define TLS_RSA_WITH_AES_128_GCM_SHA256 0x009c
 
 /* TLS hash algorithm identifiers */
 #define TLS_MD5_ALGORITHM 1
@@ -106,6 +120,10 @@ struct tls_header {
 #define TLS_MAX_FRAGMENT_LENGTH_2048 3
 #define TLS_MAX_FRAGMENT_LENGTH_4096 4
 
+/* TLS certificate status request extension */
+#define TLS_STATUS_REQUEST 5
+#define TLS_CERTIFICATE_STATUS_TYPE_OCSP 1
+
 /* TLS signature algorithms extension */
 #define TLS_SIGNATURE_ALGORITHMS 13
 
@@ -137,6 +155,7 @@ enum tls_tx_pending {
 	TLS_TX_CERTIFICATE_VERIFY = 0x0008,
 	TLS_TX_CHANGE_CIPHER = 0x0010,
 	TLS_TX_FINISHED = 0x0020,
+	TLS_TX_DATA = 0x0040,
 };
 
 /** A TLS cipher suite */
@@ -151,6 +170,16 @@ struct tls_cipher_suite {
 	uint16_t key_len;
 	/** Numeric code (in network-endian order) */
 	uint16_t code;
+	/** MAC length
+	 *
+	 * This is zero for AEAD cipher suites, which use the cipher's
+	 * authentication tag in place of an HMAC.
+	 */
+	uint8_t mac_len;
+	/** Fixed initialisation vector length */
+	uint8_t fixed_iv_len;
+	/** Record initialisation vector length */
+	uint8_t record_iv_len;
 };
 
 /** TLS cipher suite table */
@@ -173,8 +202,12 @@ struct tls_cipherspec {
 	void *cipher_ctx;
 	/** Next bulk encryption cipher context (TX only) */
 	void *cipher_next_ctx;
-	/** MAC secret */
-	void *mac_secret;
+	/** Precomputed HMAC input pad digest context */
+	void *hmac_ipad_ctx;
+	/** Precomputed HMAC output pad digest context */
+	void *hmac_opad_ctx;
+	/** Fixed initialisation vector */
+	void *fixed_iv;
 };
 
 /** A TLS signature and hash algorithm identifier */
@@ -246,7 +279,16 @@ struct md5_sha1_digest {
 /** MD5+SHA1 digest size */
 #define MD5_SHA1_DIGEST_SIZE sizeof ( struct md5_sha1_digest )
 
-/** A TLS session */
+/** A TLS session
+ *
+ * Sessions are cached (keyed by server name) for the lifetime of the
+ * iPXE instance and shared between connections, providing abbreviated
+ * handshakes for sequential connections to the same server via both
+ * session ID reuse and RFC 5077 session tickets; an empty
+ * SessionTicket extension is sent on the first connection to request
+ * a ticket, and any ticket issued by the server is presented on
+ * subsequent connections.
+ */
 struct tls_session {
 	/** Reference counter */
 	struct refcnt refcnt;
@@ -328,6 +370,10 @@ struct tls_connection {
 
 	/** Server certificate chain */
 	struct x509_chain *chain;
+	/** Stapled OCSP response (if any) */
+	void *ocsp;
+	/** Length of stapled OCSP response */
+	size_t ocsp_len;
 	/** Certificate validator */
 	struct interface validator;
 
@@ -342,6 +388,8 @@ struct tls_connection {
 	uint64_t tx_seq;
 	/** TX pending transmissions */
 	unsigned int tx_pending;
+	/** List of corked plaintext data buffers, pending transmission */
+	struct list_head tx_data;
 	/** TX process */
 	struct process process;
 
@@ -355,6 +403,8 @@ struct tls_connection {
 	struct io_buffer rx_header_iobuf;
 	/** List of received data buffers */
 	struct list_head rx_data;
+	/** List of received plaintext data buffers, pending delivery */
+	struct list_head rx_plaintext;
 };
 
 /** RX I/O buffer size
@@ -378,6 +428,14 @@ struct tls_connection {
 /** RX I/O buffer alignment */
 #define TLS_RX_ALIGN 16
 
+/** Maximum TX record length
+ *
+ * The TLS specification allows a plaintext fragment of up to 16kB.
+ * Corked plaintext is sent as the minimal number of records of up to
+ * this length.
+ */
+#define TLS_TX_RECORD_LEN 16384
+
 extern int add_tls ( struct interface *xfer, const char *name,
 		     struct interface **next );
 
@@ -43,6 +43,18 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 userptr_t urealloc ( userptr_t userptr, size_t new_size );
 
+/**
+ * Estimate available external memory
+ *
+ * @ret avail		Estimated available memory
+ *
+ * This is an estimate of the largest single external allocation that
+ * could currently succeed, intended for telemetry and pre-flight
+ * checks.  Implementations for which no meaningful estimate exists
+ * return the maximum representable size.
+ */
+size_t umavail ( void );
+
 /**
  * Allocate external memory
  *
@@ -18,6 +18,8 @@
 /* Virtio feature flags used to negotiate device and driver features. */
 /* Can the device handle any descriptor layout? */
 #define VIRTIO_F_ANY_LAYOUT             27
+/* Support notification suppression via ring event indices. */
+#define VIRTIO_RING_F_EVENT_IDX         29
 /* v1.0 compliant. */
 #define VIRTIO_F_VERSION_1              32
 #define VIRTIO_F_IOMMU_PLATFORM         33
@@ -66,17 +68,39 @@ struct vring {
    struct vring_used *used;
 };
 
+/* Ring sizes include the trailing used_event and avail_event indices,
+ * which are present whenever VIRTIO_RING_F_EVENT_IDX is negotiated.
+ */
 #define vring_size(num) \
    (((((sizeof(struct vring_desc) * num) + \
-      (sizeof(struct vring_avail) + sizeof(u16) * num)) \
+      (sizeof(struct vring_avail) + sizeof(u16) * (num + 1))) \
          + PAGE_MASK) & ~PAGE_MASK) + \
-         (sizeof(struct vring_used) + sizeof(struct vring_used_elem) * num))
+         (sizeof(struct vring_used) + \
+          sizeof(struct vring_used_elem) * num + sizeof(u16)))
+
+/* Location of the used_event and avail_event indices, valid only when
+ * VIRTIO_RING_F_EVENT_IDX has been negotiated.
+ */
+#define vring_used_event(vr)  ((vr)->avail->ring[(vr)->num])
+
+static inline u16 *vring_avail_event_ptr(struct vring *vr)
+{
+   void *avail_event = &vr->used->ring[vr->num];
+
+   return avail_event;
+}
+
+#define vring_avail_event(vr) (*vring_avail_event_ptr(vr))
 
 struct vring_virtqueue {
    unsigned char *queue;
    struct vring vring;
    u16 free_head;
    u16 last_used_idx;
+   /* VIRTIO_RING_F_EVENT_IDX has been negotiated */
+   int event_idx;
+   /* Callbacks are currently enabled */
+   int cb_enabled;
    void **vdata;
    /* PCI */
    int queue_index;
@@ -117,12 +141,34 @@ static inline void vring_init(struct vring *vr,
 
 static inline void vring_enable_cb(struct vring_virtqueue *vq)
 {
+   vq->cb_enabled = 1;
    vq->vring.avail->flags &= ~VRING_AVAIL_F_NO_INTERRUPT;
+   /* With event indices the device ignores the interrupt suppression
+    * flag, and instead interrupts when the used index passes
+    * used_event, so request an interrupt for the next used buffer.
+    */
+   if (vq->event_idx)
+           vring_used_event(&vq->vring) = vq->last_used_idx;
 }
 
 static inline void vring_disable_cb(struct vring_virtqueue *vq)
 {
+   vq->cb_enabled = 0;
    vq->vring.avail->flags |= VRING_AVAIL_F_NO_INTERRUPT;
+   /* Push used_event far into the future to suppress interrupts */
+   if (vq->event_idx)
+           vring_used_event(&vq->vring) = (u16)(vq->last_used_idx + 0x8000);
+}
+
+/*
+ * vring_need_event
+ *
+ * Device has advanced the ring index from old to new; does this cross
+ * the event index (and hence require a notification)?
+ */
+static inline int vring_need_event(u16 event, u16 new_idx, u16 old_idx)
+{
+   return (u16)(new_idx - event - 1) < (u16)(new_idx - old_idx);
 }
 
 
@@ -0,0 +1,14 @@
+#ifndef _IPXE_WATCHDOG_H
+#define _IPXE_WATCHDOG_H
+
+/** @file
+ *
+ * Platform watchdog refresh
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+extern void watchdog_refresh ( void );
+
+#endif /* _IPXE_WATCHDOG_H */
@@ -130,6 +130,8 @@ struct x509_ocsp_responder {
 	struct asn1_cursor uri;
 	/** OCSP status is good */
 	int good;
+	/** Time at which OCSP status must be rechecked */
+	time_t next_update;
 };
 
 /** X.509 certificate authority information access */
@@ -193,6 +195,12 @@ struct x509_certificate {
 	unsigned int flags;
 	/** Maximum number of subsequent certificates in chain */
 	unsigned int path_remaining;
+	/** Time at which cached validation result expires
+	 *
+	 * A value of zero indicates that the cached validation result
+	 * does not expire.
+	 */
+	time_t valid_until;
 
 	/** Raw certificate */
 	struct asn1_cursor raw;
@@ -21,6 +21,13 @@ struct xfer_buffer {
 	void *data;
 	/** Size of data */
 	size_t len;
+	/** Allocated size of data
+	 *
+	 * This may exceed the size of the data, since the buffer is
+	 * grown geometrically to avoid copying the entire buffer on
+	 * each small extension.
+	 */
+	size_t allocated;
 	/** Current offset within data */
 	size_t pos;
 	/** Data transfer buffer operations */
@@ -90,6 +97,8 @@ xferbuf_umalloc_init ( struct xfer_buffer *xferbuf, userptr_t *data ) {
 }
 
 extern void xferbuf_free ( struct xfer_buffer *xferbuf );
+extern int xferbuf_ensure_size ( struct xfer_buffer *xferbuf, size_t len );
+extern void xferbuf_trim ( struct xfer_buffer *xferbuf );
 extern int xferbuf_write ( struct xfer_buffer *xferbuf, size_t offset,
 			   const void *data, size_t len );
 extern int xferbuf_read ( struct xfer_buffer *xferbuf, size_t offset,
@@ -0,0 +1,46 @@
+#ifndef _IPXE_ZSTD_H
+#define _IPXE_ZSTD_H
+
+/** @file
+ *
+ * Zstandard decompression
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/uaccess.h>
+
+/** A chunk of data */
+struct zstd_chunk {
+	/** Data */
+	userptr_t data;
+	/** Current offset */
+	size_t offset;
+	/** Length of data */
+	size_t len;
+};
+
+/**
+ * Initialise chunk of data
+ *
+ * @v chunk		Chunk of data to initialise
+ * @v data		Data
+ * @v offset		Starting offset
+ * @v len		Length
+ */
+static inline __attribute__ (( always_inline )) void
+zstd_chunk_init ( struct zstd_chunk *chunk, userptr_t data,
+		  size_t offset, size_t len ) {
+
+	chunk->data = data;
+	chunk->offset = offset;
+	chunk->len = len;
+}
+
+extern int zstd_decompressed_len ( const struct zstd_chunk *in,
+				   uint64_t *len );
+extern int zstd_decompress ( struct zstd_chunk *in, struct zstd_chunk *out );
+
+#endif /* _IPXE_ZSTD_H */
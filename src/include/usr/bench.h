@@ -0,0 +1,19 @@
+#ifndef _USR_BENCH_H
+#define _USR_BENCH_H
+
+/** @file
+ *
+ * Benchmark commands
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+
+extern int netbench ( const char *hostname, unsigned int port, int tcp,
+		      size_t len, unsigned long duration );
+extern int diskbench ( unsigned int drive, size_t len );
+extern int cryptobench ( void );
+
+#endif /* _USR_BENCH_H */
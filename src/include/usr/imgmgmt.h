@@ -15,6 +15,9 @@ extern int imgdownload ( struct uri *uri, unsigned long timeout,
 			 struct image **image );
 extern int imgdownload_string ( const char *uri_string, unsigned long timeout,
 				struct image **image );
+extern int imgdownload_multiple ( char * const *uri_strings,
+				  unsigned int count, unsigned long timeout );
+extern int imgprefetch ( const char *uri_string );
 extern int imgacquire ( const char *name, unsigned long timeout,
 			struct image **image );
 extern void imgstat ( struct image *image );
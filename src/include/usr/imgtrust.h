@@ -11,6 +11,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <ipxe/image.h>
 
+extern int imgverify_start ( struct image *image, struct image *signature,
+			     const char *name );
 extern int imgverify ( struct image *image, struct image *signature,
 		       const char *name );
 
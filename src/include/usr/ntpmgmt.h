@@ -10,5 +10,6 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 extern int ntp ( const char *hostname );
+extern int ntp_start ( const char *hostname );
 
 #endif /* _USR_NTPMGMT_H */
@@ -11,7 +11,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
 
-extern int ping ( const char *hostname, unsigned long timeout, size_t len,
-		  unsigned int count, int quiet );
+extern int ping ( const char *hostname, unsigned long timeout,
+		  unsigned long interval, size_t len, unsigned int count,
+		  int quiet );
 
 #endif /* _USR_PINGMGMT_H */
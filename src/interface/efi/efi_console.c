@@ -28,6 +28,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/ansiesc.h>
 #include <ipxe/console.h>
 #include <ipxe/init.h>
+#include <ipxe/process.h>
 #include <config/console.h>
 
 #define ATTR_BOLD		0x08
@@ -197,23 +198,84 @@ static struct ansiesc_context efi_ansiesc_ctx = {
 	.handlers = efi_ansiesc_handlers,
 };
 
+/** EFI console output buffer length
+ *
+ * Firmware text output can be extremely slow (of the order of
+ * milliseconds per OutputString call on some BMC-redirected
+ * consoles), with the cost dominated by the per-call overhead rather
+ * than by the number of characters.  Output is therefore accumulated
+ * and flushed as a single OutputString call at the end of each line,
+ * whenever console state must change, or on each poll cycle.
+ */
+#define EFI_CONSOLE_BUFFER_LEN 256
+
+/** EFI console output buffer */
+static wchar_t efi_console_buffer[ EFI_CONSOLE_BUFFER_LEN + 1 /* wNUL */ ];
+
+/** EFI console output buffer fill level */
+static unsigned int efi_console_fill;
+
+/**
+ * Flush EFI console output buffer
+ *
+ */
+static void efi_console_flush ( void ) {
+	EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL *conout = efi_systab->ConOut;
+
+	/* Do nothing if buffer is empty */
+	if ( ! efi_console_fill )
+		return;
+
+	/* Output entire buffer in a single call */
+	efi_console_buffer[efi_console_fill] = L'\0';
+	efi_console_fill = 0;
+	conout->OutputString ( conout, efi_console_buffer );
+}
+
 /**
  * Print a character to EFI console
  *
  * @v character		Character to be printed
  */
 static void efi_putchar ( int character ) {
-	EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL *conout = efi_systab->ConOut;
-	wchar_t wstr[] = { character, 0 };
+
+	/* Flush any buffered output before processing an escape
+	 * sequence, since the sequence handlers modify console state
+	 * (attributes, cursor position) that must not be applied to
+	 * not-yet-printed characters.
+	 */
+	if ( character == 0x1b /* ESC */ )
+		efi_console_flush();
 
 	/* Intercept ANSI escape sequences */
 	character = ansiesc_process ( &efi_ansiesc_ctx, character );
 	if ( character < 0 )
 		return;
 
-	conout->OutputString ( conout, wstr );
+	/* Queue character */
+	efi_console_buffer[efi_console_fill++] = character;
+
+	/* Flush at end of line, or when the buffer is full */
+	if ( ( character == '\n' ) ||
+	     ( efi_console_fill == EFI_CONSOLE_BUFFER_LEN ) ) {
+		efi_console_flush();
+	}
 }
 
+/**
+ * EFI console background flush process
+ *
+ * @v process		EFI console process
+ */
+static void efi_console_step ( struct process *process __unused ) {
+
+	/* Flush any buffered output */
+	efi_console_flush();
+}
+
+/** EFI console process */
+PERMANENT_PROCESS ( efi_console_process, efi_console_step );
+
 /**
  * Pointer to current ANSI output sequence
  *
@@ -49,6 +49,12 @@ struct efi_download_file {
 
 	/** Callback context */
 	void *context;
+
+	/** Destination extents for scatter downloads (if any) */
+	IPXE_DOWNLOAD_EXTENT *extents;
+
+	/** Number of destination extents */
+	UINTN num_extents;
 };
 
 /* xfer interface */
@@ -63,11 +69,50 @@ static void efi_download_close ( struct efi_download_file *file, int rc ) {
 
 	file->finish_callback ( file->context, EFIRC ( rc ) );
 
+	free ( file->extents );
+	file->extents = NULL;
+
 	intf_shutdown ( &file->xfer, rc );
 
 	efi_snp_release();
 }
 
+/**
+ * Scatter received data into the registered destination extents
+ *
+ * @v file		Data transfer file
+ * @v data		Received data
+ * @v len		Length of received data
+ * @v pos		File position of received data
+ */
+static void efi_download_scatter ( struct efi_download_file *file,
+				   const void *data, size_t len, size_t pos ) {
+	IPXE_DOWNLOAD_EXTENT *extent;
+	size_t start;
+	size_t end;
+	UINTN i;
+
+	for ( i = 0 ; i < file->num_extents ; i++ ) {
+		extent = &file->extents[i];
+
+		/* Calculate overlap between data and extent */
+		start = pos;
+		if ( start < extent->FileOffset )
+			start = extent->FileOffset;
+		end = ( pos + len );
+		if ( end > ( extent->FileOffset + extent->Length ) )
+			end = ( extent->FileOffset + extent->Length );
+		if ( start >= end )
+			continue;
+
+		/* Copy overlapping portion directly into place */
+		memcpy ( ( ( ( uint8_t * ) extent->Buffer ) +
+			   ( start - extent->FileOffset ) ),
+			 ( ( ( const uint8_t * ) data ) + ( start - pos ) ),
+			 ( end - start ) );
+	}
+}
+
 /**
  * Process received data
  *
@@ -88,9 +133,14 @@ static int efi_download_deliver_iob ( struct efi_download_file *file,
 		file->pos = 0;
 	file->pos += meta->offset;
 
-	/* Call out to the data handler */
-	if ( ( efirc = file->data_callback ( file->context, iobuf->data,
-					     len, file->pos ) ) != 0 ) {
+	/* Scatter data directly into any registered extents */
+	if ( file->extents )
+		efi_download_scatter ( file, iobuf->data, len, file->pos );
+
+	/* Call out to the data handler, if any */
+	if ( file->data_callback &&
+	     ( ( efirc = file->data_callback ( file->context, iobuf->data,
+					       len, file->pos ) ) != 0 ) ) {
 		rc = -EEFI ( efirc );
 		goto err_callback;
 	}
@@ -155,6 +205,68 @@ efi_download_start ( IPXE_DOWNLOAD_PROTOCOL *This __unused,
 	file->data_callback = DataCallback;
 	file->finish_callback = FinishCallback;
 	file->context = Context;
+	file->extents = NULL;
+	file->num_extents = 0;
+	*File = file;
+	return EFI_SUCCESS;
+}
+
+/**
+ * Start downloading a file directly into caller-provided buffers.
+ *
+ * Data is scattered into the registered destination extents as it
+ * arrives, eliminating the intermediate copy through an accumulation
+ * buffer.
+ *
+ * @v This		iPXE Download Protocol instance
+ * @v Url		URL to download from
+ * @v Extents		Array of destination extents
+ * @v ExtentCount	Number of destination extents
+ * @v FinishCallback	Callback that will be invoked when the download ends
+ * @v Context		Context passed to the Finish callback
+ * @v File		Token that can be used to abort the download
+ * @ret Status		EFI status code
+ */
+static EFI_STATUS EFIAPI
+efi_download_start_extents ( IPXE_DOWNLOAD_PROTOCOL *This __unused,
+			     CHAR8 *Url,
+			     IPXE_DOWNLOAD_EXTENT *Extents,
+			     UINTN ExtentCount,
+			     IPXE_DOWNLOAD_FINISH_CALLBACK FinishCallback,
+			     VOID *Context,
+			     IPXE_DOWNLOAD_FILE *File ) {
+	struct efi_download_file *file;
+	int rc;
+
+	file = malloc ( sizeof ( struct efi_download_file ) );
+	if ( file == NULL ) {
+		return EFI_OUT_OF_RESOURCES;
+	}
+
+	/* Take a copy of the extent array; the caller's array need
+	 * not remain valid for the duration of the download.
+	 */
+	file->extents = malloc ( ExtentCount * sizeof ( *Extents ) );
+	if ( file->extents == NULL ) {
+		free ( file );
+		return EFI_OUT_OF_RESOURCES;
+	}
+	memcpy ( file->extents, Extents, ( ExtentCount * sizeof (*Extents) ) );
+	file->num_extents = ExtentCount;
+
+	intf_init ( &file->xfer, &efi_download_file_xfer_desc, NULL );
+	rc = xfer_open ( &file->xfer, LOCATION_URI_STRING, Url );
+	if ( rc ) {
+		free ( file->extents );
+		free ( file );
+		return EFIRC ( rc );
+	}
+
+	efi_snp_claim();
+	file->pos = 0;
+	file->data_callback = NULL;
+	file->finish_callback = FinishCallback;
+	file->context = Context;
 	*File = file;
 	return EFI_SUCCESS;
 }
@@ -196,7 +308,8 @@ efi_download_poll ( IPXE_DOWNLOAD_PROTOCOL *This __unused ) {
 static IPXE_DOWNLOAD_PROTOCOL ipxe_download_protocol_interface = {
 	.Start = efi_download_start,
 	.Abort = efi_download_abort,
-	.Poll = efi_download_poll
+	.Poll = efi_download_poll,
+	.StartExtents = efi_download_start_extents
 };
 
 /**
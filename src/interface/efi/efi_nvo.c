@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2015 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <string.h>
+#include <errno.h>
+#include <ipxe/init.h>
+#include <ipxe/nvs.h>
+#include <ipxe/nvo.h>
+#include <ipxe/efi/efi.h>
+
+/** @file
+ *
+ * EFI variable-backed non-volatile stored options
+ *
+ * Options are held in a RAM copy of a single EFI variable.  Reads
+ * are satisfied from the RAM copy; writes update the RAM copy and
+ * then commit the whole variable via SetVariable().  Since the
+ * non-volatile option machinery coalesces stored settings and writes
+ * back only via nvo_sync(), each batch of changes results in a
+ * single SetVariable() call.
+ */
+
+/** Length of the options variable */
+#define EFI_NVO_LEN 256
+
+/** Options variable GUID */
+static EFI_GUID efi_nvo_guid = {
+	0x9bd17550, 0x7fb1, 0x44b8,
+	{ 0x94, 0x2e, 0xd0, 0x66, 0x6c, 0x3a, 0xa0, 0xc9 }
+};
+
+/** Options variable name */
+static CHAR16 efi_nvo_name[] = L"iPXEOptions";
+
+/** RAM copy of the options variable */
+static uint8_t efi_nvo_data[EFI_NVO_LEN];
+
+/**
+ * Read from EFI variable-backed storage
+ *
+ * @v nvs		NVS device
+ * @v address		Address from which to read
+ * @v data		Data buffer
+ * @v len		Length of data buffer
+ * @ret rc		Return status code
+ */
+static int efi_nvo_read ( struct nvs_device *nvs __unused,
+			  unsigned int address, void *data, size_t len ) {
+
+	memcpy ( data, &efi_nvo_data[address], len );
+	return 0;
+}
+
+/**
+ * Write to EFI variable-backed storage
+ *
+ * @v nvs		NVS device
+ * @v address		Address to which to write
+ * @v data		Data buffer
+ * @v len		Length of data buffer
+ * @ret rc		Return status code
+ */
+static int efi_nvo_write ( struct nvs_device *nvs, unsigned int address,
+			   const void *data, size_t len ) {
+	EFI_RUNTIME_SERVICES *rs = efi_systab->RuntimeServices;
+	EFI_STATUS efirc;
+	int rc;
+
+	/* Update RAM copy */
+	memcpy ( &efi_nvo_data[address], data, len );
+
+	/* Commit whole variable */
+	if ( ( efirc = rs->SetVariable ( efi_nvo_name, &efi_nvo_guid,
+					 ( EFI_VARIABLE_NON_VOLATILE |
+					   EFI_VARIABLE_BOOTSERVICE_ACCESS ),
+					 sizeof ( efi_nvo_data ),
+					 efi_nvo_data ) ) != 0 ) {
+		rc = -EEFI ( efirc );
+		DBGC ( nvs, "EFINVO could not set variable: %s\n",
+		       strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/** EFI variable-backed storage device */
+static struct nvs_device efi_nvo_nvs = {
+	.word_len_log2 = 0,
+	.size = EFI_NVO_LEN,
+	.block_size = EFI_NVO_LEN,
+	.read = efi_nvo_read,
+	.write = efi_nvo_write,
+};
+
+/** EFI variable-backed non-volatile option block */
+static struct nvo_block efi_nvo;
+
+/**
+ * Initialise EFI variable-backed non-volatile stored options
+ *
+ */
+static void efi_nvo_init ( void ) {
+	EFI_RUNTIME_SERVICES *rs = efi_systab->RuntimeServices;
+	UINTN len = sizeof ( efi_nvo_data );
+	EFI_STATUS efirc;
+	int rc;
+
+	/* Read variable into RAM copy.  A missing or malformed
+	 * variable is treated as an empty option block; nvo_load()
+	 * will discard any content that fails its checksum.
+	 */
+	if ( ( efirc = rs->GetVariable ( efi_nvo_name, &efi_nvo_guid, NULL,
+					 &len, efi_nvo_data ) ) != 0 ) {
+		rc = -EEFI ( efirc );
+		DBGC ( &efi_nvo_nvs, "EFINVO could not get variable: %s\n",
+		       strerror ( rc ) );
+		memset ( efi_nvo_data, 0, sizeof ( efi_nvo_data ) );
+	}
+
+	/* Register non-volatile option block */
+	nvo_init ( &efi_nvo, &efi_nvo_nvs, 0, EFI_NVO_LEN, NULL, NULL );
+	if ( ( rc = register_nvo ( &efi_nvo, NULL ) ) != 0 ) {
+		DBGC ( &efi_nvo_nvs, "EFINVO could not register options: "
+		       "%s\n", strerror ( rc ) );
+		return;
+	}
+}
+
+/** EFI variable-backed non-volatile stored options initialisation function */
+struct init_fn efi_nvo_init_fn __init_fn ( INIT_NORMAL ) = {
+	.initialise = efi_nvo_init,
+};
@@ -247,6 +247,7 @@ int efipci_open ( EFI_HANDLE device, UINT32 attributes,
 	} pci_io;
 	UINTN pci_segment, pci_bus, pci_dev, pci_fn;
 	unsigned int busdevfn;
+	UINT64 supported;
 	EFI_STATUS efirc;
 	int rc;
 
@@ -290,6 +291,24 @@ int efipci_open ( EFI_HANDLE device, UINT32 attributes,
 				    EfiPciIoAttributeOperationEnable,
 				    EFI_PCI_IO_ATTRIBUTE_BUS_MASTER, NULL );
 
+	/* Enable 64-bit (dual address cycle) DMA addressing, if
+	 * supported.  Some platforms will otherwise restrict the
+	 * device to addressing memory below 4GB, forcing the firmware
+	 * to interpose bounce buffers (and so double-copy every
+	 * packet) on machines with memory above that boundary.
+	 */
+	if ( ( efirc = pci_io.pci_io->Attributes (
+			pci_io.pci_io, EfiPciIoAttributeOperationSupported,
+			0, &supported ) ) == 0 ) {
+		if ( supported & EFI_PCI_IO_ATTRIBUTE_DUAL_ADDRESS_CYCLE ) {
+			pci_io.pci_io->Attributes (
+				pci_io.pci_io,
+				EfiPciIoAttributeOperationEnable,
+				EFI_PCI_IO_ATTRIBUTE_DUAL_ADDRESS_CYCLE,
+				NULL );
+		}
+	}
+
 	/* Populate PCI device */
 	if ( ( rc = pci_read_config ( pci ) ) != 0 ) {
 		DBGC ( device, "EFIPCI " PCI_FMT " cannot read PCI "
@@ -782,8 +782,13 @@ efi_snp_receive ( EFI_SIMPLE_NETWORK_PROTOCOL *snp,
 	/* Raise TPL */
 	saved_tpl = bs->RaiseTPL ( TPL_CALLBACK );
 
-	/* Poll the network device */
-	efi_snp_poll ( snpdev );
+	/* Poll the network device, unless packets are already
+	 * queued.  A caller retrieving a burst of packets thereby
+	 * incurs only a single hardware poll, rather than paying for
+	 * one poll per receive call.
+	 */
+	if ( list_empty ( &snpdev->rx ) )
+		efi_snp_poll ( snpdev );
 
 	/* Check for an available packet */
 	iobuf = list_first_entry ( &snpdev->rx, struct io_buffer, list );
@@ -856,6 +861,13 @@ static VOID EFIAPI efi_snp_wait_for_packet ( EFI_EVENT event __unused,
 	if ( efi_snp_claimed )
 		return;
 
+	/* Do nothing if packets are already queued; the event has
+	 * already been signalled, and polling the hardware on every
+	 * event check would only add overhead.
+	 */
+	if ( ! list_empty ( &snpdev->rx ) )
+		return;
+
 	/* Raise TPL */
 	saved_tpl = bs->RaiseTPL ( TPL_CALLBACK );
 
@@ -23,6 +23,7 @@
 
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
@@ -38,6 +39,17 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** Equivalent of NOWHERE for user pointers */
 #define UNOWHERE ( ~UNULL )
 
+/** External memory block metadata
+ *
+ * Stored in the guard page preceding the data region.
+ */
+struct efi_umalloc_metadata {
+	/** Size of the data region */
+	size_t size;
+	/** Number of allocated pages (including the guard page) */
+	size_t pages;
+};
+
 /**
  * Reallocate external memory
  *
@@ -105,4 +117,61 @@ static userptr_t efi_urealloc ( userptr_t old_ptr, size_t new_size ) {
 	return new_ptr;
 }
 
+/**
+ * Estimate available external memory
+ *
+ * @ret avail		Estimated available memory
+ *
+ * Returns the length of the largest contiguous run of conventional
+ * memory, which bounds the largest single AllocatePages() request
+ * that can currently succeed.
+ */
+static size_t efi_umavail ( void ) {
+	EFI_BOOT_SERVICES *bs = efi_systab->BootServices;
+	EFI_MEMORY_DESCRIPTOR *desc;
+	UINT8 *map;
+	UINTN len = 0;
+	UINTN key;
+	UINTN desc_len;
+	UINT32 desc_version;
+	UINT64 largest = 0;
+	UINT64 run;
+	UINTN offset;
+	EFI_STATUS efirc;
+
+	/* Determine length of memory map */
+	efirc = bs->GetMemoryMap ( &len, NULL, &key, &desc_len,
+				   &desc_version );
+	if ( efirc != EFI_BUFFER_TOO_SMALL )
+		return 0;
+
+	/* Allocate space for the memory map, allowing for any
+	 * additional descriptors created by this allocation itself.
+	 */
+	len += ( 4 * desc_len );
+	map = malloc ( len );
+	if ( ! map )
+		return 0;
+
+	/* Retrieve memory map */
+	if ( ( efirc = bs->GetMemoryMap ( &len, ( ( void * ) map ), &key,
+					  &desc_len, &desc_version ) ) != 0 )
+		goto out;
+
+	/* Find largest run of conventional memory */
+	for ( offset = 0 ; offset < len ; offset += desc_len ) {
+		desc = ( ( void * ) ( map + offset ) );
+		if ( desc->Type != EfiConventionalMemory )
+			continue;
+		run = ( desc->NumberOfPages * EFI_PAGE_SIZE );
+		if ( run > largest )
+			largest = run;
+	}
+
+ out:
+	free ( map );
+	return largest;
+}
+
 PROVIDE_UMALLOC ( efi, urealloc, efi_urealloc );
+PROVIDE_UMALLOC ( efi, umavail, efi_umavail );
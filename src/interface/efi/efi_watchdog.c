@@ -34,6 +34,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <string.h>
 #include <ipxe/retry.h>
 #include <ipxe/timer.h>
+#include <ipxe/watchdog.h>
 #include <ipxe/efi/efi.h>
 #include <ipxe/efi/efi_watchdog.h>
 
@@ -50,33 +51,73 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define WATCHDOG_DATA L"iPXE";
 
 /**
- * Hold off watchdog timer
+ * Reset watchdog timer
  *
- * @v retry		Retry timer
- * @v over		Failure indicator
  */
-static void efi_watchdog_expired ( struct retry_timer *timer,
-				   int over __unused ) {
+static void efi_watchdog_reset ( void ) {
 	EFI_BOOT_SERVICES *bs = efi_systab->BootServices;
 	static CHAR16 data[] = WATCHDOG_DATA;
 	EFI_STATUS efirc;
 	int rc;
 
-	DBGC2 ( timer, "EFI holding off watchdog timer\n" );
-
-	/* Restart this holdoff timer */
-	start_timer_fixed ( timer, ( WATCHDOG_HOLDOFF_SECS * TICKS_PER_SEC ) );
-
 	/* Reset watchdog timer */
 	if ( ( efirc = bs->SetWatchdogTimer ( WATCHDOG_TIMEOUT_SECS,
 					      WATCHDOG_CODE, sizeof ( data ),
 					      data ) ) != 0 ) {
 		rc = -EEFI ( efirc );
-		DBGC ( timer, "EFI could not set watchdog timer: %s\n",
-		       strerror ( rc ) );
+		DBGC ( &efi_watchdog, "EFI could not set watchdog timer: "
+		       "%s\n", strerror ( rc ) );
 		return;
 	}
 }
 
+/**
+ * Hold off watchdog timer
+ *
+ * @v retry		Retry timer
+ * @v over		Failure indicator
+ */
+static void efi_watchdog_expired ( struct retry_timer *timer,
+				   int over __unused ) {
+
+	DBGC2 ( timer, "EFI holding off watchdog timer\n" );
+
+	/* Restart this holdoff timer */
+	start_timer_fixed ( timer, ( WATCHDOG_HOLDOFF_SECS * TICKS_PER_SEC ) );
+
+	/* Reset watchdog timer */
+	efi_watchdog_reset();
+}
+
 /** Watchdog holdoff timer */
 struct retry_timer efi_watchdog = TIMER_INIT ( efi_watchdog_expired );
+
+/**
+ * Refresh watchdog timer on download progress
+ *
+ * Called from the download data path, so that the watchdog is held
+ * off based on demonstrable forward progress even if timer servicing
+ * is starved (for example, while the network is being polled from a
+ * firmware context that bypasses our main poll loop).
+ */
+void watchdog_refresh ( void ) {
+	static unsigned long last;
+	unsigned long now;
+
+	/* Do nothing unless watchdog management is active */
+	if ( ! timer_running ( &efi_watchdog ) )
+		return;
+
+	/* Rate-limit refreshes to the holdoff interval */
+	now = currticks();
+	if ( ( now - last ) < ( WATCHDOG_HOLDOFF_SECS * TICKS_PER_SEC ) )
+		return;
+	last = now;
+
+	DBGC2 ( &efi_watchdog, "EFI refreshing watchdog timer\n" );
+
+	/* Restart holdoff timer and reset watchdog timer */
+	start_timer_fixed ( &efi_watchdog,
+			    ( WATCHDOG_HOLDOFF_SECS * TICKS_PER_SEC ) );
+	efi_watchdog_reset();
+}
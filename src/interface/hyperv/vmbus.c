@@ -498,6 +498,12 @@ int vmbus_open ( struct vmbus_device *vmdev,
 	vmdev->mtu = mtu;
 	vmdev->packet = packet;
 
+	/* Mask inbound interrupts.  We only ever poll the inbound
+	 * ring, so there is no need for the host to pay the cost of
+	 * signalling us for each packet that it produces.
+	 */
+	vmdev->in->intr_mask = cpu_to_le32 ( 1 );
+
 	DBGC ( vmdev, "VMBUS %s channel GPADL %#08x ring "
 		"[%#08lx,%#08lx,%#08lx)\n", vmdev->dev.name, vmdev->gpadl,
 		virt_to_phys ( vmdev->out ), virt_to_phys ( vmdev->in ),
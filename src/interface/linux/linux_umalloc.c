@@ -151,4 +151,18 @@ static userptr_t linux_urealloc(userptr_t old_ptr, size_t new_size)
 	return (userptr_t)linux_realloc((void *)old_ptr, new_size);
 }
 
+/**
+ * Estimate available external memory
+ *
+ * @ret avail		Estimated available memory
+ *
+ * Allocations are backed by mmap() and so are effectively unbounded;
+ * no meaningful estimate exists.
+ */
+static size_t linux_umavail(void)
+{
+	return -1UL;
+}
+
 PROVIDE_UMALLOC(linux, urealloc, linux_urealloc);
+PROVIDE_UMALLOC(linux, umavail, linux_umavail);
@@ -24,6 +24,7 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
@@ -41,6 +42,12 @@ static struct smbios smbios = {
 	.address = UNULL,
 };
 
+/** Cached SMBIOS structure descriptors */
+static struct smbios_structure *smbios_index;
+
+/** Number of cached SMBIOS structure descriptors */
+static unsigned int smbios_index_count;
+
 /**
  * Scan for SMBIOS entry point structure
  *
@@ -108,32 +115,32 @@ static size_t find_strings_terminator ( size_t offset ) {
 }
 
 /**
- * Find specific structure type within SMBIOS
+ * Build index of SMBIOS structure descriptors
  *
- * @v type		Structure type to search for
- * @v instance		Instance of this type of structure
- * @v structure		SMBIOS structure descriptor to fill in
  * @ret rc		Return status code
+ *
+ * Walking the structure table requires a scan through physical memory
+ * (including a byte-by-byte search for each strings terminator).  Do
+ * this walk exactly once, recording a descriptor for each structure,
+ * so that subsequent lookups are in-RAM array searches.
  */
-int find_smbios_structure ( unsigned int type, unsigned int instance,
-			    struct smbios_structure *structure ) {
-	unsigned int count = 0;
+static int smbios_build_index ( void ) {
+	struct smbios_structure *structure;
 	size_t offset = 0;
 	size_t strings_offset;
 	size_t terminator_offset;
-	int rc;
 
-	/* Find SMBIOS */
-	if ( ( smbios.address == UNULL ) &&
-	     ( ( rc = find_smbios ( &smbios ) ) != 0 ) )
-		return rc;
-	assert ( smbios.address != UNULL );
+	/* Allocate space for maximum possible number of structures */
+	smbios_index = malloc ( smbios.count * sizeof ( *smbios_index ) );
+	if ( ! smbios_index )
+		return -ENOMEM;
 
 	/* Scan through list of structures */
 	while ( ( ( offset + sizeof ( structure->header ) ) < smbios.len )
-		&& ( count < smbios.count ) ) {
+		&& ( smbios_index_count < smbios.count ) ) {
 
 		/* Read next SMBIOS structure header */
+		structure = &smbios_index[smbios_index_count];
 		copy_from_user ( &structure->header, smbios.address, offset,
 				 sizeof ( structure->header ) );
 
@@ -143,30 +150,62 @@ int find_smbios_structure ( unsigned int type, unsigned int instance,
 			DBG ( "SMBIOS structure at offset %zx with length "
 			      "%x extends beyond SMBIOS\n", offset,
 			      structure->header.len );
-			return -ENOENT;
+			break;
 		}
 		terminator_offset = find_strings_terminator ( strings_offset );
 		if ( ! terminator_offset ) {
 			DBG ( "SMBIOS structure at offset %zx has "
 			      "unterminated strings section\n", offset );
-			return -ENOENT;
+			break;
 		}
 		structure->strings_len = ( terminator_offset - strings_offset);
+		structure->offset = offset;
 
 		DBG ( "SMBIOS structure at offset %zx has type %d, length %x, "
 		      "strings length %zx\n", offset, structure->header.type,
 		      structure->header.len, structure->strings_len );
 
+		/* Move to next SMBIOS structure */
+		offset = ( terminator_offset + 1 );
+		smbios_index_count++;
+	}
+
+	return 0;
+}
+
+/**
+ * Find specific structure type within SMBIOS
+ *
+ * @v type		Structure type to search for
+ * @v instance		Instance of this type of structure
+ * @v structure		SMBIOS structure descriptor to fill in
+ * @ret rc		Return status code
+ */
+int find_smbios_structure ( unsigned int type, unsigned int instance,
+			    struct smbios_structure *structure ) {
+	unsigned int i;
+	int rc;
+
+	/* Find SMBIOS */
+	if ( ( smbios.address == UNULL ) &&
+	     ( ( rc = find_smbios ( &smbios ) ) != 0 ) )
+		return rc;
+	assert ( smbios.address != UNULL );
+
+	/* Build structure index, if not already built */
+	if ( ( ! smbios_index ) && ( ( rc = smbios_build_index() ) != 0 ) )
+		return rc;
+
+	/* Search through index of structures */
+	for ( i = 0 ; i < smbios_index_count ; i++ ) {
+
 		/* If this is the structure we want, return */
-		if ( ( structure->header.type == type ) &&
+		if ( ( smbios_index[i].header.type == type ) &&
 		     ( instance-- == 0 ) ) {
-			structure->offset = offset;
+			memcpy ( structure, &smbios_index[i],
+				 sizeof ( *structure ) );
 			return 0;
 		}
-
-		/* Move to next SMBIOS structure */
-		offset = ( terminator_offset + 1 );
-		count++;
 	}
 
 	DBG ( "SMBIOS structure type %d not found\n", type );
@@ -82,6 +82,12 @@ FILE_LICENCE ( GPL2_OR_LATER );
  * To avoid staying at 1Mbps for a long time, we don't track any
  * transmitted packets until we've set our rate based on received
  * packets.
+ *
+ * To climb away from low rates quickly, upward probes are made in
+ * exponentially growing steps so long as each probe succeeds; any
+ * setback resets the step size to one.  This lets us reach the top
+ * usable rate within a handful of probe cycles instead of stepping
+ * through every intermediate rate.
  */
 
 /** Two-bit packet status indicator for a packet with no retries */
@@ -143,6 +149,9 @@ struct rc80211_ctx
 
 	/** Counter of all packets sent and received */
 	int packets;
+
+	/** Current upward probe step size */
+	int step;
 };
 
 /**
@@ -154,6 +163,8 @@ struct rc80211_ctx
 struct rc80211_ctx * rc80211_init ( struct net80211_device *dev __unused )
 {
 	struct rc80211_ctx *ret = zalloc ( sizeof ( *ret ) );
+	if ( ret )
+		ret->step = 1;
 	return ret;
 }
 
@@ -259,15 +270,27 @@ static void rc80211_maybe_set_new ( struct net80211_device *dev )
 		return;
 
 	if ( net_good > RC_GOODNESS_MAX && dev->rate + 1 < dev->nr_rates ) {
-		int higher = rc80211_calc_net_goodness ( ctx, dev->rate + 1 );
-		if ( higher > net_good || higher < 0 )
-			rc80211_set_rate ( dev, dev->rate + 1 );
-		else
+		int probe = dev->rate + ctx->step;
+		int higher;
+
+		if ( probe >= dev->nr_rates )
+			probe = dev->nr_rates - 1;
+
+		higher = rc80211_calc_net_goodness ( ctx, probe );
+		if ( higher > net_good || higher < 0 ) {
+			rc80211_set_rate ( dev, probe );
+			/* Probe succeeded; grow the step for next time */
+			if ( ctx->step < dev->nr_rates )
+				ctx->step *= 2;
+		} else {
 			rc80211_set_rate ( dev, rc80211_pick_best ( dev ) );
+			ctx->step = 1;
+		}
 	}
 
 	if ( net_good < RC_GOODNESS_MIN ) {
 		rc80211_set_rate ( dev, rc80211_pick_best ( dev ) );
+		ctx->step = 1;
 	}
 }
 
@@ -337,6 +360,7 @@ void rc80211_update_tx ( struct net80211_device *dev, int retries, int rc )
 			       RC_TX_EMERG_FAIL );
 
 			rc80211_set_rate ( dev, dev->rate - 1 );
+			ctx->step = 1;
 		}
 	}
 }
@@ -55,6 +55,13 @@ FEATURE ( FEATURE_PROTOCOL, "AoE", DHCP_EB_FEATURE_AOE, 1 );
 struct net_protocol aoe_protocol __net_protocol;
 struct acpi_model abft_model __acpi_model;
 
+/** Maximum congestion window
+ *
+ * This limits the number of outstanding commands, regardless of the
+ * buffer count advertised by the target.
+ */
+#define AOE_MAX_CWND 16
+
 /******************************************************************************
  *
  * AoE devices and commands
@@ -88,6 +95,16 @@ struct aoe_device {
 	/** Saved timeout value */
 	unsigned long timeout;
 
+	/** Number of outstanding commands */
+	unsigned int pending;
+	/** Congestion window (maximum number of outstanding commands) */
+	unsigned int cwnd;
+	/** Maximum congestion window
+	 *
+	 * This is limited by the target's advertised buffer count.
+	 */
+	unsigned int max_cwnd;
+
 	/** Configuration command interface */
 	struct interface config;
 	/** Device is configued */
@@ -243,6 +260,9 @@ static void aoecmd_close ( struct aoe_command *aoecmd, int rc ) {
 	if ( ! list_empty ( &aoecmd->list ) ) {
 		list_del ( &aoecmd->list );
 		INIT_LIST_HEAD ( &aoecmd->list );
+		assert ( aoedev->pending > 0 );
+		aoedev->pending--;
+		xfer_window_changed ( &aoedev->ata );
 		aoecmd_put ( aoecmd );
 	}
 
@@ -347,6 +367,10 @@ static int aoecmd_rx ( struct aoe_command *aoecmd, struct io_buffer *iobuf,
 					ll_source ) ) != 0 )
 		goto done;
 
+	/* Grow congestion window additively on successful completion */
+	if ( aoedev->cwnd < aoedev->max_cwnd )
+		aoedev->cwnd++;
+
  done:
 	/* Free I/O buffer */
 	free_iob ( iobuf );
@@ -370,6 +394,8 @@ static void aoecmd_expired ( struct retry_timer *timer, int fail ) {
 	if ( fail ) {
 		aoecmd_close ( aoecmd, -ETIMEDOUT );
 	} else {
+		/* Shrink congestion window multiplicatively on loss */
+		aoecmd->aoedev->cwnd = ( ( aoecmd->aoedev->cwnd + 1 ) / 2 );
 		aoecmd_tx ( aoecmd );
 	}
 }
@@ -559,6 +585,12 @@ static int aoecmd_cfg_rsp ( struct aoe_command *aoecmd, const void *data,
 	DBGC ( aoedev, "AoE %s has MAC address %s\n",
 	       aoedev_name ( aoedev ), ll_protocol->ntoa ( aoedev->target ) );
 
+	/* Limit congestion window by target's advertised buffer count */
+	if ( ntohs ( aoecfg->bufcnt ) &&
+	     ( ntohs ( aoecfg->bufcnt ) < aoedev->max_cwnd ) ) {
+		aoedev->max_cwnd = ntohs ( aoecfg->bufcnt );
+	}
+
 	return 0;
 }
 
@@ -634,6 +666,7 @@ static struct aoe_command * aoecmd_create ( struct aoe_device *aoedev,
 		return NULL;
 	ref_init ( &aoecmd->refcnt, aoecmd_free );
 	list_add ( &aoecmd->list, &aoe_commands );
+	aoedev->pending++;
 	intf_init ( &aoecmd->ata, &aoecmd_ata_desc, &aoecmd->refcnt );
 	timer_init ( &aoecmd->timer, aoecmd_expired, &aoecmd->refcnt );
 	aoecmd->aoedev = aoedev_get ( aoedev );
@@ -758,7 +791,8 @@ static void aoedev_close ( struct aoe_device *aoedev, int rc ) {
  * @ret len		Length of window
  */
 static size_t aoedev_window ( struct aoe_device *aoedev ) {
-	return ( aoedev->configured ? ~( ( size_t ) 0 ) : 0 );
+	return ( ( aoedev->configured && ( aoedev->pending < aoedev->cwnd ) ) ?
+		 ~( ( size_t ) 0 ) : 0 );
 }
 
 /**
@@ -852,6 +886,8 @@ static int aoedev_open ( struct interface *parent, struct net_device *netdev,
 	aoedev->netdev = netdev_get ( netdev );
 	aoedev->major = major;
 	aoedev->minor = minor;
+	aoedev->cwnd = 1;
+	aoedev->max_cwnd = AOE_MAX_CWND;
 	memcpy ( aoedev->target, netdev->ll_broadcast,
 		 netdev->ll_protocol->ll_addr_len );
 	acpi_init ( &aoedev->desc, &abft_model, &aoedev->refcnt );
@@ -113,11 +113,23 @@ struct neighbour_discovery arp_discovery = {
  *
  */
 static struct arp_net_protocol * arp_find_protocol ( uint16_t net_proto ) {
+	static struct arp_net_protocol *cache;
 	struct arp_net_protocol *arp_net_protocol;
 
+	/* Try the most recently used protocol first; in practice
+	 * only a single protocol (IPv4) uses ARP.
+	 */
+	arp_net_protocol = cache;
+	if ( arp_net_protocol &&
+	     ( arp_net_protocol->net_protocol->net_proto == net_proto ) )
+		return arp_net_protocol;
+
+	/* Scan through the compiled-in protocols */
 	for_each_table_entry ( arp_net_protocol, ARP_NET_PROTOCOLS ) {
-		if ( arp_net_protocol->net_protocol->net_proto == net_proto )
+		if ( arp_net_protocol->net_protocol->net_proto == net_proto ) {
+			cache = arp_net_protocol;
 			return arp_net_protocol;
+		}
 	}
 	return NULL;
 }
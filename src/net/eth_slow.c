@@ -48,6 +48,28 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 struct net_protocol eth_slow_protocol __net_protocol;
 
+/** Minimum interval between LACP responses
+ *
+ * Trunk ports generate constant LACP chatter, and bursts may deliver
+ * several packets within a single poll.  One response per holdoff
+ * interval is sufficient to keep the aggregation alive, since even a
+ * fast-rate partner expects a reply only once per second.
+ */
+#define LACP_RESPONSE_HOLDOFF ( TICKS_PER_SEC / 2 )
+
+/** LACP response suppression state */
+struct eth_slow_lacp_response {
+	/** Network device of most recent response */
+	struct net_device *netdev;
+	/** Partner state at most recent response */
+	uint8_t state;
+	/** Time of most recent response */
+	unsigned long last;
+};
+
+/** Most recent LACP response */
+static struct eth_slow_lacp_response eth_slow_lacp_response;
+
 /** Slow protocols multicast address */
 static const uint8_t eth_slow_address[ETH_ALEN] =
 	{ 0x01, 0x80, 0xc2, 0x00, 0x00, 0x02 };
@@ -149,6 +171,7 @@ static int eth_slow_lacp_rx ( struct io_buffer *iobuf,
 			      struct net_device *netdev ) {
 	union eth_slow_packet *eth_slow = iobuf->data;
 	struct eth_slow_lacp *lacp = &eth_slow->lacp;
+	struct eth_slow_lacp_response *response;
 	unsigned int interval;
 
 	eth_slow_lacp_dump ( iobuf, netdev, "RX" );
@@ -173,6 +196,21 @@ static int eth_slow_lacp_rx ( struct io_buffer *iobuf,
 		netdev_link_unblock ( netdev );
 	}
 
+	/* Suppress response if we have recently responded to this
+	 * partner with identical state, batching bursts of LACP
+	 * packets into a single response.
+	 */
+	response = &eth_slow_lacp_response;
+	if ( ( response->netdev == netdev ) &&
+	     ( response->state == lacp->actor.state ) &&
+	     ( ( currticks() - response->last ) < LACP_RESPONSE_HOLDOFF ) ) {
+		free_iob ( iobuf );
+		return 0;
+	}
+	response->netdev = netdev;
+	response->state = lacp->actor.state;
+	response->last = currticks();
+
 	/* Build response */
 	memset ( lacp->reserved, 0, sizeof ( lacp->reserved ) );
 	memset ( &lacp->terminator, 0, sizeof ( lacp->terminator ) );
@@ -35,6 +35,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/in.h>
 #include <ipxe/netdevice.h>
 #include <ipxe/iobuf.h>
+#include <ipxe/stp.h>
 #include <ipxe/ethernet.h>
 
 /** @file
@@ -138,6 +139,15 @@ int eth_pull ( struct net_device *netdev __unused, struct io_buffer *iobuf,
 		*net_proto = *llc_proto;
 	}
 
+	/* Classify link-layer control frames (LACP and STP) so that
+	 * they can be diverted for expedited handling: on trunk ports
+	 * these arrive constantly.
+	 */
+	if ( ( *net_proto == htons ( ETH_P_SLOW ) ) ||
+	     ( *net_proto == htons ( ETH_P_STP ) ) ) {
+		*flags |= LL_CONTROL;
+	}
+
 	return 0;
 }
 
@@ -28,6 +28,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
+#include <assert.h>
 #include <ipxe/settings.h>
 #include <ipxe/netdevice.h>
 #include <ipxe/dhcppkt.h>
@@ -39,49 +40,65 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/** Maximum number of options in a fake DHCP packet
+ *
+ * This allows for every option at the top level and within each of
+ * the two encapsulated option spaces.
+ */
+#define FAKEDHCP_MAX_FETCH \
+	( 3 * ( DHCP_MAX_OPTION - DHCP_MIN_OPTION + 1 ) )
+
+/** A cached fake DHCP packet
+ *
+ * Constructing a fake DHCP packet requires fetching several hundred
+ * candidate options, and chainloaded NBPs (e.g. wdsnbp.com) tend to
+ * request the same fake packet repeatedly.  We therefore cache the
+ * constructed packet, and rebuild it only when the settings from
+ * which it was constructed may have changed.
+ */
+struct fakedhcp_cache {
+	/** Network device for which packet was constructed */
+	struct net_device *netdev;
+	/** Settings generation at which packet was constructed */
+	unsigned int generation;
+	/** DHCP transaction ID used in constructed packet */
+	uint32_t xid;
+	/** Length of cached packet, or zero if cache is empty */
+	size_t len;
+	/** Cached packet */
+	uint8_t data[DHCP_MIN_LEN];
+};
+
 /**
- * Copy settings to DHCP packet
+ * Build list of candidate options to copy to a fake DHCP packet
  *
- * @v dest		Destination DHCP packet
- * @v source		Source settings block
+ * @v fetches		Bulk fetch list to fill in
  * @v encapsulator	Encapsulating setting tag number, or zero
- * @ret rc		Return status code
+ * @ret count		Number of entries filled in
  */
-static int copy_encap_settings ( struct dhcp_packet *dest,
-				 struct settings *source,
-				 unsigned int encapsulator ) {
-	struct setting setting = { .name = "" };
+static unsigned int fakedhcp_fetch_list ( struct settings_fetch *fetches,
+					  unsigned int encapsulator ) {
+	unsigned int count = 0;
 	unsigned int subtag;
 	unsigned int tag;
-	void *data;
-	int len;
-	int rc;
 
 	for ( subtag = DHCP_MIN_OPTION; subtag <= DHCP_MAX_OPTION; subtag++ ) {
 		tag = DHCP_ENCAP_OPT ( encapsulator, subtag );
 		switch ( tag ) {
 		case DHCP_EB_ENCAP:
 		case DHCP_VENDOR_ENCAP:
-			/* Process encapsulated settings */
-			if ( ( rc = copy_encap_settings ( dest, source,
-							  tag ) ) != 0 )
-				return rc;
+			/* List encapsulated settings */
+			count += fakedhcp_fetch_list ( &fetches[count], tag );
 			break;
 		default:
-			/* Copy setting, if present */
-			setting.tag = tag;
-			len = fetch_raw_setting_copy ( source, &setting, &data);
-			if ( len >= 0 ) {
-				rc = dhcppkt_store ( dest, tag, data, len );
-				free ( data );
-				if ( rc != 0 )
-					return rc;
-			}
+			fetches[count].setting.name = "";
+			fetches[count].setting.tag = tag;
+			count++;
 			break;
 		}
 	}
 
-	return 0;
+	return count;
 }
 
 /**
@@ -93,7 +110,94 @@ static int copy_encap_settings ( struct dhcp_packet *dest,
  */
 static int copy_settings ( struct dhcp_packet *dest,
 			   struct settings *source ) {
-	return copy_encap_settings ( dest, source, 0 );
+	struct settings_fetch *fetches;
+	struct settings_fetch *fetch;
+	unsigned int count;
+	unsigned int i;
+	int rc = 0;
+
+	/* Build list of candidate options */
+	fetches = zalloc ( FAKEDHCP_MAX_FETCH * sizeof ( *fetches ) );
+	if ( ! fetches )
+		return -ENOMEM;
+	count = fakedhcp_fetch_list ( fetches, 0 );
+	assert ( count <= FAKEDHCP_MAX_FETCH );
+
+	/* Fetch all present options in a single hierarchy traversal */
+	fetch_raw_setting_bulk ( source, fetches, count );
+
+	/* Copy fetched options to DHCP packet */
+	for ( i = 0 ; i < count ; i++ ) {
+		fetch = &fetches[i];
+		if ( fetch->len < 0 )
+			continue;
+		if ( ( rc = dhcppkt_store ( dest, fetch->setting.tag,
+					    fetch->data, fetch->len ) ) != 0 )
+			break;
+	}
+
+	/* Free fetched options */
+	for ( i = 0 ; i < count ; i++ )
+		free ( fetches[i].data );
+	free ( fetches );
+
+	return rc;
+}
+
+/**
+ * Retrieve cached fake DHCP packet, if still valid
+ *
+ * @v cache		Fake DHCP packet cache
+ * @v netdev		Network device
+ * @v data		Buffer for DHCP packet
+ * @v max_len		Size of DHCP packet buffer
+ * @ret cached		Packet was retrieved from cache
+ */
+static int fakedhcp_cache_fetch ( struct fakedhcp_cache *cache,
+				  struct net_device *netdev,
+				  void *data, size_t max_len ) {
+
+	/* Check that cached packet exists, was constructed for this
+	 * network device from the current settings, and fits within
+	 * the caller's buffer.
+	 */
+	if ( ( cache->len == 0 ) ||
+	     ( cache->netdev != netdev ) ||
+	     ( cache->generation != settings_generation ) ||
+	     ( cache->xid != dhcp_last_xid ) ||
+	     ( cache->len > max_len ) )
+		return 0;
+
+	/* Copy cached packet */
+	memset ( data, 0, max_len );
+	memcpy ( data, cache->data, cache->len );
+	return 1;
+}
+
+/**
+ * Record constructed fake DHCP packet in cache
+ *
+ * @v cache		Fake DHCP packet cache
+ * @v netdev		Network device
+ * @v dhcppkt		Constructed DHCP packet
+ */
+static void fakedhcp_cache_store ( struct fakedhcp_cache *cache,
+				   struct net_device *netdev,
+				   struct dhcp_packet *dhcppkt ) {
+	size_t len = dhcppkt_len ( dhcppkt );
+
+	/* Refuse to cache oversized packets */
+	if ( len > sizeof ( cache->data ) ) {
+		cache->len = 0;
+		return;
+	}
+
+	/* Record packet */
+	cache->netdev = netdev;
+	cache->generation = settings_generation;
+	cache->xid = dhcp_last_xid;
+	cache->len = len;
+	memcpy ( cache->data, dhcppkt->dhcphdr, len );
 }
 
 /**
@@ -135,9 +239,14 @@ int create_fakedhcpdiscover ( struct net_device *netdev,
  */
 int create_fakedhcpack ( struct net_device *netdev,
 			 void *data, size_t max_len ) {
+	static struct fakedhcp_cache cache;
 	struct dhcp_packet dhcppkt;
 	int rc;
 
+	/* Use cached packet, if still valid */
+	if ( fakedhcp_cache_fetch ( &cache, netdev, data, max_len ) )
+		return 0;
+
 	/* Create base DHCPACK packet */
 	if ( ( rc = dhcp_create_packet ( &dhcppkt, netdev, DHCPACK,
 					 dhcp_last_xid, NULL, 0,
@@ -162,6 +271,9 @@ int create_fakedhcpack ( struct net_device *netdev,
 		return rc;
 	}
 
+	/* Cache constructed packet */
+	fakedhcp_cache_store ( &cache, netdev, &dhcppkt );
+
 	return 0;
 }
 
@@ -177,6 +289,7 @@ int create_fakedhcpack ( struct net_device *netdev,
  */
 int create_fakepxebsack ( struct net_device *netdev,
 			  void *data, size_t max_len ) {
+	static struct fakedhcp_cache cache;
 	struct dhcp_packet dhcppkt;
 	struct settings *proxy_settings;
 	struct settings *pxebs_settings;
@@ -190,6 +303,10 @@ int create_fakepxebsack ( struct net_device *netdev,
 		return create_fakedhcpack ( netdev, data, max_len );
 	}
 
+	/* Use cached packet, if still valid */
+	if ( fakedhcp_cache_fetch ( &cache, netdev, data, max_len ) )
+		return 0;
+
 	/* Create base DHCPACK packet */
 	if ( ( rc = dhcp_create_packet ( &dhcppkt, netdev, DHCPACK,
 					 dhcp_last_xid, NULL, 0,
@@ -219,5 +336,8 @@ int create_fakepxebsack ( struct net_device *netdev,
 		return rc;
 	}
 
+	/* Cache constructed packet */
+	fakedhcp_cache_store ( &cache, netdev, &dhcppkt );
+
 	return 0;
 }
@@ -327,6 +327,9 @@ enum fc_exchange_flags {
 /** Fibre Channel timeout */
 #define FC_TIMEOUT ( 1 * TICKS_PER_SEC )
 
+/** Maximum burst length for a single multi-frame sequence */
+#define FC_MAX_BURST_LEN 8192
+
 /**
  * Create local Fibre Channel exchange identifier
  *
@@ -414,16 +417,46 @@ static void fc_xchg_expired ( struct retry_timer *timer, int over __unused ) {
 	fc_xchg_close ( xchg, -ETIMEDOUT );
 }
 
+/**
+ * Determine Fibre Channel exchange maximum frame payload
+ *
+ * @v xchg		Fibre Channel exchange
+ * @ret mtu		Maximum data field size per frame
+ */
+static size_t fc_xchg_mtu ( struct fc_exchange *xchg ) {
+	struct fc_peer *peer;
+	size_t mtu = FC_LOGIN_DEFAULT_MTU;
+
+	/* Use maximum receive data field size negotiated at login, if
+	 * available.
+	 */
+	peer = fc_peer_get_port_id ( xchg->port, &xchg->peer_port_id );
+	if ( peer ) {
+		if ( peer->mtu )
+			mtu = peer->mtu;
+		fc_peer_put ( peer );
+	}
+
+	return mtu;
+}
+
 /**
  * Check Fibre Channel exchange window
  *
  * @v xchg		Fibre Channel exchange
  * @ret len		Length opf window
  */
-static size_t fc_xchg_window ( struct fc_exchange *xchg __unused ) {
+static size_t fc_xchg_window ( struct fc_exchange *xchg ) {
+	size_t mtu = fc_xchg_mtu ( xchg );
+	unsigned int frames;
 
-	/* We don't currently store the path MTU */
-	return FC_LOGIN_DEFAULT_MTU;
+	/* Allow for a multi-frame sequence of up to the maximum burst
+	 * length, in whole frames.
+	 */
+	frames = ( FC_MAX_BURST_LEN / mtu );
+	if ( ! frames )
+		frames = 1;
+	return ( frames * mtu );
 }
 
 /**
@@ -446,6 +479,71 @@ static struct io_buffer * fc_xchg_alloc_iob ( struct fc_exchange *xchg,
 	return iobuf;
 }
 
+/**
+ * Transmit a single frame as part of a Fibre Channel exchange
+ *
+ * @v xchg		Fibre Channel exchange
+ * @v iobuf		I/O buffer
+ * @v dest_id		Destination port ID (if not the exchange peer)
+ * @v r_ctl		Routing control
+ * @v f_ctl_es		Exchange and sequence control
+ * @v rel_off		Relative offset is present
+ * @v offset		Relative offset
+ * @ret rc		Return status code
+ *
+ * This function takes ownership of the I/O buffer.
+ */
+static int fc_xchg_tx_frame ( struct fc_exchange *xchg,
+			      struct io_buffer *iobuf,
+			      struct fc_port_id *dest_id, unsigned int r_ctl,
+			      unsigned int f_ctl_es, int rel_off,
+			      uint32_t offset ) {
+	struct fc_port *port = xchg->port;
+	struct fc_frame_header *fchdr;
+	int rc;
+
+	/* Create frame header */
+	fchdr = iob_push ( iobuf, sizeof ( *fchdr ) );
+	memset ( fchdr, 0, sizeof ( *fchdr ) );
+	fchdr->r_ctl = r_ctl;
+	memcpy ( &fchdr->d_id, ( dest_id ? dest_id : &xchg->peer_port_id ),
+		 sizeof ( fchdr->d_id ) );
+	memcpy ( &fchdr->s_id, &port->port_id, sizeof ( fchdr->s_id ) );
+	fchdr->type = xchg->type;
+	fchdr->f_ctl_es = f_ctl_es;
+	fchdr->seq_id = xchg->seq_id;
+	fchdr->seq_cnt = htons ( xchg->seq_cnt++ );
+	fchdr->ox_id = htons ( ( xchg->flags & FC_XCHG_ORIGINATOR ) ?
+			       xchg->xchg_id : xchg->peer_xchg_id );
+	fchdr->rx_id = htons ( ( xchg->flags & FC_XCHG_ORIGINATOR ) ?
+			       xchg->peer_xchg_id : xchg->xchg_id );
+	if ( rel_off ) {
+		fchdr->f_ctl_misc |= FC_F_CTL_MISC_REL_OFF;
+		fchdr->parameter = htonl ( offset );
+	}
+
+	/* Relinquish sequence initiative if applicable */
+	if ( f_ctl_es & FC_F_CTL_ES_TRANSFER ) {
+		xchg->flags &= ~( FC_XCHG_SEQ_INITIATIVE | FC_XCHG_SEQ_FIRST );
+		xchg->seq_cnt = 0;
+	}
+
+	/* Reset timeout */
+	start_timer_fixed ( &xchg->timer, FC_TIMEOUT );
+
+	/* Deliver frame */
+	if ( ( rc = xfer_deliver_iob ( &port->transport,
+				       iob_disown ( iobuf ) ) ) != 0 ) {
+		DBGC ( port, "FCXCHG %s/%04x cannot transmit: %s\n",
+		       port->name, xchg->xchg_id, strerror ( rc ) );
+		goto done;
+	}
+
+ done:
+	free_iob ( iobuf );
+	return rc;
+}
+
 /**
  * Transmit data as part of a Fibre Channel exchange
  *
@@ -458,9 +556,13 @@ static int fc_xchg_tx ( struct fc_exchange *xchg, struct io_buffer *iobuf,
 			struct xfer_metadata *meta ) {
 	struct fc_port *port = xchg->port;
 	struct sockaddr_fc *dest = ( ( struct sockaddr_fc * ) meta->dest );
-	struct fc_frame_header *fchdr;
+	struct fc_port_id *dest_id;
+	struct io_buffer *frag;
 	unsigned int r_ctl;
 	unsigned int f_ctl_es;
+	uint32_t offset;
+	size_t mtu;
+	int rel_off;
 	int rc;
 
 	/* Sanity checks */
@@ -469,7 +571,7 @@ static int fc_xchg_tx ( struct fc_exchange *xchg, struct io_buffer *iobuf,
 		       "holding sequence initiative\n",
 		       port->name, xchg->xchg_id );
 		rc = -EBUSY;
-		goto done;
+		goto err;
 	}
 
 	/* Calculate routing control */
@@ -521,45 +623,39 @@ static int fc_xchg_tx ( struct fc_exchange *xchg, struct io_buffer *iobuf,
 	if ( meta->flags & XFER_FL_OVER )
 		f_ctl_es |= ( FC_F_CTL_ES_END | FC_F_CTL_ES_TRANSFER );
 
-	/* Create frame header */
-	fchdr = iob_push ( iobuf, sizeof ( *fchdr ) );
-	memset ( fchdr, 0, sizeof ( *fchdr ) );
-	fchdr->r_ctl = r_ctl;
-	memcpy ( &fchdr->d_id,
-		 ( dest ? &dest->sfc_port_id : &xchg->peer_port_id ),
-		 sizeof ( fchdr->d_id ) );
-	memcpy ( &fchdr->s_id, &port->port_id, sizeof ( fchdr->s_id ) );
-	fchdr->type = xchg->type;
-	fchdr->f_ctl_es = f_ctl_es;
-	fchdr->seq_id = xchg->seq_id;
-	fchdr->seq_cnt = htons ( xchg->seq_cnt++ );
-	fchdr->ox_id = htons ( ( xchg->flags & FC_XCHG_ORIGINATOR ) ?
-			       xchg->xchg_id : xchg->peer_xchg_id );
-	fchdr->rx_id = htons ( ( xchg->flags & FC_XCHG_ORIGINATOR ) ?
-			       xchg->peer_xchg_id : xchg->xchg_id );
-	if ( meta->flags & XFER_FL_ABS_OFFSET ) {
-		fchdr->f_ctl_misc |= FC_F_CTL_MISC_REL_OFF;
-		fchdr->parameter = htonl ( meta->offset );
-	}
+	/* Determine destination and relative offset */
+	dest_id = ( dest ? &dest->sfc_port_id : NULL );
+	rel_off = ( meta->flags & XFER_FL_ABS_OFFSET );
+	offset = meta->offset;
 
-	/* Relinquish sequence initiative if applicable */
-	if ( meta->flags & XFER_FL_OVER ) {
-		xchg->flags &= ~( FC_XCHG_SEQ_INITIATIVE | FC_XCHG_SEQ_FIRST );
-		xchg->seq_cnt = 0;
+	/* Fragment data exceeding the path MTU into a multi-frame
+	 * sequence.  All frames except the last carry no
+	 * end-of-sequence bits.
+	 */
+	mtu = fc_xchg_mtu ( xchg );
+	while ( iob_len ( iobuf ) > mtu ) {
+		frag = fc_xchg_alloc_iob ( xchg, mtu );
+		if ( ! frag ) {
+			rc = -ENOMEM;
+			goto err;
+		}
+		memcpy ( iob_put ( frag, mtu ), iobuf->data, mtu );
+		iob_pull ( iobuf, mtu );
+		if ( ( rc = fc_xchg_tx_frame ( xchg, frag, dest_id, r_ctl,
+					       ( f_ctl_es &
+						 ~( FC_F_CTL_ES_END |
+						    FC_F_CTL_ES_LAST |
+						    FC_F_CTL_ES_TRANSFER ) ),
+					       rel_off, offset ) ) != 0 )
+			goto err;
+		offset += mtu;
 	}
 
-	/* Reset timeout */
-	start_timer_fixed ( &xchg->timer, FC_TIMEOUT );
-
-	/* Deliver frame */
-	if ( ( rc = xfer_deliver_iob ( &port->transport,
-				       iob_disown ( iobuf ) ) ) != 0 ) {
-		DBGC ( port, "FCXCHG %s/%04x cannot transmit: %s\n",
-		       port->name, xchg->xchg_id, strerror ( rc ) );
-		goto done;
-	}
+	/* Transmit final (or only) frame of the sequence */
+	return fc_xchg_tx_frame ( xchg, iob_disown ( iobuf ), dest_id, r_ctl,
+				  f_ctl_es, rel_off, offset );
 
- done:
+ err:
 	free_iob ( iobuf );
 	return rc;
 }
@@ -868,7 +964,7 @@ static int fc_port_deliver ( struct fc_port *port, struct io_buffer *iobuf,
 		DBGC ( port, "FCPORT %s received underlength frame (%zd "
 		       "bytes)\n", port->name, iob_len ( iobuf ) );
 		rc = -EINVAL;
-		goto err_sanity;
+		goto err;
 	}
 
 	/* Verify local port ID */
@@ -923,7 +1019,7 @@ static int fc_port_deliver ( struct fc_port *port, struct io_buffer *iobuf,
  err_no_xchg:
  err_respond:
  err_port_id:
- err_sanity:
+ err:
 	free_iob ( iobuf );
 	return rc;
 }
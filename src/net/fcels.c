@@ -676,6 +676,13 @@ static int fc_els_plogi_rx ( struct fc_els *els, void *data, size_t len ) {
 		goto err_login;
 	}
 
+	/* Record negotiated maximum receive data field size */
+	peer->mtu = ntohs ( plogi->common.mtu );
+	if ( peer->mtu < FC_LOGIN_MIN_MTU )
+		peer->mtu = FC_LOGIN_DEFAULT_MTU;
+	DBGC ( els, FCELS_FMT " has MTU %zd\n", FCELS_ARGS ( els ),
+	       peer->mtu );
+
 	/* Transmit response, if applicable */
 	if ( ! fc_els_is_request ( els ) ) {
 		if ( ( rc = fc_els_plogi_tx ( els ) ) != 0 )
@@ -50,6 +50,7 @@ static void fragment_expired ( struct retry_timer *timer, int fail __unused ) {
 	DBGC ( fragment, "FRAG %p expired\n", fragment );
 	free_iob ( fragment->iobuf );
 	list_del ( &fragment->list );
+	fragment->fragments->count--;
 	fragment->fragments->stats->reasm_fails++;
 	free ( fragment );
 }
@@ -68,8 +69,15 @@ static struct fragment * fragment_find ( struct fragment_reassembler *fragments,
 	struct fragment *fragment;
 
 	list_for_each_entry ( fragment, &fragments->list, list ) {
-		if ( fragments->is_fragment ( fragment, iobuf, hdrlen ) )
+		if ( fragments->is_fragment ( fragment, iobuf, hdrlen ) ) {
+			/* Move to front, so that the active fragment
+			 * stream is found without scanning past any
+			 * stale reassembly buffers.
+			 */
+			list_del ( &fragment->list );
+			list_add ( &fragment->list, &fragments->list );
 			return fragment;
+		}
 	}
 	return NULL;
 }
@@ -116,11 +124,23 @@ struct io_buffer * fragment_reassemble ( struct fragment_reassembler *fragments,
 	/* Create or extend fragment reassembly buffer as applicable */
 	if ( ! fragment ) {
 
+		/* Evict least recently used reassembly buffer if we
+		 * have reached the budget for concurrent reassemblies
+		 */
+		if ( fragments->count >= FRAGMENT_MAX ) {
+			fragment = list_last_entry ( &fragments->list,
+						     struct fragment, list );
+			DBGC ( fragment, "FRAG %p evicted\n", fragment );
+			stop_timer ( &fragment->timer );
+			fragment_expired ( &fragment->timer, 0 );
+		}
+
 		/* Create new fragment reassembly buffer */
 		fragment = zalloc ( sizeof ( *fragment ) );
 		if ( ! fragment )
 			goto drop;
 		list_add ( &fragment->list, &fragments->list );
+		fragments->count++;
 		fragment->iobuf = iobuf;
 		fragment->hdrlen = *hdrlen;
 		timer_init ( &fragment->timer, fragment_expired, NULL );
@@ -166,6 +186,7 @@ struct io_buffer * fragment_reassemble ( struct fragment_reassembler *fragments,
 			iobuf = fragment->iobuf;
 			*hdrlen = fragment->hdrlen;
 			list_del ( &fragment->list );
+			fragments->count--;
 			free ( fragment );
 			fragments->stats->reasm_oks++;
 			return iobuf;
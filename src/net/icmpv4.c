@@ -27,6 +27,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <errno.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/in.h>
+#include <ipxe/ip.h>
 #include <ipxe/tcpip.h>
 #include <ipxe/icmp.h>
 
@@ -38,6 +39,43 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 struct icmp_echo_protocol icmpv4_echo_protocol __icmp_echo_protocol;
 
+/**
+ * Process a received destination unreachable message
+ *
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ *
+ * This function takes ownership of the I/O buffer.
+ */
+static int icmpv4_rx_unreachable ( struct io_buffer *iobuf ) {
+	struct icmp_unreachable *unreach = iobuf->data;
+	struct iphdr *iphdr;
+	int rc;
+
+	/* Sanity check: the message must include at least the header
+	 * of the original packet.
+	 */
+	if ( iob_len ( iobuf ) < ( sizeof ( *unreach ) + sizeof ( *iphdr ))) {
+		DBG ( "ICMP unreachable too short at %zd bytes (min %zd "
+		      "bytes)\n", iob_len ( iobuf ),
+		      ( sizeof ( *unreach ) + sizeof ( *iphdr ) ) );
+		rc = -EINVAL;
+		goto discard;
+	}
+
+	/* Record discovered path MTU, if applicable */
+	if ( unreach->icmp.code == ICMP_FRAG_NEEDED ) {
+		iphdr = ( ( void * ) unreach->data );
+		ipv4_pmtu_update ( iphdr->dest, ntohs ( unreach->mtu ) );
+	}
+
+	rc = 0;
+
+ discard:
+	free_iob ( iobuf );
+	return rc;
+}
+
 /**
  * Process a received packet
  *
@@ -85,6 +123,8 @@ static int icmpv4_rx ( struct io_buffer *iobuf,
 					      &icmpv4_echo_protocol );
 	case ICMP_ECHO_REPLY:
 		return icmp_rx_echo_reply ( iobuf, st_src );
+	case ICMP_DESTINATION_UNREACHABLE:
+		return icmpv4_rx_unreachable ( iobuf );
 	default:
 		DBG ( "ICMP ignoring type %d\n", type );
 		rc = 0;
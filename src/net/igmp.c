@@ -0,0 +1,392 @@
+/*
+ * Copyright (C) 2016 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Internet Group Management Protocol
+ *
+ * This implements the multicast listener portion of IGMPv2 (RFC
+ * 2236), which is sufficient to allow multicast group memberships to
+ * propagate beyond the local link via multicast routers.  IGMPv3
+ * queriers are required by RFC 3376 to accept IGMPv2 reports, and
+ * IGMPv3 queries are answered with IGMPv2 reports.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/in.h>
+#include <ipxe/list.h>
+#include <ipxe/retry.h>
+#include <ipxe/timer.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/igmp.h>
+
+/** Maximum delay before retransmitting an unsolicited membership
+ * report (in ticks)
+ *
+ * This is the "Unsolicited Report Interval" defined in RFC 2236.
+ */
+#define IGMP_UNSOLICITED_DELAY ( 10 * TICKS_PER_SEC )
+
+/** Default maximum response time for IGMPv1 queries (in ticks)
+ *
+ * IGMPv1 queries carry no maximum response time; RFC 2236 specifies
+ * that ten seconds should be assumed.
+ */
+#define IGMP_V1_MAX_RESP_DELAY ( 10 * TICKS_PER_SEC )
+
+/** An IGMP group membership */
+struct igmp_group {
+	/** List of group memberships */
+	struct list_head list;
+	/** Network device */
+	struct net_device *netdev;
+	/** Group address */
+	struct in_addr address;
+	/** Number of joiners */
+	unsigned int count;
+	/** Report timer */
+	struct retry_timer timer;
+	/** Number of pending reports */
+	unsigned int pending;
+	/** We are the most recent reporter for this group */
+	int reporter;
+};
+
+/** List of group memberships */
+static LIST_HEAD ( igmp_groups );
+
+struct tcpip_protocol igmp_protocol __tcpip_protocol;
+
+/**
+ * Identify group membership
+ *
+ * @v netdev		Network device
+ * @v address		Group address
+ * @ret group		Group membership, or NULL if not found
+ */
+static struct igmp_group * igmp_find ( struct net_device *netdev,
+				       struct in_addr address ) {
+	struct igmp_group *group;
+
+	list_for_each_entry ( group, &igmp_groups, list ) {
+		if ( ( group->netdev == netdev ) &&
+		     ( group->address.s_addr == address.s_addr ) )
+			return group;
+	}
+	return NULL;
+}
+
+/**
+ * Transmit IGMP message
+ *
+ * @v group		Group membership
+ * @v type		Message type
+ * @v dest		Destination address
+ * @ret rc		Return status code
+ */
+static int igmp_tx ( struct igmp_group *group, unsigned int type,
+		     struct in_addr dest ) {
+	struct net_device *netdev = group->netdev;
+	struct sockaddr_tcpip st_dest;
+	struct sockaddr_in *sin_dest = ( ( struct sockaddr_in * ) &st_dest );
+	struct io_buffer *iobuf;
+	struct igmp_header *igmp;
+	int rc;
+
+	/* Construct destination address */
+	memset ( &st_dest, 0, sizeof ( st_dest ) );
+	sin_dest->sin_family = AF_INET;
+	sin_dest->sin_scope_id = netdev->index;
+	sin_dest->sin_addr = dest;
+
+	/* Allocate and populate buffer */
+	iobuf = alloc_iob ( MAX_LL_NET_HEADER_LEN + sizeof ( *igmp ) );
+	if ( ! iobuf )
+		return -ENOMEM;
+	iob_reserve ( iobuf, MAX_LL_NET_HEADER_LEN );
+	igmp = iob_put ( iobuf, sizeof ( *igmp ) );
+	memset ( igmp, 0, sizeof ( *igmp ) );
+	igmp->type = type;
+	igmp->group = group->address;
+	igmp->chksum = tcpip_chksum ( igmp, sizeof ( *igmp ) );
+
+	/* Transmit message */
+	if ( ( rc = tcpip_tx ( iobuf, &igmp_protocol, NULL, &st_dest,
+			       netdev, NULL ) ) != 0 ) {
+		DBGC ( group, "IGMP %s %s could not transmit: %s\n",
+		       netdev->name, inet_ntoa ( group->address ),
+		       strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Transmit membership report
+ *
+ * @v group		Group membership
+ * @ret rc		Return status code
+ */
+static int igmp_report ( struct igmp_group *group ) {
+
+	DBGC ( group, "IGMP %s %s reporting membership\n",
+	       group->netdev->name, inet_ntoa ( group->address ) );
+
+	/* Record that we are the most recent reporter */
+	group->reporter = 1;
+
+	/* Transmit report to the group itself */
+	return igmp_tx ( group, IGMP_V2_MEMBERSHIP_REPORT, group->address );
+}
+
+/**
+ * Handle expired report timer
+ *
+ * @v timer		Report timer
+ * @v over		Failure indicator
+ */
+static void igmp_expired ( struct retry_timer *timer, int over __unused ) {
+	struct igmp_group *group =
+		container_of ( timer, struct igmp_group, timer );
+
+	/* Transmit membership report */
+	igmp_report ( group );
+
+	/* Schedule any further pending report */
+	if ( --group->pending ) {
+		start_timer_fixed ( &group->timer,
+				    ( random() % IGMP_UNSOLICITED_DELAY ) );
+	}
+}
+
+/**
+ * Join multicast group
+ *
+ * @v netdev		Network device
+ * @v address		Group address
+ * @ret rc		Return status code
+ */
+int igmp_join ( struct net_device *netdev, struct in_addr address ) {
+	struct igmp_group *group;
+
+	/* Sanity check */
+	if ( ! IN_IS_MULTICAST ( address.s_addr ) )
+		return -EINVAL;
+
+	/* Increment count of existing membership, if any */
+	group = igmp_find ( netdev, address );
+	if ( group ) {
+		group->count++;
+		return 0;
+	}
+
+	/* Create new group membership */
+	group = zalloc ( sizeof ( *group ) );
+	if ( ! group )
+		return -ENOMEM;
+	group->netdev = netdev_get ( netdev );
+	group->address = address;
+	group->count = 1;
+	timer_init ( &group->timer, igmp_expired, NULL );
+	list_add ( &group->list, &igmp_groups );
+	DBGC ( group, "IGMP %s %s joined group\n",
+	       netdev->name, inet_ntoa ( address ) );
+
+	/* Schedule initial membership report, plus the single
+	 * retransmission required by RFC 2236
+	 */
+	group->pending = 2;
+	start_timer_nodelay ( &group->timer );
+
+	return 0;
+}
+
+/**
+ * Leave multicast group
+ *
+ * @v netdev		Network device
+ * @v address		Group address
+ */
+void igmp_leave ( struct net_device *netdev, struct in_addr address ) {
+	struct in_addr all_routers = { INADDR_ALL_ROUTERS };
+	struct igmp_group *group;
+
+	/* Identify group membership */
+	group = igmp_find ( netdev, address );
+	if ( ! group )
+		return;
+
+	/* Do nothing if this is not the last joiner */
+	if ( --group->count )
+		return;
+
+	DBGC ( group, "IGMP %s %s left group\n",
+	       netdev->name, inet_ntoa ( address ) );
+
+	/* Transmit leave message (to the all-routers group) if we
+	 * were the most recent reporter, as per RFC 2236.
+	 */
+	if ( group->reporter )
+		igmp_tx ( group, IGMP_V2_LEAVE_GROUP, all_routers );
+
+	/* Destroy group membership */
+	stop_timer ( &group->timer );
+	list_del ( &group->list );
+	netdev_put ( group->netdev );
+	free ( group );
+}
+
+/**
+ * Process received membership query
+ *
+ * @v netdev		Network device
+ * @v igmp		IGMP message
+ */
+static void igmp_rx_query ( struct net_device *netdev,
+			    struct igmp_header *igmp ) {
+	struct igmp_group *group;
+	unsigned long max_delay;
+	unsigned long delay;
+
+	/* Determine maximum response delay */
+	max_delay = ( igmp->max_resp ?
+		      ( igmp->max_resp * TICKS_PER_SEC / 10 ) :
+		      IGMP_V1_MAX_RESP_DELAY );
+
+	/* Schedule reports for all matching group memberships */
+	list_for_each_entry ( group, &igmp_groups, list ) {
+		if ( group->netdev != netdev )
+			continue;
+		if ( igmp->group.s_addr &&
+		     ( igmp->group.s_addr != group->address.s_addr ) )
+			continue;
+		DBGC ( group, "IGMP %s %s queried\n",
+		       netdev->name, inet_ntoa ( group->address ) );
+		delay = ( random() % ( max_delay + 1 ) );
+		if ( ! group->pending )
+			group->pending = 1;
+		if ( ( ! group->timer.running ) ||
+		     ( group->timer.expiry >
+		       ( currticks() + delay ) ) ) {
+			start_timer_fixed ( &group->timer, delay );
+		}
+	}
+}
+
+/**
+ * Process received membership report
+ *
+ * @v netdev		Network device
+ * @v igmp		IGMP message
+ */
+static void igmp_rx_report ( struct net_device *netdev,
+			     struct igmp_header *igmp ) {
+	struct igmp_group *group;
+
+	/* Identify group membership */
+	group = igmp_find ( netdev, igmp->group );
+	if ( ! group )
+		return;
+
+	/* Suppress our own pending report: another member has
+	 * reported this group.
+	 */
+	if ( group->timer.running ) {
+		DBGC ( group, "IGMP %s %s suppressing report\n",
+		       netdev->name, inet_ntoa ( group->address ) );
+		stop_timer ( &group->timer );
+	}
+	group->pending = 0;
+	group->reporter = 0;
+}
+
+/**
+ * Process received IGMP message
+ *
+ * @v iobuf		I/O buffer
+ * @v netdev		Network device
+ * @v st_src		Partially-filled source address
+ * @v st_dest		Partially-filled destination address
+ * @v pshdr_csum	Pseudo-header checksum
+ * @ret rc		Return status code
+ */
+static int igmp_rx ( struct io_buffer *iobuf, struct net_device *netdev,
+		     struct sockaddr_tcpip *st_src __unused,
+		     struct sockaddr_tcpip *st_dest __unused,
+		     uint16_t pshdr_csum __unused ) {
+	struct igmp_header *igmp = iobuf->data;
+	size_t len = iob_len ( iobuf );
+	unsigned int csum;
+	int rc;
+
+	/* Sanity check */
+	if ( len < sizeof ( *igmp ) ) {
+		DBG ( "IGMP packet too short at %zd bytes (min %zd bytes)\n",
+		      len, sizeof ( *igmp ) );
+		rc = -EINVAL;
+		goto discard;
+	}
+
+	/* Verify checksum */
+	csum = tcpip_chksum ( igmp, len );
+	if ( csum != 0 ) {
+		DBG ( "IGMP checksum incorrect (is %04x, should be 0000)\n",
+		      csum );
+		DBG_HD ( igmp, len );
+		rc = -EINVAL;
+		goto discard;
+	}
+
+	/* Handle IGMP message */
+	switch ( igmp->type ) {
+	case IGMP_MEMBERSHIP_QUERY:
+		igmp_rx_query ( netdev, igmp );
+		break;
+	case IGMP_V1_MEMBERSHIP_REPORT:
+	case IGMP_V2_MEMBERSHIP_REPORT:
+		igmp_rx_report ( netdev, igmp );
+		break;
+	default:
+		DBG ( "IGMP ignoring type %d\n", igmp->type );
+		break;
+	}
+	rc = 0;
+
+ discard:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/** IGMP TCP/IP protocol */
+struct tcpip_protocol igmp_protocol __tcpip_protocol = {
+	.name = "IGMP",
+	.rx = igmp_rx,
+	.tcpip_proto = IP_IGMP,
+};
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/timer.h>
+#include <ipxe/list.h>
+#include <ipxe/process.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/impair.h>
+
+/** @file
+ *
+ * Network impairment
+ *
+ * Apply a configurable bandwidth, latency and loss model to a network
+ * device's transmit path.  This allows protocol behaviour under
+ * constrained or lossy links to be reproduced on an unconstrained
+ * link (such as the Linux userspace build's TAP device), giving
+ * benchmark results that reflect link timing rather than host speed.
+ */
+
+/** An impaired network device */
+struct impair_device {
+	/** List of impaired network devices */
+	struct list_head list;
+	/** Network device */
+	struct net_device *netdev;
+	/** Link bandwidth (in bytes per second, or zero for unlimited) */
+	unsigned long bps;
+	/** Added latency (in ticks) */
+	unsigned long delay;
+	/** Loss rate (per mille) */
+	unsigned int loss;
+	/** Link-busy horizon (in ticks) */
+	unsigned long clock;
+	/** Queue of delayed frames */
+	struct list_head queue;
+};
+
+/** A delayed frame */
+struct impair_frame {
+	/** List of delayed frames */
+	struct list_head list;
+	/** Release time (in ticks) */
+	unsigned long release;
+	/** I/O buffer */
+	struct io_buffer *iobuf;
+};
+
+/** List of impaired network devices */
+static LIST_HEAD ( impair_devices );
+
+/** Delayed frames are currently being released */
+static int impair_releasing;
+
+/**
+ * Find impairment for a network device
+ *
+ * @v netdev		Network device
+ * @ret impair		Impaired network device, or NULL
+ */
+static struct impair_device * impair_find ( struct net_device *netdev ) {
+	struct impair_device *impair;
+
+	list_for_each_entry ( impair, &impair_devices, list ) {
+		if ( impair->netdev == netdev )
+			return impair;
+	}
+	return NULL;
+}
+
+/**
+ * Discard all delayed frames and remove an impairment
+ *
+ * @v impair		Impaired network device
+ */
+static void impair_del ( struct impair_device *impair ) {
+	struct impair_frame *frame;
+	struct impair_frame *tmp;
+
+	list_for_each_entry_safe ( frame, tmp, &impair->queue, list ) {
+		list_del ( &frame->list );
+		free_iob ( frame->iobuf );
+		free ( frame );
+	}
+	list_del ( &impair->list );
+	netdev_put ( impair->netdev );
+	free ( impair );
+}
+
+/**
+ * Configure network impairment
+ *
+ * @v netdev		Network device
+ * @v kbps		Link bandwidth (in kilobytes per second, or zero)
+ * @v delay_ms		Added latency (in milliseconds)
+ * @v loss		Loss rate (per mille)
+ * @ret rc		Return status code
+ *
+ * Configuring all parameters to zero removes the impairment.
+ */
+int impair_set ( struct net_device *netdev, unsigned long kbps,
+		 unsigned long delay_ms, unsigned int loss ) {
+	struct impair_device *impair;
+
+	/* Find or create impairment */
+	impair = impair_find ( netdev );
+	if ( ( ! kbps ) && ( ! delay_ms ) && ( ! loss ) ) {
+		if ( impair )
+			impair_del ( impair );
+		return 0;
+	}
+	if ( ! impair ) {
+		impair = zalloc ( sizeof ( *impair ) );
+		if ( ! impair )
+			return -ENOMEM;
+		impair->netdev = netdev_get ( netdev );
+		INIT_LIST_HEAD ( &impair->queue );
+		list_add_tail ( &impair->list, &impair_devices );
+	}
+
+	/* Update model parameters */
+	impair->bps = ( kbps * 1024 );
+	impair->delay = ( ( delay_ms * TICKS_PER_SEC ) / 1000 );
+	impair->loss = loss;
+
+	DBGC ( impair, "IMPAIR %s %ldkB/s delay %ldms loss %d/1000\n",
+	       netdev->name, kbps, delay_ms, loss );
+	return 0;
+}
+
+/**
+ * Apply impairment to a transmitted frame
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code, or -ENOTSUP to transmit normally
+ *
+ * If this function returns anything other than -ENOTSUP then it has
+ * taken ownership of the I/O buffer.
+ */
+int impair_tx ( struct net_device *netdev, struct io_buffer *iobuf ) {
+	struct impair_device *impair;
+	struct impair_frame *frame;
+	size_t len = iob_len ( iobuf );
+	unsigned long now;
+
+	/* Transmit normally when releasing delayed frames */
+	if ( impair_releasing )
+		return -ENOTSUP;
+
+	/* Transmit normally on unimpaired devices */
+	impair = impair_find ( netdev );
+	if ( ! impair )
+		return -ENOTSUP;
+
+	/* Model loss: a frame lost on the wire vanishes silently */
+	if ( impair->loss &&
+	     ( ( ( unsigned long ) ( random() % 1000 ) ) < impair->loss ) ) {
+		DBGC2 ( impair, "IMPAIR %s lost %zd bytes\n",
+			netdev->name, len );
+		free_iob ( iobuf );
+		return 0;
+	}
+
+	/* Model serialisation delay and added latency */
+	frame = malloc ( sizeof ( *frame ) );
+	if ( ! frame ) {
+		free_iob ( iobuf );
+		return -ENOMEM;
+	}
+	now = currticks();
+	if ( impair->clock < now )
+		impair->clock = now;
+	if ( impair->bps )
+		impair->clock += ( ( len * TICKS_PER_SEC ) / impair->bps );
+	frame->release = ( impair->clock + impair->delay );
+	frame->iobuf = iobuf;
+	list_add_tail ( &frame->list, &impair->queue );
+
+	DBGC2 ( impair, "IMPAIR %s delayed %zd bytes until %ld\n",
+		netdev->name, len, frame->release );
+	return 0;
+}
+
+/**
+ * Release delayed frames that have reached their release time
+ *
+ * @v process		Network impairment process
+ */
+static void impair_step ( struct process *process __unused ) {
+	struct impair_device *impair;
+	struct impair_frame *frame;
+	unsigned long now = currticks();
+
+	list_for_each_entry ( impair, &impair_devices, list ) {
+		while ( ( frame = list_first_entry ( &impair->queue,
+						     struct impair_frame,
+						     list ) ) != NULL ) {
+			if ( frame->release > now )
+				break;
+			list_del ( &frame->list );
+			impair_releasing = 1;
+			netdev_tx ( impair->netdev, frame->iobuf );
+			impair_releasing = 0;
+			free ( frame );
+		}
+	}
+}
+
+/** Network impairment process */
+PERMANENT_PROCESS ( impair_process, impair_step );
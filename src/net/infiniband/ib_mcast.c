@@ -113,9 +113,11 @@ static void ib_mcast_complete ( struct ib_device *ibdev,
 	av->rate = ( mc_member_record->rate_selector__rate & 0x3f );
 	av->sl = ( ( ntohl ( mc_member_record->sl__flow_label__hop_limit )
 		     >> 28 ) & 0x0f );
-	DBGC ( ibdev, "IBDEV %s QPN %#lx %s " IB_GID_FMT " qkey %#lx\n",
-	       ibdev->name, qp->qpn, ( joined ? "joined" : "left" ),
-	       IB_GID_ARGS ( &av->gid ), av->qkey );
+	membership->mtu = ( IB_MTU_SIZE ( mc_member_record->mtu_selector__mtu
+					  & 0x3f ) );
+	DBGC ( ibdev, "IBDEV %s QPN %#lx %s " IB_GID_FMT " qkey %#lx mtu "
+	       "%zd\n", ibdev->name, qp->qpn, ( joined ? "joined" : "left" ),
+	       IB_GID_ARGS ( &av->gid ), av->qkey, membership->mtu );
 
 	/* Set queue key */
 	qp->qkey = av->qkey;
@@ -167,6 +169,7 @@ int ib_mcast_join ( struct ib_device *ibdev, struct ib_queue_pair *qp,
 	/* Initialise structure */
 	membership->qp = qp;
 	membership->av = av;
+	membership->mtu = 0;
 	membership->complete = complete;
 
 	/* Attach queue pair to multicast GID */
@@ -56,6 +56,33 @@ static uint8_t next_ident_high = 0;
 /** List of IPv4 miniroutes */
 struct list_head ipv4_miniroutes = LIST_HEAD_INIT ( ipv4_miniroutes );
 
+/** IPv4 routing cache
+ *
+ * A connection transmits every packet to the same destination, so a
+ * single-entry cache suffices to skip the routing table walk for
+ * steady-state transmissions.
+ */
+static struct {
+	/** Routing table generation at time of lookup */
+	unsigned int generation;
+	/** Destination address scope ID */
+	unsigned int scope_id;
+	/** Final destination address */
+	struct in_addr dest;
+	/** Next hop destination address */
+	struct in_addr next_hop;
+	/** Routing table entry */
+	struct ipv4_miniroute *miniroute;
+} ipv4_route_cache;
+
+/** IPv4 routing table generation
+ *
+ * Incremented whenever the routing table or any network device state
+ * changes, to invalidate the routing cache.  Starts at one so that
+ * the zero-initialised cache can never appear valid.
+ */
+static unsigned int ipv4_route_generation = 1;
+
 /** IPv4 statistics */
 static struct ip_statistics ipv4_stats;
 
@@ -114,6 +141,9 @@ static int add_ipv4_miniroute ( struct net_device *netdev,
 		list_add ( &miniroute->list, &ipv4_miniroutes );
 	}
 
+	/* Invalidate routing cache */
+	ipv4_route_generation++;
+
 	return 0;
 }
 
@@ -134,8 +164,31 @@ static void del_ipv4_miniroute ( struct ipv4_miniroute *miniroute ) {
 	netdev_put ( miniroute->netdev );
 	list_del ( &miniroute->list );
 	free ( miniroute );
+
+	/* Invalidate routing cache */
+	ipv4_route_generation++;
 }
 
+/**
+ * Invalidate routing cache on network device state change or removal
+ *
+ * @v netdev		Network device
+ */
+static void ipv4_notify ( struct net_device *netdev __unused ) {
+
+	/* Invalidate routing cache, since route usability depends
+	 * upon network device state.
+	 */
+	ipv4_route_generation++;
+}
+
+/** IPv4 driver (for network device notifications) */
+struct net_driver ipv4_net_driver __net_driver = {
+	.name = "IPv4",
+	.notify = ipv4_notify,
+	.remove = ipv4_notify,
+};
+
 /**
  * Perform IPv4 routing
  *
@@ -150,6 +203,15 @@ static void del_ipv4_miniroute ( struct ipv4_miniroute *miniroute ) {
 static struct ipv4_miniroute * ipv4_route ( unsigned int scope_id,
 					    struct in_addr *dest ) {
 	struct ipv4_miniroute *miniroute;
+	struct in_addr orig = *dest;
+
+	/* Use cached route, if still valid */
+	if ( ( ipv4_route_cache.generation == ipv4_route_generation ) &&
+	     ( ipv4_route_cache.dest.s_addr == dest->s_addr ) &&
+	     ( ipv4_route_cache.scope_id == scope_id ) ) {
+		*dest = ipv4_route_cache.next_hop;
+		return ipv4_route_cache.miniroute;
+	}
 
 	/* Find first usable route in routing table */
 	list_for_each_entry ( miniroute, &ipv4_miniroutes, list ) {
@@ -164,7 +226,7 @@ static struct ipv4_miniroute * ipv4_route ( unsigned int scope_id,
 			 * matches this network device, then use this route.
 			 */
 			if ( miniroute->netdev->index == scope_id )
-				return miniroute;
+				goto found;
 
 		} else {
 
@@ -173,7 +235,7 @@ static struct ipv4_miniroute * ipv4_route ( unsigned int scope_id,
 			 */
 			if ( ( ( dest->s_addr ^ miniroute->address.s_addr )
 			       & miniroute->netmask.s_addr ) == 0 )
-				return miniroute;
+				goto found;
 
 			/* If destination is an off-link global
 			 * address, and we have a default gateway,
@@ -181,12 +243,22 @@ static struct ipv4_miniroute * ipv4_route ( unsigned int scope_id,
 			 */
 			if ( miniroute->gateway.s_addr ) {
 				*dest = miniroute->gateway;
-				return miniroute;
+				goto found;
 			}
 		}
 	}
 
 	return NULL;
+
+ found:
+	/* Record route in cache */
+	ipv4_route_cache.generation = ipv4_route_generation;
+	ipv4_route_cache.scope_id = scope_id;
+	ipv4_route_cache.dest = orig;
+	ipv4_route_cache.next_hop = *dest;
+	ipv4_route_cache.miniroute = miniroute;
+
+	return miniroute;
 }
 
 /**
@@ -208,6 +280,53 @@ static struct net_device * ipv4_netdev ( struct sockaddr_tcpip *st_dest ) {
 	return miniroute->netdev;
 }
 
+/**
+ * Update path MTU discovered for a destination
+ *
+ * @v dest		Destination address
+ * @v pmtu		Reported next-hop MTU
+ */
+void ipv4_pmtu_update ( struct in_addr dest, size_t pmtu ) {
+	struct ipv4_miniroute *miniroute;
+	struct in_addr next_hop;
+
+	/* Ignore implausibly small reported MTUs */
+	if ( pmtu < IP_MIN_PMTU )
+		return;
+
+	/* Identify route used to reach the destination */
+	next_hop = dest;
+	miniroute = ipv4_route ( 0, &next_hop );
+	if ( ! miniroute )
+		return;
+
+	/* Record reduced path MTU against the route */
+	if ( ( ! miniroute->pmtu ) || ( pmtu < miniroute->pmtu ) ) {
+		DBGC ( miniroute->netdev, "IPv4 path MTU to %s is %zd "
+		       "bytes\n", inet_ntoa ( dest ), pmtu );
+		miniroute->pmtu = pmtu;
+	}
+}
+
+/**
+ * Determine discovered path MTU
+ *
+ * @v st_dest		Destination network-layer address
+ * @ret pmtu		Path MTU, or zero if not discovered
+ */
+static size_t ipv4_pmtu ( struct sockaddr_tcpip *st_dest ) {
+	struct sockaddr_in *sin_dest = ( ( struct sockaddr_in * ) st_dest );
+	struct in_addr dest = sin_dest->sin_addr;
+	struct ipv4_miniroute *miniroute;
+
+	/* Find routing table entry */
+	miniroute = ipv4_route ( sin_dest->sin_scope_id, &dest );
+	if ( ! miniroute )
+		return 0;
+
+	return miniroute->pmtu;
+}
+
 /**
  * Check if IPv4 fragment matches fragment reassembly buffer
  *
@@ -325,8 +444,15 @@ static int ipv4_tx ( struct io_buffer *iobuf,
 	memset ( iphdr, 0, sizeof ( *iphdr ) );
 	iphdr->verhdrlen = ( IP_VER | ( sizeof ( *iphdr ) / 4 ) );
 	iphdr->service = IP_TOS;
-	iphdr->len = htons ( iob_len ( iobuf ) );	
+	iphdr->len = htons ( iob_len ( iobuf ) );
 	iphdr->ttl = IP_TTL;
+
+	/* Forbid fragmentation by intermediate routers, so that an
+	 * undersized link partway along the path will elicit an ICMP
+	 * fragmentation-needed message (used for path MTU discovery)
+	 * rather than being silently papered over.
+	 */
+	iphdr->frags = htons ( IP_MASK_DONOTFRAG );
 	iphdr->protocol = tcpip_protocol->tcpip_proto;
 	iphdr->dest = sin_dest->sin_addr;
 
@@ -721,6 +847,7 @@ struct tcpip_net_protocol ipv4_tcpip_protocol __tcpip_net_protocol = {
 	.net_protocol = &ipv4_protocol,
 	.tx = ipv4_tx,
 	.netdev = ipv4_netdev,
+	.pmtu = ipv4_pmtu,
 };
 
 /** IPv4 ARP protocol */
@@ -34,6 +34,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/fragment.h>
 #include <ipxe/ipstat.h>
 #include <ipxe/ndp.h>
+#include <ipxe/mld.h>
 #include <ipxe/ipv6.h>
 
 /** @file
@@ -217,7 +218,9 @@ static struct ipv6_miniroute * ipv6_miniroute ( struct net_device *netdev,
 int ipv6_add_miniroute ( struct net_device *netdev, struct in6_addr *address,
 			 unsigned int prefix_len, struct in6_addr *router ) {
 	struct ipv6_miniroute *miniroute;
+	struct in6_addr solicited;
 	uint8_t *prefix_mask;
+	unsigned int had_address;
 	unsigned int remaining;
 	unsigned int i;
 
@@ -258,6 +261,7 @@ int ipv6_add_miniroute ( struct net_device *netdev, struct in6_addr *address,
 	list_add ( &miniroute->list, &ipv6_miniroutes );
 
 	/* Set or update address, if applicable */
+	had_address = ( miniroute->flags & IPV6_HAS_ADDRESS );
 	for ( i = 0 ; i < ( sizeof ( address->s6_addr32 ) /
 			    sizeof ( address->s6_addr32[0] ) ) ; i++ ) {
 		if ( ( address->s6_addr32[i] &
@@ -270,6 +274,16 @@ int ipv6_add_miniroute ( struct net_device *netdev, struct in6_addr *address,
 	if ( miniroute->prefix_len == IPV6_MAX_PREFIX_LEN )
 		miniroute->flags |= IPV6_HAS_ADDRESS;
 
+	/* Join solicited-node multicast group, so that neighbour
+	 * solicitations can be delivered through MLD-snooping
+	 * switches.  Failure is nonfatal.
+	 */
+	if ( ( ! had_address ) && ( miniroute->flags & IPV6_HAS_ADDRESS ) ) {
+		memset ( &solicited, 0, sizeof ( solicited ) );
+		ipv6_solicited_node ( &solicited, &miniroute->address );
+		mld_join ( netdev, &solicited );
+	}
+
 	/* Update scope */
 	miniroute->scope = ipv6_scope ( &miniroute->address );
 
@@ -290,6 +304,14 @@ int ipv6_add_miniroute ( struct net_device *netdev, struct in6_addr *address,
  * @v miniroute		Routing table entry
  */
 void ipv6_del_miniroute ( struct ipv6_miniroute *miniroute ) {
+	struct in6_addr solicited;
+
+	/* Leave solicited-node multicast group, if applicable */
+	if ( miniroute->flags & IPV6_HAS_ADDRESS ) {
+		memset ( &solicited, 0, sizeof ( solicited ) );
+		ipv6_solicited_node ( &solicited, &miniroute->address );
+		mld_leave ( miniroute->netdev, &solicited );
+	}
 
 	netdev_put ( miniroute->netdev );
 	list_del ( &miniroute->list );
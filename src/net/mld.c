@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2016 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Multicast Listener Discovery
+ *
+ * This implements the multicast listener portion of MLDv1 (RFC
+ * 2710), which is sufficient to allow multicast group memberships to
+ * propagate beyond the local link via multicast routers.  MLDv2
+ * queriers are required by RFC 3810 to accept MLDv1 reports, and
+ * MLDv2 queries are answered with MLDv1 reports.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/in.h>
+#include <ipxe/list.h>
+#include <ipxe/retry.h>
+#include <ipxe/timer.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/icmpv6.h>
+#include <ipxe/ipv6.h>
+#include <ipxe/mld.h>
+
+/** Maximum delay before retransmitting an unsolicited listener
+ * report (in ticks)
+ *
+ * This is the "Unsolicited Report Interval" defined in RFC 2710.
+ */
+#define MLD_UNSOLICITED_DELAY ( 10 * TICKS_PER_SEC )
+
+/** An MLD group membership */
+struct mld_group {
+	/** List of group memberships */
+	struct list_head list;
+	/** Network device */
+	struct net_device *netdev;
+	/** Group address */
+	struct in6_addr address;
+	/** Number of joiners */
+	unsigned int count;
+	/** Report timer */
+	struct retry_timer timer;
+	/** Number of pending reports */
+	unsigned int pending;
+	/** We are the most recent reporter for this group */
+	int reporter;
+};
+
+/** List of group memberships */
+static LIST_HEAD ( mld_groups );
+
+/**
+ * Check for the all-nodes group address
+ *
+ * @v address		Group address
+ * @ret is_all_nodes	Address is the link-local all-nodes address
+ *
+ * Listener reports are never sent for the all-nodes group, as per
+ * RFC 2710.
+ */
+static int mld_is_all_nodes ( const struct in6_addr *address ) {
+	static const struct in6_addr all_nodes = {
+		.s6_addr = { 0xff, 0x02, 0, 0, 0, 0, 0, 0,
+			     0, 0, 0, 0, 0, 0, 0, 1 },
+	};
+
+	return ( memcmp ( address, &all_nodes, sizeof ( all_nodes ) ) == 0 );
+}
+
+/**
+ * Identify group membership
+ *
+ * @v netdev		Network device
+ * @v address		Group address
+ * @ret group		Group membership, or NULL if not found
+ */
+static struct mld_group * mld_find ( struct net_device *netdev,
+				     const struct in6_addr *address ) {
+	struct mld_group *group;
+
+	list_for_each_entry ( group, &mld_groups, list ) {
+		if ( ( group->netdev == netdev ) &&
+		     ( memcmp ( &group->address, address,
+				sizeof ( group->address ) ) == 0 ) )
+			return group;
+	}
+	return NULL;
+}
+
+/**
+ * Transmit MLD message
+ *
+ * @v group		Group membership
+ * @v type		Message type
+ * @v dest		Destination address
+ * @ret rc		Return status code
+ */
+static int mld_tx ( struct mld_group *group, unsigned int type,
+		    struct in6_addr *dest ) {
+	struct net_device *netdev = group->netdev;
+	struct sockaddr_in6 sin6_dest;
+	struct io_buffer *iobuf;
+	struct mld_header *mld;
+	int rc;
+
+	/* Construct destination address */
+	memset ( &sin6_dest, 0, sizeof ( sin6_dest ) );
+	sin6_dest.sin6_family = AF_INET6;
+	sin6_dest.sin6_scope_id = netdev->index;
+	memcpy ( &sin6_dest.sin6_addr, dest, sizeof ( sin6_dest.sin6_addr ) );
+
+	/* Allocate and populate buffer */
+	iobuf = alloc_iob ( MAX_LL_NET_HEADER_LEN + sizeof ( *mld ) );
+	if ( ! iobuf )
+		return -ENOMEM;
+	iob_reserve ( iobuf, MAX_LL_NET_HEADER_LEN );
+	mld = iob_put ( iobuf, sizeof ( *mld ) );
+	memset ( mld, 0, sizeof ( *mld ) );
+	mld->icmp.type = type;
+	memcpy ( &mld->group, &group->address, sizeof ( mld->group ) );
+	mld->icmp.chksum = tcpip_chksum ( mld, sizeof ( *mld ) );
+
+	/* Transmit message */
+	if ( ( rc = tcpip_tx ( iobuf, &icmpv6_protocol, NULL,
+			       ( ( struct sockaddr_tcpip * ) &sin6_dest ),
+			       netdev, &mld->icmp.chksum ) ) != 0 ) {
+		DBGC ( group, "MLD %s %s could not transmit: %s\n",
+		       netdev->name, inet6_ntoa ( &group->address ),
+		       strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Transmit listener report
+ *
+ * @v group		Group membership
+ * @ret rc		Return status code
+ */
+static int mld_report ( struct mld_group *group ) {
+
+	DBGC ( group, "MLD %s %s reporting membership\n",
+	       group->netdev->name, inet6_ntoa ( &group->address ) );
+
+	/* Record that we are the most recent reporter */
+	group->reporter = 1;
+
+	/* Transmit report to the group itself */
+	return mld_tx ( group, MLD_LISTENER_REPORT, &group->address );
+}
+
+/**
+ * Handle expired report timer
+ *
+ * @v timer		Report timer
+ * @v over		Failure indicator
+ */
+static void mld_expired ( struct retry_timer *timer, int over __unused ) {
+	struct mld_group *group =
+		container_of ( timer, struct mld_group, timer );
+
+	/* Transmit listener report */
+	mld_report ( group );
+
+	/* Schedule any further pending report */
+	if ( --group->pending ) {
+		start_timer_fixed ( &group->timer,
+				    ( random() % MLD_UNSOLICITED_DELAY ) );
+	}
+}
+
+/**
+ * Join multicast group
+ *
+ * @v netdev		Network device
+ * @v address		Group address
+ * @ret rc		Return status code
+ */
+int mld_join ( struct net_device *netdev, struct in6_addr *address ) {
+	struct mld_group *group;
+
+	/* Sanity check */
+	if ( ! IN6_IS_ADDR_MULTICAST ( address ) )
+		return -EINVAL;
+
+	/* Never report membership of the all-nodes group */
+	if ( mld_is_all_nodes ( address ) )
+		return 0;
+
+	/* Increment count of existing membership, if any */
+	group = mld_find ( netdev, address );
+	if ( group ) {
+		group->count++;
+		return 0;
+	}
+
+	/* Create new group membership */
+	group = zalloc ( sizeof ( *group ) );
+	if ( ! group )
+		return -ENOMEM;
+	group->netdev = netdev_get ( netdev );
+	memcpy ( &group->address, address, sizeof ( group->address ) );
+	group->count = 1;
+	timer_init ( &group->timer, mld_expired, NULL );
+	list_add ( &group->list, &mld_groups );
+	DBGC ( group, "MLD %s %s joined group\n",
+	       netdev->name, inet6_ntoa ( address ) );
+
+	/* Schedule initial listener report, plus the single
+	 * retransmission required by RFC 2710
+	 */
+	group->pending = 2;
+	start_timer_nodelay ( &group->timer );
+
+	return 0;
+}
+
+/**
+ * Leave multicast group
+ *
+ * @v netdev		Network device
+ * @v address		Group address
+ */
+void mld_leave ( struct net_device *netdev, struct in6_addr *address ) {
+	struct in6_addr all_routers;
+	struct mld_group *group;
+
+	/* Identify group membership */
+	group = mld_find ( netdev, address );
+	if ( ! group )
+		return;
+
+	/* Do nothing if this is not the last joiner */
+	if ( --group->count )
+		return;
+
+	DBGC ( group, "MLD %s %s left group\n",
+	       netdev->name, inet6_ntoa ( address ) );
+
+	/* Transmit done message (to the all-routers group) if we were
+	 * the most recent reporter, as per RFC 2710.
+	 */
+	if ( group->reporter ) {
+		memset ( &all_routers, 0, sizeof ( all_routers ) );
+		ipv6_all_routers ( &all_routers );
+		mld_tx ( group, MLD_LISTENER_DONE, &all_routers );
+	}
+
+	/* Destroy group membership */
+	stop_timer ( &group->timer );
+	list_del ( &group->list );
+	netdev_put ( group->netdev );
+	free ( group );
+}
+
+/**
+ * Process received listener query
+ *
+ * @v iobuf		I/O buffer
+ * @v netdev		Network device
+ * @v sin6_src		Source socket address
+ * @v sin6_dest		Destination socket address
+ * @ret rc		Return status code
+ */
+static int mld_rx_query ( struct io_buffer *iobuf,
+			  struct net_device *netdev,
+			  struct sockaddr_in6 *sin6_src __unused,
+			  struct sockaddr_in6 *sin6_dest __unused ) {
+	struct mld_header *mld = iobuf->data;
+	struct mld_group *group;
+	unsigned long max_delay;
+	unsigned long delay;
+	int rc;
+
+	/* Sanity check */
+	if ( iob_len ( iobuf ) < sizeof ( *mld ) ) {
+		DBG ( "MLD query too short at %zd bytes (min %zd bytes)\n",
+		      iob_len ( iobuf ), sizeof ( *mld ) );
+		rc = -EINVAL;
+		goto discard;
+	}
+
+	/* Determine maximum response delay */
+	max_delay = ( ntohs ( mld->max_resp ) * TICKS_PER_SEC / 1000 );
+
+	/* Schedule reports for all matching group memberships */
+	list_for_each_entry ( group, &mld_groups, list ) {
+		if ( group->netdev != netdev )
+			continue;
+		if ( ( ! IN6_IS_ADDR_UNSPECIFIED ( &mld->group ) ) &&
+		     ( memcmp ( &mld->group, &group->address,
+				sizeof ( mld->group ) ) != 0 ) )
+			continue;
+		DBGC ( group, "MLD %s %s queried\n",
+		       netdev->name, inet6_ntoa ( &group->address ) );
+		delay = ( random() % ( max_delay + 1 ) );
+		if ( ! group->pending )
+			group->pending = 1;
+		if ( ( ! group->timer.running ) ||
+		     ( group->timer.expiry > ( currticks() + delay ) ) ) {
+			start_timer_fixed ( &group->timer, delay );
+		}
+	}
+	rc = 0;
+
+ discard:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Process received listener report
+ *
+ * @v iobuf		I/O buffer
+ * @v netdev		Network device
+ * @v sin6_src		Source socket address
+ * @v sin6_dest		Destination socket address
+ * @ret rc		Return status code
+ */
+static int mld_rx_report ( struct io_buffer *iobuf,
+			   struct net_device *netdev,
+			   struct sockaddr_in6 *sin6_src __unused,
+			   struct sockaddr_in6 *sin6_dest __unused ) {
+	struct mld_header *mld = iobuf->data;
+	struct mld_group *group;
+	int rc;
+
+	/* Sanity check */
+	if ( iob_len ( iobuf ) < sizeof ( *mld ) ) {
+		DBG ( "MLD report too short at %zd bytes (min %zd bytes)\n",
+		      iob_len ( iobuf ), sizeof ( *mld ) );
+		rc = -EINVAL;
+		goto discard;
+	}
+
+	/* Suppress our own pending report, if applicable: another
+	 * listener has reported this group.
+	 */
+	group = mld_find ( netdev, &mld->group );
+	if ( group ) {
+		if ( group->timer.running ) {
+			DBGC ( group, "MLD %s %s suppressing report\n",
+			       netdev->name, inet6_ntoa ( &group->address ) );
+			stop_timer ( &group->timer );
+		}
+		group->pending = 0;
+		group->reporter = 0;
+	}
+	rc = 0;
+
+ discard:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/** MLD listener query handler */
+struct icmpv6_handler mld_query_handler __icmpv6_handler = {
+	.type = MLD_LISTENER_QUERY,
+	.rx = mld_rx_query,
+};
+
+/** MLD listener report handler */
+struct icmpv6_handler mld_report_handler __icmpv6_handler = {
+	.type = MLD_LISTENER_REPORT,
+	.rx = mld_rx_report,
+};
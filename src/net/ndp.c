@@ -1059,6 +1059,15 @@ struct ipv6conf {
 	/** Network device being configured */
 	struct net_device *netdev;
 
+	/** A router advertisement has been processed */
+	int ra_received;
+	/** DHCPv6 has been started */
+	int dhcp_started;
+	/** DHCPv6 was started statefully */
+	int dhcp_stateful;
+	/** DHCPv6 has completed successfully */
+	int dhcp_done;
+
 	/** Retransmission timer */
 	struct retry_timer timer;
 };
@@ -1066,6 +1075,30 @@ struct ipv6conf {
 /** List of IPv6 configurators */
 static LIST_HEAD ( ipv6confs );
 
+/** Number of cached router advertisement flag sets
+ *
+ * This is a policy decision.
+ */
+#define IPV6CONF_NUM_CACHED_FLAGS 4
+
+/** A cached set of router advertisement flags */
+struct ipv6conf_cached_flags {
+	/** Network device index (zero for an unused entry) */
+	unsigned int index;
+	/** Router advertisement flags */
+	uint8_t flags;
+};
+
+/** Cached router advertisement flags
+ *
+ * The managed and other-configuration flags from the most recently
+ * received router advertisements are cached so that a subsequent
+ * configuration attempt can start DHCPv6 in parallel with router
+ * solicitation, rather than serialising the two exchanges.
+ */
+static struct ipv6conf_cached_flags
+ipv6conf_flags_cache[IPV6CONF_NUM_CACHED_FLAGS];
+
 /**
  * Free IPv6 configurator
  *
@@ -1095,6 +1128,47 @@ static struct ipv6conf * ipv6conf_demux ( struct net_device *netdev ) {
 	return NULL;
 }
 
+/**
+ * Find cached router advertisement flags
+ *
+ * @v netdev		Network device
+ * @ret cached		Cached flags, or NULL
+ */
+static struct ipv6conf_cached_flags *
+ipv6conf_cached ( struct net_device *netdev ) {
+	struct ipv6conf_cached_flags *cached;
+	unsigned int i;
+
+	for ( i = 0 ; i < IPV6CONF_NUM_CACHED_FLAGS ; i++ ) {
+		cached = &ipv6conf_flags_cache[i];
+		if ( cached->index == netdev->index )
+			return cached;
+	}
+	return NULL;
+}
+
+/**
+ * Cache router advertisement flags
+ *
+ * @v netdev		Network device
+ * @v flags		Router advertisement flags
+ */
+static void ipv6conf_cache ( struct net_device *netdev, unsigned int flags ) {
+	static unsigned int victim;
+	struct ipv6conf_cached_flags *cached;
+
+	/* Update existing entry, if present; otherwise evict an entry
+	 * chosen round-robin.
+	 */
+	cached = ipv6conf_cached ( netdev );
+	if ( ! cached ) {
+		cached = &ipv6conf_flags_cache[victim];
+		victim = ( ( victim + 1 ) % IPV6CONF_NUM_CACHED_FLAGS );
+		cached->index = netdev->index;
+	}
+	cached->flags = flags;
+}
+
 /**
  * Finish IPv6 autoconfiguration
  *
@@ -1115,6 +1189,36 @@ static void ipv6conf_done ( struct ipv6conf *ipv6conf, int rc ) {
 	ref_put ( &ipv6conf->refcnt );
 }
 
+/**
+ * Start DHCPv6 during IPv6 autoconfiguration
+ *
+ * @v ipv6conf		IPv6 configurator
+ * @v flags		Router advertisement flags
+ * @ret rc		Return status code
+ */
+static int ipv6conf_start_dhcpv6 ( struct ipv6conf *ipv6conf,
+				   unsigned int flags ) {
+	struct net_device *netdev = ipv6conf->netdev;
+	int stateful = ( flags & NDP_ROUTER_MANAGED );
+	int rc;
+
+	/* Start DHCPv6 */
+	if ( ( rc = start_dhcpv6 ( &ipv6conf->dhcp, netdev,
+				   stateful ) ) != 0 ) {
+		DBGC ( netdev, "NDP %s could not start state%s DHCPv6: %s\n",
+		       netdev->name, ( stateful ? "ful" : "less" ),
+		       strerror ( rc ) );
+		return rc;
+	}
+
+	/* Record session type */
+	ipv6conf->dhcp_started = 1;
+	ipv6conf->dhcp_stateful = ( !! stateful );
+	ipv6conf->dhcp_done = 0;
+
+	return 0;
+}
+
 /**
  * Handle IPv6 configurator timer expiry
  *
@@ -1158,6 +1262,12 @@ ipv6conf_rx_router_advertisement ( struct net_device *netdev,
 	int stateful;
 	int rc;
 
+	/* Cache managed and other-configuration flags so that a
+	 * future configuration attempt can overlap DHCPv6 with router
+	 * solicitation.
+	 */
+	ipv6conf_cache ( netdev, radv->flags );
+
 	/* Identify IPv6 configurator, if any */
 	ipv6conf = ipv6conf_demux ( netdev );
 
@@ -1172,6 +1282,9 @@ ipv6conf_rx_router_advertisement ( struct net_device *netdev,
 	/* Stop router solicitation timer */
 	stop_timer ( &ipv6conf->timer );
 
+	/* Mark router advertisement as processed */
+	ipv6conf->ra_received = 1;
+
 	/* Register NDP settings */
 	option_len = ( len - offsetof ( typeof ( *radv ), option ) );
 	if ( ( rc = ndp_register_settings ( netdev, router,
@@ -1182,23 +1295,72 @@ ipv6conf_rx_router_advertisement ( struct net_device *netdev,
 	/* Start DHCPv6 if required */
 	if ( radv->flags & ( NDP_ROUTER_MANAGED | NDP_ROUTER_OTHER ) ) {
 		stateful = ( radv->flags & NDP_ROUTER_MANAGED );
-		if ( ( rc = start_dhcpv6 ( &ipv6conf->dhcp, netdev,
-					   stateful ) ) != 0 ) {
-			DBGC ( netdev, "NDP %s could not start state%s DHCPv6: "
-			       "%s\n", netdev->name,
-			       ( stateful ? "ful" : "less" ), strerror ( rc ) );
+
+		/* Use the result of (or continue to wait for) a
+		 * speculatively started DHCPv6 session of the correct
+		 * variety, if applicable.
+		 */
+		if ( ipv6conf->dhcp_stateful == ( !! stateful ) ) {
+			if ( ipv6conf->dhcp_done ) {
+				ipv6conf_done ( ipv6conf, 0 );
+				return 0;
+			}
+			if ( ipv6conf->dhcp_started )
+				return 0;
+		}
+
+		/* Otherwise, (re)start DHCPv6 */
+		if ( ipv6conf->dhcp_started )
+			intf_restart ( &ipv6conf->dhcp, -ECANCELED );
+		if ( ( rc = ipv6conf_start_dhcpv6 ( ipv6conf,
+						    radv->flags ) ) != 0 ) {
 			ipv6conf_done ( ipv6conf, rc );
 			return rc;
 		}
 		return 0;
 	}
 
+	/* Cancel any speculatively started DHCPv6 session */
+	if ( ipv6conf->dhcp_started )
+		intf_restart ( &ipv6conf->dhcp, -ECANCELED );
+
 	/* Otherwise, terminate autoconfiguration */
 	ipv6conf_done ( ipv6conf, 0 );
 
 	return 0;
 }
 
+/**
+ * Handle completion of DHCPv6 during IPv6 autoconfiguration
+ *
+ * @v ipv6conf		IPv6 configurator
+ * @v rc		DHCPv6 completion status
+ */
+static void ipv6conf_dhcp_close ( struct ipv6conf *ipv6conf, int rc ) {
+
+	/* Restart interface (to allow for a subsequent DHCPv6 session) */
+	intf_restart ( &ipv6conf->dhcp, rc );
+
+	/* If the router advertisement has already been processed, then
+	 * DHCPv6 completion (successful or otherwise) completes the
+	 * overall configuration.
+	 */
+	if ( ipv6conf->ra_received ) {
+		ipv6conf_done ( ipv6conf, rc );
+		return;
+	}
+
+	/* DHCPv6 was started speculatively based on cached router
+	 * advertisement flags.  On success, record completion and
+	 * continue to wait for the advertisement itself (which carries
+	 * the prefix and router settings).  On failure, revert to the
+	 * serialised behaviour: the advertisement will restart DHCPv6
+	 * if it is still required.
+	 */
+	ipv6conf->dhcp_started = 0;
+	ipv6conf->dhcp_done = ( rc == 0 );
+}
+
 /** IPv6 configurator job interface operations */
 static struct interface_operation ipv6conf_job_op[] = {
 	INTF_OP ( intf_close, struct ipv6conf *, ipv6conf_done ),
@@ -1210,7 +1372,7 @@ static struct interface_descriptor ipv6conf_job_desc =
 
 /** IPv6 configurator DHCPv6 interface operations */
 static struct interface_operation ipv6conf_dhcp_op[] = {
-	INTF_OP ( intf_close, struct ipv6conf *, ipv6conf_done ),
+	INTF_OP ( intf_close, struct ipv6conf *, ipv6conf_dhcp_close ),
 };
 
 /** IPv6 configurator DHCPv6 interface descriptor */
@@ -1225,6 +1387,7 @@ static struct interface_descriptor ipv6conf_dhcp_desc =
  * @ret rc		Return status code
  */
 int start_ipv6conf ( struct interface *job, struct net_device *netdev ) {
+	struct ipv6conf_cached_flags *cached;
 	struct ipv6conf *ipv6conf;
 
 	/* Allocate and initialise structure */
@@ -1240,6 +1403,20 @@ int start_ipv6conf ( struct interface *job, struct net_device *netdev ) {
 	/* Start timer to initiate router solicitation */
 	start_timer_nodelay ( &ipv6conf->timer );
 
+	/* If the managed and other-configuration flags are already
+	 * known from a previously received router advertisement, then
+	 * start DHCPv6 immediately (in parallel with router
+	 * solicitation) rather than serialising the two exchanges.
+	 * If the assumption turns out to be wrong, then the session
+	 * will be restarted or cancelled when the advertisement
+	 * arrives.  Failure to start speculatively is harmless, since
+	 * the advertisement will start DHCPv6 if it is required.
+	 */
+	cached = ipv6conf_cached ( netdev );
+	if ( cached &&
+	     ( cached->flags & ( NDP_ROUTER_MANAGED | NDP_ROUTER_OTHER ) ) )
+		ipv6conf_start_dhcpv6 ( ipv6conf, cached->flags );
+
 	/* Attach parent interface, transfer reference to list, and return */
 	intf_plug_plug ( &ipv6conf->job, job );
 	list_add ( &ipv6conf->list, &ipv6confs );
@@ -48,9 +48,33 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** Neighbour discovery maximum timeout */
 #define NEIGHBOUR_MAX_TIMEOUT ( TICKS_PER_SEC * 3 )
 
+/** Neighbour discovery failure holddown period
+ *
+ * A failed entry is retained as a negative cache entry for this
+ * period, so that a burst of traffic to an unresolvable address (such
+ * as a gateway that has gone away) results in a single discovery
+ * cycle rather than a storm of repeated discovery attempts.
+ */
+#define NEIGHBOUR_HOLDDOWN_TIMEOUT ( TICKS_PER_SEC * 10 )
+
+/** Maximum number of neighbour cache entries
+ *
+ * A boot client speaks to only a handful of distinct neighbours
+ * (gateway, DHCP, and one or two servers), but workloads that sweep a
+ * large subnet would otherwise grow the cache without bound and turn
+ * every lookup into a walk of the whole subnet's worth of entries.
+ * The least recently used entry is evicted when the cache is full.
+ */
+#define NEIGHBOUR_MAX 32
+
 /** The neighbour cache */
 struct list_head neighbours = LIST_HEAD_INIT ( neighbours );
 
+/** Number of neighbour cache entries */
+static unsigned int neighbour_count;
+
+static void neighbour_destroy ( struct neighbour *neighbour, int rc );
+
 static void neighbour_expired ( struct retry_timer *timer, int over );
 
 /**
@@ -85,6 +109,13 @@ static struct neighbour * neighbour_create ( struct net_device *netdev,
 					     const void *net_dest ) {
 	struct neighbour *neighbour;
 
+	/* Evict least recently used entry if cache is full */
+	if ( neighbour_count >= NEIGHBOUR_MAX ) {
+		neighbour = list_last_entry ( &neighbours, struct neighbour,
+					      list );
+		neighbour_destroy ( neighbour, -ENOBUFS );
+	}
+
 	/* Allocate and initialise entry */
 	neighbour = zalloc ( sizeof ( *neighbour ) );
 	if ( ! neighbour )
@@ -101,6 +132,7 @@ static struct neighbour * neighbour_create ( struct net_device *netdev,
 
 	/* Transfer ownership to cache */
 	list_add ( &neighbour->list, &neighbours );
+	neighbour_count++;
 
 	DBGC ( neighbour, "NEIGHBOUR %s %s %s created\n", netdev->name,
 	       net_protocol->name, net_protocol->ntoa ( net_dest ) );
@@ -163,6 +195,28 @@ static void neighbour_discover ( struct neighbour *neighbour,
 	       neighbour->discovery->name );
 }
 
+/**
+ * Discard any outstanding I/O buffers
+ *
+ * @v neighbour		Neighbour cache entry
+ * @v rc		Reason for discard
+ */
+static void neighbour_drain ( struct neighbour *neighbour, int rc ) {
+	struct net_device *netdev = neighbour->netdev;
+	struct net_protocol *net_protocol = neighbour->net_protocol;
+	struct io_buffer *iobuf;
+
+	while ( ( iobuf = list_first_entry ( &neighbour->tx_queue,
+					     struct io_buffer, list )) != NULL){
+		DBGC2 ( neighbour, "NEIGHBOUR %s %s %s discarding deferred "
+			"packet: %s\n", netdev->name, net_protocol->name,
+			net_protocol->ntoa ( neighbour->net_dest ),
+			strerror ( rc ) );
+		list_del ( &iobuf->list );
+		netdev_tx_err ( neighbour->netdev, iobuf, rc );
+	}
+}
+
 /**
  * Complete neighbour discovery
  *
@@ -177,6 +231,13 @@ static void neighbour_discovered ( struct neighbour *neighbour,
 	struct io_buffer *iobuf;
 	int rc;
 
+	/* Clear any recorded discovery failure.  This allows a
+	 * gratuitous ARP or unsolicited neighbour advertisement (as
+	 * sent on gateway failover, for example) to immediately
+	 * revive a negative cache entry.
+	 */
+	neighbour->rc = 0;
+
 	/* Fill in link-layer address */
 	memcpy ( neighbour->ll_dest, ll_dest, ll_protocol->ll_addr_len );
 	DBGC ( neighbour, "NEIGHBOUR %s %s %s is %s %s\n", netdev->name,
@@ -219,24 +280,16 @@ static void neighbour_discovered ( struct neighbour *neighbour,
 static void neighbour_destroy ( struct neighbour *neighbour, int rc ) {
 	struct net_device *netdev = neighbour->netdev;
 	struct net_protocol *net_protocol = neighbour->net_protocol;
-	struct io_buffer *iobuf;
 
 	/* Take ownership from cache */
 	list_del ( &neighbour->list );
+	neighbour_count--;
 
 	/* Stop timer */
 	stop_timer ( &neighbour->timer );
 
 	/* Discard any outstanding I/O buffers */
-	while ( ( iobuf = list_first_entry ( &neighbour->tx_queue,
-					     struct io_buffer, list )) != NULL){
-		DBGC2 ( neighbour, "NEIGHBOUR %s %s %s discarding deferred "
-			"packet: %s\n", netdev->name, net_protocol->name,
-			net_protocol->ntoa ( neighbour->net_dest ),
-			strerror ( rc ) );
-		list_del ( &iobuf->list );
-		netdev_tx_err ( neighbour->netdev, iobuf, rc );
-	}
+	neighbour_drain ( neighbour, rc );
 
 	DBGC ( neighbour, "NEIGHBOUR %s %s %s destroyed: %s\n", netdev->name,
 	       net_protocol->name, net_protocol->ntoa ( neighbour->net_dest ),
@@ -246,6 +299,30 @@ static void neighbour_destroy ( struct neighbour *neighbour, int rc ) {
 	ref_put ( &neighbour->refcnt );
 }
 
+/**
+ * Mark neighbour discovery as failed
+ *
+ * @v neighbour		Neighbour cache entry
+ * @v rc		Failure status code
+ */
+static void neighbour_failed ( struct neighbour *neighbour, int rc ) {
+	struct net_device *netdev = neighbour->netdev;
+	struct net_protocol *net_protocol = neighbour->net_protocol;
+
+	/* Record failure */
+	neighbour->rc = rc;
+
+	/* Discard any outstanding I/O buffers */
+	neighbour_drain ( neighbour, rc );
+
+	/* Retain as a negative cache entry for the holddown period */
+	start_timer_fixed ( &neighbour->timer, NEIGHBOUR_HOLDDOWN_TIMEOUT );
+
+	DBGC ( neighbour, "NEIGHBOUR %s %s %s failed: %s\n", netdev->name,
+	       net_protocol->name, net_protocol->ntoa ( neighbour->net_dest ),
+	       strerror ( rc ) );
+}
+
 /**
  * Handle neighbour timer expiry
  *
@@ -263,9 +340,17 @@ static void neighbour_expired ( struct retry_timer *timer, int fail ) {
 	const void *net_source = neighbour->net_source;
 	int rc;
 
-	/* If we have failed, destroy the cache entry */
+	/* If this is a negative cache entry, its holddown period has
+	 * now expired.
+	 */
+	if ( neighbour->rc ) {
+		neighbour_destroy ( neighbour, neighbour->rc );
+		return;
+	}
+
+	/* If we have failed, retain the entry as a negative cache entry */
 	if ( fail ) {
-		neighbour_destroy ( neighbour, -ETIMEDOUT );
+		neighbour_failed ( neighbour, -ETIMEDOUT );
 		return;
 	}
 
@@ -301,6 +386,7 @@ int neighbour_tx ( struct io_buffer *iobuf, struct net_device *netdev,
 		   struct neighbour_discovery *discovery,
 		   const void *net_source, const void *ll_source ) {
 	struct neighbour *neighbour;
+	int rc;
 
 	/* Find or create neighbour cache entry */
 	neighbour = neighbour_find ( netdev, net_protocol, net_dest );
@@ -311,6 +397,12 @@ int neighbour_tx ( struct io_buffer *iobuf, struct net_device *netdev,
 		neighbour_discover ( neighbour, discovery, net_source );
 	}
 
+	/* Fail immediately if this is a negative cache entry */
+	if ( ( rc = neighbour->rc ) != 0 ) {
+		netdev_tx_err ( netdev, iobuf, rc );
+		return rc;
+	}
+
 	/* If a link-layer address is available then transmit
 	 * immediately, otherwise queue for later transmission.
 	 */
@@ -81,6 +81,16 @@ const struct setting mtu_setting __setting ( SETTING_NETDEV, mtu ) = {
 	.type = &setting_type_int16,
 	.tag = DHCP_MTU,
 };
+const struct setting rxrate_setting __setting ( SETTING_NETDEV, rxrate ) = {
+	.name = "rxrate",
+	.description = "RX rate (packets per second)",
+	.type = &setting_type_uint32,
+};
+const struct setting txrate_setting __setting ( SETTING_NETDEV, txrate ) = {
+	.name = "txrate",
+	.description = "TX rate (packets per second)",
+	.type = &setting_type_uint32,
+};
 
 /**
  * Store link-layer address setting
@@ -251,6 +261,64 @@ static int netdev_fetch_ifname ( struct net_device *netdev, void *data,
 	return strlen ( ifname );
 }
 
+/**
+ * Fetch estimated completion rate
+ *
+ * @v stats		Network device statistics
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int netdev_fetch_rate ( struct net_device_stats *stats, void *data,
+			       size_t len ) {
+	unsigned long elapsed;
+	uint32_t rate;
+
+	/* Use the current (incomplete) window if it already spans at
+	 * least one full window length, since it will then provide a
+	 * fresher estimate than the last completed window.
+	 */
+	elapsed = ( currticks() - stats->window_start );
+	if ( elapsed >= NETDEV_RATE_WINDOW ) {
+		rate = ( ( ( stats->good - stats->window_good ) *
+			   TICKS_PER_SEC ) / elapsed );
+	} else {
+		rate = stats->rate;
+	}
+
+	rate = cpu_to_be32 ( rate );
+	if ( len > sizeof ( rate ) )
+		len = sizeof ( rate );
+	memcpy ( data, &rate, len );
+	return sizeof ( rate );
+}
+
+/**
+ * Fetch RX rate setting
+ *
+ * @v netdev		Network device
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int netdev_fetch_rxrate ( struct net_device *netdev, void *data,
+				 size_t len ) {
+	return netdev_fetch_rate ( &netdev->rx_stats, data, len );
+}
+
+/**
+ * Fetch TX rate setting
+ *
+ * @v netdev		Network device
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int netdev_fetch_txrate ( struct net_device *netdev, void *data,
+				 size_t len ) {
+	return netdev_fetch_rate ( &netdev->tx_stats, data, len );
+}
+
 /** A network device setting operation */
 struct netdev_setting_operation {
 	/** Setting */
@@ -283,6 +351,8 @@ static struct netdev_setting_operation netdev_setting_operations[] = {
 	{ &busid_setting, NULL, netdev_fetch_busid },
 	{ &chip_setting, NULL, netdev_fetch_chip },
 	{ &ifname_setting, NULL, netdev_fetch_ifname },
+	{ &rxrate_setting, NULL, netdev_fetch_rxrate },
+	{ &txrate_setting, NULL, netdev_fetch_txrate },
 };
 
 /**
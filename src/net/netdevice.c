@@ -40,7 +40,10 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/errortab.h>
 #include <ipxe/profile.h>
 #include <ipxe/fault.h>
+#include <ipxe/boottrace.h>
 #include <ipxe/vlan.h>
+#include <ipxe/pcap.h>
+#include <ipxe/impair.h>
 #include <ipxe/netdevice.h>
 
 /** @file
@@ -58,6 +61,15 @@ static struct list_head open_net_devices = LIST_HEAD_INIT ( open_net_devices );
 /** Network device index */
 static unsigned int netdev_index = 0;
 
+/** Receive processing budget per device per poll
+ *
+ * Packets left on the receive queue when the budget is exhausted
+ * remain there and are processed on the next poll; this stops a
+ * single busy device from starving other devices (and everything else
+ * sharing the process loop) within one call to net_poll().
+ */
+#define NET_RX_BUDGET 64
+
 /** Network polling profiler */
 static struct profiler net_poll_profiler __profiler = { .name = "net.poll" };
 
@@ -67,6 +79,15 @@ static struct profiler net_rx_profiler __profiler = { .name = "net.rx" };
 /** Network transmit profiler */
 static struct profiler net_tx_profiler __profiler = { .name = "net.tx" };
 
+/** Receive queue latency profiler
+ *
+ * This measures the time spent by packets sitting in the receive
+ * queue between netdev_rx() and network-layer processing, which is
+ * where latency accumulates when the stack cannot keep pace with the
+ * driver.
+ */
+static struct profiler net_queue_profiler __profiler = { .name = "net.queue" };
+
 /** Default unknown link status code */
 #define EUNKNOWN_LINK_STATUS __einfo_error ( EINFO_EUNKNOWN_LINK_STATUS )
 #define EINFO_EUNKNOWN_LINK_STATUS \
@@ -247,8 +268,20 @@ static void netdev_link_block_expired ( struct retry_timer *timer,
 static void netdev_record_stat ( struct net_device_stats *stats, int rc ) {
 	struct net_device_error *error;
 	struct net_device_error *least_common_error;
+	unsigned long elapsed;
+	unsigned long now;
 	unsigned int i;
 
+	/* Update windowed rate estimate */
+	now = currticks();
+	elapsed = ( now - stats->window_start );
+	if ( elapsed >= NETDEV_RATE_WINDOW ) {
+		stats->rate = ( ( ( stats->good - stats->window_good ) *
+				  TICKS_PER_SEC ) / elapsed );
+		stats->window_start = now;
+		stats->window_good = stats->good;
+	}
+
 	/* If this is not an error, just update the good counter */
 	if ( rc == 0 ) {
 		stats->good++;
@@ -294,9 +327,17 @@ int netdev_tx ( struct net_device *netdev, struct io_buffer *iobuf ) {
 		netdev->name, iobuf, iobuf->data, iob_len ( iobuf ) );
 	profile_start ( &net_tx_profiler );
 
+	/* Divert packet to network impairment, if applicable */
+	if ( ( rc = impair_tx ( netdev, iobuf ) ) != -ENOTSUP )
+		return rc;
+
 	/* Enqueue packet */
 	list_add_tail ( &iobuf->list, &netdev->tx_queue );
 
+	/* Update transmit queue occupancy */
+	if ( ++netdev->tx_count > netdev->tx_max )
+		netdev->tx_max = netdev->tx_count;
+
 	/* Avoid calling transmit() on unopened network devices */
 	if ( ! netdev_is_open ( netdev ) ) {
 		rc = -ENETUNREACH;
@@ -377,6 +418,8 @@ void netdev_tx_err ( struct net_device *netdev,
 	} else {
 		DBGC ( netdev, "NETDEV %s transmission %p failed: %s\n",
 		       netdev->name, iobuf, strerror ( rc ) );
+		tracepoint ( 2, "NET %s TX err: %s", netdev->name,
+			     strerror ( rc ) );
 	}
 
 	/* Discard packet */
@@ -400,6 +443,7 @@ void netdev_tx_complete_err ( struct net_device *netdev,
 
 	/* Dequeue and free I/O buffer */
 	list_del ( &iobuf->list );
+	netdev->tx_count--;
 	netdev_tx_err ( netdev, iobuf, rc );
 
 	/* Handle pending transmit queue */
@@ -408,6 +452,7 @@ void netdev_tx_complete_err ( struct net_device *netdev,
 
 		/* Remove from pending transmit queue */
 		list_del ( &iobuf->list );
+		netdev->tx_count--;
 
 		/* When any transmit completion fails, cancel all
 		 * pending transmissions.
@@ -479,6 +524,13 @@ void netdev_rx ( struct net_device *netdev, struct io_buffer *iobuf ) {
 		return;
 	}
 
+	/* Record ingress timestamp (in profiling builds only) */
+	if ( PROFILING )
+		iobuf->rx_stamp = profile_timestamp();
+
+	/* Record frame in packet capture, if applicable */
+	pcap_record ( netdev, iobuf );
+
 	/* Enqueue packet */
 	list_add_tail ( &iobuf->list, &netdev->rx_queue );
 
@@ -503,6 +555,7 @@ void netdev_rx_err ( struct net_device *netdev,
 
 	DBGC ( netdev, "NETDEV %s failed to receive %p: %s\n",
 	       netdev->name, iobuf, strerror ( rc ) );
+	tracepoint ( 2, "NET %s RX err: %s", netdev->name, strerror ( rc ) );
 
 	/* Discard packet */
 	free_iob ( iobuf );
@@ -1028,13 +1081,26 @@ int net_tx ( struct io_buffer *iobuf, struct net_device *netdev,
 int net_rx ( struct io_buffer *iobuf, struct net_device *netdev,
 	     uint16_t net_proto, const void *ll_dest, const void *ll_source,
 	     unsigned int flags ) {
+	static struct net_protocol *cache;
 	struct net_protocol *net_protocol;
 
+	/* Try the most recently used protocol first.  Boot workloads
+	 * are dominated by a single network-layer protocol, so this
+	 * almost always reduces demultiplexing to a single comparison.
+	 */
+	net_protocol = cache;
+	if ( net_protocol && ( net_protocol->net_proto == net_proto ) ) {
+		return net_protocol->rx ( iobuf, netdev, ll_dest,
+					  ll_source, flags );
+	}
+
 	/* Hand off to network-layer protocol, if any */
 	for_each_table_entry ( net_protocol, NET_PROTOCOLS ) {
-		if ( net_protocol->net_proto == net_proto )
+		if ( net_protocol->net_proto == net_proto ) {
+			cache = net_protocol;
 			return net_protocol->rx ( iobuf, netdev, ll_dest,
 						  ll_source, flags );
+		}
 	}
 
 	DBGC ( netdev, "NETDEV %s unknown network protocol %04x\n",
@@ -1057,6 +1123,7 @@ void net_poll ( void ) {
 	const void *ll_source;
 	uint16_t net_proto;
 	unsigned int flags;
+	unsigned int budget;
 	int rc;
 
 	/* Poll and process each network device */
@@ -1076,12 +1143,21 @@ void net_poll ( void ) {
 		if ( netdev_rx_frozen ( netdev ) )
 			continue;
 
-		/* Process all received packets */
-		while ( ( iobuf = netdev_rx_dequeue ( netdev ) ) ) {
+		/* Process received packets, up to the receive budget */
+		budget = NET_RX_BUDGET;
+		while ( budget-- && ( iobuf = netdev_rx_dequeue ( netdev ) ) ) {
 
 			DBGC2 ( netdev, "NETDEV %s processing %p (%p+%zx)\n",
 				netdev->name, iobuf, iobuf->data,
 				iob_len ( iobuf ) );
+
+			/* Record time spent in the receive queue */
+			if ( PROFILING ) {
+				profile_custom ( &net_queue_profiler,
+						 ( profile_timestamp() -
+						   iobuf->rx_stamp ) );
+			}
+
 			profile_start ( &net_rx_profiler );
 
 			/* Remove link-layer header */
@@ -1094,6 +1170,14 @@ void net_poll ( void ) {
 				continue;
 			}
 
+			/* Link-layer control frames (e.g. LACP or
+			 * STP) are cheap to handle and must not be
+			 * allowed to starve data packets of receive
+			 * budget: do not count them against it.
+			 */
+			if ( flags & LL_CONTROL )
+				budget++;
+
 			/* Hand packet to network layer */
 			if ( ( rc = net_rx ( iob_disown ( iobuf ), netdev,
 					     net_proto, ll_dest,
@@ -1160,6 +1244,154 @@ __weak void vlan_netdev_rx_err ( struct net_device *netdev,
 /** Networking stack process */
 PERMANENT_PROCESS ( net_process, net_step );
 
+/**
+ * Arrange for a network device to wake a halted CPU
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ *
+ * Enable generation of receive interrupts capable of waking a halted
+ * CPU.  This is a platform-specific operation (e.g. unmasking the
+ * relevant line at the interrupt controller and installing a handler
+ * to prevent an interrupt storm); the default implementation
+ * unconditionally fails, causing the scheduler to fall back to
+ * continuous polling.
+ */
+__weak int netdev_wake ( struct net_device *netdev __unused ) {
+
+	return -ENOTSUP;
+}
+
+/**
+ * Apply impairment to a transmitted frame
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code, or -ENOTSUP to transmit normally
+ *
+ * This function is overridden when network impairment support is
+ * present.
+ */
+__weak int impair_tx ( struct net_device *netdev __unused,
+		       struct io_buffer *iobuf __unused ) {
+
+	return -ENOTSUP;
+}
+
+/**
+ * Record an ingress frame in the packet capture
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ *
+ * This function is overridden when packet capture support is present.
+ */
+__weak void pcap_record ( struct net_device *netdev __unused,
+			  struct io_buffer *iobuf __unused ) {
+
+	/* Nothing to do */
+}
+
+/**
+ * Stop a network device from waking a halted CPU
+ *
+ * @v netdev		Network device
+ */
+__weak void netdev_unwake ( struct net_device *netdev __unused ) {
+
+	/* Nothing to do */
+}
+
+/**
+ * Check for network devices requiring polling
+ *
+ * @ret busy		Polling must continue
+ *
+ * Network devices have no interrupt-driven receive datapath, and so
+ * must be polled continuously while open, unless they are at least
+ * able to generate an interrupt that will wake a halted CPU (which
+ * may then resume polling).
+ */
+static int net_busy ( void ) {
+	struct net_device *netdev;
+
+	for_each_netdev ( netdev ) {
+
+		/* Ignore closed network devices */
+		if ( ! netdev_is_open ( netdev ) )
+			continue;
+
+		/* Poll continuously if device cannot generate
+		 * interrupts to wake a halted CPU.
+		 */
+		if ( ! netdev_irq_supported ( netdev ) )
+			return 1;
+
+		/* Poll continuously while transmissions are in
+		 * progress or received packets are awaiting
+		 * processing.
+		 */
+		if ( ! ( list_empty ( &netdev->tx_queue ) &&
+			 list_empty ( &netdev->rx_queue ) ) )
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Prepare to halt the CPU with open network devices
+ *
+ * @ret rc		Return status code
+ */
+static int net_prepare ( void ) {
+	struct net_device *netdev;
+	struct net_device *undo;
+	int rc;
+
+	/* Enable wakeup interrupts on all open network devices */
+	for_each_netdev ( netdev ) {
+		if ( ! netdev_is_open ( netdev ) )
+			continue;
+		if ( ( rc = netdev_wake ( netdev ) ) != 0 )
+			goto err_wake;
+	}
+
+	return 0;
+
+ err_wake:
+	/* Disable wakeup interrupts on all already-prepared devices */
+	for_each_netdev ( undo ) {
+		if ( undo == netdev )
+			break;
+		if ( netdev_is_open ( undo ) )
+			netdev_unwake ( undo );
+	}
+	return rc;
+}
+
+/**
+ * Resume polling open network devices after halting the CPU
+ *
+ */
+static void net_finish ( void ) {
+	struct net_device *netdev;
+
+	/* Disable wakeup interrupts on all open network devices */
+	for_each_netdev ( netdev ) {
+		if ( netdev_is_open ( netdev ) )
+			netdev_unwake ( netdev );
+	}
+}
+
+/** Networking stack idle check */
+struct idle_check net_idle_check __idle_check = {
+	.name = "net",
+	.busy = net_busy,
+	.prepare = net_prepare,
+	.finish = net_finish,
+};
+
 /**
  * Discard some cached network device data
  *
@@ -1178,6 +1410,7 @@ static unsigned int net_discard ( void ) {
 
 			/* Discard first deferred packet */
 			list_del ( &iobuf->list );
+			netdev->tx_count--;
 			free_iob ( iobuf );
 
 			/* Report discard */
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <ipxe/timer.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/umalloc.h>
+#include <ipxe/image.h>
+#include <ipxe/pcap.h>
+
+/** @file
+ *
+ * Packet capture
+ *
+ * Capture ingress frames (with timestamps) into a fixed-size buffer
+ * in the standard packet capture file format.  When capture is
+ * stopped, the buffer is registered as an image, from which it can be
+ * exported via any existing image transport (such as peer-to-peer
+ * image serving).  Captured traces can then be replayed offline
+ * through the replay network driver to reproduce protocol behaviour
+ * deterministically.
+ */
+
+/** Colour for debug messages */
+#define colour &pcap_buffer
+
+/** Capture buffer, if a capture is in progress */
+static userptr_t pcap_buffer = UNULL;
+
+/** Length of capture buffer */
+static size_t pcap_max;
+
+/** Length of captured data */
+static size_t pcap_len;
+
+/** Name under which to register the captured trace */
+static char *pcap_name;
+
+/** Number of frames dropped due to a full capture buffer */
+static unsigned int pcap_dropped;
+
+/**
+ * Start packet capture
+ *
+ * @v name		Name under which to register the captured trace
+ * @v len		Capture buffer length (or zero to use the default)
+ * @ret rc		Return status code
+ */
+int pcap_start ( const char *name, size_t len ) {
+	struct pcap_file_header hdr;
+	int rc;
+
+	/* Refuse to start if a capture is already in progress */
+	if ( pcap_buffer != UNULL ) {
+		rc = -EALREADY;
+		goto err_already;
+	}
+
+	/* Use default buffer length, if applicable */
+	if ( ! len )
+		len = PCAP_DEFAULT_LEN;
+
+	/* Refuse a buffer too small to hold even the file header */
+	if ( len < sizeof ( hdr ) ) {
+		rc = -EINVAL;
+		goto err_len;
+	}
+
+	/* Record name */
+	pcap_name = strdup ( name );
+	if ( ! pcap_name ) {
+		rc = -ENOMEM;
+		goto err_name;
+	}
+
+	/* Allocate capture buffer */
+	pcap_buffer = umalloc ( len );
+	if ( ! pcap_buffer ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	pcap_max = len;
+	pcap_dropped = 0;
+
+	/* Construct file header */
+	memset ( &hdr, 0, sizeof ( hdr ) );
+	hdr.magic = PCAP_MAGIC;
+	hdr.version_major = PCAP_VERSION_MAJOR;
+	hdr.version_minor = PCAP_VERSION_MINOR;
+	hdr.snaplen = len;
+	hdr.network = PCAP_LINKTYPE_ETHERNET;
+	copy_to_user ( pcap_buffer, 0, &hdr, sizeof ( hdr ) );
+	pcap_len = sizeof ( hdr );
+
+	DBGC ( colour, "PCAP started capture \"%s\" (%zd bytes)\n",
+	       pcap_name, pcap_max );
+	return 0;
+
+ err_alloc:
+	free ( pcap_name );
+	pcap_name = NULL;
+ err_name:
+ err_len:
+ err_already:
+	return rc;
+}
+
+/**
+ * Record an ingress frame
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ *
+ * This function must not take ownership of the I/O buffer.
+ */
+void pcap_record ( struct net_device *netdev, struct io_buffer *iobuf ) {
+	struct pcap_record_header hdr;
+	size_t len = iob_len ( iobuf );
+	unsigned long ticks;
+
+	/* Do nothing unless a capture is in progress */
+	if ( pcap_buffer == UNULL )
+		return;
+
+	/* Drop (and count) frames that no longer fit */
+	if ( ( pcap_len + sizeof ( hdr ) + len ) > pcap_max ) {
+		pcap_dropped++;
+		return;
+	}
+
+	/* Construct record header */
+	ticks = currticks();
+	hdr.ts_sec = time ( NULL );
+	hdr.ts_usec = ( ( ( uint64_t ) ( ticks % TICKS_PER_SEC ) * 1000000 ) /
+			TICKS_PER_SEC );
+	hdr.incl_len = len;
+	hdr.orig_len = len;
+
+	/* Append record to capture buffer */
+	copy_to_user ( pcap_buffer, pcap_len, &hdr, sizeof ( hdr ) );
+	pcap_len += sizeof ( hdr );
+	copy_to_user ( pcap_buffer, pcap_len, iobuf->data, len );
+	pcap_len += len;
+
+	DBGC2 ( colour, "PCAP recorded %zd bytes from %s\n",
+		len, netdev->name );
+}
+
+/**
+ * Stop packet capture and register the captured trace as an image
+ *
+ * @ret rc		Return status code
+ */
+int pcap_stop ( void ) {
+	struct image *image;
+	int rc;
+
+	/* Fail unless a capture is in progress */
+	if ( pcap_buffer == UNULL ) {
+		rc = -ENOENT;
+		goto err_inactive;
+	}
+
+	/* Allocate image */
+	image = alloc_image ( NULL );
+	if ( ! image ) {
+		rc = -ENOMEM;
+		goto err_image;
+	}
+
+	/* Name image */
+	if ( ( rc = image_set_name ( image, pcap_name ) ) != 0 )
+		goto err_name;
+
+	/* Transfer capture buffer to image */
+	image->data = pcap_buffer;
+	image->len = pcap_len;
+	pcap_buffer = UNULL;
+
+	/* Register image */
+	if ( ( rc = register_image ( image ) ) != 0 )
+		goto err_register;
+
+	DBGC ( colour, "PCAP registered \"%s\" (%zd bytes, %d dropped)\n",
+	       image->name, image->len, pcap_dropped );
+
+	/* Drop our reference, leaving the registration's reference */
+	image_put ( image );
+
+	free ( pcap_name );
+	pcap_name = NULL;
+	return 0;
+
+ err_register:
+ err_name:
+	image_put ( image );
+ err_image:
+	ufree ( pcap_buffer );
+	pcap_buffer = UNULL;
+	free ( pcap_name );
+	pcap_name = NULL;
+ err_inactive:
+	return rc;
+}
@@ -102,6 +102,16 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 #define PEERBLK_MAX_ATTEMPT_CYCLES 4
 
+/** PeerDist maximum number of consecutive peer download failures
+ *
+ * A peer that has failed this many consecutive download attempts will
+ * be skipped in favour of other peers, until the first full cycle of
+ * download attempts has been exhausted.
+ *
+ * This is a policy decision.
+ */
+#define PEERBLK_MAX_PEER_FAILURES 3
+
 /** PeerDist block download profiler */
 static struct profiler peerblk_download_profiler __profiler =
 	{ .name = "peerblk.download" };
@@ -153,6 +163,7 @@ static void peerblk_free ( struct refcnt *refcnt ) {
 		container_of ( refcnt, struct peerdist_block, refcnt );
 
 	uri_put ( peerblk->uri );
+	free ( peerblk->cipherbuf );
 	free ( peerblk->cipherctx );
 	free ( peerblk );
 }
@@ -171,6 +182,15 @@ static void peerblk_reset ( struct peerdist_block *peerblk, int rc ) {
 	/* Stop timer */
 	stop_timer ( &peerblk->timer );
 
+	/* Record result of any peer download attempt in progress */
+	if ( peerblk->busy ) {
+		assert ( peerblk->busy->inflight > 0 );
+		peerblk->busy->inflight--;
+		if ( rc != 0 )
+			peerblk->busy->failures++;
+		peerblk->busy = NULL;
+	}
+
 	/* Abort any current download attempt */
 	intf_restart ( &peerblk->raw, rc );
 	intf_restart ( &peerblk->retrieval, rc );
@@ -183,8 +203,10 @@ static void peerblk_reset ( struct peerdist_block *peerblk, int rc ) {
 	xferbuf_free ( &peerblk->buffer );
 	peerblk->pos = 0;
 
-	/* Reset digest and free cipher context */
+	/* Reset digest and free cipher context and chunk buffer */
 	digest_init ( peerblk->digest, peerblk->digestctx );
+	free ( peerblk->cipherbuf );
+	peerblk->cipherbuf = NULL;
 	free ( peerblk->cipherctx );
 	peerblk->cipherctx = NULL;
 	peerblk->cipher = NULL;
@@ -329,6 +351,12 @@ static void peerblk_done ( struct peerdist_block *peerblk, int rc ) {
 	peer = ( ( peerblk->peer == head ) ? NULL : peerblk->peer );
 	peerdisc_stat ( &peerblk->xfer, peer, &segment->peers );
 
+	/* Update peer download history */
+	if ( peer ) {
+		peer->completed++;
+		peer->failures = 0;
+	}
+
 	/* Close download */
 	peerblk_close ( peerblk, 0 );
 	return;
@@ -1033,7 +1061,8 @@ static int peerblk_parse_iv ( struct peerdist_block *peerblk, size_t buf_len,
 	}
 
 	/* Set initialisation vector */
-	cipher_setiv ( peerblk->cipher, peerblk->cipherctx, msg->msg.iv.data );
+	cipher_setiv ( peerblk->cipher, peerblk->cipherctx, msg->msg.iv.data,
+		       blksize );
 
 	return 0;
 }
@@ -1145,12 +1174,9 @@ static void peerblk_decrypt ( struct peerdist_block *peerblk ) {
 		digest_len = peerblk->digest_remaining;
 	assert ( ( cipher_len & ( cipher->blocksize - 1 ) ) == 0 );
 
-	/* Allocate temporary data buffer */
-	data = malloc ( cipher_len );
-	if ( ! data ) {
-		rc = -ENOMEM;
-		goto err_alloc_data;
-	}
+	/* Use preallocated chunk buffer */
+	data = peerblk->cipherbuf;
+	assert ( data != NULL );
 
 	/* Read ciphertext */
 	if ( ( rc = peerblk_decrypt_read ( peerblk, data, cipher_len ) ) != 0 ){
@@ -1178,9 +1204,6 @@ static void peerblk_decrypt ( struct peerdist_block *peerblk ) {
 	peerblk->cipher_remaining -= cipher_len;
 	peerblk->digest_remaining -= digest_len;
 
-	/* Free temporary data buffer */
-	free ( data );
-
 	/* Continue processing until all input is consumed */
 	if ( peerblk->cipher_remaining )
 		return;
@@ -1191,8 +1214,6 @@ static void peerblk_decrypt ( struct peerdist_block *peerblk ) {
 
  err_write:
  err_read:
-	free ( data );
- err_alloc_data:
  err_xfer_buffer:
 	peerblk_done ( peerblk, rc );
 }
@@ -1247,6 +1268,16 @@ static void peerblk_retrieval_close ( struct peerdist_block *peerblk, int rc ) {
 		goto done;
 	}
 
+	/* Allocate decryption chunk buffer.  Freeing the chunk buffer
+	 * (on error or otherwise) is handled by peerblk_reset().
+	 */
+	assert ( peerblk->cipherbuf == NULL );
+	peerblk->cipherbuf = malloc ( PEERBLK_DECRYPT_CHUNKSIZE );
+	if ( ! peerblk->cipherbuf ) {
+		rc = -ENOMEM;
+		goto done;
+	}
+
 	/* Stop the download attempt timer: there is no point in
 	 * timing out while decrypting.
 	 */
@@ -1268,6 +1299,50 @@ static void peerblk_retrieval_close ( struct peerdist_block *peerblk, int rc ) {
  ******************************************************************************
  */
 
+/**
+ * Choose best peer for next download attempt
+ *
+ * @v peerblk		PeerDist block download
+ * @ret peer		Chosen peer, or NULL if no peers remain
+ *
+ * Choose from among the peers not yet attempted within this cycle
+ * (i.e. from the current position onwards within the discovered peer
+ * list), preferring peers with the fewest download attempts currently
+ * in progress.  Concurrent block downloads therefore fan out across
+ * the available peers, and faster peers (which complete their
+ * downloads sooner, and so tend to have fewer attempts in progress)
+ * are automatically offered a larger share of the blocks.
+ */
+static struct peerdisc_peer *
+peerblk_choose ( struct peerdist_block *peerblk ) {
+	struct peerdisc_segment *segment = peerblk->discovery.segment;
+	struct peerdisc_peer *peer = peerblk->peer;
+	struct peerdisc_peer *best = NULL;
+
+	/* Choose best remaining peer */
+	list_for_each_entry_continue ( peer, &segment->peers, list ) {
+
+		/* Skip peers with a history of consecutive failures,
+		 * except in later attempt cycles.
+		 */
+		if ( ( peerblk->cycles == 0 ) &&
+		     ( peer->failures >= PEERBLK_MAX_PEER_FAILURES ) )
+			continue;
+
+		/* Prefer peers with fewer download attempts in
+		 * progress, breaking ties in favour of peers with a
+		 * longer history of successful downloads.
+		 */
+		if ( ( best == NULL ) ||
+		     ( peer->inflight < best->inflight ) ||
+		     ( ( peer->inflight == best->inflight ) &&
+		       ( peer->completed > best->completed ) ) )
+			best = peer;
+	}
+
+	return best;
+}
+
 /**
  * Handle PeerDist retry timer expiry
  *
@@ -1279,6 +1354,7 @@ static void peerblk_expired ( struct retry_timer *timer, int over __unused ) {
 		container_of ( timer, struct peerdist_block, timer );
 	struct peerdisc_segment *segment = peerblk->discovery.segment;
 	struct peerdisc_peer *head;
+	struct peerdisc_peer *peer;
 	unsigned long now = peerblk_timestamp();
 	const char *location;
 	int rc;
@@ -1326,22 +1402,26 @@ static void peerblk_expired ( struct retry_timer *timer, int over __unused ) {
 	if ( peerblk->peer == NULL )
 		peerblk->peer = head;
 
-	/* Attempt retrieval protocol download from next usable peer */
-	list_for_each_entry_continue ( peerblk->peer, &segment->peers, list ) {
+	/* Attempt retrieval protocol download from best remaining peer */
+	while ( ( peer = peerblk_choose ( peerblk ) ) != NULL ) {
 
 		/* Attempt retrieval protocol download from this peer */
-		location = peerblk->peer->location;
+		peerblk->peer = peer;
+		location = peer->location;
 		if ( ( rc = peerblk_retrieval_open ( peerblk,
 						     location ) ) != 0 ) {
 			/* Non-fatal: continue to try next peer */
 			continue;
 		}
 
-		/* Peer download started */
+		/* Peer download started: record attempt in progress */
+		peerblk->busy = peer;
+		peer->inflight++;
 		return;
 	}
 
-	/* Add to raw download queue */
+	/* Move to end of peer list and add to raw download queue */
+	peerblk->peer = head;
 	peerblk_enqueue ( peerblk, &peerblk_raw_queue );
 
 	return;
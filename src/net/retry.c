@@ -48,9 +48,31 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 #define MIN_TIMEOUT 7
 
-/** List of running timers */
+/** List of running timers, sorted by increasing expiry time */
 static LIST_HEAD ( timers );
 
+/**
+ * Insert timer into list of running timers
+ *
+ * @v timer		Retry timer
+ *
+ * The list is kept sorted by increasing expiry time, so that the head
+ * of the list is always the next timer due to expire and expiry
+ * checks need never scan the whole list.
+ */
+static void timer_insert ( struct retry_timer *timer ) {
+	struct retry_timer *after;
+
+	/* Later-expiring timers will tend to have been started more
+	 * recently, so search backwards from the tail of the list.
+	 */
+	list_for_each_entry_reverse ( after, &timers, list ) {
+		if ( ( ( signed long ) ( timer->expiry - after->expiry ) ) >= 0 )
+			break;
+	}
+	list_add ( &timer->list, &after->list );
+}
+
 /**
  * Start timer with a specified timeout
  *
@@ -63,21 +85,24 @@ static LIST_HEAD ( timers );
  */
 void start_timer_fixed ( struct retry_timer *timer, unsigned long timeout ) {
 
-	/* Add to list of running timers (if applicable) */
-	if ( ! timer->running ) {
-		list_add ( &timer->list, &timers );
+	/* Remove from list of running timers (if applicable) */
+	if ( timer->running ) {
+		list_del ( &timer->list );
+	} else {
 		ref_get ( timer->refcnt );
 		timer->running = 1;
 	}
 
-	/* Record start time */
+	/* Record start time, timeout, and expiry time */
 	timer->start = currticks();
-
-	/* Record timeout */
 	timer->timeout = timeout;
+	timer->expiry = ( timer->start + timeout );
+
+	/* Add to list of running timers in expiry order */
+	timer_insert ( timer );
 
 	DBGC2 ( timer, "Timer %p started at time %ld (expires at %ld)\n",
-		timer, timer->start, ( timer->start + timer->timeout ) );
+		timer, timer->start, timer->expiry );
 }
 
 /**
@@ -196,23 +221,58 @@ static void timer_expired ( struct retry_timer *timer ) {
  */
 void retry_poll ( void ) {
 	struct retry_timer *timer;
-	unsigned long now = currticks();
-	unsigned long used;
 
 	/* Process at most one timer expiry.  We cannot process
 	 * multiple expiries in one pass, because one timer expiring
 	 * may end up triggering another timer's deletion from the
 	 * list.
+	 *
+	 * The list is sorted by expiry time, so only the head of the
+	 * list can ever be due to expire.
 	 */
-	list_for_each_entry ( timer, &timers, list ) {
-		used = ( now - timer->start );
-		if ( used >= timer->timeout ) {
-			timer_expired ( timer );
-			break;
-		}
+	timer = list_first_entry ( &timers, struct retry_timer, list );
+	if ( timer &&
+	     ( ( ( signed long ) ( currticks() - timer->expiry ) ) >= 0 ) ) {
+		timer_expired ( timer );
 	}
 }
 
+/**
+ * Get time remaining until next timer expiry
+ *
+ * @ret deadline	Ticks until next timer expiry, or -1UL if no
+ *			timers are running
+ */
+unsigned long retry_deadline ( void ) {
+	struct retry_timer *timer;
+	signed long remaining;
+
+	/* The list is sorted by expiry time, so the nearest deadline
+	 * is always that of the head of the list.
+	 */
+	timer = list_first_entry ( &timers, struct retry_timer, list );
+	if ( ! timer )
+		return -1UL;
+	remaining = ( timer->expiry - currticks() );
+
+	return ( ( remaining > 0 ) ? ( ( unsigned long ) remaining ) : 0 );
+}
+
+/**
+ * Check for timers due to expire
+ *
+ * @ret busy		Polling must continue
+ */
+static int retry_busy ( void ) {
+	return ( retry_deadline() == 0 );
+}
+
+/** Retry timer idle check */
+struct idle_check retry_idle_check __idle_check = {
+	.name = "retry",
+	.busy = retry_busy,
+};
+
 /**
  * Single-step the retry timer list
  *
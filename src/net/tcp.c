@@ -15,9 +15,11 @@
 #include <ipxe/open.h>
 #include <ipxe/uri.h>
 #include <ipxe/netdevice.h>
+#include <ipxe/settings.h>
 #include <ipxe/profile.h>
 #include <ipxe/process.h>
 #include <ipxe/job.h>
+#include <ipxe/boottrace.h>
 #include <ipxe/tcpip.h>
 #include <ipxe/tcp.h>
 
@@ -81,6 +83,21 @@ struct tcp_connection {
 	 * Equivalent to RCV.WND in RFC 793 terminology.
 	 */
 	uint32_t rcv_win;
+	/** Maximum receive window
+	 *
+	 * Taken from the "rxwindow" setting (if specified) at the time
+	 * the connection is opened, and defaulting to
+	 * @c TCP_MAX_WINDOW_SIZE.
+	 */
+	uint32_t max_rcv_win;
+	/** Receive window pacing limit
+	 *
+	 * Grows with delivered data (and halves on each new loss
+	 * event), pacing the peer's transmission rate via the
+	 * advertised window in lieu of a sender-side congestion
+	 * window.
+	 */
+	uint32_t rcv_win_limit;
 	/** Received timestamp value
 	 *
 	 * Updated when a packet is received; copied to ts_recent when
@@ -106,8 +123,35 @@ struct tcp_connection {
 	/** Selective acknowledgement list (in host-endian order) */
 	struct tcp_sack_block sack[TCP_SACK_MAX];
 
+	/** Transmit selective acknowledgement scoreboard (in host-endian
+	 * order)
+	 *
+	 * Records ranges beyond SND.UNA that the peer has reported as
+	 * held via received SACK options, allowing retransmissions to
+	 * omit data that the peer already has.
+	 */
+	struct tcp_sack_block snd_sack[TCP_SACK_MAX];
+
 	/** Transmit queue */
 	struct list_head tx_queue;
+	/** Transmit queue length
+	 *
+	 * Total length of data currently in the transmit queue,
+	 * maintained to avoid walking the queue just to measure it on
+	 * every transmission.
+	 */
+	size_t tx_len;
+	/** Transmit rate limit
+	 *
+	 * Taken from the "txrate" setting (if specified) at the time
+	 * the connection is opened, in bytes per second.  Zero leaves
+	 * the connection unshaped.
+	 */
+	unsigned long tx_rate;
+	/** Transmit token bucket quota (in bytes) */
+	unsigned long tx_quota;
+	/** Transmit token bucket refill timestamp (in ticks) */
+	unsigned long tx_refill;
 	/** Receive queue */
 	struct list_head rx_queue;
 	/** Transmission process */
@@ -116,6 +160,14 @@ struct tcp_connection {
 	struct retry_timer timer;
 	/** Keepalive timer */
 	struct retry_timer keepalive;
+	/** Keepalive probes sent without eliciting any response */
+	unsigned int keepalives;
+	/** Delayed acknowledgement timer */
+	struct retry_timer delack;
+	/** In-sequence data segments received since the last
+	 * acknowledgement was transmitted
+	 */
+	unsigned int delack_count;
 	/** Shutdown (TIME_WAIT) timer */
 	struct retry_timer wait;
 
@@ -167,6 +219,56 @@ struct tcp_rx_queued_header {
  */
 static LIST_HEAD ( tcp_conns );
 
+/** TCP receive window size setting
+ *
+ * Allows the default maximum receive window to be overridden for
+ * high bandwidth-delay product paths (e.g. fast datacenter links),
+ * where @c TCP_MAX_WINDOW_SIZE would otherwise limit throughput.
+ */
+const struct setting tcp_rxwindow_setting __setting ( SETTING_MISC,
+						      rxwindow ) = {
+	.name = "rxwindow",
+	.description = "TCP receive window size",
+	.type = &setting_type_uint32,
+};
+
+/** TCP transmit rate limit setting
+ *
+ * Allows scripts to shape individual connections (e.g. to prevent a
+ * background image prefetch from starving production traffic on a
+ * shared WAN link) without shaping at the switch.  Expressed in bytes
+ * per second; zero or unset leaves the connection unshaped.
+ */
+const struct setting tcp_txrate_setting __setting ( SETTING_MISC, txrate ) = {
+	.name = "txrate",
+	.description = "TCP transmit rate limit",
+	.type = &setting_type_uint32,
+};
+
+/** TCP timeout cap setting
+ *
+ * A non-zero value (in milliseconds) caps the retransmission backoff
+ * interval and the keepalive probe interval for subsequently opened
+ * connections.  A capped connection gives up on an unresponsive peer
+ * within a few multiples of the cap, allowing a downloader's retry or
+ * fallback logic to engage in seconds rather than minutes.  Mean time
+ * to fallback often matters more than per-connection persistence when
+ * booting against replicated servers.
+ */
+const struct setting tcp_timeout_setting __setting ( SETTING_MISC,
+						     tcp-timeout ) = {
+	.name = "tcp-timeout",
+	.description = "TCP timeout cap",
+	.type = &setting_type_uint32,
+};
+
+/** Traffic shaper token bucket depth divisor
+ *
+ * The token bucket holds at most this fraction of one second's worth
+ * of data, limiting the burst size after an idle period.
+ */
+#define TCP_SHAPER_BURST_DIV 8
+
 /** Transmit profiler */
 static struct profiler tcp_tx_profiler __profiler = { .name = "tcp.tx" };
 
@@ -176,11 +278,22 @@ static struct profiler tcp_rx_profiler __profiler = { .name = "tcp.rx" };
 /** Data transfer profiler */
 static struct profiler tcp_xfer_profiler __profiler = { .name = "tcp.xfer" };
 
+/** Ingress-to-delivery latency profiler
+ *
+ * This measures from the ingress timestamp recorded by netdev_rx() to
+ * the end of TCP receive processing (including reassembly and
+ * delivery), capturing latency accumulated anywhere in the receive
+ * path rather than just within tcp_rx() itself.
+ */
+static struct profiler tcp_latency_profiler __profiler =
+	{ .name = "tcp.latency" };
+
 /* Forward declarations */
 static struct process_descriptor tcp_process_desc;
 static struct interface_descriptor tcp_xfer_desc;
 static void tcp_expired ( struct retry_timer *timer, int over );
 static void tcp_keepalive_expired ( struct retry_timer *timer, int over );
+static void tcp_delack_expired ( struct retry_timer *timer, int over );
 static void tcp_wait_expired ( struct retry_timer *timer, int over );
 static struct tcp_connection * tcp_demux ( unsigned int local_port );
 static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
@@ -221,6 +334,8 @@ tcp_dump_state ( struct tcp_connection *tcp ) {
 		DBGC ( tcp, "TCP %p transitioned from %s to %s\n", tcp,
 		       tcp_state ( tcp->prev_tcp_state ),
 		       tcp_state ( tcp->tcp_state ) );
+		tracepoint ( 1, "TCP %d %s", tcp->local_port,
+			     tcp_state ( tcp->tcp_state ) );
 	}
 	tcp->prev_tcp_state = tcp->tcp_state;
 }
@@ -275,6 +390,10 @@ static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
 	struct sockaddr_tcpip *st_peer = ( struct sockaddr_tcpip * ) peer;
 	struct sockaddr_tcpip *st_local = ( struct sockaddr_tcpip * ) local;
 	struct tcp_connection *tcp;
+	unsigned long rxwindow = 0;
+	unsigned long txrate = 0;
+	unsigned long timeout = 0;
+	uint32_t max_representable_win;
 	size_t mtu;
 	int port;
 	int rc;
@@ -289,6 +408,7 @@ static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
 	process_init_stopped ( &tcp->process, &tcp_process_desc, &tcp->refcnt );
 	timer_init ( &tcp->timer, tcp_expired, &tcp->refcnt );
 	timer_init ( &tcp->keepalive, tcp_keepalive_expired, &tcp->refcnt );
+	timer_init ( &tcp->delack, tcp_delack_expired, &tcp->refcnt );
 	timer_init ( &tcp->wait, tcp_wait_expired, &tcp->refcnt );
 	tcp->prev_tcp_state = TCP_CLOSED;
 	tcp->tcp_state = TCP_STATE_SENT ( TCP_SYN );
@@ -308,6 +428,30 @@ static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
 	}
 	tcp->mss = ( mtu - sizeof ( struct tcp_header ) );
 
+	/* Determine maximum receive window */
+	fetch_uint_setting ( NULL, &tcp_rxwindow_setting, &rxwindow );
+	if ( ! rxwindow )
+		rxwindow = TCP_MAX_WINDOW_SIZE;
+	max_representable_win = ( 0xffff << TCP_RX_WINDOW_SCALE );
+	if ( rxwindow > max_representable_win )
+		rxwindow = max_representable_win;
+	tcp->max_rcv_win = rxwindow;
+	tcp->rcv_win_limit = TCP_INIT_WINDOW_SIZE;
+
+	/* Determine transmit rate limit, if any, and allow an initial
+	 * quota of one path MTU so that the first segment is never
+	 * delayed.
+	 */
+	fetch_uint_setting ( NULL, &tcp_txrate_setting, &txrate );
+	tcp->tx_rate = txrate;
+	tcp->tx_quota = TCP_PATH_MTU;
+	tcp->tx_refill = currticks();
+
+	/* Cap timeouts, if applicable */
+	fetch_uint_setting ( NULL, &tcp_timeout_setting, &timeout );
+	if ( timeout )
+		tcp->timer.max = ( timeout * TICKS_PER_MS );
+
 	/* Bind to local port */
 	port = tcpip_bind ( st_local, tcp_port_available );
 	if ( port < 0 ) {
@@ -323,7 +467,7 @@ static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
 	start_timer_nodelay ( &tcp->timer );
 
 	/* Add a pending operation for the SYN */
-	pending_get ( &tcp->pending_flags );
+	pending_get ( &tcp->pending_flags, "TCP flags" );
 
 	/* Attach parent interface, transfer reference to connection
 	 * list and return
@@ -376,6 +520,7 @@ static void tcp_close ( struct tcp_connection *tcp, int rc ) {
 			free_iob ( iobuf );
 			pending_put ( &tcp->pending_data );
 		}
+		tcp->tx_len = 0;
 		assert ( ! is_pending ( &tcp->pending_data ) );
 
 		/* Remove pending operations for SYN and FIN, if applicable */
@@ -386,6 +531,7 @@ static void tcp_close ( struct tcp_connection *tcp, int rc ) {
 		process_del ( &tcp->process );
 		stop_timer ( &tcp->timer );
 		stop_timer ( &tcp->keepalive );
+		stop_timer ( &tcp->delack );
 		stop_timer ( &tcp->wait );
 		list_del ( &tcp->list );
 		ref_put ( &tcp->refcnt );
@@ -412,7 +558,7 @@ static void tcp_close ( struct tcp_connection *tcp, int rc ) {
 		process_add ( &tcp->process );
 
 		/* Add a pending operation for the FIN */
-		pending_get ( &tcp->pending_flags );
+		pending_get ( &tcp->pending_flags, "TCP flags" );
 	}
 }
 
@@ -444,6 +590,60 @@ static size_t tcp_xmit_win ( struct tcp_connection *tcp ) {
 	return len;
 }
 
+/**
+ * Apply traffic shaping to a proposed transmission length
+ *
+ * @v tcp		TCP connection
+ * @v len		Proposed transmission length
+ * @ret len		Permitted transmission length
+ *
+ * Refills the token bucket and clamps the transmission length to the
+ * available quota.  If the length is clamped, the transmission
+ * process is rescheduled so that the remainder is sent as further
+ * quota accrues.
+ */
+static size_t tcp_shaper_clamp ( struct tcp_connection *tcp, size_t len ) {
+	unsigned long elapsed;
+	unsigned long burst;
+
+	/* Do nothing unless a transmit rate limit is in force */
+	if ( ! tcp->tx_rate )
+		return len;
+
+	/* Refill token bucket.  The rate is split into whole-tick and
+	 * sub-tick components to avoid arithmetic overflow at high
+	 * rates.  The bucket depth is bounded below by one path MTU to
+	 * guarantee forward progress at very low rates.
+	 */
+	burst = ( tcp->tx_rate / TCP_SHAPER_BURST_DIV );
+	if ( burst < TCP_PATH_MTU )
+		burst = TCP_PATH_MTU;
+	elapsed = ( currticks() - tcp->tx_refill );
+	if ( elapsed ) {
+		tcp->tx_refill += elapsed;
+		if ( elapsed > TICKS_PER_SEC )
+			elapsed = TICKS_PER_SEC;
+		tcp->tx_quota += ( ( tcp->tx_rate / TICKS_PER_SEC ) * elapsed );
+		tcp->tx_quota += ( ( ( tcp->tx_rate % TICKS_PER_SEC ) *
+				     elapsed ) / TICKS_PER_SEC );
+		if ( tcp->tx_quota > burst )
+			tcp->tx_quota = burst;
+	}
+
+	/* Clamp transmission length to the available quota.  As with
+	 * deferral due to a congested transmit queue, the process will
+	 * recheck on each step until the backlog has drained.
+	 */
+	if ( len > tcp->tx_quota ) {
+		DBGC2 ( tcp, "TCP %p shaping %zd to %ld bytes\n",
+			tcp, len, tcp->tx_quota );
+		len = tcp->tx_quota;
+		process_add ( &tcp->process );
+	}
+
+	return len;
+}
+
 /**
  * Check data-transfer flow control window
  *
@@ -551,6 +751,46 @@ static unsigned int tcp_sack ( struct tcp_connection *tcp, uint32_t seq ) {
 	return new;
 }
 
+/**
+ * Calculate length to transmit, omitting data already held by the peer
+ *
+ * @v tcp		TCP connection
+ * @v len		Length of outstanding data
+ * @ret len		Length of data requiring (re)transmission
+ *
+ * If the peer has selectively acknowledged the tail of our
+ * outstanding data, then a retransmission need cover only the missing
+ * prefix; the peer will acknowledge the whole range cumulatively once
+ * that prefix arrives.
+ */
+static size_t tcp_xmit_unsacked ( struct tcp_connection *tcp, size_t len ) {
+	struct tcp_sack_block *sack;
+	uint32_t left;
+	unsigned int i;
+
+	for ( i = 0 ; i < TCP_SACK_MAX ; i++ ) {
+		sack = &tcp->snd_sack[i];
+
+		/* Skip empty scoreboard entries */
+		if ( sack->left == sack->right )
+			continue;
+
+		/* Skip blocks which do not cover the tail of the
+		 * outstanding data, since omitting data from the
+		 * middle of a segment would leave a hole.
+		 */
+		if ( tcp_cmp ( sack->right, ( tcp->snd_seq + len ) ) < 0 )
+			continue;
+
+		/* Trim to the unacknowledged prefix */
+		left = ( sack->left - tcp->snd_seq );
+		if ( left < len )
+			len = left;
+	}
+
+	return len;
+}
+
 /**
  * Process TCP transmit queue
  *
@@ -582,6 +822,7 @@ static size_t tcp_process_tx_queue ( struct tcp_connection *tcp, size_t max_len,
 		}
 		if ( remove ) {
 			iob_pull ( iobuf, frag_len );
+			tcp->tx_len -= frag_len;
 			if ( ! iob_len ( iobuf ) ) {
 				list_del ( &iobuf->list );
 				free_iob ( iobuf );
@@ -620,10 +861,12 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	unsigned int sack_count;
 	unsigned int i;
 	size_t len = 0;
+	size_t unsacked;
 	size_t sack_len;
 	uint32_t seq_len;
 	uint32_t max_rcv_win;
 	uint32_t max_representable_win;
+	struct net_device *netdev;
 	int rc;
 
 	/* Start profiling */
@@ -633,12 +876,34 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	if ( timer_running ( &tcp->timer ) )
 		return;
 
+	/* Defer data transmission if the underlying network device's
+	 * transmit queue is congested, provided that nothing else
+	 * (i.e. a SYN, FIN, or pending ACK) needs to be sent
+	 * immediately.  Transmissions are thereby clocked off
+	 * transmit completions: the process will recheck on each
+	 * step until the backlog has drained.
+	 */
+	if ( tcp->tx_len && TCP_CAN_SEND_DATA ( tcp->tcp_state ) &&
+	     ( ! ( TCP_FLAGS_SENDING ( tcp->tcp_state ) &
+		   ( TCP_SYN | TCP_FIN ) ) ) &&
+	     ( ! ( tcp->flags & TCP_ACK_PENDING ) ) ) {
+		netdev = tcpip_netdev ( &tcp->peer );
+		if ( netdev && netdev_tx_congested ( netdev ) ) {
+			DBGC2 ( tcp, "TCP %p deferring transmission: %s TX "
+				"queue congested\n", tcp, netdev->name );
+			process_add ( &tcp->process );
+			return;
+		}
+	}
+
 	/* Calculate both the actual (payload) and sequence space
 	 * lengths that we wish to transmit.
 	 */
 	if ( TCP_CAN_SEND_DATA ( tcp->tcp_state ) ) {
-		len = tcp_process_tx_queue ( tcp, tcp_xmit_win ( tcp ),
-					     NULL, 0 );
+		len = tcp->tx_len;
+		if ( len > tcp_xmit_win ( tcp ) )
+			len = tcp_xmit_win ( tcp );
+		len = tcp_shaper_clamp ( tcp, len );
 	}
 	seq_len = len;
 	flags = TCP_FLAGS_SENDING ( tcp->tcp_state );
@@ -649,6 +914,22 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	}
 	tcp->snd_sent = seq_len;
 
+	/* Omit any trailing data already held by the peer, as recorded
+	 * in the transmit SACK scoreboard.  The omitted data remains
+	 * outstanding (and so still counts towards snd_sent); it will
+	 * be acknowledged cumulatively once the missing prefix arrives.
+	 * The FIN, if any, sequences after the omitted data and so must
+	 * also be withheld.
+	 */
+	unsacked = tcp_xmit_unsacked ( tcp, len );
+	if ( unsacked != len ) {
+		DBGC ( tcp, "TCP %p skipping SACKed %08x..%08x\n", tcp,
+		       ( ( uint32_t ) ( tcp->snd_seq + unsacked ) ),
+		       ( ( uint32_t ) ( tcp->snd_seq + len ) ) );
+		flags &= ~TCP_FIN;
+		len = unsacked;
+	}
+
 	/* If we have nothing to transmit, stop now */
 	if ( ( seq_len == 0 ) && ! ( tcp->flags & TCP_ACK_PENDING ) )
 		return;
@@ -676,8 +957,10 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 
 	/* Expand receive window if possible */
 	max_rcv_win = xfer_window ( &tcp->xfer );
-	if ( max_rcv_win > TCP_MAX_WINDOW_SIZE )
-		max_rcv_win = TCP_MAX_WINDOW_SIZE;
+	if ( max_rcv_win > tcp->max_rcv_win )
+		max_rcv_win = tcp->max_rcv_win;
+	if ( max_rcv_win > tcp->rcv_win_limit )
+		max_rcv_win = tcp->rcv_win_limit;
 	max_representable_win = ( 0xffff << tcp->rcv_win_scale );
 	if ( max_rcv_win > max_representable_win )
 		max_rcv_win = max_representable_win;
@@ -755,8 +1038,19 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 		return;
 	}
 
-	/* Clear ACK-pending flag */
+	/* Deduct transmitted data from the traffic shaping quota */
+	if ( tcp->tx_rate ) {
+		assert ( len <= tcp->tx_quota );
+		tcp->tx_quota -= len;
+	}
+
+	/* Clear ACK-pending flag.  Every transmitted segment carries
+	 * a current acknowledgement, so any delayed acknowledgement
+	 * is now moot.
+	 */
 	tcp->flags &= ~TCP_ACK_PENDING;
+	stop_timer ( &tcp->delack );
+	tcp->delack_count = 0;
 
 	profile_stop ( &tcp_tx_profiler );
 }
@@ -785,6 +1079,8 @@ static struct process_descriptor tcp_process_desc =
 static void tcp_expired ( struct retry_timer *timer, int over ) {
 	struct tcp_connection *tcp =
 		container_of ( timer, struct tcp_connection, timer );
+	size_t mtu;
+	size_t mss;
 
 	DBGC ( tcp, "TCP %p timer %s in %s for %08x..%08x %08x\n", tcp,
 	       ( over ? "expired" : "fired" ), tcp_state ( tcp->tcp_state ),
@@ -805,11 +1101,86 @@ static void tcp_expired ( struct retry_timer *timer, int over ) {
 		tcp_dump_state ( tcp );
 		tcp_close ( tcp, -ETIMEDOUT );
 	} else {
-		/* Otherwise, retransmit the packet */
+		/* Refresh MSS in case a smaller path MTU has since
+		 * been discovered: the lost segment may simply have
+		 * exceeded the path MTU.
+		 */
+		mtu = tcpip_mtu ( &tcp->peer );
+		if ( mtu ) {
+			mss = ( mtu - sizeof ( struct tcp_header ) );
+			if ( mss < tcp->mss )
+				tcp->mss = mss;
+		}
+
+		/* Retransmit the packet */
 		tcp_xmit ( tcp );
 	}
 }
 
+/**
+ * Transmit a keepalive probe
+ *
+ * @v tcp		TCP connection
+ * @ret rc		Return status code
+ */
+static int tcp_xmit_probe ( struct tcp_connection *tcp ) {
+	struct io_buffer *iobuf;
+	struct tcp_header *tcphdr;
+	int rc;
+
+	/* Allocate space for dataless TX buffer */
+	iobuf = alloc_iob ( TCP_MAX_HEADER_LEN );
+	if ( ! iobuf ) {
+		DBGC ( tcp, "TCP %p could not allocate iobuf for probe\n",
+		       tcp );
+		return -ENOMEM;
+	}
+	iob_reserve ( iobuf, TCP_MAX_HEADER_LEN );
+
+	/* Construct probe.  The sequence number is deliberately one
+	 * below the current send sequence (as for a conventional TCP
+	 * keepalive): the segment is therefore unacceptable to the
+	 * peer, which forces a live peer to respond with a current
+	 * ACK.
+	 */
+	tcphdr = iob_push ( iobuf, sizeof ( *tcphdr ) );
+	memset ( tcphdr, 0, sizeof ( *tcphdr ) );
+	tcphdr->src = htons ( tcp->local_port );
+	tcphdr->dest = tcp->peer.st_port;
+	tcphdr->seq = htonl ( tcp->snd_seq - 1 );
+	tcphdr->ack = htonl ( tcp->rcv_ack );
+	tcphdr->hlen = ( ( sizeof ( *tcphdr ) / 4 ) << 4 );
+	tcphdr->flags = TCP_ACK;
+	tcphdr->win = htons ( tcp->rcv_win >> tcp->rcv_win_scale );
+	tcphdr->csum = tcpip_chksum ( iobuf->data, iob_len ( iobuf ) );
+
+	/* Transmit packet */
+	if ( ( rc = tcpip_tx ( iobuf, &tcp_protocol, NULL, &tcp->peer,
+			       NULL, &tcphdr->csum ) ) != 0 ) {
+		DBGC ( tcp, "TCP %p could not transmit probe: %s\n",
+		       tcp, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Calculate keepalive probe interval
+ *
+ * @v tcp		TCP connection
+ * @ret interval	Interval (in ticks)
+ */
+static unsigned long tcp_keepalive_interval ( struct tcp_connection *tcp ) {
+	unsigned long interval = TCP_KEEPALIVE_DELAY;
+
+	/* Probe more aggressively when an overall timeout cap is set */
+	if ( tcp->timer.max && ( tcp->timer.max < interval ) )
+		interval = tcp->timer.max;
+
+	return interval;
+}
+
 /**
  * Keepalive timer expired
  *
@@ -821,18 +1192,44 @@ static void tcp_keepalive_expired ( struct retry_timer *timer,
 	struct tcp_connection *tcp =
 		container_of ( timer, struct tcp_connection, keepalive );
 
+	/* Terminate the connection if repeated probes have elicited
+	 * no response: the peer has silently died, and failing fast
+	 * lets the requestor's retry or fallback logic engage.
+	 */
+	if ( tcp->keepalives >= TCP_KEEPALIVE_COUNT ) {
+		DBGC ( tcp, "TCP %p peer unresponsive after %d keepalives\n",
+		       tcp, tcp->keepalives );
+		tcp->tcp_state = TCP_CLOSED;
+		tcp_dump_state ( tcp );
+		tcp_close ( tcp, -ETIMEDOUT );
+		return;
+	}
+	tcp->keepalives++;
+
 	DBGC ( tcp, "TCP %p sending keepalive\n", tcp );
 
 	/* Reset keepalive timer */
-	start_timer_fixed ( &tcp->keepalive, TCP_KEEPALIVE_DELAY );
+	start_timer_fixed ( &tcp->keepalive, tcp_keepalive_interval ( tcp ) );
 
-	/* Send keepalive.  We do this only to preserve or restore
-	 * state in intermediate devices (e.g. firewall NAT tables);
-	 * we don't actually care about eliciting a response to verify
-	 * that the peer is still alive.  We therefore send just a
-	 * pure ACK, to keep our transmit path simple.
+	/* Send keepalive probe.  This preserves or restores state in
+	 * intermediate devices (e.g. firewall NAT tables), and forces
+	 * a live peer to respond, thereby resetting the probe count.
 	 */
-	tcp->flags |= TCP_ACK_PENDING;
+	tcp_xmit_probe ( tcp );
+}
+
+/**
+ * Delayed acknowledgement timer expired
+ *
+ * @v timer		Delayed acknowledgement timer
+ * @v over		Failure indicator
+ */
+static void tcp_delack_expired ( struct retry_timer *timer,
+				 int over __unused ) {
+	struct tcp_connection *tcp =
+		container_of ( timer, struct tcp_connection, delack );
+
+	/* Transmit the deferred acknowledgement */
 	tcp_xmit ( tcp );
 }
 
@@ -989,7 +1386,8 @@ static int tcp_rx_opts ( struct tcp_connection *tcp,
 			min = sizeof ( *options->spopt );
 			break;
 		case TCP_OPTION_SACK:
-			/* Ignore received SACKs */
+			options->sackopt = data;
+			min = sizeof ( *options->sackopt );
 			break;
 		case TCP_OPTION_TS:
 			options->tsopt = data;
@@ -1046,6 +1444,13 @@ static void tcp_rx_seq ( struct tcp_connection *tcp, uint32_t seq_len ) {
 	/* Update timestamp */
 	tcp->ts_recent = tcp->ts_val;
 
+	/* Grow receive window pacing limit with delivered data
+	 * (doubling per round trip, as per slow start)
+	 */
+	tcp->rcv_win_limit += seq_len;
+	if ( tcp->rcv_win_limit > tcp->max_rcv_win )
+		tcp->rcv_win_limit = tcp->max_rcv_win;
+
 	/* Update SACK list */
 	for ( sack = 0 ; sack < TCP_SACK_MAX ; sack++ ) {
 		if ( tcp->sack[sack].left == tcp->sack[sack].right )
@@ -1141,8 +1546,11 @@ static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
 	tcp->snd_win = win;
 
 	/* Hold off (or start) the keepalive timer, if applicable */
-	if ( ! ( tcp->tcp_state & TCP_STATE_SENT ( TCP_FIN ) ) )
-		start_timer_fixed ( &tcp->keepalive, TCP_KEEPALIVE_DELAY );
+	if ( ! ( tcp->tcp_state & TCP_STATE_SENT ( TCP_FIN ) ) ) {
+		tcp->keepalives = 0;
+		start_timer_fixed ( &tcp->keepalive,
+				    tcp_keepalive_interval ( tcp ) );
+	}
 
 	/* Ignore ACKs that don't actually acknowledge any new data.
 	 * (In particular, do not stop the retransmission timer; this
@@ -1169,6 +1577,12 @@ static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
 	tcp->snd_seq = ack;
 	tcp->snd_sent = 0;
 
+	/* Clear the transmit SACK scoreboard; any still-relevant
+	 * blocks will be repopulated from the SACK option (if any)
+	 * within this same packet.
+	 */
+	memset ( tcp->snd_sack, 0, sizeof ( tcp->snd_sack ) );
+
 	/* Remove any acknowledged data from transmit queue */
 	tcp_process_tx_queue ( tcp, len, NULL, 1 );
 		
@@ -1181,12 +1595,57 @@ static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
 	     ( tcp->flags & TCP_XFER_CLOSED ) &&
 	     ! ( tcp->tcp_state & TCP_STATE_SENT ( TCP_FIN ) ) ) {
 		tcp->tcp_state |= TCP_STATE_SENT ( TCP_FIN );
-		pending_get ( &tcp->pending_flags );
+		pending_get ( &tcp->pending_flags, "TCP flags" );
 	}
 
 	return 0;
 }
 
+/**
+ * Handle TCP received selective acknowledgement
+ *
+ * @v tcp		TCP connection
+ * @v sackopt		Received SACK option
+ *
+ * Rebuilds the transmit SACK scoreboard from the peer's most recent
+ * report, so that retransmissions can omit data the peer already
+ * holds.
+ */
+static void tcp_rx_sack ( struct tcp_connection *tcp,
+			  const struct tcp_sack_option *sackopt ) {
+	const struct tcp_sack_block *block =
+		( ( ( const void * ) sackopt ) + sizeof ( *sackopt ) );
+	unsigned int count;
+	unsigned int sack = 0;
+	unsigned int i;
+	uint32_t left;
+	uint32_t right;
+
+	/* Rebuild scoreboard from this report */
+	memset ( tcp->snd_sack, 0, sizeof ( tcp->snd_sack ) );
+	count = ( ( sackopt->length - sizeof ( *sackopt ) ) /
+		  sizeof ( *block ) );
+	for ( i = 0 ; i < count ; i++, block++ ) {
+
+		/* Stop if we run out of scoreboard space */
+		if ( sack == TCP_SACK_MAX )
+			break;
+
+		/* Ignore malformed blocks and blocks not beyond SND.UNA */
+		left = ntohl ( block->left );
+		right = ntohl ( block->right );
+		if ( tcp_cmp ( right, left ) <= 0 )
+			continue;
+		if ( tcp_cmp ( left, tcp->snd_seq ) <= 0 )
+			continue;
+
+		/* Record block (in host-endian order) */
+		tcp->snd_sack[sack].left = left;
+		tcp->snd_sack[sack].right = right;
+		sack++;
+	}
+}
+
 /**
  * Handle TCP received data
  *
@@ -1329,13 +1788,29 @@ static void tcp_rx_enqueue ( struct tcp_connection *tcp, uint32_t seq,
 	tcpqhdr->nxt = nxt;
 	tcpqhdr->flags = flags;
 
-	/* Add to RX queue */
-	list_for_each_entry ( queued, &tcp->rx_queue, list ) {
+	/* Add to RX queue, scanning backwards from the tail since
+	 * segments most commonly arrive in ascending sequence order;
+	 * filling in behind an existing hole is then O(1) rather than
+	 * a walk over every queued segment.
+	 */
+	list_for_each_entry_reverse ( queued, &tcp->rx_queue, list ) {
 		tcpqhdr = queued->data;
 		if ( tcp_cmp ( seq, tcpqhdr->seq ) < 0 )
-			break;
+			continue;
+
+		/* Discard (rather than queue) a segment lying wholly
+		 * within one already queued, to keep the queue length
+		 * bounded when the peer retransmits into a large
+		 * window.
+		 */
+		if ( ( ! ( flags & TCP_FIN ) ) &&
+		     ( tcp_cmp ( nxt, tcpqhdr->nxt ) <= 0 ) ) {
+			free_iob ( iobuf );
+			return;
+		}
+		break;
 	}
-	list_add_tail ( &iobuf->list, &queued->list );
+	list_add ( &iobuf->list, &queued->list );
 }
 
 /**
@@ -1410,10 +1885,12 @@ static int tcp_rx ( struct io_buffer *iobuf,
 	size_t len;
 	uint32_t seq_len;
 	size_t old_xfer_window;
+	unsigned long rx_stamp;
 	int rc;
 
 	/* Start profiling */
 	profile_start ( &tcp_rx_profiler );
+	rx_stamp = ( PROFILING ? iobuf->rx_stamp : 0 );
 
 	/* Sanity check packet */
 	if ( iob_len ( iobuf ) < sizeof ( *tcphdr ) ) {
@@ -1435,13 +1912,15 @@ static int tcp_rx ( struct io_buffer *iobuf,
 		rc = -EINVAL;
 		goto discard;
 	}
-	csum = tcpip_continue_chksum ( pshdr_csum, iobuf->data,
-				       iob_len ( iobuf ) );
-	if ( csum != 0 ) {
-		DBG ( "TCP checksum incorrect (is %04x including checksum "
-		      "field, should be 0000)\n", csum );
-		rc = -EINVAL;
-		goto discard;
+	if ( ! ( iobuf->flags & IOB_FL_CSUM_OK ) ) {
+		csum = tcpip_continue_chksum ( pshdr_csum, iobuf->data,
+					       iob_len ( iobuf ) );
+		if ( csum != 0 ) {
+			DBG ( "TCP checksum incorrect (is %04x including "
+			      "checksum field, should be 0000)\n", csum );
+			rc = -EINVAL;
+			goto discard;
+		}
 	}
 	
 	/* Parse parameters from header and strip header */
@@ -1476,19 +1955,64 @@ static int tcp_rx ( struct io_buffer *iobuf,
 	/* Record old data-transfer window */
 	old_xfer_window = tcp_xfer_window ( tcp );
 
+	/* Calculate advertised window */
+	win = ( raw_win << tcp->snd_win_scale );
+
+	/* Header prediction: a segment carrying in-sequence data on
+	 * an established connection, bearing no flags other than ACK
+	 * and possibly PSH, acknowledging nothing new, leaving the
+	 * send window unchanged, carrying no SACK blocks, and
+	 * arriving while the reassembly queue is empty, is the
+	 * overwhelmingly common case during a loss-free bulk
+	 * transfer.  Dispatch it straight to data delivery after just
+	 * these few compares, bypassing the general-case flag
+	 * processing entirely.
+	 */
+	if ( ( tcp->tcp_state == TCP_ESTABLISHED ) &&
+	     ( ( flags & ~TCP_PSH ) == TCP_ACK ) &&
+	     ( seq == tcp->rcv_ack ) && ( len > 0 ) &&
+	     ( tcp_cmp ( seq, ( tcp->rcv_ack + tcp->rcv_win ) ) < 0 ) &&
+	     ( ack == tcp->snd_seq ) && ( win == tcp->snd_win ) &&
+	     ( ! options.sackopt ) && list_empty ( &tcp->rx_queue ) ) {
+
+		/* Hold off the keepalive timer, exactly as full ACK
+		 * processing would have done.
+		 */
+		tcp->keepalives = 0;
+		start_timer_fixed ( &tcp->keepalive,
+				    tcp_keepalive_interval ( tcp ) );
+
+		/* Deliver data directly to the application */
+		tcp_rx_data ( tcp, seq, iob_disown ( iobuf ) );
+
+		goto processed;
+	}
+
 	/* Handle ACK, if present */
 	if ( flags & TCP_ACK ) {
-		win = ( raw_win << tcp->snd_win_scale );
 		if ( ( rc = tcp_rx_ack ( tcp, ack, win ) ) != 0 ) {
 			tcp_xmit_reset ( tcp, st_src, tcphdr );
 			goto discard;
 		}
 	}
 
-	/* Force an ACK if this packet is out of order */
+	/* Update transmit SACK scoreboard, if applicable */
+	if ( options.sackopt )
+		tcp_rx_sack ( tcp, options.sackopt );
+
+	/* Force an ACK if this packet is out of order, and halve the
+	 * receive window pacing limit if this is a new loss event
+	 * (i.e. if the reassembly queue was previously empty; each
+	 * subsequent out-of-order arrival belongs to the same event).
+	 */
 	if ( ( tcp->tcp_state & TCP_STATE_RCVD ( TCP_SYN ) ) &&
 	     ( seq != tcp->rcv_ack ) ) {
 		tcp->flags |= TCP_ACK_PENDING;
+		if ( list_empty ( &tcp->rx_queue ) ) {
+			tcp->rcv_win_limit >>= 1;
+			if ( tcp->rcv_win_limit < TCP_INIT_WINDOW_SIZE )
+				tcp->rcv_win_limit = TCP_INIT_WINDOW_SIZE;
+		}
 	}
 
 	/* Handle SYN, if present */
@@ -1503,12 +2027,27 @@ static int tcp_rx ( struct io_buffer *iobuf,
 			goto discard;
 	}
 
-	/* Enqueue received data */
-	tcp_rx_enqueue ( tcp, seq, flags, iob_disown ( iobuf ) );
+	/* Deliver exactly in-sequence data straight to the application,
+	 * bypassing the reassembly queue and its internal header
+	 * entirely; this is the overwhelmingly common case during a
+	 * loss-free bulk transfer.  Anything else goes through the
+	 * reassembly queue as before.
+	 */
+	if ( ( tcp->tcp_state & TCP_STATE_RCVD ( TCP_SYN ) ) &&
+	     ( seq == tcp->rcv_ack ) && ( len > 0 ) &&
+	     ( ! ( flags & TCP_FIN ) ) &&
+	     ( tcp_cmp ( seq, ( tcp->rcv_ack + tcp->rcv_win ) ) < 0 ) &&
+	     list_empty ( &tcp->rx_queue ) ) {
+		tcp_rx_data ( tcp, seq, iob_disown ( iobuf ) );
+	} else {
+		/* Enqueue received data */
+		tcp_rx_enqueue ( tcp, seq, flags, iob_disown ( iobuf ) );
 
-	/* Process receive queue */
-	tcp_process_rx_queue ( tcp );
+		/* Process receive queue */
+		tcp_process_rx_queue ( tcp );
+	}
 
+ processed:
 	/* Dump out any state change as a result of the received packet */
 	tcp_dump_state ( tcp );
 
@@ -1516,11 +2055,25 @@ static int tcp_rx ( struct io_buffer *iobuf,
 	 * have received any out-of-order packets (i.e. if the receive
 	 * queue remains non-empty after processing) then send the ACK
 	 * immediately in order to trigger Fast Retransmission.
+	 * Conversely, delay the acknowledgement of an in-sequence
+	 * pure data segment on an established connection (when we
+	 * have no data of our own awaiting transmission): send one
+	 * acknowledgement per TCP_DELACK_MAX received segments, or on
+	 * expiry of the delayed acknowledgement timer, whichever
+	 * comes first.
 	 */
-	if ( list_empty ( &tcp->rx_queue ) ) {
-		process_add ( &tcp->process );
-	} else {
+	if ( ! list_empty ( &tcp->rx_queue ) ) {
 		tcp_xmit_sack ( tcp, seq );
+	} else if ( ( tcp->tcp_state == TCP_ESTABLISHED ) &&
+		    ( ( flags & ~TCP_PSH ) == TCP_ACK ) && ( len > 0 ) &&
+		    ( tcp->tx_len == 0 ) &&
+		    ( ++tcp->delack_count < TCP_DELACK_MAX ) ) {
+		if ( ! timer_running ( &tcp->delack ) ) {
+			start_timer_fixed ( &tcp->delack,
+					    TCP_DELACK_TIMEOUT );
+		}
+	} else {
+		process_add ( &tcp->process );
 	}
 
 	/* If this packet was the last we expect to receive, set up
@@ -1536,6 +2089,13 @@ static int tcp_rx ( struct io_buffer *iobuf,
 		xfer_window_changed ( &tcp->xfer );
 
 	profile_stop ( &tcp_rx_profiler );
+
+	/* Record overall ingress-to-delivery latency */
+	if ( PROFILING ) {
+		profile_custom ( &tcp_latency_profiler,
+				 ( profile_timestamp() - rx_stamp ) );
+	}
+
 	return 0;
 
  discard:
@@ -1694,10 +2254,11 @@ static int tcp_xfer_deliver ( struct tcp_connection *tcp,
 			      struct xfer_metadata *meta __unused ) {
 
 	/* Enqueue packet */
+	tcp->tx_len += iob_len ( iobuf );
 	list_add_tail ( &iobuf->list, &tcp->tx_queue );
 
 	/* Each enqueued packet is a pending operation */
-	pending_get ( &tcp->pending_data );
+	pending_get ( &tcp->pending_data, "TCP data" );
 
 	/* Transmit data, if possible */
 	tcp_xmit ( tcp );
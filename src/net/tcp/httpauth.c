@@ -31,8 +31,12 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <errno.h>
+#include <ipxe/list.h>
+#include <ipxe/uri.h>
 #include <ipxe/http.h>
 
 /**
@@ -54,6 +58,139 @@ static struct http_authentication * http_authentication ( const char *name ) {
 	return NULL;
 }
 
+/** An HTTP authentication session
+ *
+ * Records the most recently issued challenge for an origin server, so
+ * that subsequent connections to the same origin can authenticate
+ * preemptively instead of each paying a challenge round trip.
+ */
+struct http_auth_session {
+	/** List of authentication sessions */
+	struct list_head list;
+	/** Authentication scheme */
+	struct http_authentication *auth;
+	/** Origin URI scheme */
+	char *scheme;
+	/** Origin host */
+	char *host;
+	/** Origin port (if any) */
+	char *port;
+	/** Challenge (remaining "WWW-Authenticate" header line) */
+	char *challenge;
+};
+
+/** List of HTTP authentication sessions */
+static LIST_HEAD ( http_auth_sessions );
+
+/**
+ * Compare optional origin strings
+ *
+ * @v a		First string (may be NULL)
+ * @v b		Second string (may be NULL)
+ * @ret match	Strings match
+ */
+static int http_auth_match ( const char *a, const char *b ) {
+
+	if ( ( ! a ) || ( ! b ) )
+		return ( a == b );
+	return ( strcasecmp ( a, b ) == 0 );
+}
+
+/**
+ * Find authentication session for an origin
+ *
+ * @v uri		URI
+ * @ret session		Authentication session, or NULL
+ */
+static struct http_auth_session * http_auth_session ( struct uri *uri ) {
+	struct http_auth_session *session;
+
+	list_for_each_entry ( session, &http_auth_sessions, list ) {
+		if ( http_auth_match ( session->scheme, uri->scheme ) &&
+		     http_auth_match ( session->host, uri->host ) &&
+		     http_auth_match ( session->port, uri->port ) )
+			return session;
+	}
+
+	return NULL;
+}
+
+/**
+ * Free authentication session
+ *
+ * @v session		Authentication session
+ */
+static void http_auth_session_free ( struct http_auth_session *session ) {
+
+	list_del ( &session->list );
+	free ( session->scheme );
+	free ( session->host );
+	free ( session->port );
+	free ( session->challenge );
+	free ( session );
+}
+
+/**
+ * Record authentication session
+ *
+ * @v http		HTTP transaction
+ * @v auth		Authentication scheme
+ * @v line		Remaining "WWW-Authenticate" header line
+ *
+ * Failures are ignored: the session cache is purely an optimisation,
+ * and an uncached origin simply pays the challenge round trip again.
+ */
+static void http_auth_record ( struct http_transaction *http,
+			       struct http_authentication *auth,
+			       const char *line ) {
+	struct uri *uri = http->uri;
+	struct http_auth_session *session;
+	char *challenge;
+
+	/* Do nothing if scheme is bound to a single connection */
+	if ( auth->conn )
+		return;
+
+	/* Copy challenge */
+	challenge = strdup ( line );
+	if ( ! challenge )
+		return;
+
+	/* Reuse existing session, if any */
+	session = http_auth_session ( uri );
+	if ( ! session ) {
+
+		/* Create new session */
+		session = zalloc ( sizeof ( *session ) );
+		if ( ! session )
+			goto err_alloc;
+		if ( uri->scheme &&
+		     ( ! ( session->scheme = strdup ( uri->scheme ) ) ) )
+			goto err_origin;
+		if ( uri->host &&
+		     ( ! ( session->host = strdup ( uri->host ) ) ) )
+			goto err_origin;
+		if ( uri->port &&
+		     ( ! ( session->port = strdup ( uri->port ) ) ) )
+			goto err_origin;
+		list_add ( &session->list, &http_auth_sessions );
+	}
+
+	/* Record scheme and challenge */
+	session->auth = auth;
+	free ( session->challenge );
+	session->challenge = challenge;
+	return;
+
+ err_origin:
+	free ( session->scheme );
+	free ( session->host );
+	free ( session->port );
+	free ( session );
+ err_alloc:
+	free ( challenge );
+}
+
 /**
  * Parse HTTP "WWW-Authenticate" header
  *
@@ -64,6 +201,7 @@ static struct http_authentication * http_authentication ( const char *name ) {
 static int http_parse_www_authenticate ( struct http_transaction *http,
 					 char *line ) {
 	struct http_authentication *auth;
+	struct http_auth_session *session;
 	char *name;
 	int rc;
 
@@ -89,6 +227,23 @@ static int http_parse_www_authenticate ( struct http_transaction *http,
 		return 0;
 	http->response.auth.auth = auth;
 
+	/* If this challenge was received in response to a preloaded
+	 * authentication attempt, then the cached session is stale:
+	 * discard it and start afresh.
+	 */
+	if ( http->request.auth.challenge ) {
+		if ( ( session = http_auth_session ( http->uri ) ) )
+			http_auth_session_free ( session );
+		free ( http->request.auth.challenge );
+		memset ( &http->request.auth, 0,
+			 sizeof ( http->request.auth ) );
+	}
+
+	/* Record challenge for future preemptive authentication (before
+	 * parsing, which consumes the header line in situ).
+	 */
+	http_auth_record ( http, auth, line );
+
 	/* Parse remaining header line */
 	if ( ( rc = auth->parse ( http, line ) ) != 0 ) {
 		DBGC ( http, "HTTP %p could not parse %s WWW-Authenticate "
@@ -106,6 +261,52 @@ http_response_www_authenticate __http_response_header = {
 	.parse = http_parse_www_authenticate,
 };
 
+/**
+ * Preload authentication from a cached session
+ *
+ * @v http		HTTP transaction
+ * @ret auth		Authentication scheme, or NULL
+ */
+static struct http_authentication *
+http_auth_preload ( struct http_transaction *http ) {
+	struct http_request_auth *req = &http->request.auth;
+	struct http_auth_session *session;
+	struct http_authentication *auth;
+	int rc;
+
+	/* Do nothing unless a cached session exists for this origin */
+	session = http_auth_session ( http->uri );
+	if ( ! session )
+		return NULL;
+	auth = session->auth;
+
+	/* Take a per-transaction copy of the challenge, since the
+	 * parsed fields point into the (consumed) line and the cached
+	 * session may be invalidated while the transaction is live.
+	 */
+	req->challenge = strdup ( session->challenge );
+	if ( ! req->challenge )
+		return NULL;
+
+	/* Replay challenge and authenticate */
+	req->auth = auth;
+	http->response.auth.auth = auth;
+	if ( ( ( rc = auth->parse ( http, req->challenge ) ) != 0 ) ||
+	     ( ( rc = auth->authenticate ( http ) ) != 0 ) ) {
+		DBGC ( http, "HTTP %p could not preload %s authentication: "
+		       "%s\n", http, auth->name, strerror ( rc ) );
+		free ( req->challenge );
+		memset ( req, 0, sizeof ( *req ) );
+		memset ( &http->response.auth, 0,
+			 sizeof ( http->response.auth ) );
+		return NULL;
+	}
+
+	DBGC2 ( http, "HTTP %p preloaded %s authentication\n",
+		http, auth->name );
+	return auth;
+}
+
 /**
  * Construct HTTP "Authorization" header
  *
@@ -121,6 +322,10 @@ static int http_format_authorization ( struct http_transaction *http,
 	int auth_len;
 	int rc;
 
+	/* Authenticate preemptively from a cached session, if any */
+	if ( ! auth )
+		auth = http_auth_preload ( http );
+
 	/* Do nothing unless we have an authentication scheme */
 	if ( ! auth )
 		return 0;
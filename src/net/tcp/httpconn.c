@@ -32,6 +32,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <errno.h>
 #include <byteswap.h>
 #include <ipxe/tcpip.h>
@@ -45,9 +46,44 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** HTTP pooled connection expiry time */
 #define HTTP_CONN_EXPIRY ( 10 * TICKS_PER_SEC )
 
+/** Maximum number of pooled connections
+ *
+ * Each pooled connection holds an open TCP connection (and, for
+ * HTTPS, a full TLS session) until it expires.  Bound the pool so
+ * that fetches from many distinct servers cannot accumulate an
+ * arbitrary number of open connections; the least recently pooled
+ * connection is closed to make room.
+ */
+#define HTTP_CONN_POOL_MAX 4
+
 /** HTTP connection pool */
 static LIST_HEAD ( http_connection_pool );
 
+/** List of all HTTP connections (including pooled connections) */
+static LIST_HEAD ( http_connections );
+
+/** An HTTP connection waiter
+ *
+ * Represents a client waiting for an existing connection to the same
+ * server to become available, rather than opening an additional
+ * parallel connection.
+ */
+struct http_waiter {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** List of connection waiters */
+	struct list_head list;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Connection URI */
+	struct uri *uri;
+	/** HTTP scheme */
+	struct http_scheme *scheme;
+};
+
+/** List of HTTP connection waiters */
+static LIST_HEAD ( http_waiters );
+
 /**
  * Identify HTTP scheme
  *
@@ -70,6 +106,131 @@ static struct http_scheme * http_scheme ( struct uri *uri ) {
 	return NULL;
 }
 
+/**
+ * Free HTTP connection waiter
+ *
+ * @v refcnt		Reference count
+ */
+static void http_waiter_free ( struct refcnt *refcnt ) {
+	struct http_waiter *waiter =
+		container_of ( refcnt, struct http_waiter, refcnt );
+
+	uri_put ( waiter->uri );
+	free ( waiter );
+}
+
+/**
+ * Close HTTP connection waiter
+ *
+ * @v waiter		HTTP connection waiter
+ * @v rc		Reason for close
+ */
+static void http_waiter_close ( struct http_waiter *waiter, int rc ) {
+
+	/* Remove from list of waiters */
+	list_del ( &waiter->list );
+	INIT_LIST_HEAD ( &waiter->list );
+
+	/* Shut down interface */
+	intf_shutdown ( &waiter->xfer, rc );
+}
+
+/**
+ * Check flow control window
+ *
+ * @v waiter		HTTP connection waiter
+ * @ret len		Length of window
+ */
+static size_t http_waiter_window ( struct http_waiter *waiter __unused ) {
+
+	/* Not ready for data until a connection becomes available */
+	return 0;
+}
+
+/** HTTP connection waiter data transfer interface operations */
+static struct interface_operation http_waiter_xfer_operations[] = {
+	INTF_OP ( xfer_window, struct http_waiter *, http_waiter_window ),
+	INTF_OP ( intf_close, struct http_waiter *, http_waiter_close ),
+};
+
+/** HTTP connection waiter data transfer interface descriptor */
+static struct interface_descriptor http_waiter_xfer_desc =
+	INTF_DESC ( struct http_waiter, xfer, http_waiter_xfer_operations );
+
+/**
+ * Wait for an existing HTTP connection to become available
+ *
+ * @v xfer		Data transfer interface
+ * @v uri		Connection URI
+ * @v scheme		HTTP scheme
+ * @ret rc		Return status code
+ */
+static int http_wait ( struct interface *xfer, struct uri *uri,
+		       struct http_scheme *scheme ) {
+	struct http_waiter *waiter;
+
+	/* Allocate and initialise structure */
+	waiter = zalloc ( sizeof ( *waiter ) );
+	if ( ! waiter )
+		return -ENOMEM;
+	ref_init ( &waiter->refcnt, http_waiter_free );
+	intf_init ( &waiter->xfer, &http_waiter_xfer_desc, &waiter->refcnt );
+	waiter->uri = uri_get ( uri );
+	waiter->scheme = scheme;
+	list_add_tail ( &waiter->list, &http_waiters );
+
+	/* Attach parent interface, mortalise self, and return */
+	intf_plug_plug ( &waiter->xfer, xfer );
+	ref_put ( &waiter->refcnt );
+
+	DBGC2 ( waiter, "HTTPCONN %p waiting for %s://%s\n",
+		waiter, scheme->name, uri->host );
+	return 0;
+}
+
+/**
+ * Kick waiters matching an HTTP connection
+ *
+ * @v conn		HTTP connection
+ * @v all		Kick all matching waiters (rather than just one)
+ *
+ * Suggest that waiting clients reattempt their connections.  A client
+ * kicked after the connection has been pooled will pick up the pooled
+ * connection; a client kicked because the last connection to its
+ * server has died will fall back to opening a fresh connection.
+ */
+static void http_conn_kick ( struct http_connection *conn, int all ) {
+	struct http_scheme *scheme = conn->scheme;
+	unsigned int port = uri_port ( conn->uri, scheme->port );
+	struct http_waiter *waiter;
+	struct http_waiter *tmp;
+
+	list_for_each_entry_safe ( waiter, tmp, &http_waiters, list ) {
+
+		/* Skip waiters for other servers */
+		if ( ( waiter->scheme != scheme ) ||
+		     ( strcasecmp ( waiter->uri->host,
+				    conn->uri->host ) != 0 ) ||
+		     ( uri_port ( waiter->uri, scheme->port ) != port ) )
+			continue;
+
+		/* Remove from list of waiters and suggest that the
+		 * client reattempt its connection.  The client's
+		 * reattempt will close the waiter; close it ourselves
+		 * in case the client has no reopen handler.
+		 */
+		list_del ( &waiter->list );
+		INIT_LIST_HEAD ( &waiter->list );
+		DBGC2 ( waiter, "HTTPCONN %p kicked\n", waiter );
+		pool_reopen ( &waiter->xfer );
+		intf_shutdown ( &waiter->xfer, 0 );
+
+		/* Kick only a single waiter, unless instructed otherwise */
+		if ( ! all )
+			break;
+	}
+}
+
 /**
  * Free HTTP connection
  *
@@ -91,10 +252,32 @@ static void http_conn_free ( struct refcnt *refcnt ) {
  * @v rc		Reason for close
  */
 static void http_conn_close ( struct http_connection *conn, int rc ) {
+	struct http_connection *other;
+	int last = 1;
 
 	/* Remove from connection pool, if applicable */
 	pool_del ( &conn->pool );
 
+	/* Remove from list of connections */
+	list_del ( &conn->list );
+	INIT_LIST_HEAD ( &conn->list );
+
+	/* If this was the last connection to its server, kick any
+	 * waiters so that they fall back to opening fresh connections.
+	 */
+	list_for_each_entry ( other, &http_connections, list ) {
+		if ( ( other->scheme == conn->scheme ) &&
+		     ( strcasecmp ( other->uri->host,
+				    conn->uri->host ) == 0 ) &&
+		     ( uri_port ( other->uri, other->scheme->port ) ==
+		       uri_port ( conn->uri, conn->scheme->port ) ) ) {
+			last = 0;
+			break;
+		}
+	}
+	if ( last )
+		http_conn_kick ( conn, 1 );
+
 	/* Shut down interfaces */
 	intf_shutdown ( &conn->socket, rc );
 	intf_shutdown ( &conn->xfer, rc );
@@ -184,11 +367,34 @@ static void http_conn_xfer_close ( struct http_connection *conn, int rc ) {
 	 * error occurred.
 	 */
 	if ( ( rc == 0 ) && pool_is_recyclable ( &conn->pool ) ) {
+		struct http_connection *evictee;
+		unsigned int count = 0;
+
+		/* Close least recently pooled connection if the pool
+		 * is full
+		 */
+		list_for_each_entry ( evictee, &http_connection_pool,
+				      pool.list ) {
+			count++;
+		}
+		if ( count >= HTTP_CONN_POOL_MAX ) {
+			evictee = list_first_entry ( &http_connection_pool,
+						     struct http_connection,
+						     pool.list );
+			DBGC2 ( evictee, "HTTPCONN %p evicted %s://%s\n",
+				evictee, evictee->scheme->name,
+				evictee->uri->host );
+			http_conn_close ( evictee, 0 );
+		}
+
 		intf_restart ( &conn->xfer, rc );
 		pool_add ( &conn->pool, &http_connection_pool,
 			   HTTP_CONN_EXPIRY );
 		DBGC2 ( conn, "HTTPCONN %p pooled %s://%s\n",
 			conn, conn->scheme->name, conn->uri->host );
+
+		/* Hand over to a waiting client, if applicable */
+		http_conn_kick ( conn, 0 );
 		return;
 	}
 
@@ -266,7 +472,7 @@ int http_connect ( struct interface *xfer, struct uri *uri ) {
 
 		/* Reuse connection, if possible */
 		if ( ( scheme == conn->scheme ) &&
-		     ( strcmp ( uri->host, conn->uri->host ) == 0 ) &&
+		     ( strcasecmp ( uri->host, conn->uri->host ) == 0 ) &&
 		     ( port == uri_port ( conn->uri, scheme->port ) ) ) {
 
 			/* Remove from connection pool, stop timer,
@@ -280,6 +486,19 @@ int http_connect ( struct interface *xfer, struct uri *uri ) {
 		}
 	}
 
+	/* If a connection to this server is already in use, then wait
+	 * for it to become available rather than opening an additional
+	 * parallel connection.  (Any pooled connection to this server
+	 * would already have been reused above.)
+	 */
+	list_for_each_entry ( conn, &http_connections, list ) {
+		if ( ( scheme == conn->scheme ) &&
+		     ( strcasecmp ( uri->host, conn->uri->host ) == 0 ) &&
+		     ( port == uri_port ( conn->uri, scheme->port ) ) ) {
+			return http_wait ( xfer, uri, scheme );
+		}
+	}
+
 	/* Allocate and initialise structure */
 	conn = zalloc ( sizeof ( *conn ) );
 	if ( ! conn ) {
@@ -292,6 +511,7 @@ int http_connect ( struct interface *xfer, struct uri *uri ) {
 	intf_init ( &conn->socket, &http_conn_socket_desc, &conn->refcnt );
 	intf_init ( &conn->xfer, &http_conn_xfer_desc, &conn->refcnt );
 	pool_init ( &conn->pool, http_conn_expired, &conn->refcnt );
+	list_add ( &conn->list, &http_connections );
 
 	/* Open socket */
 	memset ( &server, 0, sizeof ( server ) );
@@ -80,6 +80,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define EIO_CONTENT_LENGTH __einfo_error ( EINFO_EIO_CONTENT_LENGTH )
 #define EINFO_EIO_CONTENT_LENGTH \
 	__einfo_uniqify ( EINFO_EIO, 0x02, "Content length mismatch" )
+#define EIO_RESUME __einfo_error ( EINFO_EIO_RESUME )
+#define EINFO_EIO_RESUME \
+	__einfo_uniqify ( EINFO_EIO, 0x03, "Resumed transfer refused" )
 #define EIO_4XX __einfo_error ( EINFO_EIO_4XX )
 #define EINFO_EIO_4XX \
 	__einfo_uniqify ( EINFO_EIO, 0x04, "HTTP 4xx Client Error" )
@@ -105,6 +108,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** Retry delay used when we cannot understand the Retry-After header */
 #define HTTP_RETRY_SECONDS 5
 
+/** Maximum number of attempts to resume an interrupted transfer */
+#define HTTP_RESUME_MAX 16
+
 /** Receive profiler */
 static struct profiler http_rx_profiler __profiler = { .name = "http.rx" };
 
@@ -264,6 +270,8 @@ static void http_free ( struct refcnt *refcnt ) {
 
 	empty_line_buffer ( &http->response.headers );
 	empty_line_buffer ( &http->linebuf );
+	free ( http->request.auth.challenge );
+	free ( http->validator );
 	uri_put ( http->uri );
 	free ( http );
 }
@@ -283,8 +291,8 @@ static void http_close ( struct http_transaction *http, int rc ) {
 	stop_timer ( &http->timer );
 
 	/* Close all interfaces */
-	intfs_shutdown ( rc, &http->conn, &http->transfer, &http->content,
-			 &http->xfer, NULL );
+	intfs_shutdown ( rc, &http->conn, &http->stream, &http->transfer,
+			 &http->content, &http->xfer, NULL );
 }
 
 /**
@@ -307,6 +315,18 @@ static void http_close_error ( struct http_transaction *http, int rc ) {
 static void http_reopen ( struct http_transaction *http ) {
 	int rc;
 
+	/* Fail if the request content is streamed and the request has
+	 * already been transmitted, since the body cannot be replayed
+	 * on a fresh connection.  (If the request has not yet been
+	 * transmitted then no body data has been consumed, since the
+	 * body stream window remains closed until after the headers
+	 * are sent.)
+	 */
+	if ( http->request.content.body && ( http->state != &http_request ) ) {
+		rc = -EPIPE;
+		goto err_stream;
+	}
+
 	/* Close existing connection */
 	intf_restart ( &http->conn, -ECANCELED );
 
@@ -326,6 +346,7 @@ static void http_reopen ( struct http_transaction *http ) {
 	return;
 
  err_connect:
+ err_stream:
 	http_close ( http, rc );
 }
 
@@ -359,6 +380,10 @@ static void http_step ( struct http_transaction *http ) {
 	if ( ! xfer_window ( &http->conn ) )
 		return;
 
+	/* Notify request body stream that window may have changed */
+	if ( http->request.content.body )
+		xfer_window_changed ( http->request.content.body );
+
 	/* Notify data transfer interface that window may have changed */
 	xfer_window_changed ( &http->xfer );
 
@@ -569,6 +594,128 @@ static struct interface_descriptor http_conn_desc =
 	INTF_DESC_PASSTHRU ( struct http_transaction, conn,
 			     http_conn_operations, transfer );
 
+/** Maximum length of a chunk header */
+#define HTTP_CHUNK_HDR_LEN ( ( 2 * sizeof ( size_t ) ) + 2 /* CRLF */ )
+
+/**
+ * Report request body stream flow control window
+ *
+ * @v http		HTTP transaction
+ * @ret len		Length of window
+ */
+static size_t http_stream_window ( struct http_transaction *http ) {
+
+	/* Do not accept body data until the request headers have
+	 * been sent
+	 */
+	if ( http->state == &http_request )
+		return 0;
+
+	return xfer_window ( &http->conn );
+}
+
+/**
+ * Handle received request body data
+ *
+ * @v http		HTTP transaction
+ * @v iobuf		I/O buffer
+ * @v meta		Transfer metadata
+ * @ret rc		Return status code
+ *
+ * This function takes ownership of the I/O buffer.
+ */
+static int http_stream_deliver ( struct http_transaction *http,
+				 struct io_buffer *iobuf,
+				 struct xfer_metadata *meta __unused ) {
+	struct io_buffer *chunk;
+	char hdr[ HTTP_CHUNK_HDR_LEN + 1 /* NUL */ ];
+	size_t len = iob_len ( iobuf );
+	size_t hdr_len;
+	int rc;
+
+	/* Ignore empty I/O buffers, since a zero-length chunk would
+	 * terminate the chunked body
+	 */
+	if ( ! len ) {
+		free_iob ( iobuf );
+		return 0;
+	}
+
+	/* Construct chunk header */
+	hdr_len = snprintf ( hdr, sizeof ( hdr ), "%zx\r\n", len );
+	assert ( hdr_len < sizeof ( hdr ) );
+
+	/* Allocate and construct chunk */
+	chunk = alloc_iob ( hdr_len + len + 2 /* CRLF */ );
+	if ( ! chunk ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	memcpy ( iob_put ( chunk, hdr_len ), hdr, hdr_len );
+	memcpy ( iob_put ( chunk, len ), iobuf->data, len );
+	memcpy ( iob_put ( chunk, 2 /* CRLF */ ), "\r\n", 2 );
+
+	/* Deliver chunk */
+	if ( ( rc = xfer_deliver_iob ( &http->conn,
+				       iob_disown ( chunk ) ) ) != 0 ) {
+		DBGC ( http, "HTTP %p could not deliver body chunk: %s\n",
+		       http, strerror ( rc ) );
+		goto err_deliver;
+	}
+
+	/* Free I/O buffer */
+	free_iob ( iobuf );
+
+	return 0;
+
+ err_deliver:
+ err_alloc:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Handle closure of request body stream
+ *
+ * @v http		HTTP transaction
+ * @v rc		Reason for close
+ */
+static void http_stream_close ( struct http_transaction *http, int rc ) {
+
+	/* An aborted body fails the transaction, since the server
+	 * would wait forever for the remaining chunks
+	 */
+	if ( rc != 0 ) {
+		http_close ( http, rc );
+		return;
+	}
+
+	/* Send terminating chunk */
+	if ( ( rc = xfer_printf ( &http->conn, "0\r\n\r\n" ) ) != 0 ) {
+		DBGC ( http, "HTTP %p could not terminate body: %s\n",
+		       http, strerror ( rc ) );
+		http_close ( http, rc );
+		return;
+	}
+
+	/* Shut down request body stream */
+	http->request.content.body = NULL;
+	intf_shutdown ( &http->stream, 0 );
+}
+
+/** HTTP request body stream interface operations */
+static struct interface_operation http_stream_operations[] = {
+	INTF_OP ( xfer_deliver, struct http_transaction *,
+		  http_stream_deliver ),
+	INTF_OP ( xfer_window, struct http_transaction *,
+		  http_stream_window ),
+	INTF_OP ( intf_close, struct http_transaction *, http_stream_close ),
+};
+
+/** HTTP request body stream interface descriptor */
+static struct interface_descriptor http_stream_desc =
+	INTF_DESC ( struct http_transaction, stream, http_stream_operations );
+
 /** HTTP process descriptor */
 static struct process_descriptor http_process_desc =
 	PROC_DESC_ONCE ( struct http_transaction, process, http_step );
@@ -631,6 +778,7 @@ int http_open ( struct interface *xfer, struct http_method *method,
 	intf_init ( &http->content, &http_content_desc, &http->refcnt );
 	intf_init ( &http->transfer, &http_transfer_desc, &http->refcnt );
 	intf_init ( &http->conn, &http_conn_desc, &http->refcnt );
+	intf_init ( &http->stream, &http_stream_desc, &http->refcnt );
 	intf_plug_plug ( &http->transfer, &http->content );
 	process_init ( &http->process, &http_process_desc, &http->refcnt );
 	timer_init ( &http->timer, http_expired, &http->refcnt );
@@ -647,6 +795,11 @@ int http_open ( struct interface *xfer, struct http_method *method,
 		http->request.content.data = content_data;
 		http->request.content.len = content_len;
 		memcpy ( content_data, content->data, content_len );
+		if ( content->body ) {
+			assert ( content_len == 0 );
+			http->request.content.body = &http->stream;
+			intf_plug_plug ( &http->stream, content->body );
+		}
 	}
 	http->state = &http_request;
 	DBGC2 ( http, "HTTP %p %s://%s%s\n", http, http->uri->scheme,
@@ -798,6 +951,79 @@ static int http_transfer_complete ( struct http_transaction *http ) {
 	return 0;
 }
 
+/**
+ * Attempt to resume an interrupted transfer
+ *
+ * @v http		HTTP transaction
+ * @ret rc		Return status code
+ *
+ * Reissue the request with a range covering only the remaining
+ * content, so that the content already delivered (e.g. into a
+ * download buffer) is not discarded and refetched.  The range request
+ * is made conditional on a validator from the original response, so
+ * that content which has changed on the server cannot be spliced
+ * together from mismatched transfers.
+ */
+static int http_resume ( struct http_transaction *http ) {
+	const char *validator;
+	char *copy;
+
+	/* Resume only if some content has already been delivered */
+	if ( ! http->len )
+		return -ECANCELED;
+
+	/* Resume only idempotent requests with no request body */
+	if ( http->request.method != &http_get )
+		return -ENOTSUP;
+	if ( http->request.content.len || http->request.content.body )
+		return -ENOTSUP;
+
+	/* Resume only if the total content length is known, and only
+	 * if the content is not subject to a content encoding (since
+	 * a range applies to the encoded byte stream).
+	 */
+	if ( ! ( http->response.flags & HTTP_RESPONSE_CONTENT_LEN ) )
+		return -ENOTSUP;
+	if ( http->response.content.encoding )
+		return -ENOTSUP;
+
+	/* Select a validator, preferring a strong entity tag */
+	validator = http->response.etag;
+	if ( ( ! validator ) || ( strncmp ( validator, "W/", 2 ) == 0 ) )
+		validator = http->response.last_modified;
+	if ( ! validator )
+		return -ENOTSUP;
+
+	/* Limit the number of resume attempts */
+	if ( http->resumed >= HTTP_RESUME_MAX )
+		return -ECANCELED;
+	http->resumed++;
+
+	/* Record validator */
+	copy = strdup ( validator );
+	if ( ! copy )
+		return -ENOMEM;
+	free ( http->validator );
+	http->validator = copy;
+
+	/* Adjust request range to cover only the remaining content */
+	http->request.range.start += http->len;
+	if ( http->request.range.len )
+		http->request.range.len -= http->len;
+
+	DBGC ( http, "HTTP %p resuming at %zd (validator \"%s\")\n",
+	       http, http->request.range.start, http->validator );
+
+	/* Reset accumulated length and mark transaction as resuming */
+	http->len = 0;
+	http->resuming = 1;
+
+	/* Reopen connection and reissue request */
+	http_reopen ( http );
+
+	return 0;
+}
+
 /******************************************************************************
  *
  * Requests
@@ -805,6 +1031,15 @@ static int http_transfer_complete ( struct http_transaction *http ) {
  ******************************************************************************
  */
 
+/** Transmitted header length guess
+ *
+ * Size (excluding the request URI, which is accounted for separately)
+ * assumed to be sufficient for the formatted request headers, so that
+ * they can be formatted in a single pass.  A guess that turns out to
+ * be too small costs only a reallocation and a second pass.
+ */
+#define HTTP_TX_HEADERS_GUESS 512
+
 /**
  * Construct HTTP request headers
  *
@@ -934,12 +1169,18 @@ struct http_request_header http_request_connection __http_request_header = {
 static int http_format_range ( struct http_transaction *http,
 			       char *buf, size_t len ) {
 
-	/* Construct range, if applicable */
+	/* Construct range, if applicable.  A range with a start but
+	 * no length (as used when resuming an interrupted transfer)
+	 * is open-ended.
+	 */
 	if ( http->request.range.len ) {
 		return snprintf ( buf, len, "bytes=%zd-%zd",
 				  http->request.range.start,
 				  ( http->request.range.start +
 				    http->request.range.len - 1 ) );
+	} else if ( http->request.range.start ) {
+		return snprintf ( buf, len, "bytes=%zd-",
+				  http->request.range.start );
 	} else {
 		return 0;
 	}
@@ -951,6 +1192,30 @@ struct http_request_header http_request_range __http_request_header = {
 	.format = http_format_range,
 };
 
+/**
+ * Construct HTTP "If-Range" header
+ *
+ * @v http		HTTP transaction
+ * @v buf		Buffer
+ * @v len		Length of buffer
+ * @ret len		Length of header value, or negative error
+ */
+static int http_format_if_range ( struct http_transaction *http,
+				  char *buf, size_t len ) {
+
+	/* Construct validator, if resuming an interrupted transfer */
+	if ( http->validator )
+		return snprintf ( buf, len, "%s", http->validator );
+
+	return 0;
+}
+
+/** HTTP "If-Range" header */
+struct http_request_header http_request_if_range __http_request_header = {
+	.name = "If-Range",
+	.format = http_format_if_range,
+};
+
 /**
  * Construct HTTP "Content-Type" header
  *
@@ -1001,6 +1266,31 @@ struct http_request_header http_request_content_length __http_request_header = {
 	.format = http_format_content_length,
 };
 
+/**
+ * Construct HTTP "Transfer-Encoding" header
+ *
+ * @v http		HTTP transaction
+ * @v buf		Buffer
+ * @v len		Length of buffer
+ * @ret len		Length of header value, or negative error
+ */
+static int http_format_transfer_encoding ( struct http_transaction *http,
+					   char *buf, size_t len ) {
+
+	/* Use chunked encoding if and only if content is streamed */
+	if ( http->request.content.body )
+		return snprintf ( buf, len, "chunked" );
+
+	return 0;
+}
+
+/** HTTP "Transfer-Encoding" header */
+struct http_request_header http_request_transfer_encoding
+	__http_request_header = {
+	.name = "Transfer-Encoding",
+	.format = http_format_transfer_encoding,
+};
+
 /**
  * Construct HTTP "Accept-Encoding" header
  *
@@ -1041,12 +1331,28 @@ struct http_request_header http_request_accept_encoding __http_request_header ={
  */
 static int http_tx_request ( struct http_transaction *http ) {
 	struct io_buffer *iobuf;
+	size_t guess;
 	int len;
 	int check_len;
 	int rc;
 
-	/* Calculate request length */
-	len = http_format_headers ( http, NULL, 0 );
+	/* Allocate I/O buffer, guessing a size sufficient for almost
+	 * any request so that the headers need be formatted only
+	 * once.  Workloads that issue large numbers of near-identical
+	 * requests (e.g. pipelined range requests from the HTTP block
+	 * device) otherwise pay for a full measuring pass over every
+	 * header formatter on every request.
+	 */
+	guess = ( HTTP_TX_HEADERS_GUESS + strlen ( http->request.uri ) );
+	iobuf = alloc_iob ( guess + 1 /* NUL */ + http->request.content.len );
+	if ( ! iobuf ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
+	/* Construct request */
+	len = http_format_headers ( http, iobuf->data,
+				    ( guess + 1 /* NUL */ ) );
 	if ( len < 0 ) {
 		rc = len;
 		DBGC ( http, "HTTP %p could not construct request: %s\n",
@@ -1054,17 +1360,22 @@ static int http_tx_request ( struct http_transaction *http ) {
 		goto err_len;
 	}
 
-	/* Allocate I/O buffer */
-	iobuf = alloc_iob ( len + 1 /* NUL */ + http->request.content.len );
-	if ( ! iobuf ) {
-		rc = -ENOMEM;
-		goto err_alloc;
+	/* Reallocate I/O buffer to exact size if the guess proved
+	 * too small
+	 */
+	if ( ( ( size_t ) len ) > guess ) {
+		free_iob ( iobuf );
+		iobuf = alloc_iob ( len + 1 /* NUL */ +
+				    http->request.content.len );
+		if ( ! iobuf ) {
+			rc = -ENOMEM;
+			goto err_alloc;
+		}
+		check_len = http_format_headers ( http, iobuf->data,
+						  ( len + 1 /* NUL */ ) );
+		assert ( check_len == len );
 	}
-
-	/* Construct request */
-	check_len = http_format_headers ( http, iob_put ( iobuf, len ),
-					  ( len + 1 /* NUL */ ) );
-	assert ( check_len == len );
+	iob_put ( iobuf, len );
 	memcpy ( iob_put ( iobuf, http->request.content.len ),
 		 http->request.content.data, http->request.content.len );
 
@@ -1083,12 +1394,16 @@ static int http_tx_request ( struct http_transaction *http ) {
 	/* Move to response headers state */
 	http->state = &http_headers;
 
+	/* Notify request body stream that transmission may begin */
+	if ( http->request.content.body )
+		xfer_window_changed ( http->request.content.body );
+
 	return 0;
 
  err_deliver:
+ err_len:
 	free_iob ( iobuf );
  err_alloc:
- err_len:
 	return rc;
 }
 
@@ -1442,6 +1757,50 @@ struct http_response_header http_response_retry_after __http_response_header = {
 	.parse = http_parse_retry_after,
 };
 
+/**
+ * Parse HTTP "ETag" header
+ *
+ * @v http		HTTP transaction
+ * @v line		Remaining header line
+ * @ret rc		Return status code
+ */
+static int http_parse_etag ( struct http_transaction *http, char *line ) {
+
+	/* Record entity tag validator */
+	http->response.etag = line;
+
+	return 0;
+}
+
+/** HTTP "ETag" header */
+struct http_response_header http_response_etag __http_response_header = {
+	.name = "ETag",
+	.parse = http_parse_etag,
+};
+
+/**
+ * Parse HTTP "Last-Modified" header
+ *
+ * @v http		HTTP transaction
+ * @v line		Remaining header line
+ * @ret rc		Return status code
+ */
+static int http_parse_last_modified ( struct http_transaction *http,
+				      char *line ) {
+
+	/* Record last modification time validator */
+	http->response.last_modified = line;
+
+	return 0;
+}
+
+/** HTTP "Last-Modified" header */
+struct http_response_header http_response_last_modified
+__http_response_header = {
+	.name = "Last-Modified",
+	.parse = http_parse_last_modified,
+};
+
 /**
  * Handle received HTTP headers
  *
@@ -1470,6 +1829,18 @@ static int http_rx_headers ( struct http_transaction *http,
 	if ( ( rc = http_parse_headers ( http ) ) != 0 )
 		return rc;
 
+	/* Fail if this is a resumed transaction and the server did
+	 * not honour the range request, since the content already
+	 * delivered could otherwise be duplicated or spliced with a
+	 * changed entity.
+	 */
+	if ( http->resuming && ( http->response.status != 206 ) ) {
+		DBGC ( http, "HTTP %p resumption refused (status %d)\n",
+		       http, http->response.status );
+		return -EIO_RESUME;
+	}
+	http->resuming = 0;
+
 	/* Initialise content encoding, if applicable */
 	if ( ( content = http->response.content.encoding ) &&
 	     ( ( rc = content->init ( http ) ) != 0 ) ) {
@@ -1478,8 +1849,11 @@ static int http_rx_headers ( struct http_transaction *http,
 		return rc;
 	}
 
-	/* Presize receive buffer, if we have a content length */
-	if ( http->response.content.len ) {
+	/* Presize receive buffer, if we have a content length (and
+	 * this is not a resumed transaction, for which the receive
+	 * buffer position must be left untouched).
+	 */
+	if ( http->response.content.len && ( ! http->resumed ) ) {
 		xfer_seek ( &http->transfer, http->response.content.len );
 		xfer_seek ( &http->transfer, 0 );
 	}
@@ -1589,17 +1963,22 @@ static int http_rx_transfer_identity ( struct http_transaction *http,
 static void http_close_transfer_identity ( struct http_transaction *http,
 					   int rc ) {
 
-	/* Fail if any error occurred */
-	if ( rc != 0 )
-		goto err;
-
-	/* Fail if we have a content length (since we would have
+	/* Check for content length underrun (since we would have
 	 * already closed the connection if we had received the
 	 * correct content length).
 	 */
-	if ( http->response.flags & HTTP_RESPONSE_CONTENT_LEN ) {
+	if ( ( rc == 0 ) &&
+	     ( http->response.flags & HTTP_RESPONSE_CONTENT_LEN ) ) {
 		DBGC ( http, "HTTP %p content length underrun\n", http );
 		rc = EIO_CONTENT_LENGTH;
+	}
+
+	/* On error, attempt to resume the interrupted transfer
+	 * before failing the transaction outright.
+	 */
+	if ( rc != 0 ) {
+		if ( http_resume ( http ) == 0 )
+			return;
 		goto err;
 	}
 
@@ -1700,8 +2079,10 @@ static int http_rx_chunk_len ( struct http_transaction *http,
  */
 static int http_rx_chunk_data ( struct http_transaction *http,
 				struct io_buffer **iobuf ) {
-	struct io_buffer *payload;
+	struct io_buffer *payload = NULL;
+	struct io_buffer *tail;
 	uint8_t *crlf;
+	size_t tail_len;
 	size_t len;
 	int rc;
 
@@ -1727,6 +2108,27 @@ static int http_rx_chunk_data ( struct http_transaction *http,
 		http->len += len;
 		http->remaining -= len;
 
+	} else if ( ( tail_len = ( len - http->remaining ) ) <=
+		    http->remaining ) {
+
+		/* Data beyond this chunk is the smaller portion of
+		 * the buffer: copy it out to a temporary I/O buffer
+		 * and deliver the bulk of the chunk in place, rather
+		 * than copying the chunk data itself.
+		 */
+		tail = alloc_iob ( tail_len );
+		if ( ! tail ) {
+			rc = -ENOMEM;
+			goto err;
+		}
+		memcpy ( iob_put ( tail, tail_len ),
+			 ( (*iobuf)->data + http->remaining ), tail_len );
+		iob_unput ( *iobuf, tail_len );
+		payload = iob_disown ( *iobuf );
+		*iobuf = tail;
+		http->len += http->remaining;
+		http->remaining = 0;
+
 	} else {
 
 		/* Partial buffer is to be consumed: copy data to a
@@ -1930,6 +2332,7 @@ static int http_open_post_uri ( struct interface *xfer, struct uri *uri ) {
 	assert ( check_len == len );
 
 	/* Construct request content */
+	memset ( &content, 0, sizeof ( content ) );
 	content.type = "application/x-www-form-urlencoded";
 	content.data = data;
 	content.len = len;
@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Hyper Text Transfer Protocol (HTTP) gzip content encoding
+ *
+ * The gzip content encoding allows the server to compress the
+ * response body using the DEFLATE algorithm (wrapped in the gzip
+ * member format described in RFC 1952), substantially reducing the
+ * number of bytes transferred on compressible content such as
+ * initrds and configuration files.
+ *
+ * The gzip member header and footer are parsed and discarded by a
+ * small state machine; the compressed data itself is passed to the
+ * existing DEFLATE decompressor and the decompressed output is
+ * delivered as a normal data stream.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/open.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/interface.h>
+#include <ipxe/deflate.h>
+#include <ipxe/http.h>
+
+/* Error codes */
+#define EINVAL_HEADER __einfo_error ( EINFO_EINVAL_HEADER )
+#define EINFO_EINVAL_HEADER __einfo_uniqify \
+	( EINFO_EINVAL, 0x01, "Invalid gzip header" )
+#define EINVAL_TRAILING __einfo_error ( EINFO_EINVAL_TRAILING )
+#define EINFO_EINVAL_TRAILING __einfo_uniqify \
+	( EINFO_EINVAL, 0x02, "Trailing data after gzip member" )
+#define EIO_TRUNCATED __einfo_error ( EINFO_EIO_TRUNCATED )
+#define EINFO_EIO_TRUNCATED __einfo_uniqify \
+	( EINFO_EIO, 0x01, "Truncated gzip stream" )
+
+/** Length of fixed gzip member header */
+#define HTTP_GZIP_HEADER_LEN 10
+
+/** Length of gzip member footer (CRC32 and uncompressed length) */
+#define HTTP_GZIP_FOOTER_LEN 8
+
+/** First gzip magic byte */
+#define HTTP_GZIP_MAGIC0 0x1f
+
+/** Second gzip magic byte */
+#define HTTP_GZIP_MAGIC1 0x8b
+
+/** gzip compression method: DEFLATE */
+#define HTTP_GZIP_CM_DEFLATE 0x08
+
+/** gzip header CRC flag */
+#define HTTP_GZIP_FL_HCRC 0x02
+
+/** gzip extra field flag */
+#define HTTP_GZIP_FL_EXTRA 0x04
+
+/** gzip original file name flag */
+#define HTTP_GZIP_FL_NAME 0x08
+
+/** gzip file comment flag */
+#define HTTP_GZIP_FL_COMMENT 0x10
+
+/** gzip reserved flags */
+#define HTTP_GZIP_FL_RESERVED 0xe0
+
+/** Decompression chunk length
+ *
+ * This is the length of the I/O buffers used to hold decompressed
+ * data.  It is a policy decision.
+ */
+#define HTTP_GZIP_CHUNKSIZE 4096
+
+/** gzip decoder state */
+enum http_gzip_state {
+	/** Fixed-length portion of member header */
+	HTTP_GZIP_HEADER = 0,
+	/** Extra field length */
+	HTTP_GZIP_XLEN,
+	/** Extra field */
+	HTTP_GZIP_EXTRA,
+	/** Original file name */
+	HTTP_GZIP_NAME,
+	/** File comment */
+	HTTP_GZIP_COMMENT,
+	/** Header CRC */
+	HTTP_GZIP_HCRC,
+	/** Compressed data */
+	HTTP_GZIP_DATA,
+	/** Member footer */
+	HTTP_GZIP_FOOTER,
+	/** Decoding complete */
+	HTTP_GZIP_DONE,
+};
+
+/** A gzip content decoder */
+struct http_gzip {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Content-decoded interface */
+	struct interface xfer;
+	/** Transfer-decoded interface */
+	struct interface transfer;
+
+	/** Decoder state */
+	enum http_gzip_state state;
+	/** Member header flags */
+	unsigned int flags;
+	/** Remaining length of current fixed-length field */
+	size_t remaining;
+	/** Extra field length */
+	size_t extra;
+	/** Decompressor */
+	struct deflate deflate;
+};
+
+/**
+ * Close gzip content decoder
+ *
+ * @v gzip		gzip content decoder
+ * @v rc		Reason for close
+ */
+static void http_gzip_close ( struct http_gzip *gzip, int rc ) {
+
+	/* Shut down interfaces */
+	intf_shutdown ( &gzip->xfer, rc );
+	intf_shutdown ( &gzip->transfer, rc );
+}
+
+/**
+ * Handle transfer-decoded interface close
+ *
+ * @v gzip		gzip content decoder
+ * @v rc		Reason for close
+ */
+static void http_gzip_transfer_close ( struct http_gzip *gzip, int rc ) {
+
+	/* Fail if the compressed stream was incomplete */
+	if ( ( rc == 0 ) && ( gzip->state < HTTP_GZIP_FOOTER ) ) {
+		DBGC ( gzip, "GZIP %p truncated stream (state %d)\n",
+		       gzip, gzip->state );
+		rc = -EIO_TRUNCATED;
+	}
+
+	/* Close decoder */
+	http_gzip_close ( gzip, rc );
+}
+
+/**
+ * Advance to next gzip member header field
+ *
+ * @v gzip		gzip content decoder
+ *
+ * Advances to the next optional member header field present (as
+ * indicated by the header flags), or to the compressed data itself.
+ */
+static void http_gzip_advance ( struct http_gzip *gzip ) {
+
+	/* Move to extra field, if present */
+	if ( ( gzip->state < HTTP_GZIP_XLEN ) &&
+	     ( gzip->flags & HTTP_GZIP_FL_EXTRA ) ) {
+		gzip->state = HTTP_GZIP_XLEN;
+		gzip->remaining = sizeof ( uint16_t );
+		return;
+	}
+
+	/* Move to original file name, if present */
+	if ( ( gzip->state < HTTP_GZIP_NAME ) &&
+	     ( gzip->flags & HTTP_GZIP_FL_NAME ) ) {
+		gzip->state = HTTP_GZIP_NAME;
+		return;
+	}
+
+	/* Move to file comment, if present */
+	if ( ( gzip->state < HTTP_GZIP_COMMENT ) &&
+	     ( gzip->flags & HTTP_GZIP_FL_COMMENT ) ) {
+		gzip->state = HTTP_GZIP_COMMENT;
+		return;
+	}
+
+	/* Move to header CRC, if present.  We skip over the header
+	 * CRC without verifying it; downloaded images are verified
+	 * cryptographically where verification is required.
+	 */
+	if ( ( gzip->state < HTTP_GZIP_HCRC ) &&
+	     ( gzip->flags & HTTP_GZIP_FL_HCRC ) ) {
+		gzip->state = HTTP_GZIP_HCRC;
+		gzip->remaining = sizeof ( uint16_t );
+		return;
+	}
+
+	/* Move to compressed data */
+	gzip->state = HTTP_GZIP_DATA;
+}
+
+/**
+ * Process one byte of gzip member header or footer
+ *
+ * @v gzip		gzip content decoder
+ * @v byte		Byte to process
+ * @ret rc		Return status code
+ */
+static int http_gzip_byte ( struct http_gzip *gzip, uint8_t byte ) {
+	unsigned int pos;
+
+	switch ( gzip->state ) {
+	case HTTP_GZIP_HEADER:
+		pos = ( HTTP_GZIP_HEADER_LEN - gzip->remaining );
+		if ( ( ( pos == 0 ) && ( byte != HTTP_GZIP_MAGIC0 ) ) ||
+		     ( ( pos == 1 ) && ( byte != HTTP_GZIP_MAGIC1 ) ) ||
+		     ( ( pos == 2 ) && ( byte != HTTP_GZIP_CM_DEFLATE ) ) ||
+		     ( ( pos == 3 ) && ( byte & HTTP_GZIP_FL_RESERVED ) ) ) {
+			DBGC ( gzip, "GZIP %p invalid header byte %d: %02x\n",
+			       gzip, pos, byte );
+			return -EINVAL_HEADER;
+		}
+		if ( pos == 3 )
+			gzip->flags = byte;
+		if ( --gzip->remaining == 0 )
+			http_gzip_advance ( gzip );
+		break;
+	case HTTP_GZIP_XLEN:
+		/* Extra field length is little-endian */
+		pos = ( sizeof ( uint16_t ) - gzip->remaining );
+		gzip->extra |= ( byte << ( 8 * pos ) );
+		if ( --gzip->remaining == 0 ) {
+			gzip->state = HTTP_GZIP_EXTRA;
+			gzip->remaining = gzip->extra;
+			if ( ! gzip->remaining )
+				http_gzip_advance ( gzip );
+		}
+		break;
+	case HTTP_GZIP_EXTRA:
+	case HTTP_GZIP_HCRC:
+		if ( --gzip->remaining == 0 )
+			http_gzip_advance ( gzip );
+		break;
+	case HTTP_GZIP_NAME:
+	case HTTP_GZIP_COMMENT:
+		/* Field is NUL-terminated */
+		if ( byte == 0 )
+			http_gzip_advance ( gzip );
+		break;
+	case HTTP_GZIP_FOOTER:
+		/* Skip over the footer without verifying the CRC32 or
+		 * uncompressed length, as for the header CRC.
+		 */
+		if ( --gzip->remaining == 0 )
+			gzip->state = HTTP_GZIP_DONE;
+		break;
+	case HTTP_GZIP_DONE:
+	default:
+		DBGC ( gzip, "GZIP %p trailing data after member\n", gzip );
+		return -EINVAL_TRAILING;
+	}
+
+	return 0;
+}
+
+/**
+ * Handle received compressed data
+ *
+ * @v gzip		gzip content decoder
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int http_gzip_deliver ( struct http_gzip *gzip,
+			       struct io_buffer *iobuf,
+			       struct xfer_metadata *meta __unused ) {
+	struct io_buffer *out;
+	struct deflate_chunk in;
+	struct deflate_chunk chunk;
+	uint8_t *byte;
+	int rc;
+
+	while ( iob_len ( iobuf ) ) {
+
+		/* Decompress data, if applicable */
+		if ( gzip->state == HTTP_GZIP_DATA ) {
+			deflate_chunk_init ( &in, virt_to_user ( iobuf->data ),
+					     0, iob_len ( iobuf ) );
+			while ( ( in.offset < in.len ) &&
+				( ! deflate_finished ( &gzip->deflate ) ) ) {
+				out = xfer_alloc_iob ( &gzip->xfer,
+						       HTTP_GZIP_CHUNKSIZE );
+				if ( ! out ) {
+					rc = -ENOMEM;
+					goto err;
+				}
+				deflate_chunk_init ( &chunk,
+						     virt_to_user ( out->data ),
+						     0, iob_tailroom ( out ) );
+				if ( ( rc = deflate_inflate ( &gzip->deflate,
+							      &in,
+							      &chunk ) ) != 0 ){
+					DBGC ( gzip, "GZIP %p could not "
+					       "decompress: %s\n",
+					       gzip, strerror ( rc ) );
+					free_iob ( out );
+					goto err;
+				}
+				iob_put ( out, chunk.offset );
+				if ( iob_len ( out ) ) {
+					if ( ( rc = xfer_deliver_iob (
+						  &gzip->xfer,
+						  iob_disown ( out ) ) ) != 0 )
+						goto err;
+				} else {
+					free_iob ( out );
+				}
+			}
+			iob_pull ( iobuf, in.offset );
+			if ( deflate_finished ( &gzip->deflate ) ) {
+				gzip->state = HTTP_GZIP_FOOTER;
+				gzip->remaining = HTTP_GZIP_FOOTER_LEN;
+			}
+			continue;
+		}
+
+		/* Process one byte of member header or footer */
+		byte = iobuf->data;
+		iob_pull ( iobuf, 1 );
+		if ( ( rc = http_gzip_byte ( gzip, *byte ) ) != 0 )
+			goto err;
+	}
+
+	/* Free I/O buffer */
+	free_iob ( iobuf );
+
+	return 0;
+
+ err:
+	free_iob ( iobuf );
+	http_gzip_close ( gzip, rc );
+	return rc;
+}
+
+/** gzip content decoder content-decoded interface operations */
+static struct interface_operation http_gzip_xfer_operations[] = {
+	INTF_OP ( intf_close, struct http_gzip *, http_gzip_close ),
+};
+
+/** gzip content decoder content-decoded interface descriptor */
+static struct interface_descriptor http_gzip_xfer_desc =
+	INTF_DESC_PASSTHRU ( struct http_gzip, xfer,
+			     http_gzip_xfer_operations, transfer );
+
+/** gzip content decoder transfer-decoded interface operations */
+static struct interface_operation http_gzip_transfer_operations[] = {
+	INTF_OP ( xfer_deliver, struct http_gzip *, http_gzip_deliver ),
+	INTF_OP ( intf_close, struct http_gzip *, http_gzip_transfer_close ),
+};
+
+/** gzip content decoder transfer-decoded interface descriptor */
+static struct interface_descriptor http_gzip_transfer_desc =
+	INTF_DESC_PASSTHRU ( struct http_gzip, transfer,
+			     http_gzip_transfer_operations, xfer );
+
+/**
+ * Check whether or not to support gzip encoding for this request
+ *
+ * @v http		HTTP transaction
+ * @ret supported	gzip encoding is supported for this request
+ */
+static int http_gzip_supported ( struct http_transaction *http ) {
+
+	/* Refuse to use gzip encoding for range requests, since a
+	 * partial compressed stream cannot be decoded.
+	 */
+	return ( http->request.range.len == 0 );
+}
+
+/**
+ * Initialise gzip content encoding
+ *
+ * @v http		HTTP transaction
+ * @ret rc		Return status code
+ */
+static int http_gzip_init ( struct http_transaction *http ) {
+	struct http_gzip *gzip;
+
+	/* Allocate and initialise structure */
+	gzip = zalloc ( sizeof ( *gzip ) );
+	if ( ! gzip )
+		return -ENOMEM;
+	ref_init ( &gzip->refcnt, NULL );
+	intf_init ( &gzip->xfer, &http_gzip_xfer_desc, &gzip->refcnt );
+	intf_init ( &gzip->transfer, &http_gzip_transfer_desc, &gzip->refcnt );
+	gzip->remaining = HTTP_GZIP_HEADER_LEN;
+	deflate_init ( &gzip->deflate, DEFLATE_RAW );
+
+	/* Attach to parent interfaces, mortalise self, and return */
+	intf_plug_plug ( &gzip->xfer, &http->content );
+	intf_plug_plug ( &gzip->transfer, &http->transfer );
+	ref_put ( &gzip->refcnt );
+	return 0;
+}
+
+/** gzip HTTP content encoding */
+struct http_content_encoding gzip_encoding __http_content_encoding = {
+	.name = "gzip",
+	.supported = http_gzip_supported,
+	.init = http_gzip_init,
+};
@@ -210,6 +210,7 @@ static int http_format_ntlm_auth ( struct http_transaction *http,
 /** HTTP NTLM authentication scheme */
 struct http_authentication http_ntlm_auth __http_authentication = {
 	.name = "NTLM",
+	.conn = 1,
 	.parse = http_parse_ntlm_auth,
 	.authenticate = http_ntlm_authenticate,
 	.format = http_format_ntlm_auth,
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Hyper Text Transfer Protocol (HTTP) Zstandard content encoding
+ *
+ * The zstd content encoding (RFC 8878) allows the server to compress
+ * the response body using Zstandard, which is the default compression
+ * format for current Linux kernels and initrds.
+ *
+ * Our Zstandard decompressor is a one-shot decompressor, since it
+ * uses the output buffer as the match window.  We therefore buffer
+ * the complete compressed body, and decompress it when the transfer
+ * completes.  The decompressed length is taken from the frame content
+ * size recorded in the frame header; this is always present in files
+ * compressed by the zstd command-line tool (and by the kernel build),
+ * though the format permits it to be omitted for streamed content.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/umalloc.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/open.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/interface.h>
+#include <ipxe/zstd.h>
+#include <ipxe/http.h>
+
+/** Delivery chunk length
+ *
+ * This is the length of the I/O buffers used to deliver decompressed
+ * data.  It is a policy decision.
+ */
+#define HTTP_ZSTD_CHUNKSIZE 4096
+
+/** A zstd content decoder */
+struct http_zstd {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Content-decoded interface */
+	struct interface xfer;
+	/** Transfer-decoded interface */
+	struct interface transfer;
+
+	/** Compressed data buffer */
+	struct xfer_buffer xferbuf;
+	/** Compressed data */
+	userptr_t data;
+};
+
+/**
+ * Free zstd content decoder
+ *
+ * @v refcnt		Reference count
+ */
+static void http_zstd_free ( struct refcnt *refcnt ) {
+	struct http_zstd *zstd =
+		container_of ( refcnt, struct http_zstd, refcnt );
+
+	xferbuf_free ( &zstd->xferbuf );
+	free ( zstd );
+}
+
+/**
+ * Close zstd content decoder
+ *
+ * @v zstd		zstd content decoder
+ * @v rc		Reason for close
+ */
+static void http_zstd_close ( struct http_zstd *zstd, int rc ) {
+
+	/* Shut down interfaces */
+	intf_shutdown ( &zstd->xfer, rc );
+	intf_shutdown ( &zstd->transfer, rc );
+}
+
+/**
+ * Decompress and deliver the buffered compressed body
+ *
+ * @v zstd		zstd content decoder
+ * @ret rc		Return status code
+ */
+static int http_zstd_decompress ( struct http_zstd *zstd ) {
+	struct zstd_chunk in;
+	struct zstd_chunk out;
+	struct io_buffer *iobuf;
+	userptr_t result = UNULL;
+	uint64_t len;
+	size_t offset;
+	size_t frag;
+	int rc;
+
+	/* Determine decompressed length from the frame header */
+	zstd_chunk_init ( &in, zstd->data, 0, zstd->xferbuf.len );
+	if ( ( rc = zstd_decompressed_len ( &in, &len ) ) != 0 ) {
+		DBGC ( zstd, "ZSTD %p could not determine decompressed "
+		       "length: %s\n", zstd, strerror ( rc ) );
+		goto err_len;
+	}
+	if ( len > ~( ( size_t ) 0 ) ) {
+		rc = -ENOMEM;
+		goto err_len;
+	}
+
+	/* Allocate and fill decompression buffer */
+	result = umalloc ( len );
+	if ( ! result ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	zstd_chunk_init ( &out, result, 0, len );
+	if ( ( rc = zstd_decompress ( &in, &out ) ) != 0 ) {
+		DBGC ( zstd, "ZSTD %p could not decompress: %s\n",
+		       zstd, strerror ( rc ) );
+		goto err_decompress;
+	}
+
+	/* Presize downstream buffer */
+	xfer_seek ( &zstd->xfer, out.offset );
+	xfer_seek ( &zstd->xfer, 0 );
+
+	/* Deliver decompressed data */
+	for ( offset = 0 ; offset < out.offset ; offset += frag ) {
+		frag = ( out.offset - offset );
+		if ( frag > HTTP_ZSTD_CHUNKSIZE )
+			frag = HTTP_ZSTD_CHUNKSIZE;
+		iobuf = xfer_alloc_iob ( &zstd->xfer, frag );
+		if ( ! iobuf ) {
+			rc = -ENOMEM;
+			goto err_deliver;
+		}
+		copy_from_user ( iob_put ( iobuf, frag ), result, offset,
+				 frag );
+		if ( ( rc = xfer_deliver_iob ( &zstd->xfer,
+					       iob_disown ( iobuf ) ) ) != 0 )
+			goto err_deliver;
+	}
+
+ err_deliver:
+ err_decompress:
+	ufree ( result );
+ err_alloc:
+ err_len:
+	return rc;
+}
+
+/**
+ * Handle transfer-decoded interface close
+ *
+ * @v zstd		zstd content decoder
+ * @v rc		Reason for close
+ */
+static void http_zstd_transfer_close ( struct http_zstd *zstd, int rc ) {
+
+	/* Decompress and deliver body, if transfer was successful */
+	if ( rc == 0 )
+		rc = http_zstd_decompress ( zstd );
+
+	/* Close decoder */
+	http_zstd_close ( zstd, rc );
+}
+
+/**
+ * Handle received compressed data
+ *
+ * @v zstd		zstd content decoder
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int http_zstd_deliver ( struct http_zstd *zstd,
+			       struct io_buffer *iobuf,
+			       struct xfer_metadata *meta ) {
+	int rc;
+
+	/* Add to compressed data buffer */
+	if ( ( rc = xferbuf_deliver ( &zstd->xferbuf, iob_disown ( iobuf ),
+				      meta ) ) != 0 ) {
+		http_zstd_close ( zstd, rc );
+		return rc;
+	}
+
+	return 0;
+}
+
+/** zstd content decoder content-decoded interface operations */
+static struct interface_operation http_zstd_xfer_operations[] = {
+	INTF_OP ( intf_close, struct http_zstd *, http_zstd_close ),
+};
+
+/** zstd content decoder content-decoded interface descriptor */
+static struct interface_descriptor http_zstd_xfer_desc =
+	INTF_DESC_PASSTHRU ( struct http_zstd, xfer,
+			     http_zstd_xfer_operations, transfer );
+
+/** zstd content decoder transfer-decoded interface operations */
+static struct interface_operation http_zstd_transfer_operations[] = {
+	INTF_OP ( xfer_deliver, struct http_zstd *, http_zstd_deliver ),
+	INTF_OP ( intf_close, struct http_zstd *, http_zstd_transfer_close ),
+};
+
+/** zstd content decoder transfer-decoded interface descriptor */
+static struct interface_descriptor http_zstd_transfer_desc =
+	INTF_DESC_PASSTHRU ( struct http_zstd, transfer,
+			     http_zstd_transfer_operations, xfer );
+
+/**
+ * Check whether or not to support zstd encoding for this request
+ *
+ * @v http		HTTP transaction
+ * @ret supported	zstd encoding is supported for this request
+ */
+static int http_zstd_supported ( struct http_transaction *http ) {
+
+	/* Refuse to use zstd encoding for range requests, since a
+	 * partial compressed stream cannot be decoded.
+	 */
+	return ( http->request.range.len == 0 );
+}
+
+/**
+ * Initialise zstd content encoding
+ *
+ * @v http		HTTP transaction
+ * @ret rc		Return status code
+ */
+static int http_zstd_init ( struct http_transaction *http ) {
+	struct http_zstd *zstd;
+
+	/* Allocate and initialise structure */
+	zstd = zalloc ( sizeof ( *zstd ) );
+	if ( ! zstd )
+		return -ENOMEM;
+	ref_init ( &zstd->refcnt, http_zstd_free );
+	intf_init ( &zstd->xfer, &http_zstd_xfer_desc, &zstd->refcnt );
+	intf_init ( &zstd->transfer, &http_zstd_transfer_desc, &zstd->refcnt );
+	xferbuf_umalloc_init ( &zstd->xferbuf, &zstd->data );
+
+	/* Attach to parent interfaces, mortalise self, and return */
+	intf_plug_plug ( &zstd->xfer, &http->content );
+	intf_plug_plug ( &zstd->transfer, &http->transfer );
+	ref_put ( &zstd->refcnt );
+	return 0;
+}
+
+/** zstd HTTP content encoding */
+struct http_content_encoding zstd_encoding __http_content_encoding = {
+	.name = "zstd",
+	.supported = http_zstd_supported,
+	.init = http_zstd_init,
+};
@@ -142,10 +142,20 @@ FEATURE ( FEATURE_PROTOCOL, "iSCSI", DHCP_EB_FEATURE_ISCSI, 1 );
 #define EINFO_EPROTO_VALUE_REJECTED					\
 	__einfo_uniqify ( EINFO_EPROTO, 0x06, "Parameter rejected" )
 
+/** Maximum number of commands which may be outstanding simultaneously
+ *
+ * Allowing multiple tagged commands to be in flight lets the target
+ * overlap its storage round trips instead of serialising each one
+ * with the network latency.  This is a policy decision.
+ */
+#define ISCSI_MAX_COMMANDS 4
+
 static void iscsi_start_tx ( struct iscsi_session *iscsi );
 static void iscsi_start_login ( struct iscsi_session *iscsi );
 static void iscsi_start_data_out ( struct iscsi_session *iscsi,
 				   unsigned int datasn );
+static void iscsi_command_close ( struct iscsi_command *cmd, int rc );
+static void iscsi_start_next_command ( struct iscsi_session *iscsi );
 
 /**
  * Finish receiving PDU data into buffer
@@ -205,7 +215,7 @@ static void iscsi_free ( struct refcnt *refcnt ) {
 	free ( iscsi->target_password );
 	chap_finish ( &iscsi->chap );
 	iscsi_rx_buffered_data_done ( iscsi );
-	free ( iscsi->command );
+	assert ( list_empty ( &iscsi->commands ) );
 	free ( iscsi );
 }
 
@@ -216,6 +226,8 @@ static void iscsi_free ( struct refcnt *refcnt ) {
  * @v rc		Reason for close
  */
 static void iscsi_close ( struct iscsi_session *iscsi, int rc ) {
+	struct iscsi_command *cmd;
+	struct iscsi_command *tmp;
 
 	/* A TCP graceful close is still an error from our point of view */
 	if ( rc == 0 )
@@ -223,23 +235,32 @@ static void iscsi_close ( struct iscsi_session *iscsi, int rc ) {
 
 	DBGC ( iscsi, "iSCSI %p closed: %s\n", iscsi, strerror ( rc ) );
 
+	/* Clear session status: refuse any further commands */
+	iscsi->status = 0;
+
 	/* Stop transmission process */
 	process_del ( &iscsi->process );
 
+	/* Shut down any outstanding commands */
+	list_for_each_entry_safe ( cmd, tmp, &iscsi->commands, list ) {
+		ref_get ( &cmd->refcnt );
+		iscsi_command_close ( cmd, rc );
+		ref_put ( &cmd->refcnt );
+	}
+
 	/* Shut down interfaces */
-	intfs_shutdown ( rc, &iscsi->socket, &iscsi->control, &iscsi->data,
-			 NULL );
+	intfs_shutdown ( rc, &iscsi->socket, &iscsi->control, NULL );
 }
 
 /**
  * Assign new iSCSI initiator task tag
  *
- * @v iscsi		iSCSI session
+ * @ret itt		Initiator task tag
  */
-static void iscsi_new_itt ( struct iscsi_session *iscsi ) {
+static uint32_t iscsi_new_itt ( void ) {
 	static uint16_t itt_idx;
 
-	iscsi->itt = ( ISCSI_TAG_MAGIC | (++itt_idx) );
+	return ( ISCSI_TAG_MAGIC | (++itt_idx) );
 }
 
 /**
@@ -277,8 +298,8 @@ static int iscsi_open_connection ( struct iscsi_session *iscsi ) {
 	/* Assign new ISID */
 	iscsi->isid_iana_qual = ( random() & 0xffff );
 
-	/* Assign fresh initiator task tag */
-	iscsi_new_itt ( iscsi );
+	/* Assign fresh initiator task tag for the login phase */
+	iscsi->itt = iscsi_new_itt();
 
 	/* Initiate login */
 	iscsi_start_login ( iscsi );
@@ -313,40 +334,136 @@ static void iscsi_close_connection ( struct iscsi_session *iscsi, int rc ) {
 	iscsi_rx_buffered_data_done ( iscsi );
 }
 
+/****************************************************************************
+ *
+ * iSCSI command management
+ *
+ */
+
+/**
+ * Free iSCSI command
+ *
+ * @v refcnt		Reference count
+ */
+static void iscsi_command_free ( struct refcnt *refcnt ) {
+	struct iscsi_command *cmd =
+		container_of ( refcnt, struct iscsi_command, refcnt );
+
+	/* Remove from list of commands */
+	list_del ( &cmd->list );
+	ref_put ( &cmd->iscsi->refcnt );
+
+	/* Free command */
+	free ( cmd );
+}
+
+/**
+ * Close iSCSI command
+ *
+ * @v cmd		iSCSI command
+ * @v rc		Reason for close
+ */
+static void iscsi_command_close ( struct iscsi_command *cmd, int rc ) {
+	struct iscsi_session *iscsi = cmd->iscsi;
+
+	if ( rc != 0 ) {
+		DBGC ( iscsi, "iSCSI %p tag %08x closed: %s\n",
+		       iscsi, cmd->itt, strerror ( rc ) );
+	}
+
+	/* Mark command as no longer awaiting completion */
+	cmd->issued = 0;
+
+	/* Forget any data-out transfer in progress for this command */
+	if ( iscsi->transfer == cmd )
+		iscsi->transfer = NULL;
+
+	/* Shut down command interface */
+	intf_shutdown ( &cmd->data, rc );
+}
+
+/**
+ * Handle closure of iSCSI command interface
+ *
+ * @v cmd		iSCSI command
+ * @v rc		Reason for close
+ */
+static void iscsi_command_cancel ( struct iscsi_command *cmd, int rc ) {
+	struct iscsi_session *iscsi = cmd->iscsi;
+	int issued = cmd->issued;
+
+	/* Close command */
+	iscsi_command_close ( cmd, rc );
+
+	/* Treat unsolicited closure of a command in flight as fatal,
+	 * because we have no code to abort an individual task and the
+	 * target may send further PDUs for this tag.
+	 */
+	if ( issued )
+		iscsi_close ( iscsi, ( ( rc == 0 ) ? -ECANCELED : rc ) );
+}
+
+/** iSCSI SCSI command interface operations */
+static struct interface_operation iscsi_command_op[] = {
+	INTF_OP ( intf_close, struct iscsi_command *, iscsi_command_cancel ),
+};
+
+/** iSCSI SCSI command interface descriptor */
+static struct interface_descriptor iscsi_command_desc =
+	INTF_DESC ( struct iscsi_command, data, iscsi_command_op );
+
 /**
- * Mark iSCSI SCSI operation as complete
+ * Identify iSCSI command by initiator task tag
  *
  * @v iscsi		iSCSI session
+ * @v itt		Initiator task tag
+ * @ret cmd		iSCSI command, or NULL if not found
+ */
+static struct iscsi_command * iscsi_find_itt ( struct iscsi_session *iscsi,
+					       uint32_t itt ) {
+	struct iscsi_command *cmd;
+
+	list_for_each_entry ( cmd, &iscsi->commands, list ) {
+		if ( cmd->itt == itt )
+			return cmd;
+	}
+	return NULL;
+}
+
+/**
+ * Mark iSCSI command as complete
+ *
+ * @v cmd		iSCSI command
  * @v rc		Return status code
  * @v rsp		SCSI response, if any
- *
- * Note that iscsi_scsi_done() will not close the connection, and must
- * therefore be called only when the internal state machines are in an
- * appropriate state, otherwise bad things may happen on the next call
- * to iscsi_scsi_command().  The general rule is to call
- * iscsi_scsi_done() only at the end of receiving a PDU; at this point
- * the TX and RX engines should both be idle.
  */
-static void iscsi_scsi_done ( struct iscsi_session *iscsi, int rc,
-			      struct scsi_rsp *rsp ) {
-	uint32_t itt = iscsi->itt;
+static void iscsi_command_done ( struct iscsi_command *cmd, int rc,
+				 struct scsi_rsp *rsp ) {
+	struct iscsi_session *iscsi = cmd->iscsi;
 
-	assert ( iscsi->tx_state == ISCSI_TX_IDLE );
+	/* Take temporary reference; the command interface may be
+	 * closed as a result of the SCSI response we send.
+	 */
+	ref_get ( &cmd->refcnt );
 
-	/* Clear command */
-	free ( iscsi->command );
-	iscsi->command = NULL;
+	/* Mark command as no longer awaiting completion */
+	cmd->issued = 0;
 
 	/* Send SCSI response, if any */
 	if ( rsp )
-		scsi_response ( &iscsi->data, rsp );
+		scsi_response ( &cmd->data, rsp );
 
-	/* Close SCSI command, if this is still the same command.  (It
-	 * is possible that the command interface has already been
-	 * closed as a result of the SCSI response we sent.)
+	/* Close command */
+	iscsi_command_close ( cmd, rc );
+
+	/* Drop temporary reference */
+	ref_put ( &cmd->refcnt );
+
+	/* Start transmitting any queued command, and notify the SCSI
+	 * layer that the command window may have reopened.
 	 */
-	if ( iscsi->itt == itt )
-		intf_restart ( &iscsi->data, rc );
+	iscsi_start_next_command ( iscsi );
+	xfer_window_changed ( &iscsi->control );
 }
 
 /****************************************************************************
@@ -358,42 +475,81 @@ static void iscsi_scsi_done ( struct iscsi_session *iscsi, int rc,
 /**
  * Build iSCSI SCSI command BHS
  *
- * @v iscsi		iSCSI session
+ * @v cmd		iSCSI command
  *
  * We don't currently support bidirectional commands (i.e. with both
  * Data-In and Data-Out segments); these would require providing code
  * to generate an AHS, and there doesn't seem to be any need for it at
  * the moment.
  */
-static void iscsi_start_command ( struct iscsi_session *iscsi ) {
+static void iscsi_start_command ( struct iscsi_command *cmd ) {
+	struct iscsi_session *iscsi = cmd->iscsi;
 	struct iscsi_bhs_scsi_command *command = &iscsi->tx_bhs.scsi_command;
 
-	assert ( ! ( iscsi->command->data_in && iscsi->command->data_out ) );
+	assert ( ! ( cmd->command.data_in && cmd->command.data_out ) );
 
 	/* Construct BHS and initiate transmission */
 	iscsi_start_tx ( iscsi );
 	command->opcode = ISCSI_OPCODE_SCSI_COMMAND;
 	command->flags = ( ISCSI_FLAG_FINAL |
 			   ISCSI_COMMAND_ATTR_SIMPLE );
-	if ( iscsi->command->data_in )
+	if ( cmd->command.data_in )
 		command->flags |= ISCSI_COMMAND_FLAG_READ;
-	if ( iscsi->command->data_out )
+	if ( cmd->command.data_out )
 		command->flags |= ISCSI_COMMAND_FLAG_WRITE;
 	/* lengths left as zero */
-	memcpy ( &command->lun, &iscsi->command->lun,
+	memcpy ( &command->lun, &cmd->command.lun,
 		 sizeof ( command->lun ) );
-	command->itt = htonl ( iscsi->itt );
-	command->exp_len = htonl ( iscsi->command->data_in_len |
-				   iscsi->command->data_out_len );
+	command->itt = htonl ( cmd->itt );
+	command->exp_len = htonl ( cmd->command.data_in_len |
+				   cmd->command.data_out_len );
 	command->cmdsn = htonl ( iscsi->cmdsn );
 	command->expstatsn = htonl ( iscsi->statsn + 1 );
-	memcpy ( &command->cdb, &iscsi->command->cdb, sizeof ( command->cdb ));
-	DBGC2 ( iscsi, "iSCSI %p start " SCSI_CDB_FORMAT " %s %#zx\n",
-		iscsi, SCSI_CDB_DATA ( command->cdb ),
-		( iscsi->command->data_in ? "in" : "out" ),
-		( iscsi->command->data_in ?
-		  iscsi->command->data_in_len :
-		  iscsi->command->data_out_len ) );
+	memcpy ( &command->cdb, &cmd->command.cdb, sizeof ( command->cdb ) );
+	DBGC2 ( iscsi, "iSCSI %p tag %08x start " SCSI_CDB_FORMAT " %s %#zx\n",
+		iscsi, cmd->itt, SCSI_CDB_DATA ( command->cdb ),
+		( cmd->command.data_in ? "in" : "out" ),
+		( cmd->command.data_in ?
+		  cmd->command.data_in_len :
+		  cmd->command.data_out_len ) );
+
+	/* Consume a command sequence number and mark as issued */
+	iscsi->cmdsn++;
+	cmd->issued = 1;
+}
+
+/**
+ * Start transmitting next queued SCSI command, if applicable
+ *
+ * @v iscsi		iSCSI session
+ *
+ * Commands are queued for transmission, since only one PDU may be in
+ * transit at any one time and the target bounds the number of
+ * commands which we may issue via MaxCmdSN.
+ */
+static void iscsi_start_next_command ( struct iscsi_session *iscsi ) {
+	struct iscsi_command *cmd;
+
+	/* Do nothing unless in the full feature phase */
+	if ( ( iscsi->status & ISCSI_STATUS_PHASE_MASK ) !=
+	     ISCSI_STATUS_FULL_FEATURE_PHASE )
+		return;
+
+	/* Do nothing while a PDU is being transmitted */
+	if ( iscsi->tx_state != ISCSI_TX_IDLE )
+		return;
+
+	/* Do nothing while the target's command window is closed */
+	if ( ( ( int32_t ) ( iscsi->maxcmdsn - iscsi->cmdsn ) ) < 0 )
+		return;
+
+	/* Start transmitting first command not yet issued, if any */
+	list_for_each_entry ( cmd, &iscsi->commands, list ) {
+		if ( ! cmd->issued ) {
+			iscsi_start_command ( cmd );
+			break;
+		}
+	}
 }
 
 /**
@@ -410,6 +566,7 @@ static int iscsi_rx_scsi_response ( struct iscsi_session *iscsi,
 				    size_t remaining ) {
 	struct iscsi_bhs_scsi_response *response
 		= &iscsi->rx_bhs.scsi_response;
+	struct iscsi_command *cmd;
 	struct scsi_rsp rsp;
 	uint32_t residual_count;
 	size_t data_len;
@@ -424,6 +581,15 @@ static int iscsi_rx_scsi_response ( struct iscsi_session *iscsi,
 	if ( remaining )
 		return 0;
 
+	/* Identify command */
+	cmd = iscsi_find_itt ( iscsi, ntohl ( response->itt ) );
+	if ( ! cmd ) {
+		DBGC ( iscsi, "iSCSI %p received response for unknown tag "
+		       "%08x\n", iscsi, ntohl ( response->itt ) );
+		iscsi_rx_buffered_data_done ( iscsi );
+		return -EPROTO;
+	}
+
 	/* Parse SCSI response and discard buffer */
 	memset ( &rsp, 0, sizeof ( rsp ) );
 	rsp.status = response->status;
@@ -445,7 +611,7 @@ static int iscsi_rx_scsi_response ( struct iscsi_session *iscsi,
 		return -EIO;
 
 	/* Mark as completed */
-	iscsi_scsi_done ( iscsi, 0, &rsp );
+	iscsi_command_done ( cmd, 0, &rsp );
 	return 0;
 }
 
@@ -462,14 +628,22 @@ static int iscsi_rx_data_in ( struct iscsi_session *iscsi,
 			      const void *data, size_t len,
 			      size_t remaining ) {
 	struct iscsi_bhs_data_in *data_in = &iscsi->rx_bhs.data_in;
+	struct iscsi_command *cmd;
 	unsigned long offset;
 
+	/* Identify command */
+	cmd = iscsi_find_itt ( iscsi, ntohl ( data_in->itt ) );
+	if ( ! cmd ) {
+		DBGC ( iscsi, "iSCSI %p received data-in for unknown tag "
+		       "%08x\n", iscsi, ntohl ( data_in->itt ) );
+		return -EPROTO;
+	}
+
 	/* Copy data to data-in buffer */
 	offset = ntohl ( data_in->offset ) + iscsi->rx_offset;
-	assert ( iscsi->command != NULL );
-	assert ( iscsi->command->data_in );
-	assert ( ( offset + len ) <= iscsi->command->data_in_len );
-	copy_to_user ( iscsi->command->data_in, offset, data, len );
+	assert ( cmd->command.data_in );
+	assert ( ( offset + len ) <= cmd->command.data_in_len );
+	copy_to_user ( cmd->command.data_in, offset, data, len );
 
 	/* Wait for whole SCSI response to arrive */
 	if ( remaining )
@@ -477,10 +651,10 @@ static int iscsi_rx_data_in ( struct iscsi_session *iscsi,
 
 	/* Mark as completed if status is present */
 	if ( data_in->flags & ISCSI_DATA_FLAG_STATUS ) {
-		assert ( ( offset + len ) == iscsi->command->data_in_len );
+		assert ( ( offset + len ) == cmd->command.data_in_len );
 		assert ( data_in->flags & ISCSI_FLAG_FINAL );
 		/* iSCSI cannot return an error status via a data-in */
-		iscsi_scsi_done ( iscsi, 0, NULL );
+		iscsi_command_done ( cmd, 0, NULL );
 	}
 
 	return 0;
@@ -499,8 +673,18 @@ static int iscsi_rx_r2t ( struct iscsi_session *iscsi,
 			  const void *data __unused, size_t len __unused,
 			  size_t remaining __unused ) {
 	struct iscsi_bhs_r2t *r2t = &iscsi->rx_bhs.r2t;
+	struct iscsi_command *cmd;
+
+	/* Identify command */
+	cmd = iscsi_find_itt ( iscsi, ntohl ( r2t->itt ) );
+	if ( ( ! cmd ) || ( ! cmd->command.data_out ) ) {
+		DBGC ( iscsi, "iSCSI %p received R2T for unknown tag %08x\n",
+		       iscsi, ntohl ( r2t->itt ) );
+		return -EPROTO;
+	}
 
 	/* Record transfer parameters and trigger first data-out */
+	iscsi->transfer = cmd;
 	iscsi->ttt = ntohl ( r2t->ttt );
 	iscsi->transfer_offset = ntohl ( r2t->offset );
 	iscsi->transfer_len = ntohl ( r2t->len );
@@ -519,6 +703,7 @@ static int iscsi_rx_r2t ( struct iscsi_session *iscsi,
 static void iscsi_start_data_out ( struct iscsi_session *iscsi,
 				   unsigned int datasn ) {
 	struct iscsi_bhs_data_out *data_out = &iscsi->tx_bhs.data_out;
+	struct iscsi_command *cmd = iscsi->transfer;
 	unsigned long offset;
 	unsigned long remaining;
 	unsigned long len;
@@ -538,8 +723,8 @@ static void iscsi_start_data_out ( struct iscsi_session *iscsi,
 	if ( len == remaining )
 		data_out->flags = ( ISCSI_FLAG_FINAL );
 	ISCSI_SET_LENGTHS ( data_out->lengths, 0, len );
-	data_out->lun = iscsi->command->lun;
-	data_out->itt = htonl ( iscsi->itt );
+	data_out->lun = cmd->command.lun;
+	data_out->itt = htonl ( cmd->itt );
 	data_out->ttt = htonl ( iscsi->ttt );
 	data_out->expstatsn = htonl ( iscsi->statsn + 1 );
 	data_out->datasn = htonl ( datasn );
@@ -557,6 +742,10 @@ static void iscsi_start_data_out ( struct iscsi_session *iscsi,
 static void iscsi_data_out_done ( struct iscsi_session *iscsi ) {
 	struct iscsi_bhs_data_out *data_out = &iscsi->tx_bhs.data_out;
 
+	/* Stop if the command is no longer outstanding */
+	if ( ! iscsi->transfer )
+		return;
+
 	/* If we haven't reached the end of the sequence, start
 	 * sending the next data-out PDU.
 	 */
@@ -572,25 +761,31 @@ static void iscsi_data_out_done ( struct iscsi_session *iscsi ) {
  */
 static int iscsi_tx_data_out ( struct iscsi_session *iscsi ) {
 	struct iscsi_bhs_data_out *data_out = &iscsi->tx_bhs.data_out;
+	struct iscsi_command *cmd = iscsi->transfer;
 	struct io_buffer *iobuf;
 	unsigned long offset;
 	size_t len;
 	size_t pad_len;
 
+	/* Fail if the command was closed mid-transfer; we have
+	 * already committed to sending a data segment via the BHS.
+	 */
+	if ( ! cmd )
+		return -ECANCELED;
+
 	offset = ntohl ( data_out->offset );
 	len = ISCSI_DATA_LEN ( data_out->lengths );
 	pad_len = ISCSI_DATA_PAD_LEN ( data_out->lengths );
 
-	assert ( iscsi->command != NULL );
-	assert ( iscsi->command->data_out );
-	assert ( ( offset + len ) <= iscsi->command->data_out_len );
+	assert ( cmd->command.data_out );
+	assert ( ( offset + len ) <= cmd->command.data_out_len );
 
 	iobuf = xfer_alloc_iob ( &iscsi->socket, ( len + pad_len ) );
 	if ( ! iobuf )
 		return -ENOMEM;
-	
+
 	copy_from_user ( iob_put ( iobuf, len ),
-			 iscsi->command->data_out, offset, len );
+			 cmd->command.data_out, offset, len );
 	memset ( iob_put ( iobuf, pad_len ), 0, pad_len );
 
 	return xfer_deliver_iob ( &iscsi->socket, iobuf );
@@ -1451,6 +1646,9 @@ static void iscsi_tx_done ( struct iscsi_session *iscsi ) {
 		/* No action */
 		break;
 	}
+
+	/* Start transmitting any queued command */
+	iscsi_start_next_command ( iscsi );
 }
 
 /**
@@ -1586,9 +1784,20 @@ static int iscsi_rx_data ( struct iscsi_session *iscsi, const void *data,
 			   size_t len, size_t remaining ) {
 	struct iscsi_bhs_common_response *response
 		= &iscsi->rx_bhs.common_response;
+	uint32_t expcmdsn;
+	uint32_t maxcmdsn;
 
-	/* Update cmdsn and statsn */
-	iscsi->cmdsn = ntohl ( response->expcmdsn );
+	/* Update cmdsn, maxcmdsn and statsn.  A response may have
+	 * been generated before the target received commands that we
+	 * have already issued, so the advertised sequence numbers are
+	 * used only if they are ahead of our own counters.
+	 */
+	expcmdsn = ntohl ( response->expcmdsn );
+	if ( ( ( int32_t ) ( expcmdsn - iscsi->cmdsn ) ) > 0 )
+		iscsi->cmdsn = expcmdsn;
+	maxcmdsn = ntohl ( response->maxcmdsn );
+	if ( ( ( int32_t ) ( maxcmdsn - iscsi->maxcmdsn ) ) > 0 )
+		iscsi->maxcmdsn = maxcmdsn;
 	iscsi->statsn = ntohl ( response->statsn );
 
 	switch ( response->opcode & ISCSI_OPCODE_MASK ) {
@@ -1767,15 +1976,27 @@ static struct interface_descriptor iscsi_socket_desc =
  * @ret len		Length of window
  */
 static size_t iscsi_scsi_window ( struct iscsi_session *iscsi ) {
+	struct iscsi_command *cmd;
+	unsigned int count = 0;
 
-	if ( ( ( iscsi->status & ISCSI_STATUS_PHASE_MASK ) ==
-	       ISCSI_STATUS_FULL_FEATURE_PHASE ) &&
-	     ( iscsi->command == NULL ) ) {
-		/* We cannot handle concurrent commands */
-		return 1;
-	} else {
+	/* Refuse commands before login is complete */
+	if ( ( iscsi->status & ISCSI_STATUS_PHASE_MASK ) !=
+	     ISCSI_STATUS_FULL_FEATURE_PHASE )
 		return 0;
+
+	/* Count outstanding commands.  Refuse to overlap commands
+	 * with a write in progress, since the R2T and data-out logic
+	 * can handle only a single data transfer at a time.
+	 */
+	list_for_each_entry ( cmd, &iscsi->commands, list ) {
+		if ( cmd->command.data_out )
+			return 0;
+		count++;
 	}
+
+	/* Allow up to ISCSI_MAX_COMMANDS commands to be outstanding */
+	return ( ( count < ISCSI_MAX_COMMANDS ) ?
+		 ( ISCSI_MAX_COMMANDS - count ) : 0 );
 }
 
 /**
@@ -1789,31 +2010,33 @@ static size_t iscsi_scsi_window ( struct iscsi_session *iscsi ) {
 static int iscsi_scsi_command ( struct iscsi_session *iscsi,
 				struct interface *parent,
 				struct scsi_cmd *command ) {
+	struct iscsi_command *cmd;
 
-	/* This iSCSI implementation cannot handle multiple concurrent
-	 * commands or commands arriving before login is complete.
-	 */
+	/* Refuse commands for which we have no command window */
 	if ( iscsi_scsi_window ( iscsi ) == 0 ) {
-		DBGC ( iscsi, "iSCSI %p cannot handle concurrent commands\n",
-		       iscsi );
+		DBGC ( iscsi, "iSCSI %p cannot accept new command\n", iscsi );
 		return -EOPNOTSUPP;
 	}
 
-	/* Store command */
-	iscsi->command = malloc ( sizeof ( *command ) );
-	if ( ! iscsi->command )
+	/* Allocate and initialise structure */
+	cmd = zalloc ( sizeof ( *cmd ) );
+	if ( ! cmd )
 		return -ENOMEM;
-	memcpy ( iscsi->command, command, sizeof ( *command ) );
-
-	/* Assign new ITT */
-	iscsi_new_itt ( iscsi );
-
-	/* Start sending command */
-	iscsi_start_command ( iscsi );
-
-	/* Attach to parent interface and return */
-	intf_plug_plug ( &iscsi->data, parent );
-	return iscsi->itt;
+	ref_init ( &cmd->refcnt, iscsi_command_free );
+	intf_init ( &cmd->data, &iscsi_command_desc, &cmd->refcnt );
+	cmd->iscsi = iscsi;
+	ref_get ( &iscsi->refcnt );
+	list_add_tail ( &cmd->list, &iscsi->commands );
+	memcpy ( &cmd->command, command, sizeof ( cmd->command ) );
+	cmd->itt = iscsi_new_itt();
+
+	/* Start sending command PDU, if the TX engine is idle */
+	iscsi_start_next_command ( iscsi );
+
+	/* Attach to parent interface, mortalise self, and return */
+	intf_plug_plug ( &cmd->data, parent );
+	ref_put ( &cmd->refcnt );
+	return cmd->itt;
 }
 
 /**
@@ -1839,33 +2062,6 @@ static struct interface_operation iscsi_control_op[] = {
 static struct interface_descriptor iscsi_control_desc =
 	INTF_DESC ( struct iscsi_session, control, iscsi_control_op );
 
-/**
- * Close iSCSI command
- *
- * @v iscsi		iSCSI session
- * @v rc		Reason for close
- */
-static void iscsi_command_close ( struct iscsi_session *iscsi, int rc ) {
-
-	/* Restart interface */
-	intf_restart ( &iscsi->data, rc );
-
-	/* Treat unsolicited command closures mid-command as fatal,
-	 * because we have no code to handle partially-completed PDUs.
-	 */
-	if ( iscsi->command != NULL )
-		iscsi_close ( iscsi, ( ( rc == 0 ) ? -ECANCELED : rc ) );
-}
-
-/** iSCSI SCSI command interface operations */
-static struct interface_operation iscsi_data_op[] = {
-	INTF_OP ( intf_close, struct iscsi_session *, iscsi_command_close ),
-};
-
-/** iSCSI SCSI command interface descriptor */
-static struct interface_descriptor iscsi_data_desc =
-	INTF_DESC ( struct iscsi_session, data, iscsi_data_op );
-
 /****************************************************************************
  *
  * Instantiator
@@ -2082,8 +2278,8 @@ static int iscsi_open ( struct interface *parent, struct uri *uri ) {
 	}
 	ref_init ( &iscsi->refcnt, iscsi_free );
 	intf_init ( &iscsi->control, &iscsi_control_desc, &iscsi->refcnt );
-	intf_init ( &iscsi->data, &iscsi_data_desc, &iscsi->refcnt );
 	intf_init ( &iscsi->socket, &iscsi_socket_desc, &iscsi->refcnt );
+	INIT_LIST_HEAD ( &iscsi->commands );
 	process_init_stopped ( &iscsi->process, &iscsi_process_desc,
 			       &iscsi->refcnt );
 	acpi_init ( &iscsi->desc, &ibft_model, &iscsi->refcnt );
@@ -0,0 +1,1316 @@
+/*
+ * Copyright (C) 2015 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * NVMe over TCP protocol
+ *
+ * The NVMe/TCP transport maps each NVMe queue pair onto its own TCP
+ * connection.  We establish an admin queue, use it to connect to and
+ * enable the controller, and then establish a single I/O queue used
+ * for all block data transfers.  The queueing model natively permits
+ * multiple commands to be outstanding on the I/O queue; commands are
+ * identified by the CID carried in each capsule.
+ *
+ * Header and data digests are not negotiated, and the namespace to be
+ * used is specified via the "nsid" query parameter of the URI, e.g.
+ *
+ *   nvmetcp://target.example.com/nqn.2000-01.com.example:disk?nsid=1
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/list.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/open.h>
+#include <ipxe/uri.h>
+#include <ipxe/socket.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/settings.h>
+#include <ipxe/blockdev.h>
+#include <ipxe/nvmetcp.h>
+
+/** Maximum data length for a single read/write command
+ *
+ * The maximum data transfer size supported by the controller is not
+ * known, since we do not issue an Identify Controller command.  Use a
+ * length small enough to be accepted by any plausible controller.
+ */
+#define NVMETCP_MAX_XFER_LEN 65536
+
+/** Maximum data length for a single H2CData PDU */
+#define NVMETCP_MAX_H2C_LEN 4096
+
+/** Submission queue depth (number of entries) */
+#define NVMETCP_QUEUE_ENTRIES 32
+
+/** Maximum number of controller readiness polls */
+#define NVMETCP_READY_MAX_POLLS 256
+
+/** An NVMe/TCP command */
+struct nvmetcp_command {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** NVMe/TCP session */
+	struct nvmetcp_session *nvmetcp;
+	/** List of outstanding commands */
+	struct list_head list;
+	/** Block data interface */
+	struct interface block;
+
+	/** Command identifier */
+	uint16_t cid;
+	/** Opcode */
+	uint8_t opcode;
+	/** Data buffer */
+	userptr_t buffer;
+	/** Length of data buffer */
+	size_t len;
+	/** Starting logical block address */
+	uint64_t lba;
+	/** Number of blocks */
+	unsigned int count;
+	/** Identify data buffer (if applicable) */
+	struct nvme_identity *identity;
+};
+
+static void nvmetcp_close ( struct nvmetcp_session *nvmetcp, int rc );
+
+/**
+ * Free NVMe/TCP command
+ *
+ * @v refcnt		Reference count
+ */
+static void nvmetcp_command_free ( struct refcnt *refcnt ) {
+	struct nvmetcp_command *cmd =
+		container_of ( refcnt, struct nvmetcp_command, refcnt );
+
+	/* Drop reference to session */
+	ref_put ( &cmd->nvmetcp->refcnt );
+
+	/* Free command */
+	free ( cmd->identity );
+	free ( cmd );
+}
+
+/**
+ * Close NVMe/TCP command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v rc		Reason for close
+ */
+static void nvmetcp_command_close ( struct nvmetcp_command *cmd, int rc ) {
+	struct nvmetcp_session *nvmetcp = cmd->nvmetcp;
+
+	if ( rc != 0 ) {
+		DBGC ( nvmetcp, "NVMETCP %p cid %#04x closed: %s\n",
+		       nvmetcp, cmd->cid, strerror ( rc ) );
+	}
+
+	/* Remove from list of commands */
+	list_del ( &cmd->list );
+
+	/* Shut down interfaces */
+	intf_shutdown ( &cmd->block, rc );
+
+	/* Drop list's reference */
+	ref_put ( &cmd->refcnt );
+}
+
+/**
+ * Identify NVMe/TCP command by command identifier
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @v cid		Command identifier
+ * @ret cmd		Command, or NULL
+ */
+static struct nvmetcp_command *
+nvmetcp_find_cid ( struct nvmetcp_session *nvmetcp, uint16_t cid ) {
+	struct nvmetcp_command *cmd;
+
+	list_for_each_entry ( cmd, &nvmetcp->commands, list ) {
+		if ( cmd->cid == cid )
+			return cmd;
+	}
+	return NULL;
+}
+
+/**
+ * Transmit NVMe/TCP PDU
+ *
+ * @v queue		NVMe/TCP queue
+ * @v header		PDU header
+ * @v hlen		Length of PDU header
+ * @v data		Data to append, or NULL
+ * @v len		Length of data
+ * @ret rc		Return status code
+ */
+static int nvmetcp_tx ( struct nvmetcp_queue *queue, const void *header,
+			size_t hlen, const void *data, size_t len ) {
+	struct io_buffer *iobuf;
+
+	/* Allocate I/O buffer */
+	iobuf = xfer_alloc_iob ( &queue->socket, ( hlen + len ) );
+	if ( ! iobuf )
+		return -ENOMEM;
+
+	/* Populate I/O buffer */
+	memcpy ( iob_put ( iobuf, hlen ), header, hlen );
+	if ( len )
+		memcpy ( iob_put ( iobuf, len ), data, len );
+
+	/* Transmit I/O buffer */
+	return xfer_deliver_iob ( &queue->socket, iobuf );
+}
+
+/**
+ * Transmit initialise connection request
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_tx_icreq ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_icreq icreq;
+
+	/* Construct ICReq PDU */
+	memset ( &icreq, 0, sizeof ( icreq ) );
+	icreq.header.type = NVMETCP_ICREQ;
+	icreq.header.hlen = sizeof ( icreq );
+	icreq.header.plen = cpu_to_le32 ( sizeof ( icreq ) );
+
+	/* Transmit PDU */
+	return nvmetcp_tx ( queue, &icreq, sizeof ( icreq ), NULL, 0 );
+}
+
+/**
+ * Transmit command capsule
+ *
+ * @v queue		NVMe/TCP queue
+ * @v cmd		Command capsule (with common header zeroed)
+ * @v data		In-capsule data, or NULL
+ * @v len		Length of in-capsule data
+ * @ret rc		Return status code
+ */
+static int nvmetcp_tx_cmd ( struct nvmetcp_queue *queue,
+			    struct nvmetcp_cmd *cmd,
+			    const void *data, size_t len ) {
+
+	/* Construct common header */
+	cmd->header.type = NVMETCP_CMD;
+	cmd->header.hlen = sizeof ( *cmd );
+	cmd->header.pdo = ( len ? sizeof ( *cmd ) : 0 );
+	cmd->header.plen = cpu_to_le32 ( sizeof ( *cmd ) + len );
+
+	/* Transmit PDU */
+	return nvmetcp_tx ( queue, cmd, sizeof ( *cmd ), data, len );
+}
+
+/**
+ * Transmit connect command
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_tx_connect ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_session *nvmetcp = queue->nvmetcp;
+	struct nvme_connect_data *data;
+	struct nvmetcp_cmd cmd;
+	int rc;
+
+	/* Allocate connect data */
+	data = zalloc ( sizeof ( *data ) );
+	if ( ! data ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
+	/* Construct connect data */
+	memcpy ( &data->hostid, &nvmetcp->hostid, sizeof ( data->hostid ) );
+	data->cntlid = cpu_to_le16 ( queue->qid ? nvmetcp->cntlid :
+				     NVME_CNTLID_DYNAMIC );
+	snprintf ( data->subnqn, sizeof ( data->subnqn ), "%s",
+		   nvmetcp->subnqn );
+	snprintf ( data->hostnqn, sizeof ( data->hostnqn ), "%s",
+		   nvmetcp->hostnqn );
+
+	/* Construct connect command */
+	memset ( &cmd, 0, sizeof ( cmd ) );
+	cmd.u.fabrics.opcode = NVME_FABRICS;
+	cmd.u.fabrics.cid = cpu_to_le16 ( nvmetcp->cid++ );
+	cmd.u.fabrics.fctype = NVME_FABRICS_CONNECT;
+	cmd.u.fabrics.sgl.len = cpu_to_le32 ( sizeof ( *data ) );
+	cmd.u.fabrics.sgl.type = NVME_SGL_DATA_OFFSET;
+	cmd.u.fabrics.u.connect.qid = cpu_to_le16 ( queue->qid );
+	cmd.u.fabrics.u.connect.sqsize =
+		cpu_to_le16 ( NVMETCP_QUEUE_ENTRIES - 1 );
+
+	/* Transmit command capsule with in-capsule data */
+	if ( ( rc = nvmetcp_tx_cmd ( queue, &cmd, data,
+				     sizeof ( *data ) ) ) != 0 )
+		goto err_tx;
+
+ err_tx:
+	free ( data );
+ err_alloc:
+	return rc;
+}
+
+/**
+ * Transmit property set/get command
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @v fctype		Fabrics command type
+ * @v offset		Property offset
+ * @v value		Property value (for set)
+ * @ret rc		Return status code
+ */
+static int nvmetcp_tx_property ( struct nvmetcp_session *nvmetcp,
+				 unsigned int fctype, unsigned int offset,
+				 uint32_t value ) {
+	struct nvmetcp_cmd cmd;
+
+	/* Construct property command */
+	memset ( &cmd, 0, sizeof ( cmd ) );
+	cmd.u.fabrics.opcode = NVME_FABRICS;
+	cmd.u.fabrics.cid = cpu_to_le16 ( nvmetcp->cid++ );
+	cmd.u.fabrics.fctype = fctype;
+	cmd.u.fabrics.u.property.offset = cpu_to_le32 ( offset );
+	cmd.u.fabrics.u.property.value = cpu_to_le64 ( value );
+
+	/* Transmit command capsule */
+	return nvmetcp_tx_cmd ( &nvmetcp->admin, &cmd, NULL, 0 );
+}
+
+/**
+ * Transmit identify namespace command
+ *
+ * @v cmd		NVMe/TCP command
+ * @ret rc		Return status code
+ */
+static int nvmetcp_tx_identify ( struct nvmetcp_command *cmd ) {
+	struct nvmetcp_session *nvmetcp = cmd->nvmetcp;
+	struct nvmetcp_cmd capsule;
+
+	/* Construct identify command */
+	memset ( &capsule, 0, sizeof ( capsule ) );
+	capsule.u.sqe.opcode = NVME_IDENTIFY;
+	capsule.u.sqe.flags = NVME_SQE_FLAG_SGL;
+	capsule.u.sqe.cid = cpu_to_le16 ( cmd->cid );
+	capsule.u.sqe.nsid = cpu_to_le32 ( nvmetcp->nsid );
+	capsule.u.sqe.sgl.len = cpu_to_le32 ( cmd->len );
+	capsule.u.sqe.sgl.type = NVME_SGL_TRANSPORT;
+	capsule.u.sqe.cdw10[0] = cpu_to_le32 ( NVME_IDENTIFY_NS );
+
+	/* Transmit command capsule */
+	return nvmetcp_tx_cmd ( &nvmetcp->admin, &capsule, NULL, 0 );
+}
+
+/**
+ * Transmit read/write command
+ *
+ * @v cmd		NVMe/TCP command
+ * @ret rc		Return status code
+ */
+static int nvmetcp_tx_rw ( struct nvmetcp_command *cmd ) {
+	struct nvmetcp_session *nvmetcp = cmd->nvmetcp;
+	struct nvmetcp_cmd capsule;
+
+	/* Construct read/write command */
+	memset ( &capsule, 0, sizeof ( capsule ) );
+	capsule.u.sqe.opcode = cmd->opcode;
+	capsule.u.sqe.flags = NVME_SQE_FLAG_SGL;
+	capsule.u.sqe.cid = cpu_to_le16 ( cmd->cid );
+	capsule.u.sqe.nsid = cpu_to_le32 ( nvmetcp->nsid );
+	capsule.u.sqe.sgl.len = cpu_to_le32 ( cmd->len );
+	capsule.u.sqe.sgl.type = NVME_SGL_TRANSPORT;
+	capsule.u.sqe.cdw10[0] = cpu_to_le32 ( cmd->lba & 0xffffffffUL );
+	capsule.u.sqe.cdw10[1] = cpu_to_le32 ( cmd->lba >> 32 );
+	capsule.u.sqe.cdw10[2] = cpu_to_le32 ( cmd->count - 1 );
+
+	/* Transmit command capsule */
+	return nvmetcp_tx_cmd ( &nvmetcp->io, &capsule, NULL, 0 );
+}
+
+/**
+ * Transmit host to controller data PDUs
+ *
+ * @v cmd		NVMe/TCP command
+ * @v ttag		Transfer tag
+ * @v offset		Requested data offset
+ * @v len		Requested data length
+ * @ret rc		Return status code
+ */
+static int nvmetcp_tx_h2c_data ( struct nvmetcp_command *cmd,
+				 unsigned int ttag, size_t offset,
+				 size_t len ) {
+	struct nvmetcp_session *nvmetcp = cmd->nvmetcp;
+	struct nvmetcp_queue *queue = &nvmetcp->io;
+	struct nvmetcp_data data;
+	struct io_buffer *iobuf;
+	size_t frag_len;
+	int rc;
+
+	/* Transmit data in PDU-sized fragments */
+	while ( len ) {
+
+		/* Determine fragment length */
+		frag_len = len;
+		if ( frag_len > NVMETCP_MAX_H2C_LEN )
+			frag_len = NVMETCP_MAX_H2C_LEN;
+		if ( frag_len > queue->maxh2cdata )
+			frag_len = queue->maxh2cdata;
+
+		/* Construct H2CData PDU header */
+		memset ( &data, 0, sizeof ( data ) );
+		data.header.type = NVMETCP_H2C_DATA;
+		data.header.hlen = sizeof ( data );
+		data.header.pdo = sizeof ( data );
+		data.header.plen = cpu_to_le32 ( sizeof ( data ) + frag_len );
+		if ( frag_len == len )
+			data.header.flags = NVMETCP_FLAG_LAST;
+		data.cccid = cpu_to_le16 ( cmd->cid );
+		data.ttag = cpu_to_le16 ( ttag );
+		data.datao = cpu_to_le32 ( offset );
+		data.datal = cpu_to_le32 ( frag_len );
+
+		/* Allocate and populate I/O buffer */
+		iobuf = xfer_alloc_iob ( &queue->socket,
+					 ( sizeof ( data ) + frag_len ) );
+		if ( ! iobuf )
+			return -ENOMEM;
+		memcpy ( iob_put ( iobuf, sizeof ( data ) ), &data,
+			 sizeof ( data ) );
+		copy_from_user ( iob_put ( iobuf, frag_len ), cmd->buffer,
+				 offset, frag_len );
+
+		/* Transmit I/O buffer */
+		if ( ( rc = xfer_deliver_iob ( &queue->socket,
+					       iobuf ) ) != 0 )
+			return rc;
+
+		/* Move to next fragment */
+		offset += frag_len;
+		len -= frag_len;
+	}
+
+	return 0;
+}
+
+/**
+ * Parse identify namespace data and report block device capacity
+ *
+ * @v cmd		NVMe/TCP command
+ * @ret rc		Return status code
+ */
+static int nvmetcp_identified ( struct nvmetcp_command *cmd ) {
+	struct nvmetcp_session *nvmetcp = cmd->nvmetcp;
+	struct nvme_identity *identity = cmd->identity;
+	struct block_device_capacity capacity;
+	struct nvme_lbaf *lbaf;
+	unsigned int format;
+
+	/* Identify LBA format in use */
+	format = NVME_FLBAS_FORMAT ( identity->flbas );
+	lbaf = &identity->lbaf[format];
+
+	/* Reject nonexistent namespaces */
+	if ( ! identity->nsze ) {
+		DBGC ( nvmetcp, "NVMETCP %p namespace %d does not exist\n",
+		       nvmetcp, nvmetcp->nsid );
+		return -ENODEV;
+	}
+
+	/* Reject formats using metadata: we have no way to handle it */
+	if ( lbaf->ms || ( identity->flbas & NVME_FLBAS_EXTENDED ) ) {
+		DBGC ( nvmetcp, "NVMETCP %p unsupported metadata (format "
+		       "%d)\n", nvmetcp, format );
+		return -ENOTSUP;
+	}
+
+	/* Construct block device capacity */
+	capacity.blocks = le64_to_cpu ( identity->nsze );
+	capacity.blksize = ( 1UL << lbaf->lbads );
+	capacity.max_count = ( NVMETCP_MAX_XFER_LEN / capacity.blksize );
+	DBGC ( nvmetcp, "NVMETCP %p namespace %d has %#llx blocks of %zd "
+	       "bytes\n", nvmetcp, nvmetcp->nsid,
+	       ( ( unsigned long long ) capacity.blocks ), capacity.blksize );
+
+	/* Report block device capacity */
+	block_capacity ( &cmd->block, &capacity );
+
+	return 0;
+}
+
+/**
+ * Complete NVMe/TCP command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v rc		Command status code
+ */
+static void nvmetcp_command_done ( struct nvmetcp_command *cmd, int rc ) {
+
+	/* Parse identify data, if applicable */
+	if ( ( rc == 0 ) && cmd->identity )
+		rc = nvmetcp_identified ( cmd );
+
+	/* Close command */
+	nvmetcp_command_close ( cmd, rc );
+}
+
+/**
+ * Handle received initialise connection response
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_icresp ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_session *nvmetcp = queue->nvmetcp;
+	struct nvmetcp_icresp *icresp = &queue->rx.icresp;
+	int rc;
+
+	/* Sanity checks */
+	if ( ( ( nvmetcp->state != NVMETCP_STATE_ADMIN_ICREQ ) &&
+	       ( nvmetcp->state != NVMETCP_STATE_IO_ICREQ ) ) ||
+	     ( icresp->header.hlen < sizeof ( *icresp ) ) ) {
+		DBGC ( nvmetcp, "NVMETCP %p unexpected ICResp\n", nvmetcp );
+		return -EPROTO;
+	}
+
+	/* We offer no digests and no data alignment; the controller
+	 * may not enable what was not offered.
+	 */
+	if ( icresp->pfv || icresp->dgst || icresp->cpda ) {
+		DBGC ( nvmetcp, "NVMETCP %p unsupported connection "
+		       "parameters (pfv %d dgst %#02x cpda %d)\n", nvmetcp,
+		       le16_to_cpu ( icresp->pfv ), icresp->dgst,
+		       icresp->cpda );
+		return -ENOTSUP;
+	}
+
+	/* Record maximum host to controller data length */
+	queue->maxh2cdata = le32_to_cpu ( icresp->maxh2cdata );
+
+	/* Connect queue */
+	if ( ( rc = nvmetcp_tx_connect ( queue ) ) != 0 )
+		return rc;
+	nvmetcp->state = ( queue->qid ? NVMETCP_STATE_IO_CONNECT :
+			   NVMETCP_STATE_ADMIN_CONNECT );
+
+	return 0;
+}
+
+/**
+ * Open NVMe/TCP queue
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_open_queue ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_session *nvmetcp = queue->nvmetcp;
+	struct sockaddr_tcpip target;
+	int rc;
+
+	/* Open socket */
+	memset ( &target, 0, sizeof ( target ) );
+	target.st_port = htons ( nvmetcp->target_port );
+	if ( ( rc = xfer_open_named_socket ( &queue->socket, SOCK_STREAM,
+					     ( struct sockaddr * ) &target,
+					     nvmetcp->target_address,
+					     NULL ) ) != 0 ) {
+		DBGC ( nvmetcp, "NVMETCP %p could not open queue %d socket: "
+		       "%s\n", nvmetcp, queue->qid, strerror ( rc ) );
+		return rc;
+	}
+
+	/* Initiate connection establishment */
+	if ( ( rc = nvmetcp_tx_icreq ( queue ) ) != 0 )
+		return rc;
+
+	return 0;
+}
+
+/**
+ * Handle received response capsule
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_rsp ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_session *nvmetcp = queue->nvmetcp;
+	struct nvme_cqe *cqe = &queue->rx.rsp.cqe;
+	struct nvmetcp_command *cmd;
+	unsigned int status;
+	uint32_t csts;
+	int rc;
+
+	/* Extract status (ignoring the phase tag) */
+	status = ( le16_to_cpu ( cqe->status ) >> 1 );
+
+	/* Handle session establishment responses */
+	switch ( nvmetcp->state ) {
+
+	case NVMETCP_STATE_ADMIN_CONNECT:
+		if ( status ) {
+			DBGC ( nvmetcp, "NVMETCP %p connect failed: status "
+			       "%#04x\n", nvmetcp, status );
+			return -EPERM;
+		}
+		nvmetcp->cntlid = ( le32_to_cpu ( cqe->dw0 ) & 0xffff );
+		DBGC ( nvmetcp, "NVMETCP %p connected to controller %#04x\n",
+		       nvmetcp, nvmetcp->cntlid );
+		if ( ( rc = nvmetcp_tx_property ( nvmetcp,
+						  NVME_FABRICS_PROPERTY_SET,
+						  NVME_REG_CC,
+						  NVME_CC_VALUE ) ) != 0 )
+			return rc;
+		nvmetcp->state = NVMETCP_STATE_ENABLE;
+		return 0;
+
+	case NVMETCP_STATE_ENABLE:
+		if ( status ) {
+			DBGC ( nvmetcp, "NVMETCP %p could not enable "
+			       "controller: status %#04x\n", nvmetcp, status );
+			return -EIO;
+		}
+		nvmetcp->ready_polls = NVMETCP_READY_MAX_POLLS;
+		if ( ( rc = nvmetcp_tx_property ( nvmetcp,
+						  NVME_FABRICS_PROPERTY_GET,
+						  NVME_REG_CSTS, 0 ) ) != 0 )
+			return rc;
+		nvmetcp->state = NVMETCP_STATE_WAIT_READY;
+		return 0;
+
+	case NVMETCP_STATE_WAIT_READY:
+		csts = le32_to_cpu ( cqe->dw0 );
+		if ( status || ( csts & NVME_CSTS_CFS ) ) {
+			DBGC ( nvmetcp, "NVMETCP %p controller failed: "
+			       "status %#04x csts %#08x\n", nvmetcp, status,
+			       csts );
+			return -EIO;
+		}
+		if ( ! ( csts & NVME_CSTS_RDY ) ) {
+			/* Poll again (paced by the network round trip) */
+			if ( ! --nvmetcp->ready_polls ) {
+				DBGC ( nvmetcp, "NVMETCP %p controller never "
+				       "became ready\n", nvmetcp );
+				return -ETIMEDOUT;
+			}
+			return nvmetcp_tx_property ( nvmetcp,
+						     NVME_FABRICS_PROPERTY_GET,
+						     NVME_REG_CSTS, 0 );
+		}
+		if ( ( rc = nvmetcp_open_queue ( &nvmetcp->io ) ) != 0 )
+			return rc;
+		nvmetcp->state = NVMETCP_STATE_IO_ICREQ;
+		return 0;
+
+	case NVMETCP_STATE_IO_CONNECT:
+		if ( status ) {
+			DBGC ( nvmetcp, "NVMETCP %p I/O queue connect failed: "
+			       "status %#04x\n", nvmetcp, status );
+			return -EPERM;
+		}
+		DBGC ( nvmetcp, "NVMETCP %p session established\n", nvmetcp );
+		nvmetcp->state = NVMETCP_STATE_READY;
+		xfer_window_changed ( &nvmetcp->block );
+		return 0;
+
+	default:
+		break;
+	}
+
+	/* Identify and complete command.  A response for an unknown
+	 * CID is not an error: the command may have been cancelled.
+	 */
+	cmd = nvmetcp_find_cid ( nvmetcp, le16_to_cpu ( cqe->cid ) );
+	if ( ! cmd ) {
+		DBGC ( nvmetcp, "NVMETCP %p response for unknown cid %#04x\n",
+		       nvmetcp, le16_to_cpu ( cqe->cid ) );
+		return 0;
+	}
+	if ( status ) {
+		DBGC ( nvmetcp, "NVMETCP %p cid %#04x failed: status %#04x\n",
+		       nvmetcp, cmd->cid, status );
+	}
+	nvmetcp_command_done ( cmd, ( status ? -EIO : 0 ) );
+
+	return 0;
+}
+
+/**
+ * Handle received ready to transfer PDU
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_r2t ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_session *nvmetcp = queue->nvmetcp;
+	struct nvmetcp_r2t *r2t = &queue->rx.r2t;
+	struct nvmetcp_command *cmd;
+	size_t offset = le32_to_cpu ( r2t->r2to );
+	size_t len = le32_to_cpu ( r2t->r2tl );
+
+	/* Identify command */
+	cmd = nvmetcp_find_cid ( nvmetcp, le16_to_cpu ( r2t->cccid ) );
+	if ( ! cmd ) {
+		DBGC ( nvmetcp, "NVMETCP %p R2T for unknown cid %#04x\n",
+		       nvmetcp, le16_to_cpu ( r2t->cccid ) );
+		return -EPROTO;
+	}
+
+	/* Sanity check */
+	if ( ( offset + len ) > cmd->len ) {
+		DBGC ( nvmetcp, "NVMETCP %p R2T out of range [%#zx,%#zx)\n",
+		       nvmetcp, offset, ( offset + len ) );
+		return -EPROTO;
+	}
+
+	/* Transmit requested data */
+	return nvmetcp_tx_h2c_data ( cmd, le16_to_cpu ( r2t->ttag ),
+				     offset, len );
+}
+
+/**
+ * Handle completion of received controller to host data PDU
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_c2h_done ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_session *nvmetcp = queue->nvmetcp;
+	struct nvmetcp_data *data = &queue->rx.data;
+	struct nvmetcp_command *cmd;
+
+	/* A data PDU flagged as successful elides the response capsule */
+	if ( ! ( data->header.flags & NVMETCP_FLAG_SUCCESS ) )
+		return 0;
+
+	/* Identify and complete command */
+	cmd = nvmetcp_find_cid ( nvmetcp, le16_to_cpu ( data->cccid ) );
+	if ( ! cmd ) {
+		DBGC ( nvmetcp, "NVMETCP %p data for unknown cid %#04x\n",
+		       nvmetcp, le16_to_cpu ( data->cccid ) );
+		return -EPROTO;
+	}
+	nvmetcp_command_done ( cmd, 0 );
+
+	return 0;
+}
+
+/**
+ * Handle received controller to host data
+ *
+ * @v queue		NVMe/TCP queue
+ * @v offset		Offset within PDU data
+ * @v data		Received data
+ * @v len		Length of received data
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_c2h_data ( struct nvmetcp_queue *queue, size_t offset,
+				 const void *data, size_t len ) {
+	struct nvmetcp_session *nvmetcp = queue->nvmetcp;
+	struct nvmetcp_data *c2h = &queue->rx.data;
+	struct nvmetcp_command *cmd;
+	size_t datao = le32_to_cpu ( c2h->datao );
+
+	/* Identify command */
+	cmd = nvmetcp_find_cid ( nvmetcp, le16_to_cpu ( c2h->cccid ) );
+	if ( ! cmd ) {
+		DBGC ( nvmetcp, "NVMETCP %p data for unknown cid %#04x\n",
+		       nvmetcp, le16_to_cpu ( c2h->cccid ) );
+		return -EPROTO;
+	}
+
+	/* Sanity check */
+	if ( ( datao + offset + len ) > cmd->len ) {
+		DBGC ( nvmetcp, "NVMETCP %p data out of range [%#zx,%#zx)\n",
+		       nvmetcp, ( datao + offset ),
+		       ( datao + offset + len ) );
+		return -EPROTO;
+	}
+
+	/* Copy data to command data buffer */
+	copy_to_user ( cmd->buffer, ( datao + offset ), data, len );
+
+	return 0;
+}
+
+/**
+ * Handle received PDU completion
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_complete ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_session *nvmetcp = queue->nvmetcp;
+
+	switch ( queue->rx.header.type ) {
+	case NVMETCP_ICRESP:
+		return nvmetcp_rx_icresp ( queue );
+	case NVMETCP_RSP:
+		return nvmetcp_rx_rsp ( queue );
+	case NVMETCP_C2H_DATA:
+		return nvmetcp_rx_c2h_done ( queue );
+	case NVMETCP_R2T:
+		return nvmetcp_rx_r2t ( queue );
+	case NVMETCP_C2H_TERM:
+		DBGC ( nvmetcp, "NVMETCP %p connection terminated by "
+		       "controller\n", nvmetcp );
+		return -EPROTO;
+	default:
+		DBGC ( nvmetcp, "NVMETCP %p unknown PDU type %#02x\n",
+		       nvmetcp, queue->rx.header.type );
+		return -EPROTO;
+	}
+}
+
+/**
+ * Process received data
+ *
+ * @v queue		NVMe/TCP queue
+ * @v data		Received data
+ * @v len		Length of received data
+ * @ret rc		Return status code
+ */
+static int nvmetcp_queue_rx ( struct nvmetcp_queue *queue, const void *data,
+			      size_t len ) {
+	struct nvmetcp_session *nvmetcp = queue->nvmetcp;
+	size_t hlen;
+	size_t plen;
+	size_t pdo;
+	size_t frag_len;
+	int rc;
+
+	while ( 1 ) {
+
+		/* Receive PDU header.  The header length is variable,
+		 * and is not known until the common header has been
+		 * received.
+		 */
+		hlen = ( ( queue->rx_offset < sizeof ( queue->rx.header ) ) ?
+			 sizeof ( queue->rx.header ) : queue->rx.header.hlen );
+		if ( hlen > sizeof ( queue->rx ) ) {
+			DBGC ( nvmetcp, "NVMETCP %p oversized PDU header "
+			       "(%zd bytes)\n", nvmetcp, hlen );
+			return -EPROTO;
+		}
+		if ( queue->rx_offset < hlen ) {
+			if ( ! len )
+				break;
+			frag_len = ( hlen - queue->rx_offset );
+			if ( frag_len > len )
+				frag_len = len;
+			memcpy ( ( queue->rx.bytes + queue->rx_offset ),
+				 data, frag_len );
+			queue->rx_offset += frag_len;
+			data += frag_len;
+			len -= frag_len;
+			continue;
+		}
+
+		/* Sanity check PDU length */
+		plen = le32_to_cpu ( queue->rx.header.plen );
+		pdo = queue->rx.header.pdo;
+		if ( ( plen < hlen ) || ( pdo && ( pdo < hlen ) ) ) {
+			DBGC ( nvmetcp, "NVMETCP %p malformed PDU (hlen %zd "
+			       "pdo %zd plen %zd)\n", nvmetcp, hlen, pdo,
+			       plen );
+			return -EPROTO;
+		}
+
+		/* Receive PDU payload */
+		if ( queue->rx_offset < plen ) {
+			if ( ! len )
+				break;
+			frag_len = ( plen - queue->rx_offset );
+			if ( frag_len > len )
+				frag_len = len;
+			if ( queue->rx.header.type == NVMETCP_C2H_DATA ) {
+				/* Skip any padding before the data */
+				if ( queue->rx_offset < pdo ) {
+					if ( frag_len >
+					     ( pdo - queue->rx_offset ) ) {
+						frag_len = ( pdo -
+							     queue->rx_offset );
+					}
+				} else if ( ( rc = nvmetcp_rx_c2h_data (
+						queue,
+						( queue->rx_offset - pdo ),
+						data, frag_len ) ) != 0 ) {
+					return rc;
+				}
+			}
+			queue->rx_offset += frag_len;
+			data += frag_len;
+			len -= frag_len;
+			continue;
+		}
+
+		/* Handle completed PDU */
+		if ( ( rc = nvmetcp_rx_complete ( queue ) ) != 0 )
+			return rc;
+		queue->rx_offset = 0;
+	}
+
+	return 0;
+}
+
+/**
+ * Handle received data on queue socket
+ *
+ * @v queue		NVMe/TCP queue
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int nvmetcp_queue_deliver ( struct nvmetcp_queue *queue,
+				   struct io_buffer *iobuf,
+				   struct xfer_metadata *meta __unused ) {
+	struct nvmetcp_session *nvmetcp = queue->nvmetcp;
+	int rc;
+
+	/* Process received data */
+	rc = nvmetcp_queue_rx ( queue, iobuf->data, iob_len ( iobuf ) );
+	free_iob ( iobuf );
+
+	/* Terminate session on error */
+	if ( rc != 0 )
+		nvmetcp_close ( nvmetcp, rc );
+
+	return rc;
+}
+
+/**
+ * Handle closure of queue socket
+ *
+ * @v queue		NVMe/TCP queue
+ * @v rc		Reason for close
+ */
+static void nvmetcp_queue_closed ( struct nvmetcp_queue *queue, int rc ) {
+	struct nvmetcp_session *nvmetcp = queue->nvmetcp;
+
+	/* Any closure is an error from our point of view */
+	if ( rc == 0 )
+		rc = -ECONNRESET;
+	DBGC ( nvmetcp, "NVMETCP %p queue %d closed: %s\n",
+	       nvmetcp, queue->qid, strerror ( rc ) );
+
+	/* Terminate session */
+	nvmetcp_close ( nvmetcp, rc );
+}
+
+/**
+ * Handle received data on admin queue socket
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int nvmetcp_admin_deliver ( struct nvmetcp_session *nvmetcp,
+				   struct io_buffer *iobuf,
+				   struct xfer_metadata *meta ) {
+	return nvmetcp_queue_deliver ( &nvmetcp->admin, iobuf, meta );
+}
+
+/**
+ * Handle closure of admin queue socket
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @v rc		Reason for close
+ */
+static void nvmetcp_admin_closed ( struct nvmetcp_session *nvmetcp, int rc ) {
+	nvmetcp_queue_closed ( &nvmetcp->admin, rc );
+}
+
+/**
+ * Handle received data on I/O queue socket
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int nvmetcp_io_deliver ( struct nvmetcp_session *nvmetcp,
+				struct io_buffer *iobuf,
+				struct xfer_metadata *meta ) {
+	return nvmetcp_queue_deliver ( &nvmetcp->io, iobuf, meta );
+}
+
+/**
+ * Handle closure of I/O queue socket
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @v rc		Reason for close
+ */
+static void nvmetcp_io_closed ( struct nvmetcp_session *nvmetcp, int rc ) {
+	nvmetcp_queue_closed ( &nvmetcp->io, rc );
+}
+
+/** NVMe/TCP admin queue socket interface operations */
+static struct interface_operation nvmetcp_admin_operations[] = {
+	INTF_OP ( xfer_deliver, struct nvmetcp_session *,
+		  nvmetcp_admin_deliver ),
+	INTF_OP ( intf_close, struct nvmetcp_session *, nvmetcp_admin_closed ),
+};
+
+/** NVMe/TCP admin queue socket interface descriptor */
+static struct interface_descriptor nvmetcp_admin_desc =
+	INTF_DESC ( struct nvmetcp_session, admin.socket,
+		    nvmetcp_admin_operations );
+
+/** NVMe/TCP I/O queue socket interface operations */
+static struct interface_operation nvmetcp_io_operations[] = {
+	INTF_OP ( xfer_deliver, struct nvmetcp_session *, nvmetcp_io_deliver ),
+	INTF_OP ( intf_close, struct nvmetcp_session *, nvmetcp_io_closed ),
+};
+
+/** NVMe/TCP I/O queue socket interface descriptor */
+static struct interface_descriptor nvmetcp_io_desc =
+	INTF_DESC ( struct nvmetcp_session, io.socket, nvmetcp_io_operations );
+
+/** NVMe/TCP command block data interface operations */
+static struct interface_operation nvmetcp_command_block_operations[] = {
+	INTF_OP ( intf_close, struct nvmetcp_command *,
+		  nvmetcp_command_close ),
+};
+
+/** NVMe/TCP command block data interface descriptor */
+static struct interface_descriptor nvmetcp_command_block_desc =
+	INTF_DESC ( struct nvmetcp_command, block,
+		    nvmetcp_command_block_operations );
+
+/**
+ * Create and issue NVMe/TCP command
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @v block		Block data interface
+ * @v opcode		Opcode
+ * @v lba		Starting logical block address
+ * @v count		Number of blocks
+ * @v buffer		Data buffer
+ * @v len		Length of data buffer
+ * @ret rc		Return status code
+ */
+static int nvmetcp_command ( struct nvmetcp_session *nvmetcp,
+			     struct interface *block, unsigned int opcode,
+			     uint64_t lba, unsigned int count,
+			     userptr_t buffer, size_t len ) {
+	struct nvmetcp_command *cmd;
+	int rc;
+
+	/* Fail unless the session is established */
+	if ( nvmetcp->state != NVMETCP_STATE_READY ) {
+		rc = -ENOTCONN;
+		goto err_state;
+	}
+
+	/* Allocate and initialise structure */
+	cmd = zalloc ( sizeof ( *cmd ) );
+	if ( ! cmd ) {
+		rc = -ENOMEM;
+		goto err_zalloc;
+	}
+	ref_init ( &cmd->refcnt, nvmetcp_command_free );
+	intf_init ( &cmd->block, &nvmetcp_command_block_desc, &cmd->refcnt );
+	ref_get ( &nvmetcp->refcnt );
+	cmd->nvmetcp = nvmetcp;
+	list_add ( &cmd->list, &nvmetcp->commands );
+	cmd->cid = nvmetcp->cid++;
+	cmd->opcode = opcode;
+	cmd->lba = lba;
+	cmd->count = count;
+	cmd->buffer = buffer;
+	cmd->len = len;
+
+	/* Allocate identify buffer, if applicable */
+	if ( opcode == NVME_IDENTIFY ) {
+		cmd->identity = zalloc ( NVME_IDENTIFY_LEN );
+		if ( ! cmd->identity ) {
+			rc = -ENOMEM;
+			goto err_identity;
+		}
+		cmd->buffer = virt_to_user ( cmd->identity );
+		cmd->len = NVME_IDENTIFY_LEN;
+	}
+
+	/* Issue command */
+	if ( opcode == NVME_IDENTIFY ) {
+		rc = nvmetcp_tx_identify ( cmd );
+	} else {
+		rc = nvmetcp_tx_rw ( cmd );
+	}
+	if ( rc != 0 )
+		goto err_tx;
+
+	/* Attach to parent interface, transfer reference to list, and
+	 * return
+	 */
+	intf_plug_plug ( &cmd->block, block );
+	return 0;
+
+ err_tx:
+ err_identity:
+	nvmetcp_command_close ( cmd, rc );
+	ref_put ( &cmd->refcnt );
+ err_zalloc:
+ err_state:
+	return rc;
+}
+
+/**
+ * Check block device flow-control window
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @ret len		Length of window
+ */
+static size_t nvmetcp_block_window ( struct nvmetcp_session *nvmetcp ) {
+
+	/* Report a non-zero window once the session is established */
+	return ( ( nvmetcp->state == NVMETCP_STATE_READY ) ? 1 : 0 );
+}
+
+/**
+ * Issue block device read
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @v block		Block data interface
+ * @v lba		Starting logical block address
+ * @v count		Number of blocks
+ * @v buffer		Data buffer
+ * @v len		Length of data buffer
+ * @ret rc		Return status code
+ */
+static int nvmetcp_block_read ( struct nvmetcp_session *nvmetcp,
+				struct interface *block, uint64_t lba,
+				unsigned int count, userptr_t buffer,
+				size_t len ) {
+
+	return nvmetcp_command ( nvmetcp, block, NVME_READ, lba, count,
+				 buffer, len );
+}
+
+/**
+ * Issue block device write
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @v block		Block data interface
+ * @v lba		Starting logical block address
+ * @v count		Number of blocks
+ * @v buffer		Data buffer
+ * @v len		Length of data buffer
+ * @ret rc		Return status code
+ */
+static int nvmetcp_block_write ( struct nvmetcp_session *nvmetcp,
+				 struct interface *block, uint64_t lba,
+				 unsigned int count, userptr_t buffer,
+				 size_t len ) {
+
+	return nvmetcp_command ( nvmetcp, block, NVME_WRITE, lba, count,
+				 buffer, len );
+}
+
+/**
+ * Read block device capacity
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @v block		Block data interface
+ * @ret rc		Return status code
+ */
+static int nvmetcp_block_read_capacity ( struct nvmetcp_session *nvmetcp,
+					 struct interface *block ) {
+
+	return nvmetcp_command ( nvmetcp, block, NVME_IDENTIFY, 0, 0,
+				 UNULL, 0 );
+}
+
+/**
+ * Free NVMe/TCP session
+ *
+ * @v refcnt		Reference count
+ */
+static void nvmetcp_free ( struct refcnt *refcnt ) {
+	struct nvmetcp_session *nvmetcp =
+		container_of ( refcnt, struct nvmetcp_session, refcnt );
+
+	free ( nvmetcp->target_address );
+	free ( nvmetcp->subnqn );
+	free ( nvmetcp->hostnqn );
+	free ( nvmetcp );
+}
+
+/**
+ * Close NVMe/TCP session
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @v rc		Reason for close
+ */
+static void nvmetcp_close ( struct nvmetcp_session *nvmetcp, int rc ) {
+	struct nvmetcp_command *cmd;
+
+	/* Close any outstanding commands */
+	while ( ( cmd = list_first_entry ( &nvmetcp->commands,
+					   struct nvmetcp_command, list ) ) ) {
+		nvmetcp_command_close ( cmd, rc );
+	}
+
+	/* Shut down interfaces */
+	intfs_shutdown ( rc, &nvmetcp->io.socket, &nvmetcp->admin.socket,
+			 &nvmetcp->block, NULL );
+}
+
+/** NVMe/TCP block device interface operations */
+static struct interface_operation nvmetcp_block_operations[] = {
+	INTF_OP ( xfer_window, struct nvmetcp_session *,
+		  nvmetcp_block_window ),
+	INTF_OP ( block_read, struct nvmetcp_session *, nvmetcp_block_read ),
+	INTF_OP ( block_write, struct nvmetcp_session *, nvmetcp_block_write ),
+	INTF_OP ( block_read_capacity, struct nvmetcp_session *,
+		  nvmetcp_block_read_capacity ),
+	INTF_OP ( intf_close, struct nvmetcp_session *, nvmetcp_close ),
+};
+
+/** NVMe/TCP block device interface descriptor */
+static struct interface_descriptor nvmetcp_block_desc =
+	INTF_DESC ( struct nvmetcp_session, block, nvmetcp_block_operations );
+
+/**
+ * Construct host NQN and host identifier from settings
+ *
+ * @v nvmetcp		NVMe/TCP session
+ * @ret rc		Return status code
+ */
+static int nvmetcp_fetch_settings ( struct nvmetcp_session *nvmetcp ) {
+	union uuid uuid;
+	char *hostname;
+	int len;
+
+	/* Construct host NQN from the system UUID, if available */
+	if ( fetch_uuid_setting ( NULL, &uuid_setting, &uuid ) >= 0 ) {
+		memcpy ( &nvmetcp->hostid, &uuid,
+			 sizeof ( nvmetcp->hostid ) );
+		len = asprintf ( &nvmetcp->hostnqn,
+				 NVMETCP_NQN_PREFIX ":uuid:%s",
+				 uuid_ntoa ( &uuid ) );
+		return ( ( len < 0 ) ? len : 0 );
+	}
+
+	/* Otherwise, construct a host NQN from the hostname */
+	fetch_string_setting_copy ( NULL, &hostname_setting, &hostname );
+	if ( hostname ) {
+		len = asprintf ( &nvmetcp->hostnqn,
+				 NVMETCP_NQN_PREFIX ":%s", hostname );
+		free ( hostname );
+		return ( ( len < 0 ) ? len : 0 );
+	}
+
+	DBGC ( nvmetcp, "NVMETCP %p has no suitable host NQN\n", nvmetcp );
+	return -EINVAL;
+}
+
+/**
+ * Open NVMe/TCP URI
+ *
+ * @v parent		Parent interface
+ * @v uri		URI
+ * @ret rc		Return status code
+ */
+static int nvmetcp_open ( struct interface *parent, struct uri *uri ) {
+	struct nvmetcp_session *nvmetcp;
+	int rc;
+
+	/* Sanity checks */
+	if ( ( ! uri->host ) || ( ! uri->path ) ||
+	     ( uri->path[0] != '/' ) || ( ! uri->path[1] ) ) {
+		rc = -EINVAL;
+		goto err_sanity;
+	}
+
+	/* Allocate and initialise structure */
+	nvmetcp = zalloc ( sizeof ( *nvmetcp ) );
+	if ( ! nvmetcp ) {
+		rc = -ENOMEM;
+		goto err_zalloc;
+	}
+	ref_init ( &nvmetcp->refcnt, nvmetcp_free );
+	intf_init ( &nvmetcp->block, &nvmetcp_block_desc, &nvmetcp->refcnt );
+	intf_init ( &nvmetcp->admin.socket, &nvmetcp_admin_desc,
+		    &nvmetcp->refcnt );
+	intf_init ( &nvmetcp->io.socket, &nvmetcp_io_desc, &nvmetcp->refcnt );
+	nvmetcp->admin.nvmetcp = nvmetcp;
+	nvmetcp->io.nvmetcp = nvmetcp;
+	nvmetcp->io.qid = 1;
+	INIT_LIST_HEAD ( &nvmetcp->commands );
+
+	/* Parse URI */
+	nvmetcp->target_address = strdup ( uri->host );
+	nvmetcp->subnqn = strdup ( &uri->path[1] );
+	if ( ( ! nvmetcp->target_address ) || ( ! nvmetcp->subnqn ) ) {
+		rc = -ENOMEM;
+		goto err_parse;
+	}
+	nvmetcp->target_port = uri_port ( uri, NVMETCP_PORT );
+	nvmetcp->nsid = 1;
+	if ( uri->query && ( strncmp ( uri->query, "nsid=", 5 ) == 0 ) )
+		nvmetcp->nsid = strtoul ( &uri->query[5], NULL, 0 );
+
+	/* Construct host NQN */
+	if ( ( rc = nvmetcp_fetch_settings ( nvmetcp ) ) != 0 )
+		goto err_fetch_settings;
+	DBGC ( nvmetcp, "NVMETCP %p host %s\n", nvmetcp, nvmetcp->hostnqn );
+	DBGC ( nvmetcp, "NVMETCP %p target %s:%d %s nsid %d\n", nvmetcp,
+	       nvmetcp->target_address, nvmetcp->target_port,
+	       nvmetcp->subnqn, nvmetcp->nsid );
+
+	/* Open admin queue and initiate connection establishment */
+	if ( ( rc = nvmetcp_open_queue ( &nvmetcp->admin ) ) != 0 )
+		goto err_open_queue;
+
+	/* Attach to parent interface, mortalise self, and return */
+	intf_plug_plug ( &nvmetcp->block, parent );
+	ref_put ( &nvmetcp->refcnt );
+	return 0;
+
+ err_open_queue:
+ err_fetch_settings:
+ err_parse:
+	nvmetcp_close ( nvmetcp, rc );
+	ref_put ( &nvmetcp->refcnt );
+ err_zalloc:
+ err_sanity:
+	return rc;
+}
+
+/** NVMe/TCP URI opener */
+struct uri_opener nvmetcp_uri_opener __uri_opener = {
+	.scheme = "nvmetcp",
+	.open = nvmetcp_open,
+};
@@ -7,6 +7,7 @@
 #include <ipxe/tables.h>
 #include <ipxe/ipstat.h>
 #include <ipxe/netdevice.h>
+#include <ipxe/profile.h>
 #include <ipxe/tcpip.h>
 
 /** @file
@@ -19,6 +20,40 @@
 
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
+/** Ingress-to-transport-demultiplex latency profiler */
+static struct profiler tcpip_latency_profiler __profiler =
+	{ .name = "tcpip.latency" };
+
+/**
+ * Find transport-layer protocol
+ *
+ * @v tcpip_proto	Transport-layer protocol number
+ * @ret tcpip		Transport-layer protocol, or NULL if not found
+ */
+static struct tcpip_protocol * tcpip_protocol ( uint8_t tcpip_proto ) {
+	static struct tcpip_protocol *cache;
+	struct tcpip_protocol *tcpip;
+
+	/* Try the most recently used protocol first.  Boot workloads
+	 * are dominated by a single transport-layer protocol (and a
+	 * minimised build may compile in only one), so this almost
+	 * always reduces demultiplexing to a single comparison.
+	 */
+	tcpip = cache;
+	if ( tcpip && ( tcpip->tcpip_proto == tcpip_proto ) )
+		return tcpip;
+
+	/* Scan through the compiled-in protocols */
+	for_each_table_entry ( tcpip, TCPIP_PROTOCOLS ) {
+		if ( tcpip->tcpip_proto == tcpip_proto ) {
+			cache = tcpip;
+			return tcpip;
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * Process a received TCP/IP packet
  *
@@ -43,14 +78,21 @@ int tcpip_rx ( struct io_buffer *iobuf, struct net_device *netdev,
 	       struct ip_statistics *stats ) {
 	struct tcpip_protocol *tcpip;
 
+	/* Record latency between ingress and transport-layer
+	 * demultiplexing.
+	 */
+	if ( PROFILING ) {
+		profile_custom ( &tcpip_latency_profiler,
+				 ( profile_timestamp() - iobuf->rx_stamp ) );
+	}
+
 	/* Hand off packet to the appropriate transport-layer protocol */
-	for_each_table_entry ( tcpip, TCPIP_PROTOCOLS ) {
-		if ( tcpip->tcpip_proto == tcpip_proto ) {
-			DBG ( "TCP/IP received %s packet\n", tcpip->name );
-			stats->in_delivers++;
-			return tcpip->rx ( iobuf, netdev, st_src, st_dest,
-					   pshdr_csum );
-		}
+	tcpip = tcpip_protocol ( tcpip_proto );
+	if ( tcpip ) {
+		DBG ( "TCP/IP received %s packet\n", tcpip->name );
+		stats->in_delivers++;
+		return tcpip->rx ( iobuf, netdev, st_src, st_dest,
+				   pshdr_csum );
 	}
 
 	DBG ( "Unrecognised TCP/IP protocol %d\n", tcpip_proto );
@@ -66,11 +108,20 @@ int tcpip_rx ( struct io_buffer *iobuf, struct net_device *netdev,
  * @ret tcpip_net	TCP/IP network-layer protocol, or NULL if not found
  */
 struct tcpip_net_protocol * tcpip_net_protocol ( sa_family_t sa_family ) {
+	static struct tcpip_net_protocol *cache;
 	struct tcpip_net_protocol *tcpip_net;
 
+	/* Try the most recently used protocol first (as above) */
+	tcpip_net = cache;
+	if ( tcpip_net && ( tcpip_net->sa_family == sa_family ) )
+		return tcpip_net;
+
+	/* Scan through the compiled-in protocols */
 	for_each_table_entry ( tcpip_net, TCPIP_NET_PROTOCOLS ) {
-		if ( tcpip_net->sa_family == sa_family )
+		if ( tcpip_net->sa_family == sa_family ) {
+			cache = tcpip_net;
 			return tcpip_net;
+		}
 	}
 
 	DBG ( "Unrecognised TCP/IP address family %d\n", sa_family );
@@ -132,6 +183,7 @@ size_t tcpip_mtu ( struct sockaddr_tcpip *st_dest ) {
 	struct tcpip_net_protocol *tcpip_net;
 	struct net_device *netdev;
 	size_t mtu;
+	size_t pmtu;
 
 	/* Find appropriate network-layer protocol */
 	tcpip_net = tcpip_net_protocol ( st_dest->st_family );
@@ -143,8 +195,15 @@ size_t tcpip_mtu ( struct sockaddr_tcpip *st_dest ) {
 	if ( ! netdev )
 		return 0;
 
+	/* Clamp to discovered path MTU, if any */
+	mtu = netdev->mtu;
+	if ( tcpip_net->pmtu && ( pmtu = tcpip_net->pmtu ( st_dest ) ) &&
+	     ( pmtu < mtu ) ) {
+		mtu = pmtu;
+	}
+
 	/* Calculate MTU */
-	mtu = ( netdev->mtu - tcpip_net->header_len );
+	mtu -= tcpip_net->header_len;
 
 	return mtu;
 }
@@ -169,25 +228,69 @@ size_t tcpip_mtu ( struct sockaddr_tcpip *st_dest ) {
  */
 uint16_t generic_tcpip_continue_chksum ( uint16_t partial,
 					 const void *data, size_t len ) {
-	unsigned int cksum = ( ( ~partial ) & 0xffff );
-	unsigned int value;
-	unsigned int i;
-	
-	for ( i = 0 ; i < len ; i++ ) {
-		value = * ( ( uint8_t * ) data + i );
-		if ( i & 1 ) {
-			/* Odd bytes: swap on little-endian systems */
-			value = be16_to_cpu ( value );
-		} else {
-			/* Even bytes: swap on big-endian systems */
-			value = le16_to_cpu ( value );
-		}
-		cksum += value;
-		if ( cksum > 0xffff )
-			cksum -= 0xffff;
+	unsigned long sum = ( ( ~partial ) & 0xffff );
+	const uint8_t *bytes = data;
+	const unsigned long *words;
+	unsigned long value;
+	union {
+		uint8_t byte[2];
+		uint16_t half;
+	} trailing;
+
+	/* Sum 16-bit words until aligned to a native machine word.
+	 * One's complement addition is order-independent, and summing
+	 * native-endian words followed by a fold yields the same
+	 * 16-bit result (in network byte order) on both endiannesses,
+	 * so no per-word byte swapping is required.
+	 */
+	while ( ( ( ( intptr_t ) bytes ) & ( sizeof ( *words ) - 1 ) ) &&
+		( len >= sizeof ( uint16_t ) ) ) {
+		value = *( ( const uint16_t * ) bytes );
+		sum += value;
+		if ( sum < value )
+			sum++;
+		bytes += sizeof ( uint16_t );
+		len -= sizeof ( uint16_t );
+	}
+
+	/* Sum whole native machine words (32-bit or 64-bit at a
+	 * time), with end-around carry
+	 */
+	words = ( ( const unsigned long * ) bytes );
+	while ( len >= sizeof ( *words ) ) {
+		value = *(words++);
+		sum += value;
+		if ( sum < value )
+			sum++;
+		len -= sizeof ( *words );
+	}
+	bytes = ( ( const uint8_t * ) words );
+
+	/* Sum remaining whole 16-bit words */
+	while ( len >= sizeof ( uint16_t ) ) {
+		value = *( ( const uint16_t * ) bytes );
+		sum += value;
+		if ( sum < value )
+			sum++;
+		bytes += sizeof ( uint16_t );
+		len -= sizeof ( uint16_t );
+	}
+
+	/* Sum trailing byte, if any, padded to a 16-bit word */
+	if ( len ) {
+		trailing.byte[0] = *bytes;
+		trailing.byte[1] = 0;
+		value = trailing.half;
+		sum += value;
+		if ( sum < value )
+			sum++;
 	}
-	
-	return ( ~cksum );
+
+	/* Fold down to a 16-bit checksum */
+	while ( ( value = ( sum >> 16 ) ) )
+		sum = ( ( sum & 0xffff ) + value );
+
+	return ( ~sum & 0xffff );
 }
 
 /**
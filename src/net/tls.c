@@ -48,6 +48,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/rbg.h>
 #include <ipxe/validator.h>
 #include <ipxe/job.h>
+#include <ipxe/boottrace.h>
 #include <ipxe/tls.h>
 
 /* Disambiguate the various error causes */
@@ -107,6 +108,14 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #define EINFO_EINVAL_TICKET						\
 	__einfo_uniqify ( EINFO_EINVAL, 0x0e,				\
 			  "Invalid New Session Ticket record")
+#define EINVAL_AUTH __einfo_error ( EINFO_EINVAL_AUTH )
+#define EINFO_EINVAL_AUTH						\
+	__einfo_uniqify ( EINFO_EINVAL, 0x0f,				\
+			  "Invalid authenticated record" )
+#define EINVAL_CERT_STATUS __einfo_error ( EINFO_EINVAL_CERT_STATUS )
+#define EINFO_EINVAL_CERT_STATUS					\
+	__einfo_uniqify ( EINFO_EINVAL, 0x10,				\
+			  "Invalid Certificate Status record" )
 #define EIO_ALERT __einfo_error ( EINFO_EIO_ALERT )
 #define EINFO_EIO_ALERT							\
 	__einfo_uniqify ( EINFO_EIO, 0x01,				\
@@ -139,6 +148,10 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #define EINFO_ENOMEM_RX_CONCAT						\
 	__einfo_uniqify ( EINFO_ENOMEM, 0x08,				\
 			  "Not enough space to concatenate received data" )
+#define ENOMEM_TX_CONCAT __einfo_error ( EINFO_ENOMEM_TX_CONCAT )
+#define EINFO_ENOMEM_TX_CONCAT						\
+	__einfo_uniqify ( EINFO_ENOMEM, 0x09,				\
+			  "Not enough space to concatenate corked data" )
 #define ENOTSUP_CIPHER __einfo_error ( EINFO_ENOTSUP_CIPHER )
 #define EINFO_ENOTSUP_CIPHER						\
 	__einfo_uniqify ( EINFO_ENOTSUP, 0x01,				\
@@ -352,6 +365,7 @@ static void free_tls ( struct refcnt *refcnt ) {
 
 	/* Free dynamically-allocated resources */
 	free ( tls->new_session_ticket );
+	free ( tls->ocsp );
 	tls_clear_cipher ( tls, &tls->tx_cipherspec );
 	tls_clear_cipher ( tls, &tls->tx_cipherspec_pending );
 	tls_clear_cipher ( tls, &tls->rx_cipherspec );
@@ -360,6 +374,14 @@ static void free_tls ( struct refcnt *refcnt ) {
 		list_del ( &iobuf->list );
 		free_iob ( iobuf );
 	}
+	list_for_each_entry_safe ( iobuf, tmp, &tls->rx_plaintext, list ) {
+		list_del ( &iobuf->list );
+		free_iob ( iobuf );
+	}
+	list_for_each_entry_safe ( iobuf, tmp, &tls->tx_data, list ) {
+		list_del ( &iobuf->list );
+		free_iob ( iobuf );
+	}
 	x509_put ( tls->cert );
 	x509_chain_put ( tls->chain );
 
@@ -633,9 +655,9 @@ static void tls_generate_master_secret ( struct tls_connection *tls ) {
 static int tls_generate_keys ( struct tls_connection *tls ) {
 	struct tls_cipherspec *tx_cipherspec = &tls->tx_cipherspec_pending;
 	struct tls_cipherspec *rx_cipherspec = &tls->rx_cipherspec_pending;
-	size_t hash_size = tx_cipherspec->suite->digest->digestsize;
+	size_t hash_size = tx_cipherspec->suite->mac_len;
 	size_t key_size = tx_cipherspec->suite->key_len;
-	size_t iv_size = tx_cipherspec->suite->cipher->blocksize;
+	size_t iv_size = tx_cipherspec->suite->fixed_iv_len;
 	size_t total = ( 2 * ( hash_size + key_size + iv_size ) );
 	uint8_t key_block[total];
 	uint8_t *key;
@@ -651,13 +673,17 @@ static int tls_generate_keys ( struct tls_connection *tls ) {
 	key = key_block;
 
 	/* TX MAC secret */
-	memcpy ( tx_cipherspec->mac_secret, key, hash_size );
+	hmac_precompute ( tx_cipherspec->suite->digest, key, hash_size,
+			  tx_cipherspec->hmac_ipad_ctx,
+			  tx_cipherspec->hmac_opad_ctx );
 	DBGC ( tls, "TLS %p TX MAC secret:\n", tls );
 	DBGC_HD ( tls, key, hash_size );
 	key += hash_size;
 
 	/* RX MAC secret */
-	memcpy ( rx_cipherspec->mac_secret, key, hash_size );
+	hmac_precompute ( rx_cipherspec->suite->digest, key, hash_size,
+			  rx_cipherspec->hmac_ipad_ctx,
+			  rx_cipherspec->hmac_opad_ctx );
 	DBGC ( tls, "TLS %p RX MAC secret:\n", tls );
 	DBGC_HD ( tls, key, hash_size );
 	key += hash_size;
@@ -687,15 +713,17 @@ static int tls_generate_keys ( struct tls_connection *tls ) {
 	key += key_size;
 
 	/* TX initialisation vector */
+	memcpy ( tx_cipherspec->fixed_iv, key, iv_size );
 	cipher_setiv ( tx_cipherspec->suite->cipher,
-		       tx_cipherspec->cipher_ctx, key );
+		       tx_cipherspec->cipher_ctx, key, iv_size );
 	DBGC ( tls, "TLS %p TX IV:\n", tls );
 	DBGC_HD ( tls, key, iv_size );
 	key += iv_size;
 
 	/* RX initialisation vector */
+	memcpy ( rx_cipherspec->fixed_iv, key, iv_size );
 	cipher_setiv ( rx_cipherspec->suite->cipher,
-		       rx_cipherspec->cipher_ctx, key );
+		       rx_cipherspec->cipher_ctx, key, iv_size );
 	DBGC ( tls, "TLS %p RX IV:\n", tls );
 	DBGC_HD ( tls, key, iv_size );
 	key += iv_size;
@@ -777,9 +805,10 @@ static int tls_set_cipher ( struct tls_connection *tls,
 
 	/* Clear out old cipher contents, if any */
 	tls_clear_cipher ( tls, cipherspec );
-	
+
 	/* Allocate dynamic storage */
-	total = ( pubkey->ctxsize + 2 * cipher->ctxsize + digest->digestsize );
+	total = ( pubkey->ctxsize + 2 * cipher->ctxsize + 2 * digest->ctxsize +
+		  suite->fixed_iv_len );
 	dynamic = zalloc ( total );
 	if ( ! dynamic ) {
 		DBGC ( tls, "TLS %p could not allocate %zd bytes for crypto "
@@ -792,7 +821,9 @@ static int tls_set_cipher ( struct tls_connection *tls,
 	cipherspec->pubkey_ctx = dynamic;	dynamic += pubkey->ctxsize;
 	cipherspec->cipher_ctx = dynamic;	dynamic += cipher->ctxsize;
 	cipherspec->cipher_next_ctx = dynamic;	dynamic += cipher->ctxsize;
-	cipherspec->mac_secret = dynamic;	dynamic += digest->digestsize;
+	cipherspec->hmac_ipad_ctx = dynamic;	dynamic += digest->ctxsize;
+	cipherspec->hmac_opad_ctx = dynamic;	dynamic += digest->ctxsize;
+	cipherspec->fixed_iv = dynamic;		dynamic += suite->fixed_iv_len;
 	assert ( ( cipherspec->dynamic + total ) == dynamic );
 
 	/* Store parameters */
@@ -983,8 +1014,10 @@ static void tls_restart ( struct tls_connection *tls ) {
 	/* (Re)start negotiation */
 	tls->tx_pending = TLS_TX_CLIENT_HELLO;
 	tls_tx_resume ( tls );
-	pending_get ( &tls->client_negotiation );
-	pending_get ( &tls->server_negotiation );
+	pending_get ( &tls->client_negotiation,
+		      "TLS client negotiation" );
+	pending_get ( &tls->server_negotiation,
+		      "TLS server negotiation" );
 }
 
 /**
@@ -1060,6 +1093,13 @@ static int tls_send_client_hello ( struct tls_connection *tls ) {
 			struct {
 				uint8_t data[session->ticket_len];
 			} __attribute__ (( packed )) session_ticket;
+			uint16_t status_request_type;
+			uint16_t status_request_len;
+			struct {
+				uint8_t type;
+				uint16_t responder_id_list_len;
+				uint16_t request_extensions_len;
+			} __attribute__ (( packed )) status_request;
 		} __attribute__ (( packed )) extensions;
 	} __attribute__ (( packed )) hello;
 	struct tls_cipher_suite *suite;
@@ -1118,6 +1158,10 @@ static int tls_send_client_hello ( struct tls_connection *tls ) {
 		= htons ( sizeof ( hello.extensions.session_ticket ) );
 	memcpy ( hello.extensions.session_ticket.data, session->ticket,
 		 sizeof ( hello.extensions.session_ticket.data ) );
+	hello.extensions.status_request_type = htons ( TLS_STATUS_REQUEST );
+	hello.extensions.status_request_len
+		= htons ( sizeof ( hello.extensions.status_request ) );
+	hello.extensions.status_request.type = TLS_CERTIFICATE_STATUS_TYPE_OCSP;
 
 	return tls_send_handshake ( tls, &hello, sizeof ( hello ) );
 }
@@ -1406,6 +1450,10 @@ static int tls_new_alert ( struct tls_connection *tls, const void *data,
 		return -EINVAL_ALERT;
 	}
 
+	/* Record alert in boot trace ring, if enabled */
+	tracepoint ( 1, "TLS %s alert %d/%d", tls->session->name,
+		     alert->level, alert->description );
+
 	switch ( alert->level ) {
 	case TLS_ALERT_WARNING:
 		DBGC ( tls, "TLS %p received warning alert %d\n",
@@ -1816,6 +1864,59 @@ static int tls_new_certificate ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Receive new Certificate Status handshake record
+ *
+ * @v tls		TLS connection
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @ret rc		Return status code
+ */
+static int tls_new_certificate_status ( struct tls_connection *tls,
+					const void *data, size_t len ) {
+	const struct {
+		uint8_t type;
+		tls24_t length;
+		uint8_t response[0];
+	} __attribute__ (( packed )) *status = data;
+	size_t response_len;
+
+	/* Parse header */
+	if ( sizeof ( *status ) > len ) {
+		DBGC ( tls, "TLS %p received underlength Certificate "
+		       "Status\n", tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_CERT_STATUS;
+	}
+	response_len = tls_uint24 ( &status->length );
+	if ( response_len > ( len - sizeof ( *status ) ) ) {
+		DBGC ( tls, "TLS %p received overlength Certificate Status\n",
+		       tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_CERT_STATUS;
+	}
+
+	/* Ignore status types other than OCSP */
+	if ( status->type != TLS_CERTIFICATE_STATUS_TYPE_OCSP ) {
+		DBGC ( tls, "TLS %p ignoring certificate status type %d\n",
+		       tls, status->type );
+		return 0;
+	}
+
+	/* Record stapled OCSP response for use during validation */
+	free ( tls->ocsp );
+	tls->ocsp = malloc ( response_len );
+	if ( ! tls->ocsp ) {
+		tls->ocsp_len = 0;
+		return -ENOMEM;
+	}
+	memcpy ( tls->ocsp, status->response, response_len );
+	tls->ocsp_len = response_len;
+	DBGC ( tls, "TLS %p received stapled OCSP response\n", tls );
+
+	return 0;
+}
+
 /**
  * Receive new Certificate Request handshake record
  *
@@ -1873,12 +1974,13 @@ static int tls_new_server_hello_done ( struct tls_connection *tls,
 	}
 
 	/* Begin certificate validation */
-	if ( ( rc = create_validator ( &tls->validator, tls->chain ) ) != 0 ) {
+	if ( ( rc = create_validator ( &tls->validator, tls->chain,
+				       tls->ocsp, tls->ocsp_len ) ) != 0 ) {
 		DBGC ( tls, "TLS %p could not start certificate validation: "
 		       "%s\n", tls, strerror ( rc ) );
 		return rc;
 	}
-	pending_get ( &tls->validation );
+	pending_get ( &tls->validation, "TLS certificate validation" );
 
 	return 0;
 }
@@ -1922,6 +2024,9 @@ static int tls_new_finished ( struct tls_connection *tls,
 	/* Mark server as finished */
 	pending_put ( &tls->server_negotiation );
 
+	/* Record boot trace marker */
+	boottrace ( "TLS %s done", session->name );
+
 	/* If we are resuming a session (i.e. if the server Finished
 	 * arrives before the client Finished is sent), then schedule
 	 * transmission of Change Cipher and Finished.
@@ -2017,6 +2122,10 @@ static int tls_new_handshake ( struct tls_connection *tls,
 		case TLS_CERTIFICATE:
 			rc = tls_new_certificate ( tls, payload, payload_len );
 			break;
+		case TLS_CERTIFICATE_STATUS:
+			rc = tls_new_certificate_status ( tls, payload,
+							  payload_len );
+			break;
 		case TLS_CERTIFICATE_REQUEST:
 			rc = tls_new_certificate_request ( tls, payload,
 							   payload_len );
@@ -2053,6 +2162,54 @@ static int tls_new_handshake ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Deliver pending plaintext data
+ *
+ * @v tls		TLS connection
+ * @ret rc		Return status code
+ *
+ * Consecutive small data records are coalesced into a single I/O
+ * buffer before delivery, to avoid incurring the per-delivery
+ * overhead of the receiving data-transfer interface (e.g. the HTTP
+ * content decoders) for every individual small record.
+ */
+static int tls_deliver_plaintext ( struct tls_connection *tls ) {
+	struct io_buffer *iobuf;
+	size_t len = 0;
+	int rc;
+
+	/* Do nothing if no plaintext is pending delivery */
+	if ( list_empty ( &tls->rx_plaintext ) )
+		return 0;
+
+	/* Coalesce into a single I/O buffer if the total length is
+	 * small enough that the copy is cheaper than the overhead of
+	 * multiple deliveries.
+	 */
+	list_for_each_entry ( iobuf, &tls->rx_plaintext, list )
+		len += iob_len ( iobuf );
+	if ( len <= TLS_RX_BUFSIZE ) {
+		iobuf = iob_concatenate ( &tls->rx_plaintext );
+		if ( ! iobuf )
+			return -ENOMEM_RX_CONCAT;
+		list_add ( &iobuf->list, &tls->rx_plaintext );
+	}
+
+	/* Deliver each I/O buffer in turn */
+	while ( ( iobuf = list_first_entry ( &tls->rx_plaintext,
+					     struct io_buffer, list ) ) ) {
+		list_del ( &iobuf->list );
+		if ( ( rc = xfer_deliver_iob ( &tls->plainstream,
+					       iobuf ) ) != 0 ) {
+			DBGC ( tls, "TLS %p could not deliver data: %s\n",
+			       tls, strerror ( rc ) );
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
 /**
  * Receive new record
  *
@@ -2068,27 +2225,27 @@ static int tls_new_record ( struct tls_connection *tls, unsigned int type,
 			    size_t len );
 	int rc;
 
-	/* Deliver data records to the plainstream interface */
+	/* Queue data records for (possibly coalesced) delivery to the
+	 * plainstream interface.
+	 */
 	if ( type == TLS_TYPE_DATA ) {
 
 		/* Fail unless we are ready to receive data */
 		if ( ! tls_ready ( tls ) )
 			return -ENOTCONN;
 
-		/* Deliver each I/O buffer in turn */
-		while ( ( iobuf = list_first_entry ( rx_data, struct io_buffer,
-						     list ) ) ) {
-			list_del ( &iobuf->list );
-			if ( ( rc = xfer_deliver_iob ( &tls->plainstream,
-						       iobuf ) ) != 0 ) {
-				DBGC ( tls, "TLS %p could not deliver data: "
-				       "%s\n", tls, strerror ( rc ) );
-				return rc;
-			}
-		}
+		/* Queue for delivery */
+		list_splice_tail_init ( rx_data, &tls->rx_plaintext );
 		return 0;
 	}
 
+	/* Deliver any pending plaintext before processing a non-data
+	 * record, to preserve ordering (e.g. with respect to a
+	 * close_notify alert).
+	 */
+	if ( ( rc = tls_deliver_plaintext ( tls ) ) != 0 )
+		return rc;
+
 	/* For all other records, merge into a single I/O buffer */
 	iobuf = iob_concatenate ( rx_data );
 	if ( ! iobuf ) {
@@ -2142,7 +2299,7 @@ static void tls_hmac_init ( struct tls_cipherspec *cipherspec, void *ctx,
 			    uint64_t seq, struct tls_header *tlshdr ) {
 	struct digest_algorithm *digest = cipherspec->suite->digest;
 
-	hmac_init ( digest, ctx, cipherspec->mac_secret, &digest->digestsize );
+	hmac_resume ( digest, ctx, cipherspec->hmac_ipad_ctx );
 	seq = cpu_to_be64 ( seq );
 	hmac_update ( digest, ctx, &seq, sizeof ( seq ) );
 	hmac_update ( digest, ctx, tlshdr, sizeof ( *tlshdr ) );
@@ -2174,8 +2331,8 @@ static void tls_hmac_final ( struct tls_cipherspec *cipherspec, void *ctx,
 			     void *hmac ) {
 	struct digest_algorithm *digest = cipherspec->suite->digest;
 
-	hmac_final ( digest, ctx, cipherspec->mac_secret,
-		     &digest->digestsize, hmac );
+	hmac_final_precomputed ( digest, ctx, cipherspec->hmac_opad_ctx,
+				 hmac );
 }
 
 /**
@@ -2282,6 +2439,93 @@ static void * tls_assemble_block ( struct tls_connection *tls,
 	return plaintext;
 }
 
+/**
+ * Send plaintext record via authenticating cipher
+ *
+ * @v tls		TLS connection
+ * @v type		Record type
+ * @v data		Plaintext record
+ * @v len		Length of plaintext record
+ * @ret rc		Return status code
+ *
+ * Authenticating (AEAD) ciphers encrypt and authenticate in a single
+ * pass over the data, and so do not require a separately assembled
+ * plaintext structure or an HMAC calculation.
+ */
+static int tls_send_auth ( struct tls_connection *tls, unsigned int type,
+			   const void *data, size_t len ) {
+	struct tls_cipherspec *cipherspec = &tls->tx_cipherspec;
+	struct tls_cipher_suite *suite = cipherspec->suite;
+	struct cipher_algorithm *cipher = suite->cipher;
+	struct tls_auth_header authhdr;
+	struct tls_header *tlshdr;
+	struct io_buffer *ciphertext;
+	size_t ciphertext_len;
+	uint8_t iv[ suite->fixed_iv_len + suite->record_iv_len ];
+	int rc;
+
+	/* Construct authentication header */
+	authhdr.seq = cpu_to_be64 ( tls->tx_seq );
+	authhdr.header.type = type;
+	authhdr.header.version = htons ( tls->version );
+	authhdr.header.length = htons ( len );
+
+	/* Construct initialisation vector, using the sequence number
+	 * as the per-record component.
+	 */
+	memcpy ( iv, cipherspec->fixed_iv, suite->fixed_iv_len );
+	memcpy ( ( iv + suite->fixed_iv_len ), &authhdr.seq,
+		 suite->record_iv_len );
+
+	/* Allocate ciphertext */
+	ciphertext_len = ( sizeof ( *tlshdr ) + suite->record_iv_len + len +
+			   cipher->authsize );
+	ciphertext = xfer_alloc_iob ( &tls->cipherstream, ciphertext_len );
+	if ( ! ciphertext ) {
+		DBGC ( tls, "TLS %p could not allocate %zd bytes for "
+		       "ciphertext\n", tls, ciphertext_len );
+		rc = -ENOMEM_TX_CIPHERTEXT;
+		goto done;
+	}
+
+	/* Assemble ciphertext */
+	tlshdr = iob_put ( ciphertext, sizeof ( *tlshdr ) );
+	tlshdr->type = type;
+	tlshdr->version = htons ( tls->version );
+	tlshdr->length = htons ( ciphertext_len - sizeof ( *tlshdr ) );
+	memcpy ( iob_put ( ciphertext, suite->record_iv_len ), &authhdr.seq,
+		 suite->record_iv_len );
+
+	/* Encrypt and authenticate in a single pass */
+	memcpy ( cipherspec->cipher_next_ctx, cipherspec->cipher_ctx,
+		 cipher->ctxsize );
+	cipher_setiv ( cipher, cipherspec->cipher_next_ctx, iv,
+		       sizeof ( iv ) );
+	cipher_encrypt ( cipher, cipherspec->cipher_next_ctx, &authhdr, NULL,
+			 sizeof ( authhdr ) );
+	cipher_encrypt ( cipher, cipherspec->cipher_next_ctx, data,
+			 iob_put ( ciphertext, len ), len );
+	cipher_auth ( cipher, cipherspec->cipher_next_ctx,
+		      iob_put ( ciphertext, cipher->authsize ) );
+
+	/* Send ciphertext */
+	if ( ( rc = xfer_deliver_iob ( &tls->cipherstream,
+				       iob_disown ( ciphertext ) ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not deliver ciphertext: %s\n",
+		       tls, strerror ( rc ) );
+		goto done;
+	}
+
+	/* Update TX state machine to next record */
+	tls->tx_seq += 1;
+	memcpy ( cipherspec->cipher_ctx, cipherspec->cipher_next_ctx,
+		 cipher->ctxsize );
+
+ done:
+	free_iob ( ciphertext );
+	return rc;
+}
+
 /**
  * Send plaintext record
  *
@@ -2305,6 +2549,10 @@ static int tls_send_plaintext ( struct tls_connection *tls, unsigned int type,
 	uint8_t mac[mac_len];
 	int rc;
 
+	/* Authenticating ciphers use a dedicated single-pass path */
+	if ( is_auth_cipher ( cipher ) )
+		return tls_send_auth ( tls, type, data, len );
+
 	/* Construct header */
 	plaintext_tlshdr.type = type;
 	plaintext_tlshdr.version = htons ( tls->version );
@@ -2459,6 +2707,94 @@ static int tls_split_block ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Receive new ciphertext record via authenticating cipher
+ *
+ * @v tls		TLS connection
+ * @v tlshdr		Record header
+ * @v rx_data		List of received data buffers
+ * @ret rc		Return status code
+ *
+ * Authenticating (AEAD) ciphers decrypt and verify in a single pass
+ * over the data, using the cipher's authentication tag in place of an
+ * HMAC.
+ */
+static int tls_new_auth_ciphertext ( struct tls_connection *tls,
+				     struct tls_header *tlshdr,
+				     struct list_head *rx_data ) {
+	struct tls_cipherspec *cipherspec = &tls->rx_cipherspec;
+	struct tls_cipher_suite *suite = cipherspec->suite;
+	struct cipher_algorithm *cipher = suite->cipher;
+	struct tls_auth_header authhdr;
+	struct io_buffer *iobuf;
+	uint8_t iv[ suite->fixed_iv_len + suite->record_iv_len ];
+	uint8_t verify_auth[cipher->authsize];
+	void *auth;
+	size_t len = 0;
+	int rc;
+
+	/* Extract per-record initialisation vector */
+	iobuf = list_first_entry ( rx_data, struct io_buffer, list );
+	assert ( iobuf != NULL );
+	if ( iob_len ( iobuf ) < suite->record_iv_len ) {
+		DBGC ( tls, "TLS %p received underlength IV\n", tls );
+		DBGC_HD ( tls, iobuf->data, iob_len ( iobuf ) );
+		return -EINVAL_AUTH;
+	}
+	memcpy ( iv, cipherspec->fixed_iv, suite->fixed_iv_len );
+	memcpy ( ( iv + suite->fixed_iv_len ), iobuf->data,
+		 suite->record_iv_len );
+	iob_pull ( iobuf, suite->record_iv_len );
+
+	/* Extract authentication tag */
+	iobuf = list_last_entry ( rx_data, struct io_buffer, list );
+	assert ( iobuf != NULL );
+	if ( iob_len ( iobuf ) < cipher->authsize ) {
+		DBGC ( tls, "TLS %p received underlength authentication tag\n",
+		       tls );
+		DBGC_HD ( tls, iobuf->data, iob_len ( iobuf ) );
+		return -EINVAL_AUTH;
+	}
+	iob_unput ( iobuf, cipher->authsize );
+	auth = iobuf->tail;
+
+	/* Calculate plaintext length */
+	list_for_each_entry ( iobuf, rx_data, list )
+		len += iob_len ( iobuf );
+
+	/* Construct authentication header */
+	authhdr.seq = cpu_to_be64 ( tls->rx_seq );
+	authhdr.header.type = tlshdr->type;
+	authhdr.header.version = tlshdr->version;
+	authhdr.header.length = htons ( len );
+
+	/* Decrypt and authenticate in a single pass */
+	cipher_setiv ( cipher, cipherspec->cipher_ctx, iv, sizeof ( iv ) );
+	cipher_decrypt ( cipher, cipherspec->cipher_ctx, &authhdr, NULL,
+			 sizeof ( authhdr ) );
+	list_for_each_entry ( iobuf, rx_data, list ) {
+		cipher_decrypt ( cipher, cipherspec->cipher_ctx,
+				 iobuf->data, iobuf->data, iob_len ( iobuf ) );
+	}
+
+	/* Verify authentication tag */
+	cipher_auth ( cipher, cipherspec->cipher_ctx, verify_auth );
+	if ( memcmp ( auth, verify_auth, sizeof ( verify_auth ) ) != 0 ) {
+		DBGC ( tls, "TLS %p failed authentication tag verification\n",
+		       tls );
+		return -EINVAL_MAC;
+	}
+	DBGC2 ( tls, "Received plaintext data:\n" );
+	list_for_each_entry ( iobuf, rx_data, list )
+		DBGC2_HD ( tls, iobuf->data, iob_len ( iobuf ) );
+
+	/* Process plaintext record */
+	if ( ( rc = tls_new_record ( tls, tlshdr->type, rx_data ) ) != 0 )
+		return rc;
+
+	return 0;
+}
+
 /**
  * Receive new ciphertext record
  *
@@ -2481,6 +2817,10 @@ static int tls_new_ciphertext ( struct tls_connection *tls,
 	size_t len = 0;
 	int rc;
 
+	/* Authenticating ciphers use a dedicated single-pass path */
+	if ( is_auth_cipher ( cipher ) )
+		return tls_new_auth_ciphertext ( tls, tlshdr, rx_data );
+
 	/* Decrypt the received data */
 	list_for_each_entry ( iobuf, &tls->rx_data, list ) {
 		cipher_decrypt ( cipher, cipherspec->cipher_ctx,
@@ -2547,6 +2887,48 @@ static size_t tls_plainstream_window ( struct tls_connection *tls ) {
 	return xfer_window ( &tls->cipherstream );
 }
 
+/**
+ * Send corked plaintext data
+ *
+ * @v tls		TLS connection
+ * @ret rc		Return status code
+ *
+ * Corked data is sent as the minimal number of records, so that
+ * consecutive small deliveries (such as HTTP request headers) share a
+ * single record's MAC/padding/IV overhead and TCP segment.
+ */
+static int tls_send_data ( struct tls_connection *tls ) {
+	struct io_buffer *iobuf;
+	size_t len;
+	int rc;
+
+	/* Do nothing if no data is corked */
+	if ( list_empty ( &tls->tx_data ) )
+		return 0;
+
+	/* Merge corked data into a single I/O buffer.  When only a
+	 * single buffer is corked, this avoids any copy.
+	 */
+	iobuf = iob_concatenate ( &tls->tx_data );
+	if ( ! iobuf )
+		return -ENOMEM_TX_CONCAT;
+
+	/* Send data, split into records as needed */
+	while ( ( len = iob_len ( iobuf ) ) ) {
+		if ( len > TLS_TX_RECORD_LEN )
+			len = TLS_TX_RECORD_LEN;
+		if ( ( rc = tls_send_plaintext ( tls, TLS_TYPE_DATA,
+						 iobuf->data, len ) ) != 0 ) {
+			free_iob ( iobuf );
+			return rc;
+		}
+		iob_pull ( iobuf, len );
+	}
+	free_iob ( iobuf );
+
+	return 0;
+}
+
 /**
  * Deliver datagram as raw data
  *
@@ -2558,21 +2940,22 @@ static size_t tls_plainstream_window ( struct tls_connection *tls ) {
 static int tls_plainstream_deliver ( struct tls_connection *tls,
 				     struct io_buffer *iobuf,
 				     struct xfer_metadata *meta __unused ) {
-	int rc;
-	
+
 	/* Refuse unless we are ready to accept data */
 	if ( ! tls_ready ( tls ) ) {
-		rc = -ENOTCONN;
-		goto done;
+		free_iob ( iobuf );
+		return -ENOTCONN;
 	}
 
-	if ( ( rc = tls_send_plaintext ( tls, TLS_TYPE_DATA, iobuf->data,
-					 iob_len ( iobuf ) ) ) != 0 )
-		goto done;
+	/* Cork data for transmission by the TX state machine, so that
+	 * all deliveries made before the process next runs are
+	 * coalesced into the minimal number of records.
+	 */
+	list_add_tail ( &iobuf->list, &tls->tx_data );
+	tls->tx_pending |= TLS_TX_DATA;
+	tls_tx_resume ( tls );
 
- done:
-	free_iob ( iobuf );
-	return rc;
+	return 0;
 }
 
 /**
@@ -2782,6 +3165,14 @@ static int tls_cipherstream_deliver ( struct tls_connection *tls,
 			}
 		}
 	}
+
+	/* Deliver any pending plaintext, now that all records from
+	 * this delivery have been processed.
+	 */
+	if ( ( rc = tls_deliver_plaintext ( tls ) ) != 0 ) {
+		tls_close ( tls, rc );
+		goto done;
+	}
 	rc = 0;
 
  done:
@@ -2988,6 +3379,14 @@ static void tls_tx_step ( struct tls_connection *tls ) {
 			goto err;
 		}
 		tls->tx_pending &= ~TLS_TX_FINISHED;
+	} else if ( tls->tx_pending & TLS_TX_DATA ) {
+		/* Send corked plaintext data */
+		if ( ( rc = tls_send_data ( tls ) ) != 0 ) {
+			DBGC ( tls, "TLS %p could not send data: %s\n",
+			       tls, strerror ( rc ) );
+			goto err;
+		}
+		tls->tx_pending &= ~TLS_TX_DATA;
 	}
 
 	/* Reschedule process if pending transmissions remain,
@@ -3098,6 +3497,8 @@ int add_tls ( struct interface *xfer, const char *name,
 	iob_populate ( &tls->rx_header_iobuf, &tls->rx_header, 0,
 		       sizeof ( tls->rx_header ) );
 	INIT_LIST_HEAD ( &tls->rx_data );
+	INIT_LIST_HEAD ( &tls->rx_plaintext );
+	INIT_LIST_HEAD ( &tls->tx_data );
 	if ( ( rc = tls_generate_random ( tls, &tls->client_random.random,
 			  ( sizeof ( tls->client_random.random ) ) ) ) != 0 ) {
 		goto err_random;
@@ -29,6 +29,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ctype.h>
 #include <errno.h>
 #include <assert.h>
+#include <time.h>
 #include <byteswap.h>
 #include <ipxe/if_ether.h>
 #include <ipxe/iobuf.h>
@@ -47,6 +48,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/dhcpopts.h>
 #include <ipxe/dhcppkt.h>
 #include <ipxe/dhcp_arch.h>
+#include <ipxe/boottrace.h>
 #include <ipxe/features.h>
 #include <config/dhcp.h>
 
@@ -122,6 +124,9 @@ const struct setting dhcp_server_setting __setting ( SETTING_MISC,
  */
 uint32_t dhcp_last_xid;
 
+/** List of active DHCP sessions */
+static LIST_HEAD ( dhcp_sessions );
+
 /**
  * Name a DHCP packet type
  *
@@ -199,6 +204,8 @@ static struct dhcp_session_state dhcp_state_pxebs;
 struct dhcp_session {
 	/** Reference counter */
 	struct refcnt refcnt;
+	/** List of active DHCP sessions */
+	struct list_head list;
 	/** Job control interface */
 	struct interface job;
 	/** Data transfer interface */
@@ -219,6 +226,10 @@ struct dhcp_session {
 	struct in_addr server;
 	/** DHCP offer priority */
 	int priority;
+	/** DHCP offer contains PXE boot parameters */
+	int pxeopts;
+	/** Attempting to reclaim a cached lease */
+	int reclaim;
 
 	/** ProxyDHCP protocol extensions should be ignored */
 	int no_pxedhcp;
@@ -242,6 +253,8 @@ struct dhcp_session {
 	unsigned int count;
 	/** Start time of the current state (in ticks) */
 	unsigned long start;
+	/** Discovery is deferred pending link-up */
+	int linkwait;
 };
 
 /**
@@ -266,6 +279,13 @@ static void dhcp_free ( struct refcnt *refcnt ) {
  */
 static void dhcp_finished ( struct dhcp_session *dhcp, int rc ) {
 
+	/* Record boot trace marker */
+	boottrace ( "DHCP %s %s", dhcp->netdev->name,
+		    ( rc ? "failed" : "done" ) );
+
+	/* Remove from list of active sessions */
+	list_del ( &dhcp->list );
+
 	/* Stop retry timer */
 	stop_timer ( &dhcp->timer );
 
@@ -316,6 +336,96 @@ static int dhcp_has_pxeopts ( struct dhcp_packet *dhcppkt ) {
 	return 0;
 }
 
+/****************************************************************************
+ *
+ * Cached lease hints
+ *
+ */
+
+/** A cached lease hint */
+struct dhcp_lease_hint {
+	/** Leased IP address */
+	struct in_addr address;
+	/** DHCP server */
+	struct in_addr server;
+	/** Expiry time (seconds since the Epoch) */
+	uint32_t expiry;
+} __attribute__ (( packed ));
+
+/** Cached lease hint setting */
+static const struct setting lastlease_setting __setting ( SETTING_MISC,
+							  lastlease ) = {
+	.name = "lastlease",
+	.description = "Cached DHCP lease",
+	.tag = DHCP_EB_LAST_LEASE,
+	.type = &setting_type_hex,
+};
+
+/**
+ * Attempt to reclaim a cached lease
+ *
+ * @v dhcp		DHCP session
+ *
+ * If a plausible and unexpired lease hint exists for this network
+ * device, the session will begin with an INIT-REBOOT request for the
+ * previous address (skipping discovery entirely), falling back to
+ * normal discovery if the request is refused or unanswered.
+ */
+static void dhcp_reclaim ( struct dhcp_session *dhcp ) {
+	struct dhcp_lease_hint hint;
+	int len;
+
+	/* Do nothing unless a plausible lease hint exists for this
+	 * network device.
+	 */
+	len = fetch_raw_setting ( netdev_settings ( dhcp->netdev ),
+				  &lastlease_setting, &hint,
+				  sizeof ( hint ) );
+	if ( len != ( ( int ) sizeof ( hint ) ) )
+		return;
+	if ( ( ! hint.address.s_addr ) || ( ! hint.server.s_addr ) )
+		return;
+
+	/* Do nothing if the lease has expired */
+	if ( ( ( uint32_t ) time ( NULL ) ) >= ntohl ( hint.expiry ) )
+		return;
+
+	/* Request the previous address directly */
+	dhcp->offer = hint.address;
+	dhcp->server = hint.server;
+	dhcp->reclaim = 1;
+	DBGC ( dhcp, "DHCP %p reclaiming lease for %s\n",
+	       dhcp, inet_ntoa ( hint.address ) );
+}
+
+/**
+ * Record lease hint for use by a subsequent session
+ *
+ * @v dhcp		DHCP session
+ * @v dhcppkt		DHCPACK packet
+ */
+static void dhcp_record_hint ( struct dhcp_session *dhcp,
+			       struct dhcp_packet *dhcppkt ) {
+	struct dhcp_lease_hint hint;
+	uint32_t lease_time;
+	int len;
+
+	/* Do nothing unless the lease duration is known */
+	len = dhcppkt_fetch ( dhcppkt, DHCP_LEASE_TIME, &lease_time,
+			      sizeof ( lease_time ) );
+	if ( len != ( ( int ) sizeof ( lease_time ) ) )
+		return;
+
+	/* Construct and store hint.  Failure to store is harmless,
+	 * since the hint is only an optimisation.
+	 */
+	hint.address = dhcp->local.sin_addr;
+	hint.server = dhcp->server;
+	hint.expiry = htonl ( time ( NULL ) + ntohl ( lease_time ) );
+	store_setting ( netdev_settings ( dhcp->netdev ), &lastlease_setting,
+			&hint, sizeof ( hint ) );
+}
+
 /****************************************************************************
  *
  * DHCP state machine
@@ -342,6 +452,30 @@ static int dhcp_discovery_tx ( struct dhcp_session *dhcp,
 	return 0;
 }
 
+/**
+ * Clamp retransmission timer to the ProxyDHCP timeout
+ *
+ * @v dhcp		DHCP session
+ *
+ * Once we hold a valid DHCPOFFER, the only reason to remain in the
+ * discovery state is to wait for the offer set to be completed by a
+ * ProxyDHCPOFFER.  Ensure that this wait ends exactly at the
+ * ProxyDHCP timeout, rather than at the first (exponentially backed
+ * off) retransmission after the timeout.
+ */
+static void dhcp_discovery_clamp ( struct dhcp_session *dhcp ) {
+	unsigned long deadline;
+	unsigned long remaining;
+
+	deadline = ( dhcp->start +
+		     ( DHCP_DISC_PROXY_TIMEOUT_SEC * TICKS_PER_SEC ) );
+	remaining = ( deadline - currticks() );
+	if ( ( ( signed long ) remaining < 0 ) )
+		remaining = 0;
+	if ( ( ( signed long ) ( dhcp->timer.expiry - deadline ) ) > 0 )
+		start_timer_fixed ( &dhcp->timer, remaining );
+}
+
 /**
  * Handle received packet during DHCP discovery
  *
@@ -410,6 +544,7 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 		dhcp->server = server_id;
 		dhcp->priority = priority;
 		dhcp->no_pxedhcp = no_pxedhcp;
+		dhcp->pxeopts = dhcp_has_pxeopts ( dhcppkt );
 	}
 
 	/* Select as ProxyDHCP offer, if applicable */
@@ -425,6 +560,7 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 	 * DHCPOFFER, and either:
 	 *
 	 *  o  The DHCPOFFER instructs us to ignore ProxyDHCPOFFERs, or
+	 *  o  The DHCPOFFER itself contains PXE boot parameters, or
 	 *  o  We have a valid ProxyDHCPOFFER, or
 	 *  o  We have allowed sufficient time for ProxyDHCPOFFERs.
 	 */
@@ -433,11 +569,15 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 	if ( ! dhcp->offer.s_addr )
 		return;
 
-	/* If we can't yet transition to DHCPREQUEST, do nothing */
+	/* If we can't yet transition to DHCPREQUEST, wait only as far
+	 * as the ProxyDHCP timeout for the offer set to be completed.
+	 */
 	elapsed = ( currticks() - dhcp->start );
-	if ( ! ( dhcp->no_pxedhcp || dhcp->proxy_offer ||
-		 ( elapsed > DHCP_DISC_PROXY_TIMEOUT_SEC * TICKS_PER_SEC ) ) )
+	if ( ! ( dhcp->no_pxedhcp || dhcp->pxeopts || dhcp->proxy_offer ||
+		 ( elapsed > DHCP_DISC_PROXY_TIMEOUT_SEC * TICKS_PER_SEC ) ) ) {
+		dhcp_discovery_clamp ( dhcp );
 		return;
+	}
 
 	/* Transition to DHCPREQUEST */
 	dhcp_set_state ( dhcp, &dhcp_state_request );
@@ -451,16 +591,23 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 static void dhcp_discovery_expired ( struct dhcp_session *dhcp ) {
 	unsigned long elapsed = ( currticks() - dhcp->start );
 
-	/* If link is blocked, defer DHCP discovery (and reset timeout) */
-	if ( netdev_link_blocked ( dhcp->netdev ) &&
+	/* If link is blocked or not yet up (e.g. while
+	 * autonegotiation is still in progress), defer DHCP
+	 * discovery (and reset timeout).  Discovery will be expedited
+	 * by dhcp_notify() as soon as the link comes up.
+	 */
+	if ( ( netdev_link_blocked ( dhcp->netdev ) ||
+	       ( ! netdev_link_ok ( dhcp->netdev ) ) ) &&
 	     ( dhcp->count <= DHCP_DISC_MAX_DEFERRALS ) ) {
 		DBGC ( dhcp, "DHCP %p deferring discovery\n", dhcp );
+		dhcp->linkwait = 1;
 		dhcp->start = currticks();
 		start_timer_fixed ( &dhcp->timer,
 				    ( DHCP_DISC_START_TIMEOUT_SEC *
 				      TICKS_PER_SEC ) );
 		return;
 	}
+	dhcp->linkwait = 0;
 
 	/* Give up waiting for ProxyDHCP before we reach the failure point */
 	if ( dhcp->offer.s_addr &&
@@ -471,6 +618,12 @@ static void dhcp_discovery_expired ( struct dhcp_session *dhcp ) {
 
 	/* Otherwise, retransmit current packet */
 	dhcp_tx ( dhcp );
+
+	/* If we are waiting only for ProxyDHCP offers, do not allow
+	 * the next retransmission to overshoot the ProxyDHCP timeout.
+	 */
+	if ( dhcp->offer.s_addr )
+		dhcp_discovery_clamp ( dhcp );
 }
 
 /** DHCP discovery state operations */
@@ -500,10 +653,13 @@ static int dhcp_request_tx ( struct dhcp_session *dhcp,
 	       dhcp, inet_ntoa ( dhcp->server ), BOOTPS_PORT );
 	DBGC ( dhcp, " for %s\n", inet_ntoa ( dhcp->offer ) );
 
-	/* Set server ID */
-	if ( ( rc = dhcppkt_store ( dhcppkt, DHCP_SERVER_IDENTIFIER,
-				    &dhcp->server,
-				    sizeof ( dhcp->server ) ) ) != 0 )
+	/* Set server ID.  An INIT-REBOOT reclaim attempt omits the
+	 * server ID, since the answering server is not yet confirmed.
+	 */
+	if ( ( ! dhcp->reclaim ) &&
+	     ( ( rc = dhcppkt_store ( dhcppkt, DHCP_SERVER_IDENTIFIER,
+				      &dhcp->server,
+				      sizeof ( dhcp->server ) ) ) != 0 ) )
 		return rc;
 
 	/* Set requested IP address */
@@ -557,13 +713,29 @@ static void dhcp_request_rx ( struct dhcp_session *dhcp,
 	/* Filter out unacceptable responses */
 	if ( peer->sin_port != htons ( BOOTPS_PORT ) )
 		return;
+	if ( dhcp->reclaim && ( msgtype == DHCPNAK ) ) {
+		/* Reclaim attempt refused: revert to discovery */
+		DBGC ( dhcp, "DHCP %p reclaim refused\n", dhcp );
+		dhcp->reclaim = 0;
+		dhcp->offer.s_addr = 0;
+		dhcp->server.s_addr = 0;
+		dhcp_set_state ( dhcp, &dhcp_state_discover );
+		return;
+	}
 	if ( msgtype /* BOOTP */ && ( msgtype != DHCPACK ) )
 		return;
-	if ( server_id.s_addr != dhcp->server.s_addr )
+	if ( ( ! dhcp->reclaim ) &&
+	     ( server_id.s_addr != dhcp->server.s_addr ) )
 		return;
 	if ( ip.s_addr != dhcp->offer.s_addr )
 		return;
 
+	/* Record the answering server when reclaiming a cached lease */
+	if ( dhcp->reclaim ) {
+		dhcp->server = server_id;
+		dhcp->reclaim = 0;
+	}
+
 	/* Record assigned address */
 	dhcp->local.sin_addr = ip;
 
@@ -578,6 +750,13 @@ static void dhcp_request_rx ( struct dhcp_session *dhcp,
 		return;
 	}
 
+	/* Record lease hint for subsequent boots.  Hints are not
+	 * recorded when a ProxyDHCP offer was involved, since a
+	 * reclaim attempt would bypass ProxyDHCP offer collection.
+	 */
+	if ( ! dhcp->proxy_offer )
+		dhcp_record_hint ( dhcp, dhcppkt );
+
 	/* Perform ProxyDHCP if applicable */
 	if ( dhcp->proxy_offer /* Have ProxyDHCP offer */ &&
 	     ( ! dhcp->no_pxedhcp ) /* ProxyDHCP not disabled */ ) {
@@ -611,6 +790,18 @@ static void dhcp_request_rx ( struct dhcp_session *dhcp,
  * @v dhcp		DHCP session
  */
 static void dhcp_request_expired ( struct dhcp_session *dhcp ) {
+	unsigned long elapsed = ( currticks() - dhcp->start );
+
+	/* Fall back to discovery if a reclaim attempt goes unanswered */
+	if ( dhcp->reclaim &&
+	     ( elapsed > ( DHCP_REQ_RECLAIM_TIMEOUT_SEC * TICKS_PER_SEC ) ) ) {
+		DBGC ( dhcp, "DHCP %p reclaim timed out\n", dhcp );
+		dhcp->reclaim = 0;
+		dhcp->offer.s_addr = 0;
+		dhcp->server.s_addr = 0;
+		dhcp_set_state ( dhcp, &dhcp_state_discover );
+		return;
+	}
 
 	/* Retransmit current packet */
 	dhcp_tx ( dhcp );
@@ -1296,6 +1487,47 @@ static struct interface_operation dhcp_job_op[] = {
 static struct interface_descriptor dhcp_job_desc =
 	INTF_DESC ( struct dhcp_session, job, dhcp_job_op );
 
+/****************************************************************************
+ *
+ * Link state notifications
+ *
+ */
+
+/**
+ * Handle network device or link state change
+ *
+ * @v netdev		Network device
+ */
+static void dhcp_notify ( struct net_device *netdev ) {
+	struct dhcp_session *dhcp;
+
+	/* Do nothing unless link is up and unblocked */
+	if ( ( ! netdev_link_ok ( netdev ) ) ||
+	     netdev_link_blocked ( netdev ) )
+		return;
+
+	/* Expedite any discovery deferred pending link-up on this
+	 * network device, rather than waiting out the remainder of
+	 * the deferral timer.
+	 */
+	list_for_each_entry ( dhcp, &dhcp_sessions, list ) {
+		if ( dhcp->netdev != netdev )
+			continue;
+		if ( ! dhcp->linkwait )
+			continue;
+		DBGC ( dhcp, "DHCP %p expediting discovery\n", dhcp );
+		dhcp->linkwait = 0;
+		dhcp->start = currticks();
+		start_timer_nodelay ( &dhcp->timer );
+	}
+}
+
+/** DHCP network device driver */
+struct net_driver dhcp_net_driver __net_driver = {
+	.name = "DHCP",
+	.notify = dhcp_notify,
+};
+
 /****************************************************************************
  *
  * Instantiators
@@ -1328,6 +1560,9 @@ int start_dhcp ( struct interface *job, struct net_device *netdev ) {
 	struct dhcp_session *dhcp;
 	int rc;
 
+	/* Record boot trace marker */
+	boottrace ( "DHCP %s", netdev->name );
+
 	/* Allocate and initialise structure */
 	dhcp = zalloc ( sizeof ( *dhcp ) );
 	if ( ! dhcp )
@@ -1340,6 +1575,7 @@ int start_dhcp ( struct interface *job, struct net_device *netdev ) {
 	dhcp->local.sin_family = AF_INET;
 	dhcp->local.sin_port = htons ( BOOTPC_PORT );
 	dhcp->xid = random();
+	list_add ( &dhcp->list, &dhcp_sessions );
 
 	/* Store DHCP transaction ID for fakedhcp code */
 	dhcp_last_xid = dhcp->xid;
@@ -1349,8 +1585,12 @@ int start_dhcp ( struct interface *job, struct net_device *netdev ) {
 				  ( struct sockaddr * ) &dhcp->local ) ) != 0 )
 		goto err;
 
-	/* Enter DHCPDISCOVER state */
-	dhcp_set_state ( dhcp, &dhcp_state_discover );
+	/* Attempt to reclaim a cached lease, if available */
+	dhcp_reclaim ( dhcp );
+
+	/* Enter DHCPREQUEST (INIT-REBOOT) or DHCPDISCOVER state */
+	dhcp_set_state ( dhcp, ( dhcp->reclaim ? &dhcp_state_request :
+				 &dhcp_state_discover ) );
 
 	/* Attach parent interface, mortalise self, and return */
 	intf_plug_plug ( &dhcp->job, job );
@@ -1450,6 +1690,7 @@ int start_pxebs ( struct interface *job, struct net_device *netdev,
 			     &dhcp->local.sin_addr );
 	dhcp->local.sin_port = htons ( BOOTPC_PORT );
 	dhcp->pxe_type = cpu_to_le16 ( pxe_type );
+	list_add ( &dhcp->list, &dhcp_sessions );
 
 	/* Construct PXE boot server IP address lists */
 	pxe_discovery_control =
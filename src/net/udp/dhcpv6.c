@@ -462,6 +462,10 @@ enum dhcpv6_session_state_flags {
 	DHCPV6_RX_RECORD_SERVER_ID = 0x04,
 	/** Record received IPv6 address */
 	DHCPV6_RX_RECORD_IAADDR = 0x08,
+	/** Include rapid commit option within request */
+	DHCPV6_TX_RAPID_COMMIT = 0x10,
+	/** Accept a rapid-committed reply */
+	DHCPV6_RX_RAPID_COMMIT = 0x20,
 };
 
 /** DHCPv6 request state */
@@ -473,12 +477,19 @@ static struct dhcpv6_session_state dhcpv6_request = {
 	.next = NULL,
 };
 
-/** DHCPv6 solicitation state */
+/** DHCPv6 solicitation state
+ *
+ * We always offer the server the option to rapid-commit the
+ * solicitation (thereby cutting the exchange from four messages to
+ * two); a server that does not support (or is configured not to use)
+ * rapid commit will simply respond with a normal advertisement.
+ */
 static struct dhcpv6_session_state dhcpv6_solicit = {
 	.tx_type = DHCPV6_SOLICIT,
 	.rx_type = DHCPV6_ADVERTISE,
 	.flags = ( DHCPV6_TX_IA_NA | DHCPV6_RX_RECORD_SERVER_ID |
-		   DHCPV6_RX_RECORD_IAADDR ),
+		   DHCPV6_RX_RECORD_IAADDR | DHCPV6_TX_RAPID_COMMIT |
+		   DHCPV6_RX_RAPID_COMMIT ),
 	.next = &dhcpv6_request,
 };
 
@@ -612,6 +623,7 @@ static int dhcpv6_tx ( struct dhcpv6_session *dhcpv6 ) {
 	struct dhcpv6_ia_na_option *ia_na;
 	struct dhcpv6_iaaddr_option *iaaddr;
 	struct dhcpv6_user_class_option *user_class;
+	struct dhcpv6_option *rapid_commit;
 	struct dhcpv6_elapsed_time_option *elapsed;
 	struct dhcpv6_header *dhcphdr;
 	struct io_buffer *iobuf;
@@ -621,6 +633,7 @@ static int dhcpv6_tx ( struct dhcpv6_session *dhcpv6 ) {
 	size_t ia_na_len;
 	size_t user_class_string_len;
 	size_t user_class_len;
+	size_t rapid_commit_len;
 	size_t elapsed_len;
 	size_t total_len;
 	int rc;
@@ -641,10 +654,12 @@ static int dhcpv6_tx ( struct dhcpv6_session *dhcpv6 ) {
 	user_class_len = ( sizeof ( *user_class ) +
 			   sizeof ( user_class->user_class[0] ) +
 			   user_class_string_len );
+	rapid_commit_len = ( ( dhcpv6->state->flags & DHCPV6_TX_RAPID_COMMIT ) ?
+			     sizeof ( *rapid_commit ) : 0 );
 	elapsed_len = sizeof ( *elapsed );
 	total_len = ( sizeof ( *dhcphdr ) + client_id_len + server_id_len +
 		      ia_na_len + sizeof ( dhcpv6_request_options_data ) +
-		      user_class_len + elapsed_len );
+		      user_class_len + rapid_commit_len + elapsed_len );
 
 	/* Allocate packet */
 	iobuf = xfer_alloc_iob ( &dhcpv6->xfer, total_len );
@@ -709,6 +724,13 @@ static int dhcpv6_tx ( struct dhcpv6_session *dhcpv6 ) {
 	dhcpv6_user_class ( user_class->user_class[0].string,
 			    user_class_string_len );
 
+	/* Construct rapid commit, if applicable */
+	if ( rapid_commit_len ) {
+		rapid_commit = iob_put ( iobuf, rapid_commit_len );
+		rapid_commit->code = htons ( DHCPV6_RAPID_COMMIT );
+		rapid_commit->len = htons ( 0 );
+	}
+
 	/* Construct elapsed time */
 	elapsed = iob_put ( iobuf, elapsed_len );
 	elapsed->header.code = htons ( DHCPV6_ELAPSED_TIME );
@@ -769,6 +791,7 @@ static int dhcpv6_rx ( struct dhcpv6_session *dhcpv6,
 	struct dhcpv6_header *dhcphdr = iobuf->data;
 	struct dhcpv6_option_list options;
 	const union dhcpv6_any_option *option;
+	int rapid;
 	int rc;
 
 	/* Sanity checks */
@@ -811,8 +834,16 @@ static int dhcpv6_rx ( struct dhcpv6_session *dhcpv6,
 		goto done;
 	}
 
+	/* Check for a rapid-committed reply, if permitted.  A server
+	 * that honours our rapid commit option responds to the
+	 * solicitation with an immediately usable reply.
+	 */
+	rapid = ( ( dhcpv6->state->flags & DHCPV6_RX_RAPID_COMMIT ) &&
+		  ( dhcphdr->type == DHCPV6_REPLY ) &&
+		  ( dhcpv6_option ( &options, DHCPV6_RAPID_COMMIT ) != NULL ) );
+
 	/* Check message type */
-	if ( dhcphdr->type != dhcpv6->state->rx_type ) {
+	if ( ( dhcphdr->type != dhcpv6->state->rx_type ) && ( ! rapid ) ) {
 		DBGC ( dhcpv6, "DHCPv6 %s received %s while expecting %s\n",
 		       dhcpv6->netdev->name, dhcpv6_type_name ( dhcphdr->type ),
 		       dhcpv6_type_name ( dhcpv6->state->rx_type ) );
@@ -869,7 +900,7 @@ static int dhcpv6_rx ( struct dhcpv6_session *dhcpv6,
 	}
 
 	/* Transition to next state, if applicable */
-	if ( dhcpv6->state->next ) {
+	if ( dhcpv6->state->next && ( ! rapid ) ) {
 		dhcpv6_set_state ( dhcpv6, dhcpv6->state->next );
 		rc = 0;
 		goto done;
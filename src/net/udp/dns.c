@@ -29,6 +29,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <ctype.h>
 #include <errno.h>
@@ -39,6 +40,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/open.h>
 #include <ipxe/resolv.h>
 #include <ipxe/retry.h>
+#include <ipxe/timer.h>
+#include <ipxe/process.h>
+#include <ipxe/malloc.h>
 #include <ipxe/tcpip.h>
 #include <ipxe/settings.h>
 #include <ipxe/features.h>
@@ -436,6 +440,248 @@ static const char * dns_type ( uint16_t type ) {
 	}
 }
 
+/******************************************************************************
+ *
+ * DNS lookup cache
+ *
+ ******************************************************************************
+ */
+
+/** A resolved network address */
+struct dns_address {
+	/** Address family */
+	sa_family_t family;
+	/** Network address */
+	union {
+		/** IPv4 address */
+		struct in_addr in;
+		/** IPv6 address */
+		struct in6_addr in6;
+	} addr;
+};
+
+/** Maximum number of cached DNS lookups */
+#define DNS_CACHE_MAX 8
+
+/** Maximum time for which a cached DNS lookup may be used (in seconds) */
+#define DNS_CACHE_MAX_TTL ( 10 * 60 )
+
+/** A cached DNS lookup */
+struct dns_cache_entry {
+	/** List of cached lookups */
+	struct list_head list;
+	/** Resolved address */
+	struct dns_address address;
+	/** Expiry time (in ticks) */
+	unsigned long expiry;
+	/** Name as originally requested
+	 *
+	 * Must be at end of structure
+	 */
+	char name[0];
+};
+
+/** List of cached DNS lookups */
+static LIST_HEAD ( dns_cache );
+
+/** Number of cached DNS lookups */
+static unsigned int dns_cache_count;
+
+/**
+ * Apply resolved address to socket address
+ *
+ * @v address		Resolved address
+ * @v sa		Socket address to fill in
+ */
+static void dns_address_apply ( struct dns_address *address,
+				struct sockaddr *sa ) {
+	struct sockaddr_in *sin = ( ( struct sockaddr_in * ) sa );
+	struct sockaddr_in6 *sin6 = ( ( struct sockaddr_in6 * ) sa );
+
+	switch ( address->family ) {
+	case AF_INET:
+		sin->sin_family = AF_INET;
+		sin->sin_addr = address->addr.in;
+		break;
+	case AF_INET6:
+		sin6->sin6_family = AF_INET6;
+		memcpy ( &sin6->sin6_addr, &address->addr.in6,
+			 sizeof ( sin6->sin6_addr ) );
+		break;
+	default:
+		assert ( 0 );
+	}
+}
+
+/**
+ * Discard expired cached DNS lookups
+ *
+ */
+static void dns_cache_expire ( void ) {
+	struct dns_cache_entry *entry;
+	struct dns_cache_entry *tmp;
+	unsigned long now = currticks();
+
+	list_for_each_entry_safe ( entry, tmp, &dns_cache, list ) {
+		if ( ( ( signed long ) ( entry->expiry - now ) ) <= 0 ) {
+			DBGC ( entry, "DNS cache expired %s\n", entry->name );
+			list_del ( &entry->list );
+			free ( entry );
+			dns_cache_count--;
+		}
+	}
+}
+
+/**
+ * Look up name in DNS cache
+ *
+ * @v name		Name
+ * @ret address		Resolved address, or NULL if not cached
+ */
+static struct dns_address * dns_cache_find ( const char *name ) {
+	struct dns_cache_entry *entry;
+
+	/* Discard any expired lookups */
+	dns_cache_expire();
+
+	/* Search for a matching name */
+	list_for_each_entry ( entry, &dns_cache, list ) {
+		if ( strcasecmp ( entry->name, name ) == 0 )
+			return &entry->address;
+	}
+
+	return NULL;
+}
+
+/**
+ * Add lookup to DNS cache
+ *
+ * @v name		Name
+ * @v address		Resolved address
+ * @v ttl		Record time to live (in seconds)
+ */
+static void dns_cache_add ( const char *name, struct dns_address *address,
+			    unsigned long ttl ) {
+	struct dns_cache_entry *entry;
+	size_t name_len = ( strlen ( name ) + 1 /* NUL */ );
+
+	/* Do not cache zero-TTL records */
+	if ( ! ttl )
+		return;
+
+	/* Limit time for which lookup may be used */
+	if ( ttl > DNS_CACHE_MAX_TTL )
+		ttl = DNS_CACHE_MAX_TTL;
+
+	/* Evict oldest lookup if cache is full */
+	if ( dns_cache_count >= DNS_CACHE_MAX ) {
+		entry = list_last_entry ( &dns_cache, struct dns_cache_entry,
+					  list );
+		list_del ( &entry->list );
+		free ( entry );
+		dns_cache_count--;
+	}
+
+	/* Allocate and populate entry, ignoring failures */
+	entry = zalloc ( sizeof ( *entry ) + name_len );
+	if ( ! entry )
+		return;
+	memcpy ( &entry->address, address, sizeof ( entry->address ) );
+	entry->expiry = ( currticks() + ( ttl * TICKS_PER_SEC ) );
+	memcpy ( entry->name, name, name_len );
+	list_add ( &entry->list, &dns_cache );
+	dns_cache_count++;
+
+	DBGC ( entry, "DNS cached %s (TTL %lds)\n", entry->name, ttl );
+}
+
+/**
+ * Discard some cached DNS lookups
+ *
+ * @ret discarded	Number of cached items discarded
+ */
+static unsigned int dns_cache_discard ( void ) {
+	struct dns_cache_entry *entry;
+
+	/* Discard oldest cached lookup, if any */
+	entry = list_last_entry ( &dns_cache, struct dns_cache_entry, list );
+	if ( ! entry )
+		return 0;
+	list_del ( &entry->list );
+	free ( entry );
+	dns_cache_count--;
+
+	return 1;
+}
+
+/** DNS cache discarder */
+struct cache_discarder dns_cache_discarder __cache_discarder ( CACHE_NORMAL )={
+	.discard = dns_cache_discard,
+};
+
+/** A cached DNS lookup in the process of completing */
+struct dns_cached {
+	/** Reference counter */
+	struct refcnt refcnt;
+	/** Name resolution interface */
+	struct interface resolv;
+	/** Process */
+	struct process process;
+	/** Completed socket address */
+	struct sockaddr sa;
+};
+
+/**
+ * Complete cached DNS lookup
+ *
+ * @v cached		Cached DNS lookup
+ */
+static void dns_cached_step ( struct dns_cached *cached ) {
+
+	resolv_done ( &cached->resolv, &cached->sa );
+	intf_shutdown ( &cached->resolv, 0 );
+}
+
+/** Cached DNS lookup process descriptor */
+static struct process_descriptor dns_cached_desc =
+	PROC_DESC_ONCE ( struct dns_cached, process, dns_cached_step );
+
+/**
+ * Resolve name from DNS cache
+ *
+ * @v resolv		Name resolution interface
+ * @v address		Cached resolved address
+ * @v sa		Socket address to fill in
+ * @ret rc		Return status code
+ */
+static int dns_resolv_cached ( struct interface *resolv,
+			       struct dns_address *address,
+			       struct sockaddr *sa ) {
+	struct dns_cached *cached;
+
+	/* Allocate and initialise structure */
+	cached = zalloc ( sizeof ( *cached ) );
+	if ( ! cached )
+		return -ENOMEM;
+	ref_init ( &cached->refcnt, NULL );
+	intf_init ( &cached->resolv, &null_intf_desc, &cached->refcnt );
+	process_init ( &cached->process, &dns_cached_desc, &cached->refcnt );
+	memcpy ( &cached->sa, sa, sizeof ( cached->sa ) );
+	dns_address_apply ( address, &cached->sa );
+
+	/* Attach to parent interface, mortalise self, and return */
+	intf_plug_plug ( &cached->resolv, resolv );
+	ref_put ( &cached->refcnt );
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * DNS requests
+ *
+ ******************************************************************************
+ */
+
 /** A DNS request */
 struct dns_request {
 	/** Reference counter */
@@ -476,8 +722,119 @@ struct dns_request {
 	struct dns_name search;
 	/** Recursion counter */
 	unsigned int recursion;
+
+	/** TCP transport is in use */
+	int tcp;
+	/** Length of received TCP message length prefix */
+	size_t prefix_len;
+	/** TCP message length prefix */
+	uint8_t prefix[2];
+	/** Reassembled TCP response message */
+	struct io_buffer *message;
+
+	/** List of in-flight DNS requests */
+	struct list_head list;
+	/** List of followers sharing this request */
+	struct list_head followers;
+	/** Name as originally requested */
+	char *reqname;
+	/** Resolved address */
+	struct dns_address resolved;
+	/** Time to live of resolved record (in seconds) */
+	unsigned long ttl;
+
+	/** Identifier of parallel "A" query */
+	uint16_t aid;
+	/** Parallel "A" query is outstanding */
+	int aid_pending;
+	/** Stashed parallel "A" response is available */
+	int have_stash;
+	/** Stashed address from parallel "A" response */
+	struct dns_address stash;
+	/** Time to live of stashed record (in seconds) */
+	unsigned long stash_ttl;
+};
+
+/** List of in-flight DNS requests */
+static LIST_HEAD ( dns_requests );
+
+/** A DNS request follower
+ *
+ * A follower shares the in-flight query of an existing DNS request
+ * for the same name, rather than issuing a duplicate query.
+ */
+struct dns_follower {
+	/** Reference counter */
+	struct refcnt refcnt;
+	/** Name resolution interface */
+	struct interface resolv;
+	/** List of followers */
+	struct list_head list;
+	/** Socket address to complete */
+	struct sockaddr sa;
+};
+
+/**
+ * Detach follower from DNS request
+ *
+ * @v follower		Follower
+ * @v rc		Reason for close
+ */
+static void dns_follower_close ( struct dns_follower *follower, int rc ) {
+
+	/* Remove from follower list, if not already removed */
+	if ( ! list_empty ( &follower->list ) ) {
+		list_del ( &follower->list );
+		INIT_LIST_HEAD ( &follower->list );
+		ref_put ( &follower->refcnt );
+	}
+
+	/* Shut down interface */
+	intf_shutdown ( &follower->resolv, rc );
+}
+
+/** DNS request follower interface operations */
+static struct interface_operation dns_follower_op[] = {
+	INTF_OP ( intf_close, struct dns_follower *, dns_follower_close ),
 };
 
+/** DNS request follower interface descriptor */
+static struct interface_descriptor dns_follower_desc =
+	INTF_DESC ( struct dns_follower, resolv, dns_follower_op );
+
+/**
+ * Share an in-flight DNS request
+ *
+ * @v dns		Existing DNS request for the same name
+ * @v resolv		Name resolution interface
+ * @v sa		Socket address to complete
+ * @ret rc		Return status code
+ */
+static int dns_follow ( struct dns_request *dns, struct interface *resolv,
+			struct sockaddr *sa ) {
+	struct dns_follower *follower;
+
+	/* Allocate and initialise structure */
+	follower = zalloc ( sizeof ( *follower ) );
+	if ( ! follower )
+		return -ENOMEM;
+	ref_init ( &follower->refcnt, NULL );
+	intf_init ( &follower->resolv, &dns_follower_desc, &follower->refcnt );
+	INIT_LIST_HEAD ( &follower->list );
+	memcpy ( &follower->sa, sa, sizeof ( follower->sa ) );
+
+	/* Add to follower list */
+	ref_get ( &follower->refcnt );
+	list_add ( &follower->list, &dns->followers );
+
+	DBGC ( dns, "DNS %p sharing query for %s\n", dns, dns->reqname );
+
+	/* Attach to parent interface, mortalise self, and return */
+	intf_plug_plug ( &follower->resolv, resolv );
+	ref_put ( &follower->refcnt );
+	return 0;
+}
+
 /**
  * Mark DNS request as complete
  *
@@ -485,10 +842,31 @@ struct dns_request {
  * @v rc		Return status code
  */
 static void dns_done ( struct dns_request *dns, int rc ) {
+	struct dns_follower *follower;
+	struct dns_follower *tmp;
 
 	/* Stop the retry timer */
 	stop_timer ( &dns->timer );
 
+	/* Remove from list of in-flight requests, if not already removed */
+	if ( ! list_empty ( &dns->list ) ) {
+		list_del ( &dns->list );
+		INIT_LIST_HEAD ( &dns->list );
+		ref_put ( &dns->refcnt );
+	}
+
+	/* Discard any partially reassembled TCP response */
+	free_iob ( dns->message );
+	dns->message = NULL;
+
+	/* Shut down and detach any remaining followers */
+	list_for_each_entry_safe ( follower, tmp, &dns->followers, list ) {
+		list_del ( &follower->list );
+		INIT_LIST_HEAD ( &follower->list );
+		intf_shutdown ( &follower->resolv, rc );
+		ref_put ( &follower->refcnt );
+	}
+
 	/* Shut down interfaces */
 	intf_shutdown ( &dns->socket, rc );
 	intf_shutdown ( &dns->resolv, rc );
@@ -501,13 +879,43 @@ static void dns_done ( struct dns_request *dns, int rc ) {
  * @v rc		Return status code
  */
 static void dns_resolved ( struct dns_request *dns ) {
+	struct dns_follower *follower;
+	struct dns_follower *tmp;
+	int stashed;
+
+	/* Fill in resolved address */
+	dns_address_apply ( &dns->resolved, &dns->address.sa );
 
 	DBGC ( dns, "DNS %p found address %s\n",
 	       dns, sock_ntoa ( &dns->address.sa ) );
 
+	/* Add lookup to cache */
+	dns_cache_add ( dns->reqname, &dns->resolved, dns->ttl );
+
 	/* Return resolved address */
 	resolv_done ( &dns->resolv, &dns->address.sa );
 
+	/* Additionally return any stashed IPv4 address, so that
+	 * dual-stack clients may race connections to both addresses.
+	 */
+	stashed = ( ( dns->resolved.family == AF_INET6 ) && dns->have_stash );
+	if ( stashed ) {
+		dns_address_apply ( &dns->stash, &dns->address.sa );
+		resolv_done ( &dns->resolv, &dns->address.sa );
+	}
+
+	/* Return resolved address(es) to any followers.  A follower
+	 * may detach itself in response, so iterate safely.
+	 */
+	list_for_each_entry_safe ( follower, tmp, &dns->followers, list ) {
+		dns_address_apply ( &dns->resolved, &follower->sa );
+		resolv_done ( &follower->resolv, &follower->sa );
+		if ( stashed ) {
+			dns_address_apply ( &dns->stash, &follower->sa );
+			resolv_done ( &follower->resolv, &follower->sa );
+		}
+	}
+
 	/* Mark operation as complete */
 	dns_done ( dns, 0 );
 }
@@ -527,6 +935,10 @@ static int dns_question ( struct dns_request *dns ) {
 	int len;
 	size_t offset;
 
+	/* Discard any parallel query state for the previous question */
+	dns->aid_pending = 0;
+	dns->have_stash = 0;
+
 	/* Use root suffix if search list is empty */
 	if ( search->offset == search->len )
 		search = &search_root;
@@ -561,6 +973,27 @@ static int dns_question ( struct dns_request *dns ) {
 	return 0;
 }
 
+/**
+ * Send DNS query message
+ *
+ * @v dns		DNS request
+ * @ret rc		Return status code
+ */
+static int dns_send ( struct dns_request *dns ) {
+	uint16_t prefix;
+	int rc;
+
+	/* Prefix message with its length when using TCP transport */
+	if ( dns->tcp ) {
+		prefix = htons ( dns->len );
+		if ( ( rc = xfer_deliver_raw ( &dns->socket, &prefix,
+					       sizeof ( prefix ) ) ) != 0 )
+			return rc;
+	}
+
+	return xfer_deliver_raw ( &dns->socket, &dns->buf.query, dns->len );
+}
+
 /**
  * Send DNS query
  *
@@ -569,6 +1002,8 @@ static int dns_question ( struct dns_request *dns ) {
  */
 static int dns_send_packet ( struct dns_request *dns ) {
 	struct dns_header *query = &dns->buf.query;
+	uint16_t id;
+	int rc;
 
 	/* Start retransmission timer */
 	start_timer ( &dns->timer );
@@ -582,7 +1017,62 @@ static int dns_send_packet ( struct dns_request *dns ) {
 	       dns_type ( dns->question->qtype ) );
 
 	/* Send the data */
-	return xfer_deliver_raw ( &dns->socket, query, dns->len );
+	if ( ( rc = dns_send ( dns ) ) != 0 )
+		return rc;
+
+	/* Additionally emit a parallel "A" query within the same
+	 * window when querying for an AAAA record, so that falling
+	 * back to IPv4 does not have to wait out the AAAA exchange.
+	 * (Over TCP transport, this pipelines the second query on the
+	 * same connection.)  Failure to send the parallel query is
+	 * harmless.
+	 */
+	if ( dns->question->qtype == htons ( DNS_TYPE_AAAA ) ) {
+		id = query->id;
+		dns->aid = random();
+		query->id = dns->aid;
+		dns->question->qtype = htons ( DNS_TYPE_A );
+		DBGC ( dns, "DNS %p sending parallel query ID %#04x for %s "
+		       "type A\n", dns, ntohs ( dns->aid ),
+		       dns_name ( &dns->name ) );
+		dns_send ( dns );
+		query->id = id;
+		dns->question->qtype = htons ( DNS_TYPE_AAAA );
+		dns->aid_pending = 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Fall back to TCP transport
+ *
+ * @v dns		DNS request
+ * @ret rc		Return status code
+ *
+ * Truncated responses (e.g. for large DNSSEC-signed record sets)
+ * cannot fit within a UDP payload; retry the query over a TCP
+ * connection to the same nameserver, as per RFC 7766.
+ */
+static int dns_fallback_tcp ( struct dns_request *dns ) {
+	int rc;
+
+	DBGC ( dns, "DNS %p response truncated; retrying over TCP\n", dns );
+
+	/* Mark TCP transport as being in use */
+	dns->tcp = 1;
+
+	/* Close UDP socket and open TCP socket to the same nameserver */
+	intf_restart ( &dns->socket, 0 );
+	if ( ( rc = xfer_open_socket ( &dns->socket, SOCK_STREAM,
+				       &nameserver.sa, NULL ) ) != 0 ) {
+		DBGC ( dns, "DNS %p could not open TCP socket: %s\n",
+		       dns, strerror ( rc ) );
+		return rc;
+	}
+
+	/* Resend query (queued until the connection completes) */
+	return dns_send_packet ( dns );
 }
 
 /**
@@ -603,16 +1093,16 @@ static void dns_timer_expired ( struct retry_timer *timer, int fail ) {
 }
 
 /**
- * Receive new data
+ * Handle received DNS response message
  *
  * @v dns		DNS request
  * @v iobuf		I/O buffer
- * @v meta		Data transfer metadata
  * @ret rc		Return status code
+ *
+ * This function takes ownership of the I/O buffer.
  */
-static int dns_xfer_deliver ( struct dns_request *dns,
-			      struct io_buffer *iobuf,
-			      struct xfer_metadata *meta __unused ) {
+static int dns_response ( struct dns_request *dns,
+			  struct io_buffer *iobuf ) {
 	struct dns_header *response = iobuf->data;
 	struct dns_header *query = &dns->buf.query;
 	unsigned int qtype = dns->question->qtype;
@@ -623,6 +1113,7 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 	size_t next_offset;
 	size_t rdlength;
 	size_t name_len;
+	int parallel;
 	int rc;
 
 	/* Sanity check */
@@ -633,8 +1124,9 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 		goto done;
 	}
 
-	/* Check response ID matches query ID */
-	if ( response->id != query->id ) {
+	/* Check response ID matches query ID (or parallel query ID) */
+	parallel = ( dns->aid_pending && ( response->id == dns->aid ) );
+	if ( ( response->id != query->id ) && ( ! parallel ) ) {
 		DBGC ( dns, "DNS %p received unexpected response ID %#04x "
 		       "(wanted %d)\n", dns, ntohs ( response->id ),
 		       ntohs ( query->id ) );
@@ -644,6 +1136,13 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 	DBGC ( dns, "DNS %p received response ID %#04x\n",
 	       dns, ntohs ( response->id ) );
 
+	/* Fall back to TCP transport if the response is truncated */
+	if ( ( response->flags & htons ( DNS_FLAG_TC ) ) && ( ! dns->tcp ) ) {
+		if ( ( rc = dns_fallback_tcp ( dns ) ) != 0 )
+			dns_done ( dns, rc );
+		goto done;
+	}
+
 	/* Check that we have exactly one question */
 	if ( response->qdcount != htons ( 1 ) ) {
 		DBGC ( dns, "DNS %p received response with %d questions\n",
@@ -665,6 +1164,54 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 	}
 	answer_offset = ( offset + sizeof ( struct dns_question ) );
 
+	/* Handle the parallel "A" response separately: stash any A
+	 * record for use if the preferred AAAA lookup finds no
+	 * record, and leave the primary query's state machine (and
+	 * retry timer) untouched.
+	 */
+	if ( parallel ) {
+		dns->aid_pending = 0;
+		for ( buf.offset = answer_offset ; buf.offset != buf.len ;
+		      buf.offset = next_offset ) {
+			offset = dns_skip ( &buf );
+			if ( offset < 0 )
+				break;
+			rr = ( buf.data + offset );
+			if ( ( offset + sizeof ( rr->common ) ) > buf.len )
+				break;
+			rdlength = ntohs ( rr->common.rdlength );
+			next_offset = ( offset + sizeof ( rr->common ) +
+					rdlength );
+			if ( next_offset > buf.len )
+				break;
+			if ( dns_compare ( &buf, &dns->name ) != 0 )
+				continue;
+			if ( ( rr->common.type == htons ( DNS_TYPE_A ) ) &&
+			     ( rdlength >= sizeof ( rr->a.in_addr ) ) ) {
+				DBGC ( dns, "DNS %p stashing parallel A "
+				       "record\n", dns );
+				dns->stash.family = AF_INET;
+				dns->stash.addr.in = rr->a.in_addr;
+				dns->stash_ttl = ntohl ( rr->common.ttl );
+				dns->have_stash = 1;
+				break;
+			}
+		}
+
+		/* Use the stashed record immediately if the AAAA
+		 * possibility has already been exhausted.
+		 */
+		if ( dns->have_stash &&
+		     ( dns->question->qtype == htons ( DNS_TYPE_A ) ) ) {
+			memcpy ( &dns->resolved, &dns->stash,
+				 sizeof ( dns->resolved ) );
+			dns->ttl = dns->stash_ttl;
+			dns_resolved ( dns );
+		}
+		rc = 0;
+		goto done;
+	}
+
 	/* Search through response for useful answers.  Do this
 	 * multiple times, to take advantage of useful nameservers
 	 * which send us e.g. the CNAME *and* the A record for the
@@ -719,10 +1266,10 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 				rc = -EINVAL;
 				goto done;
 			}
-			dns->address.sin6.sin6_family = AF_INET6;
-			memcpy ( &dns->address.sin6.sin6_addr,
-				 &rr->aaaa.in6_addr,
-				 sizeof ( dns->address.sin6.sin6_addr ) );
+			dns->resolved.family = AF_INET6;
+			memcpy ( &dns->resolved.addr.in6, &rr->aaaa.in6_addr,
+				 sizeof ( dns->resolved.addr.in6 ) );
+			dns->ttl = ntohl ( rr->common.ttl );
 			dns_resolved ( dns );
 			rc = 0;
 			goto done;
@@ -736,8 +1283,9 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 				rc = -EINVAL;
 				goto done;
 			}
-			dns->address.sin.sin_family = AF_INET;
-			dns->address.sin.sin_addr = rr->a.in_addr;
+			dns->resolved.family = AF_INET;
+			dns->resolved.addr.in = rr->a.in_addr;
+			dns->ttl = ntohl ( rr->common.ttl );
 			dns_resolved ( dns );
 			rc = 0;
 			goto done;
@@ -788,9 +1336,20 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 	switch ( qtype ) {
 
 	case htons ( DNS_TYPE_AAAA ):
-		/* We asked for an AAAA record and got nothing; try
-		 * the A.
+		/* We asked for an AAAA record and got nothing.  Use
+		 * the stashed parallel A response if one has already
+		 * arrived; otherwise try the A.
 		 */
+		if ( dns->have_stash ) {
+			DBGC ( dns, "DNS %p found no AAAA record; using "
+			       "parallel A\n", dns );
+			memcpy ( &dns->resolved, &dns->stash,
+				 sizeof ( dns->resolved ) );
+			dns->ttl = dns->stash_ttl;
+			dns_resolved ( dns );
+			rc = 0;
+			goto done;
+		}
 		DBGC ( dns, "DNS %p found no AAAA record; trying A\n", dns );
 		dns->question->qtype = htons ( DNS_TYPE_A );
 		dns_send_packet ( dns );
@@ -854,6 +1413,77 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 	return rc;
 }
 
+/**
+ * Receive new data
+ *
+ * @v dns		DNS request
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int dns_xfer_deliver ( struct dns_request *dns,
+			      struct io_buffer *iobuf,
+			      struct xfer_metadata *meta __unused ) {
+	struct io_buffer *message;
+	size_t msg_len;
+	size_t frag_len;
+	int rc = 0;
+
+	/* Over UDP transport, each datagram is a single message */
+	if ( ! dns->tcp )
+		return dns_response ( dns, iobuf );
+
+	/* Over TCP transport, reassemble length-prefixed messages
+	 * from the byte stream
+	 */
+	while ( iob_len ( iobuf ) ) {
+
+		/* Accumulate the two-byte message length prefix */
+		if ( dns->prefix_len < sizeof ( dns->prefix ) ) {
+			dns->prefix[ dns->prefix_len++ ] =
+				*( ( uint8_t * ) iobuf->data );
+			iob_pull ( iobuf, 1 );
+			continue;
+		}
+
+		/* Allocate reassembly buffer, if applicable */
+		if ( ! dns->message ) {
+			msg_len = ( ( dns->prefix[0] << 8 ) | dns->prefix[1] );
+			if ( ! msg_len ) {
+				/* Ignore malformed zero-length messages */
+				dns->prefix_len = 0;
+				continue;
+			}
+			dns->message = alloc_iob ( msg_len );
+			if ( ! dns->message ) {
+				rc = -ENOMEM;
+				break;
+			}
+		}
+
+		/* Copy up to the remainder of the current message */
+		frag_len = iob_len ( iobuf );
+		if ( frag_len > iob_tailroom ( dns->message ) )
+			frag_len = iob_tailroom ( dns->message );
+		memcpy ( iob_put ( dns->message, frag_len ), iobuf->data,
+			 frag_len );
+		iob_pull ( iobuf, frag_len );
+
+		/* Process message, if complete */
+		if ( ! iob_tailroom ( dns->message ) ) {
+			message = dns->message;
+			dns->message = NULL;
+			dns->prefix_len = 0;
+			if ( ( rc = dns_response ( dns, message ) ) != 0 )
+				break;
+		}
+	}
+
+	/* Free I/O buffer */
+	free_iob ( iobuf );
+	return rc;
+}
+
 /**
  * Receive new data
  *
@@ -921,8 +1551,11 @@ static struct interface_descriptor dns_resolv_desc =
 static int dns_resolv ( struct interface *resolv,
 			const char *name, struct sockaddr *sa ) {
 	struct dns_request *dns;
+	struct dns_request *shared;
+	struct dns_address *address;
 	struct dns_header *query;
 	size_t search_len;
+	size_t reqname_len;
 	int name_len;
 	int rc;
 
@@ -934,11 +1567,24 @@ static int dns_resolv ( struct interface *resolv,
 		goto err_no_nameserver;
 	}
 
+	/* Use cached lookup, if available */
+	if ( ( address = dns_cache_find ( name ) ) != NULL ) {
+		DBG ( "DNS resolving \"%s\" from cache\n", name );
+		return dns_resolv_cached ( resolv, address, sa );
+	}
+
+	/* Share any existing in-flight request for the same name */
+	list_for_each_entry ( shared, &dns_requests, list ) {
+		if ( strcasecmp ( shared->reqname, name ) == 0 )
+			return dns_follow ( shared, resolv, sa );
+	}
+
 	/* Determine whether or not to use search list */
 	search_len = ( strchr ( name, '.' ) ? 0 : dns_search.len );
 
 	/* Allocate DNS structure */
-	dns = zalloc ( sizeof ( *dns ) + search_len );
+	reqname_len = ( strlen ( name ) + 1 /* NUL */ );
+	dns = zalloc ( sizeof ( *dns ) + search_len + reqname_len );
 	if ( ! dns ) {
 		rc = -ENOMEM;
 		goto err_alloc_dns;
@@ -947,10 +1593,14 @@ static int dns_resolv ( struct interface *resolv,
 	intf_init ( &dns->resolv, &dns_resolv_desc, &dns->refcnt );
 	intf_init ( &dns->socket, &dns_socket_desc, &dns->refcnt );
 	timer_init ( &dns->timer, dns_timer_expired, &dns->refcnt );
+	INIT_LIST_HEAD ( &dns->list );
+	INIT_LIST_HEAD ( &dns->followers );
 	memcpy ( &dns->address.sa, sa, sizeof ( dns->address.sa ) );
 	dns->search.data = ( ( ( void * ) dns ) + sizeof ( *dns ) );
 	dns->search.len = search_len;
 	memcpy ( dns->search.data, dns_search.data, search_len );
+	dns->reqname = ( ( ( void * ) dns ) + sizeof ( *dns ) + search_len );
+	memcpy ( dns->reqname, name, reqname_len );
 
 	/* Determine initial query type */
 	switch ( nameserver.sa.sa_family ) {
@@ -993,10 +1643,14 @@ static int dns_resolv ( struct interface *resolv,
 	/* Start timer to trigger first packet */
 	start_timer_nodelay ( &dns->timer );
 
+	/* Add to list of in-flight requests */
+	ref_get ( &dns->refcnt );
+	list_add ( &dns->list, &dns_requests );
+
 	/* Attach parent interface, mortalise self, and return */
 	intf_plug_plug ( &dns->resolv, resolv );
 	ref_put ( &dns->refcnt );
-	return 0;	
+	return 0;
 
  err_open_socket:
  err_question:
@@ -0,0 +1,876 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Peer-to-peer image sharing
+ *
+ * This protocol allows a booted-and-waiting iPXE instance (or the
+ * first node to finish fetching an image) to serve its registered
+ * images to LAN peers, so that a site pays for only a single WAN
+ * fetch.  Clients locate a serving peer by multicasting a query for
+ * an image name, then fetch the image from the first responding peer
+ * in digest-verified chunks over unicast UDP.
+ *
+ * Images are fetched using URIs of the form
+ *
+ *   x-imgshare:<name>
+ *
+ * where <name> is the name under which the image is registered on the
+ * serving peer.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/features.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/open.h>
+#include <ipxe/uri.h>
+#include <ipxe/image.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/crypto.h>
+#include <ipxe/sha256.h>
+#include <ipxe/socket.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/in.h>
+#include <ipxe/igmp.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/retry.h>
+#include <ipxe/timer.h>
+#include <ipxe/imgshare.h>
+
+FEATURE ( FEATURE_PROTOCOL, "PeerImg", DHCP_EB_FEATURE_IMGSHARE, 1 );
+
+/** Image sharing UDP port */
+#define IMGSHARE_PORT 10002
+
+/** Image sharing multicast discovery address: 239.255.1.2 */
+#define IMGSHARE_MULTICAST_IP \
+	( ( 239 << 24 ) | ( 255 << 16 ) | ( 1 << 8 ) | 2 )
+
+/** Image sharing chunk length
+ *
+ * Chunks must fit within a single unfragmented UDP datagram on a
+ * standard Ethernet MTU, including the message header and chunk
+ * digest.  This is a policy decision.
+ */
+#define IMGSHARE_BLKSIZE 1024
+
+/** Maximum image name length */
+#define IMGSHARE_MAX_NAME 64
+
+/** Image sharing message signature ("iPXS") */
+#define IMGSHARE_MAGIC 0x69505853UL
+
+/** Image sharing protocol version */
+#define IMGSHARE_VERSION 1
+
+/** Image sharing message types */
+enum imgshare_msgtype {
+	/** Query for an image by name (multicast) */
+	IMGSHARE_QUERY = 1,
+	/** Positive response to a query */
+	IMGSHARE_FOUND = 2,
+	/** Read an image chunk */
+	IMGSHARE_READ = 3,
+	/** Image chunk data */
+	IMGSHARE_DATA = 4,
+};
+
+/** An image sharing message header */
+struct imgshare_header {
+	/** Signature */
+	uint32_t magic;
+	/** Protocol version */
+	uint8_t version;
+	/** Message type */
+	uint8_t type;
+	/** Reserved (must be zero) */
+	uint16_t reserved;
+} __attribute__ (( packed ));
+
+/** An image query message */
+struct imgshare_query {
+	/** Message header */
+	struct imgshare_header hdr;
+	/** Image name (not NUL-terminated) */
+	char name[0];
+} __attribute__ (( packed ));
+
+/** An image found message */
+struct imgshare_found {
+	/** Message header */
+	struct imgshare_header hdr;
+	/** Total image length */
+	uint64_t len;
+	/** Image name (not NUL-terminated) */
+	char name[0];
+} __attribute__ (( packed ));
+
+/** A chunk read message */
+struct imgshare_read {
+	/** Message header */
+	struct imgshare_header hdr;
+	/** Starting offset */
+	uint64_t offset;
+	/** Requested length */
+	uint32_t len;
+	/** Image name (not NUL-terminated) */
+	char name[0];
+} __attribute__ (( packed ));
+
+/** A chunk data message */
+struct imgshare_data {
+	/** Message header */
+	struct imgshare_header hdr;
+	/** Starting offset */
+	uint64_t offset;
+	/** Chunk digest (SHA-256 over the chunk payload) */
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	/** Chunk payload */
+	uint8_t data[0];
+} __attribute__ (( packed ));
+
+/**
+ * Populate an image sharing message header
+ *
+ * @v hdr		Message header
+ * @v type		Message type
+ */
+static void imgshare_init_header ( struct imgshare_header *hdr,
+				   unsigned int type ) {
+
+	memset ( hdr, 0, sizeof ( *hdr ) );
+	hdr->magic = htonl ( IMGSHARE_MAGIC );
+	hdr->version = IMGSHARE_VERSION;
+	hdr->type = type;
+}
+
+/**
+ * Check an image sharing message header
+ *
+ * @v iobuf		I/O buffer
+ * @ret type		Message type, or negative error
+ */
+static int imgshare_check_header ( struct io_buffer *iobuf ) {
+	struct imgshare_header *hdr = iobuf->data;
+
+	if ( iob_len ( iobuf ) < sizeof ( *hdr ) )
+		return -EINVAL;
+	if ( hdr->magic != htonl ( IMGSHARE_MAGIC ) )
+		return -EINVAL;
+	if ( hdr->version != IMGSHARE_VERSION )
+		return -EPROTONOSUPPORT;
+	return hdr->type;
+}
+
+/**
+ * Calculate chunk digest
+ *
+ * @v data		Chunk payload
+ * @v len		Length of chunk payload
+ * @v out		Digest to fill in
+ */
+static void imgshare_digest ( const void *data, size_t len, uint8_t *out ) {
+	struct digest_algorithm *digest = &sha256_algorithm;
+	uint8_t ctx[SHA256_CTX_SIZE];
+
+	digest_init ( digest, ctx );
+	digest_update ( digest, ctx, data, len );
+	digest_final ( digest, ctx, out );
+}
+
+/****************************************************************************
+ *
+ * Server
+ *
+ */
+
+/** An image sharing server socket */
+struct imgshare_socket {
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Name */
+	const char *name;
+	/** Socket address */
+	union {
+		struct sockaddr sa;
+		struct sockaddr_in sin;
+	} address;
+};
+
+static struct imgshare_socket imgshare_unicast;
+
+/**
+ * Look up a named registered image
+ *
+ * @v name		Image name (not NUL-terminated)
+ * @v len		Length of image name
+ * @ret image		Image, or NULL if not found
+ */
+static struct image * imgshare_image ( const char *name, size_t len ) {
+	char buf[ IMGSHARE_MAX_NAME + 1 /* NUL */ ];
+
+	if ( ( len == 0 ) || ( len > IMGSHARE_MAX_NAME ) )
+		return NULL;
+	memcpy ( buf, name, len );
+	buf[len] = '\0';
+	return find_image ( buf );
+}
+
+/**
+ * Transmit an image found response
+ *
+ * @v image		Image
+ * @v dest		Destination address
+ * @ret rc		Return status code
+ */
+static int imgshare_tx_found ( struct image *image, struct sockaddr *dest ) {
+	struct xfer_metadata meta;
+	struct io_buffer *iobuf;
+	struct imgshare_found *found;
+	size_t name_len = strlen ( image->name );
+
+	/* Allocate I/O buffer */
+	iobuf = xfer_alloc_iob ( &imgshare_unicast.xfer,
+				 ( sizeof ( *found ) + name_len ) );
+	if ( ! iobuf )
+		return -ENOMEM;
+
+	/* Construct response */
+	found = iob_put ( iobuf, sizeof ( *found ) );
+	imgshare_init_header ( &found->hdr, IMGSHARE_FOUND );
+	found->len = cpu_to_be64 ( image->len );
+	memcpy ( iob_put ( iobuf, name_len ), image->name, name_len );
+
+	/* Transmit response */
+	memset ( &meta, 0, sizeof ( meta ) );
+	meta.dest = dest;
+	return xfer_deliver ( &imgshare_unicast.xfer, iobuf, &meta );
+}
+
+/**
+ * Transmit an image chunk
+ *
+ * @v image		Image
+ * @v offset		Starting offset
+ * @v len		Requested length
+ * @v dest		Destination address
+ * @ret rc		Return status code
+ */
+static int imgshare_tx_data ( struct image *image, uint64_t offset,
+			      size_t len, struct sockaddr *dest ) {
+	struct xfer_metadata meta;
+	struct io_buffer *iobuf;
+	struct imgshare_data *data;
+	void *payload;
+
+	/* Clamp chunk to the image and the protocol chunk length */
+	if ( offset >= image->len )
+		return -EINVAL;
+	if ( len > IMGSHARE_BLKSIZE )
+		len = IMGSHARE_BLKSIZE;
+	if ( len > ( image->len - offset ) )
+		len = ( image->len - offset );
+
+	/* Allocate I/O buffer */
+	iobuf = xfer_alloc_iob ( &imgshare_unicast.xfer,
+				 ( sizeof ( *data ) + len ) );
+	if ( ! iobuf )
+		return -ENOMEM;
+
+	/* Construct response */
+	data = iob_put ( iobuf, sizeof ( *data ) );
+	imgshare_init_header ( &data->hdr, IMGSHARE_DATA );
+	data->offset = cpu_to_be64 ( offset );
+	payload = iob_put ( iobuf, len );
+	copy_from_user ( payload, image->data, offset, len );
+	imgshare_digest ( payload, len, data->digest );
+
+	/* Transmit response */
+	memset ( &meta, 0, sizeof ( meta ) );
+	meta.dest = dest;
+	return xfer_deliver ( &imgshare_unicast.xfer, iobuf, &meta );
+}
+
+/**
+ * Handle a received image sharing request
+ *
+ * @v socket		Image sharing server socket
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int imgshare_socket_rx ( struct imgshare_socket *socket,
+				struct io_buffer *iobuf,
+				struct xfer_metadata *meta ) {
+	struct imgshare_query *query;
+	struct imgshare_read *read;
+	struct image *image;
+	int type;
+	int rc;
+
+	/* Ignore requests with no identifiable source */
+	if ( ! meta->src ) {
+		rc = -EINVAL;
+		goto done;
+	}
+
+	/* Check and identify message type */
+	if ( ( type = imgshare_check_header ( iobuf ) ) < 0 ) {
+		rc = type;
+		goto done;
+	}
+
+	/* Handle message */
+	switch ( type ) {
+	case IMGSHARE_QUERY:
+		query = iobuf->data;
+		image = imgshare_image ( query->name,
+					 ( iob_len ( iobuf ) -
+					   sizeof ( *query ) ) );
+		if ( ! image ) {
+			/* Not an error: we simply do not answer
+			 * queries for images that we do not hold.
+			 */
+			rc = 0;
+			goto done;
+		}
+		DBGC ( socket, "IMGSHARE %s answering query for \"%s\"\n",
+		       socket->name, image->name );
+		rc = imgshare_tx_found ( image, meta->src );
+		break;
+	case IMGSHARE_READ:
+		if ( iob_len ( iobuf ) < sizeof ( *read ) ) {
+			rc = -EINVAL;
+			goto done;
+		}
+		read = iobuf->data;
+		image = imgshare_image ( read->name,
+					 ( iob_len ( iobuf ) -
+					   sizeof ( *read ) ) );
+		if ( ! image ) {
+			rc = -ENOENT;
+			goto done;
+		}
+		rc = imgshare_tx_data ( image, be64_to_cpu ( read->offset ),
+					ntohl ( read->len ), meta->src );
+		break;
+	default:
+		/* Ignore response messages arriving at the server */
+		rc = 0;
+		break;
+	}
+
+ done:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/** Image sharing server socket interface operations */
+static struct interface_operation imgshare_socket_operations[] = {
+	INTF_OP ( xfer_deliver, struct imgshare_socket *, imgshare_socket_rx ),
+};
+
+/** Image sharing server socket interface descriptor */
+static struct interface_descriptor imgshare_socket_desc =
+	INTF_DESC ( struct imgshare_socket, xfer, imgshare_socket_operations );
+
+/** Image sharing unicast server socket
+ *
+ * This socket binds to an ephemeral port: clients learn the serving
+ * peer's address and port from the source of the response to their
+ * multicast query.
+ */
+static struct imgshare_socket imgshare_unicast = {
+	.name = "unicast",
+	.address = {
+		.sin = {
+			.sin_family = AF_INET,
+		},
+	},
+	.xfer = INTF_INIT ( imgshare_socket_desc ),
+};
+
+/** Image sharing multicast server socket */
+static struct imgshare_socket imgshare_multicast = {
+	.name = "multicast",
+	.address = {
+		.sin = {
+			.sin_family = AF_INET,
+			.sin_port = htons ( IMGSHARE_PORT ),
+			.sin_addr.s_addr = htonl ( IMGSHARE_MULTICAST_IP ),
+		},
+	},
+	.xfer = INTF_INIT ( imgshare_socket_desc ),
+};
+
+/**
+ * Start serving registered images to peers
+ *
+ * @ret rc		Return status code
+ *
+ * Queries arrive on the multicast socket and chunk reads on the
+ * unicast socket; all responses are sent from the unicast socket, so
+ * that clients can identify the serving peer from the response source
+ * address.
+ */
+int imgshare_serve ( void ) {
+	static int serving;
+	struct net_device *netdev;
+	struct in_addr group = { htonl ( IMGSHARE_MULTICAST_IP ) };
+	int rc;
+
+	/* Do nothing if already serving */
+	if ( serving )
+		return 0;
+
+	/* Open unicast socket */
+	if ( ( rc = xfer_open_socket ( &imgshare_unicast.xfer, SOCK_DGRAM,
+				       &imgshare_unicast.address.sa,
+				       &imgshare_unicast.address.sa ) ) != 0 ) {
+		DBGC ( &imgshare_unicast, "IMGSHARE could not open unicast "
+		       "socket: %s\n", strerror ( rc ) );
+		goto err_unicast;
+	}
+
+	/* Open multicast socket */
+	if ( ( rc = xfer_open_socket ( &imgshare_multicast.xfer, SOCK_DGRAM,
+				       &imgshare_multicast.address.sa,
+				       &imgshare_multicast.address.sa ) ) !=0 ){
+		DBGC ( &imgshare_multicast, "IMGSHARE could not open "
+		       "multicast socket: %s\n", strerror ( rc ) );
+		goto err_multicast;
+	}
+
+	/* Join the discovery group on all open network devices.
+	 * Failure is nonfatal: reception on the local link will still
+	 * work.
+	 */
+	for_each_netdev ( netdev ) {
+		if ( netdev_is_open ( netdev ) )
+			igmp_join ( netdev, group );
+	}
+
+	serving = 1;
+	return 0;
+
+ err_multicast:
+	intf_restart ( &imgshare_unicast.xfer, rc );
+ err_unicast:
+	return rc;
+}
+
+/****************************************************************************
+ *
+ * Client
+ *
+ */
+
+/** An image sharing download */
+struct imgshare_request {
+	/** Reference counter */
+	struct refcnt refcnt;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Socket interface */
+	struct interface socket;
+	/** Retry timer */
+	struct retry_timer timer;
+
+	/** Image name */
+	char *name;
+	/** Serving peer has been found */
+	int found;
+	/** Serving peer address */
+	struct sockaddr_tcpip server;
+	/** Total image length */
+	uint64_t len;
+	/** Next expected offset */
+	uint64_t offset;
+};
+
+/**
+ * Free image sharing download
+ *
+ * @v refcnt		Reference counter
+ */
+static void imgshare_free ( struct refcnt *refcnt ) {
+	struct imgshare_request *imgshare =
+		container_of ( refcnt, struct imgshare_request, refcnt );
+
+	free ( imgshare->name );
+	free ( imgshare );
+}
+
+/**
+ * Mark image sharing download as complete
+ *
+ * @v imgshare		Image sharing download
+ * @v rc		Return status code
+ */
+static void imgshare_done ( struct imgshare_request *imgshare, int rc ) {
+
+	DBGC ( imgshare, "IMGSHARE %p finished with status %s\n",
+	       imgshare, strerror ( rc ) );
+
+	/* Stop timer */
+	stop_timer ( &imgshare->timer );
+
+	/* Shut down interfaces */
+	intf_shutdown ( &imgshare->socket, rc );
+	intf_shutdown ( &imgshare->xfer, rc );
+}
+
+/**
+ * Transmit an image query
+ *
+ * @v imgshare		Image sharing download
+ * @ret rc		Return status code
+ */
+static int imgshare_tx_query ( struct imgshare_request *imgshare ) {
+	size_t name_len = strlen ( imgshare->name );
+	uint8_t buf[ sizeof ( struct imgshare_query ) + name_len ];
+	struct imgshare_query *query = ( ( void * ) buf );
+
+	/* Construct query, sent to the socket's default (multicast)
+	 * destination.
+	 */
+	imgshare_init_header ( &query->hdr, IMGSHARE_QUERY );
+	memcpy ( query->name, imgshare->name, name_len );
+	return xfer_deliver_raw ( &imgshare->socket, buf, sizeof ( buf ) );
+}
+
+/**
+ * Transmit a chunk read request
+ *
+ * @v imgshare		Image sharing download
+ * @ret rc		Return status code
+ */
+static int imgshare_tx_read ( struct imgshare_request *imgshare ) {
+	size_t name_len = strlen ( imgshare->name );
+	uint8_t buf[ sizeof ( struct imgshare_read ) + name_len ];
+	struct imgshare_read *read = ( ( void * ) buf );
+	struct xfer_metadata meta;
+
+	/* Construct read request */
+	imgshare_init_header ( &read->hdr, IMGSHARE_READ );
+	read->offset = cpu_to_be64 ( imgshare->offset );
+	read->len = htonl ( IMGSHARE_BLKSIZE );
+	memcpy ( read->name, imgshare->name, name_len );
+
+	/* Transmit to the serving peer */
+	memset ( &meta, 0, sizeof ( meta ) );
+	meta.dest = ( ( struct sockaddr * ) &imgshare->server );
+	return xfer_deliver_raw_meta ( &imgshare->socket, buf,
+				       sizeof ( buf ), &meta );
+}
+
+/**
+ * Handle an image found response
+ *
+ * @v imgshare		Image sharing download
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int imgshare_rx_found ( struct imgshare_request *imgshare,
+			       struct io_buffer *iobuf,
+			       struct xfer_metadata *meta ) {
+	struct imgshare_found *found = iobuf->data;
+	size_t name_len = strlen ( imgshare->name );
+	int rc;
+
+	/* Sanity checks */
+	if ( iob_len ( iobuf ) < ( sizeof ( *found ) + name_len ) )
+		return -EINVAL;
+	if ( memcmp ( found->name, imgshare->name, name_len ) != 0 )
+		return -EINVAL;
+	if ( ! meta->src )
+		return -EINVAL;
+
+	/* Ignore duplicate responses: the first responding peer wins */
+	if ( imgshare->found )
+		return 0;
+
+	/* Record serving peer and image length */
+	memcpy ( &imgshare->server, meta->src, sizeof ( imgshare->server ) );
+	imgshare->found = 1;
+	imgshare->len = be64_to_cpu ( found->len );
+	DBGC ( imgshare, "IMGSHARE %p found \"%s\" (%lld bytes)\n", imgshare,
+	       imgshare->name, ( ( unsigned long long ) imgshare->len ) );
+
+	/* Notify recipient of the overall length */
+	if ( ( rc = xfer_seek ( &imgshare->xfer, imgshare->len ) ) != 0 )
+		return rc;
+	if ( ( rc = xfer_seek ( &imgshare->xfer, 0 ) ) != 0 )
+		return rc;
+
+	/* Handle zero-length images */
+	if ( imgshare->len == 0 ) {
+		imgshare_done ( imgshare, 0 );
+		return 0;
+	}
+
+	/* Request the first chunk */
+	if ( ( rc = imgshare_tx_read ( imgshare ) ) != 0 )
+		return rc;
+	stop_timer ( &imgshare->timer );
+	start_timer ( &imgshare->timer );
+
+	return 0;
+}
+
+/**
+ * Handle a received image chunk
+ *
+ * @v imgshare		Image sharing download
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ */
+static int imgshare_rx_data ( struct imgshare_request *imgshare,
+			      struct io_buffer *iobuf ) {
+	struct imgshare_data *data = iobuf->data;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	struct xfer_metadata meta;
+	uint64_t offset;
+	size_t len;
+	int rc;
+
+	/* Sanity checks */
+	if ( iob_len ( iobuf ) < sizeof ( *data ) ) {
+		rc = -EINVAL;
+		goto discard;
+	}
+	offset = be64_to_cpu ( data->offset );
+	len = ( iob_len ( iobuf ) - sizeof ( *data ) );
+	if ( len == 0 ) {
+		rc = -EINVAL;
+		goto discard;
+	}
+
+	/* Ignore duplicated or reordered chunks */
+	if ( offset != imgshare->offset ) {
+		rc = 0;
+		goto discard;
+	}
+
+	/* Verify chunk digest */
+	imgshare_digest ( data->data, len, digest );
+	if ( memcmp ( digest, data->digest, sizeof ( digest ) ) != 0 ) {
+		DBGC ( imgshare, "IMGSHARE %p bad digest at offset %lld\n",
+		       imgshare, ( ( unsigned long long ) offset ) );
+		rc = -EINVAL;
+		goto discard;
+	}
+
+	/* Strip header and deliver chunk */
+	iob_pull ( iobuf, sizeof ( *data ) );
+	memset ( &meta, 0, sizeof ( meta ) );
+	meta.flags = XFER_FL_ABS_OFFSET;
+	meta.offset = offset;
+	if ( ( rc = xfer_deliver ( &imgshare->xfer, iob_disown ( iobuf ),
+				   &meta ) ) != 0 )
+		return rc;
+	imgshare->offset = ( offset + len );
+
+	/* Complete download, or request the next chunk */
+	if ( imgshare->offset >= imgshare->len ) {
+		imgshare_done ( imgshare, 0 );
+		return 0;
+	}
+	if ( ( rc = imgshare_tx_read ( imgshare ) ) != 0 )
+		return rc;
+	stop_timer ( &imgshare->timer );
+	start_timer ( &imgshare->timer );
+
+	return 0;
+
+ discard:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Handle received data
+ *
+ * @v imgshare		Image sharing download
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int imgshare_socket_deliver ( struct imgshare_request *imgshare,
+				     struct io_buffer *iobuf,
+				     struct xfer_metadata *meta ) {
+	int type;
+	int rc;
+
+	/* Check and identify message type */
+	if ( ( type = imgshare_check_header ( iobuf ) ) < 0 ) {
+		rc = type;
+		goto done;
+	}
+
+	/* Handle message */
+	switch ( type ) {
+	case IMGSHARE_FOUND:
+		rc = imgshare_rx_found ( imgshare, iobuf, meta );
+		break;
+	case IMGSHARE_DATA:
+		rc = imgshare_rx_data ( imgshare, iob_disown ( iobuf ) );
+		break;
+	default:
+		rc = -EINVAL;
+		break;
+	}
+
+ done:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Handle retry timer expiry
+ *
+ * @v timer		Retry timer
+ * @v over		Failure indicator
+ */
+static void imgshare_timer_expired ( struct retry_timer *timer, int over ) {
+	struct imgshare_request *imgshare =
+		container_of ( timer, struct imgshare_request, timer );
+
+	/* Give up if the timer has expired excessively */
+	if ( over ) {
+		imgshare_done ( imgshare, -ETIMEDOUT );
+		return;
+	}
+
+	/* Retransmit query or current chunk read */
+	start_timer ( timer );
+	if ( imgshare->found ) {
+		imgshare_tx_read ( imgshare );
+	} else {
+		imgshare_tx_query ( imgshare );
+	}
+}
+
+/** Image sharing socket interface operations */
+static struct interface_operation imgshare_request_socket_operations[] = {
+	INTF_OP ( xfer_deliver, struct imgshare_request *,
+		  imgshare_socket_deliver ),
+	INTF_OP ( intf_close, struct imgshare_request *, imgshare_done ),
+};
+
+/** Image sharing socket interface descriptor */
+static struct interface_descriptor imgshare_request_socket_desc =
+	INTF_DESC ( struct imgshare_request, socket,
+		    imgshare_request_socket_operations );
+
+/** Image sharing data transfer interface operations */
+static struct interface_operation imgshare_xfer_operations[] = {
+	INTF_OP ( intf_close, struct imgshare_request *, imgshare_done ),
+};
+
+/** Image sharing data transfer interface descriptor */
+static struct interface_descriptor imgshare_xfer_desc =
+	INTF_DESC ( struct imgshare_request, xfer, imgshare_xfer_operations );
+
+/**
+ * Initiate an image sharing download
+ *
+ * @v xfer		Data transfer interface
+ * @v uri		Uniform Resource Identifier
+ * @ret rc		Return status code
+ */
+static int imgshare_open ( struct interface *xfer, struct uri *uri ) {
+	static const struct sockaddr_in multicast = {
+		.sin_family = AF_INET,
+		.sin_port = htons ( IMGSHARE_PORT ),
+		.sin_addr = { htonl ( IMGSHARE_MULTICAST_IP ) },
+	};
+	struct imgshare_request *imgshare;
+	const char *name;
+	int rc;
+
+	/* Identify image name */
+	name = ( uri->opaque ? uri->opaque : uri->path );
+	if ( ( ! name ) || ( ! name[0] ) ||
+	     ( strlen ( name ) > IMGSHARE_MAX_NAME ) )
+		return -EINVAL;
+
+	/* Allocate and initialise structure */
+	imgshare = zalloc ( sizeof ( *imgshare ) );
+	if ( ! imgshare )
+		return -ENOMEM;
+	ref_init ( &imgshare->refcnt, imgshare_free );
+	intf_init ( &imgshare->xfer, &imgshare_xfer_desc, &imgshare->refcnt );
+	intf_init ( &imgshare->socket, &imgshare_request_socket_desc,
+		    &imgshare->refcnt );
+	timer_init ( &imgshare->timer, imgshare_timer_expired,
+		     &imgshare->refcnt );
+	imgshare->name = strdup ( name );
+	if ( ! imgshare->name ) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	/* Open socket.  The multicast group is the default
+	 * destination; responses arrive on our ephemeral local port.
+	 */
+	if ( ( rc = xfer_open_socket ( &imgshare->socket, SOCK_DGRAM,
+				       ( struct sockaddr * ) &multicast,
+				       NULL ) ) != 0 ) {
+		DBGC ( imgshare, "IMGSHARE %p could not open socket: %s\n",
+		       imgshare, strerror ( rc ) );
+		goto err;
+	}
+
+	/* Send initial query */
+	DBGC ( imgshare, "IMGSHARE %p querying peers for \"%s\"\n",
+	       imgshare, imgshare->name );
+	start_timer ( &imgshare->timer );
+	imgshare_tx_query ( imgshare );
+
+	/* Attach to parent interface, mortalise self, and return */
+	intf_plug_plug ( &imgshare->xfer, xfer );
+	ref_put ( &imgshare->refcnt );
+	return 0;
+
+ err:
+	imgshare_done ( imgshare, rc );
+	ref_put ( &imgshare->refcnt );
+	return rc;
+}
+
+/** Image sharing URI opener */
+struct uri_opener imgshare_uri_opener __uri_opener = {
+	.scheme = "x-imgshare",
+	.open = imgshare_open,
+};
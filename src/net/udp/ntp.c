@@ -25,6 +25,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
 #include <string.h>
+#include <assert.h>
 #include <errno.h>
 #include <time.h>
 #include <ipxe/malloc.h>
@@ -54,6 +55,19 @@ struct ntp_client {
 	struct interface xfer;
 	/** Retransmission timer */
 	struct retry_timer timer;
+
+	/** Number of samples remaining */
+	unsigned int remaining;
+	/** Originate timestamp of current request */
+	uint32_t originate;
+	/** Time at which current request was sent */
+	unsigned long sent;
+	/** Round trip time of best sample so far */
+	unsigned long best_rtt;
+	/** Clock delta of best sample so far */
+	int32_t best_delta;
+	/** At least one sample has been taken */
+	int sampled;
 };
 
 /**
@@ -90,6 +104,10 @@ static int ntp_request ( struct ntp_client *ntp ) {
 	hdr.transmit.seconds = htonl ( time ( NULL ) + NTP_EPOCH );
 	hdr.transmit.fraction = htonl ( NTP_FRACTION_MAGIC );
 
+	/* Record transmission time, for round trip measurement */
+	ntp->originate = ntohl ( hdr.transmit.seconds );
+	ntp->sent = currticks();
+
 	/* Send request */
 	if ( ( rc = xfer_deliver_raw ( &ntp->xfer, &hdr,
 				       sizeof ( hdr ) ) ) != 0 ) {
@@ -113,6 +131,7 @@ static int ntp_deliver ( struct ntp_client *ntp, struct io_buffer *iobuf,
 			 struct xfer_metadata *meta ) {
 	struct ntp_header *hdr;
 	struct sockaddr_tcpip *st_src;
+	unsigned long rtt;
 	int32_t delta;
 	int rc;
 
@@ -146,6 +165,14 @@ static int ntp_deliver ( struct ntp_client *ntp, struct io_buffer *iobuf,
 		goto ignore;
 	}
 
+	/* Ignore replies to anything other than the current request,
+	 * since their round trip time would be miscounted.
+	 */
+	if ( hdr->originate.seconds != htonl ( ntp->originate ) ) {
+		DBGC ( ntp, "NTP %p ignoring stale reply\n", ntp );
+		goto ignore;
+	}
+
 	/* Check for Kiss-o'-Death packets */
 	if ( ! hdr->stratum ) {
 		DBGC ( ntp, "NTP %p received kiss-o'-death:\n", ntp );
@@ -154,13 +181,33 @@ static int ntp_deliver ( struct ntp_client *ntp, struct io_buffer *iobuf,
 		goto close;
 	}
 
-	/* Calculate clock delta */
+	/* Calculate clock delta and round trip time */
 	delta = ( ntohl ( hdr->receive.seconds ) -
 		  ntohl ( hdr->originate.seconds ) );
-	DBGC ( ntp, "NTP %p delta %d seconds\n", ntp, delta );
+	rtt = ( currticks() - ntp->sent );
+	DBGC ( ntp, "NTP %p delta %d seconds (rtt %ld ticks)\n",
+	       ntp, delta, rtt );
+
+	/* Record sample, if it is the best (lowest round trip time)
+	 * so far.  A low round trip time bounds the error introduced
+	 * by path asymmetry.
+	 */
+	if ( ( ! ntp->sampled ) || ( rtt < ntp->best_rtt ) ) {
+		ntp->sampled = 1;
+		ntp->best_rtt = rtt;
+		ntp->best_delta = delta;
+	}
+
+	/* Send next request in burst, if any samples remain */
+	assert ( ntp->remaining > 0 );
+	if ( --ntp->remaining ) {
+		stop_timer ( &ntp->timer );
+		start_timer_nodelay ( &ntp->timer );
+		goto ignore;
+	}
 
-	/* Adjust system clock */
-	time_adjust ( delta );
+	/* Adjust system clock using the best sample */
+	time_adjust ( ntp->best_delta );
 
 	/* Success */
 	rc = 0;
@@ -214,9 +261,16 @@ static void ntp_expired ( struct retry_timer *timer, int fail ) {
 	struct ntp_client *ntp =
 		container_of ( timer, struct ntp_client, timer );
 
-	/* Shut down client if we have failed */
+	/* Shut down client if we have failed, applying the best
+	 * sample taken so far (if any) rather than discarding it.
+	 */
 	if ( fail ) {
-		ntp_close ( ntp, -ETIMEDOUT );
+		if ( ntp->sampled ) {
+			time_adjust ( ntp->best_delta );
+			ntp_close ( ntp, 0 );
+		} else {
+			ntp_close ( ntp, -ETIMEDOUT );
+		}
 		return;
 	}
 
@@ -251,6 +305,7 @@ int start_ntp ( struct interface *job, const char *hostname ) {
 	intf_init ( &ntp->xfer, &ntp_xfer_desc, &ntp->refcnt );
 	timer_init ( &ntp->timer, ntp_expired, &ntp->refcnt );
 	set_timer_limits ( &ntp->timer, NTP_MIN_TIMEOUT, NTP_MAX_TIMEOUT );
+	ntp->remaining = NTP_BURST_COUNT;
 
 	/* Open socket */
 	memset ( &server, 0, sizeof ( server ) );
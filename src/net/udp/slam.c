@@ -37,6 +37,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/open.h>
 #include <ipxe/uri.h>
 #include <ipxe/tcpip.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/igmp.h>
 #include <ipxe/timer.h>
 #include <ipxe/retry.h>
 
@@ -118,6 +120,18 @@ FEATURE ( FEATURE_PROTOCOL, "SLAM", DHCP_EB_FEATURE_SLAM, 1 );
 /** SLAM slave timeout */
 #define SLAM_SLAVE_TIMEOUT ( 1 * TICKS_PER_SEC )
 
+/** Maximum SLAM slave timeout jitter
+ *
+ * A random delay of up to this length is added to the slave timeout.
+ * When many clients share a single multicast session, this prevents
+ * all of the slave clients from attempting to become the master
+ * client (and so NACKing the server) simultaneously: the first
+ * client's NACK restarts the data stream, which quiets the others.
+ *
+ * This is a policy decision.
+ */
+#define SLAM_SLAVE_JITTER ( TICKS_PER_SEC / 2 )
+
 /** A SLAM request */
 struct slam_request {
 	/** Reference counter */
@@ -129,6 +143,10 @@ struct slam_request {
 	struct interface socket;
 	/** Multicast socket */
 	struct interface mc_socket;
+	/** Network device used for multicast reception */
+	struct net_device *netdev;
+	/** Multicast group address */
+	struct in_addr multicast;
 
 	/** Master client retry timer */
 	struct retry_timer master_timer;
@@ -161,6 +179,10 @@ static void slam_free ( struct refcnt *refcnt ) {
 		container_of ( refcnt, struct slam_request, refcnt );
 
 	bitmap_free ( &slam->bitmap );
+	if ( slam->netdev ) {
+		igmp_leave ( slam->netdev, slam->multicast );
+		netdev_put ( slam->netdev );
+	}
 	free ( slam );
 }
 
@@ -194,6 +216,22 @@ static void slam_finished ( struct slam_request *slam, int rc ) {
 	intf_shutdown ( &slam->xfer, rc );
 }
 
+/**
+ * Start SLAM slave client retry timer
+ *
+ * @v slam		SLAM request
+ *
+ * Starts the slave timer with a randomised expiry time, so that
+ * multiple clients sharing a multicast session do not all NACK the
+ * server at the same moment.
+ */
+static void slam_start_slave_timer ( struct slam_request *slam ) {
+	unsigned long jitter = ( random() % SLAM_SLAVE_JITTER );
+
+	start_timer_fixed ( &slam->slave_timer,
+			    ( SLAM_SLAVE_TIMEOUT + jitter ) );
+}
+
 /****************************************************************************
  *
  * TX datapath
@@ -506,7 +544,7 @@ static int slam_mc_socket_deliver ( struct slam_request *slam,
 	/* Stop the master client timer.  Restart the slave client timer. */
 	stop_timer ( &slam->master_timer );
 	stop_timer ( &slam->slave_timer );
-	start_timer_fixed ( &slam->slave_timer, SLAM_SLAVE_TIMEOUT );
+	slam_start_slave_timer ( slam );
 
 	/* Read and strip packet header */
 	if ( ( rc = slam_pull_header ( slam, iobuf ) ) != 0 )
@@ -702,6 +740,7 @@ static int slam_open ( struct interface *xfer, struct uri *uri ) {
 	struct slam_request *slam;
 	struct sockaddr_tcpip server;
 	struct sockaddr_in multicast;
+	struct net_device *netdev;
 	int rc;
 
 	/* Sanity checks */
@@ -756,8 +795,19 @@ static int slam_open ( struct interface *xfer, struct uri *uri ) {
 		goto err;
 	}
 
+	/* Join multicast group, so that the stream can be delivered
+	 * across multicast routers.  Failure is nonfatal: reception
+	 * on the local link will still work.
+	 */
+	netdev = tcpip_netdev ( ( struct sockaddr_tcpip * ) &multicast );
+	if ( netdev ) {
+		slam->netdev = netdev_get ( netdev );
+		slam->multicast = multicast.sin_addr;
+		igmp_join ( netdev, multicast.sin_addr );
+	}
+
 	/* Start slave retry timer */
-	start_timer_fixed ( &slam->slave_timer, SLAM_SLAVE_TIMEOUT );
+	slam_start_slave_timer ( slam );
 
 	/* Attach to parent interface, mortalise self, and return */
 	intf_plug_plug ( &slam->xfer, xfer );
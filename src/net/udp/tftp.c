@@ -37,6 +37,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/open.h>
 #include <ipxe/uri.h>
 #include <ipxe/tcpip.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/igmp.h>
 #include <ipxe/retry.h>
 #include <ipxe/features.h>
 #include <ipxe/bitmap.h>
@@ -75,6 +77,21 @@ FEATURE ( FEATURE_PROTOCOL, "TFTP", DHCP_EB_FEATURE_TFTP, 1 );
 #define EINVAL_MC_INVALID_PORT __einfo_error ( EINFO_EINVAL_MC_INVALID_PORT )
 #define EINFO_EINVAL_MC_INVALID_PORT __einfo_uniqify \
 	( EINFO_EINVAL, 0x07, "Invalid multicast port" )
+#define EINVAL_WINDOWSIZE __einfo_error ( EINFO_EINVAL_WINDOWSIZE )
+#define EINFO_EINVAL_WINDOWSIZE __einfo_uniqify \
+	( EINFO_EINVAL, 0x08, "Invalid windowsize" )
+
+/** Requested TFTP window size
+ *
+ * This is the window size that we request via the RFC 7440
+ * "windowsize" option.  Since received blocks are delivered
+ * immediately at their absolute offsets (rather than being held in a
+ * reassembly buffer), the window size is limited only by the 16-bit
+ * block number wraparound handling.
+ *
+ * This is a policy decision.
+ */
+#define TFTP_MAX_WINDOWSIZE 64
 
 /**
  * A TFTP request
@@ -93,6 +110,10 @@ struct tftp_request {
 	struct interface socket;
 	/** Multicast transport layer interface */
 	struct interface mc_socket;
+	/** Network device used for multicast reception */
+	struct net_device *mc_netdev;
+	/** Multicast group address */
+	struct in_addr mc_address;
 
 	/** Data block size
 	 *
@@ -108,6 +129,15 @@ struct tftp_request {
 	 * "tsize" option, this value will be zero.
 	 */
 	unsigned long tsize;
+	/** Window size
+	 *
+	 * This is the "windowsize" option negotiated with the TFTP
+	 * server.  (If the TFTP server does not support TFTP options,
+	 * this will default to 1.)
+	 */
+	unsigned int windowsize;
+	/** Number of blocks received since last acknowledgement */
+	unsigned int window;
 	
 	/** Server port
 	 *
@@ -153,11 +183,27 @@ enum {
 	TFTP_FL_RRQ_MULTICAST = 0x0004,
 	/** Perform MTFTP recovery on timeout */
 	TFTP_FL_MTFTP_RECOVERY = 0x0008,
+	/** Request window size option */
+	TFTP_FL_RRQ_WINDOWSIZE = 0x0010,
 };
 
 /** Maximum number of MTFTP open requests before falling back to TFTP */
 #define MTFTP_MAX_TIMEOUTS 3
 
+/**
+ * Leave multicast group, if applicable
+ *
+ * @v tftp		TFTP connection
+ */
+static void tftp_leave_mc ( struct tftp_request *tftp ) {
+
+	if ( tftp->mc_netdev ) {
+		igmp_leave ( tftp->mc_netdev, tftp->mc_address );
+		netdev_put ( tftp->mc_netdev );
+		tftp->mc_netdev = NULL;
+	}
+}
+
 /**
  * Free TFTP request
  *
@@ -167,6 +213,7 @@ static void tftp_free ( struct refcnt *refcnt ) {
 	struct tftp_request *tftp =
 		container_of ( refcnt, struct tftp_request, refcnt );
 
+	tftp_leave_mc ( tftp );
 	uri_put ( tftp->uri );
 	bitmap_free ( &tftp->bitmap );
 	free ( tftp );
@@ -339,7 +386,8 @@ static int tftp_send_rrq ( struct tftp_request *tftp ) {
 	len = ( sizeof ( *rrq ) + strlen ( path ) + 1 /* NUL */
 		+ 5 + 1 /* "octet" + NUL */
 		+ 7 + 1 + 5 + 1 /* "blksize" + NUL + ddddd + NUL */
-		+ 5 + 1 + 1 + 1 /* "tsize" + NUL + "0" + NUL */ 
+		+ 5 + 1 + 1 + 1 /* "tsize" + NUL + "0" + NUL */
+		+ 10 + 1 + 5 + 1 /* "windowsize" + NUL + ddddd + NUL */
 		+ 9 + 1 + 1 /* "multicast" + NUL + NUL */ );
 	iobuf = xfer_alloc_iob ( &tftp->socket, len );
 	if ( ! iobuf )
@@ -361,6 +409,12 @@ static int tftp_send_rrq ( struct tftp_request *tftp ) {
 					    "blksize%c%zd%ctsize%c0",
 					    0, blksize, 0, 0 ) + 1 );
 	}
+	if ( tftp->flags & TFTP_FL_RRQ_WINDOWSIZE ) {
+		iob_put ( iobuf, snprintf ( iobuf->tail,
+					    iob_tailroom ( iobuf ),
+					    "windowsize%c%d", 0,
+					    TFTP_MAX_WINDOWSIZE ) + 1 );
+	}
 	if ( tftp->flags & TFTP_FL_RRQ_MULTICAST ) {
 		iob_put ( iobuf, snprintf ( iobuf->tail,
 					    iob_tailroom ( iobuf ),
@@ -401,6 +455,9 @@ static int tftp_send_ack ( struct tftp_request *tftp ) {
 	ack->opcode = htons ( TFTP_ACK );
 	ack->block = htons ( block );
 
+	/* Restart window */
+	tftp->window = 0;
+
 	/* ACK always goes to the peer recorded from the RRQ response */
 	return xfer_deliver ( &tftp->socket, iobuf, &meta );
 }
@@ -505,6 +562,7 @@ static void tftp_timer_expired ( struct retry_timer *timer, int fail ) {
 
 				/* Close multicast socket */
 				intf_restart ( &tftp->mc_socket, 0 );
+				tftp_leave_mc ( tftp );
 
 				/* Reset retry timer */
 				start_timer_nodelay ( &tftp->timer );
@@ -582,6 +640,28 @@ static int tftp_process_tsize ( struct tftp_request *tftp,
 	return 0;
 }
 
+/**
+ * Process TFTP "windowsize" option
+ *
+ * @v tftp		TFTP connection
+ * @v value		Option value
+ * @ret rc		Return status code
+ */
+static int tftp_process_windowsize ( struct tftp_request *tftp,
+				     const char *value ) {
+	char *end;
+
+	tftp->windowsize = strtoul ( value, &end, 10 );
+	if ( ( *end ) || ( tftp->windowsize < 1 ) ) {
+		DBGC ( tftp, "TFTP %p got invalid windowsize \"%s\"\n",
+		       tftp, value );
+		return -EINVAL_WINDOWSIZE;
+	}
+	DBGC ( tftp, "TFTP %p windowsize=%d\n", tftp, tftp->windowsize );
+
+	return 0;
+}
+
 /**
  * Process TFTP "multicast" option
  *
@@ -669,6 +749,7 @@ struct tftp_option {
 static struct tftp_option tftp_options[] = {
 	{ "blksize", tftp_process_blksize },
 	{ "tsize", tftp_process_tsize },
+	{ "windowsize", tftp_process_windowsize },
 	{ "multicast", tftp_process_multicast },
 	{ NULL, NULL }
 };
@@ -785,6 +866,7 @@ static int tftp_rx_data ( struct tftp_request *tftp,
 			  struct io_buffer *iobuf ) {
 	struct tftp_data *data = iobuf->data;
 	struct xfer_metadata meta;
+	unsigned int expected;
 	unsigned int block;
 	off_t offset;
 	size_t data_len;
@@ -799,7 +881,8 @@ static int tftp_rx_data ( struct tftp_request *tftp,
 	}
 
 	/* Calculate block number */
-	block = ( ( bitmap_first_gap ( &tftp->bitmap ) + 1 ) & ~0xffff );
+	expected = bitmap_first_gap ( &tftp->bitmap );
+	block = ( ( expected + 1 ) & ~0xffff );
 	if ( data->block == 0 && block == 0 ) {
 		DBGC ( tftp, "TFTP %p received data block 0\n", tftp );
 		rc = -EINVAL;
@@ -836,8 +919,16 @@ static int tftp_rx_data ( struct tftp_request *tftp,
 	/* Mark block as received */
 	bitmap_set ( &tftp->bitmap, block );
 
-	/* Acknowledge block */
-	tftp_send_packet ( tftp );
+	/* Acknowledge block, if applicable.  When using a window size
+	 * greater than one, acknowledge only the final block of each
+	 * window, any block received out of order (to trigger
+	 * retransmission from the first gap without waiting for a
+	 * timeout), and the final block of the transfer.
+	 */
+	if ( ( ++tftp->window >= tftp->windowsize ) ||
+	     ( block != expected ) || bitmap_full ( &tftp->bitmap ) ) {
+		tftp_send_packet ( tftp );
+	}
 
 	/* If all blocks have been received, finish. */
 	if ( bitmap_full ( &tftp->bitmap ) )
@@ -1083,6 +1174,7 @@ static int tftp_core_open ( struct interface *xfer, struct uri *uri,
 	timer_init ( &tftp->timer, tftp_timer_expired, &tftp->refcnt );
 	tftp->uri = uri_get ( uri );
 	tftp->blksize = TFTP_DEFAULT_BLKSIZE;
+	tftp->windowsize = 1;
 	tftp->flags = flags;
 
 	/* Open socket */
@@ -1121,7 +1213,8 @@ static int tftp_core_open ( struct interface *xfer, struct uri *uri,
  */
 static int tftp_open ( struct interface *xfer, struct uri *uri ) {
 	return tftp_core_open ( xfer, uri, TFTP_PORT, NULL,
-				TFTP_FL_RRQ_SIZES );
+				( TFTP_FL_RRQ_SIZES |
+				  TFTP_FL_RRQ_WINDOWSIZE ) );
 
 }
 
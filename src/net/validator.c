@@ -35,6 +35,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/xferbuf.h>
 #include <ipxe/process.h>
 #include <ipxe/x509.h>
+#include <ipxe/certstore.h>
 #include <ipxe/settings.h>
 #include <ipxe/dhcp.h>
 #include <ipxe/base64.h>
@@ -75,8 +76,18 @@ struct validator {
 
 	/** X.509 certificate chain */
 	struct x509_chain *chain;
+	/** Downloaded cross-signing certificates (if any)
+	 *
+	 * Retained so that certificates used in a successful
+	 * validation can be saved to non-volatile storage.
+	 */
+	struct x509_chain *downloaded;
 	/** OCSP check */
 	struct ocsp_check *ocsp;
+	/** Stapled OCSP response (if any) */
+	void *staple;
+	/** Length of stapled OCSP response */
+	size_t staple_len;
 	/** Data buffer */
 	struct xfer_buffer buffer;
 
@@ -115,7 +126,10 @@ static void validator_free ( struct refcnt *refcnt ) {
 	DBGC2 ( validator, "VALIDATOR %p \"%s\" freed\n",
 		validator, validator_name ( validator ) );
 	x509_chain_put ( validator->chain );
+	if ( validator->downloaded )
+		x509_chain_put ( validator->downloaded );
 	ocsp_put ( validator->ocsp );
+	free ( validator->staple );
 	xferbuf_free ( &validator->buffer );
 	free ( validator );
 }
@@ -127,6 +141,19 @@ static void validator_free ( struct refcnt *refcnt ) {
  * @v rc		Reason for finishing
  */
 static void validator_finished ( struct validator *validator, int rc ) {
+	struct x509_link *link;
+
+	/* On successful validation, save any downloaded
+	 * cross-signing certificates that were successfully
+	 * validated, so that future boots can skip the download.
+	 */
+	if ( ( rc == 0 ) && validator->downloaded ) {
+		list_for_each_entry ( link, &validator->downloaded->links,
+				      list ) {
+			if ( x509_is_valid ( link->cert ) )
+				certstore_save ( link->cert );
+		}
+	}
 
 	/* Remove process */
 	process_del ( &validator->process );
@@ -203,6 +230,7 @@ static int validator_append ( struct validator *validator,
 	struct x509_chain *certs;
 	struct x509_certificate *cert;
 	struct x509_certificate *last;
+	struct x509_link *link;
 	int rc;
 
 	/* Allocate certificate list */
@@ -263,6 +291,16 @@ static int validator_append ( struct validator *validator,
 		goto err_no_progress;
 	}
 
+	/* Record downloaded certificates, so that they may be saved
+	 * to non-volatile storage if validation succeeds.
+	 */
+	if ( ! validator->downloaded )
+		validator->downloaded = x509_alloc_chain();
+	if ( validator->downloaded ) {
+		list_for_each_entry ( link, &certs->links, list )
+			x509_append ( validator->downloaded, link->cert );
+	}
+
 	/* Drop reference to certificate list */
 	x509_chain_put ( certs );
 
@@ -426,6 +464,36 @@ static int validator_start_ocsp ( struct validator *validator,
 		return rc;
 	}
 
+	/* Try any stapled OCSP response first, avoiding the round
+	 * trip to the OCSP responder.
+	 */
+	if ( validator->staple ) {
+		if ( ( rc = validator_ocsp_validate ( validator,
+						      validator->staple,
+						      validator->staple_len )
+		       ) == 0 ) {
+			DBGC ( validator, "VALIDATOR %p \"%s\" used stapled "
+			       "OCSP response\n", validator,
+			       validator_name ( validator ) );
+			/* Resume validation process */
+			process_add ( &validator->process );
+			return 0;
+		}
+		/* Stapled response did not apply to this certificate;
+		 * recreate the check and fall back to contacting the
+		 * responder.
+		 */
+		ocsp_put ( validator->ocsp );
+		validator->ocsp = NULL;
+		if ( ( rc = ocsp_check ( cert, issuer,
+					 &validator->ocsp ) ) != 0 ) {
+			DBGC ( validator, "VALIDATOR %p \"%s\" could not "
+			       "recreate OCSP check: %s\n", validator,
+			       validator_name ( validator ), strerror ( rc ) );
+			return rc;
+		}
+	}
+
 	/* Set completion handler */
 	validator->action = &validator_ocsp;
 	validator->cert = cert;
@@ -621,9 +689,12 @@ static struct process_descriptor validator_process_desc =
  *
  * @v job		Job control interface
  * @v chain		X.509 certificate chain
+ * @v staple		Stapled OCSP response (if any)
+ * @v staple_len	Length of stapled OCSP response
  * @ret rc		Return status code
  */
-int create_validator ( struct interface *job, struct x509_chain *chain ) {
+int create_validator ( struct interface *job, struct x509_chain *chain,
+		       const void *staple, size_t staple_len ) {
 	struct validator *validator;
 	int rc;
 
@@ -649,6 +720,17 @@ int create_validator ( struct interface *job, struct x509_chain *chain ) {
 	validator->chain = x509_chain_get ( chain );
 	xferbuf_malloc_init ( &validator->buffer );
 
+	/* Record stapled OCSP response, if any */
+	if ( staple_len ) {
+		validator->staple = malloc ( staple_len );
+		if ( ! validator->staple ) {
+			rc = -ENOMEM;
+			goto err_staple;
+		}
+		memcpy ( validator->staple, staple, staple_len );
+		validator->staple_len = staple_len;
+	}
+
 	/* Attach parent interface, mortalise self, and return */
 	intf_plug_plug ( &validator->job, job );
 	ref_put ( &validator->refcnt );
@@ -656,6 +738,7 @@ int create_validator ( struct interface *job, struct x509_chain *chain ) {
 		validator, validator_name ( validator ), validator->chain );
 	return 0;
 
+ err_staple:
 	validator_finished ( validator, rc );
 	ref_put ( &validator->refcnt );
  err_alloc:
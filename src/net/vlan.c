@@ -192,6 +192,15 @@ static void vlan_sync ( struct net_device *netdev ) {
 	}
 }
 
+/** Most recently used VLAN device
+ *
+ * The trunk device receives every packet on a trunked link, and
+ * almost all traffic belongs to a single boot VLAN, so a one-entry
+ * cache avoids walking the network device list for each received
+ * packet.
+ */
+static struct net_device *vlan_cache;
+
 /**
  * Identify VLAN device
  *
@@ -204,12 +213,21 @@ static struct net_device * vlan_find ( struct net_device *trunk,
 	struct net_device *netdev;
 	struct vlan_device *vlan;
 
+	/* Check most recently used VLAN device */
+	if ( vlan_cache ) {
+		vlan = vlan_cache->priv;
+		if ( ( vlan->trunk == trunk ) && ( vlan->tag == tag ) )
+			return vlan_cache;
+	}
+
 	for_each_netdev ( netdev ) {
 		if ( netdev->op != &vlan_operations )
 			continue;
 		vlan = netdev->priv;
-		if ( ( vlan->trunk == trunk ) && ( vlan->tag == tag ) )
+		if ( ( vlan->trunk == trunk ) && ( vlan->tag == tag ) ) {
+			vlan_cache = netdev;
 			return netdev;
+		}
 	}
 	return NULL;
 }
@@ -438,6 +456,10 @@ int vlan_destroy ( struct net_device *netdev ) {
 
 	DBGC ( netdev, "VLAN %s destroyed\n", netdev->name );
 
+	/* Invalidate cached VLAN device, if applicable */
+	if ( vlan_cache == netdev )
+		vlan_cache = NULL;
+
 	/* Remove VLAN device */
 	unregister_netdev ( netdev );
 	trunk = vlan->trunk;
@@ -37,6 +37,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/sha256.h>
 #include <ipxe/x509.h>
 #include <ipxe/uaccess.h>
+#include <ipxe/image.h>
 #include <ipxe/cms.h>
 #include <ipxe/test.h>
 
@@ -1375,10 +1376,14 @@ static void cms_verify_okx ( struct cms_test_signature *sgn,
 			     time_t time, struct x509_chain *store,
 			     struct x509_root *root, const char *file,
 			     unsigned int line ) {
+	struct image image;
 
+	memset ( &image, 0, sizeof ( image ) );
+	image.data = virt_to_user ( code->data );
+	image.len = code->len;
 	x509_invalidate_chain ( sgn->sig->certificates );
-	okx ( cms_verify ( sgn->sig, virt_to_user ( code->data ), code->len,
-			   name, time, store, root ) == 0, file, line );
+	okx ( cms_verify ( sgn->sig, &image, name, time, store,
+			   root ) == 0, file, line );
 }
 #define cms_verify_ok( sgn, code, name, time, store, root )		\
 	cms_verify_okx ( sgn, code, name, time, store, root,		\
@@ -1401,10 +1406,14 @@ static void cms_verify_fail_okx ( struct cms_test_signature *sgn,
 				  time_t time, struct x509_chain *store,
 				  struct x509_root *root, const char *file,
 				  unsigned int line ) {
+	struct image image;
 
+	memset ( &image, 0, sizeof ( image ) );
+	image.data = virt_to_user ( code->data );
+	image.len = code->len;
 	x509_invalidate_chain ( sgn->sig->certificates );
-	okx ( cms_verify ( sgn->sig, virt_to_user ( code->data ), code->len,
-			   name, time, store, root ) != 0, file, line );
+	okx ( cms_verify ( sgn->sig, &image, name, time, store,
+			   root ) != 0, file, line );
 }
 #define cms_verify_fail_ok( sgn, code, name, time, store, root )	\
 	cms_verify_fail_okx ( sgn, code, name, time, store, root,	\
@@ -110,6 +110,9 @@ void digest_frag_okx ( struct digest_test *test,
  */
 void digest_okx ( struct digest_test *test, const char *file,
 		  unsigned int line ) {
+	struct digest_multi_buffer buffers[3];
+	uint8_t out[ sizeof ( buffers ) / sizeof ( buffers[0] ) ]
+		   [test->digest->digestsize];
 	unsigned int i;
 
 	/* Test with a single pass */
@@ -120,6 +123,21 @@ void digest_okx ( struct digest_test *test, const char *file,
 			    sizeof ( digest_test_fragments[0] ) ) ; i++ ) {
 		digest_frag_okx ( test, &digest_test_fragments[i], file, line );
 	}
+
+	/* Test as multiple independent buffers */
+	for ( i = 0 ; i < ( sizeof ( buffers ) /
+			    sizeof ( buffers[0] ) ) ; i++ ) {
+		buffers[i].data = test->data;
+		buffers[i].len = test->len;
+		buffers[i].out = out[i];
+	}
+	digest_multi ( test->digest, buffers,
+		       ( sizeof ( buffers ) / sizeof ( buffers[0] ) ) );
+	for ( i = 0 ; i < ( sizeof ( buffers ) /
+			    sizeof ( buffers[0] ) ) ; i++ ) {
+		okx ( memcmp ( test->expected, out[i],
+			       test->digest->digestsize ) == 0, file, line );
+	}
 }
 
 /**
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2015 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * HMAC tests
+ *
+ * These test vectors are provided by RFC 2202 (for SHA-1) and RFC
+ * 4231 (for SHA-256).  Each vector is checked using both the
+ * incremental API and the precomputed pad digest context API.
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <string.h>
+#include <assert.h>
+#include <ipxe/hmac.h>
+#include <ipxe/sha1.h>
+#include <ipxe/sha256.h>
+#include <ipxe/test.h>
+
+/** Define inline data */
+#define DATA(...) { __VA_ARGS__ }
+
+/** An HMAC test */
+struct hmac_test {
+	/** Digest algorithm */
+	struct digest_algorithm *digest;
+	/** Key */
+	const void *key;
+	/** Length of key */
+	size_t key_len;
+	/** Data */
+	const void *data;
+	/** Length of data */
+	size_t len;
+	/** Expected HMAC */
+	const void *expected;
+	/** Length of expected HMAC */
+	size_t expected_len;
+};
+
+/**
+ * Define an HMAC test
+ *
+ * @v name		Test name
+ * @v DIGEST		Digest algorithm
+ * @v KEY		Key
+ * @v DATA		Data
+ * @v EXPECTED		Expected HMAC
+ * @ret test		HMAC test
+ */
+#define HMAC_TEST( name, DIGEST, KEY, DATA, EXPECTED )			\
+	static const uint8_t name ## _key[] = KEY;			\
+	static const uint8_t name ## _data[] = DATA;			\
+	static const uint8_t name ## _expected[] = EXPECTED;		\
+	static struct hmac_test name = {				\
+		.digest = DIGEST,					\
+		.key = name ## _key,					\
+		.key_len = sizeof ( name ## _key ),			\
+		.data = name ## _data,					\
+		.len = sizeof ( name ## _data ),			\
+		.expected = name ## _expected,				\
+		.expected_len = sizeof ( name ## _expected ),		\
+	};
+
+/**
+ * Report an HMAC test result
+ *
+ * @v test		HMAC test
+ */
+#define hmac_ok( test ) do {						\
+	struct digest_algorithm *digest = (test)->digest;		\
+	uint8_t ctx[digest->ctxsize];					\
+	uint8_t ipad_ctx[digest->ctxsize];				\
+	uint8_t opad_ctx[digest->ctxsize];				\
+	uint8_t key[ (test)->key_len + digest->digestsize ];		\
+	size_t key_len = (test)->key_len;				\
+	uint8_t hmac[digest->digestsize];				\
+									\
+	assert ( (test)->expected_len == sizeof ( hmac ) );		\
+									\
+	/* Check incremental API */					\
+	memcpy ( key, (test)->key, key_len );				\
+	hmac_init ( digest, ctx, key, &key_len );			\
+	hmac_update ( digest, ctx, (test)->data, (test)->len );		\
+	hmac_final ( digest, ctx, key, &key_len, hmac );		\
+	ok ( memcmp ( hmac, (test)->expected, sizeof ( hmac ) ) == 0 );	\
+									\
+	/* Check precomputed pad digest context API */			\
+	hmac_precompute ( digest, (test)->key, (test)->key_len,		\
+			  ipad_ctx, opad_ctx );				\
+	hmac_resume ( digest, ctx, ipad_ctx );				\
+	hmac_update ( digest, ctx, (test)->data, (test)->len );		\
+	hmac_final_precomputed ( digest, ctx, opad_ctx, hmac );		\
+	ok ( memcmp ( hmac, (test)->expected, sizeof ( hmac ) ) == 0 );	\
+	} while ( 0 )
+
+/* RFC 2202 test case 1 */
+HMAC_TEST ( sha1_hi_there_test, &sha1_algorithm,
+	    DATA ( 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+		   0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+		   0x0b, 0x0b ),
+	    DATA ( 'H', 'i', ' ', 'T', 'h', 'e', 'r', 'e' ),
+	    DATA ( 0xb6, 0x17, 0x31, 0x86, 0x55, 0x05, 0x72, 0x64, 0xe2,
+		   0x8b, 0xc0, 0xb6, 0xfb, 0x37, 0x8c, 0x8e, 0xf1, 0x46,
+		   0xbe, 0x00 ) );
+
+/* RFC 2202 test case 6 (key larger than block size) */
+HMAC_TEST ( sha1_large_key_test, &sha1_algorithm,
+	    DATA ( 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		   0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		   0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		   0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		   0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		   0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		   0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		   0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		   0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa ),
+	    DATA ( 'T', 'e', 's', 't', ' ', 'U', 's', 'i', 'n', 'g', ' ',
+		   'L', 'a', 'r', 'g', 'e', 'r', ' ', 'T', 'h', 'a', 'n',
+		   ' ', 'B', 'l', 'o', 'c', 'k', '-', 'S', 'i', 'z', 'e',
+		   ' ', 'K', 'e', 'y', ' ', '-', ' ', 'H', 'a', 's', 'h',
+		   ' ', 'K', 'e', 'y', ' ', 'F', 'i', 'r', 's', 't' ),
+	    DATA ( 0xaa, 0x4a, 0xe5, 0xe1, 0x52, 0x72, 0xd0, 0x0e, 0x95,
+		   0x70, 0x56, 0x37, 0xce, 0x8a, 0x3b, 0x55, 0xed, 0x40,
+		   0x21, 0x12 ) );
+
+/* RFC 4231 test case 1 */
+HMAC_TEST ( sha256_hi_there_test, &sha256_algorithm,
+	    DATA ( 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+		   0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+		   0x0b, 0x0b ),
+	    DATA ( 'H', 'i', ' ', 'T', 'h', 'e', 'r', 'e' ),
+	    DATA ( 0xb0, 0x34, 0x4c, 0x61, 0xd8, 0xdb, 0x38, 0x53, 0x5c,
+		   0xa8, 0xaf, 0xce, 0xaf, 0x0b, 0xf1, 0x2b, 0x88, 0x1d,
+		   0xc2, 0x00, 0xc9, 0x83, 0x3d, 0xa7, 0x26, 0xe9, 0x37,
+		   0x6c, 0x2e, 0x32, 0xcf, 0xf7 ) );
+
+/* RFC 4231 test case 2 */
+HMAC_TEST ( sha256_jefe_test, &sha256_algorithm,
+	    DATA ( 'J', 'e', 'f', 'e' ),
+	    DATA ( 'w', 'h', 'a', 't', ' ', 'd', 'o', ' ', 'y', 'a', ' ',
+		   'w', 'a', 'n', 't', ' ', 'f', 'o', 'r', ' ', 'n', 'o',
+		   't', 'h', 'i', 'n', 'g', '?' ),
+	    DATA ( 0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a,
+		   0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00,
+		   0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83, 0x9d, 0xec, 0x58,
+		   0xb9, 0x64, 0xec, 0x38, 0x43 ) );
+
+/**
+ * Perform HMAC self-tests
+ *
+ */
+static void hmac_test_exec ( void ) {
+
+	hmac_ok ( &sha1_hi_there_test );
+	hmac_ok ( &sha1_large_key_test );
+	hmac_ok ( &sha256_hi_there_test );
+	hmac_ok ( &sha256_jefe_test );
+}
+
+/** HMAC self-test */
+struct self_test hmac_test __self_test = {
+	.name = "hmac",
+	.exec = hmac_test_exec,
+};
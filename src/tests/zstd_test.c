@@ -0,0 +1,421 @@
+/*
+ * Copyright (C) 2026 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Zstandard tests
+ *
+ * The test vectors were generated using the zstd command-line tool.
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/zstd.h>
+#include <ipxe/test.h>
+
+/** Define inline data */
+#define DATA(...) { __VA_ARGS__ }
+
+/** Sentence used for compressible text tests */
+#define ZSTD_TEST_SENTENCE \
+	"The Zstandard compressed data format as defined in RFC 8878. "
+
+/** Number of sentence repetitions in the compressible text tests */
+#define ZSTD_TEST_SENTENCES 40
+
+/** Number of lines in the multi-block test */
+#define ZSTD_TEST_LINES 2500
+
+/** Length of each line in the multi-block test */
+#define ZSTD_TEST_LINE_LEN 56
+
+/* "Hello world" */
+static const char hello_expected[] = "Hello world";
+static const uint8_t hello_compressed[] =
+	DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x0b, 0x59, 0x00, 0x00, 0x48,
+	       0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64,
+	       0xd8, 0x76, 0xb3, 0x12 );
+
+/* 1024 x 'A' (run-length encoded block) */
+static const uint8_t rle_compressed[] =
+	DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x64, 0x00, 0x03, 0x45, 0x00, 0x00,
+	       0x08, 0x41, 0x01, 0x00, 0xfc, 0x2b, 0x20, 0x04, 0x27, 0x38,
+	       0xec, 0x54 );
+
+/* 64 bytes of incompressible (random) data */
+static const uint8_t random_expected[] =
+	DATA ( 0x39, 0x0c, 0x8c, 0x7d, 0x72, 0x47, 0x34, 0x2c, 0xd8, 0x10,
+	       0x0f, 0x2f, 0x6f, 0x77, 0x0d, 0x65, 0xd6, 0x70, 0xe5, 0x8e,
+	       0x03, 0x51, 0xd8, 0xae, 0x8e, 0x4f, 0x6e, 0xac, 0x34, 0x2f,
+	       0xc2, 0x31, 0xb7, 0xb0, 0x87, 0x16, 0xeb, 0x3f, 0xc1, 0x28,
+	       0x96, 0xb9, 0x62, 0x23, 0x17, 0x74, 0x94, 0x28, 0x77, 0x33,
+	       0xc2, 0x8e, 0xe8, 0xba, 0x53, 0xbd, 0xb5, 0x6b, 0x88, 0x24,
+	       0x57, 0x7d, 0x53, 0xec );
+static const uint8_t random_compressed[] =
+	DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x40, 0x01, 0x02, 0x00, 0x39,
+	       0x0c, 0x8c, 0x7d, 0x72, 0x47, 0x34, 0x2c, 0xd8, 0x10, 0x0f,
+	       0x2f, 0x6f, 0x77, 0x0d, 0x65, 0xd6, 0x70, 0xe5, 0x8e, 0x03,
+	       0x51, 0xd8, 0xae, 0x8e, 0x4f, 0x6e, 0xac, 0x34, 0x2f, 0xc2,
+	       0x31, 0xb7, 0xb0, 0x87, 0x16, 0xeb, 0x3f, 0xc1, 0x28, 0x96,
+	       0xb9, 0x62, 0x23, 0x17, 0x74, 0x94, 0x28, 0x77, 0x33, 0xc2,
+	       0x8e, 0xe8, 0xba, 0x53, 0xbd, 0xb5, 0x6b, 0x88, 0x24, 0x57,
+	       0x7d, 0x53, 0xec, 0x64, 0x52, 0x25, 0x2f );
+
+/* Repeated sentence, compressed at level 19 */
+static const uint8_t text_compressed[] =
+	DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x64, 0x88, 0x08, 0xed, 0x01, 0x00,
+	       0xd2, 0xc3, 0x0c, 0x11, 0xa0, 0xbb, 0x01, 0x08, 0x22, 0xa3,
+	       0xd9, 0xf3, 0x83, 0x7e, 0x03, 0xbe, 0xcd, 0xc0, 0x50, 0xc5,
+	       0x6a, 0x07, 0x18, 0x10, 0x2f, 0x06, 0x39, 0xab, 0xeb, 0xb2,
+	       0x42, 0xab, 0xef, 0xfc, 0xcb, 0xe5, 0x18, 0x7a, 0xbe, 0xd4,
+	       0xeb, 0x76, 0xaf, 0x6b, 0x8b, 0x9d, 0xab, 0x4b, 0xe5, 0x7c,
+	       0x6d, 0xbe, 0xa9, 0x04, 0x01, 0x00, 0x8d, 0x14, 0xc0, 0x0f,
+	       0x50, 0x9e, 0xce, 0x6f, 0xc1 );
+
+/* Repeated sentence, compressed at level 1 */
+static const uint8_t text_fast_compressed[] =
+	DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x64, 0x88, 0x08, 0x35, 0x02, 0x00,
+	       0xd4, 0x03, 0x54, 0x68, 0x65, 0x20, 0x5a, 0x73, 0x74, 0x61,
+	       0x6e, 0x64, 0x61, 0x72, 0x64, 0x20, 0x63, 0x6f, 0x6d, 0x70,
+	       0x72, 0x65, 0x73, 0x73, 0x65, 0x64, 0x20, 0x64, 0x61, 0x74,
+	       0x61, 0x20, 0x66, 0x6f, 0x72, 0x6d, 0x61, 0x74, 0x20, 0x61,
+	       0x73, 0x20, 0x64, 0x65, 0x66, 0x69, 0x6e, 0x65, 0x64, 0x20,
+	       0x69, 0x6e, 0x20, 0x52, 0x46, 0x43, 0x20, 0x38, 0x38, 0x37,
+	       0x38, 0x2e, 0x20, 0x01, 0x00, 0x8d, 0x14, 0xc0, 0x0f, 0x50,
+	       0x9e, 0xce, 0x6f, 0xc1 );
+
+/* Skippable frame followed by "Hello world" */
+static const uint8_t skippable_compressed[] =
+	DATA ( 0x50, 0x2a, 0x4d, 0x18, 0x06, 0x00, 0x00, 0x00, 0x73, 0x6b,
+	       0x69, 0x70, 0x6d, 0x65, 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x0b,
+	       0x59, 0x00, 0x00, 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77,
+	       0x6f, 0x72, 0x6c, 0x64, 0xd8, 0x76, 0xb3, 0x12 );
+
+/* "Hello world" frame followed by 1024 x 'A' frame */
+static const uint8_t multiframe_compressed[] =
+	DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x0b, 0x59, 0x00, 0x00, 0x48,
+	       0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64,
+	       0xd8, 0x76, 0xb3, 0x12, 0x28, 0xb5, 0x2f, 0xfd, 0x64, 0x00,
+	       0x03, 0x45, 0x00, 0x00, 0x08, 0x41, 0x01, 0x00, 0xfc, 0x2b,
+	       0x20, 0x04, 0x27, 0x38, 0xec, 0x54 );
+
+/* 140000 bytes of numbered lines (multiple compressed blocks) */
+static const uint8_t big_compressed[] =
+	DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0xa4, 0xe0, 0x22, 0x02, 0x00, 0x8c,
+	       0x0b, 0x00, 0x36, 0x56, 0x32, 0x1c, 0x50, 0x4f, 0x41, 0x73,
+	       0x0f, 0x3f, 0x68, 0x19, 0x6d, 0xb6, 0x19, 0x37, 0xb3, 0x66,
+	       0x66, 0x86, 0x30, 0x4d, 0x44, 0x44, 0x48, 0x4a, 0xec, 0xee,
+	       0xcc, 0xb8, 0x59, 0x03, 0x3e, 0x00, 0x2b, 0x00, 0x26, 0x00,
+	       0x89, 0x67, 0x45, 0x77, 0xa8, 0x24, 0x9e, 0x15, 0xdd, 0xb9,
+	       0x24, 0x9e, 0x15, 0xdd, 0x69, 0x49, 0x3c, 0x2b, 0xba, 0x00,
+	       0x07, 0x8f, 0x02, 0x62, 0x71, 0x21, 0xe0, 0x20, 0x0f, 0x8c,
+	       0x89, 0x07, 0x81, 0x68, 0x58, 0x90, 0x48, 0x20, 0x15, 0x0f,
+	       0x03, 0xc2, 0x40, 0xf1, 0x78, 0x18, 0x20, 0x0a, 0x04, 0x0d,
+	       0x09, 0x07, 0xc2, 0x40, 0x88, 0x20, 0x01, 0x43, 0x18, 0x0c,
+	       0x0d, 0x47, 0x78, 0x56, 0x74, 0xa7, 0x25, 0xf1, 0xac, 0xe8,
+	       0xce, 0x74, 0x4a, 0xe2, 0x59, 0xd1, 0x9d, 0x52, 0x12, 0xcf,
+	       0x8a, 0xee, 0x64, 0x49, 0x3c, 0x2b, 0xba, 0x83, 0x25, 0xf1,
+	       0xac, 0xe8, 0xce, 0x95, 0xc4, 0xb3, 0xa2, 0x3b, 0x56, 0x12,
+	       0xcf, 0x8a, 0xee, 0x54, 0x09, 0x7f, 0xdb, 0xb6, 0x6d, 0xdb,
+	       0xb6, 0x6d, 0xdb, 0xb6, 0x6d, 0xdb, 0xb6, 0x6d, 0xdb, 0xde,
+	       0xb9, 0x92, 0x78, 0x56, 0x74, 0xc7, 0x4a, 0xe2, 0x59, 0xd1,
+	       0x9d, 0x2a, 0x89, 0x67, 0x45, 0x77, 0xa8, 0x24, 0x9e, 0x15,
+	       0xdd, 0xb9, 0x64, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	       0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	       0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 0x81, 0x25, 0xa8, 0x21,
+	       0xe4, 0x0c, 0x85, 0x69, 0x7f, 0x03, 0xf1, 0x6b, 0x6c, 0x07,
+	       0x12, 0x40, 0x10, 0x18, 0x41, 0xe0, 0xff, 0xff, 0xf9, 0x03,
+	       0x24, 0x49, 0x24, 0x49, 0x24, 0x49, 0x24, 0x49, 0x24, 0x93,
+	       0x48, 0x92, 0x48, 0x92, 0x48, 0x12, 0x91, 0x24, 0x31, 0x49,
+	       0x22, 0x49, 0x22, 0x49, 0x22, 0x49, 0x22, 0xc9, 0x44, 0x92,
+	       0x44, 0x22, 0x89, 0x24, 0x89, 0x24, 0x89, 0x4c, 0x12, 0x49,
+	       0x12, 0x49, 0x12, 0x49, 0x12, 0x49, 0x32, 0x22, 0x49, 0x24,
+	       0x49, 0xe4, 0xa5, 0x70, 0xbc, 0x46, 0xa1, 0x91, 0x64, 0x92,
+	       0x6c, 0x38, 0x32, 0x49, 0x32, 0x87, 0x4b, 0x22, 0x99, 0xe4,
+	       0xd1, 0x90, 0x64, 0x92, 0x34, 0x1c, 0x99, 0x24, 0x99, 0xc3,
+	       0x25, 0x99, 0x4c, 0xf2, 0x62, 0x88, 0x48, 0x92, 0x48, 0x5c,
+	       0x92, 0x64, 0x26, 0x8f, 0x46, 0x92, 0x49, 0xd2, 0x70, 0x64,
+	       0x92, 0x64, 0x0e, 0x5b, 0x92, 0x64, 0x92, 0x47, 0x23, 0xc9,
+	       0x24, 0x69, 0x38, 0x72, 0x92, 0x64, 0x0e, 0x97, 0x24, 0x99,
+	       0xa4, 0xa3, 0x91, 0x64, 0x26, 0x69, 0x38, 0x32, 0x49, 0x32,
+	       0xb5, 0xdd, 0xb0, 0xd5, 0xa9, 0x0a, 0x01, 0xa8, 0x00, 0xee,
+	       0x1f, 0x74, 0x06, 0x00, 0x56, 0xd2, 0x15, 0x05, 0xe0, 0xe9,
+	       0x32, 0x31, 0x4b, 0x0c, 0x00, 0x0f, 0x00, 0x15, 0x00, 0xff,
+	       0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 0x00, 0x00,
+	       0x10, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+	       0xd5, 0xff, 0xff, 0xff, 0xff, 0x03, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+	       0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0x02, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x81, 0x25, 0x54, 0x01, 0x00, 0x26,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0xc9,
+	       0xe4, 0x07, 0x00, 0x76, 0x52, 0x1b, 0x09, 0xb0, 0x5b, 0x0e,
+	       0x44, 0x71, 0x5d, 0x4a, 0x92, 0xd3, 0x12, 0x00, 0x0e, 0x00,
+	       0x15, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x97,
+	       0x52, 0x4a, 0x29, 0xa5, 0x94, 0x52, 0x4a, 0x29, 0xa5, 0x04,
+	       0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0xff, 0xff,
+	       0xff, 0xff, 0xff, 0x07, 0x85, 0x0c, 0x11, 0x4c, 0x55, 0x55,
+	       0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+	       0x55, 0x55, 0x55, 0x55, 0x55, 0x43, 0x04, 0xd0, 0x31, 0x2d,
+	       0x64, 0x88, 0x00, 0x1e, 0xd3, 0x42, 0x86, 0x08, 0xa0, 0x1c,
+	       0xd3, 0x42, 0x86, 0x08, 0x80, 0x98, 0x63, 0x5a, 0xc8, 0x10,
+	       0xc1, 0x18, 0xd3, 0x42, 0x86, 0x08, 0xc6, 0x18, 0x63, 0x8c,
+	       0x31, 0xc6, 0x18, 0x60, 0x1a, 0x81, 0x25, 0xa8, 0x21, 0xf8,
+	       0x0e, 0xe1, 0x1f, 0x22, 0x08, 0xfc, 0xff, 0xff, 0xf3, 0x0f,
+	       0x24, 0x13, 0x8e, 0x44, 0x92, 0xe4, 0xc5, 0x91, 0x48, 0x92,
+	       0xbc, 0x38, 0x12, 0x49, 0x92, 0x17, 0x45, 0x92, 0x64, 0x62,
+	       0xb1, 0xab, 0x40, 0x22, 0x49, 0x92, 0xee, 0x28, 0x24, 0x49,
+	       0x92, 0x64, 0x3f, 0x46, 0x92, 0x24, 0xc1, 0xa1, 0x48, 0x92,
+	       0x24, 0x49, 0x46, 0x92, 0x24, 0x49, 0x92, 0x4c, 0x92, 0x24,
+	       0x49, 0x92, 0x44, 0x92, 0x24, 0x49, 0x92, 0x4c, 0x12, 0x49,
+	       0x92, 0x24, 0x29, 0x49, 0x92, 0x24, 0x49, 0x32, 0x49, 0x92,
+	       0x24, 0x49, 0x32, 0x49, 0x92, 0x48, 0x92, 0x64, 0x92, 0x24,
+	       0x49, 0x92, 0x64, 0x92, 0x24, 0x49, 0x92, 0xcc, 0x24, 0x49,
+	       0x92, 0x44, 0x92, 0x49, 0x92, 0x24, 0x49, 0x92, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x49, 0x92, 0x24, 0x49, 0x12, 0x93, 0x24,
+	       0x49, 0x92, 0x4c, 0x26, 0x49, 0x92, 0x24, 0x49, 0x26, 0x49,
+	       0x92, 0x24, 0x63, 0x74, 0x1b, 0x94, 0x07, 0x00, 0xc6, 0xd2,
+	       0x19, 0x09, 0xc0, 0x9d, 0x03, 0x24, 0x49, 0x42, 0x56, 0x3d,
+	       0x25, 0x1c, 0x00, 0x19, 0x00, 0x18, 0x00, 0x55, 0x55, 0x55,
+	       0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x05, 0x3a,
+	       0xa6, 0x90, 0x21, 0x42, 0x50, 0xc7, 0x14, 0x32, 0x44, 0x08,
+	       0x4e, 0xc7, 0x14, 0x32, 0x02, 0xc7, 0x14, 0x32, 0x44, 0x08,
+	       0x76, 0x4c, 0x21, 0x43, 0x84, 0x60, 0x55, 0x55, 0x55, 0x55,
+	       0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x05,
+	       0xff, 0xff, 0xff, 0xff, 0xff, 0x3b, 0xa6, 0x90, 0x21, 0x42,
+	       0x30, 0x3a, 0xa6, 0x90, 0x21, 0x42, 0x20, 0x3a, 0xa6, 0x90,
+	       0x21, 0x42, 0x10, 0x0a, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	       0xff, 0xff, 0xff, 0x0f, 0x81, 0x26, 0xec, 0xf1, 0xb3, 0x7f,
+	       0x06, 0x24, 0x49, 0x92, 0x24, 0xc9, 0x24, 0x49, 0x92, 0x64,
+	       0x92, 0x48, 0x92, 0x24, 0x49, 0x92, 0x49, 0x92, 0x64, 0x92,
+	       0x24, 0x93, 0x24, 0x49, 0x92, 0x64, 0x26, 0xc9, 0x24, 0x49,
+	       0x92, 0x4c, 0x92, 0x24, 0x49, 0x92, 0xcc, 0x24, 0x49, 0x92,
+	       0x24, 0x99, 0x24, 0x49, 0x92, 0x64, 0xcf, 0x61, 0x6d, 0xbe,
+	       0x91, 0x24, 0x49, 0xa2, 0xdc, 0x24, 0x92, 0x24, 0x2f, 0x8e,
+	       0x44, 0x92, 0xe4, 0xc5, 0x91, 0x90, 0x24, 0x79, 0x71, 0x24,
+	       0x92, 0x24, 0xaf, 0x35, 0x81, 0x91, 0xc8, 0x24, 0x49, 0x92,
+	       0x24, 0x91, 0x24, 0x49, 0x92, 0x64, 0x26, 0x49, 0x92, 0x24,
+	       0x49, 0x26, 0x49, 0x92, 0x64, 0x92, 0x4c, 0x92, 0x24, 0x89,
+	       0x24, 0x99, 0x24, 0xc9, 0x24, 0x49, 0x32, 0x49, 0x92, 0x24,
+	       0x49, 0x32, 0xc9, 0xa4, 0x30, 0x51, 0x48, 0x24, 0x92, 0xbc,
+	       0x38, 0x12, 0x49, 0x92, 0x17, 0x47, 0x22, 0xd9, 0xc7, 0x95,
+	       0x34, 0x07, 0x00, 0xb5, 0x24, 0x31, 0x82, 0x4b, 0x54, 0x01,
+	       0x00, 0x26, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x03, 0x4c, 0x05, 0x00, 0x56, 0x92, 0x0c, 0x04,
+	       0xe0, 0x0f, 0x41, 0x12, 0x0a, 0x00, 0x0a, 0x00, 0x0a, 0x00,
+	       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04,
+	       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04,
+	       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04,
+	       0xff, 0xff, 0xff, 0xff, 0xff, 0x7f, 0x00, 0x00, 0x80, 0x81,
+	       0x25, 0x54, 0x01, 0x00, 0x26, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0xc9, 0x04, 0x04, 0x00, 0x65, 0x12,
+	       0x32, 0x81, 0x26, 0x58, 0x01, 0x00, 0x12, 0xf8, 0xff, 0x11,
+	       0x04, 0xfe, 0xfd, 0x07, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x12, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x64, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0xc9, 0x24, 0x49, 0x92, 0x24,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92,
+	       0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x5c, 0x06, 0xc5, 0x03, 0x00, 0xf2,
+	       0x89, 0x08, 0x04, 0xf0, 0x39, 0x12, 0xd4, 0xff, 0xff, 0xff,
+	       0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xaa, 0xaa,
+	       0xaa, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	       0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x80, 0xa0, 0xa8, 0x20,
+	       0x7e, 0xe0, 0x0f, 0x12, 0xf8, 0xff, 0x1f, 0x41, 0xe0, 0x13,
+	       0xfc, 0x01, 0x92, 0x24, 0x49, 0x92, 0x4c, 0x92, 0x49, 0x12,
+	       0x49, 0x92, 0x24, 0x49, 0x26, 0x49, 0x92, 0x44, 0x92, 0x24,
+	       0x99, 0x44, 0x92, 0x24, 0x49, 0x22, 0xc9, 0x24, 0x49, 0x92,
+	       0x24, 0x49, 0x92, 0x92, 0x24, 0x59, 0x68, 0x44, 0x92, 0x24,
+	       0x93, 0x49, 0x92, 0x24, 0x49, 0x92, 0x4c, 0x92, 0x24, 0x92,
+	       0x24, 0x49, 0x62, 0x92, 0x24, 0x49, 0x12, 0x49, 0x92, 0x49,
+	       0x92, 0x24, 0x49, 0x92, 0x44, 0x71, 0x07, 0x04, 0x10, 0x21,
+	       0xa1, 0x03, 0x0e );
+
+
+/**
+ * Report Zstandard test result
+ *
+ * @v compressed	Compressed data
+ * @v compressed_len	Length of compressed data
+ * @v expected		Expected uncompressed data
+ * @v expected_len	Length of expected uncompressed data
+ * @v fcs_len		Expected reported frame content size
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void zstd_okx ( const void *compressed, size_t compressed_len,
+		       const void *expected, size_t expected_len,
+		       size_t fcs_len, const char *file, unsigned int line ) {
+	struct zstd_chunk in;
+	struct zstd_chunk out;
+	uint64_t len;
+	void *data;
+
+	/* Check reported decompressed length */
+	zstd_chunk_init ( &in, virt_to_user ( ( void * ) compressed ), 0,
+			  compressed_len );
+	okx ( zstd_decompressed_len ( &in, &len ) == 0, file, line );
+	okx ( len == fcs_len, file, line );
+
+	/* Decompress data */
+	data = malloc ( expected_len );
+	okx ( data != NULL, file, line );
+	if ( data ) {
+		zstd_chunk_init ( &out, virt_to_user ( data ), 0,
+				  expected_len );
+		okx ( zstd_decompress ( &in, &out ) == 0, file, line );
+		okx ( in.offset == compressed_len, file, line );
+		okx ( out.offset == expected_len, file, line );
+		okx ( memcmp ( data, expected, expected_len ) == 0,
+		      file, line );
+	}
+	free ( data );
+}
+#define zstd_ok( compressed, expected, fcs_len )			\
+	zstd_okx ( compressed, sizeof ( compressed ), expected,		\
+		   sizeof ( expected ), fcs_len, __FILE__, __LINE__ )
+
+/**
+ * Perform Zstandard self-test
+ *
+ */
+static void zstd_test_exec ( void ) {
+	static const char sentence[] = ZSTD_TEST_SENTENCE;
+	uint8_t rle_expected[1024];
+	char text_expected[ ZSTD_TEST_SENTENCES *
+			    ( sizeof ( sentence ) - 1 ) ];
+	uint8_t multiframe_expected[ sizeof ( hello_expected ) - 1 +
+				     sizeof ( rle_expected ) ];
+	char *big_expected;
+	size_t big_len = ( ZSTD_TEST_LINES * ZSTD_TEST_LINE_LEN );
+	unsigned int i;
+
+	/* Construct expected data for run-length and text tests */
+	memset ( rle_expected, 'A', sizeof ( rle_expected ) );
+	for ( i = 0 ; i < ZSTD_TEST_SENTENCES ; i++ ) {
+		memcpy ( &text_expected[ i * ( sizeof ( sentence ) - 1 ) ],
+			 sentence, ( sizeof ( sentence ) - 1 ) );
+	}
+	memcpy ( multiframe_expected, hello_expected,
+		 ( sizeof ( hello_expected ) - 1 ) );
+	memset ( &multiframe_expected[ sizeof ( hello_expected ) - 1 ], 'A',
+		 sizeof ( rle_expected ) );
+
+	/* Perform fixed-data tests */
+	zstd_okx ( hello_compressed, sizeof ( hello_compressed ),
+		   hello_expected, ( sizeof ( hello_expected ) - 1 ),
+		   ( sizeof ( hello_expected ) - 1 ), __FILE__, __LINE__ );
+	zstd_ok ( rle_compressed, rle_expected, sizeof ( rle_expected ) );
+	zstd_ok ( random_compressed, random_expected,
+		  sizeof ( random_expected ) );
+	zstd_ok ( text_compressed, text_expected, sizeof ( text_expected ) );
+	zstd_ok ( text_fast_compressed, text_expected,
+		  sizeof ( text_expected ) );
+	zstd_okx ( skippable_compressed, sizeof ( skippable_compressed ),
+		   hello_expected, ( sizeof ( hello_expected ) - 1 ),
+		   ( sizeof ( hello_expected ) - 1 ), __FILE__, __LINE__ );
+
+	/* Concatenated frames: the reported length covers only the
+	 * first frame.
+	 */
+	zstd_ok ( multiframe_compressed, multiframe_expected,
+		  ( sizeof ( hello_expected ) - 1 ) );
+
+	/* Perform multi-block test */
+	big_expected = malloc ( big_len + 1 /* snprintf NUL */ );
+	ok ( big_expected != NULL );
+	if ( big_expected ) {
+		for ( i = 0 ; i < ZSTD_TEST_LINES ; i++ ) {
+			snprintf ( &big_expected[ i * ZSTD_TEST_LINE_LEN ],
+				   ( ZSTD_TEST_LINE_LEN + 1 ),
+				   "line %05d: the quick brown fox jumps "
+				   "over the lazy dog\n", i );
+		}
+		zstd_okx ( big_compressed, sizeof ( big_compressed ),
+			   big_expected, big_len, big_len,
+			   __FILE__, __LINE__ );
+	}
+	free ( big_expected );
+}
+
+/** Zstandard self-test */
+struct self_test zstd_test __self_test = {
+	.name = "zstd",
+	.exec = zstd_test_exec,
+};
@@ -29,6 +29,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/netdevice.h>
 #include <ipxe/dhcp.h>
 #include <ipxe/settings.h>
+#include <ipxe/interface.h>
+#include <ipxe/process.h>
+#include <ipxe/pinger.h>
 #include <ipxe/image.h>
 #include <ipxe/sanboot.h>
 #include <ipxe/uri.h>
@@ -375,29 +378,121 @@ static int have_pxe_menu ( void ) {
 		       setting_exists ( NULL, &filename_setting ) ) ) );
 }
 
+/** Boot server probe timeout (in ticks)
+ *
+ * Timing out towards a dead boot server costs far more than this
+ * brief probe.  This is a policy decision.
+ */
+#define NETBOOT_PROBE_TIMEOUT ( 1 * TICKS_PER_SEC )
+
+/** Boot server probe payload length */
+#define NETBOOT_PROBE_LEN 64
+
+#ifdef PING_CMD
+
+/** A boot server liveness probe */
+struct netboot_probe {
+	/** Job control interface */
+	struct interface job;
+	/** Probe has completed */
+	int done;
+	/** Overall status code */
+	int rc;
+};
+
 /**
- * Boot from a network device
+ * Handle probe completion
+ *
+ * @v probe		Boot server probe
+ * @v rc		Reason for close
+ */
+static void netboot_probe_close ( struct netboot_probe *probe, int rc ) {
+
+	probe->done = 1;
+	probe->rc = rc;
+	intf_shutdown ( &probe->job, rc );
+}
+
+/** Boot server probe interface operations */
+static struct interface_operation netboot_probe_op[] = {
+	INTF_OP ( intf_close, struct netboot_probe *, netboot_probe_close ),
+};
+
+/** Boot server probe interface descriptor */
+static struct interface_descriptor netboot_probe_desc =
+	INTF_DESC ( struct netboot_probe, job, netboot_probe_op );
+
+/**
+ * Probe liveness of boot servers
+ *
+ * @v host1		First boot server
+ * @v host2		Second boot server
+ * @v alive1		First boot server responded
+ * @v alive2		Second boot server responded
+ *
+ * Both servers are probed concurrently (implicitly exercising the
+ * ARP/gateway path), so the time spent is bounded by a single probe
+ * timeout.  An unanswered probe is advisory only, since ICMP may be
+ * filtered.
+ */
+static void netboot_probe ( const char *host1, const char *host2,
+			    int *alive1, int *alive2 ) {
+	struct netboot_probe probes[2];
+	const char *hosts[2] = { host1, host2 };
+	unsigned int i;
+	int rc;
+
+	/* Start probes */
+	memset ( probes, 0, sizeof ( probes ) );
+	for ( i = 0 ; i < 2 ; i++ ) {
+		intf_init ( &probes[i].job, &netboot_probe_desc, NULL );
+		if ( ( rc = create_pinger ( &probes[i].job, hosts[i],
+					    NETBOOT_PROBE_TIMEOUT, 0,
+					    NETBOOT_PROBE_LEN, 1,
+					    NULL ) ) != 0 ) {
+			probes[i].done = 1;
+			probes[i].rc = rc;
+		}
+	}
+
+	/* Wait for both probes to complete */
+	while ( ! ( probes[0].done && probes[1].done ) )
+		step();
+
+	/* Record results */
+	*alive1 = ( probes[0].rc == 0 );
+	*alive2 = ( probes[1].rc == 0 );
+}
+
+#else /* PING_CMD */
+
+/**
+ * Probe liveness of boot servers (no ping support compiled in)
+ *
+ */
+static void netboot_probe ( const char *host1 __unused,
+			    const char *host2 __unused,
+			    int *alive1 __unused, int *alive2 __unused ) {
+	/* Do nothing */
+}
+
+#endif /* PING_CMD */
+
+/**
+ * Boot from an already-configured network device
  *
  * @v netdev		Network device
  * @ret rc		Return status code
  */
-int netboot ( struct net_device *netdev ) {
+static int netboot_configured ( struct net_device *netdev ) {
 	struct uri *filename;
 	struct uri *root_path;
 	char *san_filename;
+	int filename_alive = 0;
+	int root_path_alive = 0;
 	int rc;
 
-	/* Close all other network devices */
-	close_all_netdevs();
-
-	/* Open device and display device status */
-	if ( ( rc = ifopen ( netdev ) ) != 0 )
-		goto err_ifopen;
-	ifstat ( netdev );
-
-	/* Configure device */
-	if ( ( rc = ifconf ( netdev, NULL ) ) != 0 )
-		goto err_dhcp;
+	/* Display routing table */
 	route();
 
 	/* Try PXE menu boot, if applicable */
@@ -435,10 +530,36 @@ int netboot ( struct net_device *netdev ) {
 		goto err_no_boot;
 	}
 
+	/* If the filename and root path refer to distinct servers,
+	 * probe both concurrently: choosing the live server up front
+	 * beats timing out towards a dead one.  Reorder only when
+	 * exactly one server responds, since ICMP may be filtered.
+	 */
+	if ( filename && root_path && filename->host && root_path->host &&
+	     ( strcmp ( filename->host, root_path->host ) != 0 ) ) {
+		netboot_probe ( filename->host, root_path->host,
+				&filename_alive, &root_path_alive );
+	}
+
 	/* Boot using next server, filename and root path */
-	if ( ( rc = uriboot ( filename, &root_path, ( root_path ? 1 : 0 ),
-			      san_default_drive(), san_filename,
-			      ( root_path ? 0 : URIBOOT_NO_SAN ) ) ) != 0 )
+	if ( root_path_alive && ( ! filename_alive ) ) {
+		/* Boot server is not responding but SAN server is:
+		 * attempt the SAN boot first, falling back to the
+		 * filename boot if it fails.
+		 */
+		printf ( "Boot server %s is not responding; trying SAN boot "
+			 "first\n", filename->host );
+		if ( ( rc = uriboot ( NULL, &root_path, 1, san_default_drive(),
+				      san_filename, 0 ) ) != 0 ) {
+			rc = uriboot ( filename, NULL, 0, san_default_drive(),
+				       san_filename, URIBOOT_NO_SAN );
+		}
+	} else {
+		rc = uriboot ( filename, &root_path, ( root_path ? 1 : 0 ),
+			       san_default_drive(), san_filename,
+			       ( root_path ? 0 : URIBOOT_NO_SAN ) );
+	}
+	if ( rc != 0 )
 		goto err_uriboot;
 
  err_uriboot:
@@ -447,11 +568,34 @@ int netboot ( struct net_device *netdev ) {
 	uri_put ( root_path );
 	uri_put ( filename );
  err_pxe_menu_boot:
- err_dhcp:
- err_ifopen:
 	return rc;
 }
 
+/**
+ * Boot from a network device
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+int netboot ( struct net_device *netdev ) {
+	int rc;
+
+	/* Close all other network devices */
+	close_all_netdevs();
+
+	/* Open device and display device status */
+	if ( ( rc = ifopen ( netdev ) ) != 0 )
+		return rc;
+	ifstat ( netdev );
+
+	/* Configure device */
+	if ( ( rc = ifconf ( netdev, NULL ) ) != 0 )
+		return rc;
+
+	/* Boot from device */
+	return netboot_configured ( netdev );
+}
+
 /**
  * Test if network device matches the autoboot device bus type and location
  *
@@ -514,25 +658,68 @@ void set_autoboot_ll_addr ( const void *ll_addr, size_t len ) {
 	is_autoboot_device = is_autoboot_ll_addr;
 }
 
+/**
+ * Test if network device is an autoboot candidate
+ *
+ * @v netdev		Network device
+ * @ret is_candidate	Network device is an autoboot candidate
+ */
+static int autoboot_candidate ( struct net_device *netdev ) {
+
+	/* Use only devices matching the specified autoboot device
+	 * location, if applicable.
+	 */
+	if ( is_autoboot_device && ( ! is_autoboot_device ( netdev ) ) )
+		return 0;
+
+	return 1;
+}
+
 /**
  * Boot the system
  */
 static int autoboot ( void ) {
 	struct net_device *netdev;
-	int rc = -ENODEV;
+	struct net_device *configured;
+	int rc;
 
-	/* Try booting from each network device.  If we have a
-	 * specified autoboot device location, then use only devices
-	 * matching that location.
-	 */
+	/* Open all candidate network devices */
 	for_each_netdev ( netdev ) {
+		if ( autoboot_candidate ( netdev ) )
+			ifopen ( netdev );
+	}
 
-		/* Skip any non-matching devices, if applicable */
-		if ( is_autoboot_device && ( ! is_autoboot_device ( netdev ) ) )
-			continue;
+	/* Configure all candidates in parallel, and boot from
+	 * whichever obtains a usable configuration first.  This avoids
+	 * paying the full configuration timeout serially for each
+	 * uncabled port in a multi-port system.
+	 */
+	if ( ( rc = ifconf_any ( NULL, &configured ) ) == 0 ) {
+
+		/* Close all other devices (implicitly cancelling any
+		 * still-running configurations)
+		 */
+		for_each_netdev ( netdev ) {
+			if ( netdev != configured )
+				ifclose ( netdev );
+		}
 
-		/* Attempt booting from this device */
-		rc = netboot ( netdev );
+		/* Boot from the configured device */
+		ifstat ( configured );
+		rc = netboot_configured ( configured );
+
+		/* If booting failed, fall back to trying each
+		 * remaining candidate device in turn
+		 */
+		if ( rc != 0 ) {
+			for_each_netdev ( netdev ) {
+				if ( ! autoboot_candidate ( netdev ) )
+					continue;
+				if ( netdev == configured )
+					continue;
+				rc = netboot ( netdev );
+			}
+		}
 	}
 
 	printf ( "No more network devices\n" );
@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2015 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/timer.h>
+#include <ipxe/monojob.h>
+#include <ipxe/netbench.h>
+#include <ipxe/sanboot.h>
+#include <ipxe/umalloc.h>
+#include <ipxe/profile.h>
+#include <ipxe/crypto.h>
+#include <ipxe/md5.h>
+#include <ipxe/sha1.h>
+#include <ipxe/sha256.h>
+#include <ipxe/aes.h>
+#include <usr/bench.h>
+
+/** @file
+ *
+ * Benchmark commands
+ *
+ */
+
+/** Disk benchmark chunk length */
+#define DISKBENCH_CHUNK_LEN ( 64 * 1024 )
+
+/** Crypto benchmark buffer length */
+#define CRYPTOBENCH_LEN 4096
+
+/** Crypto benchmark iteration count */
+#define CRYPTOBENCH_COUNT 256
+
+/** Digest algorithms to benchmark */
+static struct digest_algorithm *cryptobench_digests[] = {
+	&md5_algorithm,
+	&sha1_algorithm,
+	&sha256_algorithm,
+};
+
+/** Cipher algorithms to benchmark */
+static struct cipher_algorithm *cryptobench_ciphers[] = {
+	&aes_cbc_algorithm,
+};
+
+/**
+ * Display network benchmark result
+ *
+ * @v tx_bytes		Bytes transmitted
+ * @v rx_bytes		Bytes received
+ * @v elapsed		Elapsed time (in ticks)
+ */
+static void netbench_callback ( uint64_t tx_bytes, uint64_t rx_bytes,
+				unsigned long elapsed ) {
+
+	/* Guard against division by zero */
+	if ( ! elapsed )
+		elapsed = 1;
+
+	printf ( "TX %lld bytes (%lld kB/s), RX %lld bytes (%lld kB/s)\n",
+		 ( ( unsigned long long ) tx_bytes ),
+		 ( ( unsigned long long )
+		   ( ( tx_bytes * TICKS_PER_SEC ) / ( elapsed * 1024 ) ) ),
+		 ( ( unsigned long long ) rx_bytes ),
+		 ( ( unsigned long long )
+		   ( ( rx_bytes * TICKS_PER_SEC ) / ( elapsed * 1024 ) ) ) );
+
+	/* Emit a machine-readable result line for scripted harnesses */
+	printf ( "netbench: tx_bytes=%lld rx_bytes=%lld elapsed_ms=%ld\n",
+		 ( ( unsigned long long ) tx_bytes ),
+		 ( ( unsigned long long ) rx_bytes ),
+		 ( ( elapsed * 1000 ) / TICKS_PER_SEC ) );
+}
+
+/**
+ * Run network throughput benchmark
+ *
+ * @v hostname		Hostname of benchmark server
+ * @v port		Port number
+ * @v tcp		Use TCP rather than UDP
+ * @v len		Payload length
+ * @v duration		Duration (in ticks)
+ * @ret rc		Return status code
+ */
+int netbench ( const char *hostname, unsigned int port, int tcp,
+	       size_t len, unsigned long duration ) {
+	int rc;
+
+	/* Create benchmark */
+	if ( ( rc = create_netbench ( &monojob, hostname, port, tcp, len,
+				      duration, netbench_callback ) ) != 0 ) {
+		printf ( "Could not start benchmark: %s\n", strerror ( rc ) );
+		return rc;
+	}
+
+	/* Wait for benchmark to complete */
+	if ( ( rc = monojob_wait ( NULL, 0 ) ) != 0 ) {
+		printf ( "Benchmark failed: %s\n", strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Run one disk read benchmark pass
+ *
+ * @v sandev		SAN device
+ * @v buffer		Chunk buffer
+ * @v count		Blocks per chunk
+ * @v len		Total length to read
+ * @v random_access	Use random (rather than sequential) access
+ * @ret rc		Return status code
+ */
+static int diskbench_pass ( struct san_device *sandev, userptr_t buffer,
+			    unsigned int count, size_t len,
+			    int random_access ) {
+	uint64_t blocks = sandev_capacity ( sandev );
+	unsigned long start;
+	unsigned long elapsed;
+	uint64_t lba = 0;
+	size_t remaining;
+	int rc;
+
+	/* Read chunks until the requested total length is reached */
+	start = currticks();
+	for ( remaining = len ; remaining ; remaining -= DISKBENCH_CHUNK_LEN ){
+
+		/* Select chunk location */
+		if ( random_access ) {
+			lba = ( ( ( ( uint64_t ) random() ) * count ) %
+				( blocks - count ) );
+		} else if ( ( lba + count ) > blocks ) {
+			lba = 0;
+		}
+
+		/* Read chunk */
+		if ( ( rc = sandev_read ( sandev, lba, count,
+					  buffer ) ) != 0 ) {
+			printf ( "Could not read drive %#02x at %#llx: %s\n",
+				 sandev->drive,
+				 ( ( unsigned long long ) lba ),
+				 strerror ( rc ) );
+			return rc;
+		}
+		lba += count;
+	}
+	elapsed = ( currticks() - start );
+	if ( ! elapsed )
+		elapsed = 1;
+
+	/* Display result */
+	printf ( "%s: %zd bytes (%lld kB/s)\n",
+		 ( random_access ? "random" : "sequential" ), len,
+		 ( ( unsigned long long )
+		   ( ( ( ( uint64_t ) len ) * TICKS_PER_SEC ) /
+		     ( elapsed * 1024 ) ) ) );
+
+	return 0;
+}
+
+/**
+ * Run disk read benchmark
+ *
+ * @v drive		Drive number
+ * @v len		Total length to read per pass
+ * @ret rc		Return status code
+ */
+int diskbench ( unsigned int drive, size_t len ) {
+	struct san_device *sandev;
+	userptr_t buffer;
+	unsigned int count;
+	int rc;
+
+	/* Identify SAN device */
+	sandev = sandev_find ( drive );
+	if ( ! sandev ) {
+		printf ( "No such drive %#02x\n", drive );
+		return -ENODEV;
+	}
+
+	/* Calculate blocks per chunk */
+	count = ( DISKBENCH_CHUNK_LEN / sandev_blksize ( sandev ) );
+	if ( ( ! count ) ||
+	     ( sandev_capacity ( sandev ) < ( 2 * count ) ) ) {
+		printf ( "Drive %#02x is too small to benchmark\n", drive );
+		return -ENOSPC;
+	}
+
+	/* Round total length down to a whole number of chunks */
+	len &= ~( ( size_t ) ( DISKBENCH_CHUNK_LEN - 1 ) );
+	if ( ! len )
+		len = DISKBENCH_CHUNK_LEN;
+
+	/* Allocate chunk buffer */
+	buffer = umalloc ( DISKBENCH_CHUNK_LEN );
+	if ( ! buffer ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
+	/* Run sequential and random passes */
+	if ( ( rc = diskbench_pass ( sandev, buffer, count, len, 0 ) ) != 0 )
+		goto err_pass;
+	if ( ( rc = diskbench_pass ( sandev, buffer, count, len, 1 ) ) != 0 )
+		goto err_pass;
+
+ err_pass:
+	ufree ( buffer );
+ err_alloc:
+	return rc;
+}
+
+/**
+ * Display crypto benchmark result
+ *
+ * @v name		Algorithm name
+ * @v cycles		Consumed cycles
+ * @v len		Total length processed
+ */
+static void cryptobench_result ( const char *name, uint64_t cycles,
+				 size_t len ) {
+
+	printf ( "%s: %lld cycles (%lld cycles/byte)\n", name,
+		 ( ( unsigned long long ) cycles ),
+		 ( ( unsigned long long ) ( cycles / len ) ) );
+}
+
+/**
+ * Run crypto benchmark
+ *
+ * @ret rc		Return status code
+ *
+ * Measures cycles per byte for a representative set of digest and
+ * cipher algorithms, using the profiling timestamp counter.
+ */
+int cryptobench ( void ) {
+	struct digest_algorithm *digest;
+	struct cipher_algorithm *cipher;
+	static const uint8_t key[16];
+	static const uint8_t iv[16];
+	uint8_t *buf;
+	uint64_t start;
+	unsigned int i;
+	unsigned int iter;
+	int rc;
+
+	/* Allocate data buffer */
+	buf = zalloc ( CRYPTOBENCH_LEN );
+	if ( ! buf ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
+	/* Benchmark digest algorithms */
+	for ( i = 0 ; i < ( sizeof ( cryptobench_digests ) /
+			    sizeof ( cryptobench_digests[0] ) ) ; i++ ) {
+		digest = cryptobench_digests[i];
+		{
+			uint8_t ctx[digest->ctxsize];
+			uint8_t out[digest->digestsize];
+
+			start = profile_timestamp();
+			digest_init ( digest, ctx );
+			for ( iter = 0 ; iter < CRYPTOBENCH_COUNT ; iter++ ) {
+				digest_update ( digest, ctx, buf,
+						CRYPTOBENCH_LEN );
+			}
+			digest_final ( digest, ctx, out );
+			cryptobench_result ( digest->name,
+					     ( profile_timestamp() - start ),
+					     ( CRYPTOBENCH_COUNT *
+					       CRYPTOBENCH_LEN ) );
+		}
+	}
+
+	/* Benchmark cipher algorithms */
+	for ( i = 0 ; i < ( sizeof ( cryptobench_ciphers ) /
+			    sizeof ( cryptobench_ciphers[0] ) ) ; i++ ) {
+		cipher = cryptobench_ciphers[i];
+		{
+			uint8_t ctx[cipher->ctxsize];
+
+			if ( ( rc = cipher_setkey ( cipher, ctx, key,
+						    sizeof ( key ) ) ) != 0 ) {
+				printf ( "Could not set %s key: %s\n",
+					 cipher->name, strerror ( rc ) );
+				goto err_setkey;
+			}
+			cipher_setiv ( cipher, ctx, iv, cipher->blocksize );
+			start = profile_timestamp();
+			for ( iter = 0 ; iter < CRYPTOBENCH_COUNT ; iter++ ) {
+				cipher_encrypt ( cipher, ctx, buf, buf,
+						 CRYPTOBENCH_LEN );
+			}
+			cryptobench_result ( cipher->name,
+					     ( profile_timestamp() - start ),
+					     ( CRYPTOBENCH_COUNT *
+					       CRYPTOBENCH_LEN ) );
+		}
+	}
+
+	rc = 0;
+ err_setkey:
+	free ( buf );
+ err_alloc:
+	return rc;
+}
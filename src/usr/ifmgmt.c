@@ -109,13 +109,14 @@ static void ifstat_errors ( struct net_device_stats *stats,
  */
 void ifstat ( struct net_device *netdev ) {
 	printf ( "%s: %s using %s on %s (%s)\n"
-		 "  [Link:%s%s, TX:%d TXE:%d RX:%d RXE:%d]\n",
+		 "  [Link:%s%s, TX:%d TXE:%d TXQ:%d/%d RX:%d RXE:%d]\n",
 		 netdev->name, netdev_addr ( netdev ),
 		 netdev->dev->driver_name, netdev->dev->name,
 		 ( netdev_is_open ( netdev ) ? "open" : "closed" ),
 		 ( netdev_link_ok ( netdev ) ? "up" : "down" ),
 		 ( netdev_link_blocked ( netdev ) ? " (blocked)" : "" ),
 		 netdev->tx_stats.good, netdev->tx_stats.bad,
+		 netdev->tx_count, netdev->tx_max,
 		 netdev->rx_stats.good, netdev->rx_stats.bad );
 	if ( ! netdev_link_ok ( netdev ) ) {
 		printf ( "  [Link status: %s]\n",
@@ -298,3 +299,103 @@ int ifconf ( struct net_device *netdev,
 		 netdev->name, netdev->ll_protocol->ntoa ( netdev->ll_addr ) );
 	return ifpoller_wait ( netdev, configurator, 0, ifconf_progress );
 }
+
+/**
+ * Check parallel configuration progress
+ *
+ * @v ifpoller		Network device poller
+ * @ret ongoing_rc	Ongoing job status code (if known)
+ */
+static int ifconf_any_progress ( struct ifpoller *ifpoller ) {
+	struct net_device *netdev;
+	int rc;
+
+	/* Terminate successfully as soon as any device has a usable
+	 * configuration.
+	 */
+	for_each_netdev ( netdev ) {
+		if ( ! netdev_is_open ( netdev ) )
+			continue;
+		if ( netdev_configuration_in_progress ( netdev ) )
+			continue;
+		if ( netdev_configuration_ok ( netdev ) ) {
+			intf_close ( &ifpoller->job, 0 );
+			return 0;
+		}
+	}
+
+	/* Do nothing while any device is still attempting configuration */
+	for_each_netdev ( netdev ) {
+		if ( netdev_is_open ( netdev ) &&
+		     netdev_configuration_in_progress ( netdev ) )
+			return 0;
+	}
+
+	/* Terminate unsuccessfully once all devices have completed */
+	rc = -EADDRNOTAVAIL_CONFIG;
+	intf_close ( &ifpoller->job, rc );
+	return rc;
+}
+
+/**
+ * Perform configuration of all open network devices in parallel
+ *
+ * @v configurator	Network device configurator, or NULL to use all
+ * @v configured	Successfully configured network device to fill in
+ * @ret rc		Return status code
+ *
+ * Configuration is started simultaneously on all open network
+ * devices, and completes as soon as any single device obtains a
+ * usable configuration.  This avoids paying the full configuration
+ * timeout serially for each device that cannot be configured (e.g. an
+ * uncabled port).
+ */
+int ifconf_any ( struct net_device_configurator *configurator,
+		 struct net_device **configured ) {
+	struct net_device *netdev;
+	unsigned int started = 0;
+	int rc;
+
+	/* Start configuration on all open devices */
+	printf ( "Configuring %s%s%s(",
+		 ( configurator ? "[" : "" ),
+		 ( configurator ? configurator->name : "" ),
+		 ( configurator ? "] " : "" ) );
+	for_each_netdev ( netdev ) {
+		if ( ! netdev_is_open ( netdev ) )
+			continue;
+		if ( configurator ) {
+			rc = netdev_configure ( netdev, configurator );
+		} else {
+			rc = netdev_configure_all ( netdev );
+		}
+		if ( rc != 0 ) {
+			printf ( "\nCould not configure %s: %s\n",
+				 netdev->name, strerror ( rc ) );
+			continue;
+		}
+		printf ( "%s%s", ( started ? " " : "" ), netdev->name );
+		started++;
+	}
+	printf ( ")" );
+	if ( ! started ) {
+		printf ( "\n" );
+		return -ENODEV;
+	}
+
+	/* Wait for any configuration to complete */
+	if ( ( rc = ifpoller_wait ( NULL, configurator, 0,
+				    ifconf_any_progress ) ) != 0 )
+		return rc;
+
+	/* Identify first successfully configured device */
+	for_each_netdev ( netdev ) {
+		if ( netdev_is_open ( netdev ) &&
+		     netdev_configuration_ok ( netdev ) ) {
+			*configured = netdev;
+			return 0;
+		}
+	}
+
+	return -EADDRNOTAVAIL_CONFIG;
+}
@@ -26,12 +26,16 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 #include <ipxe/image.h>
+#include <ipxe/process.h>
 #include <ipxe/downloader.h>
 #include <ipxe/monojob.h>
+#include <ipxe/job.h>
 #include <ipxe/open.h>
 #include <ipxe/uri.h>
+#include <ipxe/boottrace.h>
 #include <usr/imgmgmt.h>
 
 /** @file
@@ -40,6 +44,224 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/** A background prefetch */
+struct imgprefetch {
+	/** Reference count for this object */
+	struct refcnt refcnt;
+	/** List of background prefetches */
+	struct list_head list;
+	/** Job control interface */
+	struct interface job;
+	/** Image being downloaded */
+	struct image *image;
+};
+
+/** List of background prefetches */
+static LIST_HEAD ( imgprefetches );
+
+/**
+ * Check whether two URIs refer to the same resource
+ *
+ * @v a			First URI
+ * @v b			Second URI
+ * @ret same		URIs refer to the same resource
+ */
+static int imguri_same ( struct uri *a, struct uri *b ) {
+	char *a_string;
+	char *b_string;
+	int same = 0;
+
+	/* Compare formatted URIs */
+	a_string = format_uri_alloc ( a );
+	b_string = format_uri_alloc ( b );
+	if ( a_string && b_string )
+		same = ( strcmp ( a_string, b_string ) == 0 );
+	free ( a_string );
+	free ( b_string );
+
+	return same;
+}
+
+/**
+ * Find registered image by URI
+ *
+ * @v uri		URI
+ * @ret image		Registered image, or NULL
+ */
+static struct image * imgfind_uri ( struct uri *uri ) {
+	struct image *image;
+
+	for_each_image ( image ) {
+		if ( image->uri && imguri_same ( image->uri, uri ) )
+			return image;
+	}
+
+	return NULL;
+}
+
+/**
+ * Find in-flight background prefetch by URI
+ *
+ * @v uri		URI
+ * @ret prefetch	Background prefetch, or NULL
+ */
+static struct imgprefetch * imgprefetch_find ( struct uri *uri ) {
+	struct imgprefetch *prefetch;
+
+	list_for_each_entry ( prefetch, &imgprefetches, list ) {
+		if ( imguri_same ( prefetch->image->uri, uri ) )
+			return prefetch;
+	}
+
+	return NULL;
+}
+
+/**
+ * Wait for any in-flight background prefetch of a URI to complete
+ *
+ * @v uri		URI
+ *
+ * The wait is bounded by the prefetch download's own connection
+ * timeouts: the download will eventually either complete or fail, at
+ * which point the prefetch removes itself from the list.
+ */
+static void imgprefetch_wait ( struct uri *uri ) {
+
+	while ( imgprefetch_find ( uri ) != NULL )
+		step();
+}
+
+/**
+ * Free background prefetch
+ *
+ * @v refcnt		Reference counter
+ */
+static void imgprefetch_free ( struct refcnt *refcnt ) {
+	struct imgprefetch *prefetch =
+		container_of ( refcnt, struct imgprefetch, refcnt );
+
+	image_put ( prefetch->image );
+	free ( prefetch );
+}
+
+/**
+ * Handle completion of a background prefetch
+ *
+ * @v prefetch		Background prefetch
+ * @v rc		Reason for completion
+ */
+static void imgprefetch_close ( struct imgprefetch *prefetch, int rc ) {
+	struct image *image = prefetch->image;
+
+	/* Register image on successful completion.  Failures are
+	 * deliberately quiet: a later explicit fetch of the same URI
+	 * will retry the download and report any error.
+	 */
+	if ( rc == 0 ) {
+		if ( ( rc = register_image ( image ) ) != 0 ) {
+			DBGC ( prefetch, "PREFETCH %p could not register %s: "
+			       "%s\n", prefetch, image->name, strerror ( rc ) );
+		}
+	} else {
+		DBGC ( prefetch, "PREFETCH %p %s failed: %s\n",
+		       prefetch, image->name, strerror ( rc ) );
+	}
+
+	/* Shut down interface, remove from list, and drop reference */
+	intf_shutdown ( &prefetch->job, rc );
+	list_del ( &prefetch->list );
+	ref_put ( &prefetch->refcnt );
+}
+
+/** Background prefetch job control interface operations */
+static struct interface_operation imgprefetch_job_operations[] = {
+	INTF_OP ( intf_close, struct imgprefetch *, imgprefetch_close ),
+};
+
+/** Background prefetch job control interface descriptor */
+static struct interface_descriptor imgprefetch_job_desc =
+	INTF_DESC ( struct imgprefetch, job, imgprefetch_job_operations );
+
+/**
+ * Start a background prefetch of an image
+ *
+ * @v uri_string	URI string
+ * @ret rc		Return status code
+ *
+ * The download proceeds whenever the network is polled (e.g. while an
+ * interactive menu is waiting for a keypress), and registers the
+ * image on completion.  A subsequent download of the same URI will
+ * then be satisfied directly from the image store.
+ */
+int imgprefetch ( const char *uri_string ) {
+	struct imgprefetch *prefetch;
+	struct uri *parsed;
+	struct uri *uri;
+	int rc;
+
+	/* Parse and resolve URI */
+	parsed = parse_uri ( uri_string );
+	if ( ! parsed ) {
+		rc = -ENOMEM;
+		goto err_parse_uri;
+	}
+	uri = resolve_uri ( cwuri, parsed );
+	uri_put ( parsed );
+	if ( ! uri ) {
+		rc = -ENOMEM;
+		goto err_resolve_uri;
+	}
+
+	/* Do nothing if the image is already downloaded, or if a
+	 * prefetch is already in flight.
+	 */
+	if ( imgfind_uri ( uri ) || imgprefetch_find ( uri ) ) {
+		rc = 0;
+		goto err_exists;
+	}
+
+	/* Allocate and initialise structure */
+	prefetch = zalloc ( sizeof ( *prefetch ) );
+	if ( ! prefetch ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	ref_init ( &prefetch->refcnt, imgprefetch_free );
+	intf_init ( &prefetch->job, &imgprefetch_job_desc, &prefetch->refcnt );
+
+	/* Allocate image */
+	prefetch->image = alloc_image ( uri );
+	if ( ! prefetch->image ) {
+		rc = -ENOMEM;
+		goto err_alloc_image;
+	}
+
+	/* Create downloader */
+	if ( ( rc = create_downloader ( &prefetch->job,
+					prefetch->image ) ) != 0 ) {
+		DBGC ( prefetch, "PREFETCH %p could not start download of "
+		       "%s: %s\n", prefetch, uri_string, strerror ( rc ) );
+		goto err_create_downloader;
+	}
+	DBGC ( prefetch, "PREFETCH %p started %s\n", prefetch, uri_string );
+	boottrace ( "prefetch %s", prefetch->image->name );
+
+	/* Transfer reference to list and return */
+	list_add_tail ( &prefetch->list, &imgprefetches );
+	uri_put ( uri );
+	return 0;
+
+ err_create_downloader:
+ err_alloc_image:
+	ref_put ( &prefetch->refcnt );
+ err_alloc:
+ err_exists:
+	uri_put ( uri );
+ err_resolve_uri:
+ err_parse_uri:
+	return rc;
+}
+
 /**
  * Download a new image
  *
@@ -52,6 +274,7 @@ int imgdownload ( struct uri *uri, unsigned long timeout,
 		  struct image **image ) {
 	struct uri uri_redacted;
 	char *uri_string_redacted;
+	struct image *duplicate;
 	int rc;
 
 	/* Construct redacted URI */
@@ -73,6 +296,19 @@ int imgdownload ( struct uri *uri, unsigned long timeout,
 		goto err_resolve_uri;
 	}
 
+	/* Use any image already downloaded from the same URI (e.g. by
+	 * a background prefetch), waiting first for any still-in-flight
+	 * prefetch of this URI to complete rather than starting a
+	 * duplicate download.
+	 */
+	imgprefetch_wait ( uri );
+	*image = imgfind_uri ( uri );
+	if ( *image ) {
+		boottrace ( "fetch %s prefetched", uri_string_redacted );
+		rc = 0;
+		goto err_alloc_image;
+	}
+
 	/* Allocate image */
 	*image = alloc_image ( uri );
 	if ( ! *image ) {
@@ -87,9 +323,26 @@ int imgdownload ( struct uri *uri, unsigned long timeout,
 	}
 
 	/* Wait for download to complete */
-	if ( ( rc = monojob_wait ( uri_string_redacted, timeout ) ) != 0 )
+	boottrace ( "fetch %s", uri_string_redacted );
+	rc = monojob_wait ( uri_string_redacted, timeout );
+	boottrace ( "fetch %s", ( rc ? "failed" : "done" ) );
+	if ( rc != 0 )
 		goto err_monojob_wait;
 
+	/* Use any registered image with identical content (e.g. the
+	 * same overlay fetched under a different URI), rather than
+	 * storing the same bytes twice.  register_image() callers rely
+	 * on the registered image being the one they passed in, so the
+	 * short-circuit lives here rather than in registration itself.
+	 */
+	duplicate = find_image_duplicate ( *image );
+	if ( duplicate ) {
+		image_put ( *image );
+		*image = image_get ( duplicate );
+		rc = 0;
+		goto err_register_image;
+	}
+
 	/* Register image */
 	if ( ( rc = register_image ( *image ) ) != 0 ) {
 		printf ( "Could not register image: %s\n", strerror ( rc ) );
@@ -130,6 +383,250 @@ int imgdownload_string ( const char *uri_string, unsigned long timeout,
 	return rc;
 }
 
+/** A parallel download set */
+struct imgmulti {
+	/** Reference count for this object */
+	struct refcnt refcnt;
+	/** Job control interface */
+	struct interface job;
+	/** Downloads */
+	struct imgmulti_download *downloads;
+	/** Number of downloads */
+	unsigned int count;
+	/** Number of incomplete downloads */
+	unsigned int pending;
+};
+
+/** A download within a parallel download set */
+struct imgmulti_download {
+	/** Containing parallel download set */
+	struct imgmulti *multi;
+	/** Job control interface */
+	struct interface job;
+	/** Download has completed */
+	int done;
+};
+
+/**
+ * Free parallel download set
+ *
+ * @v refcnt		Reference counter
+ */
+static void imgmulti_free ( struct refcnt *refcnt ) {
+	struct imgmulti *multi =
+		container_of ( refcnt, struct imgmulti, refcnt );
+
+	free ( multi );
+}
+
+/**
+ * Terminate parallel download set
+ *
+ * @v multi		Parallel download set
+ * @v rc		Reason for termination
+ */
+static void imgmulti_close ( struct imgmulti *multi, int rc ) {
+	unsigned int i;
+
+	/* Shut down all interfaces */
+	for ( i = 0 ; i < multi->count ; i++ )
+		intf_shutdown ( &multi->downloads[i].job, rc );
+	intf_shutdown ( &multi->job, rc );
+}
+
+/**
+ * Handle completion of one download within a parallel download set
+ *
+ * @v download		Download
+ * @v rc		Reason for completion
+ */
+static void imgmulti_download_close ( struct imgmulti_download *download,
+				      int rc ) {
+	struct imgmulti *multi = download->multi;
+
+	/* Record completion and shut down interface */
+	if ( ! download->done ) {
+		download->done = 1;
+		multi->pending--;
+	}
+	intf_shutdown ( &download->job, rc );
+
+	/* Terminate the set on any error, or when the last download
+	 * completes.
+	 */
+	if ( ( rc != 0 ) || ( multi->pending == 0 ) )
+		imgmulti_close ( multi, rc );
+}
+
+/**
+ * Report aggregate progress of parallel download set
+ *
+ * @v multi		Parallel download set
+ * @v progress		Progress report to fill in
+ * @ret ongoing_rc	Ongoing job status code (if known)
+ */
+static int imgmulti_progress ( struct imgmulti *multi,
+			       struct job_progress *progress ) {
+	struct job_progress child;
+	unsigned int i;
+
+	/* Sum progress of all downloads.  Completed downloads no
+	 * longer report progress; this is a reasonable first
+	 * approximation.
+	 */
+	for ( i = 0 ; i < multi->count ; i++ ) {
+		job_progress ( &multi->downloads[i].job, &child );
+		progress->completed += child.completed;
+		progress->total += child.total;
+	}
+
+	return 0;
+}
+
+/** Parallel download set job control interface operations */
+static struct interface_operation imgmulti_job_operations[] = {
+	INTF_OP ( job_progress, struct imgmulti *, imgmulti_progress ),
+	INTF_OP ( intf_close, struct imgmulti *, imgmulti_close ),
+};
+
+/** Parallel download set job control interface descriptor */
+static struct interface_descriptor imgmulti_job_desc =
+	INTF_DESC ( struct imgmulti, job, imgmulti_job_operations );
+
+/** Parallel download set download interface operations */
+static struct interface_operation imgmulti_download_operations[] = {
+	INTF_OP ( intf_close, struct imgmulti_download *,
+		  imgmulti_download_close ),
+};
+
+/** Parallel download set download interface descriptor */
+static struct interface_descriptor imgmulti_download_desc =
+	INTF_DESC ( struct imgmulti_download, job,
+		    imgmulti_download_operations );
+
+/**
+ * Download multiple new images concurrently
+ *
+ * @v uri_strings	URI strings
+ * @v count		Number of URIs
+ * @v timeout		Download timeout
+ * @ret rc		Return status code
+ *
+ * All downloads run concurrently under a single aggregate job, so
+ * the total time taken approaches that of the largest individual
+ * download rather than the sum of all downloads.  Images are
+ * registered only if every download succeeds.
+ */
+int imgdownload_multiple ( char * const *uri_strings, unsigned int count,
+			   unsigned long timeout ) {
+	struct imgmulti *multi;
+	struct imgmulti_download *download;
+	struct image **images;
+	struct uri *parsed;
+	struct uri *uri;
+	unsigned int i;
+	int rc;
+
+	/* Sanity check */
+	if ( ! count )
+		return -EINVAL;
+
+	/* Allocate and initialise structure */
+	multi = zalloc ( sizeof ( *multi ) +
+			 ( count * sizeof ( multi->downloads[0] ) ) );
+	if ( ! multi ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	ref_init ( &multi->refcnt, imgmulti_free );
+	intf_init ( &multi->job, &imgmulti_job_desc, &multi->refcnt );
+	multi->downloads = ( ( void * ) ( multi + 1 ) );
+	multi->count = count;
+
+	/* Allocate image list */
+	images = zalloc ( count * sizeof ( images[0] ) );
+	if ( ! images ) {
+		rc = -ENOMEM;
+		goto err_alloc_images;
+	}
+
+	/* Create downloaders */
+	for ( i = 0 ; i < count ; i++ ) {
+		download = &multi->downloads[i];
+		download->multi = multi;
+		intf_init ( &download->job, &imgmulti_download_desc,
+			    &multi->refcnt );
+
+		/* Parse and resolve URI */
+		parsed = parse_uri ( uri_strings[i] );
+		if ( ! parsed ) {
+			rc = -ENOMEM;
+			goto err_uri;
+		}
+		uri = resolve_uri ( cwuri, parsed );
+		uri_put ( parsed );
+		if ( ! uri ) {
+			rc = -ENOMEM;
+			goto err_uri;
+		}
+
+		/* Allocate image */
+		images[i] = alloc_image ( uri );
+		uri_put ( uri );
+		if ( ! images[i] ) {
+			rc = -ENOMEM;
+			goto err_alloc_image;
+		}
+
+		/* Create downloader */
+		if ( ( rc = create_downloader ( &download->job,
+						images[i] ) ) != 0 ) {
+			printf ( "Could not start download of %s: %s\n",
+				 uri_strings[i], strerror ( rc ) );
+			goto err_create_downloader;
+		}
+		multi->pending++;
+	}
+
+	/* Attach to monojob, mortalise self, and wait for completion */
+	intf_plug_plug ( &multi->job, &monojob );
+	ref_put ( &multi->refcnt );
+	if ( ( rc = monojob_wait ( "Downloading", timeout ) ) != 0 )
+		goto err_monojob_wait;
+
+	/* Register images */
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( ( rc = register_image ( images[i] ) ) != 0 ) {
+			printf ( "Could not register %s: %s\n",
+				 images[i]->name, strerror ( rc ) );
+			goto err_register_image;
+		}
+	}
+
+ err_register_image:
+ err_monojob_wait:
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( images[i] )
+			image_put ( images[i] );
+	}
+	free ( images );
+	return rc;
+
+ err_create_downloader:
+ err_alloc_image:
+ err_uri:
+	imgmulti_close ( multi, rc );
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( images[i] )
+			image_put ( images[i] );
+	}
+	free ( images );
+ err_alloc_images:
+	ref_put ( &multi->refcnt );
+ err_alloc:
+	return rc;
+}
+
 /**
  * Acquire an image
  *
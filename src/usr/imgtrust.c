@@ -24,6 +24,7 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 #include <time.h>
 #include <syslog.h>
@@ -32,6 +33,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/cms.h>
 #include <ipxe/validator.h>
 #include <ipxe/monojob.h>
+#include <ipxe/process.h>
+#include <ipxe/list.h>
 #include <usr/imgtrust.h>
 
 /** @file
@@ -40,26 +43,176 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/** An image verification job */
+struct imgverify_job {
+	/** Reference count for this object */
+	struct refcnt refcnt;
+	/** List of verification jobs */
+	struct list_head list;
+
+	/** Image being verified */
+	struct image *image;
+	/** Required common name, or NULL to allow any name */
+	char *name;
+	/** Parsed signature */
+	struct cms_signature *sig;
+	/** Signer information currently being validated */
+	struct cms_signer_info *info;
+	/** Certificate validator interface */
+	struct interface validator;
+
+	/** Verification has completed */
+	int done;
+	/** Completion status */
+	int rc;
+};
+
+/** List of running verification jobs */
+static LIST_HEAD ( imgverify_jobs );
+
 /**
- * Verify image using downloaded signature
+ * Free image verification job
+ *
+ * @v refcnt		Reference counter
+ */
+static void imgverify_job_free ( struct refcnt *refcnt ) {
+	struct imgverify_job *job =
+		container_of ( refcnt, struct imgverify_job, refcnt );
+
+	if ( job->sig )
+		cms_put ( job->sig );
+	image_put ( job->image );
+	free ( job->name );
+	free ( job );
+}
+
+/**
+ * Complete image verification job
+ *
+ * @v job		Verification job
+ * @v rc		Completion status
+ */
+static void imgverify_job_done ( struct imgverify_job *job, int rc ) {
+
+	/* Verify image, if all certificate chains completed */
+	if ( rc == 0 ) {
+		rc = cms_verify ( job->sig, job->image, job->name,
+				  time ( NULL ), NULL, NULL );
+	}
+
+	/* Mark image as trusted, if applicable */
+	if ( rc == 0 ) {
+		image_trust ( job->image );
+		syslog ( LOG_NOTICE, "Image \"%s\" signature OK\n",
+			 job->image->name );
+	} else {
+		syslog ( LOG_ERR, "Image \"%s\" signature bad: %s\n",
+			 job->image->name, strerror ( rc ) );
+	}
+
+	/* Record completion status */
+	job->done = 1;
+	job->rc = rc;
+
+	/* Shut down validator interface */
+	intf_shutdown ( &job->validator, rc );
+
+	/* Drop signature reference */
+	cms_put ( job->sig );
+	job->sig = NULL;
+
+	/* Remove from list of running jobs and drop list's reference */
+	list_del ( &job->list );
+	ref_put ( &job->refcnt );
+}
+
+/**
+ * Handle completion of one certificate chain validation
+ *
+ * @v job		Verification job
+ * @v rc		Reason for completion
+ */
+static void imgverify_validator_done ( struct imgverify_job *job, int rc ) {
+
+	/* Terminate job on any validation error */
+	if ( rc != 0 ) {
+		imgverify_job_done ( job, rc );
+		return;
+	}
+
+	/* Move to next signer information block, if any */
+	job->info = list_next_entry ( job->info, &job->sig->info, list );
+	if ( ! job->info ) {
+		imgverify_job_done ( job, 0 );
+		return;
+	}
+
+	/* Restart interface and validate next certificate chain */
+	intf_restart ( &job->validator, rc );
+	if ( ( rc = create_validator ( &job->validator, job->info->chain,
+				       NULL, 0 ) ) != 0 ) {
+		imgverify_job_done ( job, rc );
+		return;
+	}
+}
+
+/** Verification job validator interface operations */
+static struct interface_operation imgverify_validator_operations[] = {
+	INTF_OP ( intf_close, struct imgverify_job *,
+		  imgverify_validator_done ),
+};
+
+/** Verification job validator interface descriptor */
+static struct interface_descriptor imgverify_validator_desc =
+	INTF_DESC ( struct imgverify_job, validator,
+		    imgverify_validator_operations );
+
+/**
+ * Find running verification job for an image
+ *
+ * @v image		Image
+ * @ret job		Verification job, or NULL if none running
+ */
+static struct imgverify_job * imgverify_find ( struct image *image ) {
+	struct imgverify_job *job;
+
+	list_for_each_entry ( job, &imgverify_jobs, list ) {
+		if ( job->image == image )
+			return job;
+	}
+	return NULL;
+}
+
+/**
+ * Start verifying image using downloaded signature
  *
  * @v image		Image to verify
  * @v signature		Image containing signature
  * @v name		Required common name, or NULL to allow any name
  * @ret rc		Return status code
+ *
+ * Verification runs as a background job, overlapping with any other
+ * foreground activity (such as downloading further images).  The
+ * image will be marked as trusted if and when verification succeeds;
+ * use imgverify_wait() to wait for completion.
  */
-int imgverify ( struct image *image, struct image *signature,
-		const char *name ) {
+int imgverify_start ( struct image *image, struct image *signature,
+		      const char *name ) {
+	struct imgverify_job *job;
 	struct asn1_cursor *data;
 	struct cms_signature *sig;
-	struct cms_signer_info *info;
-	time_t now;
 	int next;
 	int rc;
 
 	/* Mark image as untrusted */
 	image_untrust ( image );
 
+	/* Fail if a verification job is already running for this image */
+	if ( imgverify_find ( image ) ) {
+		rc = -EALREADY;
+		goto err_already;
+	}
+
 	/* Get raw signature data */
 	next = image_asn1 ( signature, 0, &data );
 	if ( next < 0 ) {
@@ -75,38 +228,100 @@ int imgverify ( struct image *image, struct image *signature,
 	free ( data );
 	data = NULL;
 
-	/* Complete all certificate chains */
-	list_for_each_entry ( info, &sig->info, list ) {
-		if ( ( rc = create_validator ( &monojob, info->chain ) ) != 0 )
-			goto err_create_validator;
-		if ( ( rc = monojob_wait ( NULL, 0 ) ) != 0 )
-			goto err_validator_wait;
+	/* Allocate and initialise job */
+	job = zalloc ( sizeof ( *job ) );
+	if ( ! job ) {
+		rc = -ENOMEM;
+		goto err_alloc;
 	}
-
-	/* Use signature to verify image */
-	now = time ( NULL );
-	if ( ( rc = cms_verify ( sig, image->data, image->len,
-				 name, now, NULL, NULL ) ) != 0 )
-		goto err_verify;
-
-	/* Drop reference to signature */
-	cms_put ( sig );
+	ref_init ( &job->refcnt, imgverify_job_free );
+	intf_init ( &job->validator, &imgverify_validator_desc,
+		    &job->refcnt );
+	job->image = image_get ( image );
+	job->sig = sig;
 	sig = NULL;
+	if ( name ) {
+		job->name = strdup ( name );
+		if ( ! job->name ) {
+			rc = -ENOMEM;
+			goto err_name;
+		}
+	}
 
-	/* Mark image as trusted */
-	image_trust ( image );
-	syslog ( LOG_NOTICE, "Image \"%s\" signature OK\n", image->name );
+	/* Begin validating first certificate chain */
+	job->info = list_first_entry ( &job->sig->info,
+				       struct cms_signer_info, list );
+	if ( ! job->info ) {
+		rc = -EINVAL;
+		goto err_info;
+	}
+	if ( ( rc = create_validator ( &job->validator, job->info->chain,
+				       NULL, 0 ) ) != 0 )
+		goto err_create_validator;
+
+	/* Add to list of running jobs and transfer our reference */
+	list_add_tail ( &job->list, &imgverify_jobs );
 
 	return 0;
 
- err_verify:
- err_validator_wait:
  err_create_validator:
-	cms_put ( sig );
+ err_info:
+ err_name:
+	ref_put ( &job->refcnt );
+ err_alloc:
  err_parse:
 	free ( data );
  err_asn1:
+ err_already:
 	syslog ( LOG_ERR, "Image \"%s\" signature bad: %s\n",
 		 image->name, strerror ( rc ) );
 	return rc;
 }
+
+/**
+ * Wait for image verification to complete
+ *
+ * @v image		Image
+ * @ret rc		Return status code
+ *
+ * Returns success immediately if no verification job is running for
+ * the image.
+ */
+int imgverify_wait ( struct image *image ) {
+	struct imgverify_job *job;
+	int rc;
+
+	/* Identify running job, if any */
+	job = imgverify_find ( image );
+	if ( ! job )
+		return 0;
+
+	/* Wait for job to complete, holding our own reference */
+	ref_get ( &job->refcnt );
+	while ( ! job->done )
+		step();
+	rc = job->rc;
+	ref_put ( &job->refcnt );
+
+	return rc;
+}
+
+/**
+ * Verify image using downloaded signature
+ *
+ * @v image		Image to verify
+ * @v signature		Image containing signature
+ * @v name		Required common name, or NULL to allow any name
+ * @ret rc		Return status code
+ */
+int imgverify ( struct image *image, struct image *signature,
+		const char *name ) {
+	int rc;
+
+	/* Start verification job */
+	if ( ( rc = imgverify_start ( image, signature, name ) ) != 0 )
+		return rc;
+
+	/* Wait for verification to complete */
+	return imgverify_wait ( image );
+}
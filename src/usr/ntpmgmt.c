@@ -24,8 +24,12 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/interface.h>
 #include <ipxe/ntp.h>
 #include <ipxe/monojob.h>
 #include <usr/ntpmgmt.h>
@@ -36,6 +40,76 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/** A background NTP synchronisation */
+struct ntp_background {
+	/** Reference count for this object */
+	struct refcnt refcnt;
+	/** Job control interface */
+	struct interface job;
+};
+
+/**
+ * Handle completion of a background NTP synchronisation
+ *
+ * @v bg		Background NTP synchronisation
+ * @v rc		Reason for completion
+ *
+ * Failures are deliberately quiet: background synchronisation is
+ * best-effort, and the clock simply remains unadjusted.
+ */
+static void ntp_background_close ( struct ntp_background *bg, int rc ) {
+
+	DBGC ( bg, "NTP %p background synchronisation %s\n", bg,
+	       ( ( rc == 0 ) ? "complete" : strerror ( rc ) ) );
+	intf_shutdown ( &bg->job, rc );
+}
+
+/** Background NTP synchronisation interface operations */
+static struct interface_operation ntp_background_op[] = {
+	INTF_OP ( intf_close, struct ntp_background *, ntp_background_close ),
+};
+
+/** Background NTP synchronisation interface descriptor */
+static struct interface_descriptor ntp_background_desc =
+	INTF_DESC ( struct ntp_background, job, ntp_background_op );
+
+/**
+ * Start getting time and date via NTP in the background
+ *
+ * @v hostname		Hostname
+ * @ret rc		Return status code
+ *
+ * Synchronisation proceeds whenever the network is polled (such as
+ * during subsequent downloads), rather than blocking the caller.
+ */
+int ntp_start ( const char *hostname ) {
+	struct ntp_background *bg;
+	int rc;
+
+	/* Allocate and initialise structure */
+	bg = zalloc ( sizeof ( *bg ) );
+	if ( ! bg ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	ref_init ( &bg->refcnt, NULL );
+	intf_init ( &bg->job, &ntp_background_desc, &bg->refcnt );
+
+	/* Start NTP client */
+	if ( ( rc = start_ntp ( &bg->job, hostname ) ) != 0 )
+		goto err_start;
+
+	/* Mortalise self and return */
+	ref_put ( &bg->refcnt );
+	return 0;
+
+ err_start:
+	intf_shutdown ( &bg->job, rc );
+	ref_put ( &bg->refcnt );
+ err_alloc:
+	return rc;
+}
+
 /**
  * Get time and date via NTP
  *
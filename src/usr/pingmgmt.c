@@ -26,9 +26,11 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <ipxe/pinger.h>
 #include <ipxe/monojob.h>
 #include <ipxe/timer.h>
+#include <ipxe/profile.h>
 #include <usr/pingmgmt.h>
 
 /** @file
@@ -37,52 +39,125 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/** Convert ticks to milliseconds */
+#define TICKS_TO_MS( ticks ) ( ( ( ticks ) * 1000 ) / TICKS_PER_SEC )
+
+/** Ping statistics */
+struct ping_stats {
+	/** Number of responses received */
+	unsigned int received;
+	/** Number of packets lost (i.e. timed out) */
+	unsigned int lost;
+	/** Minimum round-trip time (in ticks) */
+	unsigned long min;
+	/** Maximum round-trip time (in ticks) */
+	unsigned long max;
+	/** Round-trip time profiler */
+	struct profiler rtt;
+};
+
+/** Statistics for the current ping */
+static struct ping_stats ping_stats;
+
+/** Inhibit output for the current ping */
+static int ping_quiet;
+
 /**
- * Display ping result
+ * Record and display ping result
  *
  * @v src		Source socket address, or NULL
  * @v sequence		Sequence number
  * @v len		Payload length
+ * @v rtt		Round-trip time (in ticks), if known
  * @v rc		Status code
  */
 static void ping_callback ( struct sockaddr *peer, unsigned int sequence,
-			    size_t len, int rc ) {
+			    size_t len, unsigned long rtt, int rc ) {
+
+	/* Record statistics */
+	if ( rc == 0 ) {
+		if ( ( ping_stats.received == 0 ) || ( rtt < ping_stats.min ) )
+			ping_stats.min = rtt;
+		if ( rtt > ping_stats.max )
+			ping_stats.max = rtt;
+		profile_update ( &ping_stats.rtt, rtt );
+		ping_stats.received++;
+	} else if ( rc == -ETIMEDOUT ) {
+		ping_stats.lost++;
+	}
 
 	/* Display ping response */
+	if ( ping_quiet )
+		return;
 	printf ( "%zd bytes from %s: seq=%d",
 		 len, ( peer ? sock_ntoa ( peer ) : "<none>" ), sequence );
-	if ( rc != 0 )
+	if ( rc == 0 ) {
+		printf ( " time=%ld ms", TICKS_TO_MS ( rtt ) );
+	} else {
 		printf ( ": %s", strerror ( rc ) );
+	}
 	printf ( "\n" );
 }
 
+/**
+ * Display ping statistics
+ *
+ * @v stats		Ping statistics
+ */
+static void ping_stat ( struct ping_stats *stats ) {
+	unsigned int total = ( stats->received + stats->lost );
+
+	/* Display packet counts and loss percentage */
+	printf ( "%d packets transmitted, %d received, %d%% packet loss\n",
+		 total, stats->received,
+		 ( total ? ( stats->lost * 100 / total ) : 0 ) );
+
+	/* Display round-trip time statistics, if any responses received */
+	if ( stats->received ) {
+		printf ( "rtt min/avg/max/sdev = %ld/%ld/%ld/%ld ms\n",
+			 TICKS_TO_MS ( stats->min ),
+			 TICKS_TO_MS ( profile_mean ( &stats->rtt ) ),
+			 TICKS_TO_MS ( stats->max ),
+			 TICKS_TO_MS ( profile_stddev ( &stats->rtt ) ) );
+	}
+}
+
 /**
  * Ping a host
  *
  * @v hostname		Hostname
- * @v timeout		Timeout between pings, in ticks
+ * @v timeout		Timeout for each response, in ticks
+ * @v interval		Interval between pings, in ticks (or zero to use timeout)
  * @v len		Payload length
  * @v count		Number of packets to send (or zero for no limit)
  * @v quiet		Inhibit output
  * @ret rc		Return status code
  */
-int ping ( const char *hostname, unsigned long timeout, size_t len,
-	   unsigned int count, int quiet ) {
+int ping ( const char *hostname, unsigned long timeout,
+	   unsigned long interval, size_t len, unsigned int count,
+	   int quiet ) {
 	int rc;
 
+	/* Reset statistics */
+	memset ( &ping_stats, 0, sizeof ( ping_stats ) );
+	ping_quiet = quiet;
+
 	/* Create pinger */
-	if ( ( rc = create_pinger ( &monojob, hostname, timeout, len, count,
-				    ( quiet ? NULL : ping_callback ) ) ) != 0 ){
+	if ( ( rc = create_pinger ( &monojob, hostname, timeout, interval, len,
+				    count, ping_callback ) ) != 0 ) {
 		printf ( "Could not start ping: %s\n", strerror ( rc ) );
 		return rc;
 	}
 
 	/* Wait for ping to complete */
-	if ( ( rc = monojob_wait ( NULL, 0 ) ) != 0 ) {
-		if ( ! quiet )
+	rc = monojob_wait ( NULL, 0 );
+
+	/* Display statistics */
+	if ( ! quiet ) {
+		ping_stat ( &ping_stats );
+		if ( rc != 0 )
 			printf ( "Finished: %s\n", strerror ( rc ) );
-		return rc;
 	}
 
-	return 0;
+	return rc;
 }
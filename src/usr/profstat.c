@@ -24,6 +24,7 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdio.h>
+#include <syslog.h>
 #include <ipxe/profile.h>
 #include <usr/profstat.h>
 
@@ -46,3 +47,21 @@ void profstat ( void ) {
 			 profile_stddev ( profiler ), profiler->count );
 	}
 }
+
+/**
+ * Export profiling statistics via system logger
+ *
+ * Each profiler is emitted as a single structured line via the system
+ * logger, and so will reach any enabled syslog console for ingestion
+ * by a telemetry pipeline.
+ */
+void profstat_export ( void ) {
+	struct profiler *profiler;
+
+	for_each_table_entry ( profiler, PROFILERS ) {
+		log_printf ( "PROFILE %s count %d mean %ld stddev %ld\n",
+			     profiler->name, profiler->count,
+			     profile_mean ( profiler ),
+			     profile_stddev ( profiler ) );
+	}
+}